@@ -80,6 +80,18 @@ XGB_DLL int XGBSetGlobalConfig(const char* json_str);
  */
 XGB_DLL int XGBGetGlobalConfig(const char** json_str);
 
+/*!
+ * \brief Collect the built-in hot-path profile counters as a JSON string.
+ *        Counters (histogram build rows/bytes, partition rows, allreduce
+ *        bytes and latency, external memory page waits, ...) accumulate
+ *        since the previous call and are reset by collecting, so polling
+ *        once per boosting iteration yields per-iteration figures.  Timer
+ *        values are raw ticks in the unit named by the "timer_unit" field.
+ * \param json_str pointer to the received counter snapshot as a JSON string.
+ * \return 0 for success, -1 for failure
+ */
+XGB_DLL int XGBGetProfileCounters(const char** json_str);
+
 /*!
  * \brief load a data matrix
  * \param fname the name of the file
@@ -172,6 +184,29 @@ XGB_DLL int XGDMatrixCreateFromDT(void** data,
                                   bst_ulong ncol,
                                   DMatrixHandle* out,
                                   int nthread);
+/*!
+ * \brief create matrix content from columnar (Arrow style) buffers without an
+ *        intermediate copy.  Value buffers are read in place and copied once
+ *        into the final DMatrix page.
+ * \param data pointer to pointer to column value buffers
+ * \param feature_stypes pointer to type strings, one of "float32", "float64",
+ *        "int8", "int16", "int32", "int64"
+ * \param validity pointer to per-column Arrow validity bitmaps (least
+ *        significant bit first), individual entries or the whole array may be
+ *        NULL for columns without missing values
+ * \param nrow number of rows
+ * \param ncol number columns
+ * \param out created dmatrix
+ * \param nthread number of threads (up to maximum cores available, if <=0 use all cores)
+ * \return 0 when success, -1 when failure happens
+ */
+XGB_DLL int XGDMatrixCreateFromColumnar(void const** data,
+                                        const char** feature_stypes,
+                                        unsigned char const** validity,
+                                        bst_ulong nrow,
+                                        bst_ulong ncol,
+                                        DMatrixHandle* out,
+                                        int nthread);
 
 /*
  * ========================== Begin data callback APIs =========================
@@ -349,6 +384,23 @@ XGB_DLL int XGDeviceQuantileDMatrixSetDataCudaArrayInterface(
 XGB_DLL int XGDeviceQuantileDMatrixSetDataCudaColumnar(
     DMatrixHandle handle,
     const char* c_interface_str);
+/*!
+ * \brief Create a Device Quantile DMatrix from a single batch of device
+ *        columnar data.  The data is sketched, quantized and compressed
+ *        entirely on the device; no iterator callbacks are required.
+ *
+ * \param c_interface_str Null terminated JSON document string representation of CUDA
+ *                        array interface, with an array of columns.
+ * \param missing  Which value to represent missing value
+ * \param nthread  Number of threads to use, 0 for default.
+ * \param max_bin  Maximum number of bins for building histogram.
+ * \param out      The created Device Quantile DMatrix
+ *
+ * \return 0 when success, -1 when failure happens
+ */
+XGB_DLL int XGDeviceDMatrixCreateFromColumnar(char const* c_interface_str,
+                                              float missing, int nthread,
+                                              int max_bin, DMatrixHandle* out);
 /*
  * ==========================- End data callback APIs ==========================
  */
@@ -634,6 +686,23 @@ XGB_DLL int XGBoosterSetParam(BoosterHandle handle,
                               const char *name,
                               const char *value);
 
+/*!
+ * \brief set a numeric parameter without string formatting
+ *
+ *  For a small set of frequently adjusted parameters such as the learning
+ *  rate, this updates the configured booster in place instead of forcing a
+ *  full reconfiguration on the next iteration.  Other parameters silently
+ *  fall back to the behaviour of \ref XGBoosterSetParam.
+ *
+ * \param handle handle
+ * \param name   parameter name
+ * \param value  value of parameter
+ * \return 0 when success, -1 when failure happens
+ */
+XGB_DLL int XGBoosterSetParamFloat(BoosterHandle handle,
+                                   const char *name,
+                                   float value);
+
 /*!
  * \brief get number of features
  * \param out number of features
@@ -683,6 +752,51 @@ XGB_DLL int XGBoosterEvalOneIter(BoosterHandle handle,
                                  const char *evnames[],
                                  bst_ulong len,
                                  const char **out_result);
+/*!
+ * \brief Query the built-in early stopping engine.  Set the
+ *        `early_stopping_rounds` parameter and call XGBoosterEvalOneIter every
+ *        round; once the evaluation metric plateaus this returns 1 and the
+ *        training loop should stop boosting.
+ * \param handle handle
+ * \param out_should_stop set to 1 when training should stop, 0 otherwise
+ * \return 0 when success, -1 when failure happens
+ */
+XGB_DLL int XGBoosterShouldStop(BoosterHandle handle, int *out_should_stop);
+/*!
+ * \brief Freeze the booster for concurrent prediction.  Configuration is
+ *        finalized and further parameter changes or training calls fail, and
+ *        XGBoosterPredict no longer touches shared caches, so one frozen
+ *        booster may serve predictions from any number of threads without
+ *        external locking.  Freezing cannot be undone on a handle.
+ * \param handle handle
+ * \return 0 when success, -1 when failure happens
+ */
+XGB_DLL int XGBoosterFreezeForPrediction(BoosterHandle handle);
+/*!
+ * \brief Compact the booster for inference deployment.  Training-only node
+ *        statistics are dropped, deleted nodes are pruned and the trees are
+ *        re-laid out breadth-first for traversal.  Predictions are unchanged;
+ *        further training is not supported afterwards.
+ * \param handle handle
+ * \return 0 when success, -1 when failure happens
+ */
+XGB_DLL int XGBoosterCompactForInference(BoosterHandle handle);
+/*!
+ * \brief Replace the booster's model with one parsed from a memory buffer
+ *        while the handle keeps serving predictions.  The new model is staged
+ *        off the prediction path, in-flight XGBoosterPredict calls finish
+ *        against the old trees, and the swap publishes the new model as a
+ *        whole, so every prediction sees a consistent snapshot.  Intended for
+ *        frozen serving boosters reloading a retrained model in place;
+ *        training concurrent with a swap is not supported.
+ * \param handle handle
+ * \param buf pointer to the serialized model
+ * \param len the length of the buffer
+ * \return 0 when success, -1 when failure happens
+ */
+XGB_DLL int XGBoosterSwapModel(BoosterHandle handle,
+                               const void *buf,
+                               bst_ulong len);
 /*!
  * \brief make prediction based on dmat
  * \param handle handle
@@ -753,6 +867,27 @@ XGB_DLL int XGBoosterLoadModel(BoosterHandle handle,
  */
 XGB_DLL int XGBoosterSaveModel(BoosterHandle handle,
                                const char *fname);
+/*!
+ * \brief Save model into existing file on a background thread.
+ *
+ * The model state is snapshotted before this call returns, so training may
+ * continue immediately; serialization and the file write overlap with
+ * boosting.  At most one write is in flight: a new call first waits for the
+ * previous one.  Only the binary model format is supported.
+ *
+ * \param handle handle
+ * \param fname file name
+ * \return 0 when success, -1 when failure happens
+ */
+XGB_DLL int XGBoosterSaveModelAsync(BoosterHandle handle,
+                                    const char *fname);
+/*!
+ * \brief Block until the last XGBoosterSaveModelAsync write is on disk and
+ *        surface any error it hit.
+ * \param handle handle
+ * \return 0 when success, -1 when failure happens
+ */
+XGB_DLL int XGBoosterWaitForModelSave(BoosterHandle handle);
 /*!
  * \brief load model from in memory buffer
  * \param handle handle
@@ -814,6 +949,29 @@ XGB_DLL int XGBoosterLoadRabitCheckpoint(BoosterHandle handle,
  */
 XGB_DLL int XGBoosterSaveRabitCheckpoint(BoosterHandle handle);
 
+/*!
+ * \brief Checkpoint the booster to a chain of files rooted at fname on a
+ *  background thread.  The first call writes a full model, later calls with
+ *  the same fname write only the trees boosted since the previous checkpoint
+ *  to fname.delta.1, fname.delta.2, ... so checkpoint cost is proportional to
+ *  the new trees, not the model.
+ * \param handle handle
+ * \param fname base checkpoint file name
+ * \return 0 when success, -1 when failure happens
+ */
+XGB_DLL int XGBoosterSaveCheckpoint(BoosterHandle handle, const char* fname);
+
+/*!
+ * \brief Restore the booster from a checkpoint chain written by
+ *  `XGBoosterSaveCheckpoint' and resume the chain, so the next save appends.
+ * \param handle handle
+ * \param fname base checkpoint file name
+ * \param version The number of boosted rounds recovered, 0 when no
+ *  checkpoint exists yet.
+ * \return 0 when success, -1 when failure happens
+ */
+XGB_DLL int XGBoosterLoadCheckpoint(BoosterHandle handle, const char* fname,
+                                    int* version);
 
 /*!
  * \brief Save XGBoost's internal configuration into a JSON document.  Currently the
@@ -917,6 +1075,25 @@ XGB_DLL int XGBoosterDumpModelExWithFeatures(BoosterHandle handle,
                                              bst_ulong *out_len,
                                              const char ***out_models);
 
+/*!
+ * \brief Compute per-feature importance directly from the tree statistics,
+ *  without dumping and re-parsing the model.  Only gbtree boosters are
+ *  supported.
+ * \param handle handle
+ * \param importance_type one of "weight", "gain", "cover", "total_gain" or
+ *  "total_cover"
+ * \param out_n_features number of entries in out_scores, equal to the number
+ *  of features of the model
+ * \param out_scores importance score of each feature indexed by feature id,
+ *  zero for features no tree splits on.  The buffer is owned by the booster
+ *  and valid until the next call into the API on this thread.
+ * \return 0 when success, -1 when failure happens
+ */
+XGB_DLL int XGBoosterFeatureImportance(BoosterHandle handle,
+                                       const char* importance_type,
+                                       bst_ulong* out_n_features,
+                                       const float** out_scores);
+
 /*!
  * \brief Get string attribute from Booster.
  * \param handle handle
@@ -14,6 +14,7 @@
 #include <xgboost/span.h>
 #include <xgboost/host_device_vector.h>
 
+#include <functional>
 #include <memory>
 #include <numeric>
 #include <algorithm>
@@ -158,6 +159,18 @@ class MetaInfo {
    *        Right now only 1 column is permitted.
    */
   void SetInfo(const char* key, std::string const& interface_str);
+  /*!
+   * \brief Build group_ptr_ from per-row query ids.
+   *
+   *        A group boundary sits at every row whose query id differs from the
+   *        previous row, so the boundaries can be found independently per
+   *        chunk of rows and written out in parallel.  Equivalent to a serial
+   *        scan that opens a new group whenever the query id changes.
+   *
+   * \param qids    Query id of each row; rows of a group must be contiguous.
+   * \param nthread Number of threads used for the scan.
+   */
+  void SetGroupPtrFromQids(const std::vector<uint64_t>& qids, int32_t nthread);
 
   void GetInfo(char const* key, bst_ulong* out_len, DataType dtype,
                const void** out_dptr) const;
@@ -175,9 +188,26 @@ class MetaInfo {
    */
   void Extend(MetaInfo const& that, bool accumulate_rows);
 
+  /*!
+   * \brief Bit-packed copy of the labels when every label is exactly 0 or 1.
+   *
+   *  Binary classification objectives re-read the full float label vector on
+   *  every iteration; the packed form cuts that traffic 32-fold.  Built
+   *  lazily on first use and invalidated when the labels are replaced.  Not
+   *  thread-safe on first call; callers inside parallel regions must probe
+   *  the cache up front.
+   *
+   * \return Packed words with bit i holding label i, or an empty vector when
+   *  the labels are not binary.
+   */
+  std::vector<uint32_t> const& TryPackedLabels() const;
+
  private:
   /*! \brief argsort of labels */
   mutable std::vector<size_t> label_order_cache_;
+  /*! \brief cache for TryPackedLabels; 0 unknown, 1 packed, -1 not binary */
+  mutable int8_t packed_label_state_{0};
+  mutable std::vector<uint32_t> packed_labels_;
 };
 
 /*! \brief Element from a sparse vector */
@@ -247,6 +277,13 @@ class SparsePage {
   /*! \brief the data of the segments */
   HostDeviceVector<Entry> data;
 
+  /*!
+   * \brief Optional per-feature entry counts of this page, see
+   *  BuildFeatureIndex().  Empty until built; invalidated by Clear() and by
+   *  pushing more data.
+   */
+  std::vector<size_t> feature_counts;
+
   size_t base_rowid {0};
 
   /*! \brief an instance of sparse vector in the batch */
@@ -288,6 +325,7 @@ class SparsePage {
     offset_vec.clear();
     offset_vec.push_back(0);
     data.HostVector().clear();
+    feature_counts.clear();
   }
 
   /*! \brief Set the base row id for this page. */
@@ -297,6 +335,13 @@ class SparsePage {
 
   SparsePage GetTranspose(int num_columns) const;
 
+  /*!
+   * \brief Build feature_counts, the per-feature entry counts of this page.
+   *  A no-op when the index is already valid, so the count pass is shared by
+   *  every later GetTranspose() of the page instead of being redone per call.
+   */
+  void BuildFeatureIndex(int num_columns);
+
   void SortRows() {
     auto ncol = static_cast<bst_omp_uint>(this->Size());
 #pragma omp parallel for default(none) shared(ncol) schedule(dynamic, 1)
@@ -448,6 +493,12 @@ class BatchSet {
 
 struct XGBAPIThreadLocalEntry;
 
+/*!
+ * \brief Predicate over a half-open row index range [begin, end); returns true
+ *        when the caller needs at least one row inside the range.
+ */
+using RowRangePredicate = std::function<bool(bst_row_t, bst_row_t)>;
+
 /*!
  * \brief Internal data structured used by XGBoost during training.
  */
@@ -478,6 +529,19 @@ class DMatrix {
   template <typename T>
   bool PageExists() const;
 
+  /*!
+   * \brief Get row batches restricted to the rows selected by \p predicate.
+   *
+   * The predicate is an I/O hint: sources that know the row range of every
+   * page (the external memory cache) skip pages whose whole range is
+   * rejected, while in-memory sources return every batch.  Returned pages may
+   * still contain unselected rows, so callers must apply their own row
+   * filter on top.
+   */
+  virtual BatchSet<SparsePage> GetRowBatches(RowRangePredicate const& predicate) {
+    return this->GetRowBatches();
+  }
+
   // the following are column meta data, should be able to answer them fast.
   /*! \return Whether the data columns single column block. */
   virtual bool SingleColBlock() const = 0;
@@ -27,6 +27,7 @@ namespace xgboost {
 class Json;
 class FeatureMap;
 class ObjFunction;
+class RegTree;
 
 struct GenericParameter;
 struct LearnerModelParam;
@@ -50,6 +51,21 @@ class GradientBooster : public Model, public Configurable {
    * \param cfg configurations on both training and model parameters.
    */
   virtual void Configure(const std::vector<std::pair<std::string, std::string> >& cfg) = 0;
+  /*!
+   * \brief Typed fast path for updating a single numeric hyper-parameter on an
+   *  already configured booster, bypassing the full reconfiguration that
+   *  `Configure` performs.  Boosters only need to support the parameters that
+   *  are commonly adjusted between iterations, such as the learning rate.
+   *
+   * \param key   Parameter name.
+   * \param value New value.
+   *
+   * \return True if the parameter was applied; false when the key is not
+   *  supported and the caller must fall back to `Configure`.
+   */
+  virtual bool SetParamFloat(const std::string&, float) {
+    return false;
+  }
   /*!
    * \brief load model from stream
    * \param fi input stream.
@@ -60,6 +76,48 @@ class GradientBooster : public Model, public Configurable {
    * \param fo output stream
    */
   virtual void Save(dmlc::Stream* fo) const = 0;
+  /*!
+   * \brief Capture an immutable snapshot of the model and return a writer
+   *  producing the same bytes as Save.  The writer may run on another thread
+   *  while boosting continues.  The default implementation serializes
+   *  eagerly and only defers the write; boosters whose committed state is
+   *  immutable can return a cheap copy-on-write view instead.
+   */
+  virtual std::function<void(dmlc::Stream*)> MakeSaveSnapshot() const;
+  /*!
+   * \brief Capture a writer for an incremental checkpoint covering only the
+   *  model state committed since the caller's last checkpoint, for boosters
+   *  whose committed state is append-only.
+   *
+   *  On entry *p_trees_done is the number of trees the caller has already
+   *  checkpointed and *p_base_generation the model base generation it was
+   *  captured at; on success they are advanced to the current state and the
+   *  returned writer, which may run on another thread like MakeSaveSnapshot,
+   *  serializes the gap.  Returns an empty function when the booster does not
+   *  support deltas or the already checkpointed prefix has changed, in which
+   *  case the caller must fall back to a full snapshot.
+   */
+  virtual std::function<void(dmlc::Stream*)> MakeDeltaSnapshot(
+      size_t* p_trees_done, uint64_t* p_base_generation) const {
+    return {};
+  }
+  /*!
+   * \brief Append a delta checkpoint produced by a MakeDeltaSnapshot writer.
+   * \return false when the stream is not a delta checkpoint continuing the
+   *  current model, e.g. a stale file from an earlier run.
+   */
+  virtual bool LoadDelta(dmlc::Stream* fi) {
+    LOG(FATAL) << "Delta checkpoints are not supported by the current booster.";
+    return false;
+  }
+  /*!
+   * \brief Drop training-only state and re-lay the model out for prediction.
+   *  Predictions are unchanged; further training on the compacted model is
+   *  not supported.
+   */
+  virtual void CompactForInference() {
+    LOG(FATAL) << "Compaction for inference is not supported by the current booster.";
+  }
   /*!
    * \brief Slice a model using boosting index. The slice m:n indicates taking all trees
    *        that were fit during the boosting rounds m, (m+1), (m+2), ..., (n-1).
@@ -109,6 +167,21 @@ class GradientBooster : public Model, public Configurable {
                             bool training,
                             unsigned ntree_limit = 0) = 0;
 
+  /*!
+   * \brief Generate predictions while reporting finished row ranges through
+   *  `on_range`, so the caller can consume predictions for `[begin, end)`
+   *  while they are still cache resident.  The callback covers every row
+   *  exactly once and may be invoked concurrently from worker threads.
+   *
+   * \return True if the ranged traversal was performed; false when the
+   *  booster or the active predictor does not support it, in which case
+   *  nothing was predicted and the caller must use \ref PredictBatch.
+   */
+  virtual bool PredictBatchRanged(DMatrix*, PredictionCacheEntry*,
+                                  std::function<void(std::size_t, std::size_t)> const&) {
+    return false;
+  }
+
   /*!
    * \brief Inplace prediction.
    *
@@ -150,6 +223,47 @@ class GradientBooster : public Model, public Configurable {
                            HostDeviceVector<bst_float>* out_preds,
                            unsigned ntree_limit = 0) = 0;
 
+  /*!
+   * \brief predict the leaf index of each tree as int32 into a caller provided buffer
+   *        of size nsample * ntree, this is only valid in gbtree predictor
+   * \param dmat feature matrix
+   * \param out_indices caller provided output buffer, may be backed by a memory mapped file
+   * \param ntree_limit limit the number of trees used in prediction
+   * \return true when the booster supports the direct int32 path, false otherwise
+   */
+  virtual bool PredictLeafInt32(DMatrix*, common::Span<bst_node_t>,
+                                unsigned = 0) {
+    return false;
+  }
+
+  /*!
+   * \brief aggregate per-leaf row counts and label/weight sums over a matrix
+   *        in one traversal, without materializing per-row leaf indices; the
+   *        output holds one segment of `max_nodes * 3` floats per used tree,
+   *        this is only valid in gbtree predictor
+   * \param dmat feature matrix
+   * \param out_stats output vector of aggregated per-node statistics
+   * \param ntree_limit limit the number of trees used in prediction
+   * \return true when the booster supports the aggregation, false otherwise
+   */
+  virtual bool PredictLeafStats(DMatrix*, std::vector<bst_float>*,
+                                unsigned = 0) {
+    return false;
+  }
+
+  /*!
+   * \brief install trees parsed by the direct JSON model reader after
+   *        LoadModel consumed a document with the tree arrays spliced out,
+   *        this is only valid in gbtree predictor
+   * \param trees the parsed trees, indexed by tree id
+   * \param tree_info output group of each tree
+   * \return true when the booster accepted the trees, false otherwise
+   */
+  virtual bool InstallTrees(std::vector<std::shared_ptr<RegTree>>&&,
+                            std::vector<int>&&) {
+    return false;
+  }
+
   /*!
    * \brief feature contributions to individual predictions; the output will be a vector
    *         of length (nfeats + 1) * num_output_group * nsample, arranged in that order
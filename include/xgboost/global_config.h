@@ -16,11 +16,19 @@ class Json;
 
 struct GlobalConfiguration : public XGBoostParameter<GlobalConfiguration> {
   int verbosity { 1 };
+  int64_t pinned_staging_bytes { 0 };
   DMLC_DECLARE_PARAMETER(GlobalConfiguration) {
     DMLC_DECLARE_FIELD(verbosity)
         .set_range(0, 3)
         .set_default(1)  // shows only warning
         .describe("Flag to print out detailed breakdown of runtime.");
+    DMLC_DECLARE_FIELD(pinned_staging_bytes)
+        .set_lower_bound(0)
+        .set_default(0)
+        .describe(
+            "Size in bytes of the pinned host memory pool that host-device "
+            "copies are staged through.  0 (default) copies directly from "
+            "pageable memory.");
   }
 };
 
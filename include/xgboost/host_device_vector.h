@@ -135,6 +135,14 @@ class HostDeviceVector {
   void SetDevice(int device) const;
 
   void Resize(size_t new_size, T v = T());
+  /*!
+   * \brief Pre-allocate storage for at least new_capacity elements without
+   *  changing the size.  Buffers spanning a huge page or more are given
+   *  transparent-huge-page backing where the platform supports it.
+   */
+  void Reserve(size_t new_capacity);
+  /*! \brief Number of elements the vector can hold before reallocating. */
+  size_t Capacity() const;
 
   using value_type = T;  // NOLINT
 
@@ -36,7 +36,7 @@ class JsonReader {
     void Forward() {
       pos_++;
     }
-    void Forward(uint32_t n) {
+    void Forward(size_t n) {
       pos_ += n;
     }
   } cursor_;
@@ -101,6 +101,14 @@ class JsonReader {
   virtual Json ParseBoolean();
   virtual Json ParseNull();
 
+  /*
+   * \brief Parses a large array by scanning the element boundaries first and
+   *        distributing the elements over the available threads.  Returns false
+   *        when the array is too small or malformed, in which case the caller
+   *        falls back to the sequential parser.
+   */
+  bool TryParseArrayParallel(Json* p_out);
+
   Json Parse();
 
  public:
@@ -119,6 +119,44 @@ class Learner : public Model, public Configurable, public dmlc::Serializable {
                        bool approx_contribs = false,
                        bool pred_interactions = false) = 0;
 
+  /*!
+   * \brief Predict the leaf index of each tree as int32 directly into a
+   *  caller provided buffer of size num_row * ntree, which may be backed by a
+   *  memory mapped file.  Avoids the float materialization of the pred_leaf
+   *  path of Predict for pipelines that consume leaf indices as integers.
+   * \param data input data
+   * \param ntree_limit limit number of trees used for prediction, 0 uses all trees
+   * \param out_indices the caller provided output buffer
+   * \return true when the booster supports the direct int32 path; false
+   *  leaves the buffer untouched and the caller should fall back to Predict
+   *  with pred_leaf set.
+   */
+  virtual bool PredictLeafInt32(std::shared_ptr<DMatrix> data,
+                                unsigned ntree_limit,
+                                common::Span<bst_node_t> out_indices) {
+    return false;
+  }
+
+  /*!
+   * \brief Aggregate per-leaf statistics over a matrix in one traversal: for
+   *  every used tree and node, the number of rows routed to it and the sums
+   *  of their labels and weights.  Replaces exporting per-row leaf indices
+   *  and aggregating downstream.  The output holds one segment of
+   *  `max_nodes * 3` floats per used tree, where `max_nodes` is the node
+   *  count of the largest used tree, laid out as {count, label sum, weight
+   *  sum} per node.
+   * \param data input data
+   * \param ntree_limit limit number of trees used for prediction, 0 uses all trees
+   * \param out_stats the aggregated per-node statistics
+   * \return true when the booster supports the aggregation; false leaves the
+   *  output untouched.
+   */
+  virtual bool PredictLeafStats(std::shared_ptr<DMatrix> data,
+                                unsigned ntree_limit,
+                                std::vector<bst_float>* out_stats) {
+    return false;
+  }
+
   /*!
    * \brief Inplace prediction.
    *
@@ -139,12 +177,93 @@ class Learner : public Model, public Configurable, public dmlc::Serializable {
    */
   virtual int32_t BoostedRounds() const = 0;
 
+  /*
+   * \brief Access the underlying gradient booster; requires the learner to be
+   *  configured.  Used by the multi-booster scoring C API, which traverses
+   *  several boosters' trees in one pass.
+   */
+  GradientBooster const* GetBooster() const { return gbm_.get(); }
+
+  /*
+   * \brief Whether the built-in early stopping engine detected a plateau of the
+   *  evaluation metric.  Always false unless `early_stopping_rounds` is set.
+   */
+  virtual bool ShouldStop() const = 0;
+
+  /*
+   * \brief Freeze the learner for concurrent prediction.  Configuration is
+   *  finalized, further parameter changes are rejected, and batch predictions
+   *  stop touching the shared prediction cache, so any number of threads may
+   *  predict over one model without cloning it.
+   */
+  virtual void FreezeForPrediction() = 0;
+
+  /*
+   * \brief Compact the booster for inference deployment: training-only node
+   *  statistics are dropped, deleted nodes are pruned and the trees are
+   *  re-laid out for traversal.  Predictions are unchanged; further training
+   *  is not supported afterwards.
+   */
+  virtual void CompactForInference() = 0;
+
+  /*
+   * \brief Replace the model with one parsed from `fi` while the learner
+   *  keeps serving predictions.  The replacement is staged outside the lock
+   *  shared with batch prediction, in-flight predictions drain against the
+   *  old trees, and the swap publishes the new model as a whole: a
+   *  prediction sees either the old model or the new one, never a mixture.
+   *  Intended for frozen serving boosters; training concurrent with a swap
+   *  is not supported.
+   */
+  virtual void SwapModel(dmlc::Stream* fi) = 0;
+
   void LoadModel(Json const& in) override = 0;
   void SaveModel(Json* out) const override = 0;
 
   virtual void LoadModel(dmlc::Stream* fi) = 0;
   virtual void SaveModel(dmlc::Stream* fo) const = 0;
 
+  /*!
+   * \brief Save the model to a file on a background thread.
+   *
+   * The booster state is snapshotted synchronously, so training can continue
+   * immediately; serialization and the file write overlap with boosting.  At
+   * most one write is in flight: a new call first waits for the previous one.
+   *
+   * \param fname file name, written in the binary model format.
+   */
+  virtual void SaveModelAsync(std::string const& fname) = 0;
+  /*!
+   * \brief Block until the last SaveModelAsync write is on disk and surface
+   *  any error it hit.
+   */
+  virtual void WaitForModelSave() = 0;
+
+  /*!
+   * \brief Checkpoint the model to a chain of files rooted at fname, writing
+   *  on a background thread like SaveModelAsync.
+   *
+   * The first call writes a full model to fname; subsequent calls with the
+   * same fname append only the trees boosted since the previous checkpoint to
+   * fname.delta.1, fname.delta.2, ... so checkpoint cost is proportional to
+   * the new trees, not the model.  Boosters without append-only committed
+   * state fall back to a full save every time.
+   *
+   * \param fname base checkpoint file name.
+   */
+  virtual void SaveCheckpointAsync(std::string const& fname) = 0;
+  /*!
+   * \brief Restore the model from a checkpoint chain written by
+   *  SaveCheckpointAsync and resume the chain, so the next save appends.
+   *
+   * The chain is walked until the first missing or stale delta file.
+   *
+   * \param fname base checkpoint file name.
+   * \return the number of boosted rounds recovered, 0 when no checkpoint
+   *  exists yet.
+   */
+  virtual int32_t LoadCheckpoint(std::string const& fname) = 0;
+
   /*!
    * \brief Set multiple parameters at once.
    *
@@ -160,6 +279,20 @@ class Learner : public Model, public Configurable, public dmlc::Serializable {
    * \param value The value of parameter
    */
   virtual void SetParam(const std::string& key, const std::string& value) = 0;
+  /*!
+   * \brief Typed fast path for updating a single numeric parameter without
+   *  invalidating the configuration.  Only a small set of hot parameters is
+   *  supported; when this returns false the caller must fall back to
+   *  \ref SetParam.
+   *
+   * \param key   The key of parameter
+   * \param value The value of parameter
+   *
+   * \return True if the parameter was applied through the fast path.
+   */
+  virtual bool SetParamFloat(const std::string&, float) {
+    return false;
+  }
 
   /*!
    * \brief Get the number of features of the booster.
@@ -21,6 +21,17 @@
 #include <utility>
 #include <vector>
 
+/*
+ * Compile-time floor for debug tracing.  Building with
+ * -DXGBOOST_STRIP_DEBUG_LOG=1 turns every `LOG(DEBUG)` statement, together
+ * with the per-call verbosity check it expands to, into dead code, so release
+ * binaries pay nothing for tracing on hot paths.  Warning/info logging and
+ * `verbosity` handling are unaffected.
+ */
+#if !defined(XGBOOST_STRIP_DEBUG_LOG)
+#define XGBOOST_STRIP_DEBUG_LOG 0
+#endif  // !defined(XGBOOST_STRIP_DEBUG_LOG)
+
 namespace xgboost {
 
 class BaseLogger {
@@ -56,6 +67,9 @@ class ConsoleLogger : public BaseLogger {
   static LogVerbosity GlobalVerbosity();
   static LogVerbosity DefaultVerbosity();
   static bool ShouldLog(LogVerbosity verbosity);
+  /*! \brief Whether debug-level tracing is compiled in; constant so that
+   *  gated callers fold away when it is stripped. */
+  constexpr static bool DebugCompiledIn() { return XGBOOST_STRIP_DEBUG_LOG == 0; }
 
   ConsoleLogger() = delete;
   explicit ConsoleLogger(LogVerbosity cur_verb);
@@ -122,7 +136,8 @@ using LogCallbackRegistryStore = dmlc::ThreadLocalStore<LogCallbackRegistry>;
 #undef LOG_DEBUG
 #endif  // defined(LOG_DEBUG)
 #define LOG_DEBUG                                                              \
-  if (::xgboost::ConsoleLogger::ShouldLog(                                     \
+  if (::xgboost::ConsoleLogger::DebugCompiledIn() &&                           \
+      ::xgboost::ConsoleLogger::ShouldLog(                                     \
           ::xgboost::ConsoleLogger::LV::kDebug))                               \
   ::xgboost::ConsoleLogger(__FILE__, __LINE__,                                 \
                            ::xgboost::ConsoleLogger::LogVerbosity::kDebug)
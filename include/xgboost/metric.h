@@ -61,6 +61,31 @@ class Metric : public Configurable {
   virtual bst_float Eval(const HostDeviceVector<bst_float>& preds,
                          const MetaInfo& info,
                          bool distributed) = 0;
+  /*!
+   * \brief Begin a streamed evaluation where the predictions arrive as
+   *  chunks instead of one resident vector, so large external-memory
+   *  evaluation sets never materialize a second full copy.  Followed by a
+   *  sequence of \ref EvalChunk calls covering the rows in order and one
+   *  \ref EvalChunkEnd.  The default implementation declines, in which case
+   *  the caller must use \ref Eval.
+   * \return true when the metric supports chunked accumulation
+   */
+  virtual bool EvalChunkBegin(const MetaInfo&) { return false; }
+  /*!
+   * \brief Accumulate the transformed predictions for rows `[begin, end)`.
+   *  `chunk` is indexed from zero; labels and weights from `begin`.  Only
+   *  valid between \ref EvalChunkBegin and \ref EvalChunkEnd.
+   */
+  virtual void EvalChunk(const HostDeviceVector<bst_float>& /*chunk*/,
+                         const MetaInfo& /*info*/, size_t /*begin*/,
+                         size_t /*end*/) {
+    LOG(FATAL) << "EvalChunkBegin must be checked before EvalChunk.";
+  }
+  /*! \brief Finish a streamed evaluation and return the metric value. */
+  virtual bst_float EvalChunkEnd(bool /*distributed*/) {
+    LOG(FATAL) << "EvalChunkBegin must be checked before EvalChunkEnd.";
+    return 0;
+  }
   /*! \return name of metric */
   virtual const char* Name() const = 0;
   /*! \brief virtual destructor */
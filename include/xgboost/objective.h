@@ -15,6 +15,7 @@
 #include <xgboost/host_device_vector.h>
 
 #include <vector>
+#include <cstddef>
 #include <utility>
 #include <string>
 #include <functional>
@@ -46,6 +47,61 @@ class ObjFunction : public Configurable {
                            int iteration,
                            HostDeviceVector<GradientPair>* out_gpair) = 0;
 
+  /*!
+   * \brief Compute gradients and, when the objective supports it, accumulate
+   *  its default evaluation metric over the same traversal of the
+   *  predictions.  The default implementation only computes gradients and
+   *  returns false; objectives with an elementwise default metric may
+   *  override it to halve the memory traffic of a combined train + eval
+   *  iteration.
+   * \param preds prediction of current round
+   * \param info information about labels, weights, groups in rank
+   * \param iteration current iteration number.
+   * \param out_gpair output of get gradient, saves gradient and second order gradient in
+   * \param out_metric value of the default evaluation metric on preds
+   * \return true when *out_metric was filled; false when the caller must run
+   *  the metric in a separate pass
+   */
+  virtual bool GetGradientFusedEval(const HostDeviceVector<bst_float>& preds,
+                                    const MetaInfo& info,
+                                    int iteration,
+                                    HostDeviceVector<GradientPair>* out_gpair,
+                                    bst_float* /*out_metric*/) {
+    this->GetGradient(preds, info, iteration, out_gpair);
+    return false;
+  }
+
+  /*!
+   * \brief Prepare for computing gradients over row ranges.  When this
+   *  returns true the caller may invoke \ref GetGradientRange concurrently on
+   *  disjoint ranges covering the predictions exactly once — typically from
+   *  the predictor, while each range is still cache resident — followed by a
+   *  single call to \ref GetGradientRangeEnd.  The default implementation
+   *  declines, in which case the caller must use \ref GetGradient.
+   * \param preds prediction of current round
+   * \param info information about labels, weights, groups in rank
+   * \param out_gpair gradient output, sized here so range calls only write
+   * \return true when the objective supports range computation on this device
+   */
+  virtual bool GetGradientRangeBegin(const HostDeviceVector<bst_float>&,
+                                     const MetaInfo&,
+                                     HostDeviceVector<GradientPair>*) {
+    return false;
+  }
+  /*!
+   * \brief Compute gradients for rows `[begin, end)`.  Must be thread-safe
+   *  for disjoint ranges; only valid between \ref GetGradientRangeBegin and
+   *  \ref GetGradientRangeEnd.
+   */
+  virtual void GetGradientRange(const HostDeviceVector<bst_float>& /*preds*/,
+                                const MetaInfo& /*info*/, int /*iteration*/,
+                                std::size_t /*begin*/, std::size_t /*end*/,
+                                HostDeviceVector<GradientPair>* /*out_gpair*/) {
+    LOG(FATAL) << "GetGradientRangeBegin must be checked before GetGradientRange.";
+  }
+  /*! \brief Finish a sequence of range computations, e.g. raise on invalid labels. */
+  virtual void GetGradientRangeEnd() {}
+
   /*! \return the default evaluation metric for the objective */
   virtual const char* DefaultEvalMetric() const = 0;
   // the following functions are optional, most of time default implementation is good enough
@@ -11,6 +11,7 @@
 #include <xgboost/host_device_vector.h>
 
 #include <functional>
+#include <limits>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -134,6 +135,22 @@ class Predictor {
                             const gbm::GBTreeModel& model, int tree_begin,
                             uint32_t const ntree_limit = 0) = 0;
 
+  /**
+   * \brief Batch prediction that reports each contiguous row range as soon as
+   * its predictions are final, so the caller can consume them while they are
+   * still cache resident.  `on_range` receives `[begin, end)` row indices,
+   * covers every row exactly once, and may be invoked concurrently from
+   * worker threads.
+   *
+   * \return True if the ranged traversal was performed; false when the
+   * predictor does not support it and the caller must use \ref PredictBatch.
+   */
+  virtual bool PredictBatchRanged(DMatrix*, PredictionCacheEntry*,
+                                  const gbm::GBTreeModel&, int /*tree_begin*/,
+                                  std::function<void(std::size_t, std::size_t)> const&) {
+    return false;
+  }
+
   /**
    * \brief Inplace prediction.
    * \param           x                      Type erased data adapter.
@@ -156,12 +173,18 @@ class Predictor {
    * \param [in,out]  out_preds   The output preds.
    * \param           model       The model to predict from
    * \param           ntree_limit (Optional) The ntree limit.
+   * \param           decision_threshold (Optional) Stop accumulating trees once
+   *                  the partial sum of a single output group exceeds this
+   *                  margin value, yielding an approximate score.  NaN disables
+   *                  the early exit.
    */
 
   virtual void PredictInstance(const SparsePage::Inst& inst,
                                std::vector<bst_float>* out_preds,
                                const gbm::GBTreeModel& model,
-                               unsigned ntree_limit = 0) = 0;
+                               unsigned ntree_limit = 0,
+                               bst_float decision_threshold =
+                                   std::numeric_limits<bst_float>::quiet_NaN()) = 0;
 
   /**
    * \brief predict the leaf index of each tree, the output will be nsample *
@@ -177,6 +200,49 @@ class Predictor {
                            const gbm::GBTreeModel& model,
                            unsigned ntree_limit = 0) = 0;
 
+  /**
+   * \brief predict the leaf index of each tree directly into a caller
+   * provided int32 buffer of size nsample * ntree, skipping the float
+   * materialization of PredictLeaf.  The buffer may be backed by a memory
+   * mapped file.
+   *
+   * \param [in,out]  dmat        The input feature matrix.
+   * \param [out]     out_indices The caller provided output buffer.
+   * \param           model       Model to make predictions from.
+   * \param           ntree_limit (Optional) The ntree limit.
+   *
+   * \return  True if this predictor implements the direct path; false leaves
+   *          the buffer untouched and the caller falls back to PredictLeaf.
+   */
+  virtual bool PredictLeafInt32(DMatrix*, common::Span<bst_node_t>,
+                                const gbm::GBTreeModel&, unsigned = 0) {
+    return false;
+  }
+
+  /**
+   * \brief aggregate per-leaf statistics in one traversal: for every used
+   * tree and node, the number of rows routed to it and the sums of their
+   * labels and weights.  Rows are never materialized individually, turning
+   * a per-row leaf index export into a summary of a few MB.
+   *
+   * Output layout: one segment of `stride * 3` floats per used tree, where
+   * `stride` is the node count of the largest used tree; the entry at
+   * `(tree * stride + nid) * 3` holds {row count, label sum, weight sum} of
+   * node `nid`.  Unweighted rows count with weight one.
+   *
+   * \param [in,out]  dmat        The input feature matrix.
+   * \param [out]     out_stats   The aggregated per-node statistics.
+   * \param           model       Model to make predictions from.
+   * \param           ntree_limit (Optional) The ntree limit.
+   *
+   * \return  True if this predictor implements the aggregation; false leaves
+   *          the output untouched.
+   */
+  virtual bool PredictLeafStats(DMatrix*, std::vector<bst_float>*,
+                                const gbm::GBTreeModel&, unsigned = 0) {
+    return false;
+  }
+
   /**
    * \fn  virtual void Predictor::PredictContribution( DMatrix* dmat,
    * std::vector<bst_float>* out_contribs, const gbm::GBTreeModel& model,
@@ -223,6 +289,26 @@ class Predictor {
       std::string const& name, GenericParameter const* generic_param);
 };
 
+namespace predictor {
+/*!
+ * \brief Score several tree models over one dense row batch in a single
+ *        interleaved pass on the CPU.
+ *
+ * Each row is staged once and walked through every model's trees in tree
+ * blocks scheduled round robin across the models, amortizing the staging and
+ * memory traffic that per-booster prediction repeats for every model.
+ *
+ * \param models boosters to score; each must take n_cols features and
+ *  produce a single output group.
+ * \param values dense row major feature matrix of shape [n_rows, n_cols].
+ * \param missing value marking a missing feature.
+ * \param out_margins untransformed margins, laid out [model][row].
+ */
+void PredictDenseMulti(std::vector<gbm::GBTreeModel const *> const &models,
+                       float const *values, size_t n_rows, size_t n_cols,
+                       float missing, float *out_margins);
+}  // namespace predictor
+
 /*!
  * \brief Registry entry for predictor.
  */
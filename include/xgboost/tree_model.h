@@ -26,7 +26,19 @@
 
 namespace xgboost {
 
-struct PathElement;  // forward declaration
+// Used by TreeShap
+// data we keep about our decision path
+// note that pweight is included for convenience and is not tied with the other attributes
+// the pweight of the i'th path element is the permuation weight of paths with i-1 ones in them
+struct PathElement {
+  int feature_index;
+  bst_float zero_fraction;
+  bst_float one_fraction;
+  bst_float pweight;
+  PathElement() = default;
+  PathElement(int i, bst_float z, bst_float o, bst_float w) :
+    feature_index(i), zero_fraction(z), one_fraction(o), pweight(w) {}
+};
 
 class Json;
 // FIXME(trivialfis): Once binary IO is gone, make this parameter internal as it should
@@ -359,6 +371,15 @@ class RegTree : public Model {
    * \param fo output stream
    */
   void Save(dmlc::Stream* fo) const;
+  /*!
+   * \brief load the tree from externally assembled node and stat arrays, used
+   *  by the columnar model format
+   * \param p tree parameter
+   * \param nodes tree nodes
+   * \param stats node statistics
+   */
+  void LoadNodes(TreeParam const& p, std::vector<Node>&& nodes,
+                 std::vector<RTreeNodeStat>&& stats);
 
   void LoadModel(Json const& in) override;
   void SaveModel(Json* out) const override;
@@ -445,6 +466,18 @@ class RegTree : public Model {
                          bst_float right_leaf_weight, bst_float loss_change,
                          float sum_hess, float left_sum, float right_sum);
 
+  /*!
+   * \brief reserve storage for at least n_nodes nodes so that growing the
+   *        tree does not reallocate the node arrays split by split
+   * \param n_nodes lower bound on node capacity
+   */
+  void Reserve(bst_node_t n_nodes) {
+    nodes_.reserve(n_nodes);
+    stats_.reserve(n_nodes);
+    split_types_.reserve(n_nodes);
+    split_categories_segments_.reserve(n_nodes);
+  }
+
   /*!
    * \brief get current depth
    * \param nid node id
@@ -505,6 +538,17 @@ class RegTree : public Model {
      * \param inst The sparse instance to drop.
      */
     void Drop(const SparsePage::Inst& inst);
+    /*!
+     * \brief restrict staging to the features whose bit is set.
+     * \param used bitmap with one bit per feature index; an empty span
+     *  disables the filter.  The caller keeps the storage alive.
+     * \param n_used number of set bits in the bitmap.
+     *
+     * Fill then skips features the model never tests and HasMissing becomes
+     * relative to the tested features, so a row that covers all of them
+     * still takes the dense traversal paths.
+     */
+    void SetFilter(common::Span<uint32_t const> used, size_t n_used);
     /*!
      * \brief returns the size of the feature vector
      * \return the size of the feature vector
@@ -536,6 +580,10 @@ class RegTree : public Model {
     };
     std::vector<Entry> data_;
     bool has_missing_;
+    /*! \brief optional bitmap of features the model tests, see SetFilter */
+    common::Span<uint32_t const> used_;
+    /*! \brief number of set bits in used_ */
+    size_t n_used_ {0};
   };
   /*!
    * \brief get the leaf index
@@ -555,6 +603,20 @@ class RegTree : public Model {
   void CalculateContributions(const RegTree::FVec& feat,
                               bst_float* out_contribs, int condition = 0,
                               unsigned condition_feature = 0) const;
+  /*!
+   * \brief as above, with caller provided scratch for the unique path data so
+   *  batch callers avoid an allocation and a tree walk per row
+   * \param path_scratch preallocated storage holding at least
+   *  PathScratchSize() elements
+   */
+  void CalculateContributions(const RegTree::FVec& feat, bst_float* out_contribs,
+                              int condition, unsigned condition_feature,
+                              PathElement* path_scratch) const;
+  /*! \brief number of PathElement slots TreeShap needs for this tree */
+  size_t PathScratchSize() const {
+    const size_t maxd = this->MaxDepth(0) + 2;
+    return (maxd * (maxd + 1)) / 2;
+  }
   /*!
    * \brief Recursive function that computes the feature attributions for a single tree.
    * \param feat dense feature vector, if the feature is missing the field is set to NaN
@@ -582,6 +644,29 @@ class RegTree : public Model {
    */
   void CalculateContributionsApprox(const RegTree::FVec& feat,
                                     bst_float* out_contribs) const;
+  /*!
+   * \brief as above, but scaled by a tree weight and accumulated directly into
+   *  the output.  The approximate method touches only the nodes on the decision
+   *  path, so staging a full feature-wide buffer per tree would cost more than
+   *  the traversal itself on wide datasets.
+   */
+  void CalculateContributionsApprox(const RegTree::FVec& feat,
+                                    bst_float* out_contribs, bst_float scale) const;
+  /*!
+   * \brief largest absolute difference between sibling subtree means, a
+   *  conservative estimate of how much the approximate attribution of a single
+   *  split in this tree can deviate from exact TreeSHAP.  Requires
+   *  FillNodeMeanValues to have run.
+   */
+  bst_float MaxSiblingMeanDelta() const;
+  /*!
+   * \brief Re-lay the tree out for inference: deleted nodes are pruned,
+   *  the remaining nodes are renumbered breadth-first so traversal walks
+   *  forward through memory, and the training-only node statistics are
+   *  reset.  Predictions are unchanged; training-side consumers of the
+   *  statistics (dump with stats, refresh) must not run afterwards.
+   */
+  void CompactForInference();
   /*!
    * \brief get next position of the tree given current pid
    * \param pid Current node id.
@@ -618,6 +703,24 @@ class RegTree : public Model {
   std::vector<FeatureType> const &GetSplitTypes() const { return split_types_; }
   common::Span<uint32_t const> GetSplitCategories() const { return split_categories_; }
   auto const& GetSplitCategoriesPtr() const { return split_categories_segments_; }
+  /*! \brief Whether the tree contains any categorical split. */
+  bool HasCategoricalSplit() const { return !split_categories_.empty(); }
+  /*!
+   * \brief Get the bitset of matching categories for a node.
+   * \param nidx Index of node, must be a categorical split.
+   */
+  common::Span<uint32_t const> NodeCats(bst_node_t nidx) const {
+    auto const& segment = split_categories_segments_[nidx];
+    return common::Span<uint32_t const>{split_categories_}.subspan(segment.beg,
+                                                                   segment.size);
+  }
+  /*!
+   * \brief Decide the direction at a categorical split.
+   * \param nidx Index of node, must be a categorical split.
+   * \param fvalue The (non-missing) category value of the row.
+   * \return Whether the row goes to the left branch.
+   */
+  bool CategoricalDecision(bst_node_t nidx, bst_float fvalue) const;
 
   // The fields of split_categories_segments_[i] are set such that
   // the range split_categories_[beg:(beg+size)] stores the bitset for
@@ -689,26 +792,54 @@ inline void RegTree::FVec::Init(size_t size) {
 
 inline void RegTree::FVec::Fill(const SparsePage::Inst& inst) {
   size_t feature_count = 0;
-  for (auto const& entry : inst) {
-    if (entry.index >= data_.size()) {
-      continue;
+  if (used_.empty()) {
+    for (auto const& entry : inst) {
+      if (entry.index >= data_.size()) {
+        continue;
+      }
+      data_[entry.index].fvalue = entry.fvalue;
+      ++feature_count;
+    }
+    has_missing_ = data_.size() != feature_count;
+  } else {
+    for (auto const& entry : inst) {
+      if (entry.index >= data_.size() ||
+          !((used_[entry.index >> 5] >> (entry.index & 31)) & 1u)) {
+        continue;
+      }
+      data_[entry.index].fvalue = entry.fvalue;
+      ++feature_count;
     }
-    data_[entry.index].fvalue = entry.fvalue;
-    ++feature_count;
+    has_missing_ = n_used_ != feature_count;
   }
-  has_missing_ = data_.size() != feature_count;
 }
 
 inline void RegTree::FVec::Drop(const SparsePage::Inst& inst) {
-  for (auto const& entry : inst) {
-    if (entry.index >= data_.size()) {
-      continue;
+  if (used_.empty()) {
+    for (auto const& entry : inst) {
+      if (entry.index >= data_.size()) {
+        continue;
+      }
+      data_[entry.index].flag = -1;
+    }
+  } else {
+    for (auto const& entry : inst) {
+      if (entry.index >= data_.size() ||
+          !((used_[entry.index >> 5] >> (entry.index & 31)) & 1u)) {
+        continue;
+      }
+      data_[entry.index].flag = -1;
     }
-    data_[entry.index].flag = -1;
   }
   has_missing_ = true;
 }
 
+inline void RegTree::FVec::SetFilter(common::Span<uint32_t const> used,
+                                     size_t n_used) {
+  used_ = used;
+  n_used_ = n_used;
+}
+
 inline size_t RegTree::FVec::Size() const {
   return data_.size();
 }
@@ -739,15 +870,19 @@ inline int RegTree::GetLeafIndex(const RegTree::FVec& feat) const {
 /*! \brief get next position of the tree given current pid */
 template <bool has_missing>
 inline int RegTree::GetNext(int pid, bst_float fvalue, bool is_unknown) const {
+  if (has_missing && is_unknown) {
+    return (*this)[pid].DefaultChild();
+  }
+  if (!split_categories_.empty() &&
+      split_types_[pid] == FeatureType::kCategorical) {
+    return this->CategoricalDecision(pid, fvalue) ? (*this)[pid].LeftChild()
+                                                  : (*this)[pid].RightChild();
+  }
   if (has_missing) {
-    if (is_unknown) {
-      return (*this)[pid].DefaultChild();
+    if (fvalue < (*this)[pid].SplitCond()) {
+      return (*this)[pid].LeftChild();
     } else {
-      if (fvalue < (*this)[pid].SplitCond()) {
-        return (*this)[pid].LeftChild();
-      } else {
-        return (*this)[pid].RightChild();
-      }
+      return (*this)[pid].RightChild();
     }
   } else {
     // 35% speed up due to reduced miss branch predictions
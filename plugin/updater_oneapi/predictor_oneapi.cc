@@ -404,8 +404,10 @@ class PredictorOneAPI : public Predictor {
 
   void PredictInstance(const SparsePage::Inst& inst,
                        std::vector<bst_float>* out_preds,
-                       const gbm::GBTreeModel& model, unsigned ntree_limit) override {
-    cpu_predictor->PredictInstance(inst, out_preds, model, ntree_limit);
+                       const gbm::GBTreeModel& model, unsigned ntree_limit,
+                       bst_float decision_threshold) override {
+    cpu_predictor->PredictInstance(inst, out_preds, model, ntree_limit,
+                                   decision_threshold);
   }
 
   void PredictLeaf(DMatrix* p_fmat, std::vector<bst_float>* out_preds,
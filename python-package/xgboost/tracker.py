@@ -214,6 +214,37 @@ class RabitTracker(object):
             parent_map[r] = (r + 1) // 2 - 1
         return tree_map, parent_map
 
+    def get_host_tree(self, hosts):
+        """
+        build a tree that places workers sharing a host in the same subtree,
+        so only the subtree root of each host talks across the network
+
+        hosts is the list of host addresses ordered by rank; workers on the
+        same host must occupy consecutive ranks
+        """
+        groups = []
+        for r, h in enumerate(hosts):
+            if groups and hosts[groups[-1][0]] == h:
+                groups[-1].append(r)
+            else:
+                groups.append([r])
+        parent_map = {}
+        for g, members in enumerate(groups):
+            if g == 0:
+                parent_map[members[0]] = -1
+            else:
+                parent_map[members[0]] = groups[(g + 1) // 2 - 1][0]
+            for i in range(1, len(members)):
+                parent_map[members[i]] = members[(i + 1) // 2 - 1]
+        tree_map = {}
+        for r in range(len(hosts)):
+            tree_map[r] = []
+        for r, p in parent_map.items():
+            if p != -1:
+                tree_map[r].append(p)
+                tree_map[p].append(r)
+        return tree_map, parent_map
+
     def find_share_ring(self, tree_map, parent_map, r):
         """
         get a ring structure that tends to share nodes with the tree
@@ -275,6 +306,15 @@ class RabitTracker(object):
                 parent_map_[rmap[k]] = -1
         return tree_map_, parent_map_, ring_map_
 
+    def get_host_link_map(self, hosts):
+        """
+        get the link map for a batch of workers whose hosts are all known,
+        keeping workers that share a host in the same subtree
+        """
+        tree_map, parent_map = self.get_host_tree(hosts)
+        ring_map = self.get_ring(tree_map, parent_map)
+        return tree_map, parent_map, ring_map
+
     def accept_slaves(self, nslave):
         # set of nodes that finishs the job
         shutdown = {}
@@ -321,6 +361,12 @@ class RabitTracker(object):
                 pending.append(s)
                 if len(pending) == len(todo_nodes):
                     pending.sort(key=lambda x: x.host)
+                    if len(pending) == nslave:
+                        # the whole world is assigned in one batch so the host
+                        # of every rank is known: rebuild the link map to keep
+                        # workers sharing a host in the same subtree
+                        tree_map, parent_map, ring_map = self.get_host_link_map(
+                            [p.host for p in pending])
                     for s in pending:
                         rank = todo_nodes.pop(0)
                         if s.jobid != 'NULL':
@@ -177,6 +177,22 @@ inline void Allreduce(DType *sendrecvbuf, size_t count,
                      engine::mpi::GetType<DType>(), OP::kType, InvokeLambda, &prepare_fun);
 }
 
+// blocks until the asynchronously started reduction has completed
+inline void AllreduceHandle::Wait() {
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+}
+// starts inplace Allreduce on a background thread
+template<typename OP, typename DType>
+inline AllreduceHandle AllreduceStart(DType *sendrecvbuf, size_t count) {
+  AllreduceHandle handle;
+  handle.worker_ = std::thread([sendrecvbuf, count]() {
+    Allreduce<OP>(sendrecvbuf, count);
+  });
+  return handle;
+}
+
 // Performs inplace Allgather
 template<typename DType>
 inline void Allgather(DType *sendrecvbuf,
@@ -336,6 +352,15 @@ inline void Reducer<DType, freduce>::Allreduce(DType *sendrecvbuf, size_t count,
                                                std::function<void()> prepare_fun) {
   this->Allreduce(sendrecvbuf, count, InvokeLambda, &prepare_fun);
 }
+template<typename DType, void (*freduce)(DType &dst, const DType &src)>  // NOLINT(*)
+inline AllreduceHandle Reducer<DType, freduce>::AllreduceStart(DType *sendrecvbuf,
+                                                               size_t count) {
+  AllreduceHandle handle;
+  handle.worker_ = std::thread([this, sendrecvbuf, count]() {
+    this->Allreduce(sendrecvbuf, count);
+  });
+  return handle;
+}
 template<typename DType>
 inline void SerializeReducer<DType>::Allreduce(DType *sendrecvobj,
                                                size_t max_nbytes, size_t count,
@@ -23,6 +23,7 @@
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <sys/ioctl.h>
 
 #endif  // defined(_WIN32)
@@ -375,6 +376,27 @@ class TCPSocket : public Socket{
                    reinterpret_cast<char*>(&opt), sizeof(opt)) < 0) {
       Socket::Error("SetKeepAlive");
     }
+#endif  // !IS_MINGW()
+  }
+  /*!
+   * \brief set the kernel send/receive buffer sizes
+   *  A zero size keeps the corresponding OS default.  Larger buffers are
+   *  needed to keep a high bandwidth-delay-product link busy.
+   * \param send_size size of the send buffer in bytes
+   * \param recv_size size of the receive buffer in bytes
+   */
+  void SetBufSize(int send_size, int recv_size) {
+#if !IS_MINGW()
+    if (send_size > 0 &&
+        setsockopt(sockfd, SOL_SOCKET, SO_SNDBUF,
+                   reinterpret_cast<char*>(&send_size), sizeof(send_size)) < 0) {
+      Socket::Error("SetBufSize-SndBuf");
+    }
+    if (recv_size > 0 &&
+        setsockopt(sockfd, SOL_SOCKET, SO_RCVBUF,
+                   reinterpret_cast<char*>(&recv_size), sizeof(recv_size)) < 0) {
+      Socket::Error("SetBufSize-RcvBuf");
+    }
 #endif  // !IS_MINGW()
   }
   inline void SetLinger(int timeout = 0) {
@@ -453,6 +475,74 @@ class TCPSocket : public Socket{
 #else
     return false;
 #endif  // !IS_MINGW()
+  }
+  /*!
+   * \brief create a unix domain stream socket
+   *  used as a transport between ranks on the same host that bypasses
+   *  the TCP stack; send/recv/poll work the same as on a TCP socket
+   */
+  inline void CreateUnix() {
+#if !defined(_WIN32)
+    sockfd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sockfd == kInvalidSocket) {
+      Socket::Error("CreateUnix");
+    }
+#endif  // !defined(_WIN32)
+  }
+  /*!
+   * \brief bind the socket to a unix domain path and start listening,
+   *  removing any stale socket file left behind by a dead process
+   * \param path filesystem path of the socket
+   * \param backlog backlog parameter
+   * \return whether bind and listen succeeded
+   */
+  inline bool TryBindListenUnix(const std::string &path, int backlog = 16) {
+#if !defined(_WIN32)
+    sockaddr_un addr;
+    if (path.length() >= sizeof(addr.sun_path)) return false;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(path.c_str());
+    if (bind(sockfd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+      return false;
+    }
+    listen(sockfd, backlog);
+    return true;
+#else
+    return false;
+#endif  // !defined(_WIN32)
+  }
+  /*!
+   * \brief connect to a unix domain socket
+   * \param path filesystem path of the socket
+   * \return whether connect is successful
+   */
+  inline bool ConnectUnix(const std::string &path) {
+#if !defined(_WIN32)
+    sockaddr_un addr;
+    if (path.length() >= sizeof(addr.sun_path)) return false;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    return connect(sockfd, reinterpret_cast<sockaddr*>(&addr),
+                   sizeof(addr)) == 0;
+#else
+    return false;
+#endif  // !defined(_WIN32)
+  }
+  /*! \brief whether this socket is in the unix domain */
+  inline bool IsUnixDomain() const {
+#if !defined(_WIN32)
+    sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+    if (getsockname(sockfd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+      return false;
+    }
+    return addr.ss_family == AF_UNIX;
+#else
+    return false;
+#endif  // !defined(_WIN32)
   }
   /*!
    * \brief send data using the socket
@@ -17,6 +17,10 @@
 // to use rabit interface, there is no need to read engine.h
 // rabit.h and serializable.h are enough to use the interface
 #include "./internal/engine.h"
+#if DMLC_USE_CXX11
+#include <thread>
+#include <utility>
+#endif  // DMLC_USE_CXX11
 
 /*! \brief rabit namespace */
 namespace rabit {
@@ -177,6 +181,48 @@ inline void Allgather(DType *sendrecvbuf_,
 
 // C++11 support for lambda prepare function
 #if DMLC_USE_CXX11
+/*!
+ * \brief handle of an asynchronous Allreduce started by AllreduceStart
+ *
+ *  The content of sendrecvbuf must not be touched and no other rabit call
+ *  may be issued between the start and the matching Wait, because rabit
+ *  operations have to execute in the same order on every worker.  At most
+ *  one asynchronous operation can be in flight per process.
+ * \sa AllreduceStart
+ */
+class AllreduceHandle {
+ public:
+  AllreduceHandle() = default;
+  AllreduceHandle(AllreduceHandle &&) = default;
+  AllreduceHandle &operator=(AllreduceHandle &&other) {
+    this->Wait();
+    worker_ = std::move(other.worker_);
+    return *this;
+  }
+  /*! \brief blocks until the started reduction has completed */
+  inline void Wait();
+  ~AllreduceHandle() { this->Wait(); }
+
+ private:
+  template<typename OP, typename DType>
+  friend AllreduceHandle AllreduceStart(DType *sendrecvbuf, size_t count);
+  template<typename DType, void (*freduce)(DType &dst, const DType &src)>  // NOLINT(*)
+  friend class Reducer;
+  /*! \brief thread running the engine call */
+  std::thread worker_;
+};
+/*!
+ * \brief starts an in-place Allreduce on sendrecvbuf without blocking,
+ *  the result is only valid in sendrecvbuf after Wait on the returned
+ *  handle has completed
+ * \param sendrecvbuf buffer for both sending and receiving data
+ * \param count number of elements to be reduced
+ * \tparam OP see namespace op, reduce operator
+ * \tparam DType data type
+ * \sa AllreduceHandle
+ */
+template<typename OP, typename DType>
+inline AllreduceHandle AllreduceStart(DType *sendrecvbuf, size_t count);
 /*!
  * \brief performs in-place Allreduce, on sendrecvbuf
  *        with a prepare function specified by a lambda function
@@ -312,6 +358,15 @@ class Reducer {
    */
   inline void Allreduce(DType *sendrecvbuf, size_t count,
                         std::function<void()> prepare_fun);
+  /*!
+   * \brief starts the customized in-place all reduce without blocking,
+   *  the result is only valid in sendrecvbuf after Wait on the returned
+   *  handle has completed
+   * \param sendrecvbuf the in place send-recv buffer
+   * \param count number of elements to be reduced
+   * \sa AllreduceHandle
+   */
+  inline AllreduceHandle AllreduceStart(DType *sendrecvbuf, size_t count);
 #endif  // DMLC_USE_CXX11
 
  private:
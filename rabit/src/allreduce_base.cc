@@ -11,6 +11,7 @@
 #include "allreduce_base.h"
 
 #ifndef _WIN32
+#include <ifaddrs.h>
 #include <netinet/tcp.h>
 #endif  // _WIN32
 
@@ -19,6 +20,41 @@
 
 namespace rabit {
 namespace engine {
+#ifndef _WIN32
+// whether the address names an interface of this host, so the peer can be
+// reached through a unix domain socket instead of the TCP stack
+static bool IsLocalAddress(const std::string &host) {
+  if (host == "localhost" || host.compare(0, 4, "127.") == 0) return true;
+  struct ifaddrs *ifa_head = nullptr;
+  if (getifaddrs(&ifa_head) != 0) return false;
+  bool local = false;
+  char buf[INET6_ADDRSTRLEN];
+  for (struct ifaddrs *ifa = ifa_head; ifa != nullptr; ifa = ifa->ifa_next) {
+    if (ifa->ifa_addr == nullptr) continue;
+    const void *src = nullptr;
+    if (ifa->ifa_addr->sa_family == AF_INET) {
+      src = &reinterpret_cast<struct sockaddr_in*>(ifa->ifa_addr)->sin_addr;
+    } else if (ifa->ifa_addr->sa_family == AF_INET6) {
+      src = &reinterpret_cast<struct sockaddr_in6*>(ifa->ifa_addr)->sin6_addr;
+    } else {
+      continue;
+    }
+    if (inet_ntop(ifa->ifa_addr->sa_family, src, buf, sizeof(buf)) != nullptr &&
+        host == buf) {
+      local = true;
+      break;
+    }
+  }
+  freeifaddrs(ifa_head);
+  return local;
+}
+// path of the unix domain socket used by the worker that listens on the
+// given TCP port; the port is unique per host so the path is too
+static std::string UnixSockPath(int port) {
+  return "/tmp/rabit." + std::to_string(getuid()) +
+         "." + std::to_string(port) + ".sock";
+}
+#endif  // !_WIN32
 // constructor
 AllreduceBase::AllreduceBase() {
   tracker_uri = "NULL";
@@ -35,6 +71,8 @@ AllreduceBase::AllreduceBase() {
   reduce_ring_mincount = 32 << 10;
   // 1M reducer size each time
   tree_reduce_minsize = 1 << 20;
+  // 32K reducer size each ring step
+  ring_reduce_minsize = 32 << 10;
   // tracker URL
   task_id = "NULL";
   err_link = nullptr;
@@ -189,6 +227,7 @@ void AllreduceBase::SetParam(const char *name, const char *val) {
   if (!strcmp(name, "rabit_world_size")) world_size = atoi(val);
   if (!strcmp(name, "rabit_hadoop_mode")) hadoop_mode = utils::StringToBool(val);
   if (!strcmp(name, "rabit_tree_reduce_minsize")) tree_reduce_minsize =  atoi(val);
+  if (!strcmp(name, "rabit_ring_reduce_minsize")) ring_reduce_minsize = atoi(val);
   if (!strcmp(name, "rabit_reduce_ring_mincount")) {
     reduce_ring_mincount = atoi(val);
     utils::Assert(reduce_ring_mincount > 0, "rabit_reduce_ring_mincount should be greater than 0");
@@ -219,6 +258,15 @@ void AllreduceBase::SetParam(const char *name, const char *val) {
       rabit_enable_tcp_no_delay = false;
     }
   }
+  if (!strcmp(name, "rabit_enable_unix_socket")) {
+    rabit_enable_unix_socket = utils::StringToBool(val);
+  }
+  if (!strcmp(name, "rabit_sock_sndbuf")) {
+    sock_sndbuf = static_cast<int>(ParseUnit(name, val));
+  }
+  if (!strcmp(name, "rabit_sock_rcvbuf")) {
+    sock_rcvbuf = static_cast<int>(ParseUnit(name, val));
+  }
 }
 /*!
  * \brief initialize connection to the tracker
@@ -322,6 +370,22 @@ bool AllreduceBase::ReConnectLinks(const char *cmd) {
     utils::Check(port != -1, "ReConnectLink fail to bind the ports specified");
     sock_listen.Listen();
 
+    // additionally listen on a unix domain socket so that ranks on the same
+    // host connect through it instead of the TCP stack
+    utils::TCPSocket sock_unix_listen;
+    std::string unix_path;
+#ifndef _WIN32
+    if (rabit_enable_unix_socket) {
+      unix_path = UnixSockPath(port);
+      sock_unix_listen.CreateUnix();
+      if (!sock_unix_listen.TryBindListenUnix(unix_path)) {
+        // the TCP listener still accepts every peer
+        sock_unix_listen.Close();
+        unix_path.clear();
+      }
+    }
+#endif  // !_WIN32
+
     // get number of to connect and number of to accept nodes from tracker
     int num_conn, num_accept, num_error = 1;
     do {
@@ -356,8 +420,19 @@ bool AllreduceBase::ReConnectLinks(const char *cmd) {
         Assert(tracker.RecvAll(&hrank, sizeof(hrank)) == sizeof(hrank),
                "ReConnectLink failure 10");
 
-        r.sock.Create();
-        if (!r.sock.Connect(utils::SockAddr(hname.c_str(), hport))) {
+        bool connected = false;
+#ifndef _WIN32
+        if (rabit_enable_unix_socket && IsLocalAddress(hname)) {
+          r.sock.CreateUnix();
+          connected = r.sock.ConnectUnix(UnixSockPath(hport));
+          if (!connected) r.sock.Close();
+        }
+#endif  // !_WIN32
+        if (!connected) {
+          r.sock.Create();
+          connected = r.sock.Connect(utils::SockAddr(hname.c_str(), hport));
+        }
+        if (!connected) {
           num_error += 1;
           r.sock.Close();
           continue;
@@ -391,7 +466,18 @@ bool AllreduceBase::ReConnectLinks(const char *cmd) {
     // listen to incoming links
     for (int i = 0; i < num_accept; ++i) {
       LinkRecord r;
-      r.sock = sock_listen.Accept();
+      if (!sock_unix_listen.IsClosed()) {
+        // accept from whichever listener becomes ready
+        utils::PollHelper watcher;
+        watcher.WatchRead(sock_listen);
+        watcher.WatchRead(sock_unix_listen);
+        watcher.Poll(timeout_sec);
+        r.sock = watcher.CheckRead(sock_unix_listen)
+                     ? sock_unix_listen.Accept()
+                     : sock_listen.Accept();
+      } else {
+        r.sock = sock_listen.Accept();
+      }
       Assert(r.sock.SendAll(&rank, sizeof(rank)) == sizeof(rank),
              "ReConnectLink failure 15");
       Assert(r.sock.RecvAll(&r.rank, sizeof(r.rank)) == sizeof(r.rank),
@@ -409,16 +495,26 @@ bool AllreduceBase::ReConnectLinks(const char *cmd) {
       if (!match) all_links.push_back(r);
     }
     sock_listen.Close();
+#ifndef _WIN32
+    if (!sock_unix_listen.IsClosed()) {
+      sock_unix_listen.Close();
+      unlink(unix_path.c_str());
+    }
+#endif  // !_WIN32
     this->parent_index = -1;
     // setup tree links and ring structure
     tree_links.plinks.clear();
     int tcpNoDelay = 1;
     for (auto & all_link : all_links) {
       utils::Assert(!all_link.sock.BadSocket(), "ReConnectLink: bad socket");
+      const bool is_unix = all_link.sock.IsUnixDomain();
       // set the socket to non-blocking mode, enable TCP keepalive
       all_link.sock.SetNonBlock(true);
-      all_link.sock.SetKeepAlive(true);
-      if (rabit_enable_tcp_no_delay) {
+      if (!is_unix) all_link.sock.SetKeepAlive(true);
+      if (sock_sndbuf > 0 || sock_rcvbuf > 0) {
+        all_link.sock.SetBufSize(sock_sndbuf, sock_rcvbuf);
+      }
+      if (rabit_enable_tcp_no_delay && !is_unix) {
 #if defined(__unix__)
         setsockopt(all_link.sock, IPPROTO_TCP,
                    TCP_NODELAY, reinterpret_cast<void *>(&tcpNoDelay), sizeof(tcpNoDelay));
@@ -891,6 +987,12 @@ AllreduceBase::TryReduceScatterRing(void *sendrecvbuf_,
   next.InitBuffer(type_nbytes, step, reduce_buffer_size);
   // set size_read to read pointer for ring buffer to work properly
   next.size_read = read_ptr;
+  // minimal number of bytes to accumulate before invoking the reducer,
+  // so large payloads are reduced and forwarded in sizable chunks instead
+  // of once per received packet; capped by the ring buffer size so reading
+  // can never stall while waiting for a full chunk
+  const size_t eachreduce =
+      std::min(ring_reduce_minsize / type_nbytes * type_nbytes, next.buffer_size);
 
   while (true) {
     // select helper
@@ -916,19 +1018,22 @@ AllreduceBase::TryReduceScatterRing(void *sendrecvbuf_,
       // sync the rate
       read_ptr = next.size_read;
       utils::Assert(read_ptr <= stop_read, "[%d] read_ptr boundary check", rank);
-      const size_t buffer_size = next.buffer_size;
-      size_t max_reduce = (read_ptr  / type_nbytes) * type_nbytes;
-      while (reduce_ptr < max_reduce) {
-        size_t bstart = reduce_ptr % buffer_size;
-        size_t nread = std::min(buffer_size - bstart,
-                                max_reduce - reduce_ptr);
-        size_t rstart = reduce_ptr % total_size;
-        nread = std::min(nread, total_size - rstart);
-        reducer(next.buffer_head + bstart,
-                sendrecvbuf + rstart,
-                static_cast<int>(nread / type_nbytes),
-                MPI::Datatype(type_nbytes));
-        reduce_ptr += nread;
+      // make sure to accumulate minimal reducer size, except at slice end
+      if (read_ptr - reduce_ptr >= eachreduce || read_ptr == stop_read) {
+        const size_t buffer_size = next.buffer_size;
+        size_t max_reduce = (read_ptr  / type_nbytes) * type_nbytes;
+        while (reduce_ptr < max_reduce) {
+          size_t bstart = reduce_ptr % buffer_size;
+          size_t nread = std::min(buffer_size - bstart,
+                                  max_reduce - reduce_ptr);
+          size_t rstart = reduce_ptr % total_size;
+          nread = std::min(nread, total_size - rstart);
+          reducer(next.buffer_head + bstart,
+                  sendrecvbuf + rstart,
+                  static_cast<int>(nread / type_nbytes),
+                  MPI::Datatype(type_nbytes));
+          reduce_ptr += nread;
+        }
       }
     }
     if (write_ptr < reduce_ptr && write_ptr != stop_write) {
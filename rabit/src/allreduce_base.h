@@ -544,6 +544,8 @@ class AllreduceBase : public IEngine {
   size_t reduce_ring_mincount;  // NOLINT
   // minimul block size per tree reduce
   size_t tree_reduce_minsize;  // NOLINT
+  // minimal block size per ring reduce
+  size_t ring_reduce_minsize;  // NOLINT
   // current rank
   int rank;  // NOLINT
   // world size
@@ -560,6 +562,13 @@ class AllreduceBase : public IEngine {
   bool rabit_timeout = false;  // NOLINT
   // Enable TCP node delay
   bool rabit_enable_tcp_no_delay = false;  // NOLINT
+  // connect ranks on the same host through unix domain sockets instead of
+  // the TCP stack; falls back to TCP transparently when unavailable
+  bool rabit_enable_unix_socket = true;  // NOLINT
+  // socket send/receive buffer sizes for peer links, 0 keeps the OS default.
+  // On long fat networks the default buffers bound the per-link throughput.
+  int sock_sndbuf = 0;  // NOLINT
+  int sock_rcvbuf = 0;  // NOLINT
 };
 }  // namespace engine
 }  // namespace rabit
@@ -5,7 +5,11 @@
 #include <cstdio>
 #include <cstring>
 #include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
 #include <algorithm>
+#include <typeinfo>
 #include <vector>
 #include <string>
 #include <memory>
@@ -20,9 +24,14 @@
 #include "xgboost/json.h"
 #include "xgboost/global_config.h"
 
+#include "xgboost/predictor.h"
+
 #include "c_api_error.h"
 #include "../common/io.h"
+#include "../gbm/gbtree.h"
 #include "../common/charconv.h"
+#include "../common/memory_stats.h"
+#include "../common/profile.h"
 #include "../data/adapter.h"
 #include "../data/simple_dmatrix.h"
 #include "../data/proxy_dmatrix.h"
@@ -133,6 +142,22 @@ XGB_DLL int XGBGetGlobalConfig(const char** json_str) {
   API_END();
 }
 
+XGB_DLL int XGBGetProfileCounters(const char** json_str) {
+  API_BEGIN();
+  auto& local = *GlobalConfigAPIThreadLocalStore::Get();
+  local.ret_str = common::ProfileRegistry::Instance().CollectJson();
+  *json_str = local.ret_str.c_str();
+  API_END();
+}
+
+XGB_DLL int XGBGetMemoryStats(const char** json_str) {
+  API_BEGIN();
+  auto& local = *GlobalConfigAPIThreadLocalStore::Get();
+  local.ret_str = common::MemoryStats::Instance().CollectJson();
+  *json_str = local.ret_str.c_str();
+  API_END();
+}
+
 XGB_DLL int XGDMatrixCreateFromFile(const char *fname,
                                     int silent,
                                     DMatrixHandle *out) {
@@ -231,6 +256,46 @@ XGB_DLL int XGDeviceQuantileDMatrixCreateFromCallback(
     xgboost::DMatrix::Create(iter, proxy, reset, next, missing, nthread, max_bin)};
   API_END();
 }
+
+namespace {
+// Drives the data-callback protocol with a single device columnar batch, so
+// one-shot construction shares the on-device sketching and quantization of
+// the iterator path without requiring a caller-side iterator.
+struct SingleColumnarBatchIter {
+  char const* interface_str;
+  xgboost::data::DMatrixProxy* proxy;
+  bool consumed { false };
+
+  static void Reset(DataIterHandle self) {
+    static_cast<SingleColumnarBatchIter*>(self)->consumed = false;
+  }
+  static int Next(DataIterHandle self) {
+    auto* iter = static_cast<SingleColumnarBatchIter*>(self);
+    if (iter->consumed) {
+      return 0;
+    }
+    iter->proxy->SetData(iter->interface_str);
+    iter->consumed = true;
+    return 1;
+  }
+};
+}  // anonymous namespace
+
+XGB_DLL int XGDeviceDMatrixCreateFromColumnar(char const* c_interface_str,
+                                              float missing, int nthread,
+                                              int max_bin, DMatrixHandle* out) {
+  API_BEGIN();
+  // the proxy only lives for the duration of the construction; the built
+  // DMatrix holds the quantized pages itself
+  std::shared_ptr<xgboost::DMatrix> proxy_handle{new xgboost::data::DMatrixProxy};
+  auto* proxy = static_cast<xgboost::data::DMatrixProxy*>(proxy_handle.get());
+  SingleColumnarBatchIter iter{c_interface_str, proxy};
+  *out = new std::shared_ptr<xgboost::DMatrix>{xgboost::DMatrix::Create(
+      static_cast<DataIterHandle>(&iter),
+      static_cast<DMatrixHandle>(&proxy_handle), SingleColumnarBatchIter::Reset,
+      SingleColumnarBatchIter::Next, missing, nthread, max_bin)};
+  API_END();
+}
 // End Create from data iterator
 
 XGB_DLL int XGDMatrixCreateFromCSREx(const size_t* indptr,
@@ -291,6 +356,19 @@ XGB_DLL int XGDMatrixCreateFromDT(void** data, const char** feature_stypes,
   API_END();
 }
 
+XGB_DLL int XGDMatrixCreateFromColumnar(void const** data,
+                                        const char** feature_stypes,
+                                        unsigned char const** validity,
+                                        xgboost::bst_ulong nrow,
+                                        xgboost::bst_ulong ncol,
+                                        DMatrixHandle* out, int nthread) {
+  API_BEGIN();
+  data::ColumnarAdapter adapter(data, feature_stypes, validity, nrow, ncol);
+  *out = new std::shared_ptr<DMatrix>(
+      DMatrix::Create(&adapter, std::nan(""), nthread));
+  API_END();
+}
+
 XGB_DLL int XGDMatrixSliceDMatrix(DMatrixHandle handle,
                                   const int* idxset,
                                   xgboost::bst_ulong len,
@@ -494,6 +572,20 @@ XGB_DLL int XGBoosterSetParam(BoosterHandle handle,
   API_END();
 }
 
+XGB_DLL int XGBoosterSetParamFloat(BoosterHandle handle,
+                                   const char *name,
+                                   float value) {
+  API_BEGIN();
+  CHECK_HANDLE();
+  auto *learner = static_cast<Learner*>(handle);
+  if (!learner->SetParamFloat(name, value)) {
+    std::ostringstream os;
+    os << std::setprecision(std::numeric_limits<float>::max_digits10) << value;
+    learner->SetParam(name, os.str());
+  }
+  API_END();
+}
+
 XGB_DLL int XGBoosterGetNumFeature(BoosterHandle handle,
                                    xgboost::bst_ulong *out) {
   API_BEGIN();
@@ -593,6 +685,22 @@ XGB_DLL int XGBoosterEvalOneIter(BoosterHandle handle,
   API_END();
 }
 
+XGB_DLL int XGBoosterShouldStop(BoosterHandle handle, int* out_should_stop) {
+  API_BEGIN();
+  CHECK_HANDLE();
+  auto* bst = static_cast<Learner*>(handle);
+  *out_should_stop = bst->ShouldStop() ? 1 : 0;
+  API_END();
+}
+
+XGB_DLL int XGBoosterFreezeForPrediction(BoosterHandle handle) {
+  API_BEGIN();
+  CHECK_HANDLE();
+  auto* bst = static_cast<Learner*>(handle);
+  bst->FreezeForPrediction();
+  API_END();
+}
+
 XGB_DLL int XGBoosterPredict(BoosterHandle handle,
                              DMatrixHandle dmat,
                              int option_mask,
@@ -618,6 +726,94 @@ XGB_DLL int XGBoosterPredict(BoosterHandle handle,
   API_END();
 }
 
+// A hidden API for preallocated pipelines: same as XGBoosterPredict, but the
+// result is written into a caller-provided buffer instead of a pointer into
+// the booster's thread local cache, which the next call from the same thread
+// would invalidate.  The caller keeps ownership and alignment of the output
+// memory, so predict and postprocess stages can run over one reused buffer.
+// `out_size` is the capacity of `out_result` in floats and must be at least
+// the prediction length of XGBoosterPredict with the same options.
+XGB_DLL int XGBoosterPredictInto(BoosterHandle handle,
+                                 DMatrixHandle dmat,
+                                 int option_mask,
+                                 unsigned ntree_limit,
+                                 int training,
+                                 xgboost::bst_ulong out_size,
+                                 bst_float *out_result) {
+  API_BEGIN();
+  CHECK_HANDLE();
+  auto *learner = static_cast<Learner*>(handle);
+  auto& entry = learner->GetThreadLocal().prediction_entry;
+  learner->Predict(
+      *static_cast<std::shared_ptr<DMatrix>*>(dmat),
+      (option_mask & 1) != 0,
+      &entry.predictions, ntree_limit,
+      static_cast<bool>(training),
+      (option_mask & 2) != 0,
+      (option_mask & 4) != 0,
+      (option_mask & 8) != 0,
+      (option_mask & 16) != 0);
+  CHECK_GE(out_size, entry.predictions.Size())
+      << "Output buffer is too small for the prediction result.";
+  auto const& h_predt = entry.predictions.ConstHostVector();
+  std::copy_n(h_predt.cbegin(), entry.predictions.Size(), out_result);
+  API_END();
+}
+
+// A hidden API for leaf-embedding pipelines: writes the leaf index of every
+// used tree as int32 directly into a caller-provided buffer, which may be
+// backed by a memory mapped file, instead of materializing a float copy in
+// the booster's thread local cache.  `out_size` is the capacity of
+// `out_result` in int32 entries and must equal num_row * number of used
+// trees.
+XGB_DLL int XGBoosterPredictLeafInto(BoosterHandle handle,
+                                     DMatrixHandle dmat,
+                                     unsigned ntree_limit,
+                                     xgboost::bst_ulong out_size,
+                                     int32_t *out_result) {
+  API_BEGIN();
+  CHECK_HANDLE();
+  auto *learner = static_cast<Learner*>(handle);
+  auto p_m = *static_cast<std::shared_ptr<DMatrix>*>(dmat);
+  common::Span<bst_node_t> out_indices{out_result,
+                                       static_cast<size_t>(out_size)};
+  if (!learner->PredictLeafInt32(p_m, ntree_limit, out_indices)) {
+    // the configured predictor has no direct int32 path; fall back to the
+    // float leaf prediction and narrow
+    HostDeviceVector<bst_float> tmp;
+    learner->Predict(p_m, false, &tmp, ntree_limit, false, true);
+    auto const &h_tmp = tmp.ConstHostVector();
+    CHECK_EQ(static_cast<size_t>(out_size), h_tmp.size())
+        << "Leaf index buffer must hold num_row * number of used trees entries.";
+    std::transform(h_tmp.cbegin(), h_tmp.cend(), out_result,
+                   [](bst_float v) { return static_cast<bst_node_t>(v); });
+  }
+  API_END();
+}
+
+// A hidden API for gradient-boosted feature extraction pipelines: aggregates
+// per-leaf row counts and label/weight sums over the whole matrix in a single
+// traversal, instead of exporting one leaf index per row per tree and
+// aggregating downstream.  The result holds `max_nodes * 3` floats per used
+// tree, {count, label sum, weight sum} per node, where `max_nodes` is the
+// node count of the largest used tree.
+XGB_DLL int XGBoosterPredictLeafStats(BoosterHandle handle,
+                                      DMatrixHandle dmat,
+                                      unsigned ntree_limit,
+                                      xgboost::bst_ulong *out_len,
+                                      const bst_float **out_result) {
+  API_BEGIN();
+  CHECK_HANDLE();
+  auto *learner = static_cast<Learner*>(handle);
+  auto p_m = *static_cast<std::shared_ptr<DMatrix>*>(dmat);
+  std::vector<bst_float>& stats = learner->GetThreadLocal().ret_vec_float;
+  CHECK(learner->PredictLeafStats(p_m, ntree_limit, &stats))
+      << "The configured booster does not support leaf statistics.";
+  *out_len = static_cast<xgboost::bst_ulong>(stats.size());
+  *out_result = dmlc::BeginPtr(stats);
+  API_END();
+}
+
 // A hidden API as cache id is not being supported yet.
 XGB_DLL int XGBoosterPredictFromDense(BoosterHandle handle, float *values,
                                       xgboost::bst_ulong n_rows,
@@ -646,6 +842,72 @@ XGB_DLL int XGBoosterPredictFromDense(BoosterHandle handle, float *values,
   API_END();
 }
 
+// A hidden API for serving: same as XGBoosterPredictFromDense, but the result
+// is written into a caller-provided buffer instead of a pointer into the
+// booster's thread local cache, which the next call from the same thread
+// would invalidate.  `out_size` is the capacity of `out_result` in floats.
+XGB_DLL int XGBoosterPredictFromDenseInto(BoosterHandle handle, float *values,
+                                          xgboost::bst_ulong n_rows,
+                                          xgboost::bst_ulong n_cols,
+                                          float missing,
+                                          unsigned iteration_begin,
+                                          unsigned iteration_end,
+                                          char const* c_type,
+                                          xgboost::bst_ulong out_size,
+                                          float *out_result) {
+  API_BEGIN();
+  CHECK_HANDLE();
+  auto *learner = static_cast<xgboost::Learner *>(handle);
+
+  std::shared_ptr<xgboost::data::DenseAdapter> x{
+    new xgboost::data::DenseAdapter(values, n_rows, n_cols)};
+  HostDeviceVector<float>* p_predt { nullptr };
+  std::string type { c_type };
+  learner->InplacePredict(x, type, missing, &p_predt, iteration_begin, iteration_end);
+  CHECK(p_predt);
+  CHECK_GE(out_size, p_predt->Size())
+      << "Output buffer is too small for the prediction result.";
+
+  auto const& h_predt = p_predt->ConstHostVector();
+  std::copy_n(h_predt.cbegin(), p_predt->Size(), out_result);
+  API_END();
+}
+
+// A hidden API for serving ensembles of boosters over one feature vector:
+// each dense row is staged once and every booster's trees are traversed in a
+// single interleaved pass, instead of one XGBoosterPredict call per booster
+// re-staging the row.  Results are untransformed margins laid out
+// [booster][row] in a caller-provided buffer of capacity `out_size` floats.
+// Only single-output gbtree boosters are supported.
+XGB_DLL int XGBoosterPredictFromDenseMany(BoosterHandle handles[],
+                                          xgboost::bst_ulong n_boosters,
+                                          float *values,
+                                          xgboost::bst_ulong n_rows,
+                                          xgboost::bst_ulong n_cols,
+                                          float missing,
+                                          xgboost::bst_ulong out_size,
+                                          float *out_results) {
+  API_BEGIN();
+  CHECK(handles) << "Booster handles cannot be NULL.";
+  CHECK_GE(n_boosters, 1);
+  CHECK_GE(out_size, n_boosters * n_rows)
+      << "Output buffer is too small for the prediction result.";
+  std::vector<xgboost::gbm::GBTreeModel const *> models;
+  models.reserve(n_boosters);
+  for (xgboost::bst_ulong i = 0; i < n_boosters; ++i) {
+    CHECK(handles[i]) << "Booster handles cannot be NULL.";
+    auto *learner = static_cast<xgboost::Learner *>(handles[i]);
+    learner->Configure();
+    auto const *booster = learner->GetBooster();
+    CHECK(booster && typeid(*booster) == typeid(xgboost::gbm::GBTree))
+        << "Multi-booster scoring supports gbtree boosters only.";
+    models.push_back(&dynamic_cast<xgboost::gbm::GBTree const &>(*booster).Model());
+  }
+  xgboost::predictor::PredictDenseMulti(models, values, n_rows, n_cols,
+                                        missing, out_results);
+  API_END();
+}
+
 // A hidden API as cache id is not being supported yet.
 XGB_DLL int XGBoosterPredictFromCSR(BoosterHandle handle,
                                     const size_t* indptr,
@@ -732,6 +994,9 @@ XGB_DLL int XGBoosterSaveModel(BoosterHandle handle, const char* c_fname) {
   auto *learner = static_cast<Learner *>(handle);
   learner->Configure();
   if (common::FileExtension(c_fname) == "json") {
+    // bump allocate the short lived Json values making up the model document,
+    // released wholesale once the dump is written.
+    JsonArenaScope arena_scope;
     Json out { Object() };
     learner->SaveModel(&out);
     std::string str;
@@ -744,6 +1009,39 @@ XGB_DLL int XGBoosterSaveModel(BoosterHandle handle, const char* c_fname) {
   API_END();
 }
 
+XGB_DLL int XGBoosterCompactForInference(BoosterHandle handle) {
+  API_BEGIN();
+  CHECK_HANDLE();
+  static_cast<Learner*>(handle)->CompactForInference();
+  API_END();
+}
+
+XGB_DLL int XGBoosterSwapModel(BoosterHandle handle,
+                               const void* buf,
+                               xgboost::bst_ulong len) {
+  API_BEGIN();
+  CHECK_HANDLE();
+  common::MemoryFixSizeBuffer fs((void*)buf, len);  // NOLINT(*)
+  static_cast<Learner*>(handle)->SwapModel(&fs);
+  API_END();
+}
+
+XGB_DLL int XGBoosterSaveModelAsync(BoosterHandle handle, const char* c_fname) {
+  API_BEGIN();
+  CHECK_HANDLE();
+  CHECK_NE(common::FileExtension(c_fname), "json")
+      << "Asynchronous save only supports the binary model format.";
+  static_cast<Learner*>(handle)->SaveModelAsync(c_fname);
+  API_END();
+}
+
+XGB_DLL int XGBoosterWaitForModelSave(BoosterHandle handle) {
+  API_BEGIN();
+  CHECK_HANDLE();
+  static_cast<Learner*>(handle)->WaitForModelSave();
+  API_END();
+}
+
 XGB_DLL int XGBoosterLoadModelFromBuffer(BoosterHandle handle,
                                          const void* buf,
                                          xgboost::bst_ulong len) {
@@ -825,6 +1123,21 @@ XGB_DLL int XGBoosterSaveRabitCheckpoint(BoosterHandle handle) {
   API_END();
 }
 
+XGB_DLL int XGBoosterSaveCheckpoint(BoosterHandle handle, const char* fname) {
+  API_BEGIN();
+  CHECK_HANDLE();
+  static_cast<Learner*>(handle)->SaveCheckpointAsync(fname);
+  API_END();
+}
+
+XGB_DLL int XGBoosterLoadCheckpoint(BoosterHandle handle, const char* fname,
+                                    int* version) {
+  API_BEGIN();
+  CHECK_HANDLE();
+  *version = static_cast<Learner*>(handle)->LoadCheckpoint(fname);
+  API_END();
+}
+
 XGB_DLL int XGBoosterSlice(BoosterHandle handle, int begin_layer,
                            int end_layer, int step,
                            BoosterHandle *out) {
@@ -916,6 +1229,26 @@ XGB_DLL int XGBoosterDumpModelExWithFeatures(BoosterHandle handle,
   API_END();
 }
 
+XGB_DLL int XGBoosterFeatureImportance(BoosterHandle handle,
+                                       const char* importance_type,
+                                       xgboost::bst_ulong* out_n_features,
+                                       const bst_float** out_scores) {
+  API_BEGIN();
+  CHECK_HANDLE();
+  auto* learner = static_cast<Learner*>(handle);
+  learner->Configure();
+  auto const* booster = learner->GetBooster();
+  CHECK(booster && typeid(*booster) == typeid(xgboost::gbm::GBTree))
+      << "Feature importance supports gbtree boosters only.";
+  auto const& model =
+      dynamic_cast<xgboost::gbm::GBTree const&>(*booster).Model();
+  std::vector<bst_float>& scores = learner->GetThreadLocal().ret_vec_float;
+  model.FeatureImportance(importance_type, &scores);
+  *out_n_features = static_cast<xgboost::bst_ulong>(scores.size());
+  *out_scores = dmlc::BeginPtr(scores);
+  API_END();
+}
+
 XGB_DLL int XGBoosterGetAttr(BoosterHandle handle,
                      const char* key,
                      const char** out,
@@ -15,8 +15,15 @@
 #include <xgboost/logging.h>
 #include <xgboost/parameter.h>
 
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cmath>
 #include <iomanip>
 #include <ctime>
+#include <future>
+#include <numeric>
+#include <random>
 #include <string>
 #include <cstdio>
 #include <cstring>
@@ -25,12 +32,14 @@
 #include "common/config.h"
 #include "common/io.h"
 #include "common/version.h"
+#include "data/simple_dmatrix.h"
 
 namespace xgboost {
 enum CLITask {
   kTrain = 0,
   kDumpModel = 1,
-  kPredict = 2
+  kPredict = 2,
+  kCV = 3
 };
 
 struct CLIParam : public XGBoostParameter<CLIParam> {
@@ -40,6 +49,10 @@ struct CLIParam : public XGBoostParameter<CLIParam> {
   bool eval_train;
   /*! \brief number of boosting iterations */
   int num_round;
+  /*! \brief number of folds for the cv task */
+  int nfold;
+  /*! \brief random seed of the fold assignment for the cv task */
+  int cv_seed;
   /*! \brief the period to save the model, 0 means only save the final round model */
   int save_period;
   /*! \brief the path of training set */
@@ -56,6 +69,8 @@ struct CLIParam : public XGBoostParameter<CLIParam> {
   std::string name_pred;
   /*! \brief data split mode */
   int dsplit;
+  /*! \brief whether to keep and reuse binary caches of text data sources */
+  bool use_binary_cache;
   /*!\brief limit number of trees in prediction */
   int ntree_limit;
   /*!\brief whether to directly output margin value */
@@ -84,11 +99,16 @@ struct CLIParam : public XGBoostParameter<CLIParam> {
         .add_enum("train", kTrain)
         .add_enum("dump", kDumpModel)
         .add_enum("pred", kPredict)
+        .add_enum("cv", kCV)
         .describe("Task to be performed by the CLI program.");
     DMLC_DECLARE_FIELD(eval_train).set_default(false)
         .describe("Whether evaluate on training data during training.");
     DMLC_DECLARE_FIELD(num_round).set_default(10).set_lower_bound(1)
         .describe("Number of boosting iterations");
+    DMLC_DECLARE_FIELD(nfold).set_default(5).set_lower_bound(2)
+        .describe("Number of folds for the cv task.");
+    DMLC_DECLARE_FIELD(cv_seed).set_default(0)
+        .describe("Random seed of the fold assignment for the cv task.");
     DMLC_DECLARE_FIELD(save_period).set_default(0).set_lower_bound(0)
         .describe("The period to save the model, 0 means only save final model.");
     DMLC_DECLARE_FIELD(train_path).set_default("NULL")
@@ -108,6 +128,10 @@ struct CLIParam : public XGBoostParameter<CLIParam> {
         .add_enum("col", 1)
         .add_enum("row", 2)
         .describe("Data split mode.");
+    DMLC_DECLARE_FIELD(use_binary_cache).set_default(false)
+        .describe("Cache matrices parsed from text sources as binary files "
+                  "(<path>.buffer) and load an up-to-date cache directly on "
+                  "later runs, skipping the text parse.");
     DMLC_DECLARE_FIELD(ntree_limit).set_default(0).set_lower_bound(0)
         .describe("Number of trees used for prediction, 0 means use all trees.");
     DMLC_DECLARE_FIELD(pred_margin).set_default(false)
@@ -169,12 +193,62 @@ void CLIError(dmlc::Error const& e) {
 class CLI {
   CLIParam param_;
   std::unique_ptr<Learner> learner_;
+  // model bytes read ahead of time, see CLITrain and LoadModel
+  std::future<std::string> preread_model_;
   enum Print {
     kNone,
     kVersion,
     kHelp
   } print_info_ {kNone};
 
+  /*!
+   * \brief Load one data source, optionally through a binary cache.
+   *
+   *  With use_binary_cache a matrix parsed from text is saved next to its
+   *  source as <path>.buffer; later runs load an up-to-date cache directly,
+   *  which repeated short jobs over the same data benefit from the most.
+   */
+  std::shared_ptr<DMatrix> LoadDMatrix(std::string const& path) const {
+    const bool verbose =
+        ConsoleLogger::GlobalVerbosity() > ConsoleLogger::DefaultVerbosity();
+    const bool load_row_split = param_.dsplit == 2;
+    // only plain local files can be cached; URIs with protocols, query
+    // parameters or external memory specs go through the regular loader
+    if (!param_.use_binary_cache || load_row_split ||
+        path.find('#') != std::string::npos ||
+        path.find('?') != std::string::npos ||
+        path.find("://") != std::string::npos) {
+      return std::shared_ptr<DMatrix>(
+          DMatrix::Load(path, verbose, load_row_split));
+    }
+    const std::string cache_path = path + ".buffer";
+    struct stat cache_stat, src_stat;
+    if (::stat(cache_path.c_str(), &cache_stat) == 0) {
+      if (::stat(path.c_str(), &src_stat) == 0 &&
+          cache_stat.st_mtime >= src_stat.st_mtime) {
+#if defined(__unix__)
+        // serve the cache straight out of the kernel page cache; repeated
+        // jobs over the same data skip the text parse and the read syscalls
+        common::MemoryMappedStream fs(cache_path);
+        return std::shared_ptr<DMatrix>(new data::SimpleDMatrix(&fs));
+#else
+        return std::shared_ptr<DMatrix>(
+            DMatrix::Load(cache_path, verbose, load_row_split));
+#endif  // defined(__unix__)
+      }
+      LOG(WARNING) << "Binary cache " << cache_path << " is older than "
+                   << path << ", rebuilding it";
+    }
+    std::shared_ptr<DMatrix> dmat(
+        DMatrix::Load(path, verbose, load_row_split));
+    auto* simple = dynamic_cast<data::SimpleDMatrix*>(dmat.get());
+    if (simple != nullptr) {
+      simple->SaveToLocalFile(cache_path);
+      LOG(INFO) << "Cached " << path << " as " << cache_path;
+    }
+    return dmat;
+  }
+
   int ResetLearner(std::vector<std::shared_ptr<DMatrix>> const &matrices) {
     learner_.reset(Learner::Create(matrices));
     int version = rabit::LoadCheckPoint(learner_.get());
@@ -196,20 +270,21 @@ class CLI {
       std::string pname = rabit::GetProcessorName();
       LOG(CONSOLE) << "start " << pname << ":" << rabit::GetRank();
     }
+    // read the input model concurrently with the data load; both have to
+    // finish before the learner is configured, so neither waits on the other
+    if (param_.model_in != CLIParam::kNull) {
+      preread_model_ = std::async(std::launch::async, [this] {
+        return common::LoadSequentialFile(param_.model_in);
+      });
+    }
     // load in data.
-    std::shared_ptr<DMatrix> dtrain(DMatrix::Load(
-        param_.train_path,
-        ConsoleLogger::GlobalVerbosity() > ConsoleLogger::DefaultVerbosity(),
-        param_.dsplit == 2));
+    std::shared_ptr<DMatrix> dtrain = this->LoadDMatrix(param_.train_path);
     std::vector<std::shared_ptr<DMatrix>> deval;
     std::vector<std::shared_ptr<DMatrix>> cache_mats;
     std::vector<std::shared_ptr<DMatrix>> eval_datasets;
     cache_mats.push_back(dtrain);
     for (size_t i = 0; i < param_.eval_data_names.size(); ++i) {
-      deval.emplace_back(std::shared_ptr<DMatrix>(DMatrix::Load(
-          param_.eval_data_paths[i],
-          ConsoleLogger::GlobalVerbosity() > ConsoleLogger::DefaultVerbosity(),
-          param_.dsplit == 2)));
+      deval.emplace_back(this->LoadDMatrix(param_.eval_data_paths[i]));
       eval_datasets.push_back(deval.back());
       cache_mats.push_back(deval.back());
     }
@@ -283,6 +358,131 @@ class CLI {
     LOG(INFO) << "update end, " << elapsed << " sec in all";
   }
 
+  // "[0]\ttest-rmse:1.6812\t..." -> {("test-rmse", 1.6812), ...}
+  static std::vector<std::pair<std::string, float>> ParseEvalResult(
+      std::string const& res) {
+    std::vector<std::pair<std::string, float>> out;
+    auto tokens = common::Split(res, '\t');
+    for (size_t i = 1; i < tokens.size(); ++i) {
+      auto pos = tokens[i].rfind(':');
+      CHECK_NE(pos, std::string::npos) << "Malformed evaluation result: " << res;
+      out.emplace_back(tokens[i].substr(0, pos),
+                       std::stof(tokens[i].substr(pos + 1)));
+    }
+    return out;
+  }
+
+  void CLICrossValidation() {
+    CHECK(!rabit::IsDistributed())
+        << "The cv task is not supported in distributed training.";
+    const double tstart_data_load = dmlc::GetTime();
+    std::shared_ptr<DMatrix> dall(DMatrix::Load(
+        param_.train_path,
+        ConsoleLogger::GlobalVerbosity() > ConsoleLogger::DefaultVerbosity(),
+        false));
+    auto const n_rows = static_cast<size_t>(dall->Info().num_row_);
+    auto const nfold = static_cast<size_t>(param_.nfold);
+    CHECK_GE(n_rows, nfold) << "Cannot have more folds than rows.";
+
+    // Shuffled fold assignment.
+    std::vector<int32_t> row_order(n_rows);
+    std::iota(row_order.begin(), row_order.end(), 0);
+    std::shuffle(row_order.begin(), row_order.end(),
+                 std::mt19937(param_.cv_seed));
+    std::vector<size_t> fold_of_row(n_rows);
+    for (size_t i = 0; i < n_rows; ++i) {
+      fold_of_row[row_order[i]] = i % nfold;
+    }
+
+    // Every fold trains on the full matrix with the weights of its held-out
+    // rows set to zero: zero-weight rows contribute no gradient or hessian,
+    // so splits and leaf values see only the training part, while the data is
+    // loaded and quantized once for all folds instead of once per fold.
+    std::vector<float> const base_weights = dall->Info().weights_.HostVector();
+    std::vector<std::vector<float>> fold_weights(nfold);
+    for (size_t f = 0; f < nfold; ++f) {
+      fold_weights[f].resize(n_rows);
+      for (size_t i = 0; i < n_rows; ++i) {
+        float w = base_weights.empty() ? 1.0f : base_weights[i];
+        fold_weights[f][i] = fold_of_row[i] == f ? 0.0f : w;
+      }
+    }
+
+    // Held-out slices used for evaluation.
+    std::vector<std::shared_ptr<DMatrix>> dtest(nfold);
+    for (size_t f = 0; f < nfold; ++f) {
+      std::vector<int32_t> rows;
+      for (size_t i = 0; i < n_rows; ++i) {
+        if (fold_of_row[i] == f) {
+          rows.push_back(i);
+        }
+      }
+      dtest[f].reset(dall->Slice({rows.data(), rows.size()}));
+    }
+
+    // The folds boost over one shared matrix, so hist boosters can also
+    // share its quantized index instead of building one per fold.
+    std::vector<std::pair<std::string, std::string>> cfg = param_.cfg;
+    for (auto const& kv : param_.cfg) {
+      if (kv.first == "tree_method" && kv.second == "hist") {
+        cfg.emplace_back("shared_quantized_index", "1");
+      }
+    }
+
+    std::vector<std::unique_ptr<Learner>> learners(nfold);
+    for (size_t f = 0; f < nfold; ++f) {
+      learners[f].reset(Learner::Create({dall, dtest[f]}));
+      learners[f]->SetParams(cfg);
+      learners[f]->Configure();
+    }
+    LOG(INFO) << "Loading data: " << dmlc::GetTime() - tstart_data_load
+              << " sec";
+
+    const double start = dmlc::GetTime();
+    for (int i = 0; i < param_.num_round; ++i) {
+      std::vector<std::string> names;
+      std::vector<std::vector<float>> values;
+      for (size_t f = 0; f < nfold; ++f) {
+        dall->Info().weights_.HostVector() = fold_weights[f];
+        learners[f]->UpdateOneIter(i, dall);
+        std::vector<std::shared_ptr<DMatrix>> eval_sets{dtest[f]};
+        std::vector<std::string> eval_names{"test"};
+        if (param_.eval_train) {
+          // weighted metrics skip the zero-weight held-out rows
+          eval_sets.push_back(dall);
+          eval_names.emplace_back("train");
+        }
+        auto metrics =
+            ParseEvalResult(learners[f]->EvalOneIter(i, eval_sets, eval_names));
+        if (f == 0) {
+          values.resize(metrics.size());
+          for (auto const& kv : metrics) {
+            names.push_back(kv.first);
+          }
+        }
+        CHECK_EQ(metrics.size(), names.size());
+        for (size_t m = 0; m < metrics.size(); ++m) {
+          values[m].push_back(metrics[m].second);
+        }
+      }
+      std::ostringstream os;
+      os << '[' << i << ']' << std::setprecision(6);
+      for (size_t m = 0; m < names.size(); ++m) {
+        double mean =
+            std::accumulate(values[m].cbegin(), values[m].cend(), 0.0) / nfold;
+        double var = 0;
+        for (auto v : values[m]) {
+          var += (v - mean) * (v - mean);
+        }
+        os << "\tcv-" << names[m] << ':' << mean << '+' << std::sqrt(var / nfold);
+      }
+      LOG(CONSOLE) << os.str();
+    }
+    dall->Info().weights_.HostVector() = base_weights;
+    LOG(INFO) << "Complete cross-validation loop time: "
+              << dmlc::GetTime() - start << " sec";
+  }
+
   void CLIDumpModel() {
     FeatureMap fmap;
     if (param_.name_fmap != CLIParam::kNull) {
@@ -324,10 +524,7 @@ class CLI {
     CHECK_NE(param_.test_path, CLIParam::kNull)
         << "Test dataset parameter test:data must be specified.";
     // load data
-    std::shared_ptr<DMatrix> dtest(DMatrix::Load(
-        param_.test_path,
-        ConsoleLogger::GlobalVerbosity() > ConsoleLogger::DefaultVerbosity(),
-        param_.dsplit == 2));
+    std::shared_ptr<DMatrix> dtest = this->LoadDMatrix(param_.test_path);
     // load model
     CHECK_NE(param_.model_in, CLIParam::kNull) << "Must specify model_in for predict";
     this->ResetLearner({});
@@ -348,13 +545,24 @@ class CLI {
     os.set_stream(nullptr);
   }
 
-  void LoadModel(std::string const& path, Learner* learner) const {
+  void LoadModel(std::string const& path, Learner* learner) {
+    // pick up the bytes CLITrain read concurrently with the data load
+    std::string str;
+    const bool preread = preread_model_.valid();
+    if (preread) {
+      str = preread_model_.get();
+    }
     if (common::FileExtension(path) == "json") {
-      auto str = common::LoadSequentialFile(path);
+      if (!preread) {
+        str = common::LoadSequentialFile(path);
+      }
       CHECK_GT(str.size(), 2);
       CHECK_EQ(str[0], '{');
       Json in{Json::Load({str.c_str(), str.size()})};
       learner->LoadModel(in);
+    } else if (preread) {
+      common::MemoryFixSizeBuffer fi(&str[0], str.size());
+      learner->LoadModel(&fi);
     } else {
       std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(path.c_str(), "r"));
       learner->LoadModel(fi.get());
@@ -499,6 +707,9 @@ class CLI {
       case kPredict:
         CLIPredict();
         break;
+      case kCV:
+        CLICrossValidation();
+        break;
       }
     } catch (dmlc::Error const& e) {
       xgboost::CLIError(e);
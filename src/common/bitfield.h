@@ -222,6 +222,7 @@ struct RBitsPolicy : public BitFieldContainer<VT, RBitsPolicy<VT>> {
 // Format: <Const><Direction>BitField<size of underlying type in bits>, underlying type
 // must be unsigned.
 using LBitField64 = BitFieldContainer<uint64_t, LBitsPolicy<uint64_t>>;
+using CLBitField64 = BitFieldContainer<uint64_t, LBitsPolicy<uint64_t, true>, true>;
 using RBitField8 = BitFieldContainer<uint8_t, RBitsPolicy<unsigned char>>;
 
 using LBitField32 = BitFieldContainer<uint32_t, LBitsPolicy<uint32_t>>;
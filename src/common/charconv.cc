@@ -26,6 +26,8 @@
  * is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
  * KIND, either express or implied.
  */
+#include <dmlc/endian.h>
+
 #include <algorithm>
 #include <cassert>
 #include <cinttypes>
@@ -737,6 +739,44 @@ to_chars_result ToCharsUnsignedImpl(char *first, char *last,
   return ret;
 }
 
+namespace {
+/*
+ * Parse 8 consecutive ASCII digits in one go by loading them as a single
+ * 64-bit word and reducing with 3 multiplications (SWAR), instead of 8
+ * dependent iterations.  Returns false when any of the 8 bytes is not a
+ * digit.  The reduction assumes the digit order of a little endian load,
+ * big endian platforms take the scalar loop instead.
+ */
+inline bool ParseEightDigits(const char *p, uint32_t *out) {
+#if DMLC_LITTLE_ENDIAN
+  uint64_t w;
+  std::memcpy(&w, p, sizeof(w));
+  if (((w & 0xF0F0F0F0F0F0F0F0ULL) |
+       (((w + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) !=
+      0x3333333333333333ULL) {
+    return false;
+  }
+  w = (w & 0x0F0F0F0F0F0F0F0FULL) * 2561 >> 8;
+  w = (w & 0x00FF00FF00FF00FFULL) * 6553601 >> 16;
+  *out = static_cast<uint32_t>((w & 0x0000FFFF0000FFFFULL) * 42949672960001ULL >> 32);
+  return true;
+#else
+  (void)p;
+  (void)out;
+  return false;
+#endif  // DMLC_LITTLE_ENDIAN
+}
+
+inline int32_t DecimalDigits(uint32_t v) {
+  int32_t n = 0;
+  while (v != 0) {
+    v /= 10;
+    n++;
+  }
+  return n;
+}
+}  // anonymous namespace
+
 /*
  * The parsing is also part of ryu.  As of writing, the implementation in ryu uses full
  * double table.  But here we optimize the table size with float table instead.  The
@@ -761,6 +801,17 @@ from_chars_result FromCharFloatImpl(const char *buffer, const int len,
     i++;
   }
   for (; i < len; i++) {
+    // Batch the leading run of significant digits, which covers 8 of the up
+    // to 9 digits a ryu generated mantissa has.
+    if (mantissa_b10 == 0 && i + 8 <= len) {
+      uint32_t chunk;
+      if (ParseEightDigits(buffer + i, &chunk)) {
+        mantissa_b10 = chunk;
+        m10digits = DecimalDigits(chunk);
+        i += 7;  // the loop increment consumes the 8th digit
+        continue;
+      }
+    }
     char c = buffer[i];
     if (c == '.') {
       if (dot_ind != len) {
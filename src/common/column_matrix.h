@@ -8,6 +8,7 @@
 #ifndef XGBOOST_COMMON_COLUMN_MATRIX_H_
 #define XGBOOST_COMMON_COLUMN_MATRIX_H_
 
+#include <algorithm>
 #include <limits>
 #include <vector>
 #include <memory>
@@ -84,15 +85,17 @@ template <typename BinIdxType>
 class DenseColumn: public Column<BinIdxType> {
  public:
   DenseColumn(ColumnType type, common::Span<const BinIdxType> index,
-              uint32_t index_base, const std::vector<bool>& missing_flags,
+              uint32_t index_base, const std::vector<uint8_t>& missing_flags,
               size_t feature_offset)
       : Column<BinIdxType>(type, index, index_base),
         missing_flags_(missing_flags),
         feature_offset_(feature_offset) {}
-  bool IsMissing(size_t idx) const { return missing_flags_[feature_offset_ + idx]; }
+  bool IsMissing(size_t idx) const { return missing_flags_[feature_offset_ + idx] != 0; }
  private:
-  /* flags for missing values in dense columns */
-  const std::vector<bool>& missing_flags_;
+  /* flags for missing values in dense columns; one byte per entry so rows
+     can set their flags concurrently during construction and the partition
+     kernels probe them without bit arithmetic */
+  const std::vector<uint8_t>& missing_flags_;
   size_t feature_offset_;
 };
 
@@ -109,7 +112,7 @@ class ColumnMatrix {
   inline void Init(const GHistIndexMatrix& gmat,
                    double  sparse_threshold) {
     const int32_t nfeature = static_cast<int32_t>(gmat.cut.Ptrs().size() - 1);
-    const size_t nrow = gmat.row_ptr.size() - 1;
+    const size_t nrow = gmat.Size();
     // identify type of each column
     feature_counts_.resize(nfeature);
     type_.resize(nfeature);
@@ -155,13 +158,13 @@ class ColumnMatrix {
     // store least bin id for each feature
     index_base_ = const_cast<uint32_t*>(gmat.cut.Ptrs().data());
 
-    const bool noMissingValues = NoMissingValues(gmat.row_ptr[nrow], nrow, nfeature);
+    const bool noMissingValues = NoMissingValues(gmat.RowBegin(nrow), nrow, nfeature);
     any_missing_ = !noMissingValues;
 
     if (noMissingValues) {
-      missing_flags_.resize(feature_offsets_[nfeature], false);
+      missing_flags_.assign(feature_offsets_[nfeature], 0);
     } else {
-      missing_flags_.resize(feature_offsets_[nfeature], true);
+      missing_flags_.assign(feature_offsets_[nfeature], 1);
     }
 
     // pre-fill index_ for dense columns
@@ -241,29 +244,30 @@ class ColumnMatrix {
         }
       }
     } else {
-      /* to handle rows in all batches, sum of all batch sizes equal to gmat.row_ptr.size() - 1 */
+      /* to handle rows in all batches, sum of all batch sizes equal to gmat.Size() */
+      const int32_t nthread = omp_get_max_threads();
       size_t rbegin = 0;
       for (const auto &batch : gmat.p_fmat->GetBatches<SparsePage>()) {
         const xgboost::Entry* data_ptr = batch.data.HostVector().data();
         const std::vector<bst_row_t>& offset_vec = batch.offset.HostVector();
         const size_t batch_size = batch.Size();
         CHECK_LT(batch_size, offset_vec.size());
-        for (size_t rid = 0; rid < batch_size; ++rid) {
+        /* every row owns its slot of each touched column and the flags are
+           one byte wide, so the rows of a batch fill independently */
+        ParallelFor(batch_size, nthread, [&](size_t rid) {
           const size_t size = offset_vec[rid + 1] - offset_vec[rid];
           SparsePage::Inst inst = {data_ptr + offset_vec[rid], size};
-          const size_t ibegin = gmat.row_ptr[rbegin + rid];
-          const size_t iend = gmat.row_ptr[rbegin + rid + 1];
+          const size_t ibegin = gmat.RowBegin(rbegin + rid);
+          const size_t iend = gmat.RowEnd(rbegin + rid);
           CHECK_EQ(ibegin + inst.size(), iend);
           size_t j = 0;
-          size_t fid = 0;
           for (size_t i = ibegin; i < iend; ++i, ++j) {
-              fid = inst[j].index;
-              const size_t idx = feature_offsets_[fid];
+              const size_t idx = feature_offsets_[inst[j].index];
               /* rbegin allows to store indexes from specific SparsePage batch */
               local_index[idx + rbegin + rid] = index[i];
-              missing_flags_[idx + rbegin + rid] = false;
+              missing_flags_[idx + rbegin + rid] = 0;
           }
-        }
+        });
         rbegin += batch.Size();
       }
     }
@@ -272,42 +276,81 @@ class ColumnMatrix {
   template<typename T>
   inline void SetIndex(uint32_t* index, const GHistIndexMatrix& gmat,
                        const size_t nfeature) {
-    std::vector<size_t> num_nonzeros;
-    num_nonzeros.resize(nfeature);
-    std::fill(num_nonzeros.begin(), num_nonzeros.end(), 0);
+    /* running number of stored entries per sparse column, carried across
+       batches so row indices stay ascending within every column */
+    std::vector<size_t> num_nonzeros(nfeature, 0);
 
     T* local_index = reinterpret_cast<T*>(&index_[0]);
+    const int32_t nthread = omp_get_max_threads();
     size_t rbegin = 0;
     for (const auto &batch : gmat.p_fmat->GetBatches<SparsePage>()) {
       const xgboost::Entry* data_ptr = batch.data.HostVector().data();
       const std::vector<bst_row_t>& offset_vec = batch.offset.HostVector();
       const size_t batch_size = batch.Size();
       CHECK_LT(batch_size, offset_vec.size());
-      for (size_t rid = 0; rid < batch_size; ++rid) {
-        const size_t ibegin = gmat.row_ptr[rbegin + rid];
-        const size_t iend = gmat.row_ptr[rbegin + rid + 1];
-        size_t fid = 0;
-        const size_t size = offset_vec[rid + 1] - offset_vec[rid];
-        SparsePage::Inst inst = {data_ptr + offset_vec[rid], size};
-
-        CHECK_EQ(ibegin + inst.size(), iend);
-        size_t j = 0;
-        for (size_t i = ibegin; i < iend; ++i, ++j) {
-          const uint32_t bin_id = index[i];
 
-          fid = inst[j].index;
-          if (type_[fid] == kDenseColumn) {
-            T* begin = &local_index[feature_offsets_[fid]];
-            begin[rid + rbegin] = bin_id - index_base_[fid];
-            missing_flags_[feature_offsets_[fid] + rid + rbegin] = false;
-          } else {
-            T* begin = &local_index[feature_offsets_[fid]];
-            begin[num_nonzeros[fid]] = bin_id - index_base_[fid];
-            row_ind_[feature_offsets_[fid] + num_nonzeros[fid]] = rid + rbegin;
-            ++num_nonzeros[fid];
+      /* Dense columns are addressed by row and fill lock-free, but sparse
+         columns append in row order.  The batch is cut into row blocks: a
+         counting pass gives every block its starting cursor in each sparse
+         column, which turns the append into a stable parallel scatter with
+         the same output as the sequential scan. */
+      const size_t n_blocks =
+          std::max<size_t>(1, std::min<size_t>(nthread, batch_size));
+      const size_t block_size = (batch_size + n_blocks - 1) / n_blocks;
+      std::vector<size_t> block_cursors(n_blocks * nfeature, 0);
+      ParallelFor(n_blocks, nthread, [&](size_t block) {
+        const size_t rid_begin = block * block_size;
+        const size_t rid_end = std::min(batch_size, rid_begin + block_size);
+        size_t* counts = block_cursors.data() + block * nfeature;
+        for (size_t rid = rid_begin; rid < rid_end; ++rid) {
+          const size_t size = offset_vec[rid + 1] - offset_vec[rid];
+          SparsePage::Inst inst = {data_ptr + offset_vec[rid], size};
+          for (size_t j = 0; j < inst.size(); ++j) {
+            const size_t fid = inst[j].index;
+            if (type_[fid] == kSparseColumn) {
+              ++counts[fid];
+            }
           }
         }
+      });
+      /* exclusive scan over the blocks turns the counts into cursors */
+      for (size_t fid = 0; fid < nfeature; ++fid) {
+        size_t cursor = num_nonzeros[fid];
+        for (size_t block = 0; block < n_blocks; ++block) {
+          const size_t count = block_cursors[block * nfeature + fid];
+          block_cursors[block * nfeature + fid] = cursor;
+          cursor += count;
+        }
+        num_nonzeros[fid] = cursor;
       }
+      ParallelFor(n_blocks, nthread, [&](size_t block) {
+        const size_t rid_begin = block * block_size;
+        const size_t rid_end = std::min(batch_size, rid_begin + block_size);
+        size_t* cursors = block_cursors.data() + block * nfeature;
+        for (size_t rid = rid_begin; rid < rid_end; ++rid) {
+          const size_t ibegin = gmat.RowBegin(rbegin + rid);
+          const size_t iend = gmat.RowEnd(rbegin + rid);
+          const size_t size = offset_vec[rid + 1] - offset_vec[rid];
+          SparsePage::Inst inst = {data_ptr + offset_vec[rid], size};
+
+          CHECK_EQ(ibegin + inst.size(), iend);
+          size_t j = 0;
+          for (size_t i = ibegin; i < iend; ++i, ++j) {
+            const uint32_t bin_id = index[i];
+
+            const size_t fid = inst[j].index;
+            T* begin = &local_index[feature_offsets_[fid]];
+            if (type_[fid] == kDenseColumn) {
+              begin[rid + rbegin] = bin_id - index_base_[fid];
+              missing_flags_[feature_offsets_[fid] + rid + rbegin] = 0;
+            } else {
+              begin[cursors[fid]] = bin_id - index_base_[fid];
+              row_ind_[feature_offsets_[fid] + cursors[fid]] = rid + rbegin;
+              ++cursors[fid];
+            }
+          }
+        }
+      });
       rbegin += batch.Size();
     }
   }
@@ -337,7 +380,10 @@ class ColumnMatrix {
 
   // index_base_[fid]: least bin id for feature fid
   uint32_t* index_base_;
-  std::vector<bool> missing_flags_;
+  /* one byte per entry instead of packed bits: concurrent rows can set their
+     flags without sharing words, and the partition kernels read them with a
+     plain load */
+  std::vector<uint8_t> missing_flags_;
   BinTypeSize bins_type_size_;
   bool any_missing_;
 };
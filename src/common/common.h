@@ -6,10 +6,12 @@
 #ifndef XGBOOST_COMMON_COMMON_H_
 #define XGBOOST_COMMON_COMMON_H_
 
+#include <dmlc/parameter.h>
 #include <xgboost/base.h>
 #include <xgboost/logging.h>
 
 #include <algorithm>
+#include <cstdint>
 #include <exception>
 #include <functional>
 #include <limits>
@@ -19,6 +21,11 @@
 #include <sstream>
 #include <numeric>
 
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif  // defined(__linux__)
+
 #if defined(__CUDACC__)
 #include <thrust/system/cuda/error.h>
 #include <thrust/system_error.h>
@@ -72,6 +79,39 @@ XGBOOST_DEVICE T Max(T a, T b) {
   return a < b ? b : a;
 }
 
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+/*!
+ * \brief Ask the kernel to back an allocation with transparent huge pages so
+ *  far fewer TLB entries cover a large streamed buffer.  Best effort: the
+ *  advice is trimmed to whole pages and silently ignored where unsupported.
+ */
+inline void MadviseHugePages(void* ptr, size_t n_bytes) {
+  const auto page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  auto begin = (reinterpret_cast<uintptr_t>(ptr) + page - 1) & ~(page - 1);
+  auto end = (reinterpret_cast<uintptr_t>(ptr) + n_bytes) & ~(page - 1);
+  if (end > begin) {
+    madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE);
+  }
+}
+#else
+inline void MadviseHugePages(void*, size_t) {}
+#endif  // defined(__linux__) && defined(MADV_HUGEPAGE)
+
+/*!
+ * \brief Capacity to allocate when a buffer must grow to hold \p requested
+ *  elements: at least the current capacity times the multiplier from
+ *  XGBOOST_VECTOR_GROWTH_FACTOR (default 2), so repeated appends from a
+ *  stream of unknown total size reallocate O(log n) times instead of once
+ *  per batch.
+ */
+inline size_t GrowCapacity(size_t current, size_t requested) {
+  static double const factor = []() {
+    double f = dmlc::GetEnv("XGBOOST_VECTOR_GROWTH_FACTOR", 2.0);
+    return f < 1.0 ? 1.0 : f;
+  }();
+  return std::max(requested, static_cast<size_t>(current * factor));
+}
+
 // simple routine to convert any data to string
 template<typename T>
 inline std::string ToString(const T& data) {
@@ -23,9 +23,11 @@
 
 #include <algorithm>
 #include <chrono>
+#include <map>
 #include <numeric>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 #include <tuple>
 
@@ -287,20 +289,39 @@ inline void LaunchN(int device_idx, size_t n, L lambda) {
 }
 
 namespace detail {
+/*! \brief The subsystem label attributed to allocations made on this thread;
+ *  set through dh::MemoryScope. */
+inline const char *&CurrentMemoryScope() {
+  static thread_local const char *scope = nullptr;
+  return scope;
+}
+
 /** \brief Keeps track of global device memory allocations. Thread safe.*/
 class MemoryLogger {
+  struct SubsystemStats {
+    size_t currently_allocated_bytes{ 0 };
+    size_t peak_allocated_bytes{ 0 };
+  };
   // Information for a single device
   struct DeviceStats {
     size_t currently_allocated_bytes{ 0 };
     size_t peak_allocated_bytes{ 0 };
     size_t num_allocations{ 0 };
     size_t num_deallocations{ 0 };
-    std::map<void *, size_t> device_allocations;
+    std::map<void *, std::pair<size_t, std::string>> device_allocations;
+    std::map<std::string, SubsystemStats> subsystems;
     void RegisterAllocation(void *ptr, size_t n) {
-      device_allocations[ptr] = n;
+      const char *scope = CurrentMemoryScope();
+      std::string label = scope == nullptr ? "unscoped" : scope;
+      device_allocations[ptr] = {n, label};
       currently_allocated_bytes += n;
       peak_allocated_bytes =
         std::max(peak_allocated_bytes, currently_allocated_bytes);
+      auto& subsystem = subsystems[label];
+      subsystem.currently_allocated_bytes += n;
+      subsystem.peak_allocated_bytes =
+        std::max(subsystem.peak_allocated_bytes,
+                 subsystem.currently_allocated_bytes);
       num_allocations++;
       CHECK_GT(num_allocations, num_deallocations);
     }
@@ -312,7 +333,9 @@ class MemoryLogger {
       }
       num_deallocations++;
       CHECK_LE(num_deallocations, num_allocations);
-      currently_allocated_bytes -= itr->second;
+      currently_allocated_bytes -= itr->second.first;
+      subsystems[itr->second.second].currently_allocated_bytes -=
+          itr->second.first;
       device_allocations.erase(itr);
     }
   };
@@ -344,6 +367,18 @@ public:
   size_t CurrentlyAllocatedBytes() const {
     return stats_.currently_allocated_bytes;
   }
+  /*! \brief Peak bytes attributed to one subsystem (see dh::MemoryScope). */
+  size_t PeakMemory(std::string const& subsystem) const {
+    auto itr = stats_.subsystems.find(subsystem);
+    return itr == stats_.subsystems.end() ? 0 : itr->second.peak_allocated_bytes;
+  }
+  /*! \brief Live bytes attributed to one subsystem (see dh::MemoryScope). */
+  size_t CurrentlyAllocatedBytes(std::string const& subsystem) const {
+    auto itr = stats_.subsystems.find(subsystem);
+    return itr == stats_.subsystems.end()
+               ? 0
+               : itr->second.currently_allocated_bytes;
+  }
   void Clear()
   {
     stats_ = DeviceStats();
@@ -361,6 +396,11 @@ public:
     LOG(CONSOLE) << "Peak memory usage: "
       << stats_.peak_allocated_bytes / 1048576 << "MiB";
     LOG(CONSOLE) << "Number of allocations: " << stats_.num_allocations;
+    for (auto const& kv : stats_.subsystems) {
+      LOG(CONSOLE) << "  " << kv.first << ": live "
+        << kv.second.currently_allocated_bytes / 1048576 << "MiB, peak "
+        << kv.second.peak_allocated_bytes / 1048576 << "MiB";
+    }
   }
 };
 }  // namespace detail
@@ -370,6 +410,24 @@ inline detail::MemoryLogger &GlobalMemoryLogger() {
   return memory_logger;
 }
 
+/*! \brief Attributes device allocations made on this thread to a named
+ *  subsystem for the duration of the scope; the memory logger reports live
+ *  and peak usage per subsystem.  Scopes nest, restoring the previous label
+ *  on exit.  Takes a string literal: the label must outlive the scope. */
+class MemoryScope {
+ public:
+  explicit MemoryScope(const char *subsystem)
+      : previous_{detail::CurrentMemoryScope()} {
+    detail::CurrentMemoryScope() = subsystem;
+  }
+  ~MemoryScope() { detail::CurrentMemoryScope() = previous_; }
+  MemoryScope(MemoryScope const &) = delete;
+  MemoryScope &operator=(MemoryScope const &) = delete;
+
+ private:
+  const char *previous_;
+};
+
 // dh::DebugSyncDevice(__FILE__, __LINE__);
 inline void DebugSyncDevice(std::string file="", int32_t line = -1) {
   if (file != "" && line != -1) {
@@ -400,8 +458,19 @@ inline void ThrowOOMError(std::string const& err, size_t bytes) {
   LOG(FATAL) << ss.str();
 }
 
+/*! \brief The per-device arena shared by every dh:: allocator in non-RMM
+ *  builds.  Blocks are binned by geometrically growing sizes and retired
+ *  blocks are recycled per stream without device synchronization, so
+ *  repeated allocations during tree building do not hit cudaMalloc/cudaFree.
+ *  Blocks above the largest bin (~1GB) bypass the cache. */
+inline cub::CachingDeviceAllocator& GetGlobalCachingAllocator() {
+  static cub::CachingDeviceAllocator *allocator = new cub::CachingDeviceAllocator(2, 9, 29);
+  return *allocator;
+}
+
 /**
- * \brief Default memory allocator, uses cudaMalloc/Free and logs allocations if verbose.
+ * \brief Default memory allocator; routes through the global caching arena
+ *        (or RMM when enabled) and logs allocations if verbose.
  */
 template <class T>
 struct XGBDefaultDeviceAllocatorImpl : XGBBaseDeviceAllocator<T> {
@@ -413,6 +482,7 @@ struct XGBDefaultDeviceAllocatorImpl : XGBBaseDeviceAllocator<T> {
     using other = XGBDefaultDeviceAllocatorImpl<U>;  // NOLINT
   };
   pointer allocate(size_t n) {  // NOLINT
+#if defined(XGBOOST_USE_RMM) && XGBOOST_USE_RMM == 1
     pointer ptr;
     try {
       ptr = SuperT::allocate(n);
@@ -420,12 +490,25 @@ struct XGBDefaultDeviceAllocatorImpl : XGBBaseDeviceAllocator<T> {
     } catch (const std::exception &e) {
       ThrowOOMError(e.what(), n * sizeof(T));
     }
+#else
+    T *raw_ptr;
+    auto errc = GetGlobalCachingAllocator().DeviceAllocate(
+        reinterpret_cast<void **>(&raw_ptr), n * sizeof(T));
+    if (errc != cudaSuccess) {
+      ThrowOOMError("Caching allocator", n * sizeof(T));
+    }
+    pointer ptr{raw_ptr};
+#endif  // defined(XGBOOST_USE_RMM) && XGBOOST_USE_RMM == 1
     GlobalMemoryLogger().RegisterAllocation(ptr.get(), n * sizeof(T));
     return ptr;
   }
   void deallocate(pointer ptr, size_t n) {  // NOLINT
     GlobalMemoryLogger().RegisterDeallocation(ptr.get(), n * sizeof(T));
+#if defined(XGBOOST_USE_RMM) && XGBOOST_USE_RMM == 1
     SuperT::deallocate(ptr, n);
+#else
+    GetGlobalCachingAllocator().DeviceFree(ptr.get());
+#endif  // defined(XGBOOST_USE_RMM) && XGBOOST_USE_RMM == 1
   }
 #if defined(XGBOOST_USE_RMM) && XGBOOST_USE_RMM == 1
   XGBDefaultDeviceAllocatorImpl()
@@ -446,12 +529,6 @@ struct XGBCachingDeviceAllocatorImpl : XGBBaseDeviceAllocator<T> {
   {
     using other = XGBCachingDeviceAllocatorImpl<U>;  // NOLINT
   };
-  cub::CachingDeviceAllocator& GetGlobalCachingAllocator() {
-    // Configure allocator with maximum cached bin size of ~1GB and no limit on
-    // maximum cached bytes
-    static cub::CachingDeviceAllocator *allocator = new cub::CachingDeviceAllocator(2, 9, 29);
-    return *allocator;
-  }
   pointer allocate(size_t n) {  // NOLINT
     T* ptr;
     auto errc =  GetGlobalCachingAllocator().DeviceAllocate(reinterpret_cast<void **>(&ptr),
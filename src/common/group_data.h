@@ -21,6 +21,8 @@
 
 #include "xgboost/base.h"
 
+#include "memory_stats.h"
+
 namespace xgboost {
 namespace common {
 /*!
@@ -48,6 +50,10 @@ class ParallelGroupBuilder {
         data_(*p_data),
         base_row_offset_(base_row_offset) {}
 
+  ~ParallelGroupBuilder() {
+    MemoryStats::Instance().Free(MemoryStats::kGroupBuilder, accounted_bytes_);
+  }
+
   /*!
    * \brief step 1: initialize the helper, with hint of number keys
    *                and thread used in the construction
@@ -59,6 +65,7 @@ class ParallelGroupBuilder {
     for (std::size_t i = 0; i < thread_rptr_.size(); ++i) {
       thread_rptr_[i].resize(max_key - std::min(base_row_offset_, max_key), 0);
     }
+    Account();
   }
 
   /*!
@@ -78,6 +85,9 @@ class ParallelGroupBuilder {
 
   /*! \brief step 3: initialize the necessary storage */
   inline void InitStorage() {
+    // budget rows grown by concurrent AddBudget calls are charged here, once
+    // all the budgeting threads have joined
+    Account();
     // set rptr to correct size
     SizeType rptr_fill_value = rptr_.empty() ? 0 : rptr_.back();
     for (std::size_t tid = 0; tid < thread_rptr_.size(); ++tid) {
@@ -119,6 +129,25 @@ class ParallelGroupBuilder {
   }
 
  private:
+  // Sync the charged figure to the capacity of the thread local budgets.
+  // rptr_ and data_ are caller owned and accounted by their owners.
+  void Account() {
+    size_t bytes = 0;
+    for (auto const& trptr : thread_rptr_) {
+      bytes += trptr.capacity() * sizeof(SizeType);
+    }
+    if (bytes == accounted_bytes_) {
+      return;
+    }
+    auto& stats = MemoryStats::Instance();
+    if (bytes > accounted_bytes_) {
+      stats.Allocate(MemoryStats::kGroupBuilder, bytes - accounted_bytes_);
+    } else {
+      stats.Free(MemoryStats::kGroupBuilder, accounted_bytes_ - bytes);
+    }
+    accounted_bytes_ = bytes;
+  }
+
   /*! \brief pointer to the beginning and end of each continuous key */
   std::vector<SizeType> &rptr_;
   /*! \brief index of nonzero entries in each row */
@@ -127,6 +156,8 @@ class ParallelGroupBuilder {
   std::vector<std::vector<SizeType> > thread_rptr_;
   /** \brief Used when rows being pushed into the builder are strictly above some number. */
   size_t base_row_offset_;
+  /*! \brief bytes currently charged to the MemoryStats gauge */
+  size_t accounted_bytes_ {0};
 };
 }  // namespace common
 }  // namespace xgboost
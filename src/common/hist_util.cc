@@ -6,15 +6,21 @@
 #include <dmlc/omp.h>
 
 #include <rabit/rabit.h>
+#include <algorithm>
+#include <bitset>
+#include <cmath>
 #include <numeric>
+#include <utility>
 #include <vector>
 
 #include "xgboost/base.h"
 #include "../common/common.h"
 #include "hist_util.h"
+#include "kernel_calibration.h"
 #include "random.h"
 #include "column_matrix.h"
 #include "quantile.h"
+#include "../data/adapter.h"
 #include "./../tree/updater_quantile_hist.h"
 
 #if defined(XGBOOST_MM_PREFETCH_PRESENT)
@@ -26,6 +32,12 @@
   #define PREFETCH_READ_T0(addr) do {} while (0)
 #endif  // defined(XGBOOST_MM_PREFETCH_PRESENT)
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && \
+    !defined(__CUDACC__) && !defined(__APPLE__)
+  #define XGBOOST_HIST_VEC_KERNELS_PRESENT 1
+  #include <immintrin.h>
+#endif  // defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+
 namespace xgboost {
 namespace common {
 
@@ -48,10 +60,191 @@ HistogramCuts::HistogramCuts() {
   cut_ptrs_.HostVector().emplace_back(0);
 }
 
-void GHistIndexMatrix::Init(DMatrix* p_fmat, int max_bins) {
-  cut = SketchOnDMatrix(p_fmat, max_bins);
+namespace {
+// number of rows on which both bitsets have a non-zero entry
+size_t CountSharedRows(const std::vector<uint64_t>& a,
+                       const std::vector<uint64_t>& b) {
+  size_t n = 0;
+  for (size_t i = 0; i < a.size(); ++i) {
+    n += std::bitset<64>(a[i] & b[i]).count();
+  }
+  return n;
+}
+}  // anonymous namespace
+
+bst_feature_t ExclusiveFeatureBundles::OriginalSplit(
+    bst_feature_t bundled_fid, bst_float split_value,
+    bst_float* out_value) const {
+  auto const& members = bundles.at(bundled_fid);
+  if (members.size() == 1) {
+    // singleton bundles keep the original values
+    *out_value = split_value;
+    return members.front();
+  }
+  // members are stored in increasing offset order and own disjoint value
+  // ranges, so the split lies inside the range of exactly one of them
+  bst_feature_t fid = members.front();
+  for (auto it = members.rbegin(); it != members.rend(); ++it) {
+    if (feature_offsets[*it] < split_value) {
+      fid = *it;
+      break;
+    }
+  }
+  *out_value = static_cast<bst_float>(split_value - feature_offsets[fid] -
+                                      1.0 + feature_min[fid]);
+  return fid;
+}
+
+ExclusiveFeatureBundles MakeExclusiveFeatureBundles(DMatrix* m,
+                                                    double max_conflict_rate) {
+  CHECK_GE(max_conflict_rate, 0.0);
+  ExclusiveFeatureBundles efb;
+  const size_t n_rows = m->Info().num_row_;
+  const auto n_features = static_cast<bst_feature_t>(m->Info().num_col_);
+  const size_t n_words = (n_rows + 63) / 64;
+
+  // per-feature non-zero row bitsets, counts and value ranges
+  std::vector<std::vector<uint64_t>> rows(
+      n_features, std::vector<uint64_t>(n_words, 0));
+  std::vector<size_t> nnz(n_features, 0);
+  std::vector<float> fmin(n_features, std::numeric_limits<float>::max());
+  std::vector<float> fmax(n_features, std::numeric_limits<float>::lowest());
+  for (const auto& batch : m->GetBatches<CSCPage>()) {
+    for (bst_feature_t fid = 0; fid < n_features; ++fid) {
+      auto col = batch[fid];
+      nnz[fid] += col.size();
+      for (auto const& e : col) {
+        rows[fid][e.index / 64] |= uint64_t{1} << (e.index % 64);
+        fmin[fid] = std::min(fmin[fid], e.fvalue);
+        fmax[fid] = std::max(fmax[fid], e.fvalue);
+      }
+    }
+  }
+
+  // greedy assignment in decreasing density, as the densest features are the
+  // hardest to place
+  std::vector<bst_feature_t> order(n_features);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&nnz](bst_feature_t a, bst_feature_t b) {
+                     return nnz[a] > nnz[b];
+                   });
+
+  efb.feature_to_bundle.resize(n_features);
+  efb.feature_offsets.resize(n_features, 0.0);
+  efb.feature_min = fmin;
+  std::vector<std::vector<uint64_t>> bundle_rows;
+  std::vector<size_t> bundle_conflicts;
+  std::vector<double> bundle_upper;
+  std::vector<bool> bundle_open;
+  const auto budget = static_cast<size_t>(max_conflict_rate * n_rows);
+  // features this dense gain little from bundling, keep them alone
+  const size_t dense_cutoff = n_rows / 2;
+  // cap the number of candidate bundles scanned per feature to keep the
+  // assignment linear in practice
+  const size_t kMaxSearch = 256;
+  for (auto fid : order) {
+    int32_t assigned = -1;
+    if (nnz[fid] <= dense_cutoff) {
+      const size_t n_search = std::min(bundle_rows.size(), kMaxSearch);
+      for (size_t b = 0; b < n_search && assigned < 0; ++b) {
+        if (!bundle_open[b]) {
+          continue;
+        }
+        const size_t conflicts = CountSharedRows(bundle_rows[b], rows[fid]);
+        if (bundle_conflicts[b] + conflicts <= budget) {
+          bundle_conflicts[b] += conflicts;
+          assigned = static_cast<int32_t>(b);
+        }
+      }
+    }
+    if (assigned < 0) {
+      bundle_rows.emplace_back(n_words, 0);
+      bundle_conflicts.push_back(0);
+      bundle_upper.push_back(0.0);
+      bundle_open.push_back(nnz[fid] <= dense_cutoff);
+      efb.bundles.emplace_back();
+      assigned = static_cast<int32_t>(efb.bundles.size() - 1);
+    }
+    for (size_t i = 0; i < n_words; ++i) {
+      bundle_rows[assigned][i] |= rows[fid][i];
+    }
+    efb.feature_to_bundle[fid] = assigned;
+    efb.feature_offsets[fid] = bundle_upper[assigned];
+    const double span = nnz[fid] == 0 ? 0.0
+        : static_cast<double>(fmax[fid]) - static_cast<double>(fmin[fid]);
+    bundle_upper[assigned] += span + 1.0;
+    efb.bundles[assigned].push_back(fid);
+  }
+  return efb;
+}
 
-  max_num_bins = max_bins;
+std::shared_ptr<DMatrix> ApplyExclusiveFeatureBundles(
+    DMatrix* m, ExclusiveFeatureBundles const& efb) {
+  std::vector<size_t> row_ptr{0};
+  std::vector<unsigned> indices;
+  std::vector<float> values;
+  std::vector<std::pair<unsigned, float>> line;
+  for (const auto& batch : m->GetBatches<SparsePage>()) {
+    for (size_t i = 0; i < batch.Size(); ++i) {
+      line.clear();
+      for (auto const& e : batch[i]) {
+        const auto b = efb.feature_to_bundle[e.index];
+        // singleton bundles keep the original values, everything else is
+        // shifted into the member's range: (offset, offset + span + 1]
+        const float v = efb.bundles[b].size() == 1
+            ? e.fvalue
+            : static_cast<float>(efb.feature_offsets[e.index] +
+                                 (e.fvalue - efb.feature_min[e.index]) + 1.0);
+        line.emplace_back(b, v);
+      }
+      std::stable_sort(line.begin(), line.end(),
+                       [](std::pair<unsigned, float> const& a,
+                          std::pair<unsigned, float> const& b) {
+                         return a.first < b.first;
+                       });
+      for (size_t j = 0; j < line.size(); ++j) {
+        // conflict-tolerant: a conflicting row keeps only its first entry of
+        // the bundle
+        if (j > 0 && line[j].first == line[j - 1].first) {
+          continue;
+        }
+        indices.push_back(line[j].first);
+        values.push_back(line[j].second);
+      }
+      row_ptr.push_back(values.size());
+    }
+  }
+  data::CSRAdapter adapter(row_ptr.data(), indices.data(), values.data(),
+                           row_ptr.size() - 1, values.size(),
+                           efb.NumBundles());
+  std::shared_ptr<DMatrix> bundled{DMatrix::Create(
+      &adapter, std::numeric_limits<float>::quiet_NaN(), 0)};
+  auto& out_info = bundled->Info();
+  auto const& in_info = m->Info();
+  out_info.labels_.Resize(in_info.labels_.Size());
+  out_info.labels_.Copy(in_info.labels_);
+  out_info.weights_.Resize(in_info.weights_.Size());
+  out_info.weights_.Copy(in_info.weights_);
+  out_info.base_margin_.Resize(in_info.base_margin_.Size());
+  out_info.base_margin_.Copy(in_info.base_margin_);
+  out_info.group_ptr_ = in_info.group_ptr_;
+  return bundled;
+}
+
+void GHistIndexMatrix::Init(DMatrix* p_fmat, int max_bins,
+                            common::Span<float const> hessian) {
+  cut = SketchOnDMatrix(p_fmat, max_bins, hessian);
+
+  /* Choose the bin index width from the realized cut counts instead of the
+     configured maximum: sketching often produces far fewer cuts per feature
+     than requested, and the dense index stores bins relative to the feature
+     offset, so the widest feature bounds the storage type. */
+  max_num_bins = 1;
+  for (size_t fid = 1; fid < cut.Ptrs().size(); ++fid) {
+    max_num_bins = std::max(
+        max_num_bins, static_cast<size_t>(cut.Ptrs()[fid] - cut.Ptrs()[fid - 1]));
+  }
   const int32_t nthread = omp_get_max_threads();
   const uint32_t nbins = cut.Ptrs().back();
   hit_count.resize(nbins, 0);
@@ -62,22 +255,59 @@ void GHistIndexMatrix::Init(DMatrix* p_fmat, int max_bins) {
   for (const auto &batch : p_fmat->GetBatches<SparsePage>()) {
     new_size += batch.Size();
   }
-
-  row_ptr.resize(new_size);
-  row_ptr[0] = 0;
+  n_rows_ = new_size - 1;
 
   size_t rbegin = 0;
-  size_t prev_sum = 0;
   const bool isDense = p_fmat->IsDense();
   this->isDense_ = isDense;
 
+  /* A dense matrix has exactly one entry per feature in every row, so rows
+     are addressed by the implicit stride and the offset array is never
+     materialized for it. */
+  if (isDense) {
+    row_stride_ = cut.Ptrs().size() - 1;
+  } else {
+    row_stride_ = 0;
+    row_ptr.resize(new_size);
+    row_ptr[0] = 0;
+  }
+
+  /* Size the index once from the total entry count so external memory pages
+     stream into the final buffer; growing it batch by batch reallocates and
+     copies the whole index on every page. */
+  const size_t n_entries = p_fmat->Info().num_nonzero_;
+  ResizeIndex(n_entries, isDense);
+  if (isDense) {
+    const size_t n_offsets = cut.Ptrs().size() - 1;
+    index.ResizeOffset(n_offsets);
+    uint32_t* offsets = index.Offset();
+    for (size_t i = 0; i < n_offsets; ++i) {
+      offsets[i] = cut.Ptrs()[i];
+    }
+  }
+
   for (const auto &batch : p_fmat->GetBatches<SparsePage>()) {
-    // The number of threads is pegged to the batch size. If the OMP
-    // block is parallelized on anything other than the batch/block size,
-    // it should be reassigned
-    const size_t batch_threads = std::max(
-        size_t(1),
-        std::min(batch.Size(), static_cast<size_t>(omp_get_max_threads())));
+    this->PushBatch(batch, rbegin, nbins, n_entries, nthread);
+    rbegin += batch.Size();
+  }
+  CHECK_EQ(this->RowBegin(n_rows_), n_entries);
+}
+
+void GHistIndexMatrix::PushBatch(const SparsePage &batch, size_t rbegin,
+                                 uint32_t nbins, size_t n_entries,
+                                 int32_t nthread) {
+  const bool isDense = isDense_;
+  // The number of threads is pegged to the batch size. If the OMP
+  // block is parallelized on anything other than the batch/block size,
+  // it should be reassigned
+  const size_t batch_threads = std::max(
+      size_t(1),
+      std::min(batch.Size(), static_cast<size_t>(omp_get_max_threads())));
+
+  // a dense matrix carries no row pointers, so only the sparse layout runs
+  // the prefix sum filling them in
+  if (!isDense) {
+    const size_t prev_sum = row_ptr[rbegin];
     MemStackAllocator<size_t, 128> partial_sums(batch_threads);
     size_t* p_part = partial_sums.Get();
 
@@ -115,68 +345,180 @@ void GHistIndexMatrix::Init(DMatrix* p_fmat, int max_bins) {
         }
       }
     }
+  }
 
-    const size_t n_offsets = cut.Ptrs().size() - 1;
-    const size_t n_index = row_ptr[rbegin + batch.Size()];
-    ResizeIndex(n_index, isDense);
+  const size_t n_index = this->RowBegin(rbegin + batch.Size());
+  CHECK_LE(n_index, n_entries);
 
-    CHECK_GT(cut.Values().size(), 0U);
+  CHECK_GT(cut.Values().size(), 0U);
 
-    uint32_t* offsets = nullptr;
-    if (isDense) {
-      index.ResizeOffset(n_offsets);
-      offsets = index.Offset();
-      for (size_t i = 0; i < n_offsets; ++i) {
-        offsets[i] = cut.Ptrs()[i];
-      }
-    }
+  const uint32_t* offsets = isDense ? index.Offset() : nullptr;
 
-    if (isDense) {
-      BinTypeSize curent_bin_size = index.GetBinTypeSize();
-      if (curent_bin_size == kUint8BinsTypeSize) {
-        common::Span<uint8_t> index_data_span = {index.data<uint8_t>(),
-                                                 n_index};
-        SetIndexData(index_data_span, batch_threads, batch, rbegin, nbins,
-                     [offsets](auto idx, auto j) {
-                       return static_cast<uint8_t>(idx - offsets[j]);
-                     });
-
-      } else if (curent_bin_size == kUint16BinsTypeSize) {
-        common::Span<uint16_t> index_data_span = {index.data<uint16_t>(),
-                                                  n_index};
-        SetIndexData(index_data_span, batch_threads, batch, rbegin, nbins,
-                     [offsets](auto idx, auto j) {
-                       return static_cast<uint16_t>(idx - offsets[j]);
-                     });
-      } else {
-        CHECK_EQ(curent_bin_size, kUint32BinsTypeSize);
-        common::Span<uint32_t> index_data_span = {index.data<uint32_t>(),
-                                                  n_index};
-        SetIndexData(index_data_span, batch_threads, batch, rbegin, nbins,
-                     [offsets](auto idx, auto j) {
-                       return static_cast<uint32_t>(idx - offsets[j]);
-                     });
-      }
+  if (isDense) {
+    BinTypeSize curent_bin_size = index.GetBinTypeSize();
+    if (curent_bin_size == kUint8BinsTypeSize) {
+      common::Span<uint8_t> index_data_span = {index.data<uint8_t>(),
+                                               n_index};
+      SetIndexData(index_data_span, batch_threads, batch, rbegin, nbins,
+                   [offsets](auto idx, auto j) {
+                     return static_cast<uint8_t>(idx - offsets[j]);
+                   });
 
-    /* For sparse DMatrix we have to store index of feature for each bin
-       in index field to chose right offset. So offset is nullptr and index is not reduced */
+    } else if (curent_bin_size == kUint16BinsTypeSize) {
+      common::Span<uint16_t> index_data_span = {index.data<uint16_t>(),
+                                                n_index};
+      SetIndexData(index_data_span, batch_threads, batch, rbegin, nbins,
+                   [offsets](auto idx, auto j) {
+                     return static_cast<uint16_t>(idx - offsets[j]);
+                   });
     } else {
-      common::Span<uint32_t> index_data_span = {index.data<uint32_t>(), n_index};
+      CHECK_EQ(curent_bin_size, kUint32BinsTypeSize);
+      common::Span<uint32_t> index_data_span = {index.data<uint32_t>(),
+                                                n_index};
       SetIndexData(index_data_span, batch_threads, batch, rbegin, nbins,
-                   [](auto idx, auto) { return idx; });
+                   [offsets](auto idx, auto j) {
+                     return static_cast<uint32_t>(idx - offsets[j]);
+                   });
+    }
+
+  /* For sparse DMatrix we have to store index of feature for each bin
+     in index field to chose right offset. So offset is nullptr and index is not reduced */
+  } else {
+    common::Span<uint32_t> index_data_span = {index.data<uint32_t>(), n_index};
+    SetIndexData(index_data_span, batch_threads, batch, rbegin, nbins,
+                 [](auto idx, auto) { return idx; });
+  }
+
+  #pragma omp parallel for num_threads(nthread) schedule(static)
+  for (bst_omp_uint idx = 0; idx < bst_omp_uint(nbins); ++idx) {
+    for (int32_t tid = 0; tid < nthread; ++tid) {
+      hit_count[idx] += hit_count_tloc_[tid * nbins + idx];
+      hit_count_tloc_[tid * nbins + idx] = 0;  // reset for next batch
     }
+  }
+}
+
+namespace {
+// Copy one parser block into a CSR page so the existing sketch and
+// quantization kernels can run on it.  A missing value array means the text
+// format carries indicator features with an implicit value of one.
+void RowBlockToPage(dmlc::RowBlock<uint32_t> const& block, size_t base_rowid,
+                    SparsePage* p_page) {
+  auto& offset_vec = p_page->offset.HostVector();
+  auto& data_vec = p_page->data.HostVector();
+  const size_t first = block.offset[0];
+  offset_vec.resize(block.size + 1);
+  data_vec.resize(block.offset[block.size] - first);
+  offset_vec[0] = 0;
+  for (size_t i = 0; i < block.size; ++i) {
+    offset_vec[i + 1] = block.offset[i + 1] - first;
+  }
+  ParallelFor(data_vec.size(), omp_get_max_threads(), [&](size_t i) {
+    const float fvalue = block.value == nullptr ? 1.0f : block.value[first + i];
+    data_vec[i] = Entry(block.index[first + i], fvalue);
+  });
+  p_page->base_rowid = base_rowid;
+}
+}  // anonymous namespace
 
-    #pragma omp parallel for num_threads(nthread) schedule(static)
-    for (bst_omp_uint idx = 0; idx < bst_omp_uint(nbins); ++idx) {
-      for (int32_t tid = 0; tid < nthread; ++tid) {
-        hit_count[idx] += hit_count_tloc_[tid * nbins + idx];
-        hit_count_tloc_[tid * nbins + idx] = 0;  // reset for next batch
+void GHistIndexMatrix::Init(dmlc::Parser<uint32_t>* parser, MetaInfo* info,
+                            int max_bins) {
+  const int32_t nthread = omp_get_max_threads();
+
+  // Counting pass: shapes, per-column entry counts and row metadata.  Only
+  // the current parser block is resident.
+  size_t n_rows = 0;
+  size_t n_entries = 0;
+  std::vector<bst_row_t> columns_size;
+  std::vector<bst_float> labels;
+  std::vector<bst_float> weights;
+  parser->BeforeFirst();
+  while (parser->Next()) {
+    auto const& block = parser->Value();
+    n_rows += block.size;
+    n_entries += block.offset[block.size] - block.offset[0];
+    for (size_t i = block.offset[0]; i < block.offset[block.size]; ++i) {
+      const size_t fid = block.index[i];
+      if (fid >= columns_size.size()) {
+        columns_size.resize(fid + 1, 0);
       }
+      columns_size[fid]++;
+    }
+    if (block.label != nullptr) {
+      labels.insert(labels.end(), block.label, block.label + block.size);
     }
+    if (block.weight != nullptr) {
+      weights.insert(weights.end(), block.weight, block.weight + block.size);
+    }
+  }
+  auto n_cols = static_cast<bst_feature_t>(columns_size.size());
+  rabit::Allreduce<rabit::op::Max>(&n_cols, 1);
+  columns_size.resize(n_cols, 0);
+  CHECK_NE(n_cols, 0) << "No feature is found from the input data.";
+
+  info->num_row_ = n_rows;
+  info->num_col_ = n_cols;
+  info->num_nonzero_ = n_entries;
+  if (!labels.empty()) {
+    info->labels_.HostVector() = std::move(labels);
+  }
+  if (!weights.empty()) {
+    info->weights_.HostVector() = std::move(weights);
+  }
 
-    prev_sum = row_ptr[rbegin + batch.Size()];
-    rbegin += batch.Size();
+  // Sketching pass.  Distributed merging of the per-worker sketches happens
+  // inside MakeCuts, exactly as on the DMatrix path.
+  HostSketchContainer container(columns_size, max_bins,
+                                HostSketchContainer::UseGroup(*info));
+  SparsePage page;
+  size_t base_rowid = 0;
+  parser->BeforeFirst();
+  while (parser->Next()) {
+    RowBlockToPage(parser->Value(), base_rowid, &page);
+    container.PushRowPage(page, *info);
+    base_rowid += page.Size();
+  }
+  container.MakeCuts(&cut);
+
+  max_num_bins = 1;
+  for (size_t fid = 1; fid < cut.Ptrs().size(); ++fid) {
+    max_num_bins = std::max(
+        max_num_bins, static_cast<size_t>(cut.Ptrs()[fid] - cut.Ptrs()[fid - 1]));
+  }
+  const uint32_t nbins = cut.Ptrs().back();
+  hit_count.resize(nbins, 0);
+  hit_count_tloc_.resize(nthread * nbins, 0);
+
+  this->p_fmat = nullptr;
+  n_rows_ = n_rows;
+  this->isDense_ = n_entries == n_rows * static_cast<size_t>(n_cols);
+  if (isDense_) {
+    row_stride_ = n_cols;
+  } else {
+    row_stride_ = 0;
+    row_ptr.resize(n_rows + 1);
+    row_ptr[0] = 0;
+  }
+  ResizeIndex(n_entries, isDense_);
+  if (isDense_) {
+    const size_t n_offsets = cut.Ptrs().size() - 1;
+    index.ResizeOffset(n_offsets);
+    uint32_t* offsets = index.Offset();
+    for (size_t i = 0; i < n_offsets; ++i) {
+      offsets[i] = cut.Ptrs()[i];
+    }
+  }
+
+  // Quantization pass: parsed values go straight into the compressed index.
+  size_t rbegin = 0;
+  parser->BeforeFirst();
+  while (parser->Next()) {
+    RowBlockToPage(parser->Value(), rbegin, &page);
+    this->PushBatch(page, rbegin, nbins, n_entries, nthread);
+    rbegin += page.Size();
   }
+  CHECK_EQ(rbegin, n_rows);
+  CHECK_EQ(this->RowBegin(n_rows_), n_entries);
 }
 
 template <typename BinIdxType>
@@ -324,7 +666,7 @@ inline std::vector<std::vector<unsigned>>
 FastFeatureGrouping(const GHistIndexMatrix& gmat,
                     const ColumnMatrix& colmat,
                     const tree::TrainParam& param) {
-  const size_t nrow = gmat.row_ptr.size() - 1;
+  const size_t nrow = gmat.Size();
   const size_t nfeature = gmat.cut.Ptrs().size() - 1;
 
   std::vector<unsigned> feature_list(nfeature);
@@ -380,7 +722,7 @@ void GHistIndexBlockMatrix::Init(const GHistIndexMatrix& gmat,
                                  const tree::TrainParam& param) {
   cut_ = &gmat.cut;
 
-  const size_t nrow = gmat.row_ptr.size() - 1;
+  const size_t nrow = gmat.Size();
   const uint32_t nbins = gmat.cut.Ptrs().back();
 
   /* step 1: form feature groups */
@@ -405,8 +747,8 @@ void GHistIndexBlockMatrix::Init(const GHistIndexMatrix& gmat,
     row_ptr_temp[block_id].push_back(0);
   }
   for (size_t rid = 0; rid < nrow; ++rid) {
-    const size_t ibegin = gmat.row_ptr[rid];
-    const size_t iend = gmat.row_ptr[rid + 1];
+    const size_t ibegin = gmat.RowBegin(rid);
+    const size_t iend = gmat.RowEnd(rid);
     for (size_t j = ibegin; j < iend; ++j) {
       const uint32_t bin_id = gmat.index[j];
       const uint32_t block_id = bin2block[bin_id];
@@ -516,19 +858,69 @@ template void SubtractionHist(GHistRow<double> dst, const GHistRow<double> src1,
                               const GHistRow<double> src2,
                               size_t begin, size_t end);
 
+void QuantizedGradients::Init(const std::vector<GradientPair>& gpair) {
+  const size_t size = gpair.size();
+  data_.resize(2 * size);
+
+  const int32_t nthread = omp_get_max_threads();
+  MemStackAllocator<float, 128> partial_max(nthread);
+  float* p_max = partial_max.Get();
+  std::fill(p_max, p_max + nthread, 0.0f);
+
+#pragma omp parallel for num_threads(nthread) schedule(static)
+  for (omp_ulong i = 0; i < size; ++i) {
+    const int tid = omp_get_thread_num();
+    p_max[tid] = std::max(p_max[tid], std::abs(gpair[i].GetGrad()));
+    p_max[tid] = std::max(p_max[tid], std::abs(gpair[i].GetHess()));
+  }
+  float max_abs = 0.0f;
+  for (int32_t tid = 0; tid < nthread; ++tid) {
+    max_abs = std::max(max_abs, p_max[tid]);
+  }
+
+  // shared power-of-two exponent: quantization/dequantization is a plain
+  // exponent shift and introduces no extra rounding on the way back
+  constexpr float kMaxQuant = 32767.0f;
+  int exponent = 0;
+  if (max_abs > 0.0f) {
+    std::frexp(max_abs / kMaxQuant, &exponent);
+  }
+  scale_ = std::ldexp(1.0f, exponent);
+  const float inv_scale = 1.0f / scale_;
+
+  int16_t* data = data_.data();
+#pragma omp parallel for num_threads(nthread) schedule(static)
+  for (omp_ulong i = 0; i < size; ++i) {
+    data[2 * i] = static_cast<int16_t>(std::round(gpair[i].GetGrad() * inv_scale));
+    data[2 * i + 1] = static_cast<int16_t>(std::round(gpair[i].GetHess() * inv_scale));
+  }
+}
+
 struct Prefetch {
  public:
   static constexpr size_t kCacheLineSize = 64;
-  static constexpr size_t kPrefetchOffset = 10;
-
- private:
-  static constexpr size_t kNoPrefetchSize =
-      kPrefetchOffset + kCacheLineSize /
-      sizeof(decltype(GHistIndexMatrix::row_ptr)::value_type);
+  static constexpr size_t kDefaultPrefetchOffset = 10;
+
+  /*!
+   * \brief Pipelining distance in rows; overridable once per process through
+   *        the XGBOOST_HIST_PREFETCH_DISTANCE environment variable, since the
+   *        best distance depends on the memory latency of the machine.  When
+   *        the variable is unset the distance comes from KernelCalibration,
+   *        which returns the historical default unless calibration is on.
+   */
+  static size_t Offset() {
+    static const size_t offset = static_cast<size_t>(std::max(
+        1, dmlc::GetEnv("XGBOOST_HIST_PREFETCH_DISTANCE",
+                        static_cast<int>(
+                            KernelCalibration::Params().hist_prefetch_distance))));
+    return offset;
+  }
 
- public:
+  // the tail processed without prefetching covers the two-stage pipeline
+  // (2x distance) of the sparse kernel plus one cache line of row pointers
   static size_t NoPrefetchSize(size_t rows) {
-    return std::min(rows, kNoPrefetchSize);
+    return std::min(rows, 2 * Offset() + kCacheLineSize /
+        sizeof(decltype(GHistIndexMatrix::row_ptr)::value_type));
   }
 
   template <typename T>
@@ -537,8 +929,6 @@ struct Prefetch {
   }
 };
 
-constexpr size_t Prefetch::kNoPrefetchSize;
-
 
 template<typename FPType, bool do_prefetch, typename BinIdxType>
 void BuildHistDenseKernel(const std::vector<GradientPair>& gpair,
@@ -548,6 +938,7 @@ void BuildHistDenseKernel(const std::vector<GradientPair>& gpair,
                           GHistRow<FPType> hist) {
   const size_t size = row_indices.Size();
   const size_t* rid = row_indices.begin;
+  const size_t prefetch_offset = do_prefetch ? Prefetch::Offset() : 0;
   const float* pgh = reinterpret_cast<const float*>(gpair.data());
   const BinIdxType* gradient_index = gmat.index.data<BinIdxType>();
   const uint32_t* offsets = gmat.index.Offset();
@@ -562,9 +953,9 @@ void BuildHistDenseKernel(const std::vector<GradientPair>& gpair,
     const size_t idx_gh = two * rid[i];
 
     if (do_prefetch) {
-      const size_t icol_start_prefetch = rid[i + Prefetch::kPrefetchOffset] * n_features;
+      const size_t icol_start_prefetch = rid[i + prefetch_offset] * n_features;
 
-      PREFETCH_READ_T0(pgh + two * rid[i + Prefetch::kPrefetchOffset]);
+      PREFETCH_READ_T0(pgh + two * rid[i + prefetch_offset]);
       for (size_t j = icol_start_prefetch; j < icol_start_prefetch + n_features;
            j += Prefetch::GetPrefetchStep<BinIdxType>()) {
         PREFETCH_READ_T0(gradient_index + j);
@@ -588,6 +979,7 @@ void BuildHistSparseKernel(const std::vector<GradientPair>& gpair,
                            GHistRow<FPType> hist) {
   const size_t size = row_indices.Size();
   const size_t* rid = row_indices.begin;
+  const size_t prefetch_offset = do_prefetch ? Prefetch::Offset() : 0;
   const float* pgh = reinterpret_cast<const float*>(gpair.data());
   const uint32_t* gradient_index = gmat.index.data<uint32_t>();
   const size_t* row_ptr =  gmat.row_ptr.data();
@@ -603,10 +995,16 @@ void BuildHistSparseKernel(const std::vector<GradientPair>& gpair,
     const size_t idx_gh = two * rid[i];
 
     if (do_prefetch) {
-      const size_t icol_start_prftch = row_ptr[rid[i+Prefetch::kPrefetchOffset]];
-      const size_t icol_end_prefect = row_ptr[rid[i+Prefetch::kPrefetchOffset]+1];
+      // two-stage pipeline: touch the row pointer and gradient pair two
+      // windows ahead, so when the window below reaches that row its
+      // row_ptr lookup (needed to address the index row) is already cached
+      const size_t far_rid = rid[i + 2 * prefetch_offset];
+      PREFETCH_READ_T0(row_ptr + far_rid);
+      PREFETCH_READ_T0(pgh + two * far_rid);
+
+      const size_t icol_start_prftch = row_ptr[rid[i+prefetch_offset]];
+      const size_t icol_end_prefect = row_ptr[rid[i+prefetch_offset]+1];
 
-      PREFETCH_READ_T0(pgh + two * rid[i + Prefetch::kPrefetchOffset]);
       for (size_t j = icol_start_prftch; j < icol_end_prefect;
         j+=Prefetch::GetPrefetchStep<uint32_t>()) {
         PREFETCH_READ_T0(gradient_index + j);
@@ -621,38 +1019,475 @@ void BuildHistSparseKernel(const std::vector<GradientPair>& gpair,
 }
 
 
+/*!
+ * \brief Level of SIMD support detected on the running CPU.
+ *
+ * Detected once per process via CPUID; used to pick an explicitly vectorized
+ * histogram kernel when the row block is dense enough to benefit from it.
+ */
+enum class SimdLevel : int {
+  kNone = 0,
+  kAvx2 = 1,
+  kAvx512 = 2
+};
+
+inline SimdLevel DetectSimdLevel() {
+  static const SimdLevel level = []() {
+#if defined(XGBOOST_HIST_VEC_KERNELS_PRESENT)
+    if (__builtin_cpu_supports("avx512f")) {
+      return SimdLevel::kAvx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+      return SimdLevel::kAvx2;
+    }
+#endif  // defined(XGBOOST_HIST_VEC_KERNELS_PRESENT)
+    return SimdLevel::kNone;
+  }();
+  return level;
+}
+
+#if defined(XGBOOST_HIST_VEC_KERNELS_PRESENT)
+/* For a dense row every feature contributes exactly one bin and the bin id is
+   offsets[j] + local index, so all bins touched by one row are pairwise
+   distinct.  This makes per-row gather/accumulate/scatter free of intra-vector
+   conflicts and is the invariant both kernels below rely on. */
+
+template<bool do_prefetch, typename BinIdxType>
+__attribute__((target("avx2")))
+void BuildHistDenseKernelAvx2(const std::vector<GradientPair>& gpair,
+                              const RowSetCollection::Elem row_indices,
+                              const GHistIndexMatrix& gmat,
+                              const size_t n_features,
+                              GHistRow<double> hist) {
+  const size_t size = row_indices.Size();
+  const size_t* rid = row_indices.begin;
+  const size_t prefetch_offset = do_prefetch ? Prefetch::Offset() : 0;
+  const float* pgh = reinterpret_cast<const float*>(gpair.data());
+  const BinIdxType* gradient_index = gmat.index.data<BinIdxType>();
+  const uint32_t* offsets = gmat.index.Offset();
+  double* hist_data = reinterpret_cast<double*>(hist.data());
+
+  constexpr size_t kLanes = 4;  // 4 x 64-bit gradients per YMM register
+  const size_t n_vec = n_features - n_features % kLanes;
+
+  for (size_t i = 0; i < size; ++i) {
+    const size_t icol_start = rid[i] * n_features;
+    const size_t idx_gh = 2 * rid[i];
+
+    if (do_prefetch) {
+      const size_t icol_start_prefetch = rid[i + prefetch_offset] * n_features;
+
+      PREFETCH_READ_T0(pgh + 2 * rid[i + prefetch_offset]);
+      for (size_t j = icol_start_prefetch; j < icol_start_prefetch + n_features;
+           j += Prefetch::GetPrefetchStep<BinIdxType>()) {
+        PREFETCH_READ_T0(gradient_index + j);
+      }
+    }
+    const BinIdxType* gr_index_local = gradient_index + icol_start;
+    const __m256d grad = _mm256_set1_pd(static_cast<double>(pgh[idx_gh]));
+    const __m256d hess = _mm256_set1_pd(static_cast<double>(pgh[idx_gh + 1]));
+
+    alignas(32) uint32_t bins[kLanes];
+    alignas(32) double sum_g[kLanes];
+    alignas(32) double sum_h[kLanes];
+    for (size_t j = 0; j < n_vec; j += kLanes) {
+      for (size_t k = 0; k < kLanes; ++k) {
+        bins[k] = 2 * (static_cast<uint32_t>(gr_index_local[j + k]) + offsets[j + k]);
+      }
+      const __m128i vidx_g = _mm_load_si128(reinterpret_cast<const __m128i*>(bins));
+      const __m128i vidx_h = _mm_add_epi32(vidx_g, _mm_set1_epi32(1));
+      __m256d g = _mm256_i32gather_pd(hist_data, vidx_g, sizeof(double));
+      __m256d h = _mm256_i32gather_pd(hist_data, vidx_h, sizeof(double));
+      g = _mm256_add_pd(g, grad);
+      h = _mm256_add_pd(h, hess);
+      // AVX2 has no scatter; bins within a row are distinct, plain stores suffice
+      _mm256_store_pd(sum_g, g);
+      _mm256_store_pd(sum_h, h);
+      for (size_t k = 0; k < kLanes; ++k) {
+        hist_data[bins[k]]     = sum_g[k];
+        hist_data[bins[k] + 1] = sum_h[k];
+      }
+    }
+    for (size_t j = n_vec; j < n_features; ++j) {
+      const uint32_t idx_bin = 2 * (static_cast<uint32_t>(gr_index_local[j]) + offsets[j]);
+      hist_data[idx_bin]     += pgh[idx_gh];
+      hist_data[idx_bin + 1] += pgh[idx_gh + 1];
+    }
+  }
+}
+
+template<bool do_prefetch, typename BinIdxType>
+__attribute__((target("avx512f")))
+void BuildHistDenseKernelAvx512(const std::vector<GradientPair>& gpair,
+                                const RowSetCollection::Elem row_indices,
+                                const GHistIndexMatrix& gmat,
+                                const size_t n_features,
+                                GHistRow<double> hist) {
+  const size_t size = row_indices.Size();
+  const size_t* rid = row_indices.begin;
+  const size_t prefetch_offset = do_prefetch ? Prefetch::Offset() : 0;
+  const float* pgh = reinterpret_cast<const float*>(gpair.data());
+  const BinIdxType* gradient_index = gmat.index.data<BinIdxType>();
+  const uint32_t* offsets = gmat.index.Offset();
+  double* hist_data = reinterpret_cast<double*>(hist.data());
+
+  constexpr size_t kLanes = 8;  // 8 x 64-bit gradients per ZMM register
+  const size_t n_vec = n_features - n_features % kLanes;
+
+  for (size_t i = 0; i < size; ++i) {
+    const size_t icol_start = rid[i] * n_features;
+    const size_t idx_gh = 2 * rid[i];
+
+    if (do_prefetch) {
+      const size_t icol_start_prefetch = rid[i + prefetch_offset] * n_features;
+
+      PREFETCH_READ_T0(pgh + 2 * rid[i + prefetch_offset]);
+      for (size_t j = icol_start_prefetch; j < icol_start_prefetch + n_features;
+           j += Prefetch::GetPrefetchStep<BinIdxType>()) {
+        PREFETCH_READ_T0(gradient_index + j);
+      }
+    }
+    const BinIdxType* gr_index_local = gradient_index + icol_start;
+    const __m512d grad = _mm512_set1_pd(static_cast<double>(pgh[idx_gh]));
+    const __m512d hess = _mm512_set1_pd(static_cast<double>(pgh[idx_gh + 1]));
+
+    alignas(32) uint32_t bins[kLanes];
+    for (size_t j = 0; j < n_vec; j += kLanes) {
+      for (size_t k = 0; k < kLanes; ++k) {
+        bins[k] = 2 * (static_cast<uint32_t>(gr_index_local[j + k]) + offsets[j + k]);
+      }
+      const __m256i vidx_g = _mm256_load_si256(reinterpret_cast<const __m256i*>(bins));
+      const __m256i vidx_h = _mm256_add_epi32(vidx_g, _mm256_set1_epi32(1));
+      __m512d g = _mm512_i32gather_pd(vidx_g, hist_data, sizeof(double));
+      __m512d h = _mm512_i32gather_pd(vidx_h, hist_data, sizeof(double));
+      g = _mm512_add_pd(g, grad);
+      h = _mm512_add_pd(h, hess);
+      _mm512_i32scatter_pd(hist_data, vidx_g, g, sizeof(double));
+      _mm512_i32scatter_pd(hist_data, vidx_h, h, sizeof(double));
+    }
+    for (size_t j = n_vec; j < n_features; ++j) {
+      const uint32_t idx_bin = 2 * (static_cast<uint32_t>(gr_index_local[j]) + offsets[j]);
+      hist_data[idx_bin]     += pgh[idx_gh];
+      hist_data[idx_bin + 1] += pgh[idx_gh + 1];
+    }
+  }
+}
+#endif  // defined(XGBOOST_HIST_VEC_KERNELS_PRESENT)
+
+/*!
+ * \brief Try the explicitly vectorized dense kernel; returns false when the
+ *        running CPU or the block shape does not qualify so that the caller
+ *        falls back to the scalar kernel.
+ */
+template<bool do_prefetch, typename BinIdxType>
+bool TryBuildHistDenseVecKernel(const std::vector<GradientPair>& gpair,
+                                const RowSetCollection::Elem row_indices,
+                                const GHistIndexMatrix& gmat,
+                                const size_t n_features,
+                                GHistRow<double> hist) {
+#if defined(XGBOOST_HIST_VEC_KERNELS_PRESENT)
+  constexpr size_t kMinVecFeatures = 8;  // too few features: remainder loop dominates
+  if (n_features < kMinVecFeatures) {
+    return false;
+  }
+  switch (DetectSimdLevel()) {
+    case SimdLevel::kAvx512:
+      BuildHistDenseKernelAvx512<do_prefetch, BinIdxType>(gpair, row_indices,
+                                                          gmat, n_features, hist);
+      return true;
+    case SimdLevel::kAvx2:
+      BuildHistDenseKernelAvx2<do_prefetch, BinIdxType>(gpair, row_indices,
+                                                        gmat, n_features, hist);
+      return true;
+    case SimdLevel::kNone:
+      return false;
+  }
+#else
+  (void)gpair; (void)row_indices; (void)gmat; (void)n_features; (void)hist;
+#endif  // defined(XGBOOST_HIST_VEC_KERNELS_PRESENT)
+  return false;
+}
+
+// single precision histograms accumulate in float; keep them on the scalar path
+template<bool do_prefetch, typename BinIdxType>
+bool TryBuildHistDenseVecKernel(const std::vector<GradientPair>&,
+                                const RowSetCollection::Elem,
+                                const GHistIndexMatrix&,
+                                const size_t,
+                                GHistRow<float>) {
+  return false;
+}
+
 template<typename FPType, bool do_prefetch, typename BinIdxType>
-void BuildHistDispatchKernel(const std::vector<GradientPair>& gpair,
-                     const RowSetCollection::Elem row_indices,
-                     const GHistIndexMatrix& gmat, GHistRow<FPType> hist, bool isDense) {
-  if (isDense) {
-    const size_t* row_ptr =  gmat.row_ptr.data();
-    const size_t n_features = row_ptr[row_indices.begin[0]+1] - row_ptr[row_indices.begin[0]];
+void BuildHistDenseQuantizedKernel(const QuantizedGradients& gpair,
+                                   const RowSetCollection::Elem row_indices,
+                                   const GHistIndexMatrix& gmat,
+                                   const size_t n_features,
+                                   GHistRow<FPType> hist) {
+  const size_t size = row_indices.Size();
+  const size_t* rid = row_indices.begin;
+  const size_t prefetch_offset = do_prefetch ? Prefetch::Offset() : 0;
+  const int16_t* pgh = gpair.Data();
+  const FPType scale = static_cast<FPType>(gpair.Scale());
+  const BinIdxType* gradient_index = gmat.index.data<BinIdxType>();
+  const uint32_t* offsets = gmat.index.Offset();
+  FPType* hist_data = reinterpret_cast<FPType*>(hist.data());
+  const uint32_t two {2};
+
+  for (size_t i = 0; i < size; ++i) {
+    const size_t icol_start = rid[i] * n_features;
+    const size_t idx_gh = two * rid[i];
+
+    if (do_prefetch) {
+      const size_t icol_start_prefetch = rid[i + prefetch_offset] * n_features;
+
+      PREFETCH_READ_T0(pgh + two * rid[i + prefetch_offset]);
+      for (size_t j = icol_start_prefetch; j < icol_start_prefetch + n_features;
+           j += Prefetch::GetPrefetchStep<BinIdxType>()) {
+        PREFETCH_READ_T0(gradient_index + j);
+      }
+    }
+    const BinIdxType* gr_index_local = gradient_index + icol_start;
+    const FPType grad = scale * static_cast<FPType>(pgh[idx_gh]);
+    const FPType hess = scale * static_cast<FPType>(pgh[idx_gh + 1]);
+    for (size_t j = 0; j < n_features; ++j) {
+      const uint32_t idx_bin = two * (static_cast<uint32_t>(gr_index_local[j]) +
+                                      offsets[j]);
+      hist_data[idx_bin]   += grad;
+      hist_data[idx_bin+1] += hess;
+    }
+  }
+}
+
+template<typename FPType, bool do_prefetch>
+void BuildHistSparseQuantizedKernel(const QuantizedGradients& gpair,
+                                    const RowSetCollection::Elem row_indices,
+                                    const GHistIndexMatrix& gmat,
+                                    GHistRow<FPType> hist) {
+  const size_t size = row_indices.Size();
+  const size_t* rid = row_indices.begin;
+  const size_t prefetch_offset = do_prefetch ? Prefetch::Offset() : 0;
+  const int16_t* pgh = gpair.Data();
+  const FPType scale = static_cast<FPType>(gpair.Scale());
+  const uint32_t* gradient_index = gmat.index.data<uint32_t>();
+  const size_t* row_ptr =  gmat.row_ptr.data();
+  FPType* hist_data = reinterpret_cast<FPType*>(hist.data());
+  const uint32_t two {2};
+
+  for (size_t i = 0; i < size; ++i) {
+    const size_t icol_start = row_ptr[rid[i]];
+    const size_t icol_end = row_ptr[rid[i]+1];
+    const size_t idx_gh = two * rid[i];
+
+    if (do_prefetch) {
+      // two-stage pipeline, see BuildHistSparseKernel
+      const size_t far_rid = rid[i + 2 * prefetch_offset];
+      PREFETCH_READ_T0(row_ptr + far_rid);
+      PREFETCH_READ_T0(pgh + two * far_rid);
+
+      const size_t icol_start_prftch = row_ptr[rid[i+prefetch_offset]];
+      const size_t icol_end_prefect = row_ptr[rid[i+prefetch_offset]+1];
+
+      for (size_t j = icol_start_prftch; j < icol_end_prefect;
+        j+=Prefetch::GetPrefetchStep<uint32_t>()) {
+        PREFETCH_READ_T0(gradient_index + j);
+      }
+    }
+    const FPType grad = scale * static_cast<FPType>(pgh[idx_gh]);
+    const FPType hess = scale * static_cast<FPType>(pgh[idx_gh + 1]);
+    for (size_t j = icol_start; j < icol_end; ++j) {
+      const uint32_t idx_bin = two * gradient_index[j];
+      hist_data[idx_bin]   += grad;
+      hist_data[idx_bin+1] += hess;
+    }
+  }
+}
+
+/*!
+ * \brief One entry of the BuildHist kernel instantiation matrix.
+ *
+ * Every combination of {uint8/16/32 bins} x {dense/sparse} is compiled as a
+ * separate kernel with the prefetching and non-prefetching flavors side by
+ * side, so the inner loops carry none of the dispatch conditionals.  The
+ * matrix is a static table indexed by the properties of the gradient index
+ * matrix, turning the old nested switch-and-branch dispatch into one lookup.
+ */
+template <typename FPType>
+struct BuildHistDispatch {
+  using KernelFn = void (*)(const std::vector<GradientPair>&,
+                            const RowSetCollection::Elem,
+                            const GHistIndexMatrix&, GHistRow<FPType>);
+  using QuantizedKernelFn = void (*)(const QuantizedGradients&,
+                                     const RowSetCollection::Elem,
+                                     const GHistIndexMatrix&, GHistRow<FPType>);
+  KernelFn prefetch;
+  KernelFn no_prefetch;
+  QuantizedKernelFn quantized_prefetch;
+  QuantizedKernelFn quantized_no_prefetch;
+};
+
+template <typename FPType, bool do_prefetch, typename BinIdxType, bool kIsDense>
+void BuildHistMatrixEntry(const std::vector<GradientPair>& gpair,
+                          const RowSetCollection::Elem row_indices,
+                          const GHistIndexMatrix& gmat, GHistRow<FPType> hist) {
+  if (kIsDense) {
+    // uniform per-row entry count; one-based dense data keeps row_ptr but
+    // still stores the same number of entries in every row
+    const size_t n_features = gmat.RowSize(row_indices.begin[0]);
+    if (TryBuildHistDenseVecKernel<do_prefetch, BinIdxType>(gpair, row_indices,
+                                                            gmat, n_features, hist)) {
+      return;
+    }
     BuildHistDenseKernel<FPType, do_prefetch, BinIdxType>(gpair, row_indices,
-                                                       gmat, n_features, hist);
+                                                          gmat, n_features, hist);
   } else {
-    BuildHistSparseKernel<FPType, do_prefetch>(gpair, row_indices,
+    BuildHistSparseKernel<FPType, do_prefetch>(gpair, row_indices, gmat, hist);
+  }
+}
+
+template <typename FPType, bool do_prefetch, typename BinIdxType, bool kIsDense>
+void BuildHistQuantizedMatrixEntry(const QuantizedGradients& gpair,
+                                   const RowSetCollection::Elem row_indices,
+                                   const GHistIndexMatrix& gmat,
+                                   GHistRow<FPType> hist) {
+  if (kIsDense) {
+    const size_t n_features = gmat.RowSize(row_indices.begin[0]);
+    BuildHistDenseQuantizedKernel<FPType, do_prefetch, BinIdxType>(
+        gpair, row_indices, gmat, n_features, hist);
+  } else {
+    BuildHistSparseQuantizedKernel<FPType, do_prefetch>(gpair, row_indices,
                                                         gmat, hist);
   }
 }
 
+template <typename FPType, typename BinIdxType, bool kIsDense>
+BuildHistDispatch<FPType> MakeBuildHistDispatch() {
+  return {&BuildHistMatrixEntry<FPType, true, BinIdxType, kIsDense>,
+          &BuildHistMatrixEntry<FPType, false, BinIdxType, kIsDense>,
+          &BuildHistQuantizedMatrixEntry<FPType, true, BinIdxType, kIsDense>,
+          &BuildHistQuantizedMatrixEntry<FPType, false, BinIdxType, kIsDense>};
+}
+
+template <typename FPType>
+BuildHistDispatch<FPType> const& LookupBuildHistDispatch(
+    const GHistIndexMatrix& gmat, bool is_dense) {
+  // rows are the bin widths, columns sparse/dense
+  static const BuildHistDispatch<FPType> kMatrix[3][2] = {
+      {MakeBuildHistDispatch<FPType, uint8_t, false>(),
+       MakeBuildHistDispatch<FPType, uint8_t, true>()},
+      {MakeBuildHistDispatch<FPType, uint16_t, false>(),
+       MakeBuildHistDispatch<FPType, uint16_t, true>()},
+      {MakeBuildHistDispatch<FPType, uint32_t, false>(),
+       MakeBuildHistDispatch<FPType, uint32_t, true>()}};
+  size_t bin_idx = 0;
+  switch (gmat.index.GetBinTypeSize()) {
+    case kUint8BinsTypeSize: bin_idx = 0; break;
+    case kUint16BinsTypeSize: bin_idx = 1; break;
+    case kUint32BinsTypeSize: bin_idx = 2; break;
+    default: CHECK(false);  // no default behavior
+  }
+  return kMatrix[bin_idx][is_dense];
+}
+
+template <typename GradientSumT>
+void GHistBuilder<GradientSumT>::BuildHist(
+    const std::vector<GradientPair> &gpair,
+    const RowSetCollection::Elem row_indices, const GHistIndexMatrix &gmat,
+    GHistRowT hist, bool isDense) {
+  const size_t nrows = row_indices.Size();
+  if (nrows == 0) {
+    return;
+  }
+  auto const& kernels = LookupBuildHistDispatch<GradientSumT>(gmat, isDense);
+  const size_t no_prefetch_size = Prefetch::NoPrefetchSize(nrows);
+
+  // if need to work with all rows from bin-matrix (e.g. root node)
+  const bool contiguousBlock = (row_indices.begin[nrows - 1] - row_indices.begin[0]) == (nrows - 1);
+
+  if (contiguousBlock) {
+    // contiguous memory access, built-in HW prefetching is enough
+    kernels.no_prefetch(gpair, row_indices, gmat, hist);
+  } else {
+    const RowSetCollection::Elem span1(row_indices.begin, row_indices.end - no_prefetch_size);
+    const RowSetCollection::Elem span2(row_indices.end - no_prefetch_size, row_indices.end);
+
+    kernels.prefetch(gpair, span1, gmat, hist);
+    // no prefetching to avoid loading extra memory
+    kernels.no_prefetch(gpair, span2, gmat, hist);
+  }
+}
+template
+void GHistBuilder<float>::BuildHist(const std::vector<GradientPair>& gpair,
+                             const RowSetCollection::Elem row_indices,
+                             const GHistIndexMatrix& gmat,
+                             GHistRow<float> hist,
+                             bool isDense);
+template
+void GHistBuilder<double>::BuildHist(const std::vector<GradientPair>& gpair,
+                             const RowSetCollection::Elem row_indices,
+                             const GHistIndexMatrix& gmat,
+                             GHistRow<double> hist,
+                             bool isDense);
+
+template<typename FPType, bool do_prefetch, typename BinIdxType>
+void BuildHistDenseColumnsKernel(const std::vector<GradientPair>& gpair,
+                                 const RowSetCollection::Elem row_indices,
+                                 const GHistIndexMatrix& gmat,
+                                 const size_t n_features,
+                                 const size_t f_begin, const size_t f_end,
+                                 GHistRow<FPType> hist) {
+  const size_t size = row_indices.Size();
+  const size_t* rid = row_indices.begin;
+  const size_t prefetch_offset = do_prefetch ? Prefetch::Offset() : 0;
+  const float* pgh = reinterpret_cast<const float*>(gpair.data());
+  const BinIdxType* gradient_index = gmat.index.data<BinIdxType>();
+  const uint32_t* offsets = gmat.index.Offset();
+  FPType* hist_data = reinterpret_cast<FPType*>(hist.data());
+  const uint32_t two {2};  // each 'gpair'/'hist' element holds two FP values
+
+  for (size_t i = 0; i < size; ++i) {
+    const size_t icol_start = rid[i] * n_features;
+    const size_t idx_gh = two * rid[i];
+
+    if (do_prefetch) {
+      const size_t icol_start_prefetch = rid[i + prefetch_offset] * n_features;
+
+      PREFETCH_READ_T0(pgh + two * rid[i + prefetch_offset]);
+      for (size_t j = icol_start_prefetch + f_begin; j < icol_start_prefetch + f_end;
+           j += Prefetch::GetPrefetchStep<BinIdxType>()) {
+        PREFETCH_READ_T0(gradient_index + j);
+      }
+    }
+    const BinIdxType* gr_index_local = gradient_index + icol_start;
+    for (size_t j = f_begin; j < f_end; ++j) {
+      const uint32_t idx_bin = two * (static_cast<uint32_t>(gr_index_local[j]) +
+                                      offsets[j]);
+
+      hist_data[idx_bin]   += pgh[idx_gh];
+      hist_data[idx_bin+1] += pgh[idx_gh+1];
+    }
+  }
+}
+
 template<typename FPType, bool do_prefetch>
-void BuildHistKernel(const std::vector<GradientPair>& gpair,
-                     const RowSetCollection::Elem row_indices,
-                     const GHistIndexMatrix& gmat, const bool isDense, GHistRow<FPType> hist) {
-  const bool is_dense = row_indices.Size() && isDense;
+void BuildHistColumnsKernel(const std::vector<GradientPair>& gpair,
+                            const RowSetCollection::Elem row_indices,
+                            const GHistIndexMatrix& gmat,
+                            const size_t n_features,
+                            const size_t f_begin, const size_t f_end,
+                            GHistRow<FPType> hist) {
   switch (gmat.index.GetBinTypeSize()) {
     case kUint8BinsTypeSize:
-      BuildHistDispatchKernel<FPType, do_prefetch, uint8_t>(gpair, row_indices,
-                                                            gmat, hist, is_dense);
+      BuildHistDenseColumnsKernel<FPType, do_prefetch, uint8_t>(
+          gpair, row_indices, gmat, n_features, f_begin, f_end, hist);
       break;
     case kUint16BinsTypeSize:
-      BuildHistDispatchKernel<FPType, do_prefetch, uint16_t>(gpair, row_indices,
-                                                             gmat, hist, is_dense);
+      BuildHistDenseColumnsKernel<FPType, do_prefetch, uint16_t>(
+          gpair, row_indices, gmat, n_features, f_begin, f_end, hist);
       break;
     case kUint32BinsTypeSize:
-      BuildHistDispatchKernel<FPType, do_prefetch, uint32_t>(gpair, row_indices,
-                                                             gmat, hist, is_dense);
+      BuildHistDenseColumnsKernel<FPType, do_prefetch, uint32_t>(
+          gpair, row_indices, gmat, n_features, f_begin, f_end, hist);
       break;
     default:
       CHECK(false);  // no default behavior
@@ -660,11 +1495,58 @@ void BuildHistKernel(const std::vector<GradientPair>& gpair,
 }
 
 template <typename GradientSumT>
-void GHistBuilder<GradientSumT>::BuildHist(
+void GHistBuilder<GradientSumT>::BuildHistColumns(
     const std::vector<GradientPair> &gpair,
     const RowSetCollection::Elem row_indices, const GHistIndexMatrix &gmat,
+    size_t f_begin, size_t f_end, GHistRowT hist) {
+  const size_t nrows = row_indices.Size();
+  if (nrows == 0) {
+    return;
+  }
+  const size_t no_prefetch_size = Prefetch::NoPrefetchSize(nrows);
+  const size_t n_features = gmat.RowSize(row_indices.begin[0]);
+
+  // if need to work with all rows from bin-matrix (e.g. root node)
+  const bool contiguousBlock = (row_indices.begin[nrows - 1] - row_indices.begin[0]) == (nrows - 1);
+
+  if (contiguousBlock) {
+    // contiguous memory access, built-in HW prefetching is enough
+    BuildHistColumnsKernel<GradientSumT, false>(gpair, row_indices, gmat,
+                                                n_features, f_begin, f_end, hist);
+  } else {
+    const RowSetCollection::Elem span1(row_indices.begin, row_indices.end - no_prefetch_size);
+    const RowSetCollection::Elem span2(row_indices.end - no_prefetch_size, row_indices.end);
+
+    BuildHistColumnsKernel<GradientSumT, true>(gpair, span1, gmat,
+                                               n_features, f_begin, f_end, hist);
+    // no prefetching to avoid loading extra memory
+    BuildHistColumnsKernel<GradientSumT, false>(gpair, span2, gmat,
+                                                n_features, f_begin, f_end, hist);
+  }
+}
+template
+void GHistBuilder<float>::BuildHistColumns(const std::vector<GradientPair>& gpair,
+                             const RowSetCollection::Elem row_indices,
+                             const GHistIndexMatrix& gmat,
+                             size_t f_begin, size_t f_end,
+                             GHistRow<float> hist);
+template
+void GHistBuilder<double>::BuildHistColumns(const std::vector<GradientPair>& gpair,
+                             const RowSetCollection::Elem row_indices,
+                             const GHistIndexMatrix& gmat,
+                             size_t f_begin, size_t f_end,
+                             GHistRow<double> hist);
+
+template <typename GradientSumT>
+void GHistBuilder<GradientSumT>::BuildHistQuantized(
+    const QuantizedGradients &gpair,
+    const RowSetCollection::Elem row_indices, const GHistIndexMatrix &gmat,
     GHistRowT hist, bool isDense) {
   const size_t nrows = row_indices.Size();
+  if (nrows == 0) {
+    return;
+  }
+  auto const& kernels = LookupBuildHistDispatch<GradientSumT>(gmat, isDense);
   const size_t no_prefetch_size = Prefetch::NoPrefetchSize(nrows);
 
   // if need to work with all rows from bin-matrix (e.g. root node)
@@ -672,24 +1554,24 @@ void GHistBuilder<GradientSumT>::BuildHist(
 
   if (contiguousBlock) {
     // contiguous memory access, built-in HW prefetching is enough
-    BuildHistKernel<GradientSumT, false>(gpair, row_indices, gmat, isDense, hist);
+    kernels.quantized_no_prefetch(gpair, row_indices, gmat, hist);
   } else {
     const RowSetCollection::Elem span1(row_indices.begin, row_indices.end - no_prefetch_size);
     const RowSetCollection::Elem span2(row_indices.end - no_prefetch_size, row_indices.end);
 
-    BuildHistKernel<GradientSumT, true>(gpair, span1, gmat, isDense, hist);
+    kernels.quantized_prefetch(gpair, span1, gmat, hist);
     // no prefetching to avoid loading extra memory
-    BuildHistKernel<GradientSumT, false>(gpair, span2, gmat, isDense, hist);
+    kernels.quantized_no_prefetch(gpair, span2, gmat, hist);
   }
 }
 template
-void GHistBuilder<float>::BuildHist(const std::vector<GradientPair>& gpair,
+void GHistBuilder<float>::BuildHistQuantized(const QuantizedGradients& gpair,
                              const RowSetCollection::Elem row_indices,
                              const GHistIndexMatrix& gmat,
                              GHistRow<float> hist,
                              bool isDense);
 template
-void GHistBuilder<double>::BuildHist(const std::vector<GradientPair>& gpair,
+void GHistBuilder<double>::BuildHistQuantized(const QuantizedGradients& gpair,
                              const RowSetCollection::Elem row_indices,
                              const GHistIndexMatrix& gmat,
                              GHistRow<double> hist,
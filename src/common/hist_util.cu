@@ -92,11 +92,15 @@ size_t RequiredMemory(bst_row_t num_rows, bst_feature_t num_columns, size_t nnz,
 size_t SketchBatchNumElements(size_t sketch_batch_num_elements,
                               bst_row_t num_rows, bst_feature_t columns,
                               size_t nnz, int device,
-                              size_t num_cuts, bool has_weight) {
+                              size_t num_cuts, bool has_weight,
+                              size_t memory_budget_bytes) {
   if (sketch_batch_num_elements == 0) {
     auto required_memory = RequiredMemory(num_rows, columns, nnz, num_cuts, has_weight);
     // use up to 80% of available space
-    auto avail = dh::AvailableMemory(device) * 0.8;
+    auto avail = static_cast<size_t>(dh::AvailableMemory(device) * 0.8);
+    if (memory_budget_bytes != 0) {
+      avail = std::min(avail, memory_budget_bytes);
+    }
     if (required_memory > avail) {
       sketch_batch_num_elements = avail / BytesPerElement(has_weight);
     } else {
@@ -283,7 +287,8 @@ void ProcessWeightedBatch(int device, const SparsePage& page,
 }
 
 HistogramCuts DeviceSketch(int device, DMatrix* dmat, int max_bins,
-                           size_t sketch_batch_num_elements) {
+                           size_t sketch_batch_num_elements,
+                           size_t memory_budget_bytes) {
   dmat->Info().feature_types.SetDevice(device);
   dmat->Info().feature_types.ConstDevicePointer();  // pull to device early
   // Configure batch size based on available memory
@@ -295,32 +300,92 @@ HistogramCuts DeviceSketch(int device, DMatrix* dmat, int max_bins,
       dmat->Info().num_row_,
       dmat->Info().num_col_,
       dmat->Info().num_nonzero_,
-      device, num_cuts_per_feature, has_weights);
+      device, num_cuts_per_feature, has_weights, memory_budget_bytes);
 
   HistogramCuts cuts;
   SketchContainer sketch_container(dmat->Info().feature_types, max_bins, dmat->Info().num_col_,
                                    dmat->Info().num_row_, device);
 
+  // With an explicit memory ceiling each window is sketched into its own
+  // container whose pruned summary is spilled to pinned host memory, so the
+  // device never holds more than one window of raw entries plus one summary at
+  // a time.  The spilled summaries are merged back below.
+  bool const spill_to_host = memory_budget_bytes != 0;
+  size_t const intermediate_num_cuts =
+      std::min(static_cast<size_t>(dmat->Info().num_row_),
+               static_cast<size_t>(max_bins * SketchContainer::kFactor));
+  std::vector<std::unique_ptr<dh::PinnedMemory>> spilled_entries;
+  std::vector<std::vector<SketchContainer::OffsetT>> spilled_columns_ptr;
+
   dmat->Info().weights_.SetDevice(device);
   for (const auto& batch : dmat->GetBatches<SparsePage>()) {
     size_t batch_nnz = batch.data.Size();
     auto const& info = dmat->Info();
     for (auto begin = 0ull; begin < batch_nnz; begin += sketch_batch_num_elements) {
       size_t end = std::min(batch_nnz, size_t(begin + sketch_batch_num_elements));
+      std::unique_ptr<SketchContainer> window_container;
+      SketchContainer* p_container = &sketch_container;
+      if (spill_to_host) {
+        window_container = std::make_unique<SketchContainer>(
+            dmat->Info().feature_types, max_bins, dmat->Info().num_col_,
+            dmat->Info().num_row_, device);
+        p_container = window_container.get();
+      }
       if (has_weights) {
         bool is_ranking = HostSketchContainer::UseGroup(dmat->Info());
         dh::caching_device_vector<uint32_t> groups(info.group_ptr_.cbegin(),
                                                    info.group_ptr_.cend());
         ProcessWeightedBatch(
             device, batch, dmat->Info(), begin, end,
-            &sketch_container,
+            p_container,
             num_cuts_per_feature,
             dmat->Info().num_col_,
             is_ranking, dh::ToSpan(groups));
       } else {
-        ProcessBatch(device, dmat->Info(), batch, begin, end, &sketch_container,
+        ProcessBatch(device, dmat->Info(), batch, begin, end, p_container,
                      num_cuts_per_feature, dmat->Info().num_col_);
       }
+      if (spill_to_host) {
+        window_container->Prune(intermediate_num_cuts);
+        auto d_entries = window_container->Data();
+        spilled_entries.emplace_back(new dh::PinnedMemory);
+        auto h_entries =
+            spilled_entries.back()->GetSpan<SketchEntry>(d_entries.size());
+        dh::safe_cuda(cudaMemcpy(h_entries.data(), d_entries.data(),
+                                 d_entries.size_bytes(),
+                                 cudaMemcpyDeviceToHost));
+        auto d_columns_ptr = window_container->ColumnsPtr();
+        spilled_columns_ptr.emplace_back(d_columns_ptr.size());
+        dh::safe_cuda(cudaMemcpy(spilled_columns_ptr.back().data(),
+                                 d_columns_ptr.data(),
+                                 d_columns_ptr.size_bytes(),
+                                 cudaMemcpyDeviceToHost));
+      }
+    }
+  }
+
+  if (spill_to_host) {
+    // Merge the spilled window summaries back one at a time, mirroring the
+    // merge loop in SketchContainer::AllReduce.
+    dh::device_vector<SketchEntry> d_entries;
+    dh::device_vector<SketchContainer::OffsetT> d_columns_ptr;
+    for (size_t i = 0; i < spilled_columns_ptr.size(); ++i) {
+      auto const& h_columns_ptr = spilled_columns_ptr[i];
+      size_t n_entries = h_columns_ptr.back();
+      d_entries.resize(n_entries);
+      auto h_entries = spilled_entries[i]->GetSpan<SketchEntry>(n_entries);
+      dh::safe_cuda(cudaMemcpy(d_entries.data().get(), h_entries.data(),
+                               n_entries * sizeof(SketchEntry),
+                               cudaMemcpyHostToDevice));
+      d_columns_ptr.resize(h_columns_ptr.size());
+      dh::safe_cuda(cudaMemcpy(
+          d_columns_ptr.data().get(), h_columns_ptr.data(),
+          h_columns_ptr.size() * sizeof(SketchContainer::OffsetT),
+          cudaMemcpyHostToDevice));
+      sketch_container.Merge(dh::ToSpan(d_columns_ptr), dh::ToSpan(d_entries));
+      sketch_container.FixError();
+      sketch_container.Prune(intermediate_num_cuts);
+      spilled_entries[i].reset();  // release the pinned buffer early
     }
   }
   sketch_container.MakeCuts(&cuts);
@@ -66,12 +66,14 @@ inline size_t constexpr BytesPerElement(bool has_weight) {
 }
 
 /* \brief Calcuate the length of sliding window. Returns `sketch_batch_num_elements`
- *        directly if it's not 0.
+ *        directly if it's not 0.  A non-zero `memory_budget_bytes` caps the
+ *        window at an explicit ceiling instead of 80% of free device memory.
  */
 size_t SketchBatchNumElements(size_t sketch_batch_num_elements,
                               bst_row_t num_rows, bst_feature_t columns,
                               size_t nnz, int device,
-                              size_t num_cuts, bool has_weight);
+                              size_t num_cuts, bool has_weight,
+                              size_t memory_budget_bytes = 0);
 
 // Compute number of sample cuts needed on local node to maintain accuracy
 // We take more cuts than needed and then reduce them later
@@ -129,8 +131,13 @@ void SortByWeight(dh::device_vector<float>* weights,
 
 // Compute sketch on DMatrix.
 // sketch_batch_num_elements 0 means autodetect. Only modify this for testing.
+// memory_budget_bytes 0 means size windows from free device memory; a non-zero
+// budget bounds device usage by spilling per-window summaries to pinned host
+// memory and merging them back one at a time, so sketching cannot OOM next to
+// other resident data such as an EllpackPage.
 HistogramCuts DeviceSketch(int device, DMatrix* dmat, int max_bins,
-                           size_t sketch_batch_num_elements = 0);
+                           size_t sketch_batch_num_elements = 0,
+                           size_t memory_budget_bytes = 0);
 
 template <typename AdapterBatch>
 void ProcessSlidingWindow(AdapterBatch const& batch, int device, size_t columns,
@@ -9,15 +9,16 @@
 
 #include <xgboost/data.h>
 #include <xgboost/generic_parameters.h>
+#include <atomic>
 #include <limits>
 #include <vector>
 #include <algorithm>
 #include <memory>
 #include <utility>
-#include <map>
 
 #include "row_set.h"
 #include "common.h"
+#include "memory_stats.h"
 #include "threading_utils.h"
 #include "../tree/param.h"
 #include "./quantile.h"
@@ -106,9 +107,54 @@ class HistogramCuts {
   BinIdx SearchBin(Entry const& e) const {
     return SearchBin(e.fvalue, e.index);
   }
+
+  // Assign bins for a block of entries at once.  The lanes run a branchless
+  // binary search in lockstep, so the cut-array loads of different lanes
+  // overlap instead of each element serializing behind its own
+  // compare-and-branch chain; quantization is bound by exactly that chain.
+  void SearchBinBlock(Entry const* entries, size_t n, BinIdx* out) const {
+    auto const& ptrs = cut_ptrs_.ConstHostVector();
+    float const* values = cut_values_.ConstHostVector().data();
+    constexpr size_t kLanes = 8;
+    size_t i = 0;
+    for (; i + kLanes <= n; i += kLanes) {
+      float const* base[kLanes];
+      uint32_t count[kLanes];
+      uint32_t end[kLanes];
+      float v[kLanes];
+      uint32_t max_count = 0;
+      for (size_t k = 0; k < kLanes; ++k) {
+        auto const column = entries[i + k].index;
+        auto const beg = ptrs[column];
+        end[k] = ptrs[column + 1];
+        base[k] = values + beg;
+        count[k] = end[k] - beg;
+        v[k] = entries[i + k].fvalue;
+        max_count = std::max(max_count, count[k]);
+      }
+      while (max_count > 1) {
+        for (size_t k = 0; k < kLanes; ++k) {
+          uint32_t const half = count[k] >> 1;
+          // lanes that already narrowed to one cut keep half == 0 and idle
+          base[k] += (half != 0 && base[k][half - 1] <= v[k]) ? half : 0;
+          count[k] -= half;
+        }
+        max_count -= max_count >> 1;
+      }
+      for (size_t k = 0; k < kLanes; ++k) {
+        auto idx = static_cast<BinIdx>(base[k] - values) +
+                   static_cast<BinIdx>(base[k][0] <= v[k]);
+        out[i + k] = idx == end[k] ? idx - 1 : idx;
+      }
+    }
+    for (; i < n; ++i) {
+      out[i] = SearchBin(entries[i]);
+    }
+  }
 };
 
-inline HistogramCuts SketchOnDMatrix(DMatrix *m, int32_t max_bins) {
+inline HistogramCuts SketchOnDMatrix(DMatrix *m, int32_t max_bins,
+                                     common::Span<float const> hessian = {}) {
   HistogramCuts out;
   auto const& info = m->Info();
   const auto threads = omp_get_max_threads();
@@ -127,12 +173,63 @@ inline HistogramCuts SketchOnDMatrix(DMatrix *m, int32_t max_bins) {
   HostSketchContainer container(reduced, max_bins,
                                 HostSketchContainer::UseGroup(info));
   for (auto const &page : m->GetBatches<SparsePage>()) {
-    container.PushRowPage(page, info);
+    container.PushRowPage(page, info, hessian);
   }
   container.MakeCuts(&out);
   return out;
 }
 
+/*!
+ * \brief Exclusive feature bundling (EFB).  Groups sparse features that are
+ *  (almost) never non-zero on the same row into shared bundles, so that e.g.
+ *  thousands of mutually exclusive one-hot columns collapse into a handful of
+ *  effective features.  Every original feature owns a disjoint value range
+ *  inside its bundle, which keeps the inverse mapping exact: a split found on
+ *  a bundled column can always be reported on the original feature.
+ */
+struct ExclusiveFeatureBundles {
+  /*! \brief bundle each original feature was assigned to */
+  std::vector<bst_feature_t> feature_to_bundle;
+  /*! \brief original features of each bundle, in increasing offset order */
+  std::vector<std::vector<bst_feature_t>> bundles;
+  /*! \brief value offset of each original feature inside its bundle */
+  std::vector<double> feature_offsets;
+  /*! \brief smallest non-zero value of each original feature */
+  std::vector<float> feature_min;
+
+  size_t NumBundles() const { return bundles.size(); }
+  /*!
+   * \brief Map a split on a bundled column back to the original feature for
+   *  RegTree split reporting.
+   *
+   * \param bundled_fid  column index in the bundled matrix
+   * \param split_value  split condition found on the bundled column
+   * \param out_value    split condition expressed on the original feature
+   * \return the original feature index
+   */
+  bst_feature_t OriginalSplit(bst_feature_t bundled_fid, bst_float split_value,
+                              bst_float* out_value) const;
+};
+
+/*!
+ * \brief Greedily compute exclusive feature bundles over the columns of a
+ *  DMatrix, tolerating a bounded number of conflicting rows per bundle.
+ *
+ * \param m                 the input matrix
+ * \param max_conflict_rate fraction of rows on which the features of a bundle
+ *                          may overlap; 0 demands strict exclusiveness
+ */
+ExclusiveFeatureBundles MakeExclusiveFeatureBundles(DMatrix* m,
+                                                    double max_conflict_rate);
+
+/*!
+ * \brief Materialize the bundled matrix: entries are shifted into the value
+ *  range their feature owns inside its bundle, and on the rare conflicting
+ *  rows only the first entry of a bundle is kept.
+ */
+std::shared_ptr<DMatrix> ApplyExclusiveFeatureBundles(
+    DMatrix* m, ExclusiveFeatureBundles const& efb);
+
 enum BinTypeSize {
   kUint8BinsTypeSize  = 1,
   kUint16BinsTypeSize = 2,
@@ -228,13 +325,15 @@ struct Index {
 
 
 /*!
- * \brief preprocessed global index matrix, in CSR format
+ * \brief preprocessed global index matrix, in CSR format for sparse data;
+ *  dense data drops the row offsets and addresses rows by an implicit stride
  *
  *  Transform floating values to integer index in histogram This is a global histogram
  *  index for CPU histogram.  On GPU ellpack page is used.
  */
 struct GHistIndexMatrix {
-  /*! \brief row pointer to rows by element position */
+  /*! \brief row pointer to rows by element position; left empty for a dense
+   *  matrix, which uses the implicit stride RowStride() instead */
   std::vector<size_t> row_ptr;
   /*! \brief The index data */
   Index index;
@@ -243,9 +342,24 @@ struct GHistIndexMatrix {
   /*! \brief The corresponding cuts */
   HistogramCuts cut;
   DMatrix* p_fmat;
+  /*! \brief largest realized number of bins over all features, bounds the index width */
   size_t max_num_bins;
   // Create a global histogram matrix, given cut
-  void Init(DMatrix* p_fmat, int max_num_bins);
+  /*!
+   * \brief Build the quantized index from a DMatrix.
+   * \param hessian Optional per-row hessian values used as sketch weights in
+   *   place of the sample weights, for hessian-weighted cut refreshes.
+   */
+  void Init(DMatrix* p_fmat, int max_num_bins,
+            common::Span<float const> hessian = {});
+
+  /*! \brief Build the index by streaming a text parser instead of walking an
+   *  in-memory DMatrix.  The parser is scanned three times: a counting pass
+   *  for shapes, column sizes and metadata, a sketching pass, and a
+   *  quantization pass writing straight into the compressed index.  Only one
+   *  parser block is resident at a time, so the float CSR page is never
+   *  materialized. */
+  void Init(dmlc::Parser<uint32_t>* parser, MetaInfo* info, int max_num_bins);
 
   // specific method for sparse data as no posibility to reduce allocated memory
   template <typename BinIdxType, typename GetOffset>
@@ -260,15 +374,21 @@ struct GHistIndexMatrix {
 #pragma omp parallel for num_threads(batch_threads) schedule(static)
     for (omp_ulong i = 0; i < batch_size; ++i) {
       const int tid = omp_get_thread_num();
-      size_t ibegin = row_ptr[rbegin + i];
-      size_t iend = row_ptr[rbegin + i + 1];
+      size_t ibegin = RowBegin(rbegin + i);
+      size_t iend = RowEnd(rbegin + i);
       const size_t size = offset_vec[i + 1] - offset_vec[i];
       SparsePage::Inst inst = {data_ptr + offset_vec[i], size};
       CHECK_EQ(ibegin + inst.size(), iend);
-      for (bst_uint j = 0; j < inst.size(); ++j) {
-        uint32_t idx = cut.SearchBin(inst[j]);
-        index_data[ibegin + j] = get_offset(idx, j);
-        ++hit_count_tloc_[tid * nbins + idx];
+      constexpr bst_uint kBlock = 64;
+      uint32_t bins[kBlock];
+      for (bst_uint j0 = 0; j0 < inst.size(); j0 += kBlock) {
+        bst_uint const len = std::min(kBlock, static_cast<bst_uint>(inst.size() - j0));
+        cut.SearchBinBlock(inst.data() + j0, len, bins);
+        for (bst_uint k = 0; k < len; ++k) {
+          uint32_t const idx = bins[k];
+          index_data[ibegin + j0 + k] = get_offset(idx, j0 + k);
+          ++hit_count_tloc_[tid * nbins + idx];
+        }
       }
     }
   }
@@ -289,10 +409,41 @@ struct GHistIndexMatrix {
   inline bool IsDense() const {
     return isDense_;
   }
+  /*! \brief number of rows */
+  inline size_t Size() const {
+    return row_stride_ != 0 ? n_rows_
+                            : (row_ptr.empty() ? 0 : row_ptr.size() - 1);
+  }
+  /*! \brief position of the first entry of row ridx inside the index; valid
+   *  for ridx == Size() as well, where it gives the total entry count */
+  inline size_t RowBegin(size_t ridx) const {
+    return row_stride_ != 0 ? ridx * row_stride_ : row_ptr[ridx];
+  }
+  /*! \brief position past the last entry of row ridx */
+  inline size_t RowEnd(size_t ridx) const {
+    return RowBegin(ridx + 1);
+  }
+  /*! \brief number of entries stored for row ridx */
+  inline size_t RowSize(size_t ridx) const {
+    return RowEnd(ridx) - RowBegin(ridx);
+  }
+  /*! \brief entries per row of a dense matrix; 0 when row_ptr is in use */
+  inline size_t RowStride() const {
+    return row_stride_;
+  }
 
  private:
+  // Quantize one CSR batch into the index; row_ptr, the index storage and the
+  // cuts must already be sized.
+  void PushBatch(const SparsePage& batch, size_t rbegin, uint32_t nbins,
+                 size_t n_entries, int32_t nthread);
+
   std::vector<size_t> hit_count_tloc_;
   bool isDense_;
+  /*! \brief number of rows, tracked independently of row_ptr */
+  size_t n_rows_ {0};
+  /*! \brief implicit entries-per-row stride of a dense matrix, 0 for sparse */
+  size_t row_stride_ {0};
 };
 
 template <typename GradientIndex>
@@ -367,6 +518,29 @@ class GHistIndexBlockMatrix {
 template<typename GradientSumT>
 using GHistRow = Span<xgboost::detail::GradientPairInternal<GradientSumT> >;
 
+/*!
+ * \brief Per-iteration gradient pairs rescaled to int16 with one shared
+ *        power-of-two scale, halving the gradient traffic of BuildHist on
+ *        bandwidth-bound machines.  Histogram kernels multiply the shared
+ *        scale back in while accumulating, so sums stay in GradientSumT.
+ */
+class QuantizedGradients {
+ public:
+  /*! \brief quantize one iteration's gradients; scale is chosen from the
+   *         largest absolute gradient/hessian of the batch */
+  void Init(const std::vector<GradientPair>& gpair);
+
+  bool Empty() const { return data_.empty(); }
+  /*! \brief interleaved quantized (gradient, hessian) values */
+  const int16_t* Data() const { return data_.data(); }
+  /*! \brief multiply accumulated integers by this to recover float sums */
+  float Scale() const { return scale_; }
+
+ private:
+  std::vector<int16_t> data_;
+  float scale_ { 1.0f };
+};
+
 /*!
  * \brief fill a histogram by zeros
  */
@@ -424,15 +598,30 @@ class HistCollection {
     return (nid < row_ptr_.size() && row_ptr_[nid] != k_max);
   }
 
-  // initialize histogram collection
-  void Init(uint32_t nbins) {
+  ~HistCollection() {
+    MemoryStats::Instance().Free(
+        MemoryStats::kHistogram,
+        accounted_bytes_.exchange(0, std::memory_order_relaxed));
+  }
+
+  // initialize histogram collection.  When keep_rows is set and the bin count
+  // is unchanged, the node rows of the previous tree are retained so that a
+  // caller with identical partitions can reuse them instead of rebuilding.
+  void Init(uint32_t nbins, bool keep_rows = false) {
     if (nbins_ != nbins) {
       nbins_ = nbins;
       // quite expensive operation, so let's do this only once
       data_.clear();
+      MemoryStats::Instance().Free(
+          MemoryStats::kHistogram,
+          accounted_bytes_.exchange(0, std::memory_order_relaxed));
+      keep_rows = false;
+    }
+    if (!keep_rows) {
+      row_ptr_.clear();
+      free_slots_.clear();
+      n_nodes_added_ = 0;
     }
-    row_ptr_.clear();
-    n_nodes_added_ = 0;
   }
 
   // create an empty histogram for i-th node
@@ -447,13 +636,29 @@ class HistCollection {
       data_.resize((nid + 1));
     }
 
-    row_ptr_[nid] = n_nodes_added_;
-    n_nodes_added_++;
+    if (!free_slots_.empty()) {
+      row_ptr_[nid] = free_slots_.back();
+      free_slots_.pop_back();
+    } else {
+      row_ptr_[nid] = n_nodes_added_;
+      n_nodes_added_++;
+    }
+  }
+  // drop the histogram of i-th node; the slot is recycled by a later
+  // AddHistRow, mirroring how RegTree recycles deleted node ids
+  void RemoveHistRow(bst_uint nid) {
+    constexpr uint32_t kMax = std::numeric_limits<uint32_t>::max();
+    CHECK_LT(nid, row_ptr_.size());
+    CHECK_NE(row_ptr_[nid], kMax);
+    free_slots_.push_back(row_ptr_[nid]);
+    row_ptr_[nid] = kMax;
   }
   // allocate thread local memory i-th node
   void AllocateData(bst_uint nid) {
     if (data_[row_ptr_[nid]].size() == 0) {
       data_[row_ptr_[nid]].resize(nbins_, {0, 0});
+      // may run from several threads at once, so only this slot is inspected
+      Account(data_[row_ptr_[nid]].capacity() * sizeof(GradientPairT));
     }
   }
   // allocate common buffer contiguously for all nodes, need for single Allreduce call
@@ -461,11 +666,21 @@ class HistCollection {
     const size_t new_size = nbins_*data_.size();
     contiguous_allocation_ = true;
     if (data_[0].size() != new_size) {
+      const size_t old_capacity = data_[0].capacity();
       data_[0].resize(new_size);
+      if (data_[0].capacity() > old_capacity) {
+        Account((data_[0].capacity() - old_capacity) * sizeof(GradientPairT));
+      }
     }
   }
 
  private:
+  // charge newly acquired capacity to the histogram gauge
+  void Account(size_t bytes) {
+    MemoryStats::Instance().Allocate(MemoryStats::kHistogram, bytes);
+    accounted_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+  }
+
   /*! \brief number of all bins over all features */
   uint32_t nbins_ = 0;
   /*! \brief amount of active nodes in hist collection */
@@ -477,6 +692,10 @@ class HistCollection {
 
   /*! \brief row_ptr_[nid] locates bin for histogram of node nid */
   std::vector<size_t> row_ptr_;
+  /*! \brief slots of removed rows, recycled before growing the collection */
+  std::vector<size_t> free_slots_;
+  /*! \brief bytes currently charged to the MemoryStats gauge */
+  std::atomic<size_t> accounted_bytes_ {0};
 };
 
 /*!
@@ -498,10 +717,12 @@ class ParallelGHistBuilder {
 
   // Add new elements if needed, mark all hists as unused
   // targeted_hists - already allocated hists which should contain final results after Reduce() call
+  // any_thread_any_node - set when blocks may migrate between threads (work
+  // stealing), so every thread needs a buffer for every node it might touch
   void Reset(size_t nthreads, size_t nodes, const BlockedSpace2d& space,
-             const std::vector<GHistRowT>& targeted_hists) {
+             const std::vector<GHistRowT>& targeted_hists,
+             bool any_thread_any_node = false) {
     hist_buffer_.Init(nbins_);
-    tid_nid_to_hist_.clear();
     threads_to_nids_map_.clear();
 
     targeted_hists_ = targeted_hists;
@@ -511,12 +732,20 @@ class ParallelGHistBuilder {
     nodes_    = nodes;
     nthreads_ = nthreads;
 
-    MatchThreadsToNodes(space);
+    if (any_thread_any_node) {
+      threads_to_nids_map_.resize(nthreads_ * nodes_, true);
+    } else {
+      MatchThreadsToNodes(space);
+    }
     AllocateAdditionalHistograms();
     MatchNodeNidPairToHist();
 
-    hist_was_used_.resize(nthreads * nodes_);
-    std::fill(hist_was_used_.begin(), hist_was_used_.end(), static_cast<int>(false));
+    // bumping the epoch invalidates every used mark at once; the vector only
+    // grows when the frontier does and is never refilled
+    ++epoch_;
+    if (hist_used_epoch_.size() < nthreads_ * nodes_) {
+      hist_used_epoch_.resize(nthreads_ * nodes_, 0);
+    }
   }
 
   // Get specified hist, initialize hist by zeros if it wasn't used before
@@ -524,15 +753,15 @@ class ParallelGHistBuilder {
     CHECK_LT(nid, nodes_);
     CHECK_LT(tid, nthreads_);
 
-    int idx = tid_nid_to_hist_.at({tid, nid});
+    int idx = tid_nid_to_hist_[tid * nodes_ + nid];
     if (idx >= 0) {
       hist_buffer_.AllocateData(idx);
     }
     GHistRowT hist = idx == -1 ? targeted_hists_[nid] : hist_buffer_[idx];
 
-    if (!hist_was_used_[tid * nodes_ + nid]) {
+    if (hist_used_epoch_[tid * nodes_ + nid] != epoch_) {
       InitilizeHistByZeroes(hist, 0, hist.size());
-      hist_was_used_[tid * nodes_ + nid] = static_cast<int>(true);
+      hist_used_epoch_[tid * nodes_ + nid] = epoch_;
     }
 
     return hist;
@@ -547,10 +776,10 @@ class ParallelGHistBuilder {
 
     bool is_updated = false;
     for (size_t tid = 0; tid < nthreads_; ++tid) {
-      if (hist_was_used_[tid * nodes_ + nid]) {
+      if (hist_used_epoch_[tid * nodes_ + nid] == epoch_) {
         is_updated = true;
 
-        int idx = tid_nid_to_hist_.at({tid, nid});
+        int idx = tid_nid_to_hist_[tid * nodes_ + nid];
         GHistRowT src = idx == -1 ? targeted_hists_[nid] : hist_buffer_[idx];
 
         if (dst.data() != src.data()) {
@@ -565,6 +794,77 @@ class ParallelGHistBuilder {
     }
   }
 
+  /*!
+   * \brief Reduce all nodes over all bins with a tree-structured pairwise
+   * merge instead of the per-range sequential loop of ReduceHist.
+   *
+   * ReduceHist folds every per-thread copy into the target one after another,
+   * so each bin block costs O(nthreads) additions on a single thread and the
+   * merge stops scaling once nodes * blocks is smaller than the pool.  Here
+   * the copies are merged pairwise level by level, every (pair, bin block) of
+   * a level running in parallel, which cuts the critical path of a block to
+   * O(log2(nthreads)) additions.  The merge order is fixed by the thread to
+   * node assignment, so results are bitwise reproducible, though they can
+   * differ in the last ulp from the sequential order of ReduceHist.
+   */
+  void ReduceHistTree(size_t nthreads) {
+    // Contributing copies per node, the externally allocated target first so
+    // that the reduction finishes in place.
+    std::vector<std::vector<GHistRowT>> rows(nodes_);
+    std::vector<int> zero_dst(nodes_);
+    size_t max_rows = 0;
+    for (size_t nid = 0; nid < nodes_; ++nid) {
+      bool dst_used = false;
+      for (size_t tid = 0; tid < nthreads_; ++tid) {
+        if (hist_used_epoch_[tid * nodes_ + nid] != epoch_) {
+          continue;
+        }
+        int idx = tid_nid_to_hist_[tid * nodes_ + nid];
+        if (idx == -1) {
+          dst_used = true;
+        } else {
+          rows[nid].push_back(hist_buffer_[idx]);
+        }
+      }
+      rows[nid].insert(rows[nid].begin(), targeted_hists_[nid]);
+      // Targets are zeroed lazily on first use like any other copy; a target
+      // no thread touched - including empty nodes in distributed mode - still
+      // has to be cleared before it can absorb the others.
+      zero_dst[nid] = static_cast<int>(!dst_used);
+      max_rows = std::max(max_rows, rows[nid].size());
+    }
+
+    BlockedSpace2d zero_space(nodes_, [&](size_t nid) {
+      return zero_dst[nid] ? static_cast<size_t>(nbins_) : 0;
+    }, 1024);
+    ParallelFor2d(zero_space, nthreads, [&](size_t nid, Range1d r) {
+      InitilizeHistByZeroes(targeted_hists_[nid], r.begin(), r.end());
+    });
+
+    for (size_t stride = 1; stride < max_rows; stride *= 2) {
+      // pairs (i, i + stride) for i a multiple of 2 * stride, i + stride < n
+      auto num_pairs = [&](size_t nid) {
+        const size_t n = rows[nid].size();
+        return n > stride ? (n - stride - 1) / (2 * stride) + 1 : 0;
+      };
+      BlockedSpace2d space(nodes_, [&](size_t nid) {
+        return num_pairs(nid) * nbins_;
+      }, 1024);
+      ParallelFor2d(space, nthreads, [&](size_t nid, Range1d r) {
+        // a range can straddle pair boundaries; merge it piecewise
+        for (size_t i = r.begin(); i < r.end();) {
+          const size_t pair  = i / nbins_;
+          const size_t begin = i % nbins_;
+          const size_t end   = std::min(static_cast<size_t>(nbins_),
+                                        begin + (r.end() - i));
+          IncrementHist(rows[nid][2 * stride * pair],
+                        rows[nid][2 * stride * pair + stride], begin, end);
+          i += end - begin;
+        }
+      });
+    }
+  }
+
  protected:
   void MatchThreadsToNodes(const BlockedSpace2d& space) {
     const size_t space_size = space.Size();
@@ -615,15 +915,17 @@ class ParallelGHistBuilder {
   void MatchNodeNidPairToHist() {
     size_t hist_allocated_additionally = 0;
 
+    tid_nid_to_hist_.assign(nthreads_ * nodes_, -1);
     for (size_t nid = 0; nid < nodes_; ++nid) {
       bool first_hist = true;
       for (size_t tid = 0; tid < nthreads_; ++tid) {
         if (threads_to_nids_map_[tid * nodes_ + nid]) {
           if (first_hist) {
-            tid_nid_to_hist_[{tid, nid}] = -1;
+            tid_nid_to_hist_[tid * nodes_ + nid] = -1;
             first_hist = false;
           } else {
-            tid_nid_to_hist_[{tid, nid}] = hist_allocated_additionally++;
+            tid_nid_to_hist_[tid * nodes_ + nid] =
+                static_cast<int>(hist_allocated_additionally++);
           }
         }
       }
@@ -639,21 +941,24 @@ class ParallelGHistBuilder {
   /*! \brief Buffer for additional histograms for Parallel processing  */
   HistCollection<GradientSumT> hist_buffer_;
   /*!
-   * \brief Marks which hists were used, it means that they should be merged.
-   * Contains only {true or false} values
-   * but 'int' is used instead of 'bool', because std::vector<bool> isn't thread safe
+   * \brief Epoch tag of the Reset that last touched each {tid, nid} slot.
+   * A slot was used - and so has been zeroed and must be merged - when its
+   * tag equals epoch_.  'size_t' is used instead of 'bool', because
+   * std::vector<bool> isn't thread safe
    */
-  std::vector<int> hist_was_used_;
+  std::vector<size_t> hist_used_epoch_;
+  /*! \brief Current epoch, bumped by every Reset */
+  size_t epoch_ = 0;
 
   /*! \brief Buffer for additional histograms for Parallel processing  */
   std::vector<bool> threads_to_nids_map_;
   /*! \brief Contains histograms for final results  */
   std::vector<GHistRowT> targeted_hists_;
   /*!
-   * \brief map pair {tid, nid} to index of allocated histogram from hist_buffer_ and targeted_hists_,
-   * -1 is reserved for targeted_hists_
+   * \brief maps flat index tid * nodes_ + nid to the index of the allocated
+   * histogram from hist_buffer_, -1 is reserved for targeted_hists_
    */
-  std::map<std::pair<size_t, size_t>, int> tid_nid_to_hist_;
+  std::vector<int> tid_nid_to_hist_;
 };
 
 /*!
@@ -673,6 +978,21 @@ class GHistBuilder {
                  const GHistIndexMatrix& gmat,
                  GHistRowT hist,
                  bool isDense);
+  // column-parallel flavor for dense matrices: accumulate only the features
+  // in [f_begin, f_end) over all given rows, touching just their bin range of
+  // 'hist'.  Callers partition the features across threads so that writes are
+  // disjoint by construction and no per-thread copies or merge are needed.
+  void BuildHistColumns(const std::vector<GradientPair>& gpair,
+                        const RowSetCollection::Elem row_indices,
+                        const GHistIndexMatrix& gmat,
+                        size_t f_begin, size_t f_end,
+                        GHistRowT hist);
+  // same, reading int16 quantized gradient pairs instead of float pairs
+  void BuildHistQuantized(const QuantizedGradients& gpair,
+                          const RowSetCollection::Elem row_indices,
+                          const GHistIndexMatrix& gmat,
+                          GHistRowT hist,
+                          bool isDense);
   // same, with feature grouping
   void BuildBlockHist(const std::vector<GradientPair>& gpair,
                       const RowSetCollection::Elem row_indices,
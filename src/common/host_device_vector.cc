@@ -7,29 +7,74 @@
 
 #include <xgboost/base.h>
 #include <xgboost/data.h>
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <utility>
 #include "xgboost/tree_model.h"
 #include "xgboost/host_device_vector.h"
+#include "common.h"
+#include "memory_stats.h"
 
 namespace xgboost {
 
+namespace {
+// buffers at least this large are worth transparent-huge-page backing
+size_t constexpr kHugePageBytes = 2UL << 20;
+}  // anonymous namespace
+
 template <typename T>
 struct HostDeviceVectorImpl {
-  explicit HostDeviceVectorImpl(size_t size, T v) : data_h_(size, v) {}
-  HostDeviceVectorImpl(std::initializer_list<T> init) : data_h_(init) {}
-  explicit HostDeviceVectorImpl(std::vector<T>  init) : data_h_(std::move(init)) {}
-  HostDeviceVectorImpl(HostDeviceVectorImpl&& that) : data_h_(std::move(that.data_h_)) {}
+  explicit HostDeviceVectorImpl(size_t size, T v) : data_h_(size, v) { Account(); }
+  HostDeviceVectorImpl(std::initializer_list<T> init) : data_h_(init) { Account(); }
+  explicit HostDeviceVectorImpl(std::vector<T>  init) : data_h_(std::move(init)) { Account(); }
+  HostDeviceVectorImpl(HostDeviceVectorImpl&& that)
+      : data_h_(std::move(that.data_h_)),
+        accounted_bytes_(that.accounted_bytes_.exchange(0, std::memory_order_relaxed)) {}
+  ~HostDeviceVectorImpl() {
+    common::MemoryStats::Instance().Free(
+        common::MemoryStats::kHostDeviceVector,
+        accounted_bytes_.load(std::memory_order_relaxed));
+  }
 
   void Swap(HostDeviceVectorImpl &other) {
      data_h_.swap(other.data_h_);
+     other.accounted_bytes_.store(
+         accounted_bytes_.exchange(
+             other.accounted_bytes_.load(std::memory_order_relaxed),
+             std::memory_order_relaxed),
+         std::memory_order_relaxed);
   }
 
-  std::vector<T>& Vec() { return data_h_; }
+  std::vector<T>& Vec() {
+    Account();
+    return data_h_;
+  }
 
  private:
+  // Callers mutate through the reference Vec() hands out, so the charged
+  // figure is synced to the current capacity at every access instead of at
+  // every mutation; the gauge can lag one access behind a resize.  The CAS
+  // picks one winner when concurrent readers observe the same change.
+  void Account() {
+    const size_t bytes = data_h_.capacity() * sizeof(T);
+    size_t charged = accounted_bytes_.load(std::memory_order_relaxed);
+    if (bytes == charged ||
+        !accounted_bytes_.compare_exchange_strong(charged, bytes,
+                                                  std::memory_order_relaxed)) {
+      return;
+    }
+    auto& stats = common::MemoryStats::Instance();
+    if (bytes > charged) {
+      stats.Allocate(common::MemoryStats::kHostDeviceVector, bytes - charged);
+    } else {
+      stats.Free(common::MemoryStats::kHostDeviceVector, charged - bytes);
+    }
+  }
+
   std::vector<T> data_h_;
+  /*! \brief bytes currently charged to the MemoryStats gauge */
+  std::atomic<size_t> accounted_bytes_ {0};
 };
 
 template <typename T>
@@ -111,9 +156,29 @@ const std::vector<T>& HostDeviceVector<T>::ConstHostVector() const {
 
 template <typename T>
 void HostDeviceVector<T>::Resize(size_t new_size, T v) {
+  // grow geometrically so streams of unknown total size do not trigger a
+  // reallocation and copy per appended batch
+  if (new_size > this->Capacity()) {
+    this->Reserve(common::GrowCapacity(this->Capacity(), new_size));
+  }
   impl_->Vec().resize(new_size, v);
 }
 
+template <typename T>
+void HostDeviceVector<T>::Reserve(size_t new_capacity) {
+  auto& vec = impl_->Vec();
+  if (new_capacity <= vec.capacity()) { return; }
+  vec.reserve(new_capacity);
+  if (vec.capacity() * sizeof(T) >= kHugePageBytes) {
+    common::MadviseHugePages(vec.data(), vec.capacity() * sizeof(T));
+  }
+}
+
+template <typename T>
+size_t HostDeviceVector<T>::Capacity() const {
+  return impl_->Vec().capacity();
+}
+
 template <typename T>
 void HostDeviceVector<T>::Fill(T v) {
   std::fill(HostVector().begin(), HostVector().end(), v);
@@ -140,7 +205,7 @@ void HostDeviceVector<T>::Copy(std::initializer_list<T> other) {
 template <typename T>
 void HostDeviceVector<T>::Extend(HostDeviceVector const& other) {
   auto ori_size = this->Size();
-  this->HostVector().resize(ori_size + other.Size());
+  this->Resize(ori_size + other.Size());
   std::copy(other.ConstHostVector().cbegin(), other.ConstHostVector().cend(),
             this->HostVector().begin() + ori_size);
 }
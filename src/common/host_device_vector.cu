@@ -7,9 +7,11 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <mutex>
 
 #include "xgboost/data.h"
+#include "xgboost/global_config.h"
 #include "xgboost/host_device_vector.h"
 #include "xgboost/tree_model.h"
 #include "device_helpers.cuh"
@@ -23,6 +25,126 @@ void SetCudaSetDeviceHandler(void (*handler)(int)) {
   cudaSetDeviceHandler = handler;
 }
 
+namespace {
+/*!
+ * \brief Process-wide pinned staging buffer for host-device transfers.
+ *
+ * Transfers from pageable memory run at a fraction of the PCIe bandwidth the
+ * pinned path reaches, while calling cudaMallocHost per transfer would stall
+ * on the allocation.  The pool is sized by the `pinned_staging_bytes` global
+ * configuration and split into two halves so that the host side memcpy of one
+ * chunk overlaps the DMA of the other.  The buffer and its streams are
+ * deliberately leaked: freeing CUDA resources during process teardown races
+ * with driver shutdown.
+ */
+class PinnedStagingPool {
+ public:
+  static PinnedStagingPool& Instance() {
+    static auto* pool = new PinnedStagingPool;
+    return *pool;
+  }
+
+  /*!
+   * \brief Copy between host and device through the pinned staging buffer.
+   *  Returns false when the pool is disabled or cannot be allocated, in which
+   *  case the caller falls back to a direct copy.
+   */
+  bool Copy(void* dst, const void* src, size_t bytes, cudaMemcpyKind kind) {
+    auto requested = static_cast<size_t>(
+        GlobalConfigThreadLocalStore::Get()->pinned_staging_bytes);
+    if (requested == 0 || bytes == 0) {
+      return false;
+    }
+    std::lock_guard<std::mutex> guard(mu_);
+    if (!this->LazyResize(requested)) {
+      return false;
+    }
+    size_t const chunk = size_ / 2;
+    if (chunk == 0) {
+      return false;
+    }
+    if (kind == cudaMemcpyHostToDevice) {
+      int cur = 0;
+      for (size_t off = 0; off < bytes; off += chunk, cur ^= 1) {
+        size_t n = std::min(chunk, bytes - off);
+        // wait until this half is no longer being read by the device
+        dh::safe_cuda(cudaStreamSynchronize(streams_[cur]));
+        std::memcpy(Half(cur), static_cast<const char*>(src) + off, n);
+        dh::safe_cuda(cudaMemcpyAsync(static_cast<char*>(dst) + off, Half(cur),
+                                      n, kind, streams_[cur]));
+      }
+    } else {
+      CHECK_EQ(kind, cudaMemcpyDeviceToHost);
+      // issue the DMA of the next chunk before draining the current one
+      size_t n_chunks = (bytes + chunk - 1) / chunk;
+      for (size_t i = 0; i < n_chunks; ++i) {
+        size_t off = i * chunk;
+        size_t n = std::min(chunk, bytes - off);
+        dh::safe_cuda(cudaMemcpyAsync(Half(i % 2),
+                                      static_cast<const char*>(src) + off, n,
+                                      kind, streams_[i % 2]));
+        if (i > 0) {
+          this->Drain(dst, i - 1, chunk, bytes);
+        }
+      }
+      this->Drain(dst, n_chunks - 1, chunk, bytes);
+    }
+    dh::safe_cuda(cudaStreamSynchronize(streams_[0]));
+    dh::safe_cuda(cudaStreamSynchronize(streams_[1]));
+    return true;
+  }
+
+ private:
+  char* Half(int i) { return static_cast<char*>(staging_) + i * (size_ / 2); }
+
+  /*! \brief Copy chunk i of a device to host transfer out of the staging. */
+  void Drain(void* dst, size_t i, size_t chunk, size_t bytes) {
+    size_t off = i * chunk;
+    size_t n = std::min(chunk, bytes - off);
+    dh::safe_cuda(cudaStreamSynchronize(streams_[i % 2]));
+    std::memcpy(static_cast<char*>(dst) + off, Half(i % 2), n);
+  }
+
+  bool LazyResize(size_t requested) {
+    // streams belong to the device they were created on
+    int device = -1;
+    dh::safe_cuda(cudaGetDevice(&device));
+    if (streams_[0] != nullptr && device != stream_device_) {
+      dh::safe_cuda(cudaStreamDestroy(streams_[0]));
+      dh::safe_cuda(cudaStreamDestroy(streams_[1]));
+      streams_[0] = streams_[1] = nullptr;
+    }
+    if (streams_[0] == nullptr) {
+      dh::safe_cuda(cudaStreamCreate(&streams_[0]));
+      dh::safe_cuda(cudaStreamCreate(&streams_[1]));
+      stream_device_ = device;
+    }
+    if (size_ == requested) {
+      return true;
+    }
+    if (staging_ != nullptr) {
+      dh::safe_cuda(cudaFreeHost(staging_));
+      staging_ = nullptr;
+      size_ = 0;
+    }
+    if (cudaMallocHost(&staging_, requested) != cudaSuccess) {
+      // not enough lockable memory, fall back to direct copies
+      cudaGetLastError();
+      staging_ = nullptr;
+      return false;
+    }
+    size_ = requested;
+    return true;
+  }
+
+  std::mutex mu_;
+  void* staging_ {nullptr};
+  size_t size_ {0};
+  cudaStream_t streams_[2] {nullptr, nullptr};
+  int stream_device_ {-1};
+};
+}  // anonymous namespace
+
 template <typename T>
 class HostDeviceVectorImpl {
  public:
@@ -176,10 +298,30 @@ class HostDeviceVectorImpl {
     } else {
       // resize on host
       LazySyncHost(GPUAccess::kNone);
+      if (new_size > data_h_.capacity()) {
+        this->Reserve(common::GrowCapacity(data_h_.capacity(), new_size));
+      }
       data_h_.resize(new_size, v);
     }
   }
 
+  void Reserve(size_t new_capacity) {
+    if (DeviceCanWrite() && data_d_) {
+      SetDevice();
+      data_d_->reserve(new_capacity);
+    } else if (new_capacity > data_h_.capacity()) {
+      data_h_.reserve(new_capacity);
+      if (data_h_.capacity() * sizeof(T) >= (2UL << 20)) {
+        common::MadviseHugePages(data_h_.data(), data_h_.capacity() * sizeof(T));
+      }
+    }
+  }
+
+  size_t Capacity() const {
+    return HostCanRead() ? data_h_.capacity()
+                         : data_d_ ? data_d_->capacity() : 0;
+  }
+
   void LazySyncHost(GPUAccess access) {
     if (HostCanAccess(access)) { return; }
     if (HostCanRead()) {
@@ -190,10 +332,15 @@ class HostDeviceVectorImpl {
     gpu_access_ = access;
     if (data_h_.size() != data_d_->size()) { data_h_.resize(data_d_->size()); }
     SetDevice();
-    dh::safe_cuda(cudaMemcpy(data_h_.data(),
-                             data_d_->data().get(),
-                             data_d_->size() * sizeof(T),
-                             cudaMemcpyDeviceToHost));
+    if (!PinnedStagingPool::Instance().Copy(data_h_.data(),
+                                            data_d_->data().get(),
+                                            data_d_->size() * sizeof(T),
+                                            cudaMemcpyDeviceToHost)) {
+      dh::safe_cuda(cudaMemcpy(data_h_.data(),
+                               data_d_->data().get(),
+                               data_d_->size() * sizeof(T),
+                               cudaMemcpyDeviceToHost));
+    }
   }
 
   void LazySyncDevice(GPUAccess access) {
@@ -206,10 +353,15 @@ class HostDeviceVectorImpl {
     // data is on the host
     LazyResizeDevice(data_h_.size());
     SetDevice();
-    dh::safe_cuda(cudaMemcpyAsync(data_d_->data().get(),
-                                  data_h_.data(),
-                                  data_d_->size() * sizeof(T),
-                                  cudaMemcpyHostToDevice));
+    if (!PinnedStagingPool::Instance().Copy(data_d_->data().get(),
+                                            data_h_.data(),
+                                            data_d_->size() * sizeof(T),
+                                            cudaMemcpyHostToDevice)) {
+      dh::safe_cuda(cudaMemcpyAsync(data_d_->data().get(),
+                                    data_h_.data(),
+                                    data_d_->size() * sizeof(T),
+                                    cudaMemcpyHostToDevice));
+    }
     gpu_access_ = access;
   }
 
@@ -351,6 +503,14 @@ void HostDeviceVector<T>::Extend(HostDeviceVector const& other) {
   impl_->Extend(other.impl_);
 }
 
+template <typename T>
+void HostDeviceVector<T>::Reserve(size_t new_capacity) {
+  impl_->Reserve(new_capacity);
+}
+
+template <typename T>
+size_t HostDeviceVector<T>::Capacity() const { return impl_->Capacity(); }
+
 template <typename T>
 std::vector<T>& HostDeviceVector<T>::HostVector() { return impl_->HostVector(); }
 
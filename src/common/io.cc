@@ -3,6 +3,7 @@
  */
 #if defined(__unix__)
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <unistd.h>
 #endif  // defined(__unix__)
@@ -94,6 +95,46 @@ void FixedSizeStream::Take(std::string* out) {
   *out = std::move(buffer_);
 }
 
+#if defined(__unix__)
+MemoryMappedStream::MemoryMappedStream(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  CHECK_GE(fd, 0) << "Opening " << path << " failed: " << strerror(errno);
+  struct stat sb;
+  CHECK_EQ(fstat(fd, &sb), 0) << "fstat on " << path
+                              << " failed: " << strerror(errno);
+  size_ = static_cast<size_t>(sb.st_size);
+  if (size_ != 0) {
+    void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    CHECK_NE(mapped, MAP_FAILED) << "mmap of " << path
+                                 << " failed: " << strerror(errno);
+    data_ = static_cast<char*>(mapped);
+    // page caches are scanned front to back once per epoch
+    posix_madvise(data_, size_, POSIX_MADV_SEQUENTIAL);
+  }
+  close(fd);
+}
+
+MemoryMappedStream::~MemoryMappedStream() {
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+  }
+}
+
+size_t MemoryMappedStream::Read(void* dptr, size_t size) {
+  size_t nread = std::min(size, size_ - pointer_);
+  if (nread != 0) {
+    std::memcpy(dptr, data_ + pointer_, nread);
+    pointer_ += nread;
+  }
+  return nread;
+}
+
+void MemoryMappedStream::Seek(size_t pos) {
+  CHECK_LE(pos, size_);
+  pointer_ = pos;
+}
+#endif  // defined(__unix__)
+
 std::string LoadSequentialFile(std::string uri, bool stream) {
   auto OpenErr = [&uri]() {
     std::string msg;
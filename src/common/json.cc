@@ -1,15 +1,19 @@
 /*!
  * Copyright (c) by Contributors 2019-2020
  */
+#include <atomic>
 #include <cctype>
 #include <cstddef>
+#include <cstring>
 #include <iterator>
 #include <locale>
 #include <sstream>
 #include <limits>
 #include <cmath>
+#include <utility>
 
 #include "charconv.h"
+#include "threading_utils.h"
 #include "xgboost/base.h"
 #include "xgboost/logging.h"
 #include "xgboost/json.h"
@@ -17,6 +21,88 @@
 
 namespace xgboost {
 
+namespace {
+/*
+ * Memory behind the Json values created inside a JsonArenaScope.  Blocks are
+ * bump allocated only from the thread owning the scope, but a value may still
+ * be destroyed from another thread, so the live counter is atomic.  The
+ * counter starts at 1 for the owning scope; whoever drops it to zero frees
+ * every block at once.
+ */
+struct JsonArena {
+  static constexpr std::size_t kBlockBytes = 1u << 20;
+  // header in front of each allocation recording its arena, kept at max
+  // alignment so the value behind it stays suitably aligned.
+  static constexpr std::size_t kHeaderBytes = alignof(std::max_align_t);
+
+  std::vector<std::unique_ptr<char[]>> blocks;
+  std::size_t offset { kBlockBytes };
+  std::atomic<std::size_t> live { 1 };
+
+  void* Allocate(std::size_t size) {
+    size = (size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+    if (kBlockBytes - offset < size) {
+      blocks.emplace_back(new char[kBlockBytes]);
+      offset = 0;
+    }
+    void* ptr = blocks.back().get() + offset;
+    offset += size;
+    live.fetch_add(1, std::memory_order_relaxed);
+    return ptr;
+  }
+
+  void Release() {
+    if (live.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this;
+    }
+  }
+};
+
+thread_local JsonArena* current_json_arena {nullptr};
+}  // anonymous namespace
+
+void* Value::operator new(std::size_t size) {
+  auto* arena = current_json_arena;
+  char* base;
+  if (arena && size + JsonArena::kHeaderBytes <= JsonArena::kBlockBytes) {
+    base = static_cast<char*>(arena->Allocate(size + JsonArena::kHeaderBytes));
+  } else {
+    arena = nullptr;
+    base = static_cast<char*>(::operator new(size + JsonArena::kHeaderBytes));
+  }
+  std::memcpy(base, &arena, sizeof(arena));
+  return base + JsonArena::kHeaderBytes;
+}
+
+void Value::operator delete(void* ptr) {
+  if (!ptr) {
+    return;
+  }
+  char* base = static_cast<char*>(ptr) - JsonArena::kHeaderBytes;
+  JsonArena* arena;
+  std::memcpy(&arena, base, sizeof(arena));
+  if (arena) {
+    arena->Release();
+  } else {
+    ::operator delete(base);
+  }
+}
+
+JsonArenaScope::JsonArenaScope() {
+  if (current_json_arena == nullptr) {
+    current_json_arena = new JsonArena;
+    owned_ = true;
+  }
+}
+
+JsonArenaScope::~JsonArenaScope() {
+  if (owned_) {
+    auto* arena = current_json_arena;
+    current_json_arena = nullptr;
+    arena->Release();
+  }
+}
+
 void JsonWriter::Save(Json json) {
   json.ptr_->Save(this);
 }
@@ -529,9 +615,102 @@ Json JsonReader::ParseNull() {
   return Json{JsonNull()};
 }
 
+namespace {
+// Lower bound on the size of an array in bytes before the parallel parser is
+// considered, the structural scan is not free.
+constexpr size_t kParallelArrayBytes = 1u << 20;
+
+// Scans the extents of the top level elements of the array starting at pos
+// without interpreting the values.  Returns false on malformed input, error
+// reporting is left to the sequential parser.
+bool ScanArrayElements(StringView raw_str, size_t pos,
+                       std::vector<std::pair<size_t, size_t>>* p_elems,
+                       size_t* p_end) {
+  auto& elems = *p_elems;
+  elems.clear();
+  size_t depth = 0;
+  bool in_string = false;
+  bool has_elem = false;
+  size_t elem_begin = 0;
+  for (size_t i = pos; i < raw_str.size(); ++i) {
+    char c = raw_str[i];
+    if (in_string) {
+      if (c == '\\') {
+        ++i;  // skip the escaped character
+      } else if (c == '"') {
+        in_string = false;
+      }
+      continue;
+    }
+    if (depth == 1 && !has_elem && c != ',' && c != ']' && !IsSpace(c)) {
+      elem_begin = i;
+      has_elem = true;
+    }
+    switch (c) {
+      case '"': in_string = true; break;
+      case '[':
+      case '{': ++depth; break;
+      case ']':
+      case '}':
+        if (depth == 0) { return false; }
+        --depth;
+        if (depth == 0) {
+          if (c != ']') { return false; }
+          if (has_elem) {
+            elems.emplace_back(elem_begin, i);
+          }
+          *p_end = i + 1;
+          return true;
+        }
+        break;
+      case ',':
+        if (depth == 1) {
+          if (!has_elem) { return false; }
+          elems.emplace_back(elem_begin, i);
+          has_elem = false;
+        }
+        break;
+      default: break;
+    }
+  }
+  return false;  // unterminated array
+}
+}  // anonymous namespace
+
+bool JsonReader::TryParseArrayParallel(Json* p_out) {
+  size_t const pos = cursor_.Pos();
+  std::vector<std::pair<size_t, size_t>> elems;
+  size_t end = 0;
+  if (!ScanArrayElements(raw_str_, pos, &elems, &end)) {
+    return false;
+  }
+  auto const n_threads = static_cast<size_t>(omp_get_max_threads());
+  if (end - pos < kParallelArrayBytes || n_threads <= 1 || elems.size() < n_threads * 2) {
+    return false;
+  }
+  std::vector<Json> data(elems.size());
+  common::ParallelFor(elems.size(), n_threads, [&](size_t i) {
+    JsonReader reader{StringView{raw_str_.c_str() + elems[i].first,
+                                 elems[i].second - elems[i].first}};
+    data[i] = reader.Load();
+  });
+  cursor_.Forward(end - pos);
+  *p_out = Json(std::move(data));
+  return true;
+}
+
 Json JsonReader::ParseArray() {
   std::vector<Json> data;
 
+  // Large arrays like the trees of a boosted forest are parsed with all
+  // available threads, each element is independent once its extent is known.
+  if (raw_str_.size() - cursor_.Pos() >= kParallelArrayBytes) {
+    Json result;
+    if (this->TryParseArrayParallel(&result)) {
+      return result;
+    }
+  }
+
   char ch { GetConsecutiveChar('[') };  // NOLINT
   while (true) {
     if (PeekNextChar() == ']') {
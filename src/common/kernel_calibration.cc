@@ -0,0 +1,232 @@
+/*!
+ * Copyright 2021 by Contributors
+ * \file kernel_calibration.cc
+ */
+#include "kernel_calibration.h"
+
+#include <dmlc/omp.h>
+#include <dmlc/parameter.h>
+#include <dmlc/timer.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "xgboost/logging.h"
+#include "threading_utils.h"
+
+#if defined(XGBOOST_MM_PREFETCH_PRESENT)
+  #include <xmmintrin.h>
+  #define PREFETCH_READ_T0(addr) _mm_prefetch(reinterpret_cast<const char*>(addr), _MM_HINT_T0)
+#elif defined(XGBOOST_BUILTIN_PREFETCH_PRESENT)
+  #define PREFETCH_READ_T0(addr) __builtin_prefetch(reinterpret_cast<const char*>(addr), 0, 3)
+#else  // no SW pre-fetching available; PREFETCH_READ_T0 is no-op
+  #define PREFETCH_READ_T0(addr) do {} while (0)
+#endif  // defined(XGBOOST_MM_PREFETCH_PRESENT)
+
+namespace xgboost {
+namespace common {
+namespace {
+
+// Shape of the microbenchmark, sized so the gradients and the bin index
+// stream from memory while the histogram stays cache resident, matching the
+// dense uint8 histogram kernel the calibration stands in for.
+constexpr size_t kRows = 1 << 15;
+constexpr size_t kFeatures = 16;
+constexpr size_t kBins = 256;
+constexpr size_t kCacheLineSize = 64;
+// entry of the cache file format, bumped when the line layout changes
+constexpr int kCacheFileVersion = 1;
+
+// One pass over rows [begin, end) accumulating gradient pairs into hist with
+// the pipelining structure of BuildHistDenseKernel.
+void HistPass(const uint8_t* index, const float* pgh, size_t begin, size_t end,
+              size_t distance, double* hist) {
+  const size_t size = end - begin;
+  for (size_t i = 0; i < size; ++i) {
+    const size_t row = begin + i;
+    if (i + distance < size) {
+      const size_t prefetch_row = begin + i + distance;
+      PREFETCH_READ_T0(pgh + 2 * prefetch_row);
+      for (size_t j = 0; j < kFeatures; j += kCacheLineSize / sizeof(uint8_t)) {
+        PREFETCH_READ_T0(index + prefetch_row * kFeatures + j);
+      }
+    }
+    const uint8_t* row_index = index + row * kFeatures;
+    for (size_t j = 0; j < kFeatures; ++j) {
+      double* cell = hist + 2 * (j * kBins + row_index[j]);
+      cell[0] += pgh[2 * row];
+      cell[1] += pgh[2 * row + 1];
+    }
+  }
+}
+
+// Run fn repeatedly for roughly budget seconds and return the call rate.
+template <typename Fn>
+double PassesPerSecond(double budget, Fn fn) {
+  fn();  // warm the caches and the instruction path
+  const double start = dmlc::GetTime();
+  size_t calls = 0;
+  do {
+    fn();
+    ++calls;
+  } while (dmlc::GetTime() - start < budget);
+  return calls / (dmlc::GetTime() - start);
+}
+
+std::vector<std::string> SplitTabs(const std::string& line) {
+  std::vector<std::string> fields;
+  std::istringstream is(line);
+  std::string field;
+  while (std::getline(is, field, '\t')) {
+    fields.push_back(field);
+  }
+  return fields;
+}
+
+}  // anonymous namespace
+
+const KernelParams& KernelCalibration::Params() {
+  static const KernelParams params = [] {
+    KernelParams p;
+    if (dmlc::GetEnv("XGBOOST_CALIBRATE", 0) == 0) {
+      return p;
+    }
+    const std::string home = dmlc::GetEnv("HOME", std::string{"."});
+    const std::string path = dmlc::GetEnv("XGBOOST_CALIBRATION_FILE",
+                                          home + "/.xgboost_tuning");
+    const std::string model = CpuModel();
+    if (LoadCacheFile(path, model, &p)) {
+      LOG(INFO) << "Loaded calibrated kernel parameters for \"" << model
+                << "\" from " << path;
+      return p;
+    }
+    p = Benchmark();
+    AppendCacheFile(path, model, p);
+    LOG(INFO) << "Calibrated kernel parameters for \"" << model
+              << "\": prefetch distance " << p.hist_prefetch_distance
+              << ", row grain " << p.hist_row_grain;
+    return p;
+  }();
+  return params;
+}
+
+std::string KernelCalibration::CpuModel() {
+#if defined(__linux__)
+  std::ifstream fin("/proc/cpuinfo");
+  std::string line;
+  while (std::getline(fin, line)) {
+    if (line.compare(0, 10, "model name") == 0) {
+      size_t pos = line.find(':');
+      if (pos != std::string::npos) {
+        pos = line.find_first_not_of(" \t", pos + 1);
+        if (pos != std::string::npos) {
+          return line.substr(pos);
+        }
+      }
+    }
+  }
+#endif  // defined(__linux__)
+  return "unknown";
+}
+
+KernelParams KernelCalibration::Benchmark() {
+  KernelParams best;  // falls back to the defaults when nothing wins
+
+  std::vector<uint8_t> index(kRows * kFeatures);
+  std::vector<float> pgh(2 * kRows);
+  std::vector<double> hist(2 * kFeatures * kBins, 0.0);
+  std::mt19937 rng(0);
+  for (auto& v : index) {
+    v = static_cast<uint8_t>(rng() % kBins);
+  }
+  for (auto& v : pgh) {
+    v = static_cast<float>(rng() % 1024) / 1024.0f;
+  }
+
+  // The prefetch distance only shifts the pipeline, so a single threaded pass
+  // is representative.
+  double best_rate = 0.0;
+  for (size_t distance : {4, 6, 8, 10, 13, 16, 24, 32}) {
+    const double rate = PassesPerSecond(0.006, [&] {
+      HistPass(index.data(), pgh.data(), 0, kRows, distance, hist.data());
+    });
+    if (rate > best_rate) {
+      best_rate = rate;
+      best.hist_prefetch_distance = distance;
+    }
+  }
+
+  // The block grain trades scheduling slack against cache reuse, so it is
+  // timed with the full thread pool over a blocked space like the one
+  // BuildLocalHistograms builds, with per-thread scratch histograms.
+  const int32_t nthreads = std::max(omp_get_max_threads(), 1);
+  std::vector<std::vector<double>> hist_tloc(
+      nthreads, std::vector<double>(2 * kFeatures * kBins, 0.0));
+  constexpr size_t kNodes = 4;
+  constexpr size_t kRowsPerNode = kRows / kNodes;
+  best_rate = 0.0;
+  for (size_t grain : {64, 128, 256, 512, 1024}) {
+    BlockedSpace2d space(kNodes, [&](size_t) { return kRowsPerNode; }, grain);
+    const double rate = PassesPerSecond(0.008, [&] {
+      ParallelFor2d(space, nthreads, [&](size_t node, Range1d r) {
+        const size_t begin = node * kRowsPerNode + r.begin();
+        const size_t end = node * kRowsPerNode + r.end();
+        HistPass(index.data(), pgh.data(), begin, end,
+                 best.hist_prefetch_distance,
+                 hist_tloc[omp_get_thread_num()].data());
+      });
+    });
+    if (rate > best_rate) {
+      best_rate = rate;
+      best.hist_row_grain = grain;
+    }
+  }
+  return best;
+}
+
+bool KernelCalibration::LoadCacheFile(const std::string& path,
+                                      const std::string& model,
+                                      KernelParams* out) {
+  std::ifstream fin(path.c_str());
+  if (!fin.good()) {
+    return false;
+  }
+  std::string line;
+  while (std::getline(fin, line)) {
+    // version, prefetch distance, row grain, CPU model; the model comes last
+    // since it contains spaces
+    std::vector<std::string> fields = SplitTabs(line);
+    if (fields.size() != 4 ||
+        fields[0] != std::to_string(kCacheFileVersion) || fields[3] != model) {
+      continue;
+    }
+    const unsigned long prefetch = std::strtoul(fields[1].c_str(), nullptr, 10);  // NOLINT
+    const unsigned long grain = std::strtoul(fields[2].c_str(), nullptr, 10);  // NOLINT
+    if (prefetch == 0 || grain == 0) {
+      continue;
+    }
+    out->hist_prefetch_distance = prefetch;
+    out->hist_row_grain = grain;
+    return true;
+  }
+  return false;
+}
+
+void KernelCalibration::AppendCacheFile(const std::string& path,
+                                        const std::string& model,
+                                        const KernelParams& params) {
+  std::ofstream fout(path.c_str(), std::ios::app);
+  if (!fout.good()) {
+    LOG(WARNING) << "Couldn't write calibration cache file " << path;
+    return;
+  }
+  fout << kCacheFileVersion << '\t' << params.hist_prefetch_distance << '\t'
+       << params.hist_row_grain << '\t' << model << '\n';
+}
+
+}  // namespace common
+}  // namespace xgboost
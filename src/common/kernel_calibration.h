@@ -0,0 +1,63 @@
+/*!
+ * Copyright 2021 by Contributors
+ * \file kernel_calibration.h
+ * \brief One-time microbenchmark choosing CPU kernel parameters.
+ */
+#ifndef XGBOOST_COMMON_KERNEL_CALIBRATION_H_
+#define XGBOOST_COMMON_KERNEL_CALIBRATION_H_
+
+#include <cstddef>
+#include <string>
+
+namespace xgboost {
+namespace common {
+
+/*! \brief CPU kernel parameters chosen by the one-time calibration. */
+struct KernelParams {
+  /*! \brief pipelining distance in rows of the histogram kernels */
+  size_t hist_prefetch_distance{10};
+  /*! \brief rows per block when splitting histogram build spaces */
+  size_t hist_row_grain{256};
+};
+
+/*!
+ * \brief Calibrates the constants baked into the CPU histogram kernels.
+ *
+ * The default prefetch distance and block grain were tuned on one historical
+ * microarchitecture and are 10-20% off on others.  Setting XGBOOST_CALIBRATE=1
+ * runs roughly a hundred milliseconds of histogram-shaped microkernels the
+ * first time the parameters are requested - in practice the first Update -
+ * and settles on the best-performing candidates.  The result is cached in a
+ * small text file keyed by the CPU model string (XGBOOST_CALIBRATION_FILE,
+ * defaulting to .xgboost_tuning in the home directory), so the benchmark runs
+ * once per machine rather than once per process.  Explicit environment
+ * overrides such as XGBOOST_HIST_PREFETCH_DISTANCE still take precedence over
+ * the calibrated values.
+ */
+class KernelCalibration {
+ public:
+  /*!
+   * \brief Calibrated parameters; the defaults when calibration is disabled.
+   *  The first call may block for the duration of the benchmark.
+   */
+  static const KernelParams& Params();
+
+  /*! \brief CPU model string used as the cache key, "unknown" when unavailable */
+  static std::string CpuModel();
+  /*! \brief run the microbenchmark and return the winning parameters */
+  static KernelParams Benchmark();
+  /*!
+   * \brief Look up \p model in the cache file.
+   * \return whether a valid entry was found and written to \p out.
+   */
+  static bool LoadCacheFile(const std::string& path, const std::string& model,
+                            KernelParams* out);
+  /*! \brief append the entry for \p model to the cache file */
+  static void AppendCacheFile(const std::string& path, const std::string& model,
+                              const KernelParams& params);
+};
+
+}  // namespace common
+}  // namespace xgboost
+
+#endif  // XGBOOST_COMMON_KERNEL_CALIBRATION_H_
@@ -0,0 +1,65 @@
+/*!
+ * Copyright 2021 by Contributors
+ * \file memory_stats.cc
+ */
+#include "memory_stats.h"
+
+#include <xgboost/json.h>
+#include <xgboost/logging.h>
+
+#include <sstream>
+
+namespace xgboost {
+namespace common {
+
+MemoryStats& MemoryStats::Instance() {
+  static MemoryStats instance;
+  return instance;
+}
+
+const char* MemoryStats::Name(Subsystem sub) {
+  switch (sub) {
+    case kHostDeviceVector: return "host_device_vector";
+    case kHistogram: return "histogram";
+    case kGroupBuilder: return "group_builder";
+    default: LOG(FATAL) << "Unknown subsystem: " << static_cast<int>(sub);
+  }
+  return "";
+}
+
+std::string MemoryStats::CollectJson() const {
+  Json out{Object()};
+  for (int i = 0; i < kNumSubsystems; ++i) {
+    const auto sub = static_cast<Subsystem>(i);
+    Json entry{Object()};
+    entry["live_bytes"] = Integer(static_cast<Integer::Int>(LiveBytes(sub)));
+    entry["peak_bytes"] = Integer(static_cast<Integer::Int>(PeakBytes(sub)));
+    out[Name(sub)] = entry;
+  }
+  std::string str;
+  Json::Dump(out, &str);
+  return str;
+}
+
+void MemoryStats::Log() {
+  bool advanced = false;
+  for (int i = 0; i < kNumSubsystems; ++i) {
+    advanced |= PeakBytes(static_cast<Subsystem>(i)) != logged_peak_[i];
+  }
+  if (!advanced) {
+    return;
+  }
+  constexpr double kMiB = 1024.0 * 1024.0;
+  std::ostringstream os;
+  os << "Memory usage in MiB (live/peak):";
+  for (int i = 0; i < kNumSubsystems; ++i) {
+    const auto sub = static_cast<Subsystem>(i);
+    logged_peak_[i] = PeakBytes(sub);
+    os << ' ' << Name(sub) << '=' << LiveBytes(sub) / kMiB << '/'
+       << logged_peak_[i] / kMiB;
+  }
+  LOG(INFO) << os.str();
+}
+
+}  // namespace common
+}  // namespace xgboost
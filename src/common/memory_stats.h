@@ -0,0 +1,77 @@
+/*!
+ * Copyright 2021 by Contributors
+ * \file memory_stats.h
+ * \brief Live and peak byte gauges for the major host side allocation owners.
+ *
+ * The ProfileRegistry in profile.h answers "where did the time go"; the
+ * gauges below answer "where did the memory go".  Each hooked subsystem
+ * syncs its charged footprint as it grows and shrinks, the registry keeps
+ * the current and high-water byte counts, and the aggregate is exported
+ * through XGBGetMemoryStats and logged once per iteration with verbosity 2.
+ */
+#ifndef XGBOOST_COMMON_MEMORY_STATS_H_
+#define XGBOOST_COMMON_MEMORY_STATS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+namespace xgboost {
+namespace common {
+
+class MemoryStats {
+ public:
+  /*! \brief subsystems with accounting hooks */
+  enum Subsystem : int {
+    kHostDeviceVector = 0,
+    kHistogram,
+    kGroupBuilder,
+    kNumSubsystems
+  };
+
+  static MemoryStats& Instance();
+
+  /*! \brief charge bytes to a subsystem; hooks may fire from any thread */
+  void Allocate(Subsystem sub, size_t bytes) {
+    size_t live = live_[sub].fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    size_t peak = peak_[sub].load(std::memory_order_relaxed);
+    while (live > peak &&
+           !peak_[sub].compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+  }
+
+  /*! \brief release previously charged bytes */
+  void Free(Subsystem sub, size_t bytes) {
+    live_[sub].fetch_sub(bytes, std::memory_order_relaxed);
+  }
+
+  size_t LiveBytes(Subsystem sub) const {
+    return live_[sub].load(std::memory_order_relaxed);
+  }
+  size_t PeakBytes(Subsystem sub) const {
+    return peak_[sub].load(std::memory_order_relaxed);
+  }
+
+  static const char* Name(Subsystem sub);
+
+  /*! \brief JSON object mapping each subsystem to its live and peak byte counts */
+  std::string CollectJson() const;
+
+  /*!
+   * \brief Emit one info line (verbosity 2) with the live/peak figures; a
+   *  no-op unless some peak advanced since the previous call.
+   */
+  void Log();
+
+ private:
+  MemoryStats() = default;
+
+  std::atomic<size_t> live_[kNumSubsystems] {};
+  std::atomic<size_t> peak_[kNumSubsystems] {};
+  /*! \brief peaks at the time of the last emitted line; touched only by Log */
+  size_t logged_peak_[kNumSubsystems] {};
+};
+
+}  // namespace common
+}  // namespace xgboost
+#endif  // XGBOOST_COMMON_MEMORY_STATS_H_
@@ -0,0 +1,137 @@
+/*!
+ * Copyright 2021 by Contributors
+ * \file numa_utils.h
+ * \brief NUMA topology discovery and thread binding helpers.
+ *
+ * Implemented on top of sysfs and sched_setaffinity to avoid a hard
+ * dependency on libnuma; on non-Linux platforms everything degrades to a
+ * single-node topology and binding becomes a no-op.
+ */
+#ifndef XGBOOST_COMMON_NUMA_UTILS_H_
+#define XGBOOST_COMMON_NUMA_UTILS_H_
+
+#include <dmlc/omp.h>
+#include <dmlc/common.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <sstream>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif  // defined(__linux__)
+
+#include "xgboost/logging.h"
+
+namespace xgboost {
+namespace common {
+namespace numa {
+
+/*! \brief List of logical CPUs for each NUMA node, parsed from
+ *         /sys/devices/system/node/node<i>/cpulist.  A single node holding
+ *         all CPUs is reported when the topology cannot be discovered. */
+inline std::vector<std::vector<int>> const& NodeCpus() {
+  static const std::vector<std::vector<int>> nodes = []() {
+    std::vector<std::vector<int>> result;
+#if defined(__linux__)
+    for (int node = 0; ; ++node) {
+      std::ifstream fin("/sys/devices/system/node/node" + std::to_string(node)
+                        + "/cpulist");
+      if (!fin) {
+        break;
+      }
+      std::string cpulist;
+      std::getline(fin, cpulist);
+      // cpulist is a comma separated sequence of ids and ranges, e.g. "0-15,32-47"
+      std::vector<int> cpus;
+      std::stringstream ss(cpulist);
+      std::string token;
+      while (std::getline(ss, token, ',')) {
+        const auto dash = token.find('-');
+        if (dash == std::string::npos) {
+          cpus.push_back(std::stoi(token));
+        } else {
+          const int first = std::stoi(token.substr(0, dash));
+          const int last = std::stoi(token.substr(dash + 1));
+          for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+          }
+        }
+      }
+      if (!cpus.empty()) {
+        result.push_back(std::move(cpus));
+      }
+    }
+#endif  // defined(__linux__)
+    if (result.empty()) {
+      std::vector<int> all_cpus(std::max(omp_get_num_procs(), 1));
+      for (size_t i = 0; i < all_cpus.size(); ++i) {
+        all_cpus[i] = static_cast<int>(i);
+      }
+      result.push_back(std::move(all_cpus));
+    }
+    return result;
+  }();
+  return nodes;
+}
+
+/*! \brief Number of NUMA nodes visible to the process. */
+inline int NumNodes() {
+  return static_cast<int>(NodeCpus().size());
+}
+
+/*!
+ * \brief Restrict the calling thread to the CPUs of one NUMA node, so that
+ *        first-touch page allocation from this thread lands on local memory.
+ * \return true when the affinity mask was applied.
+ */
+inline bool BindThreadToNode(int node) {
+#if defined(__linux__)
+  auto const& nodes = NodeCpus();
+  if (node < 0 || node >= static_cast<int>(nodes.size())) {
+    return false;
+  }
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  for (int cpu : nodes[node]) {
+    CPU_SET(cpu, &mask);
+  }
+  return sched_setaffinity(0, sizeof(mask), &mask) == 0;
+#else
+  (void)node;
+  return false;
+#endif  // defined(__linux__)
+}
+
+/*!
+ * \brief Bind the first nthreads OpenMP workers to NUMA nodes in contiguous
+ *        blocks: threads [0, n/k) to node 0, the next block to node 1 and so
+ *        on.  Combined with the block distribution used by ParallelFor2d this
+ *        keeps a thread's histogram buffers and row partitions on the memory
+ *        of its own socket.  No-op on single-node machines.
+ */
+inline void BindOmpThreadsToNodes(int nthreads) {
+  const int n_nodes = NumNodes();
+  if (n_nodes <= 1 || nthreads <= 0) {
+    return;
+  }
+  const int threads_per_node = nthreads / n_nodes + !!(nthreads % n_nodes);
+  dmlc::OMPException omp_exc;
+#pragma omp parallel num_threads(nthreads)
+  {
+    omp_exc.Run([threads_per_node, n_nodes]() {
+      const int tid = omp_get_thread_num();
+      const int node = std::min(tid / threads_per_node, n_nodes - 1);
+      BindThreadToNode(node);
+    });
+  }
+  omp_exc.Rethrow();
+}
+
+}  // namespace numa
+}  // namespace common
+}  // namespace xgboost
+
+#endif  // XGBOOST_COMMON_NUMA_UTILS_H_
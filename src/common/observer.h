@@ -66,6 +66,9 @@ class TrainingObserver {
   template <typename T>
   void Observe(common::Span<T> span, std::string name,
                size_t n = std::numeric_limits<std::size_t>::max()) {
+    // gate before the copy; the other overloads check again but by then the
+    // span has already been materialized
+    if (XGBOOST_EXPECT(!kObserve, true)) { return; }
     std::vector<T> copy(span.size());
     std::copy(span.cbegin(), span.cend(), copy.begin());
     this->Observe(copy, name, n);
@@ -0,0 +1,51 @@
+/*!
+ * Copyright 2021 by Contributors
+ * \file profile.cc
+ */
+#include "profile.h"
+
+#include <xgboost/json.h>
+#include <xgboost/logging.h>
+
+namespace xgboost {
+namespace common {
+
+ProfileRegistry& ProfileRegistry::Instance() {
+  static ProfileRegistry instance;
+  return instance;
+}
+
+size_t ProfileRegistry::Register(const std::string& name) {
+  std::lock_guard<std::mutex> guard(mu_);
+  for (size_t i = 0; i < names_.size(); ++i) {
+    if (names_[i] == name) {
+      return i;
+    }
+  }
+  CHECK_LT(names_.size(), kMaxCounters)
+      << "Too many profile counters registered";
+  names_.push_back(name);
+  return names_.size() - 1;
+}
+
+std::string ProfileRegistry::CollectJson() {
+  Json out{Object()};
+  {
+    std::lock_guard<std::mutex> guard(mu_);
+    for (size_t i = 0; i < names_.size(); ++i) {
+      out[names_[i]] = Integer(static_cast<Integer::Int>(
+          counters_[i].exchange(0, std::memory_order_relaxed)));
+    }
+  }
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  out["timer_unit"] = String("tsc");
+#else
+  out["timer_unit"] = String("ns");
+#endif
+  std::string str;
+  Json::Dump(out, &str);
+  return str;
+}
+
+}  // namespace common
+}  // namespace xgboost
@@ -0,0 +1,95 @@
+/*!
+ * Copyright 2021 by Contributors
+ * \file profile.h
+ * \brief Always-on counters and tick timers for the hot paths.
+ *
+ * common::Monitor reports coarse phase timings and only with verbosity 3.
+ * The registry below is meant to stay enabled in production: counters cost a
+ * single relaxed atomic add per block of work, timers read the TSC directly,
+ * and the aggregate is exported as JSON through XGBGetProfileCounters, so a
+ * slow training job can be diagnosed without rerunning it under a profiler.
+ */
+#ifndef XGBOOST_COMMON_PROFILE_H_
+#define XGBOOST_COMMON_PROFILE_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <x86intrin.h>
+#endif
+
+namespace xgboost {
+namespace common {
+
+/*! \brief raw tick source: TSC on x86-64, steady clock nanoseconds elsewhere */
+inline uint64_t ProfileTicks() {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  return __rdtsc();
+#else
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+/*!
+ * \brief Process-wide registry of named counters.  Call sites resolve their
+ *  name to a slot once through a static local and accumulate into the slot
+ *  afterwards; a snapshot of all counters is collected per iteration through
+ *  the C API.
+ */
+class ProfileRegistry {
+ public:
+  static ProfileRegistry& Instance();
+
+  /*!
+   * \brief Resolve a counter name to a stable slot.  Idempotent and thread
+   *  safe; intended to run once per call site through a static local.
+   */
+  size_t Register(const std::string& name);
+
+  /*! \brief accumulate into a slot; a single relaxed add, safe on hot paths */
+  void Add(size_t slot, uint64_t value) {
+    counters_[slot].fetch_add(value, std::memory_order_relaxed);
+  }
+
+  /*!
+   * \brief JSON object with every registered counter plus the timer unit.
+   *  Values accumulate since the previous call and collecting resets them,
+   *  so polling once per iteration yields per-iteration figures.
+   */
+  std::string CollectJson();
+
+ private:
+  ProfileRegistry() = default;
+
+  static constexpr size_t kMaxCounters = 256;
+  std::array<std::atomic<uint64_t>, kMaxCounters> counters_ {};
+  std::vector<std::string> names_;
+  std::mutex mu_;  // guards names_ during registration
+};
+
+/*! \brief RAII timer charging elapsed ticks to a registry slot */
+class ProfileTimer {
+ public:
+  explicit ProfileTimer(size_t slot) : slot_{slot}, begin_{ProfileTicks()} {}
+  ~ProfileTimer() {
+    ProfileRegistry::Instance().Add(slot_, ProfileTicks() - begin_);
+  }
+  ProfileTimer(ProfileTimer const&) = delete;
+  ProfileTimer& operator=(ProfileTimer const&) = delete;
+
+ private:
+  size_t slot_;
+  uint64_t begin_;
+};
+
+}  // namespace common
+}  // namespace xgboost
+#endif  // XGBOOST_COMMON_PROFILE_H_
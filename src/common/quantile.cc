@@ -1,14 +1,90 @@
 /*!
  * Copyright 2020 by XGBoost Contributors
  */
+#include <dmlc/parameter.h>
+
+#include <algorithm>
+#include <cstring>
 #include <limits>
 #include <utility>
+#include <vector>
 #include "quantile.h"
 #include "hist_util.h"
 
 namespace xgboost {
 namespace common {
 
+namespace {
+/* Number of entries sorted per batch in PushRowPage; bounds the sort scratch
+   to 2 buffers of 16 bytes per entry. */
+constexpr size_t kSketchSortBatch = 1UL << 24;
+
+/* Entry of the page-wide radix sort used by PushRowPage: the column index in
+   the high key bytes, the value bits (mapped so that unsigned comparison
+   matches float ordering) in the low 32.  The original value rides along for
+   duplicate merging, the weight for summary construction. */
+struct SortEntry {
+  uint64_t key;
+  float value;
+  float weight;
+};
+
+uint32_t OrderedFloatBits(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return (bits >> 31) ? ~bits : (bits | (uint32_t{1} << 31));
+}
+
+/* One stable pass of a parallel LSD radix sort over 8-bit digits.  The digit
+   major, thread minor exclusive scan places all occurrences of a smaller
+   digit before any occurrence of a larger one, and earlier chunks of the same
+   digit before later chunks, which keeps the pass stable. */
+void RadixSortPass(std::vector<SortEntry> const &in,
+                   std::vector<SortEntry> *p_out, size_t n, uint32_t shift,
+                   int32_t nthreads) {
+  constexpr size_t kBuckets = 256;
+  auto &out = *p_out;
+  std::vector<size_t> counts(static_cast<size_t>(nthreads) * kBuckets, 0);
+  size_t const chunk = DivRoundUp(n, nthreads);
+  dmlc::OMPException exc;
+#pragma omp parallel num_threads(nthreads)
+  {
+    exc.Run([&]() {
+      auto const tid = static_cast<size_t>(omp_get_thread_num());
+      size_t const begin = std::min(chunk * tid, n);
+      size_t const end = std::min(begin + chunk, n);
+      size_t *local = counts.data() + tid * kBuckets;
+      for (size_t i = begin; i < end; ++i) {
+        ++local[(in[i].key >> shift) & (kBuckets - 1)];
+      }
+    });
+  }
+  exc.Rethrow();
+  size_t total = 0;
+  for (size_t digit = 0; digit < kBuckets; ++digit) {
+    for (int32_t tid = 0; tid < nthreads; ++tid) {
+      size_t *count = &counts[static_cast<size_t>(tid) * kBuckets + digit];
+      size_t const tmp = *count;
+      *count = total;
+      total += tmp;
+    }
+  }
+#pragma omp parallel num_threads(nthreads)
+  {
+    exc.Run([&]() {
+      auto const tid = static_cast<size_t>(omp_get_thread_num());
+      size_t const begin = std::min(chunk * tid, n);
+      size_t const end = std::min(begin + chunk, n);
+      size_t *local = counts.data() + tid * kBuckets;
+      for (size_t i = begin; i < end; ++i) {
+        out[local[(in[i].key >> shift) & (kBuckets - 1)]++] = in[i];
+      }
+    });
+  }
+  exc.Rethrow();
+}
+}  // anonymous namespace
+
 HostSketchContainer::HostSketchContainer(std::vector<bst_row_t> columns_size,
                                          int32_t max_bins, bool use_group)
     : columns_size_{std::move(columns_size)}, max_bins_{max_bins},
@@ -21,7 +97,6 @@ HostSketchContainer::HostSketchContainer(std::vector<bst_row_t> columns_size,
     n_bins = std::max(n_bins, static_cast<decltype(n_bins)>(1));
     auto eps = 1.0 / (static_cast<float>(n_bins) * WQSketch::kFactor);
     sketches_[i].Init(columns_size_[i], eps);
-    sketches_[i].inqueue.queue.resize(sketches_[i].limit_size * 2);
   }
 }
 
@@ -90,57 +165,129 @@ std::vector<bst_feature_t> HostSketchContainer::LoadBalance(
 }
 
 void HostSketchContainer::PushRowPage(SparsePage const &page,
-                                      MetaInfo const &info) {
+                                      MetaInfo const &info,
+                                      common::Span<float const> hessian) {
   monitor_.Start(__func__);
-  int nthread = omp_get_max_threads();
+  int32_t const nthread = omp_get_max_threads();
   CHECK_EQ(sketches_.size(), info.num_col_);
 
   // Data groups, used in ranking.
   std::vector<bst_uint> const &group_ptr = info.group_ptr_;
-  // Use group index for weights?
   auto batch = page.GetView();
-  dmlc::OMPException exec;
-  // Parallel over columns.  Each thread owns a set of consecutive columns.
-  auto const ncol = static_cast<uint32_t>(info.num_col_);
-  auto const is_dense = info.num_nonzero_ == info.num_col_ * info.num_row_;
-  auto thread_columns_ptr = LoadBalance(page, info.num_col_, nthread);
+  auto const ncol = static_cast<bst_feature_t>(info.num_col_);
+
+  // Number of radix key bytes: 4 bytes of value bits plus enough high bytes
+  // to hold the column index.
+  int32_t key_bytes = 4;
+  for (size_t c = ncol == 0 ? 0 : static_cast<size_t>(ncol) - 1; c != 0;
+       c >>= 8) {
+    ++key_bytes;
+  }
 
+  /* Previously each thread owned a range of columns and pushed entries into
+   * the per-column queues, every queue sorting itself with std::sort whenever
+   * it filled.  For wide datasets that is a long tail of medium sorts, each on
+   * a single thread.  Instead gather a batch of rows into one buffer, sort all
+   * column segments at once with a parallel radix sort keyed on (column, value
+   * bits), and push each column's sorted run into its sketch as one summary.
+   * The radix passes spread the work evenly over all threads no matter how the
+   * entries distribute across columns. */
+  std::vector<SortEntry> entries;
+  std::vector<SortEntry> scratch;
+  for (size_t chunk_begin = 0; chunk_begin < batch.Size();) {
+    // Take rows until the scratch budget is reached.
+    size_t chunk_end = chunk_begin;
+    size_t n_entries = 0;
+    while (chunk_end < batch.Size()) {
+      size_t const row_size = batch[chunk_end].size();
+      if (n_entries != 0 && n_entries + row_size > kSketchSortBatch) {
+        break;
+      }
+      n_entries += row_size;
+      ++chunk_end;
+    }
+    size_t const n_rows = chunk_end - chunk_begin;
+    entries.resize(n_entries);
+    scratch.resize(n_entries);
+
+    // First pass: per-thread, per-column entry counts over the chunk.
+    std::vector<size_t> counts(static_cast<size_t>(nthread) * ncol, 0);
+    size_t const rows_per_thread = DivRoundUp(n_rows, nthread);
+    dmlc::OMPException exc;
 #pragma omp parallel num_threads(nthread)
-  {
-    exec.Run([&]() {
-      auto tid = static_cast<uint32_t>(omp_get_thread_num());
-      auto const begin = thread_columns_ptr[tid];
-      auto const end = thread_columns_ptr[tid + 1];
-      size_t group_ind = 0;
-
-      // do not iterate if no columns are assigned to the thread
-      if (begin < end && end <= ncol) {
-        for (size_t i = 0; i < batch.Size(); ++i) {
-          size_t const ridx = page.base_rowid + i;
-          SparsePage::Inst const inst = batch[i];
-          if (use_group_ind_) {
-            group_ind = this->SearchGroupIndFromRow(group_ptr, i + page.base_rowid);
-          }
-          size_t w_idx = use_group_ind_ ? group_ind : ridx;
-          auto w = info.GetWeight(w_idx);
-          auto p_inst = inst.data();
-          if (is_dense) {
-            for (size_t ii = begin; ii < end; ii++) {
-              sketches_[ii].Push(p_inst[ii].fvalue, w);
-            }
-          } else {
-            for (size_t i = 0; i < inst.size(); ++i) {
-              auto const& entry = p_inst[i];
-              if (entry.index >= begin && entry.index < end) {
-                sketches_[entry.index].Push(entry.fvalue, w);
-              }
-            }
+    {
+      exc.Run([&]() {
+        auto const tid = static_cast<size_t>(omp_get_thread_num());
+        size_t const begin = std::min(rows_per_thread * tid, n_rows);
+        size_t const end = std::min(begin + rows_per_thread, n_rows);
+        size_t *local = counts.data() + tid * ncol;
+        for (size_t i = begin; i < end; ++i) {
+          for (auto const &entry : batch[chunk_begin + i]) {
+            ++local[entry.index];
           }
         }
+      });
+    }
+    exc.Rethrow();
+    // Column major exclusive scan turns the counts into write cursors:
+    // column segments are contiguous, each thread writing its rows in order.
+    std::vector<size_t> col_offsets(static_cast<size_t>(ncol) + 1, 0);
+    size_t total = 0;
+    for (bst_feature_t fid = 0; fid < ncol; ++fid) {
+      col_offsets[fid] = total;
+      for (int32_t tid = 0; tid < nthread; ++tid) {
+        size_t *count = &counts[static_cast<size_t>(tid) * ncol + fid];
+        size_t const tmp = *count;
+        *count = total;
+        total += tmp;
       }
+    }
+    col_offsets[ncol] = total;
+    CHECK_EQ(total, n_entries);
+
+    // Second pass: scatter the entries into their column segments together
+    // with the row weight.  Zero weight entries are still written, so that
+    // the cursors stay consistent with the counts; they are dropped when the
+    // summaries are built below.
+#pragma omp parallel num_threads(nthread)
+    {
+      exc.Run([&]() {
+        auto const tid = static_cast<size_t>(omp_get_thread_num());
+        size_t const begin = std::min(rows_per_thread * tid, n_rows);
+        size_t const end = std::min(begin + rows_per_thread, n_rows);
+        size_t *local = counts.data() + tid * ncol;
+        for (size_t i = begin; i < end; ++i) {
+          size_t const ridx = page.base_rowid + chunk_begin + i;
+          size_t const w_idx =
+              use_group_ind_ ? SearchGroupIndFromRow(group_ptr, ridx) : ridx;
+          auto const w = hessian.empty() ? info.GetWeight(w_idx) : hessian[ridx];
+          for (auto const &entry : batch[chunk_begin + i]) {
+            uint64_t const key = (static_cast<uint64_t>(entry.index) << 32) |
+                                 OrderedFloatBits(entry.fvalue);
+            entries[local[entry.index]++] = SortEntry{key, entry.fvalue, w};
+          }
+        }
+      });
+    }
+    exc.Rethrow();
+
+    // Radix passes, ping-ponging between the two buffers.
+    auto *in = &entries;
+    auto *out = &scratch;
+    for (int32_t byte = 0; byte < key_bytes; ++byte) {
+      RadixSortPass(*in, out, n_entries, byte * 8, nthread);
+      std::swap(in, out);
+    }
+    auto const &sorted = *in;
+
+    // Merge each column's sorted run into its sketch as one summary through
+    // the usual prune path.
+    ParallelFor(ncol, nthread, [&](size_t fid) {
+      sketches_[fid].PushSorted(sorted.data() + col_offsets[fid],
+                                sorted.data() + col_offsets[fid + 1]);
     });
+    chunk_begin = chunk_end;
   }
-  exec.Rethrow();
   monitor_.Stop(__func__);
 }
 
@@ -212,28 +359,33 @@ void HostSketchContainer::AllReduce(
   std::vector<bst_row_t> global_column_size(columns_size_);
   rabit::Allreduce<rabit::op::Sum>(global_column_size.data(), global_column_size.size());
 
-size_t nbytes = 0;
   for (size_t i = 0; i < sketches_.size(); ++i) {
     int32_t intermediate_num_cuts =  static_cast<int32_t>(std::min(
         global_column_size[i], static_cast<size_t>(max_bins_ * WQSketch::kFactor)));
+    num_cuts.push_back(intermediate_num_cuts);
+  }
+  // Each feature's summary and pruned output are independent, so prune all
+  // features in parallel instead of one at a time.
+  ParallelFor(sketches_.size(), omp_get_max_threads(), [&](size_t i) {
     if (global_column_size[i] != 0) {
       WQSketch::SummaryContainer out;
       sketches_[i].GetSummary(&out);
-      reduced[i].Reserve(intermediate_num_cuts);
+      reduced[i].Reserve(num_cuts[i]);
       CHECK(reduced[i].data);
-      reduced[i].SetPrune(out, intermediate_num_cuts);
-      nbytes = std::max(
-          WQSketch::SummaryContainer::CalcMemCost(intermediate_num_cuts),
-          nbytes);
+      reduced[i].SetPrune(out, num_cuts[i]);
     }
-
-    num_cuts.push_back(intermediate_num_cuts);
-  }
+  });
   auto world = rabit::GetWorldSize();
   if (world == 1) {
     return;
   }
 
+  if (dmlc::GetEnv("XGBOOST_SKETCH_TWO_PHASE", 0) != 0) {
+    this->TwoPhaseReduce(&reduced, num_cuts);
+    monitor_.Stop(__func__);
+    return;
+  }
+
   std::vector<size_t> worker_segments(1, 0);  // CSC pointer to sketches.
   std::vector<bst_row_t> sketches_scan((n_columns + 1) * world, 0);
 
@@ -270,6 +422,150 @@ size_t nbytes = 0;
   monitor_.Stop(__func__);
 }
 
+void HostSketchContainer::TwoPhaseReduce(
+    std::vector<WQSketch::SummaryContainer>* p_reduced,
+    std::vector<int32_t> const& num_cuts) {
+  auto& reduced = *p_reduced;
+  size_t const n_columns = sketches_.size();
+  auto world = rabit::GetWorldSize();
+  int32_t const nthreads = omp_get_max_threads();
+
+  // Phase one: gather summaries pruned down to about a kFactor-th of their
+  // synchronized size.  The merge of these coarse summaries only picks the
+  // candidate cut values; the rank accuracy lost by the aggressive pruning
+  // is repaired in the second phase.
+  std::vector<WQSketch::SummaryContainer> coarse(n_columns);
+  ParallelFor(n_columns, nthreads, [&](size_t i) {
+    if (reduced[i].size != 0) {
+      int32_t coarse_cuts = std::min(num_cuts[i], max_bins_ + 1);
+      coarse[i].Reserve(coarse_cuts);
+      coarse[i].SetPrune(reduced[i], coarse_cuts);
+    }
+  });
+  std::vector<size_t> worker_segments(1, 0);  // CSC pointer to sketches.
+  std::vector<bst_row_t> sketches_scan((n_columns + 1) * world, 0);
+  std::vector<WQSketch::Entry> global_sketches;
+  this->GatherSketchInfo(coarse, &worker_segments, &sketches_scan,
+                         &global_sketches);
+
+  // Every worker merges the same gathered data, so the candidate grids come
+  // out identical everywhere without further synchronization.
+  std::vector<WQSketch::SummaryContainer> candidates(n_columns);
+  ParallelFor(n_columns, nthreads, [&](size_t fidx) {
+    auto nbytes = WQSketch::SummaryContainer::CalcMemCost(num_cuts[fidx]);
+    WQSketch::SummaryContainer merged;
+    for (int32_t i = 1; i < world + 1; ++i) {
+      auto size = worker_segments.at(i) - worker_segments[i - 1];
+      auto worker_sketches = Span<WQSketch::Entry>{global_sketches}.subspan(
+          worker_segments[i - 1], size);
+      auto worker_scan = Span<bst_row_t>(sketches_scan)
+          .subspan((i - 1) * (n_columns + 1), (n_columns + 1));
+      auto worker_feature = worker_sketches.subspan(
+          worker_scan[fidx], worker_scan[fidx + 1] - worker_scan[fidx]);
+      WQSummary<float, float> summary(worker_feature.data(),
+                                      worker_feature.size());
+      merged.Reduce(summary, nbytes);
+    }
+    candidates[fidx].Reserve(num_cuts[fidx]);
+    candidates[fidx].SetPrune(merged, num_cuts[fidx]);
+  });
+
+  // Phase two: every worker evaluates its local summary at the shared
+  // candidate values.  The elementwise sum of {rmin, rmax, weight} triples
+  // across workers is a valid summary of the combined stream with near-exact
+  // ranks at every candidate, and its size does not grow with the number of
+  // workers.
+  std::vector<size_t> candidate_ptr(n_columns + 1, 0);
+  for (size_t i = 0; i < n_columns; ++i) {
+    candidate_ptr[i + 1] = candidate_ptr[i] + candidates[i].size;
+  }
+  std::vector<float> stats(candidate_ptr.back() * 3, 0.0f);
+  ParallelFor(n_columns, nthreads, [&](size_t i) {
+    auto const& local = reduced[i];
+    float* feature_stats = stats.data() + candidate_ptr[i] * 3;
+    for (size_t j = 0; j < candidates[i].size; ++j) {
+      float const value = candidates[i].data[j].value;
+      auto const* begin = local.data;
+      auto const* end = local.data + local.size;
+      auto const* it = std::lower_bound(
+          begin, end, value,
+          [](WQSketch::Entry const& e, float v) { return e.value < v; });
+      float rmin, rmax, weight;
+      if (it == begin && it == end) {
+        // no local mass for this feature
+        rmin = 0; rmax = 0; weight = 0;
+      } else if (it != end && it->value == value) {
+        rmin = it->rmin;
+        rmax = it->rmax;
+        weight = it->wmin;
+      } else if (it == begin) {
+        // below the local minimum
+        rmin = 0; rmax = 0; weight = 0;
+      } else if (it == end) {
+        // above the local maximum, all local mass ranks below
+        rmin = (end - 1)->RMinNext();
+        rmax = (end - 1)->rmax;
+        weight = 0;
+      } else {
+        // between two local entries, same bounds SetCombine would use
+        rmin = (it - 1)->RMinNext();
+        rmax = it->RMaxPrev();
+        weight = 0;
+      }
+      feature_stats[j * 3 + 0] = rmin;
+      feature_stats[j * 3 + 1] = rmax;
+      feature_stats[j * 3 + 2] = weight;
+    }
+  });
+  rabit::Allreduce<rabit::op::Sum>(stats.data(), stats.size());
+
+  ParallelFor(n_columns, nthreads, [&](size_t i) {
+    size_t const n_candidates = candidates[i].size;
+    if (n_candidates == 0) {
+      return;
+    }
+    std::vector<WQSketch::Entry> entries(n_candidates);
+    float const* feature_stats = stats.data() + candidate_ptr[i] * 3;
+    for (size_t j = 0; j < n_candidates; ++j) {
+      entries[j] = WQSketch::Entry(feature_stats[j * 3 + 0],
+                                   feature_stats[j * 3 + 1],
+                                   feature_stats[j * 3 + 2],
+                                   candidates[i].data[j].value);
+    }
+    WQSummary<float, float> summary(entries.data(), entries.size());
+    reduced[i].Reserve(num_cuts[i]);
+    reduced[i].SetPrune(summary, num_cuts[i]);
+  });
+}
+
+void HostSketchContainer::SaveState(dmlc::Stream* fo) {
+  monitor_.Start(__func__);
+  const uint64_t n_columns = sketches_.size();
+  fo->Write(&n_columns, sizeof(n_columns));
+  WQSketch::SummaryContainer summary;
+  for (auto& sketch : sketches_) {
+    sketch.GetSummary(&summary);
+    summary.Save(*fo);
+  }
+  monitor_.Stop(__func__);
+}
+
+void HostSketchContainer::LoadAndMergeState(dmlc::Stream* fi) {
+  monitor_.Start(__func__);
+  uint64_t n_columns = 0;
+  CHECK_EQ(fi->Read(&n_columns, sizeof(n_columns)), sizeof(n_columns));
+  CHECK_EQ(n_columns, sketches_.size())
+      << "Saved sketch state has a different number of features.";
+  WQSketch::SummaryContainer summary;
+  for (auto& sketch : sketches_) {
+    summary.Load(*fi);
+    if (summary.size != 0) {
+      sketch.PushSummary(summary);
+    }
+  }
+  monitor_.Stop(__func__);
+}
+
 void AddCutPoint(WQuantileSketch<float, float>::SummaryContainer const &summary,
                  int max_bin, HistogramCuts *cuts) {
   size_t required_cuts = std::min(summary.size, static_cast<size_t>(max_bin));
@@ -288,10 +584,15 @@ void HostSketchContainer::MakeCuts(HistogramCuts* cuts) {
   std::vector<int32_t> num_cuts;
   this->AllReduce(&reduced, &num_cuts);
 
-  cuts->min_vals_.HostVector().resize(sketches_.size(), 0.0f);
+  auto& min_vals = cuts->min_vals_.HostVector();
+  min_vals.resize(sketches_.size(), 0.0f);
 
-  for (size_t fid = 0; fid < reduced.size(); ++fid) {
-    WQSketch::SummaryContainer a;
+  // The final prune down to max_bins_ dominates cut construction on wide
+  // datasets and is independent per feature; the ordered assembly of the
+  // value and pointer arrays below is a cheap copy by comparison.
+  std::vector<WQSketch::SummaryContainer> pruned(reduced.size());
+  ParallelFor(reduced.size(), omp_get_max_threads(), [&](size_t fid) {
+    WQSketch::SummaryContainer& a = pruned[fid];
     size_t max_num_bins = std::min(num_cuts[fid], max_bins_);
     a.Reserve(max_num_bins + 1);
     CHECK(a.data);
@@ -299,12 +600,16 @@ void HostSketchContainer::MakeCuts(HistogramCuts* cuts) {
       a.SetPrune(reduced[fid], max_num_bins + 1);
       CHECK(a.data && reduced[fid].data);
       const bst_float mval = a.data[0].value;
-      cuts->min_vals_.HostVector()[fid] = mval - fabs(mval) - 1e-5f;
+      min_vals[fid] = mval - fabs(mval) - 1e-5f;
     } else {
       // Empty column.
-      const float mval = 1e-5f;
-      cuts->min_vals_.HostVector()[fid] = mval;
+      min_vals[fid] = 1e-5f;
     }
+  });
+
+  for (size_t fid = 0; fid < reduced.size(); ++fid) {
+    auto const& a = pruned[fid];
+    size_t max_num_bins = std::min(num_cuts[fid], max_bins_);
 
     AddCutPoint(a, max_num_bins, cuts);
     // push a value that is greater than anything
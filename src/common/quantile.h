@@ -8,6 +8,7 @@
 #define XGBOOST_COMMON_QUANTILE_H_
 
 #include <dmlc/base.h>
+#include <dmlc/io.h>
 #include <xgboost/logging.h>
 #include <xgboost/data.h>
 #include <cmath>
@@ -18,6 +19,12 @@
 
 #include "timer.h"
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && \
+    !defined(__CUDACC__) && !defined(__APPLE__)
+  #define XGBOOST_QUANTILE_VEC_MERGE_PRESENT 1
+  #include <immintrin.h>
+#endif  // defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+
 namespace xgboost {
 namespace common {
 /*!
@@ -244,24 +251,15 @@ struct WQSummary {
     }
   }
   /*!
-   * \brief set current summary to be merged summary of sa and sb
-   * \param sa first input summary to be merged
-   * \param sb second input summary to be merged
+   * \brief merge two sorted runs of entries into dst, the work horse of
+   *        SetCombine.  Specialized for the float instantiation below.
+   * \return one past the last entry written
    */
-  inline void SetCombine(const WQSummary &sa,
-                         const WQSummary &sb) {
-    if (sa.size == 0) {
-      this->CopyFrom(sb); return;
-    }
-    if (sb.size == 0) {
-      this->CopyFrom(sa); return;
-    }
-    CHECK(sa.size > 0 && sb.size > 0);
-    const Entry *a = sa.data, *a_end = sa.data + sa.size;
-    const Entry *b = sb.data, *b_end = sb.data + sb.size;
+  inline static Entry* MergeSorted(const Entry *a, const Entry *a_end,
+                                   const Entry *b, const Entry *b_end,
+                                   Entry *dst) {
     // extended rmin value
     RType aprev_rmin = 0, bprev_rmin = 0;
-    Entry *dst = this->data;
     while (a != a_end && b != b_end) {
       // duplicated value entry
       if (a->value == b->value) {
@@ -299,6 +297,24 @@ struct WQSummary {
         ++dst; ++b;
       } while (b != b_end);
     }
+    return dst;
+  }
+  /*!
+   * \brief set current summary to be merged summary of sa and sb
+   * \param sa first input summary to be merged
+   * \param sb second input summary to be merged
+   */
+  inline void SetCombine(const WQSummary &sa,
+                         const WQSummary &sb) {
+    if (sa.size == 0) {
+      this->CopyFrom(sb); return;
+    }
+    if (sb.size == 0) {
+      this->CopyFrom(sa); return;
+    }
+    CHECK(sa.size > 0 && sb.size > 0);
+    Entry *dst = MergeSorted(sa.data, sa.data + sa.size,
+                             sb.data, sb.data + sb.size, this->data);
     this->size = dst - data;
     const RType tol = 10;
     RType err_mingap, err_maxgap, err_wgap;
@@ -362,6 +378,65 @@ struct WQSummary {
   }
 };
 
+#if defined(XGBOOST_QUANTILE_VEC_MERGE_PRESENT)
+/* One entry of the float instantiation is exactly one 128-bit lane
+   (rmin, rmax, wmin, value), so the rank arithmetic of an output entry is a
+   single vector add plus one 16-byte store instead of four scalar stores.
+   The merge order itself stays scalar -- which entry is consumed next depends
+   on the comparison -- but every arithmetic case adds the same values in the
+   same order as the generic version, so the result is bit-identical. */
+template <>
+inline WQSummary<float, float>::Entry* WQSummary<float, float>::MergeSorted(
+    const Entry *a, const Entry *a_end, const Entry *b, const Entry *b_end,
+    Entry *dst) {
+  static_assert(sizeof(Entry) == 4 * sizeof(float), "entry must be one SSE lane");
+  // all bits set in the three rank lanes, zero in the value lane
+  const __m128 kRankMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+  float aprev_rmin = 0, bprev_rmin = 0;
+  while (a != a_end && b != b_end) {
+    const __m128 va = _mm_loadu_ps(reinterpret_cast<const float*>(a));
+    const __m128 vb = _mm_loadu_ps(reinterpret_cast<const float*>(b));
+    __m128 out;
+    if (a->value == b->value) {
+      // sum the rank lanes, keep a's value lane
+      const __m128 sum = _mm_add_ps(va, vb);
+      out = _mm_or_ps(_mm_and_ps(kRankMask, sum), _mm_andnot_ps(kRankMask, va));
+      aprev_rmin = a->RMinNext();
+      bprev_rmin = b->RMinNext();
+      ++a; ++b;
+    } else if (a->value < b->value) {
+      out = _mm_add_ps(va, _mm_setr_ps(bprev_rmin, b->rmax - b->wmin, 0.f, 0.f));
+      aprev_rmin = a->RMinNext();
+      ++a;
+    } else {
+      out = _mm_add_ps(vb, _mm_setr_ps(aprev_rmin, a->rmax - a->wmin, 0.f, 0.f));
+      bprev_rmin = b->RMinNext();
+      ++b;
+    }
+    _mm_storeu_ps(reinterpret_cast<float*>(dst), out);
+    ++dst;
+  }
+  // the remaining run gets a constant addend, one entry per iteration
+  if (a != a_end) {
+    const __m128 add = _mm_setr_ps(bprev_rmin, (b_end - 1)->rmax, 0.f, 0.f);
+    do {
+      _mm_storeu_ps(reinterpret_cast<float*>(dst),
+                    _mm_add_ps(_mm_loadu_ps(reinterpret_cast<const float*>(a)), add));
+      ++dst; ++a;
+    } while (a != a_end);
+  }
+  if (b != b_end) {
+    const __m128 add = _mm_setr_ps(aprev_rmin, (a_end - 1)->rmax, 0.f, 0.f);
+    do {
+      _mm_storeu_ps(reinterpret_cast<float*>(dst),
+                    _mm_add_ps(_mm_loadu_ps(reinterpret_cast<const float*>(b)), add));
+      ++dst; ++b;
+    } while (b != b_end);
+  }
+  return dst;
+}
+#endif  // defined(XGBOOST_QUANTILE_VEC_MERGE_PRESENT)
+
 /*! \brief try to do efficient pruning */
 template<typename DType, typename RType>
 struct WXQSummary : public WQSummary<DType, RType> {
@@ -590,6 +665,46 @@ class QuantileSketchTemplate {
     inqueue.Push(x, w);
   }
 
+  /*!
+   * \brief Merge a run of entries already sorted by value into the sketch as
+   *  one exact summary, bypassing the per-element queue maintenance of Push.
+   *  Items only need `value` and `weight` members, so callers can feed their
+   *  own staging layout; zero weight runs are skipped like in Push.
+   */
+  template <typename Iter>
+  inline void PushSorted(Iter begin, Iter end) {
+    if (begin == end) {
+      return;
+    }
+    SummaryContainer summary;
+    summary.Reserve(static_cast<size_t>(end - begin));
+    RType wsum = 0;
+    while (begin != end) {
+      const DType value = begin->value;
+      RType w = begin->weight;
+      ++begin;
+      for (; begin != end && begin->value == value; ++begin) {
+        w += begin->weight;
+      }
+      if (w != static_cast<RType>(0)) {
+        summary.data[summary.size++] = Entry(wsum, wsum + w, w, value);
+        wsum += w;
+      }
+    }
+    if (summary.size != 0) {
+      this->PushSummary(summary);
+    }
+  }
+
+  /*!
+   * \brief Bulk counterpart of Push: sort the batch once and merge it into
+   *  the sketch as one summary.  The batch is reordered in place.
+   */
+  inline void PushBatch(Span<typename Summary::Queue::QEntry> batch) {
+    std::sort(batch.begin(), batch.end());
+    this->PushSorted(batch.begin(), batch.end());
+  }
+
   inline void PushSummary(const Summary& summary) {
     temp.Reserve(limit_size * 2);
     temp.SetPrune(summary, limit_size * 2);
@@ -756,9 +871,33 @@ class HostSketchContainer {
   // Merge sketches from all workers.
   void AllReduce(std::vector<WQSketch::SummaryContainer> *p_reduced,
                  std::vector<int32_t>* p_num_cuts);
+  // Two-phase merge used by AllReduce when XGBOOST_SKETCH_TWO_PHASE is set:
+  // a coarse gather of aggressively pruned summaries picks a shared candidate
+  // grid, then a single allreduce of rank statistics on that grid replaces
+  // gathering every worker's full-sized summary.
+  void TwoPhaseReduce(std::vector<WQSketch::SummaryContainer>* p_reduced,
+                      std::vector<int32_t> const& num_cuts);
+
+  /* \brief Push a CSR matrix.
+   *
+   * \param hessian Optional per-row hessian values.  When provided they are
+   *   used as sketch weights in place of the sample weights, matching the
+   *   weighted proposals of the approx updater; sample weights are already
+   *   folded into the hessian by the objective.
+   */
+  void PushRowPage(SparsePage const& page, MetaInfo const& info,
+                   common::Span<float const> hessian = {});
 
-  /* \brief Push a CSR matrix. */
-  void PushRowPage(SparsePage const& page, MetaInfo const& info);
+  /* \brief Serialize per-feature sketch summaries so quantization can be
+   *        resumed later on refreshed data without re-sketching rows that
+   *        did not change. */
+  void SaveState(dmlc::Stream* fo);
+  /* \brief Merge summaries previously written by SaveState into the current
+   *        sketches.  Push pages holding only the new rows, then call this
+   *        before MakeCuts; the container must have been constructed with
+   *        column sizes covering old and new rows combined so that sketch
+   *        accuracy budgets hold for the merged stream. */
+  void LoadAndMergeState(dmlc::Stream* fi);
 
   void MakeCuts(HistogramCuts* cuts);
 };
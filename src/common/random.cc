@@ -2,10 +2,129 @@
  * Copyright 2020 by XGBoost Contributors
  * \file random.cc
  */
+#include <dmlc/omp.h>
+
 #include "random.h"
 
 namespace xgboost {
 namespace common {
+
+std::vector<uint8_t> StratifiedSampleRows(const std::vector<GradientPair>& gpair,
+                                          const std::vector<bst_float>& labels,
+                                          float subsample, int32_t nthread) {
+  const size_t n_rows = gpair.size();
+  CHECK_EQ(labels.size(), n_rows)
+      << "Stratified sampling requires one label per training row.";
+  std::vector<uint8_t> mask(n_rows, 0);
+  if (n_rows == 0) {
+    return mask;
+  }
+  nthread = std::max(std::min(nthread, static_cast<int32_t>(n_rows)), 1);
+  const size_t block_size = n_rows / nthread + !!(n_rows % nthread);
+
+  // resolve the class of every row and the number of classes
+  std::vector<uint32_t> classes(n_rows, 0);
+  std::vector<uint32_t> max_class(nthread, 0);
+  std::vector<uint8_t> bad_label(nthread, 0);
+#pragma omp parallel num_threads(nthread)
+  {
+    const int tid = omp_get_thread_num();
+    const size_t ibegin = tid * block_size;
+    const size_t iend = std::min(ibegin + block_size, n_rows);
+    uint32_t local_max = 0;
+    for (size_t i = ibegin; i < iend; ++i) {
+      const auto c = static_cast<uint32_t>(std::max(labels[i], 0.0f));
+      if (static_cast<bst_float>(c) != labels[i]) {
+        bad_label[tid] = 1;
+      }
+      classes[i] = c;
+      local_max = std::max(local_max, c);
+    }
+    max_class[tid] = local_max;
+  }
+  for (int32_t tid = 0; tid < nthread; ++tid) {
+    CHECK(!bad_label[tid])
+        << "Stratified sampling expects non-negative integer class labels.";
+  }
+  const size_t n_classes = static_cast<size_t>(*std::max_element(
+      max_class.begin(), max_class.end())) + 1;
+
+  // count the eligible rows of every (class, thread) pair and lay the
+  // per-class buckets out in one arena, classes major, so the selection pass
+  // can walk each class contiguously
+  std::vector<std::vector<size_t>> counts(nthread,
+                                          std::vector<size_t>(n_classes, 0));
+#pragma omp parallel num_threads(nthread)
+  {
+    const int tid = omp_get_thread_num();
+    const size_t ibegin = tid * block_size;
+    const size_t iend = std::min(ibegin + block_size, n_rows);
+    auto& local = counts[tid];
+    for (size_t i = ibegin; i < iend; ++i) {
+      if (gpair[i].GetHess() >= 0.0f) {
+        ++local[classes[i]];
+      }
+    }
+  }
+  std::vector<size_t> bucket_ptr(n_classes * nthread + 1, 0);
+  for (size_t c = 0; c < n_classes; ++c) {
+    for (int32_t t = 0; t < nthread; ++t) {
+      bucket_ptr[c * nthread + t + 1] =
+          bucket_ptr[c * nthread + t] + counts[t][c];
+    }
+  }
+
+  // one key per row from a counter-based stream indexed by the row number,
+  // so the selection is identical for every thread count; the global engine
+  // only seeds the pass
+  struct KeyedRow {
+    uint32_t key;
+    size_t row;
+  };
+  std::vector<KeyedRow> keyed(bucket_ptr.back());
+  auto& rnd = GlobalRandom();
+  uint64_t pass_seed = rnd();
+  pass_seed = (pass_seed << 32) | rnd();
+#pragma omp parallel num_threads(nthread)
+  {
+    const int tid = omp_get_thread_num();
+    const size_t ibegin = tid * block_size;
+    const size_t iend = std::min(ibegin + block_size, n_rows);
+    PhiloxEngine eng{pass_seed};
+    eng.discard(ibegin);
+    std::vector<size_t> cursor(n_classes);
+    for (size_t c = 0; c < n_classes; ++c) {
+      cursor[c] = bucket_ptr[c * nthread + tid];
+    }
+    for (size_t i = ibegin; i < iend; ++i) {
+      const uint32_t key = eng();
+      if (gpair[i].GetHess() >= 0.0f) {
+        keyed[cursor[classes[i]]++] = KeyedRow{key, i};
+      }
+    }
+  }
+
+  // keep the floor(subsample * n_c) smallest keys of every class
+  const auto n_classes_omp = static_cast<bst_omp_uint>(n_classes);
+#pragma omp parallel for schedule(dynamic) num_threads(nthread)
+  for (bst_omp_uint c = 0; c < n_classes_omp; ++c) {  // NOLINT(*)
+    const size_t begin = bucket_ptr[c * nthread];
+    const size_t end = bucket_ptr[(c + 1) * nthread];
+    const auto k = static_cast<size_t>((end - begin) * subsample);
+    if (k == 0) {
+      continue;
+    }
+    std::nth_element(keyed.begin() + begin, keyed.begin() + begin + k,
+                     keyed.begin() + end,
+                     [](const KeyedRow& a, const KeyedRow& b) {
+                       return a.key < b.key;
+                     });
+    for (size_t j = begin; j < begin + k; ++j) {
+      mask[keyed[j].row] = 1;
+    }
+  }
+  return mask;
+}
 std::shared_ptr<HostDeviceVector<bst_feature_t>> ColumnSampler::ColSample(
     std::shared_ptr<HostDeviceVector<bst_feature_t>> p_features,
     float colsample) {
@@ -21,7 +140,7 @@ std::shared_ptr<HostDeviceVector<bst_feature_t>> ColumnSampler::ColSample(
 
   if (feature_weights_.size() != 0) {
     new_features.HostVector() = WeightedSamplingWithoutReplacement(
-        p_features->HostVector(), feature_weights_, n);
+        p_features->HostVector(), feature_weights_, n, &rng_);
   } else {
     new_features.Resize(features.size());
     std::copy(features.begin(), features.end(),
@@ -34,5 +153,76 @@ std::shared_ptr<HostDeviceVector<bst_feature_t>> ColumnSampler::ColSample(
   return p_new_features;
 }
 
+void ColumnSampler::SampleNodeInto(const std::vector<bst_feature_t> &features,
+                                   PhiloxEngine *eng,
+                                   Span<bst_feature_t> out) {
+  CHECK_GT(features.size(), 0);
+  CHECK_LE(out.size(), features.size());
+
+  if (feature_weights_.size() != 0) {
+    auto sampled = WeightedSamplingWithoutReplacement(features, feature_weights_,
+                                                      out.size(), eng);
+    std::copy(sampled.begin(), sampled.end(), out.begin());
+  } else {
+    // partial Fisher-Yates, only the first out.size() positions are drawn
+    std::vector<bst_feature_t> pool(features);
+    for (size_t k = 0; k < out.size(); ++k) {
+      std::uniform_int_distribution<size_t> pick(k, pool.size() - 1);
+      std::swap(pool[k], pool[pick(*eng)]);
+      out[k] = pool[k];
+    }
+  }
+  std::sort(out.begin(), out.end());
+}
+
+void ColumnSampler::SampleFeatureSets(
+    const std::vector<int> &depths,
+    std::vector<Span<bst_feature_t const>> *out_sets) {
+  auto &sets = *out_sets;
+  sets.resize(depths.size());
+
+  if (colsample_bylevel_ == 1.0f && colsample_bynode_ == 1.0f) {
+    auto const &tree_set = feature_set_tree_->ConstHostVector();
+    for (auto &set : sets) {
+      set = {tree_set.data(), tree_set.size()};
+    }
+    return;
+  }
+  if (colsample_bynode_ == 1.0f) {
+    for (size_t i = 0; i < depths.size(); ++i) {
+      auto const &level_set = LevelFeatureSet(depths[i])->ConstHostVector();
+      sets[i] = {level_set.data(), level_set.size()};
+    }
+    return;
+  }
+  // per-node sampling: the slot of every node is known up front, and every
+  // node draws from its own counter-based stream, so the frontier is sampled
+  // in parallel with draws independent of the thread count
+  const size_t n_nodes = depths.size();
+  std::vector<const std::vector<bst_feature_t>*> level_sets(n_nodes);
+  node_set_ptr_.resize(n_nodes + 1);
+  node_set_ptr_[0] = 0;
+  for (size_t i = 0; i < n_nodes; ++i) {
+    // serial, fills the per-depth cache
+    level_sets[i] = &LevelFeatureSet(depths[i])->ConstHostVector();
+    node_set_ptr_[i + 1] =
+        node_set_ptr_[i] + SampleSize(level_sets[i]->size(), colsample_bynode_);
+  }
+  node_sets_.resize(node_set_ptr_.back());
+  const auto n_nodes_omp = static_cast<bst_omp_uint>(n_nodes);
+#pragma omp parallel for schedule(dynamic)
+  for (bst_omp_uint i = 0; i < n_nodes_omp; ++i) {  // NOLINT(*)
+    PhiloxEngine eng{philox_seed_, node_streams_used_ + i};
+    SampleNodeInto(*level_sets[i], &eng,
+                   {node_sets_.data() + node_set_ptr_[i],
+                    node_set_ptr_[i + 1] - node_set_ptr_[i]});
+  }
+  node_streams_used_ += n_nodes;
+  for (size_t i = 0; i < n_nodes; ++i) {
+    sets[i] = {node_sets_.data() + node_set_ptr_[i],
+               node_set_ptr_[i + 1] - node_set_ptr_[i]};
+  }
+}
+
 }  // namespace common
 }  // namespace xgboost
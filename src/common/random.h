@@ -20,6 +20,7 @@
 #include <utility>
 
 #include "xgboost/host_device_vector.h"
+#include "xgboost/span.h"
 #include "common.h"
 
 namespace xgboost {
@@ -78,6 +79,70 @@ using GlobalRandomEngine = RandomEngine;
  */
 GlobalRandomEngine& GlobalRandom(); // NOLINT(*)
 
+/*!
+ * \brief Counter-based random engine (Philox 4x32-10).
+ *
+ * Every draw is a pure function of (seed, stream, counter): the engine keeps
+ * no evolving state besides the counter, discard() is constant time and
+ * engines constructed with different stream ids yield independent sequences.
+ * Sampling passes can therefore be split by row block or node id and stay
+ * reproducible for every thread count, instead of forking a serial engine
+ * and advancing the copies past each other.
+ */
+class PhiloxEngine {
+ public:
+  using result_type = uint32_t;
+
+  static constexpr result_type min() { return 0; }  // NOLINT
+  static constexpr result_type max() {  // NOLINT
+    return std::numeric_limits<result_type>::max();
+  }
+
+  PhiloxEngine() = default;
+  explicit PhiloxEngine(uint64_t seed, uint64_t stream = 0)
+      : seed_{seed}, stream_{stream} {}
+
+  void seed(uint64_t s) {  // NOLINT
+    seed_ = s;
+    counter_ = 0;
+  }
+  /*! \brief advance the sequence in constant time */
+  void discard(uint64_t n) { counter_ += n; }  // NOLINT
+
+  result_type operator()() {
+    // one 4x32 block per draw, keyed by the seed with the stream folded into
+    // the upper counter words; the first output word is returned
+    uint32_t c0 = static_cast<uint32_t>(counter_);
+    uint32_t c1 = static_cast<uint32_t>(counter_ >> 32);
+    uint32_t c2 = static_cast<uint32_t>(stream_);
+    uint32_t c3 = static_cast<uint32_t>(stream_ >> 32);
+    uint32_t k0 = static_cast<uint32_t>(seed_);
+    uint32_t k1 = static_cast<uint32_t>(seed_ >> 32);
+    ++counter_;
+    for (int round = 0; round < 10; ++round) {
+      const uint64_t p0 = static_cast<uint64_t>(kMul0) * c0;
+      const uint64_t p1 = static_cast<uint64_t>(kMul1) * c2;
+      c0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+      c1 = static_cast<uint32_t>(p1);
+      c2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+      c3 = static_cast<uint32_t>(p0);
+      k0 += kWeyl0;
+      k1 += kWeyl1;
+    }
+    return c0;
+  }
+
+ private:
+  static constexpr uint32_t kMul0 = 0xD2511F53;
+  static constexpr uint32_t kMul1 = 0xCD9E8D57;
+  static constexpr uint32_t kWeyl0 = 0x9E3779B9;
+  static constexpr uint32_t kWeyl1 = 0xBB67AE85;
+
+  uint64_t seed_{0};
+  uint64_t stream_{0};
+  uint64_t counter_{0};
+};
+
 /*
  * Original paper:
  * Weighted Random Sampling (2005; Efraimidis, Spirakis)
@@ -85,17 +150,17 @@ GlobalRandomEngine& GlobalRandom(); // NOLINT(*)
  * Blog:
  * https://timvieira.github.io/blog/post/2019/09/16/algorithms-for-sampling-without-replacement/
 */
-template <typename T>
+template <typename T, typename Engine>
 std::vector<T> WeightedSamplingWithoutReplacement(
-    std::vector<T> const &array, std::vector<float> const &weights, size_t n) {
+    std::vector<T> const &array, std::vector<float> const &weights, size_t n,
+    Engine *eng) {
   // ES sampling.
   CHECK_EQ(array.size(), weights.size());
   std::vector<float> keys(weights.size());
   std::uniform_real_distribution<float> dist;
-  auto& rng = GlobalRandom();
   for (size_t i = 0; i < array.size(); ++i) {
     auto w = std::max(weights.at(i), kRtEps);
-    auto u = dist(rng);
+    auto u = dist(*eng);
     auto k = std::log(u) / w;
     keys[i] = k;
   }
@@ -110,6 +175,28 @@ std::vector<T> WeightedSamplingWithoutReplacement(
   return results;
 }
 
+/*!
+ * \brief Label-stratified row subsampling.
+ *
+ * Selects floor(subsample * n_c) rows of every label class c, so the class
+ * balance of the sample matches the training data exactly instead of only in
+ * expectation.  Every eligible row draws one key from a counter-based stream
+ * indexed by its row number in a single parallel pass over the gradient
+ * vector, and the rows with the smallest keys of each class are kept; the
+ * selection is identical for every thread count and GlobalRandom only seeds
+ * the pass.  Labels must be integer class indices; rows with a negative
+ * hessian are never selected.
+ *
+ * \param gpair     The gradient pairs, one per row.
+ * \param labels    The class label of every row.
+ * \param subsample Fraction of every class to keep.
+ * \param nthread   Number of threads of the sampling pass.
+ * \return A per-row mask, 1 for the sampled rows.
+ */
+std::vector<uint8_t> StratifiedSampleRows(const std::vector<GradientPair>& gpair,
+                                          const std::vector<bst_float>& labels,
+                                          float subsample, int32_t nthread);
+
 /**
  * \class ColumnSampler
  *
@@ -121,12 +208,57 @@ class ColumnSampler {
   std::shared_ptr<HostDeviceVector<bst_feature_t>> feature_set_tree_;
   std::map<int, std::shared_ptr<HostDeviceVector<bst_feature_t>>> feature_set_level_;
   std::vector<float> feature_weights_;
+  // flat arena holding the per-node sets of one frontier, reused between calls
+  std::vector<bst_feature_t> node_sets_;
+  std::vector<size_t> node_set_ptr_;
   float colsample_bylevel_{1.0f};
   float colsample_bytree_{1.0f};
   float colsample_bynode_{1.0f};
   GlobalRandomEngine rng_;
+  /*! \brief seed of the per-node counter-based streams, drawn from rng_ */
+  uint64_t philox_seed_{0};
+  /*! \brief number of node streams handed out since Init() */
+  uint64_t node_streams_used_{0};
+
+  /*! \brief The level set for a depth, without the per-node sampling. */
+  std::shared_ptr<HostDeviceVector<bst_feature_t>> LevelFeatureSet(int depth) {
+    if (colsample_bylevel_ == 1.0f) {
+      return feature_set_tree_;
+    }
+    if (feature_set_level_.count(depth) == 0) {
+      // Level sampling, level does not yet exist so generate it
+      feature_set_level_[depth] = ColSample(feature_set_tree_, colsample_bylevel_);
+    }
+    return feature_set_level_[depth];
+  }
+
+  /*!
+   * \brief Sample out.size() features of one node into a pre-sized slot.
+   *
+   * The engine is supplied by the caller, one counter-based stream per node,
+   * so concurrent nodes can sample without sharing rng_.
+   */
+  void SampleNodeInto(const std::vector<bst_feature_t>& features,
+                      PhiloxEngine* eng, Span<bst_feature_t> out);
+
+  /*! \brief Output size of sampling a fraction colsample of n features. */
+  static size_t SampleSize(size_t n, float colsample) {
+    return std::max(static_cast<size_t>(1),
+                    static_cast<size_t>(colsample * n));
+  }
 
  public:
+  /*!
+   * \brief Whether one fixed feature set covers every node of the tree,
+   *  i.e. neither per-level nor per-node sampling is active.
+   */
+  bool HasFixedTreeSet() const {
+    return colsample_bylevel_ == 1.0f && colsample_bynode_ == 1.0f;
+  }
+  /*! \brief The per-tree feature sample; only valid after Init(). */
+  const std::vector<bst_feature_t>& TreeFeatureSet() const {
+    return feature_set_tree_->ConstHostVector();
+  }
   std::shared_ptr<HostDeviceVector<bst_feature_t>> ColSample(
       std::shared_ptr<HostDeviceVector<bst_feature_t>> p_features, float colsample);
   /**
@@ -164,6 +296,12 @@ class ColumnSampler {
     colsample_bytree_ = colsample_bytree;
     colsample_bynode_ = colsample_bynode;
 
+    // reseed the per-node streams once per tree; rng_ is synchronized across
+    // workers, so the streams are as well
+    philox_seed_ = rng_();
+    philox_seed_ = (philox_seed_ << 32) | rng_();
+    node_streams_used_ = 0;
+
     if (feature_set_tree_ == nullptr) {
       feature_set_tree_ = std::make_shared<HostDeviceVector<bst_feature_t>>();
     }
@@ -201,17 +339,37 @@ class ColumnSampler {
       return feature_set_tree_;
     }
 
-    if (feature_set_level_.count(depth) == 0) {
-      // Level sampling, level does not yet exist so generate it
-      feature_set_level_[depth] = ColSample(feature_set_tree_, colsample_bylevel_);
-    }
     if (colsample_bynode_ == 1.0f) {
       // Level sampling
-      return feature_set_level_[depth];
+      return LevelFeatureSet(depth);
     }
-    // Need to sample for the node individually
-    return ColSample(feature_set_level_[depth], colsample_bynode_);
+    // Need to sample for the node individually; the draws come from the
+    // node's own counter-based stream, see SampleFeatureSets
+    auto const& level = LevelFeatureSet(depth)->ConstHostVector();
+    auto p_new_features = std::make_shared<HostDeviceVector<bst_feature_t>>();
+    p_new_features->Resize(SampleSize(level.size(), colsample_bynode_));
+    PhiloxEngine eng{philox_seed_, node_streams_used_++};
+    auto& new_features = p_new_features->HostVector();
+    SampleNodeInto(level, &eng, {new_features.data(), new_features.size()});
+    return p_new_features;
   }
+
+  /**
+   * \brief Samples the feature sets for a whole frontier of nodes in one pass.
+   *
+   * The sets are packed into a flat arena that is reused between calls, so
+   * the per-node allocation and shared_ptr copy of GetFeatureSet are avoided
+   * and the returned spans can be read concurrently by the split evaluation
+   * threads without synchronization.  Every node samples from its own
+   * counter-based stream, so the frontier is sampled in parallel while the
+   * draws stay identical across distributed workers and thread counts.
+   *
+   * \param depths   The tree depth of every node in the frontier.
+   * \param out_sets One span per node, pointing into the arena.  Valid until
+   *                 the next call into this sampler.
+   */
+  void SampleFeatureSets(const std::vector<int>& depths,
+                         std::vector<Span<bst_feature_t const>>* out_sets);
 };
 
 }  // namespace common
@@ -118,6 +118,19 @@ class RowSetCollection {
     elem_of_each_node_[right_node_id] = Elem(begin + n_left, e.end, right_node_id);
     elem_of_each_node_[node_id] = Elem(nullptr, nullptr, -1);
   }
+  // undo AddSplit: give the parent its contiguous span back, so the child
+  // slots can be recycled for another node
+  inline void UniteSplit(unsigned node_id,
+                         unsigned left_node_id,
+                         unsigned right_node_id) {
+    const Elem left = elem_of_each_node_[left_node_id];
+    const Elem right = elem_of_each_node_[right_node_id];
+    CHECK(left.begin != nullptr);
+    CHECK_EQ(left.end, right.begin);
+    elem_of_each_node_[node_id] = Elem(left.begin, right.end, node_id);
+    elem_of_each_node_[left_node_id] = Elem(nullptr, nullptr, -1);
+    elem_of_each_node_[right_node_id] = Elem(nullptr, nullptr, -1);
+  }
 
  private:
   // stores the row indexes in the set
@@ -80,6 +80,37 @@ class BlockedSpace2d {
     }
   }
 
+  // Variant cutting blocks by accumulated weight instead of element count,
+  // for spaces whose elements cost wildly different amounts - e.g. rows of a
+  // sparse matrix weighted by their number of entries.  A block is closed as
+  // soon as its weight reaches weight_grain, so every block carries between
+  // weight_grain and weight_grain plus one element's weight of work.
+  // Arguments:
+  // dim1 - size of the first dimension in the space
+  // getter_size_dim2 - functor to get the second dimensions for each 'row' by row-index
+  // getter_weight - functor (row-index, element-index) returning the element's weight
+  // weight_grain - weight at which a block is closed
+  template<typename Func, typename WeightFunc>
+  BlockedSpace2d(size_t dim1, Func getter_size_dim2, WeightFunc getter_weight,
+                 size_t weight_grain) {
+    for (size_t i = 0; i < dim1; ++i) {
+      const size_t size = getter_size_dim2(i);
+      size_t begin = 0;
+      size_t weight = 0;
+      for (size_t j = 0; j < size; ++j) {
+        weight += getter_weight(i, j);
+        if (weight >= weight_grain) {
+          AddBlock(i, begin, j + 1);
+          begin = j + 1;
+          weight = 0;
+        }
+      }
+      if (begin < size) {
+        AddBlock(i, begin, size);
+      }
+    }
+  }
+
   // Amount of blocks(tasks) in a space
   size_t Size() const {
     return ranges_.size();
@@ -170,6 +201,107 @@ inline int32_t OmpSetNumThreadsWithoutHT(int32_t* p_threads) {
   return nthread_original;
 }
 
+/*!
+ * \brief Per-phase thread budget calibrated during the first invocations.
+ *
+ * A single global nthread fits every phase poorly: memory-bandwidth bound
+ * loops saturate well below the core count while compute bound ones want the
+ * whole pool, and oversubscribing a small amount of work costs more in
+ * fork/join than the loop itself.  The budget times its phase at a few
+ * candidate thread counts, normalized by the amount of work the caller
+ * reports, then settles on the count with the best throughput.  Thread
+ * counts only affect how the work is blocked, so the calibration trials
+ * produce the same results as the settled runs.
+ */
+class PhaseThreadBudget {
+ public:
+  /*!
+   * \param min_work_per_thread never hand out more threads than
+   *        work / min_work_per_thread, so small invocations are not
+   *        oversubscribed; 0 disables the clamp
+   */
+  explicit PhaseThreadBudget(size_t min_work_per_thread = 0)
+      : min_work_per_thread_(min_work_per_thread) {}
+
+  /*!
+   * \brief Set the upper bound of the budget; restarts the calibration when
+   *  the bound changed.  Must be called before Threads().
+   */
+  void SetMaxThreads(int32_t max_threads) {
+    max_threads = std::max(max_threads, 1);
+    if (max_threads == max_threads_) {
+      return;
+    }
+    max_threads_ = max_threads;
+    candidates_.clear();
+    for (int32_t c : {max_threads, 3 * max_threads / 4,
+                      max_threads / 2, max_threads / 4}) {
+      c = std::max(c, 1);
+      if (std::find(candidates_.begin(), candidates_.end(), c) ==
+          candidates_.end()) {
+        candidates_.push_back(c);
+      }
+    }
+    work_.assign(candidates_.size(), 0);
+    seconds_.assign(candidates_.size(), 0.0);
+    trial_ = 0;
+    best_ = 0;
+    settled_ = candidates_.size() == 1;
+  }
+
+  /*! \brief thread count to use for an invocation covering `work` units */
+  int32_t Threads(size_t work) const {
+    int32_t threads = candidates_[settled_ ? best_ : trial_ / kTrialsPerCandidate];
+    if (min_work_per_thread_ != 0) {
+      const size_t cap = std::max<size_t>(1, work / min_work_per_thread_);
+      if (cap < static_cast<size_t>(threads)) {
+        threads = static_cast<int32_t>(cap);
+      }
+    }
+    return threads;
+  }
+
+  /*! \brief charge a timed invocation of `work` units to the trial candidate */
+  void Observe(size_t work, double seconds) {
+    if (settled_ || work == 0) {
+      return;
+    }
+    const size_t candidate = trial_ / kTrialsPerCandidate;
+    work_[candidate] += work;
+    seconds_[candidate] += seconds;
+    ++trial_;
+    if (trial_ < kTrialsPerCandidate * candidates_.size()) {
+      return;
+    }
+    // every candidate has been timed; settle on the best throughput
+    double best_throughput = 0.0;
+    for (size_t i = 0; i < candidates_.size(); ++i) {
+      const double throughput = seconds_[i] > 0.0 ? work_[i] / seconds_[i] : 0.0;
+      if (throughput > best_throughput) {
+        best_throughput = throughput;
+        best_ = i;
+      }
+    }
+    settled_ = true;
+    LOG(DEBUG) << "Thread budget settled on " << candidates_[best_]
+               << " of " << max_threads_ << " threads";
+  }
+
+ private:
+  // invocations timed per candidate before moving to the next one
+  static constexpr size_t kTrialsPerCandidate = 3;
+
+  size_t min_work_per_thread_;
+  int32_t max_threads_ {0};
+  std::vector<int32_t> candidates_;
+  // accumulated work and time per candidate during calibration
+  std::vector<size_t> work_;
+  std::vector<double> seconds_;
+  size_t trial_ {0};
+  size_t best_ {0};
+  bool settled_ {false};
+};
+
 }  // namespace common
 }  // namespace xgboost
 
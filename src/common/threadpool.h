@@ -0,0 +1,189 @@
+/*!
+ * Copyright 2021 by Contributors
+ * \file threadpool.h
+ * \brief Persistent work-stealing thread pool.
+ *
+ * OpenMP opens a fresh parallel region for every call, which is measurably
+ * expensive when the hist updater processes many small tree nodes deep in a
+ * tree.  The pool below keeps its workers alive between calls and lets idle
+ * workers steal blocks from busy ones, so small nodes do not serialize on
+ * region startup.
+ */
+#ifndef XGBOOST_COMMON_THREADPOOL_H_
+#define XGBOOST_COMMON_THREADPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "xgboost/logging.h"
+#include "threading_utils.h"
+
+namespace xgboost {
+namespace common {
+
+/*!
+ * \brief Fixed-size pool of worker threads executing blocks of an index
+ *        space.  Blocks are initially distributed in contiguous chunks (the
+ *        same layout ParallelFor2d produces); a worker that drains its own
+ *        chunk steals single blocks from the tail of other workers' chunks.
+ */
+class WorkStealingThreadPool {
+ public:
+  explicit WorkStealingThreadPool(size_t n_workers)
+      : n_workers_(std::max<size_t>(1, n_workers)),
+        next_(n_workers_), end_(n_workers_) {
+    workers_.reserve(n_workers_);
+    for (size_t tid = 0; tid < n_workers_; ++tid) {
+      workers_.emplace_back([this, tid]() { this->WorkerLoop(tid); });
+    }
+  }
+
+  ~WorkStealingThreadPool() {
+    {
+      std::unique_lock<std::mutex> lock(mu_);
+      shutdown_ = true;
+      epoch_++;
+    }
+    cv_start_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  WorkStealingThreadPool(WorkStealingThreadPool const&) = delete;
+  WorkStealingThreadPool& operator=(WorkStealingThreadPool const&) = delete;
+
+  size_t NumWorkers() const { return n_workers_; }
+
+  /*!
+   * \brief Execute func(worker_id, block_id) for every block in
+   *        [0, n_blocks); returns when all blocks are processed.  Exceptions
+   *        thrown by func are re-thrown here on the calling thread.
+   *        n_active_workers caps how many workers share the blocks - worker
+   *        ids stay below the cap - so a phase that scales worse than the
+   *        pool can run narrower without rebuilding the pool; 0 uses all.
+   */
+  template <typename Func>
+  void Execute(size_t n_blocks, Func const& func, size_t n_active_workers = 0) {
+    if (n_blocks == 0) {
+      return;
+    }
+    const size_t n_sharing = n_active_workers == 0
+        ? n_workers_
+        : std::min(std::max<size_t>(1, n_active_workers), n_workers_);
+    const size_t chunk_size = n_blocks / n_sharing + !!(n_blocks % n_sharing);
+    for (size_t tid = 0; tid < n_workers_; ++tid) {
+      const size_t begin = std::min(chunk_size * tid, n_blocks);
+      next_[tid].store(begin, std::memory_order_relaxed);
+      end_[tid].store(std::min(begin + chunk_size, n_blocks), std::memory_order_relaxed);
+    }
+    task_ = [&func](size_t worker_id, size_t block_id) { func(worker_id, block_id); };
+    exception_ = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(mu_);
+      n_sharing_ = n_sharing;
+      n_active_ = n_workers_;
+      epoch_++;
+    }
+    cv_start_.notify_all();
+    {
+      std::unique_lock<std::mutex> lock(mu_);
+      cv_done_.wait(lock, [this]() { return n_active_ == 0; });
+    }
+    task_ = nullptr;
+    if (exception_) {
+      std::rethrow_exception(exception_);
+    }
+  }
+
+  /*!
+   * \brief Work-stealing counterpart of common::ParallelFor2d; the functor
+   *        additionally receives the executing worker id as no OpenMP thread
+   *        id is available inside pool workers.
+   */
+  template <typename Func>
+  void ParallelFor2d(const BlockedSpace2d& space, Func const& func,
+                     size_t n_active_workers = 0) {
+    Execute(space.Size(), [&space, &func](size_t worker_id, size_t block_id) {
+      func(worker_id, space.GetFirstDimension(block_id), space.GetRange(block_id));
+    }, n_active_workers);
+  }
+
+ private:
+  void WorkerLoop(size_t tid) {
+    uint64_t last_epoch = 0;
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(mu_);
+        cv_start_.wait(lock, [this, last_epoch]() {
+          return shutdown_ || epoch_ != last_epoch;
+        });
+        if (shutdown_) {
+          return;
+        }
+        last_epoch = epoch_;
+      }
+      RunBlocks(tid);
+      {
+        std::unique_lock<std::mutex> lock(mu_);
+        if (--n_active_ == 0) {
+          cv_done_.notify_all();
+        }
+      }
+    }
+  }
+
+  void RunBlocks(size_t tid) {
+    // workers above the sharing cap sit this task out
+    if (tid >= n_sharing_) {
+      return;
+    }
+    try {
+      // drain own chunk first, then steal single blocks from other workers
+      for (size_t victim = tid; victim < tid + n_sharing_; ++victim) {
+        const size_t v = victim % n_sharing_;
+        for (;;) {
+          const size_t block = next_[v].fetch_add(1, std::memory_order_relaxed);
+          if (block >= end_[v].load(std::memory_order_relaxed)) {
+            break;
+          }
+          task_(tid, block);
+        }
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> guard(exc_mu_);
+      if (!exception_) {
+        exception_ = std::current_exception();
+      }
+    }
+  }
+
+  const size_t n_workers_;
+  std::vector<std::thread> workers_;
+  // per-worker [next, end) block ranges; stealing bumps the victim's counter
+  std::vector<std::atomic<size_t>> next_;
+  std::vector<std::atomic<size_t>> end_;
+  std::function<void(size_t, size_t)> task_;
+
+  std::mutex mu_;
+  std::condition_variable cv_start_;
+  std::condition_variable cv_done_;
+  uint64_t epoch_ = 0;
+  size_t n_active_ = 0;
+  // workers sharing the blocks of the current task; set per Execute call
+  size_t n_sharing_ = 0;
+  bool shutdown_ = false;
+
+  std::mutex exc_mu_;
+  std::exception_ptr exception_;
+};
+
+}  // namespace common
+}  // namespace xgboost
+
+#endif  // XGBOOST_COMMON_THREADPOOL_H_
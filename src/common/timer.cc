@@ -3,6 +3,7 @@
  */
 #include <rabit/rabit.h>
 #include <algorithm>
+#include <set>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -17,26 +18,22 @@
 namespace xgboost {
 namespace common {
 
-void Monitor::Start(std::string const &name) {
-  if (ConsoleLogger::ShouldLog(ConsoleLogger::LV::kDebug)) {
-    auto &stats = statistics_map_[name];
-    stats.timer.Start();
+void Monitor::StartImpl(std::string const &name) {
+  auto &stats = statistics_map_[name];
+  stats.timer.Start();
 #if defined(XGBOOST_USE_NVTX)
-    std::string nvtx_name = label_ + "::" + name;
-    stats.nvtx_id = nvtxRangeStartA(nvtx_name.c_str());
+  std::string nvtx_name = label_ + "::" + name;
+  stats.nvtx_id = nvtxRangeStartA(nvtx_name.c_str());
 #endif  // defined(XGBOOST_USE_NVTX)
-  }
 }
 
-void Monitor::Stop(const std::string &name) {
-  if (ConsoleLogger::ShouldLog(ConsoleLogger::LV::kDebug)) {
-    auto &stats = statistics_map_[name];
-    stats.timer.Stop();
-    stats.count++;
+void Monitor::StopImpl(const std::string &name) {
+  auto &stats = statistics_map_[name];
+  stats.timer.Stop();
+  stats.count++;
 #if defined(XGBOOST_USE_NVTX)
-    nvtxRangeEnd(stats.nvtx_id);
+  nvtxRangeEnd(stats.nvtx_id);
 #endif  // defined(XGBOOST_USE_NVTX)
-  }
 }
 
 std::vector<Monitor::StatMap> Monitor::CollectFromOtherRanks() const {
@@ -107,8 +104,43 @@ void Monitor::PrintStatistics(StatMap const& statistics) const {
   }
 }
 
+void Monitor::PrintWorldStatistics(std::vector<StatMap> const& world) const {
+  // Union of phase names; other workers may have timers this one hasn't started.
+  std::set<std::string> names;
+  for (auto const& statistic : world) {
+    for (auto const& kv : statistic) {
+      names.insert(kv.first);
+    }
+  }
+
+  for (auto const& name : names) {
+    // elapsed microseconds paired with the owning rank
+    std::vector<std::pair<size_t, size_t>> elapsed;
+    for (size_t i = 0; i < world.size(); ++i) {
+      auto it = world[i].find(name);
+      if (it != world[i].cend() && it->second.first != 0) {
+        elapsed.emplace_back(it->second.second, i);
+      }
+    }
+    if (elapsed.empty()) {
+      continue;
+    }
+    std::sort(elapsed.begin(), elapsed.end());
+    auto const& min = elapsed.front();
+    auto const& max = elapsed.back();
+    auto const& med = elapsed[elapsed.size() / 2];
+    LOG(CONSOLE) << name << ": min " << static_cast<double>(min.first) / 1e+6
+                 << "s (rank " << min.second << "), median "
+                 << static_cast<double>(med.first) / 1e+6 << "s, max "
+                 << static_cast<double>(max.first) / 1e+6 << "s (rank "
+                 << max.second << "), " << elapsed.size() << "/" << world.size()
+                 << " ranks" << std::endl;
+  }
+}
+
 void Monitor::Print() const {
-  if (!ConsoleLogger::ShouldLog(ConsoleLogger::LV::kDebug)) { return; }
+  if (!ConsoleLogger::DebugCompiledIn() ||
+      !ConsoleLogger::ShouldLog(ConsoleLogger::LV::kDebug)) { return; }
 
   bool is_distributed = rabit::IsDistributed();
 
@@ -117,6 +149,9 @@ void Monitor::Print() const {
     // rank zero is in charge of printing
     if (rabit::GetRank() == 0) {
       LOG(CONSOLE) << "======== Monitor: " << label_ << " ========";
+      // Summary across ranks first: a straggling worker shows up as the max
+      // holder without reading through every rank's block below.
+      this->PrintWorldStatistics(world);
       for (size_t i = 0; i < world.size(); ++i) {
         LOG(CONSOLE) << "From rank: " << i << ": " << std::endl;
         auto const& statistic = world[i];
@@ -62,6 +62,10 @@ struct Monitor {
   /*! \brief Collect time statistics across all workers. */
   std::vector<StatMap> CollectFromOtherRanks() const;
   void PrintStatistics(StatMap const& statistics) const;
+  void StartImpl(const std::string& name);
+  void StopImpl(const std::string& name);
+  /*! \brief Per-phase min/median/max over all workers, for finding stragglers. */
+  void PrintWorldStatistics(std::vector<StatMap> const& world) const;
 
  public:
   Monitor() { self_timer_.Start(); }
@@ -80,8 +84,28 @@ struct Monitor {
   void Print() const;
 
   void Init(std::string label) { this->label_ = label; }
-  void Start(const std::string &name);
-  void Stop(const std::string &name);
+  /* The verbosity gate lives here in the header: builds stripping debug
+   * logging fold Start/Stop into no-ops, and other builds skip the
+   * out-of-line call (map lookup, possible NVTX range) unless the user asked
+   * for debug output.  Start/Stop sit on hot paths such as the per-frontier
+   * phases of the hist updater, so the common case must be a predicted-taken
+   * early return. */
+  void Start(const std::string &name) {
+    if (XGBOOST_EXPECT(!ConsoleLogger::DebugCompiledIn() ||
+                           !ConsoleLogger::ShouldLog(ConsoleLogger::LV::kDebug),
+                       true)) {
+      return;
+    }
+    this->StartImpl(name);
+  }
+  void Stop(const std::string &name) {
+    if (XGBOOST_EXPECT(!ConsoleLogger::DebugCompiledIn() ||
+                           !ConsoleLogger::ShouldLog(ConsoleLogger::LV::kDebug),
+                       true)) {
+      return;
+    }
+    this->StopImpl(name);
+  }
 };
 }  // namespace common
 }  // namespace xgboost
@@ -8,6 +8,7 @@
 #include <dmlc/common.h>
 
 #include <xgboost/data.h>
+#include <algorithm>
 #include <utility>
 #include <vector>
 #include <type_traits>  // enable_if
@@ -165,14 +166,49 @@ class Transform {
     }
 #endif  // defined(__CUDACC__)
 
+    /*! \brief Unroll factor of the per-thread element loop. */
+    static constexpr omp_ulong kUnroll = 4;
+
+    /*!
+     * \brief Run the functor over one contiguous block of indices.
+     *
+     * The spans are taken by value so the element loop reads them from
+     * registers, and the fixed-trip inner loop unrolls at compile time.
+     */
+    template <typename... SpanType>
+    void EvalBlock(Functor func, omp_ulong begin, omp_ulong end,
+                   SpanType... spans) const {
+      omp_ulong idx = begin;
+      for (; idx + kUnroll <= end; idx += kUnroll) {
+        for (omp_ulong u = 0; u < kUnroll; ++u) {
+          func(idx + u, spans...);
+        }
+      }
+      for (; idx < end; ++idx) {
+        func(idx, spans...);
+      }
+    }
+
     template <typename... HDV>
     void LaunchCPU(Functor func, HDV*... vectors) const {
       omp_ulong end = static_cast<omp_ulong>(*(range_.end()));
       dmlc::OMPException omp_exc;
       SyncHost(vectors...);
-#pragma omp parallel for schedule(static)
-      for (omp_ulong idx = 0; idx < end; ++idx) {
-        omp_exc.Run(func, idx, UnpackHDV(vectors)...);
+      // every thread owns one contiguous block: the spans are unpacked once
+      // per block instead of once per element, and the exception guard wraps
+      // the block instead of putting a try/catch around every element
+      const auto nthread = static_cast<omp_ulong>(omp_get_max_threads());
+      const omp_ulong block_size = end / nthread + !!(end % nthread);
+#pragma omp parallel num_threads(nthread)
+      {
+        omp_exc.Run([&] {
+          const auto tid = static_cast<omp_ulong>(omp_get_thread_num());
+          const omp_ulong ibegin = tid * block_size;
+          const omp_ulong iend = std::min(ibegin + block_size, end);
+          if (ibegin < iend) {
+            this->EvalBlock(func, ibegin, iend, UnpackHDV(vectors)...);
+          }
+        });
       }
       omp_exc.Rethrow();
     }
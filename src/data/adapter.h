@@ -115,6 +115,13 @@ class NoMetaInfo {
 
 class CSRAdapterBatch : public detail::NoMetaInfo {
  public:
+  // Whether GetLine(i) yields the elements of row i, in row order.  Row major
+  // batches can be pushed into a SparsePage without grouping by key.
+  static constexpr bool kIsRowMajor = true;
+  // Whether every line holds one element per feature, with the column index
+  // equal to the element's position.  Dense batches qualify for the all-valid
+  // fast path of the row major push.
+  static constexpr bool kIsDense = false;
   class Line {
    public:
     Line(size_t row_idx, size_t size, const unsigned* feature_idx,
@@ -177,6 +184,8 @@ class CSRAdapter : public detail::SingleBatchDataIter<CSRAdapterBatch> {
 
 class DenseAdapterBatch : public detail::NoMetaInfo {
  public:
+  static constexpr bool kIsRowMajor = true;
+  static constexpr bool kIsDense = true;
   DenseAdapterBatch(const float* values, size_t num_rows, size_t num_features)
       : values_(values),
         num_rows_(num_rows),
@@ -230,6 +239,8 @@ class DenseAdapter : public detail::SingleBatchDataIter<DenseAdapterBatch> {
 
 class CSCAdapterBatch : public detail::NoMetaInfo {
  public:
+  static constexpr bool kIsRowMajor = false;
+  static constexpr bool kIsDense = false;
   CSCAdapterBatch(const size_t* col_ptr, const unsigned* row_idx,
                   const float* values, size_t num_features)
       : col_ptr_(col_ptr),
@@ -295,6 +306,8 @@ class CSCAdapter : public detail::SingleBatchDataIter<CSCAdapterBatch> {
 
 class DataTableAdapterBatch : public detail::NoMetaInfo {
  public:
+  static constexpr bool kIsRowMajor = false;
+  static constexpr bool kIsDense = false;
   DataTableAdapterBatch(void** data, const char** feature_stypes,
                         size_t num_rows, size_t num_features)
       : data_(data),
@@ -422,8 +435,148 @@ class DataTableAdapter
   size_t num_columns_;
 };
 
+/** \brief Adapter for Arrow style columnar data.  Each feature is a
+ *  contiguous buffer of a primitive type with an optional validity bitmap in
+ *  Arrow layout (least significant bit first).  Buffers are referenced in
+ *  place, the only copy happens when the DMatrix page is built. */
+class ColumnarAdapterBatch : public detail::NoMetaInfo {
+ public:
+  static constexpr bool kIsRowMajor = false;
+  static constexpr bool kIsDense = false;
+  ColumnarAdapterBatch(void const** data, const char** feature_stypes,
+                       uint8_t const** validity, size_t num_rows,
+                       size_t num_features)
+      : data_(data),
+        feature_stypes_(feature_stypes),
+        validity_(validity),
+        num_features_(num_features),
+        num_rows_(num_rows) {}
+
+ private:
+  enum class ColumnType : uint8_t {
+    kFloat32 = 0,
+    kFloat64 = 1,
+    kInt8 = 2,
+    kInt16 = 3,
+    kInt32 = 4,
+    kInt64 = 5,
+    kUnknown = 6
+  };
+
+  ColumnType GetType(std::string type_string) const {
+    if (type_string == "float32") {
+      return ColumnType::kFloat32;
+    } else if (type_string == "float64") {
+      return ColumnType::kFloat64;
+    } else if (type_string == "int8") {
+      return ColumnType::kInt8;
+    } else if (type_string == "int16") {
+      return ColumnType::kInt16;
+    } else if (type_string == "int32") {
+      return ColumnType::kInt32;
+    } else if (type_string == "int64") {
+      return ColumnType::kInt64;
+    } else {
+      LOG(FATAL) << "Unknown columnar type.";
+      return ColumnType::kUnknown;
+    }
+  }
+
+  class Line {
+    float GetValue(size_t ridx) const {
+      float missing = std::numeric_limits<float>::quiet_NaN();
+      if (validity_ != nullptr &&
+          ((validity_[ridx / 8] >> (ridx % 8)) & 1) == 0) {
+        return missing;
+      }
+      switch (type_) {
+        case ColumnType::kFloat32: {
+          float val = reinterpret_cast<const float*>(column_)[ridx];
+          return std::isfinite(val) ? val : missing;
+        }
+        case ColumnType::kFloat64: {
+          double val = reinterpret_cast<const double*>(column_)[ridx];
+          return std::isfinite(val) ? static_cast<float>(val) : missing;
+        }
+        case ColumnType::kInt8:
+          return static_cast<float>(
+              reinterpret_cast<const int8_t*>(column_)[ridx]);
+        case ColumnType::kInt16:
+          return static_cast<float>(
+              reinterpret_cast<const int16_t*>(column_)[ridx]);
+        case ColumnType::kInt32:
+          return static_cast<float>(
+              reinterpret_cast<const int32_t*>(column_)[ridx]);
+        case ColumnType::kInt64:
+          return static_cast<float>(
+              reinterpret_cast<const int64_t*>(column_)[ridx]);
+        default: {
+          LOG(FATAL) << "Unknown columnar type.";
+          return 0.0f;
+        }
+      }
+    }
+
+   public:
+    Line(ColumnType type, size_t size, size_t column_idx, const void* column,
+         uint8_t const* validity)
+        : type_(type),
+          size_(size),
+          column_idx_(column_idx),
+          column_(column),
+          validity_(validity) {}
+
+    size_t Size() const { return size_; }
+    COOTuple GetElement(size_t idx) const {
+      return COOTuple{idx, column_idx_, GetValue(idx)};
+    }
+
+   private:
+    ColumnType type_;
+    size_t size_;
+    size_t column_idx_;
+    const void* column_;
+    uint8_t const* validity_;
+  };
+
+ public:
+  size_t Size() const { return num_features_; }
+  const Line GetLine(size_t idx) const {
+    return Line(GetType(feature_stypes_[idx]), num_rows_, idx, data_[idx],
+                validity_ == nullptr ? nullptr : validity_[idx]);
+  }
+
+ private:
+  void const** data_;
+  const char** feature_stypes_;
+  uint8_t const** validity_;
+  size_t num_features_;
+  size_t num_rows_;
+};
+
+class ColumnarAdapter
+    : public detail::SingleBatchDataIter<ColumnarAdapterBatch> {
+ public:
+  ColumnarAdapter(void const** data, const char** feature_stypes,
+                  uint8_t const** validity, size_t num_rows,
+                  size_t num_features)
+      : batch_(data, feature_stypes, validity, num_rows, num_features),
+        num_rows_(num_rows),
+        num_columns_(num_features) {}
+  const ColumnarAdapterBatch& Value() const override { return batch_; }
+  size_t NumRows() const { return num_rows_; }
+  size_t NumColumns() const { return num_columns_; }
+
+ private:
+  ColumnarAdapterBatch batch_;
+  size_t num_rows_;
+  size_t num_columns_;
+};
+
 class FileAdapterBatch {
  public:
+  static constexpr bool kIsRowMajor = true;
+  static constexpr bool kIsDense = false;
   class Line {
    public:
     Line(size_t row_idx, const uint32_t *feature_idx, const float *value,
@@ -3,7 +3,9 @@
  * \file data.cc
  */
 #include <dmlc/registry.h>
+#include <algorithm>
 #include <cstring>
+#include <numeric>
 
 #include "dmlc/io.h"
 #include "xgboost/data.h"
@@ -15,6 +17,7 @@
 #include "sparse_page_writer.h"
 #include "simple_dmatrix.h"
 
+#include "../common/common.h"
 #include "../common/io.h"
 #include "../common/math.h"
 #include "../common/version.h"
@@ -133,11 +136,36 @@ uint64_t constexpr MetaInfo::kNumField;
 void MetaInfo::Clear() {
   num_row_ = num_col_ = num_nonzero_ = 0;
   labels_.HostVector().clear();
+  packed_label_state_ = 0;
+  packed_labels_.clear();
   group_ptr_.clear();
   weights_.HostVector().clear();
   base_margin_.HostVector().clear();
 }
 
+std::vector<uint32_t> const& MetaInfo::TryPackedLabels() const {
+  if (packed_label_state_ == 0) {
+    auto const& labels = labels_.ConstHostVector();
+    bool const binary =
+        !labels.empty() &&
+        std::all_of(labels.cbegin(), labels.cend(),
+                    [](float y) { return y == 0.0f || y == 1.0f; });
+    if (binary) {
+      packed_labels_.assign((labels.size() + 31) / 32, 0u);
+      for (size_t i = 0; i < labels.size(); ++i) {
+        if (labels[i] == 1.0f) {
+          packed_labels_[i / 32] |= 1u << (i % 32);
+        }
+      }
+      packed_label_state_ = 1;
+    } else {
+      packed_labels_.clear();
+      packed_label_state_ = -1;
+    }
+  }
+  return packed_labels_;
+}
+
 /*
  * Binary serialization format for MetaInfo:
  *
@@ -241,6 +269,8 @@ void MetaInfo::LoadBinary(dmlc::Stream *fi) {
   LoadScalarField(fi, u8"num_col", DataType::kUInt64, &num_col_);
   LoadScalarField(fi, u8"num_nonzero", DataType::kUInt64, &num_nonzero_);
   LoadVectorField(fi, u8"labels", DataType::kFloat32, &labels_);
+  packed_label_state_ = 0;
+  packed_labels_.clear();
   LoadVectorField(fi, u8"group_ptr", DataType::kUInt32, &group_ptr_);
   LoadVectorField(fi, u8"weights", DataType::kFloat32, &weights_);
   LoadVectorField(fi, u8"base_margin", DataType::kFloat32, &base_margin_);
@@ -360,6 +390,8 @@ void MetaInfo::SetInfo(const char* key, const void* dptr, DataType dtype, size_t
     labels.resize(num);
     DISPATCH_CONST_PTR(dtype, dptr, cast_dptr,
                        std::copy(cast_dptr, cast_dptr + num, labels.begin()));
+    packed_label_state_ = 0;
+    packed_labels_.clear();
   } else if (!std::strcmp(key, "weight")) {
     auto& weights = weights_.HostVector();
     weights.resize(num);
@@ -406,6 +438,47 @@ void MetaInfo::SetInfo(const char* key, const void* dptr, DataType dtype, size_t
   }
 }
 
+void MetaInfo::SetGroupPtrFromQids(const std::vector<uint64_t>& qids, int32_t nthread) {
+  group_ptr_.clear();
+  const size_t n = qids.size();
+  if (n == 0) {
+    return;
+  }
+  nthread = std::max(std::min(nthread, static_cast<int32_t>(n)), 1);
+  const size_t block_size = n / nthread + !!(n % nthread);
+  // pass 1: each chunk counts its boundaries, a row being a boundary when its
+  // query id differs from that of the previous row
+  std::vector<size_t> counts(nthread, 0);
+#pragma omp parallel for schedule(static) num_threads(nthread)
+  for (omp_ulong tid = 0; tid < static_cast<omp_ulong>(nthread); ++tid) {
+    const size_t ibegin = tid * block_size;
+    const size_t iend = std::min(ibegin + block_size, n);
+    size_t cnt = 0;
+    for (size_t i = ibegin; i < iend; ++i) {
+      cnt += i == 0 || qids[i] != qids[i - 1];
+    }
+    counts[tid] = cnt;
+  }
+  std::vector<size_t> offsets(nthread + 1, 0);
+  for (int32_t tid = 0; tid < nthread; ++tid) {
+    offsets[tid + 1] = offsets[tid] + counts[tid];
+  }
+  // pass 2: every chunk knows where its boundaries land, write them out
+  group_ptr_.resize(offsets[nthread] + 1);
+#pragma omp parallel for schedule(static) num_threads(nthread)
+  for (omp_ulong tid = 0; tid < static_cast<omp_ulong>(nthread); ++tid) {
+    const size_t ibegin = tid * block_size;
+    const size_t iend = std::min(ibegin + block_size, n);
+    size_t out = offsets[tid];
+    for (size_t i = ibegin; i < iend; ++i) {
+      if (i == 0 || qids[i] != qids[i - 1]) {
+        group_ptr_[out++] = static_cast<bst_group_t>(i);
+      }
+    }
+  }
+  group_ptr_.back() = static_cast<bst_group_t>(n);
+}
+
 void MetaInfo::GetInfo(char const *key, bst_ulong *out_len, DataType dtype,
                        const void **out_dptr) const {
   if (dtype == DataType::kFloat32) {
@@ -490,6 +563,8 @@ void MetaInfo::Extend(MetaInfo const& that, bool accumulate_rows) {
 
   this->labels_.SetDevice(that.labels_.DeviceIdx());
   this->labels_.Extend(that.labels_);
+  packed_label_state_ = 0;
+  packed_labels_.clear();
 
   this->weights_.SetDevice(that.weights_.DeviceIdx());
   this->weights_.Extend(that.weights_);
@@ -614,12 +689,31 @@ DMatrix* DMatrix::Load(const std::string& uri,
                        const std::string& file_format,
                        const size_t page_size) {
   std::string fname, cache_file;
+  size_t effective_page_size = page_size;
   size_t dlm_pos = uri.find('#');
   if (dlm_pos != std::string::npos) {
     cache_file = uri.substr(dlm_pos + 1, uri.length());
     fname = uri.substr(0, dlm_pos);
     CHECK_EQ(cache_file.find('#'), std::string::npos)
         << "Only one `#` is allowed in file path for cache file specification.";
+    // Optional per-cache page size, e.g. "data#cache.ps-1048576" asks for one
+    // megabyte pages.  Larger pages favour sequential devices, smaller ones
+    // reduce the memory held by in-flight pages.
+    size_t ps_pos = cache_file.find(".ps-");
+    if (ps_pos != std::string::npos) {
+      size_t digits_end =
+          cache_file.find_first_not_of("0123456789", ps_pos + 4);
+      if (digits_end == std::string::npos) {
+        digits_end = cache_file.length();
+      }
+      CHECK_GT(digits_end, ps_pos + 4)
+          << "Invalid page size in cache file specification: " << cache_file;
+      effective_page_size = std::stoull(
+          cache_file.substr(ps_pos + 4, digits_end - ps_pos - 4));
+      CHECK_NE(effective_page_size, 0U)
+          << "Page size in cache file specification cannot be 0.";
+      cache_file.erase(ps_pos, digits_end - ps_pos);
+    }
     if (load_row_split) {
       std::ostringstream os;
       std::vector<std::string> cache_shards = common::Split(cache_file, ':');
@@ -669,7 +763,10 @@ DMatrix* DMatrix::Load(const std::string& uri,
           dmlc::ByteSwap(&magic, sizeof(magic), 1);
         }
         if (magic == data::SimpleDMatrix::kMagic) {
-          DMatrix* dmat = new data::SimpleDMatrix(&is);
+          auto* dmat = new data::SimpleDMatrix(&is);
+          // the exact updaters persist the sorted column page next to the
+          // binary matrix, so repeated trainings skip the transpose and sort
+          dmat->SetSortedPageCacheFile(fname + ".sorted.col.page");
           if (!silent) {
             LOG(CONSOLE) << dmat->Info().num_row_ << 'x' << dmat->Info().num_col_ << " matrix with "
               << dmat->Info().num_nonzero_ << " entries loaded from " << uri;
@@ -686,8 +783,11 @@ DMatrix* DMatrix::Load(const std::string& uri,
   DMatrix* dmat {nullptr};
 
   try {
-    dmat = DMatrix::Create(&adapter, std::numeric_limits<float>::quiet_NaN(), 1,
-                           cache_file, page_size);
+    // 0 threads means use all available threads.  Tokenizing is pipelined
+    // inside the dmlc parser, while converting the parsed blocks into the
+    // SparsePage runs here and used to be the single threaded bottleneck.
+    dmat = DMatrix::Create(&adapter, std::numeric_limits<float>::quiet_NaN(), 0,
+                           cache_file, effective_page_size);
   } catch (dmlc::Error& e) {
     std::vector<std::string> splited = common::Split(fname, '#');
     std::vector<std::string> args = common::Split(splited.front(), '?');
@@ -790,6 +890,9 @@ template DMatrix* DMatrix::Create<data::CSCAdapter>(
 template DMatrix* DMatrix::Create<data::DataTableAdapter>(
     data::DataTableAdapter* adapter, float missing, int nthread,
     const std::string& cache_prefix, size_t page_size);
+template DMatrix* DMatrix::Create<data::ColumnarAdapter>(
+    data::ColumnarAdapter* adapter, float missing, int nthread,
+    const std::string& cache_prefix, size_t page_size);
 template DMatrix* DMatrix::Create<data::FileAdapter>(
     data::FileAdapter* adapter, float missing, int nthread,
     const std::string& cache_prefix, size_t page_size);
@@ -799,57 +902,341 @@ DMatrix::Create(data::IteratorAdapter<DataIterHandle, XGBCallbackDataIterNext,
                 float missing, int nthread, const std::string &cache_prefix,
                 size_t page_size);
 
+namespace {
+/*! \brief A transposed entry together with its column, staged in the tile
+ *  buckets of GetTranspose before concatenation. */
+struct TransposeEntry {
+  bst_uint column;
+  Entry value;
+};
+}  // anonymous namespace
+
+/*
+ * The counts are accumulated into per-thread arrays and reduced, the same
+ * shape the group builder uses for keyed counting.  Building the index once
+ * lets every later GetTranspose of the page take its column offsets from it
+ * instead of re-counting the staged entries; the column and sorted-column
+ * pages of an in-memory matrix each transpose the same rows, so the pass is
+ * shared between them.
+ */
+void SparsePage::BuildFeatureIndex(int num_columns) {
+  const auto n_columns = static_cast<size_t>(num_columns);
+  if (feature_counts.size() == n_columns) {
+    return;
+  }
+  feature_counts.assign(n_columns, 0);
+  const size_t batch_size = this->Size();
+  if (batch_size == 0) {
+    return;
+  }
+  const int nthread = std::max(
+      std::min(omp_get_max_threads(), static_cast<int>(batch_size)), 1);
+  std::vector<std::vector<size_t>> tloc(
+      nthread, std::vector<size_t>(n_columns, 0));
+#pragma omp parallel num_threads(nthread)
+  {
+    const int tid = omp_get_thread_num();
+    const size_t row_begin = tid * batch_size / nthread;
+    const size_t row_end = (tid + 1) * batch_size / nthread;
+    auto& counts = tloc[tid];
+    for (size_t i = row_begin; i < row_end; ++i) {
+      for (const auto& entry : (*this)[i]) {
+        ++counts[entry.index];
+      }
+    }
+  }
+  for (const auto& counts : tloc) {
+    for (size_t j = 0; j < n_columns; ++j) {
+      feature_counts[j] += counts[j];
+    }
+  }
+}
+
+/*
+ * Blocked two-pass transpose.  The group builder used previously scattered
+ * every entry straight to its final CSC position, striding the whole output
+ * matrix and saturating the TLB on large inputs.  Instead the columns are cut
+ * into tiles and each thread first buckets the entries of its row range by
+ * tile with purely sequential writes; the concatenation pass then works one
+ * tile at a time, so its scatter stays inside one tile-sized output window
+ * that remains cache and TLB resident.
+ */
 SparsePage SparsePage::GetTranspose(int num_columns) const {
   SparsePage transpose;
-  common::ParallelGroupBuilder<Entry, bst_row_t> builder(&transpose.offset.HostVector(),
-                                                         &transpose.data.HostVector());
-  const int nthread = omp_get_max_threads();
-  builder.InitBudget(num_columns, nthread);
-  long batch_size = static_cast<long>(this->Size());  // NOLINT(*)
-#pragma omp parallel for default(none) shared(batch_size, builder) schedule(static)
-  for (long i = 0; i < batch_size; ++i) {  // NOLINT(*)
-    int tid = omp_get_thread_num();
-    auto inst = (*this)[i];
-    for (const auto& entry : inst) {
-      builder.AddBudget(entry.index, tid);
+  auto& rptr = transpose.offset.HostVector();
+  auto& cdata = transpose.data.HostVector();
+  const auto n_columns = static_cast<size_t>(num_columns);
+  const size_t batch_size = this->Size();
+  const size_t n_entries = this->data.Size();
+  rptr.assign(n_columns + 1, 0);
+  if (n_entries == 0) {
+    return transpose;
+  }
+  const int nthread = std::max(
+      std::min(omp_get_max_threads(), static_cast<int>(batch_size)), 1);
+  // Narrow tiles keep the concatenation window small; the floor keeps a few
+  // tiles per thread on matrices with few columns.
+  const size_t tile_cols = std::min<size_t>(
+      std::max<size_t>(n_columns / (static_cast<size_t>(nthread) * 4), 1), 4096);
+  const size_t n_tiles = n_columns / tile_cols + !!(n_columns % tile_cols);
+
+  // First pass over the rows: count the entries of each (thread, tile) pair.
+  std::vector<std::vector<size_t>> tile_count(
+      nthread, std::vector<size_t>(n_tiles, 0));
+#pragma omp parallel num_threads(nthread)
+  {
+    const int tid = omp_get_thread_num();
+    const size_t row_begin = tid * batch_size / nthread;
+    const size_t row_end = (tid + 1) * batch_size / nthread;
+    auto& counts = tile_count[tid];
+    for (size_t i = row_begin; i < row_end; ++i) {
+      for (const auto& entry : (*this)[i]) {
+        ++counts[entry.index / tile_cols];
+      }
     }
   }
-  builder.InitStorage();
-#pragma omp parallel for default(none) shared(batch_size, builder) schedule(static)
-  for (long i = 0; i < batch_size; ++i) {  // NOLINT(*)
-    int tid = omp_get_thread_num();
-    auto inst = (*this)[i];
-    for (const auto& entry : inst) {
-      builder.Push(
-          entry.index,
-          Entry(static_cast<bst_uint>(this->base_rowid + i), entry.fvalue),
-          tid);
+
+  // Bucket layout inside one staging arena, tiles major, so every tile's
+  // buckets from all threads are adjacent for the concatenation pass.
+  std::vector<size_t> bucket_ptr(n_tiles * nthread + 1, 0);
+  for (size_t j = 0; j < n_tiles; ++j) {
+    for (int t = 0; t < nthread; ++t) {
+      bucket_ptr[j * nthread + t + 1] =
+          bucket_ptr[j * nthread + t] + tile_count[t][j];
+    }
+  }
+  std::vector<TransposeEntry> staged(n_entries);
+  common::MadviseHugePages(staged.data(), n_entries * sizeof(TransposeEntry));
+
+  // Second pass over the rows: every thread appends to its own buckets, so
+  // all writes advance a handful of sequential cursors.
+#pragma omp parallel num_threads(nthread)
+  {
+    const int tid = omp_get_thread_num();
+    const size_t row_begin = tid * batch_size / nthread;
+    const size_t row_end = (tid + 1) * batch_size / nthread;
+    std::vector<size_t> cursor(n_tiles);
+    for (size_t j = 0; j < n_tiles; ++j) {
+      cursor[j] = bucket_ptr[j * nthread + tid];
+    }
+    for (size_t i = row_begin; i < row_end; ++i) {
+      const auto row_id = static_cast<bst_uint>(this->base_rowid + i);
+      for (const auto& entry : (*this)[i]) {
+        staged[cursor[entry.index / tile_cols]++] =
+            TransposeEntry{entry.index, Entry(row_id, entry.fvalue)};
+      }
+    }
+  }
+
+  // Per-column counts; taken from the feature index when one was built,
+  // otherwise counted from the staged entries, where tiles own disjoint
+  // column ranges so no synchronization is needed.
+  const auto n_tiles_omp = static_cast<bst_omp_uint>(n_tiles);
+  if (feature_counts.size() == n_columns) {
+    std::copy(feature_counts.cbegin(), feature_counts.cend(),
+              rptr.begin() + 1);
+  } else {
+#pragma omp parallel for schedule(dynamic)
+    for (bst_omp_uint j = 0; j < n_tiles_omp; ++j) {
+      for (size_t k = bucket_ptr[j * nthread];
+           k < bucket_ptr[(j + 1) * nthread]; ++k) {
+        ++rptr[staged[k].column + 1];
+      }
+    }
+  }
+  std::partial_sum(rptr.begin(), rptr.end(), rptr.begin());
+
+  // Concatenate tile by tile.  Buckets are visited in thread order and the
+  // threads held increasing row ranges, so each column stays sorted by row,
+  // as the group builder guaranteed.
+  cdata.resize(n_entries);
+#pragma omp parallel for schedule(dynamic)
+  for (bst_omp_uint j = 0; j < n_tiles_omp; ++j) {
+    const size_t col_begin = j * tile_cols;
+    std::vector<bst_row_t> cursor(
+        rptr.begin() + col_begin,
+        rptr.begin() + std::min(col_begin + tile_cols, n_columns));
+    for (size_t k = bucket_ptr[j * nthread]; k < bucket_ptr[(j + 1) * nthread];
+         ++k) {
+      cdata[cursor[staged[k].column - col_begin]++] = staged[k].value;
     }
   }
   return transpose;
 }
 void SparsePage::Push(const SparsePage &batch) {
+  feature_counts.clear();
   auto& data_vec = data.HostVector();
   auto& offset_vec = offset.HostVector();
   const auto& batch_offset_vec = batch.offset.HostVector();
   const auto& batch_data_vec = batch.data.HostVector();
   size_t top = offset_vec.back();
-  data_vec.resize(top + batch.data.Size());
+  // Resize amortizes growth, so ingesting a stream of pages of unknown total
+  // size does not reallocate and copy the accumulated data per batch.
+  data.Resize(top + batch.data.Size());
   if (dmlc::BeginPtr(data_vec) && dmlc::BeginPtr(batch_data_vec)) {
     std::memcpy(dmlc::BeginPtr(data_vec) + top, dmlc::BeginPtr(batch_data_vec),
                 sizeof(Entry) * batch.data.Size());
   }
   size_t begin = offset.Size();
-  offset_vec.resize(begin + batch.Size());
+  offset.Resize(begin + batch.Size());
   for (size_t i = 0; i < batch.Size(); ++i) {
     offset_vec[i + begin] = top + batch_offset_vec[i + 1];
   }
 }
 
+/*
+ * Push for row major adapters.  Line i of the batch is row `page->Size() + i`
+ * of the page, so the valid entries of each row can be counted independently,
+ * a prefix sum turns the counts into final offsets, and a second pass writes
+ * every entry straight to its final position.  Unlike the group builder used
+ * for the general case this keeps neither per-thread row budgets (which cost
+ * nthread * num_rows memory) nor a serial accumulation over them.
+ */
+template <typename AdapterBatchT>
+uint64_t PushRowMajorBatch(SparsePage* page, const AdapterBatchT& batch,
+                           float missing, int nthread) {
+  auto& offset_vec = page->offset.HostVector();
+  auto& data_vec = page->data.HostVector();
+  const size_t base_offset = page->Size();
+  const size_t batch_size = batch.Size();
+  const size_t thread_size = batch_size / nthread;
+  if (offset_vec.empty()) {
+    offset_vec.push_back(0);
+  }
+  offset_vec.resize(base_offset + batch_size + 1);
+
+  std::vector<uint64_t> max_columns_vector(nthread, 0);
+  dmlc::OMPException exec;
+
+  // Dense batches are usually complete.  Probe that with a branch-free
+  // all-valid scan; when nothing is missing the offsets are uniform and the
+  // entries copy over without any per-element test.  Batches with missing
+  // values fall through to the generic two passes below.
+  if (AdapterBatchT::kIsDense) {
+    const size_t num_features = batch.GetLine(0).Size();
+    std::vector<uint8_t> thread_valid(nthread, 1);
+#pragma omp parallel num_threads(nthread)
+    {
+      exec.Run([&]() {
+        int tid = omp_get_thread_num();
+        size_t begin = tid * thread_size;
+        size_t end = tid != (nthread - 1) ? (tid + 1) * thread_size : batch_size;
+        uint8_t ok = 1;
+        for (size_t i = begin; i < end; ++i) {
+          auto line = batch.GetLine(i);
+          for (auto j = 0ull; j < line.Size(); j++) {
+            const float value = line.GetElement(j).value;
+            ok &= static_cast<uint8_t>(!common::CheckNAN(value) &&
+                                       value != missing);
+          }
+        }
+        thread_valid[tid] = ok;
+      });
+    }
+    exec.Rethrow();
+    if (std::all_of(thread_valid.cbegin(), thread_valid.cend(),
+                    [](uint8_t v) { return v != 0; })) {
+      for (size_t i = 0; i < batch_size; ++i) {
+        offset_vec[base_offset + i + 1] =
+            offset_vec[base_offset + i] + num_features;
+      }
+      data_vec.resize(offset_vec.back());
+#pragma omp parallel num_threads(nthread)
+      {
+        exec.Run([&]() {
+          int tid = omp_get_thread_num();
+          size_t begin = tid * thread_size;
+          size_t end =
+              tid != (nthread - 1) ? (tid + 1) * thread_size : batch_size;
+          for (size_t i = begin; i < end; ++i) {
+            auto line = batch.GetLine(i);
+            Entry* out = data_vec.data() + offset_vec[base_offset + i];
+            for (auto j = 0ull; j < line.Size(); j++) {
+              out[j] = Entry(static_cast<bst_feature_t>(j),
+                             line.GetElement(j).value);
+            }
+          }
+        });
+      }
+      exec.Rethrow();
+      return num_features;
+    }
+  }
+
+  // First pass over the batch, counting valid entries of each row
+#pragma omp parallel num_threads(nthread)
+  {
+    exec.Run([&]() {
+      int tid = omp_get_thread_num();
+      size_t begin = tid * thread_size;
+      size_t end = tid != (nthread - 1) ? (tid + 1) * thread_size : batch_size;
+      uint64_t& max_columns_local = max_columns_vector[tid];
+
+      for (size_t i = begin; i < end; ++i) {
+        auto line = batch.GetLine(i);
+        bst_row_t valid = 0;
+        for (auto j = 0ull; j < line.Size(); j++) {
+          auto element = line.GetElement(j);
+          max_columns_local = std::max(
+              max_columns_local, static_cast<uint64_t>(element.column_idx + 1));
+          if (!common::CheckNAN(element.value) && element.value != missing) {
+            ++valid;
+          }
+        }
+        offset_vec[base_offset + i + 1] = valid;
+      }
+    });
+  }
+  exec.Rethrow();
+
+  // turn the counts into final offsets
+  for (size_t i = base_offset; i < base_offset + batch_size; ++i) {
+    offset_vec[i + 1] += offset_vec[i];
+  }
+  data_vec.resize(offset_vec.back());
+
+  // Second pass over the batch, writing entries to their final position
+#pragma omp parallel num_threads(nthread)
+  {
+    exec.Run([&]() {
+      int tid = omp_get_thread_num();
+      size_t begin = tid * thread_size;
+      size_t end = tid != (nthread - 1) ? (tid + 1) * thread_size : batch_size;
+      for (size_t i = begin; i < end; ++i) {
+        auto line = batch.GetLine(i);
+        size_t out = offset_vec[base_offset + i];
+        for (auto j = 0ull; j < line.Size(); j++) {
+          auto element = line.GetElement(j);
+          if (!common::CheckNAN(element.value) && element.value != missing) {
+            data_vec[out++] = Entry(element.column_idx, element.value);
+          }
+        }
+      }
+    });
+  }
+  exec.Rethrow();
+
+  uint64_t max_columns = 0;
+  for (const auto& max : max_columns_vector) {
+    max_columns = std::max(max_columns, max);
+  }
+  return max_columns;
+}
+
 template <typename AdapterBatchT>
 uint64_t SparsePage::Push(const AdapterBatchT& batch, float missing, int nthread) {
+  feature_counts.clear();
   // Set number of threads but keep old value so we can reset it after
   int nthread_original = common::OmpSetNumThreadsWithoutHT(&nthread);
+  if (batch.Size() == 0) {
+    omp_set_num_threads(nthread_original);
+    return 0;
+  }
+  if (AdapterBatchT::kIsRowMajor) {
+    uint64_t max_columns = PushRowMajorBatch(this, batch, missing, nthread);
+    omp_set_num_threads(nthread_original);
+    return max_columns;
+  }
   auto& offset_vec = offset.HostVector();
   auto& data_vec = data.HostVector();
 
@@ -939,6 +1326,7 @@ uint64_t SparsePage::Push(const AdapterBatchT& batch, float missing, int nthread
 }
 
 void SparsePage::PushCSC(const SparsePage &batch) {
+  feature_counts.clear();
   std::vector<xgboost::Entry>& self_data = data.HostVector();
   std::vector<bst_row_t>& self_offset = offset.HostVector();
 
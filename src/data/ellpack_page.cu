@@ -37,13 +37,21 @@ __global__ void CompressBinEllpackKernel(
     size_t base_row,                        // batch_row_begin
     size_t n_rows,
     size_t row_stride,
-    unsigned int null_gidx_value) {
+    unsigned int null_gidx_value,
+    const size_t* __restrict__ overflow_row_ptr,  // null without overflow section
+    size_t overflow_base) {
   size_t irow = threadIdx.x + blockIdx.x * blockDim.x;
   int ifeature = threadIdx.y + blockIdx.y * blockDim.y;
-  if (irow >= n_rows || ifeature >= row_stride) {
+  if (irow >= n_rows) {
     return;
   }
   int row_length = static_cast<int>(row_ptrs[irow + 1] - row_ptrs[irow]);
+  if (ifeature >= static_cast<int>(row_stride) &&
+      (overflow_row_ptr == nullptr || ifeature >= row_length)) {
+    // Entries past the dense stride go to the overflow section, which is not
+    // padded with null values.
+    return;
+  }
   unsigned int bin = null_gidx_value;
   if (ifeature < row_length) {
     Entry entry = entries[row_ptrs[irow] - row_ptrs[0] + ifeature];
@@ -72,7 +80,14 @@ __global__ void CompressBinEllpackKernel(
     bin += cut_rows[feature];
   }
   // Write to gidx buffer.
-  wr.AtomicWriteSymbol(buffer, bin, (irow + base_row) * row_stride + ifeature);
+  size_t out_position;
+  if (ifeature < static_cast<int>(row_stride)) {
+    out_position = (irow + base_row) * row_stride + ifeature;
+  } else {
+    out_position = overflow_base + overflow_row_ptr[irow + base_row] +
+                   (ifeature - row_stride);
+  }
+  wr.AtomicWriteSymbol(buffer, bin, out_position);
 }
 
 // Construct an ELLPACK matrix with the given number of empty rows.
@@ -101,6 +116,74 @@ EllpackPageImpl::EllpackPageImpl(int device, common::HistogramCuts cuts,
   this->CreateHistIndices(device, page, feature_types);
 }
 
+namespace {
+// Choose the dense stride of the hybrid layout by minimizing the number of
+// stored symbols: rows within the stride are padded as in plain ELLPACK, while
+// the tails of longer rows go to an overflow CSR section.  Fills the overflow
+// CSR pointer, which is left empty when plain ELLPACK is already (close to)
+// optimal, e.g. when row lengths are uniform.
+size_t ChooseRowStride(DMatrix* dmat, std::vector<size_t>* p_overflow_row_ptr) {
+  std::vector<size_t> row_lengths;
+  row_lengths.reserve(dmat->Info().num_row_);
+  for (const auto& batch : dmat->GetBatches<SparsePage>()) {
+    const auto& row_offset = batch.offset.ConstHostVector();
+    for (auto i = 1ull; i < row_offset.size(); i++) {
+      row_lengths.push_back(row_offset[i] - row_offset[i - 1]);
+    }
+  }
+  size_t n_rows = row_lengths.size();
+  if (n_rows == 0) {
+    return 0;
+  }
+
+  std::vector<size_t> sorted(row_lengths);
+  std::sort(sorted.begin(), sorted.end());
+  // Suffix sums of sorted lengths, to evaluate each candidate stride in O(1).
+  std::vector<size_t> suffix_sum(n_rows + 1, 0);
+  for (size_t i = n_rows; i > 0; --i) {
+    suffix_sum[i - 1] = suffix_sum[i] + sorted[i - 1];
+  }
+
+  size_t const max_stride = sorted.back();
+  size_t const plain_cost = n_rows * max_stride;
+  size_t best_stride = max_stride;
+  size_t best_cost = plain_cost;
+  // Walk distinct lengths from long to short so ties keep the larger stride.
+  // Only strides turning less than 1% of the rows into overflow rows are
+  // considered: the hybrid layout targets a few outlier rows inflating the
+  // stride, not genuinely skewed length distributions.
+  for (size_t i = n_rows; i-- > 0;) {
+    if (i + 1 < n_rows && sorted[i] == sorted[i + 1]) {
+      continue;
+    }
+    size_t stride = sorted[i];
+    size_t n_longer = n_rows - (i + 1);
+    if (n_longer * 100 > n_rows) {
+      break;
+    }
+    size_t cost = n_rows * stride + suffix_sum[i + 1] - n_longer * stride;
+    if (cost < best_cost) {
+      best_cost = cost;
+      best_stride = stride;
+    }
+  }
+  // Only switch to the hybrid layout for a tangible gain; the plain dense
+  // block is simpler and slightly faster to index.
+  if (best_stride == max_stride || best_cost + plain_cost / 16 > plain_cost) {
+    return max_stride;
+  }
+
+  auto& overflow_row_ptr = *p_overflow_row_ptr;
+  overflow_row_ptr.resize(n_rows + 1, 0);
+  for (size_t i = 0; i < n_rows; ++i) {
+    size_t extra =
+        row_lengths[i] > best_stride ? row_lengths[i] - best_stride : 0;
+    overflow_row_ptr[i + 1] = overflow_row_ptr[i] + extra;
+  }
+  return best_stride;
+}
+}  // anonymous namespace
+
 // Construct an ELLPACK matrix in memory.
 EllpackPageImpl::EllpackPageImpl(DMatrix* dmat, const BatchParam& param)
     : is_dense(dmat->IsDense()) {
@@ -111,7 +194,12 @@ EllpackPageImpl::EllpackPageImpl(DMatrix* dmat, const BatchParam& param)
 
   monitor_.Start("Quantiles");
   // Create the quantile sketches for the dmatrix and initialize HistogramCuts.
-  row_stride = GetRowStride(dmat);
+  std::vector<size_t> overflow_row_ptr_h;
+  row_stride = is_dense ? GetRowStride(dmat)
+                        : ChooseRowStride(dmat, &overflow_row_ptr_h);
+  if (!overflow_row_ptr_h.empty()) {
+    overflow_row_ptr.HostVector() = std::move(overflow_row_ptr_h);
+  }
   cuts_ = common::DeviceSketch(param.gpu_id, dmat, param.max_bin);
   monitor_.Stop("Quantiles");
 
@@ -309,6 +397,7 @@ size_t EllpackPageImpl::Copy(int device, EllpackPageImpl* page, size_t offset) {
   size_t num_elements = page->n_rows * page->row_stride;
   CHECK_EQ(row_stride, page->row_stride);
   CHECK_EQ(NumSymbols(), page->NumSymbols());
+  CHECK_EQ(page->OverflowSize(), 0) << "Cannot copy a hybrid-layout page.";
   CHECK_GE(n_rows * row_stride, offset + num_elements);
   if (page == this) {
     LOG(FATAL) << "Concatenating the same Ellpack.";
@@ -369,6 +458,7 @@ void EllpackPageImpl::Compact(int device, EllpackPageImpl* page,
   monitor_.Start("Compact");
   CHECK_EQ(row_stride, page->row_stride);
   CHECK_EQ(NumSymbols(), page->NumSymbols());
+  CHECK_EQ(page->OverflowSize(), 0) << "Cannot compact a hybrid-layout page.";
   CHECK_LE(page->base_rowid + page->n_rows, row_indexes.size());
   gidx_buffer.SetDevice(device);
   page->gidx_buffer.SetDevice(device);
@@ -380,10 +470,11 @@ void EllpackPageImpl::Compact(int device, EllpackPageImpl* page,
 void EllpackPageImpl::InitCompressedData(int device) {
   size_t num_symbols = NumSymbols();
 
-  // Required buffer size for storing data matrix in ELLPack format.
+  // Required buffer size for storing data matrix in ELLPack format, plus the
+  // overflow section for rows longer than the dense stride.
   size_t compressed_size_bytes =
-    common::CompressedBufferWriter::CalculateBufferSize(row_stride * n_rows,
-      num_symbols);
+    common::CompressedBufferWriter::CalculateBufferSize(
+      row_stride * n_rows + OverflowSize(), num_symbols);
   gidx_buffer.SetDevice(device);
   // Don't call fill unnecessarily
   if (gidx_buffer.Size() == 0) {
@@ -403,6 +494,17 @@ void EllpackPageImpl::CreateHistIndices(int device,
 
   const auto& offset_vec = row_batch.offset.ConstHostVector();
 
+  // With an overflow section the compression grid has to reach the tails of
+  // rows longer than the dense stride.
+  size_t max_row_length = row_stride;
+  if (overflow_row_ptr.Size() != 0) {
+    for (auto i = 1ull; i < offset_vec.size(); ++i) {
+      max_row_length = std::max(
+          max_row_length, static_cast<size_t>(offset_vec[i] - offset_vec[i - 1]));
+    }
+    overflow_row_ptr.SetDevice(device);
+  }
+
   // bin and compress entries in batches of rows
   size_t gpu_batch_nrows =
       std::min(dh::TotalMemory(device) / (16 * row_stride * sizeof(Entry)),
@@ -434,7 +536,7 @@ void EllpackPageImpl::CreateHistIndices(int device,
                                   n_entries * sizeof(Entry), cudaMemcpyDefault));
     const dim3 block3(32, 8, 1);  // 256 threads
     const dim3 grid3(common::DivRoundUp(batch_nrows, block3.x),
-                     common::DivRoundUp(row_stride, block3.y), 1);
+                     common::DivRoundUp(max_row_length, block3.y), 1);
     auto device_accessor = GetDeviceAccessor(device);
     dh::LaunchKernel {grid3, block3}(
         CompressBinEllpackKernel, common::CompressedBufferWriter(NumSymbols()),
@@ -442,7 +544,10 @@ void EllpackPageImpl::CreateHistIndices(int device,
         entries_d.data().get(), device_accessor.gidx_fvalue_map.data(),
         device_accessor.feature_segments.data(), feature_types,
         row_batch.base_rowid + batch_row_begin, batch_nrows, row_stride,
-        null_gidx_value);
+        null_gidx_value,
+        overflow_row_ptr.Size() != 0 ? overflow_row_ptr.ConstDevicePointer()
+                                     : nullptr,
+        n_rows * row_stride);
   }
 }
 
@@ -461,9 +566,15 @@ size_t EllpackPageImpl::MemCostBytes(size_t num_rows, size_t row_stride,
 
 EllpackDeviceAccessor EllpackPageImpl::GetDeviceAccessor(int device) const {
   gidx_buffer.SetDevice(device);
+  common::Span<const size_t> overflow{};
+  if (overflow_row_ptr.Size() != 0) {
+    overflow_row_ptr.SetDevice(device);
+    overflow = overflow_row_ptr.ConstDeviceSpan();
+  }
   return EllpackDeviceAccessor(
       device, cuts_, is_dense, row_stride, base_rowid, n_rows,
       common::CompressedIterator<uint32_t>(gidx_buffer.ConstDevicePointer(),
-                                           NumSymbols()));
+                                           NumSymbols()),
+      overflow);
 }
 }  // namespace xgboost
@@ -30,14 +30,21 @@ struct EllpackDeviceAccessor {
   common::Span<const uint32_t> feature_segments;
   /*! \brief Histogram cut values. Size equals to (bins per feature * number of features). */
   common::Span<const bst_float> gidx_fvalue_map;
+  /*! \brief CSR pointer into the overflow section holding the tail of rows
+   * longer than row_stride.  Size equals to (number of rows + 1) when the page
+   * has an overflow section, empty otherwise.  The overflow symbols are stored
+   * in gidx_iter after the dense block, starting at (n_rows * row_stride). */
+  common::Span<const size_t> overflow_row_ptr;
 
   EllpackDeviceAccessor(int device, const common::HistogramCuts& cuts,
                         bool is_dense, size_t row_stride, size_t base_rowid,
-                        size_t n_rows,common::CompressedIterator<uint32_t> gidx_iter)
+                        size_t n_rows,common::CompressedIterator<uint32_t> gidx_iter,
+                        common::Span<const size_t> overflow_row_ptr = {})
       : is_dense(is_dense),
         row_stride(row_stride),
         base_rowid(base_rowid),
-        n_rows(n_rows) ,gidx_iter(gidx_iter){
+        n_rows(n_rows) ,gidx_iter(gidx_iter),
+        overflow_row_ptr(overflow_row_ptr) {
     cuts.cut_values_.SetDevice(device);
     cuts.cut_ptrs_.SetDevice(device);
     cuts.min_vals_.SetDevice(device);
@@ -60,6 +67,16 @@ struct EllpackDeviceAccessor {
                                      gidx_iter,
                                      feature_segments[fidx],
                                      feature_segments[fidx + 1]);
+      if (gidx == -1 && !overflow_row_ptr.empty()) {
+        // The tail of rows longer than row_stride lives in the overflow
+        // section, which keeps the same sorted-by-feature order.
+        auto overflow_base = n_rows * row_stride;
+        gidx = common::BinarySearchBin(overflow_base + overflow_row_ptr[ridx],
+                                       overflow_base + overflow_row_ptr[ridx + 1],
+                                       gidx_iter,
+                                       feature_segments[fidx],
+                                       feature_segments[fidx + 1]);
+      }
     }
     return gidx;
   }
@@ -203,6 +220,16 @@ public:
   size_t n_rows{};
   /*! \brief global index of histogram, which is stored in ELLPack format. */
   HostDeviceVector<common::CompressedByteT> gidx_buffer;
+  /*! \brief CSR pointer into the overflow section for rows longer than
+   * row_stride.  Empty unless the page is built with a hybrid layout, where a
+   * few outlier rows would otherwise inflate the stride of the whole page. */
+  HostDeviceVector<size_t> overflow_row_ptr;
+
+  /*! \return Number of symbols stored in the overflow section. */
+  size_t OverflowSize() const {
+    return overflow_row_ptr.Size() == 0 ? 0
+                                        : overflow_row_ptr.ConstHostVector().back();
+  }
 
  private:
   common::HistogramCuts cuts_;
@@ -10,6 +10,10 @@
 namespace xgboost {
 namespace data {
 
+// Placeholder for the device page cache, which only exists in CUDA builds;
+// the member is never populated here as the constructor aborts.
+class EllpackPageDeviceCache {};
+
 EllpackPageSource::EllpackPageSource(DMatrix* dmat,
                                      const std::string& cache_info,
                                      const BatchParam& param) noexcept(false) {
@@ -18,6 +22,15 @@ EllpackPageSource::EllpackPageSource(DMatrix* dmat,
          "XGBoost is not compiled with CUDA but EllpackPageSource is required";
 }
 
+BatchSet<EllpackPage> EllpackPageSource::GetBatchSet() {
+  LOG(FATAL)
+      << "Internal Error: "
+         "XGBoost is not compiled with CUDA but EllpackPageSource is required";
+  return BatchSet<EllpackPage>(BatchIterator<EllpackPage>(nullptr));
+}
+
+EllpackPageSource::~EllpackPageSource() = default;
+
 }  // namespace data
 }  // namespace xgboost
 #endif  // DMLC_ENABLE_STD_THREAD
@@ -1,6 +1,7 @@
 /*!
  * Copyright 2019 XGBoost contributors
  */
+#include <future>
 #include <memory>
 #include <utility>
 
@@ -13,6 +14,164 @@
 namespace xgboost {
 namespace data {
 
+/*!
+ * \brief Device-memory-aware cache over the external-memory ELLPACK stream.
+ *
+ * On the first pass the leading pages are moved into a device-resident set
+ * until a memory budget is exhausted; the device copy made when the updater
+ * accessed the page is captured before the prefetcher recycles it, so caching
+ * adds no extra transfers.  Later passes serve the resident prefix from
+ * device memory and fall back to the disk prefetcher for the remainder.
+ *
+ * The access pattern is strictly cyclic, so evicting the least recently used
+ * page would always evict the page needed next; pinning the leading pages is
+ * the policy a cyclic LRU converges to, without the churn.  While the
+ * resident prefix is being served, a background task drains the skipped
+ * pages from the prefetcher, which overlaps the disk reads of the first
+ * streamed pages with compute on the resident ones.
+ *
+ * The budget defaults to half of the free device memory when the cache is
+ * created, leaving room for histograms and tree building; it can be
+ * overridden with XGBOOST_EXTMEM_DEVICE_CACHE_MB (0 disables the cache).
+ *
+ * Exposes the BeforeFirst/Next/Value protocol of ExternalMemoryPrefetcher so
+ * it plugs into SparseBatchIteratorImpl.  Like the prefetcher it is not
+ * thread safe.
+ */
+class EllpackPageDeviceCache {
+ public:
+  EllpackPageDeviceCache(ExternalMemoryPrefetcher<EllpackPage>* source,
+                         int device)
+      : source_{source} {
+    int64_t budget_mb = dmlc::GetEnv("XGBOOST_EXTMEM_DEVICE_CACHE_MB",
+                                     static_cast<int64_t>(-1));
+    if (budget_mb >= 0) {
+      budget_bytes_ = static_cast<size_t>(budget_mb) << 20;
+    } else {
+      budget_bytes_ = dh::AvailableMemory(device) / 2;
+    }
+  }
+
+  void BeforeFirst() {
+    if (skip_.valid()) {
+      skip_.wait();
+    }
+    serve_idx_ = 0;
+    current_ = nullptr;
+    if (first_epoch_) {
+      // A restart during the first epoch (or the initial start) rebuilds the
+      // resident set from scratch.
+      resident_.clear();
+      used_bytes_ = 0;
+      accepting_ = true;
+      source_->BeforeFirst();
+      return;
+    }
+    if (all_resident_) {
+      return;
+    }
+    source_->BeforeFirst();
+    if (!resident_.empty()) {
+      skip_ = std::async(std::launch::async, [this] {
+        for (size_t i = 0; i < resident_.size(); ++i) {
+          CHECK(source_->Next());
+        }
+      });
+    }
+  }
+
+  bool Next() {
+    if (first_epoch_) {
+      return NextFirstEpoch();
+    }
+    if (serve_idx_ < resident_.size()) {
+      current_ = resident_[serve_idx_++].get();
+      return true;
+    }
+    if (all_resident_) {
+      return false;
+    }
+    if (skip_.valid()) {
+      skip_.get();
+    }
+    if (!source_->Next()) {
+      return false;
+    }
+    current_ = &source_->Value();
+    return true;
+  }
+
+  EllpackPage& Value() { return *current_; }
+  const EllpackPage& Value() const { return *current_; }
+
+ private:
+  bool NextFirstEpoch() {
+    // Retire the page handed out last time before the prefetcher recycles
+    // it.  Caching stops at the first page that does not fit: keeping a
+    // strict prefix resident is what makes later epochs a simple
+    // serve-then-stream sequence.
+    if (current_ != nullptr && accepting_) {
+      auto* impl = current_->Impl();
+      size_t bytes = impl->gidx_buffer.Size() * sizeof(common::CompressedByteT) +
+                     impl->overflow_row_ptr.Size() * sizeof(size_t);
+      if (used_bytes_ + bytes <= budget_bytes_) {
+        resident_.emplace_back(new EllpackPage());
+        *resident_.back()->Impl() = std::move(*impl);
+        used_bytes_ += bytes;
+      } else {
+        accepting_ = false;
+      }
+    }
+    if (!source_->Next()) {
+      first_epoch_ = false;
+      all_resident_ = accepting_;
+      current_ = nullptr;
+      if (!resident_.empty()) {
+        LOG(INFO) << "EllpackPageDeviceCache: " << resident_.size()
+                  << " page(s) resident, " << (used_bytes_ >> 20UL)
+                  << " MB of " << (budget_bytes_ >> 20UL) << " MB budget"
+                  << (all_resident_ ? ", whole dataset fits in device memory"
+                                    : "");
+      }
+      return false;
+    }
+    current_ = &source_->Value();
+    return true;
+  }
+
+  ExternalMemoryPrefetcher<EllpackPage>* source_;
+  size_t budget_bytes_{0};
+  size_t used_bytes_{0};
+  /*! \brief Device-resident leading pages, in access order. */
+  std::vector<std::unique_ptr<EllpackPage>> resident_;
+  size_t serve_idx_{0};
+  EllpackPage* current_{nullptr};
+  bool first_epoch_{true};
+  bool accepting_{true};
+  bool all_resident_{false};
+  /*! \brief Background drain of the resident prefix from the prefetcher. */
+  std::future<void> skip_;
+};
+
+BatchSet<EllpackPage> EllpackPageSource::GetBatchSet() {
+  if (!device_cache_) {
+    device_cache_.reset(
+        new EllpackPageDeviceCache(external_prefetcher_.get(), device_));
+  }
+  auto begin_iter = BatchIterator<EllpackPage>(
+      new SparseBatchIteratorImpl<EllpackPageDeviceCache, EllpackPage>(
+          device_cache_.get()));
+  return BatchSet<EllpackPage>(begin_iter);
+}
+
+EllpackPageSource::~EllpackPageSource() {
+  device_cache_.reset();
+  external_prefetcher_.reset();
+  for (auto file : cache_info_.name_shards) {
+    TryDeleteCacheFile(file);
+  }
+}
+
 // Build the quantile sketch across the whole input data, then use the histogram cuts to compress
 // each CSR page, and write the accumulated ELLPACK pages to disk.
 EllpackPageSource::EllpackPageSource(DMatrix* dmat,
@@ -25,6 +184,7 @@ EllpackPageSource::EllpackPageSource(DMatrix* dmat,
   if (param.gpu_page_size > 0) {
     page_size_ = param.gpu_page_size;
   }
+  device_ = param.gpu_id;
 
   monitor_.Init("ellpack_page_source");
   dh::safe_cuda(cudaSetDevice(param.gpu_id));
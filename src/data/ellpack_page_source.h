@@ -16,6 +16,8 @@
 namespace xgboost {
 namespace data {
 
+class EllpackPageDeviceCache;
+
 /*!
  * \brief External memory data source for ELLPACK format.
  *
@@ -30,19 +32,9 @@ class EllpackPageSource {
                              const std::string& cache_info,
                              const BatchParam& param) noexcept(false);
 
-  BatchSet<EllpackPage> GetBatchSet() {
-    auto begin_iter = BatchIterator<EllpackPage>(
-        new SparseBatchIteratorImpl<ExternalMemoryPrefetcher<EllpackPage>,
-                                    EllpackPage>(external_prefetcher_.get()));
-    return BatchSet<EllpackPage>(begin_iter);
-  }
+  BatchSet<EllpackPage> GetBatchSet();
 
-  ~EllpackPageSource() {
-    external_prefetcher_.reset();
-    for (auto file : cache_info_.name_shards) {
-      TryDeleteCacheFile(file);
-    }
-  }
+  ~EllpackPageSource();
 
  private:
   void WriteEllpackPages(int device, DMatrix* dmat,
@@ -54,8 +46,13 @@ class EllpackPageSource {
   const std::string kPageType_{".ellpack.page"};
 
   size_t page_size_{DMatrix::kPageSize};
+  int device_{0};
   common::Monitor monitor_;
   std::unique_ptr<ExternalMemoryPrefetcher<EllpackPage>> external_prefetcher_;
+  /*! \brief Device-memory-aware page cache: pages that fit the device budget
+   * are served from device memory instead of being reloaded from disk each
+   * iteration.  See the definition in ellpack_page_source.cu. */
+  std::unique_ptr<EllpackPageDeviceCache> device_cache_;
   CacheInfo cache_info_;
 };
 
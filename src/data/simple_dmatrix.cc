@@ -6,14 +6,17 @@
  */
 #include <vector>
 #include <limits>
+#include <numeric>
 #include <type_traits>
 #include <algorithm>
+#include <cstdint>
 
 #include "xgboost/data.h"
 #include "xgboost/c_api.h"
 
 #include "simple_dmatrix.h"
 #include "./simple_batch_iterator.h"
+#include "./sparse_page_codec.h"
 #include "../common/random.h"
 #include "../common/threading_utils.h"
 #include "adapter.h"
@@ -27,17 +30,37 @@ const MetaInfo& SimpleDMatrix::Info() const { return info_; }
 DMatrix* SimpleDMatrix::Slice(common::Span<int32_t const> ridxs) {
   auto out = new SimpleDMatrix;
   SparsePage& out_page = out->sparse_page_;
+  const int32_t nthread = omp_get_max_threads();
+  // A contiguous ascending range can rebase the source offsets and copy the
+  // entry span wholesale instead of gathering row by row.
+  bool contiguous = !ridxs.empty();
+  for (size_t i = 1; contiguous && i < ridxs.size(); ++i) {
+    contiguous = ridxs[i] == ridxs[i - 1] + 1;
+  }
   for (auto const &page : this->GetBatches<SparsePage>()) {
-    page.data.HostVector();
-    page.offset.HostVector();
+    auto batch = page.GetView();
     auto& h_data = out_page.data.HostVector();
     auto& h_offset = out_page.offset.HostVector();
-    size_t rptr{0};
-    for (auto ridx : ridxs) {
-      auto inst = page[ridx];
-      rptr += inst.size();
-      std::copy(inst.begin(), inst.end(), std::back_inserter(h_data));
-      h_offset.emplace_back(rptr);
+    h_offset.resize(ridxs.size() + 1, 0);
+    if (contiguous) {
+      auto const begin = batch.offset[ridxs.front()];
+      common::ParallelFor(ridxs.size(), nthread, [&](size_t i) {
+        h_offset[i + 1] = batch.offset[ridxs.front() + i + 1] - begin;
+      });
+      h_data.resize(h_offset.back());
+      std::copy_n(batch.data.data() + begin, h_data.size(), h_data.begin());
+    } else {
+      // first pass: per-row sizes, turned into offsets by a prefix sum
+      common::ParallelFor(ridxs.size(), nthread, [&](size_t i) {
+        h_offset[i + 1] = batch[ridxs[i]].size();
+      });
+      std::partial_sum(h_offset.cbegin(), h_offset.cend(), h_offset.begin());
+      // second pass: gather rows concurrently into the preallocated buffer
+      h_data.resize(h_offset.back());
+      common::ParallelFor(ridxs.size(), nthread, [&](size_t i) {
+        auto inst = batch[ridxs[i]];
+        std::copy(inst.begin(), inst.end(), h_data.begin() + h_offset[i]);
+      });
     }
     out->Info() = this->Info().Slice(ridxs);
     out->Info().num_nonzero_ = h_offset.back();
@@ -54,7 +77,11 @@ BatchSet<SparsePage> SimpleDMatrix::GetRowBatches() {
 
 BatchSet<CSCPage> SimpleDMatrix::GetColumnBatches() {
   // column page doesn't exist, generate it
+  std::lock_guard<std::mutex> guard(column_page_mu_);
   if (!column_page_) {
+    // the feature index carries the count pass over to the sorted column
+    // page, which transposes the same rows
+    sparse_page_.BuildFeatureIndex(info_.num_col_);
     column_page_.reset(new CSCPage(sparse_page_.GetTranspose(info_.num_col_)));
   }
   auto begin_iter =
@@ -64,10 +91,17 @@ BatchSet<CSCPage> SimpleDMatrix::GetColumnBatches() {
 
 BatchSet<SortedCSCPage> SimpleDMatrix::GetSortedColumnBatches() {
   // Sorted column page doesn't exist, generate it
+  std::lock_guard<std::mutex> guard(column_page_mu_);
   if (!sorted_column_page_) {
-    sorted_column_page_.reset(
-        new SortedCSCPage(sparse_page_.GetTranspose(info_.num_col_)));
-    sorted_column_page_->SortRows();
+    if (sorted_page_cache_.empty() || !TryLoadSortedColumnPage()) {
+      sparse_page_.BuildFeatureIndex(info_.num_col_);
+      sorted_column_page_.reset(
+          new SortedCSCPage(sparse_page_.GetTranspose(info_.num_col_)));
+      sorted_column_page_->SortRows();
+      if (!sorted_page_cache_.empty()) {
+        SaveSortedColumnPage();
+      }
+    }
   }
   auto begin_iter = BatchIterator<SortedCSCPage>(
       new SimpleBatchIteratorImpl<SortedCSCPage>(sorted_column_page_.get()));
@@ -96,9 +130,6 @@ SimpleDMatrix::SimpleDMatrix(AdapterT* adapter, float missing, int nthread) {
   int nthread_original = common::OmpSetNumThreadsWithoutHT(&nthread);
 
   std::vector<uint64_t> qids;
-  uint64_t default_max = std::numeric_limits<uint64_t>::max();
-  uint64_t last_group_id = default_max;
-  bst_uint group_size = 0;
   auto& offset_vec = sparse_page_.offset.HostVector();
   auto& data_vec = sparse_page_.data.HostVector();
   uint64_t inferred_num_columns = 0;
@@ -130,22 +161,11 @@ SimpleDMatrix::SimpleDMatrix(AdapterT* adapter, float missing, int nthread) {
     }
     if (batch.Qid() != nullptr) {
       qids.insert(qids.end(), batch.Qid(), batch.Qid() + batch.Size());
-      // get group
-      for (size_t i = 0; i < batch.Size(); ++i) {
-        const uint64_t cur_group_id = batch.Qid()[i];
-        if (last_group_id == default_max || last_group_id != cur_group_id) {
-          info_.group_ptr_.push_back(group_size);
-        }
-        last_group_id = cur_group_id;
-        ++group_size;
-      }
     }
   }
 
-  if (last_group_id != default_max) {
-    if (group_size > info_.group_ptr_.back()) {
-      info_.group_ptr_.push_back(group_size);
-    }
+  if (!qids.empty()) {
+    info_.SetGroupPtrFromQids(qids, nthread);
   }
 
   // Deal with empty rows/columns if necessary
@@ -191,19 +211,83 @@ SimpleDMatrix::SimpleDMatrix(AdapterT* adapter, float missing, int nthread) {
 SimpleDMatrix::SimpleDMatrix(dmlc::Stream* in_stream) {
   int tmagic;
   CHECK(in_stream->Read(&tmagic)) << "invalid input file format";
-  CHECK_EQ(tmagic, kMagic) << "invalid format, magic number mismatch";
+  CHECK(tmagic == kMagic || tmagic == kMagicCompact)
+      << "invalid format, magic number mismatch";
   info_.LoadBinary(in_stream);
-  in_stream->Read(&sparse_page_.offset.HostVector());
-  in_stream->Read(&sparse_page_.data.HostVector());
+  if (tmagic == kMagicCompact) {
+    SparsePageCodec codec;
+    CHECK(codec.Decode(&sparse_page_, in_stream)) << "invalid input file format";
+  } else {
+    in_stream->Read(&sparse_page_.offset.HostVector());
+    in_stream->Read(&sparse_page_.data.HostVector());
+  }
 }
 
 void SimpleDMatrix::SaveToLocalFile(const std::string& fname) {
     std::unique_ptr<dmlc::Stream> fo(dmlc::Stream::Create(fname.c_str(), "w"));
-    int tmagic = kMagic;
+    // Compact binaries delta + varint encode the indices and dictionary
+    // encode low-cardinality values, roughly halving cache files; loading
+    // dispatches on the magic so the switch only affects newly written files.
+    const bool compact = dmlc::GetEnv("XGBOOST_COMPACT_BINARY", 0) != 0;
+    int tmagic = compact ? kMagicCompact : kMagic;
     fo->Write(tmagic);
     info_.SaveBinary(fo.get());
-    fo->Write(sparse_page_.offset.HostVector());
-    fo->Write(sparse_page_.data.HostVector());
+    if (compact) {
+      SparsePageCodec codec;
+      codec.Encode(sparse_page_, fo.get());
+    } else {
+      fo->Write(sparse_page_.offset.HostVector());
+      fo->Write(sparse_page_.data.HostVector());
+    }
+    // keep the sorted column page next to the binary matrix, so matrices
+    // loaded from this file skip the transpose and sort
+    sorted_page_cache_ = fname + ".sorted.col.page";
+    if (sorted_column_page_) {
+      SaveSortedColumnPage();
+    }
+}
+
+bool SimpleDMatrix::TryLoadSortedColumnPage() {
+  std::unique_ptr<dmlc::Stream> fi(
+      dmlc::Stream::Create(sorted_page_cache_.c_str(), "r", true));
+  if (fi == nullptr) {
+    return false;
+  }
+  // The shape header guards against a page left behind by different data
+  // under the same name; on any mismatch the page is rebuilt and the file
+  // overwritten.
+  int tmagic;
+  uint64_t num_row, num_col, num_nonzero;
+  if (!fi->Read(&tmagic) || tmagic != kMagic || !fi->Read(&num_row) ||
+      !fi->Read(&num_col) || !fi->Read(&num_nonzero) ||
+      num_row != info_.num_row_ || num_col != info_.num_col_ ||
+      num_nonzero != info_.num_nonzero_) {
+    return false;
+  }
+  std::unique_ptr<SortedCSCPage> page(new SortedCSCPage());
+  if (!fi->Read(&page->offset.HostVector()) ||
+      !fi->Read(&page->data.HostVector())) {
+    return false;
+  }
+  sorted_column_page_ = std::move(page);
+  return true;
+}
+
+void SimpleDMatrix::SaveSortedColumnPage() {
+  std::unique_ptr<dmlc::Stream> fo(
+      dmlc::Stream::Create(sorted_page_cache_.c_str(), "w", true));
+  if (fo == nullptr) {
+    LOG(WARNING) << "Could not write the sorted column page to "
+                 << sorted_page_cache_;
+    return;
+  }
+  int tmagic = kMagic;
+  fo->Write(tmagic);
+  fo->Write(info_.num_row_);
+  fo->Write(info_.num_col_);
+  fo->Write(info_.num_nonzero_);
+  fo->Write(sorted_column_page_->offset.HostVector());
+  fo->Write(sorted_column_page_->data.HostVector());
 }
 
 template SimpleDMatrix::SimpleDMatrix(DenseAdapter* adapter, float missing,
@@ -214,6 +298,8 @@ template SimpleDMatrix::SimpleDMatrix(CSCAdapter* adapter, float missing,
                                      int nthread);
 template SimpleDMatrix::SimpleDMatrix(DataTableAdapter* adapter, float missing,
                                      int nthread);
+template SimpleDMatrix::SimpleDMatrix(ColumnarAdapter* adapter, float missing,
+                                     int nthread);
 template SimpleDMatrix::SimpleDMatrix(FileAdapter* adapter, float missing,
                                      int nthread);
 template SimpleDMatrix::SimpleDMatrix(
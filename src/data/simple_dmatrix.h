@@ -11,6 +11,7 @@
 #include <xgboost/data.h>
 
 #include <memory>
+#include <mutex>
 #include <string>
 
 
@@ -28,6 +29,16 @@ class SimpleDMatrix : public DMatrix {
 
   void SaveToLocalFile(const std::string& fname);
 
+  /*!
+   * \brief Persist and reuse the sorted column page at the given file.  The
+   *  exact-greedy updaters transpose and sort the matrix once per DMatrix;
+   *  with a cache file the page is written on first use and later instances
+   *  built from the same binary matrix read the sorted layout back instead.
+   */
+  void SetSortedPageCacheFile(const std::string& fname) {
+    sorted_page_cache_ = fname;
+  }
+
   MetaInfo& Info() override;
 
   const MetaInfo& Info() const override;
@@ -37,6 +48,10 @@ class SimpleDMatrix : public DMatrix {
 
   /*! \brief magic number used to identify SimpleDMatrix binary files */
   static const int kMagic = 0xffffab01;
+  /*! \brief magic number of compact binary files, whose sparse page is
+   *  delta + varint encoded by SparsePageCodec.  Loading recognises either
+   *  layout; writing the compact one is opt-in, see SaveToLocalFile. */
+  static const int kMagicCompact = 0xffffab02;
 
  private:
   BatchSet<SparsePage> GetRowBatches() override;
@@ -44,12 +59,21 @@ class SimpleDMatrix : public DMatrix {
   BatchSet<SortedCSCPage> GetSortedColumnBatches() override;
   BatchSet<EllpackPage> GetEllpackBatches(const BatchParam& param) override;
 
+  bool TryLoadSortedColumnPage();
+  void SaveSortedColumnPage();
+
   MetaInfo info_;
   SparsePage sparse_page_;  // Primary storage type
   std::unique_ptr<CSCPage> column_page_;
   std::unique_ptr<SortedCSCPage> sorted_column_page_;
+  // guards the lazy construction of the column pages above: parallel class
+  // boosting requests batches from several threads at once
+  std::mutex column_page_mu_;
   std::unique_ptr<EllpackPage> ellpack_page_;
   BatchParam batch_param_;
+  // when set, the sorted column page is persisted here and read back on the
+  // next use instead of being rebuilt
+  std::string sorted_page_cache_;
 
   bool EllpackExists() const override {
     return static_cast<bool>(ellpack_page_);
@@ -27,6 +27,11 @@ BatchSet<SparsePage> SparsePageDMatrix::GetRowBatches() {
   return row_source_->GetBatchSet();
 }
 
+BatchSet<SparsePage> SparsePageDMatrix::GetRowBatches(
+    RowRangePredicate const& predicate) {
+  return row_source_->GetBatchSet(predicate);
+}
+
 BatchSet<CSCPage> SparsePageDMatrix::GetColumnBatches() {
   // Lazily instantiate
   if (!column_source_) {
@@ -40,6 +40,7 @@
 
 #include <dmlc/threadediter.h>
 #include <dmlc/timer.h>
+#include <dmlc/parameter.h>
 
 #include <algorithm>
 #include <limits>
@@ -57,6 +58,8 @@
 #include "adapter.h"
 #include "sparse_page_writer.h"
 #include "../common/common.h"
+#include "../common/io.h"
+#include "../common/profile.h"
 #include <xgboost/data.h>
 
 namespace detail {
@@ -89,7 +92,7 @@ class SparseBatchIteratorImpl : public BatchIteratorImpl<T> {
   explicit SparseBatchIteratorImpl(S* source) : source_(source) {
     CHECK(source_ != nullptr);
     source_->BeforeFirst();
-    source_->Next();
+    at_end_ = !source_->Next();
   }
   T& operator*() override { return source_->Value(); }
   const T& operator*() const override { return source_->Value(); }
@@ -136,13 +139,41 @@ inline CacheInfo ParseCacheInfo(const std::string& cache_info, const std::string
   CHECK_NE(cache_shards.size(), 0U);
   // read in the info files.
   info.name_info = cache_shards[0];
+  // Pages are distributed round-robin over the shard files, each with its own
+  // writer thread and prefetch reader, so listing one prefix per drive in
+  // `cache_info` streams an epoch from all drives concurrently.  A single
+  // sequential stream rarely saturates a modern drive either, so each prefix
+  // can additionally be fanned out into several sub-shards.
+  const int sub_shards = std::max(dmlc::GetEnv("XGBOOST_CACHE_SHARDS", 1), 1);
   for (const std::string& prefix : cache_shards) {
+    const std::string format = DecideFormat(prefix).first;
     info.name_shards.push_back(prefix + page_type);
-    info.format_shards.push_back(DecideFormat(prefix).first);
+    info.format_shards.push_back(format);
+    for (int i = 1; i < sub_shards; ++i) {
+      info.name_shards.push_back(prefix + ".shard-" + std::to_string(i) + page_type);
+      info.format_shards.push_back(format);
+    }
   }
   return info;
 }
 
+/*!
+ * \brief Open a cache shard for reading.  Local files are memory mapped so
+ *        page loads copy straight out of the kernel page cache instead of
+ *        going through buffered stream reads; set the environment variable
+ *        XGBOOST_CACHE_MMAP=0 to force the dmlc stream reader.
+ */
+inline dmlc::SeekStream* CreateCacheReader(const std::string& uri) {
+#if defined(__unix__)
+  auto parsed = dmlc::io::URI(uri.c_str());
+  if ((parsed.protocol == "file://" || parsed.protocol.length() == 0) &&
+      dmlc::GetEnv("XGBOOST_CACHE_MMAP", 1) != 0) {
+    return new common::MemoryMappedStream(parsed.name);
+  }
+#endif  // defined(__unix__)
+  return dmlc::SeekStream::CreateForRead(uri.c_str());
+}
+
 inline void TryDeleteCacheFile(const std::string& file) {
   if (std::remove(file.c_str()) != 0) {
     LOG(WARNING) << "Couldn't remove external memory cache file " << file
@@ -171,6 +202,18 @@ inline void CheckCacheFileExists(const std::string& file) {
 template <typename PageT>
 class ExternalMemoryPrefetcher : dmlc::DataIter<PageT> {
  public:
+  /*!
+   * \brief Number of pages each shard reads and decodes ahead of the
+   *        consumer.  The default keeps compute and page IO overlapped on
+   *        most disks; raise XGBOOST_EXTMEM_PREFETCH_BUFFER when the updater
+   *        still stalls on page loads, at the cost of holding more decoded
+   *        pages in memory.
+   */
+  static size_t PrefetchDepth() {
+    static size_t depth = static_cast<size_t>(std::max(
+        dmlc::GetEnv("XGBOOST_EXTMEM_PREFETCH_BUFFER", 4), 1));
+    return depth;
+  }
   explicit ExternalMemoryPrefetcher(const CacheInfo& info) noexcept(false)
       : base_rowid_(0), page_(nullptr), clock_ptr_(0) {
     // read in the info files
@@ -189,14 +232,14 @@ class ExternalMemoryPrefetcher : dmlc::DataIter<PageT> {
     // read in the cache files.
     for (size_t i = 0; i < info.name_shards.size(); ++i) {
       std::string name_row = info.name_shards.at(i);
-      files_[i].reset(dmlc::SeekStream::CreateForRead(name_row.c_str()));
+      files_[i].reset(CreateCacheReader(name_row));
       std::unique_ptr<dmlc::SeekStream>& fi = files_[i];
       std::string format;
       CHECK(fi->Read(&format)) << "Invalid page format";
       formats_[i].reset(CreatePageFormat<PageT>(format));
       std::unique_ptr<SparsePageFormat<PageT>>& fmt = formats_[i];
       size_t fbegin = fi->Tell();
-      prefetchers_[i].reset(new dmlc::ThreadedIter<PageT>(4));
+      prefetchers_[i].reset(new dmlc::ThreadedIter<PageT>(PrefetchDepth()));
       prefetchers_[i]->Init(
           [&fi, &fmt](PageT** dptr) {
             if (*dptr == nullptr) {
@@ -221,7 +264,18 @@ class ExternalMemoryPrefetcher : dmlc::DataIter<PageT> {
       prefetchers_[(clock_ptr_ + n - 1) % n]->Recycle(&page_);
     }
 
-    if (prefetchers_[clock_ptr_]->Next(&page_)) {
+    // the prefetcher may still be reading the page from disk; the wait here
+    // is the external-memory stall the profiler surfaces
+    static const size_t kPageWaitSlot =
+        common::ProfileRegistry::Instance().Register("page_load_wait_ticks");
+    static const size_t kPageCountSlot =
+        common::ProfileRegistry::Instance().Register("page_load_count");
+    const uint64_t wait_begin = common::ProfileTicks();
+    const bool has_next = prefetchers_[clock_ptr_]->Next(&page_);
+    common::ProfileRegistry::Instance().Add(
+        kPageWaitSlot, common::ProfileTicks() - wait_begin);
+    if (has_next) {
+      common::ProfileRegistry::Instance().Add(kPageCountSlot, 1);
       page_->SetBaseRowId(base_rowid_);
       base_rowid_ += page_->Size();
       // advance clock
@@ -267,6 +321,163 @@ class ExternalMemoryPrefetcher : dmlc::DataIter<PageT> {
 };
 
 
+/**
+ * \brief Reads only the row pages whose row range is accepted by a
+ *        RowRangePredicate, seeking straight past rejected pages so their
+ *        bytes are never read or decoded.  Each page's row range, shard and
+ *        byte extent come from the page index appended to the cache info
+ *        file.  Not thread safe; unlike ExternalMemoryPrefetcher an instance
+ *        is built per filtered epoch.
+ */
+class SelectiveExternalMemoryPrefetcher : dmlc::DataIter<SparsePage> {
+ public:
+  SelectiveExternalMemoryPrefetcher(const CacheInfo& info,
+                                    RowRangePredicate const& predicate) noexcept(false)
+      : pos_(0), prev_shard_(0), page_(nullptr) {
+    CHECK_NE(info.name_shards.size(), 0U);
+    // load the page index appended after the metadata in the info file
+    {
+      std::unique_ptr<dmlc::Stream> finfo(
+          dmlc::Stream::Create(info.name_info.c_str(), "r"));
+      int tmagic;
+      CHECK(finfo->Read(&tmagic));
+      CHECK_EQ(tmagic, kMagic) << "invalid format, magic number mismatch";
+      MetaInfo scratch;
+      scratch.LoadBinary(finfo.get());
+      uint64_t n_pages = 0;
+      CHECK_EQ(finfo->Read(&n_pages, sizeof(n_pages)), sizeof(n_pages))
+          << "Cache info file " << info.name_info << " has no page index";
+      std::vector<PageIndexEntry> index(n_pages);
+      if (n_pages != 0) {
+        CHECK_EQ(finfo->Read(index.data(), n_pages * sizeof(PageIndexEntry)),
+                 n_pages * sizeof(PageIndexEntry))
+            << "Invalid page index in cache info file";
+      }
+      for (const PageIndexEntry& entry : index) {
+        if (predicate(entry.base_rowid, entry.base_rowid + entry.n_rows)) {
+          selected_.push_back(entry);
+        }
+      }
+    }
+
+    // group the selected pages by the shard holding them; the global epoch
+    // order is ascending in byte offset within each shard, so the shard
+    // streams only ever seek forward
+    shard_pages_.resize(info.name_shards.size());
+    for (const PageIndexEntry& entry : selected_) {
+      CHECK_LT(entry.shard, shard_pages_.size());
+      shard_pages_[entry.shard].push_back(entry);
+    }
+
+    files_.resize(info.name_shards.size());
+    formats_.resize(info.name_shards.size());
+    prefetchers_.resize(info.name_shards.size());
+    cursors_.assign(info.name_shards.size(), 0);
+    for (size_t i = 0; i < info.name_shards.size(); ++i) {
+      if (shard_pages_[i].empty()) {
+        // every page of the shard was rejected; don't even open the file
+        continue;
+      }
+      files_[i].reset(CreateCacheReader(info.name_shards.at(i)));
+      std::unique_ptr<dmlc::SeekStream>& fi = files_[i];
+      std::string format;
+      CHECK(fi->Read(&format)) << "Invalid page format";
+      formats_[i].reset(CreatePageFormat<SparsePage>(format));
+      std::unique_ptr<SparsePageFormat<SparsePage>>& fmt = formats_[i];
+      const std::vector<PageIndexEntry>* pages = &shard_pages_[i];
+      size_t* cursor = &cursors_[i];
+      prefetchers_[i].reset(new dmlc::ThreadedIter<SparsePage>(
+          ExternalMemoryPrefetcher<SparsePage>::PrefetchDepth()));
+      prefetchers_[i]->Init(
+          [&fi, &fmt, pages, cursor](SparsePage** dptr) {
+            if (*cursor == pages->size()) {
+              return false;
+            }
+            const PageIndexEntry& entry = (*pages)[(*cursor)++];
+            if (*dptr == nullptr) {
+              *dptr = new SparsePage();
+            }
+            fi->Seek(entry.offset_begin);
+            return fmt->Read(*dptr, fi.get());
+          },
+          [cursor]() { *cursor = 0; });
+    }
+  }
+  /*! \brief destructor */
+  ~SelectiveExternalMemoryPrefetcher() override {
+    delete page_;
+  }
+
+  // implement Next
+  bool Next() override {
+    CHECK(mutex_.try_lock()) << "Multiple threads attempting to use prefetcher";
+    if (pos_ == selected_.size()) {
+      mutex_.unlock();
+      return false;
+    }
+    const PageIndexEntry& entry = selected_[pos_];
+    if (page_ != nullptr) {
+      prefetchers_[prev_shard_]->Recycle(&page_);
+    }
+
+    static const size_t kPageWaitSlot =
+        common::ProfileRegistry::Instance().Register("page_load_wait_ticks");
+    static const size_t kPageCountSlot =
+        common::ProfileRegistry::Instance().Register("page_load_count");
+    const uint64_t wait_begin = common::ProfileTicks();
+    CHECK(prefetchers_[entry.shard]->Next(&page_))
+        << "Cache shard ended before its page index";
+    common::ProfileRegistry::Instance().Add(
+        kPageWaitSlot, common::ProfileTicks() - wait_begin);
+    common::ProfileRegistry::Instance().Add(kPageCountSlot, 1);
+    CHECK_EQ(page_->Size(), entry.n_rows)
+        << "Page index out of sync with cache shard";
+    page_->SetBaseRowId(entry.base_rowid);
+    prev_shard_ = entry.shard;
+    ++pos_;
+    mutex_.unlock();
+    return true;
+  }
+
+  // implement BeforeFirst
+  void BeforeFirst() override {
+    CHECK(mutex_.try_lock()) << "Multiple threads attempting to use prefetcher";
+    pos_ = 0;
+    for (auto& p : prefetchers_) {
+      if (p) {
+        p->BeforeFirst();
+      }
+    }
+    mutex_.unlock();
+  }
+
+  // implement Value
+  SparsePage& Value() { return *page_; }
+
+  const SparsePage& Value() const override { return *page_; }
+
+ private:
+  std::mutex mutex_;
+  /*! \brief selected pages in global epoch order */
+  std::vector<PageIndexEntry> selected_;
+  /*! \brief selected pages grouped by the shard holding them */
+  std::vector<std::vector<PageIndexEntry>> shard_pages_;
+  /*! \brief next page to load per shard, owned by the reader threads */
+  std::vector<size_t> cursors_;
+  /*! \brief position in selected_ */
+  size_t pos_;
+  /*! \brief shard the page on hold was loaded from */
+  size_t prev_shard_;
+  /*! \brief page currently on hold. */
+  SparsePage* page_;
+  /*! \brief file pointer to the row blob file. */
+  std::vector<std::unique_ptr<dmlc::SeekStream>> files_;
+  /*! \brief Sparse page format file. */
+  std::vector<std::unique_ptr<SparsePageFormat<SparsePage>>> formats_;
+  /*! \brief internal prefetcher. */
+  std::vector<std::unique_ptr<dmlc::ThreadedIter<SparsePage>>> prefetchers_;
+};
+
 // A data pool to keep the size of each page balanced and data partitioning to be
 // deterministic.
 class DataPool {
@@ -313,9 +524,11 @@ class SparsePageSource {
       CheckCacheFileExists(file);
     }
 
+    std::vector<std::vector<PageIndexEntry>> shard_index;
     {
       SparsePageWriter<SparsePage> writer(cache_info_.name_shards,
-                                          cache_info_.format_shards, 6);
+                                          cache_info_.format_shards, 6,
+                                          &shard_index);
       DataPool pool(&info, page_size, &writer);
 
       std::shared_ptr<SparsePage> page { new SparsePage };
@@ -323,9 +536,6 @@ class SparsePageSource {
       uint64_t inferred_num_columns = 0;
       uint64_t inferred_num_rows = 0;
 
-      const uint64_t default_max = std::numeric_limits<uint64_t>::max();
-      uint64_t last_group_id = default_max;
-      bst_uint group_size = 0;
       std::vector<uint64_t> qids;
       adapter->BeforeFirst();
       while (adapter->Next()) {
@@ -347,16 +557,6 @@ class SparsePageSource {
         }
         if (batch.Qid() != nullptr) {
           qids.insert(qids.end(), batch.Qid(), batch.Qid() + batch.Size());
-          // get group
-          for (size_t i = 0; i < batch.Size(); ++i) {
-            const uint64_t cur_group_id = batch.Qid()[i];
-            if (last_group_id == default_max ||
-                last_group_id != cur_group_id) {
-              info.group_ptr_.push_back(group_size);
-            }
-            last_group_id = cur_group_id;
-            ++group_size;
-          }
         }
         CHECK_EQ(page->Size(), 0);
         auto batch_max_columns = page->Push(batch, missing, nthread);
@@ -367,10 +567,8 @@ class SparsePageSource {
         page->SetBaseRowId(inferred_num_rows);
       }
 
-      if (last_group_id != default_max) {
-        if (group_size > info.group_ptr_.back()) {
-          info.group_ptr_.push_back(group_size);
-        }
+      if (!qids.empty()) {
+        info.SetGroupPtrFromQids(qids, nthread);
       }
 
       // Deal with empty rows/columns if necessary
@@ -399,14 +597,45 @@ class SparsePageSource {
 
       pool.Push(page);
       pool.Finalize();
+      // Either every row has query ID or none at all
+      CHECK(qids.empty() || qids.size() == info.num_row_);
+    }
+    // The writer threads have joined, so the per-shard page records are
+    // complete.  Page k of the epoch was pushed to shard k % n_shards, so
+    // interleaving the shard lists round-robin restores the epoch order and
+    // lets the base row id of every page be assigned by accumulation.
+    std::vector<PageIndexEntry> page_index;
+    uint64_t base_rowid = 0;
+    for (size_t j = 0; true; ++j) {
+      bool any = false;
+      for (const auto& shard : shard_index) {
+        if (j < shard.size()) {
+          PageIndexEntry entry = shard[j];
+          entry.base_rowid = base_rowid;
+          base_rowid += entry.n_rows;
+          page_index.push_back(entry);
+          any = true;
+        }
+      }
+      if (!any) {
+        break;
+      }
+    }
+    CHECK_EQ(base_rowid, info.num_row_);
 
+    {
       std::unique_ptr<dmlc::Stream> fo(
           dmlc::Stream::Create(cache_info_.name_info.c_str(), "w"));
       int tmagic = kMagic;
       fo->Write(tmagic);
-      // Either every row has query ID or none at all
-      CHECK(qids.empty() || qids.size() == info.num_row_);
       info.SaveBinary(fo.get());
+      // the page index goes after the metadata so readers that need only the
+      // magic + MetaInfo prefix are unaffected
+      uint64_t n_pages = page_index.size();
+      fo->Write(&n_pages, sizeof(n_pages));
+      if (n_pages != 0) {
+        fo->Write(page_index.data(), n_pages * sizeof(PageIndexEntry));
+      }
     }
     LOG(INFO) << "SparsePageSource Finished writing to "
               << cache_info_.name_info;
@@ -429,10 +658,26 @@ class SparsePageSource {
                                     SparsePage>(external_prefetcher_.get()));
     return BatchSet<SparsePage>(begin_iter);
   }
+
+  /*!
+   * \brief Get row batches restricted to the pages holding rows selected by
+   *        \p predicate; rejected pages are skipped at the I/O layer.  Each
+   *        call invalidates the previous filtered batch set.  Callers that
+   *        need every row should keep using the unfiltered GetBatchSet().
+   */
+  BatchSet<SparsePage> GetBatchSet(RowRangePredicate const& predicate) {
+    selective_prefetcher_.reset(
+        new SelectiveExternalMemoryPrefetcher(cache_info_, predicate));
+    auto begin_iter = BatchIterator<SparsePage>(
+        new SparseBatchIteratorImpl<SelectiveExternalMemoryPrefetcher,
+                                    SparsePage>(selective_prefetcher_.get()));
+    return BatchSet<SparsePage>(begin_iter);
+  }
   MetaInfo info;
 
  private:
   std::unique_ptr<ExternalMemoryPrefetcher<SparsePage>> external_prefetcher_;
+  std::unique_ptr<SelectiveExternalMemoryPrefetcher> selective_prefetcher_;
   CacheInfo cache_info_;
 };
 
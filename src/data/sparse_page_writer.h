@@ -10,6 +10,7 @@
 #include <dmlc/io.h>
 #include <vector>
 #include <algorithm>
+#include <cstdint>
 #include <cstring>
 #include <string>
 #include <utility>
@@ -74,6 +75,41 @@ inline SparsePageFormat<T>* CreatePageFormat(const std::string& name) {
   return (e->body)();
 }
 
+/*!
+ * \brief Metadata of one page recorded while it is written to a cache shard.
+ *
+ * The writer fills everything except \c base_rowid, which only the caller
+ * assembling the pages into a global epoch order can know.  The fields are
+ * fixed-width so a whole index can be written and read back as one blob.
+ */
+struct PageIndexEntry {
+  /*! \brief first row id of the page within the epoch, filled by the caller */
+  uint64_t base_rowid{0};
+  /*! \brief number of rows (or columns for column pages) in the page */
+  uint64_t n_rows{0};
+  /*! \brief number of nonzero entries in the page */
+  uint64_t n_entries{0};
+  /*! \brief index of the shard file holding the page */
+  uint64_t shard{0};
+  /*! \brief byte range [offset_begin, offset_end) of the page in its shard */
+  uint64_t offset_begin{0};
+  uint64_t offset_end{0};
+};
+
+/*!
+ * \brief Number of nonzero entries of a page, or 0 for page types that do not
+ *        expose their entry storage (the ellpack page).
+ */
+template <typename T>
+inline auto PageNumEntries(const T& page, int) -> decltype(page.data.Size()) {
+  return page.data.Size();
+}
+
+template <typename T>
+inline size_t PageNumEntries(const T&, ...) {
+  return 0;
+}
+
 #if DMLC_ENABLE_STD_THREAD
 /*!
  * \brief A threaded writer to write sparse batch page to sharded files.
@@ -87,29 +123,52 @@ class SparsePageWriter {
    * \param name_shards name of shard files.
    * \param format_shards format of each shard.
    * \param extra_buffer_capacity Extra buffer capacity before block.
+   * \param out_page_index When non-null, receives one PageIndexEntry per
+   *        written page, grouped by shard in shard write order.  Only valid
+   *        after the writer is destructed and its threads have joined.
    */
   explicit SparsePageWriter(const std::vector<std::string>& name_shards,
                             const std::vector<std::string>& format_shards,
-                            size_t extra_buffer_capacity)
+                            size_t extra_buffer_capacity,
+                            std::vector<std::vector<PageIndexEntry>>* out_page_index = nullptr)
       : num_free_buffer_(extra_buffer_capacity + name_shards.size()),
         clock_ptr_(0),
         workers_(name_shards.size()),
         qworkers_(name_shards.size()) {
     CHECK_EQ(name_shards.size(), format_shards.size());
+    if (out_page_index != nullptr) {
+      out_page_index->assign(name_shards.size(), {});
+    }
     // start writer threads
     for (size_t i = 0; i < name_shards.size(); ++i) {
       std::string name_shard = name_shards[i];
       std::string format_shard = format_shards[i];
       auto* wqueue = &qworkers_[i];
+      // each worker records into its own shard slot, so no synchronisation
+      // beyond the thread join is needed
+      std::vector<PageIndexEntry>* index =
+          out_page_index != nullptr ? &(*out_page_index)[i] : nullptr;
       workers_[i].reset(new std::thread(
-          [this, name_shard, format_shard, wqueue]() {
+          [this, name_shard, format_shard, wqueue, index, i]() {
             std::unique_ptr<dmlc::Stream> fo(dmlc::Stream::Create(name_shard.c_str(), "w"));
+            CountedStream counted(fo.get());
             std::unique_ptr<SparsePageFormat<T>> fmt(CreatePageFormat<T>(format_shard));
-            fo->Write(format_shard);
+            counted.Write(format_shard);
             std::shared_ptr<T> page;
             while (wqueue->Pop(&page)) {
               if (page == nullptr) break;
-              fmt->Write(*page, fo.get());
+              if (index != nullptr) {
+                PageIndexEntry entry;
+                entry.n_rows = page->Size();
+                entry.n_entries = PageNumEntries(*page, 0);
+                entry.shard = i;
+                entry.offset_begin = counted.BytesWritten();
+                fmt->Write(*page, &counted);
+                entry.offset_end = counted.BytesWritten();
+                index->push_back(entry);
+              } else {
+                fmt->Write(*page, &counted);
+              }
               qrecycle_.Push(std::move(page));
             }
             fo.reset(nullptr);
@@ -158,6 +217,29 @@ class SparsePageWriter {
   }
 
  private:
+  /*!
+   * \brief Forwarding stream counting the bytes written so far, used to
+   *        record per-page byte extents without a seekable output stream.
+   */
+  class CountedStream : public dmlc::Stream {
+   public:
+    using dmlc::Stream::Write;
+    explicit CountedStream(dmlc::Stream* strm) : strm_(strm) {}
+    size_t Read(void*, size_t) override {
+      LOG(FATAL) << "CountedStream is write only";
+      return 0;
+    }
+    void Write(const void* ptr, size_t size) override {
+      strm_->Write(ptr, size);
+      bytes_written_ += size;
+    }
+    size_t BytesWritten() const { return bytes_written_; }
+
+   private:
+    dmlc::Stream* strm_;
+    size_t bytes_written_{0};
+  };
+
   /*! \brief number of allocated pages */
   size_t num_free_buffer_;
   /*! \brief clock_pointer */
@@ -12,6 +12,8 @@
 #include "xgboost/learner.h"
 #include "xgboost/generic_parameters.h"
 
+#include "../common/io.h"
+
 namespace dmlc {
 DMLC_REGISTRY_ENABLE(::xgboost::GradientBoosterReg);
 }  // namespace dmlc
@@ -29,6 +31,15 @@ GradientBooster* GradientBooster::Create(
   p_bst->generic_param_ = generic_param;
   return p_bst;
 }
+
+std::function<void(dmlc::Stream*)> GradientBooster::MakeSaveSnapshot() const {
+  std::string buffer;
+  common::MemoryBufferStream fo(&buffer);
+  this->Save(&fo);
+  return [buffer = std::move(buffer)](dmlc::Stream* fo) {
+    fo->Write(buffer.data(), buffer.size());
+  };
+}
 }  // namespace xgboost
 
 namespace xgboost {
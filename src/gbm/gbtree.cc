@@ -9,6 +9,8 @@
 
 #include <vector>
 #include <memory>
+#include <iomanip>
+#include <sstream>
 #include <utility>
 #include <string>
 #include <limits>
@@ -40,10 +42,18 @@ void GBTree::Configure(const Args& cfg) {
 
   model_.Configure(cfg);
 
-  // for the 'update' process_type, move trees into trees_to_update
-  if (tparam_.process_type == TreeProcessType::kUpdate) {
+  // for the 'update' and 'refresh_epoch' process_types, move trees into
+  // trees_to_update
+  if (tparam_.process_type == TreeProcessType::kUpdate ||
+      tparam_.process_type == TreeProcessType::kRefreshEpoch) {
     model_.InitTreesToUpdate();
   }
+  if (tparam_.process_type == TreeProcessType::kRefreshEpoch) {
+    if (!refresher_) {
+      refresher_.reset(TreeUpdater::Create("refresh", generic_param_));
+    }
+    refresher_->Configure(cfg);
+  }
 
   // configure predictors
   if (!cpu_predictor_) {
@@ -90,6 +100,7 @@ void GBTree::Configure(const Args& cfg) {
   this->ConfigureUpdaters();
   if (updater_seq != tparam_.updater_seq) {
     updaters_.clear();
+    group_updaters_.clear();
     this->InitUpdater(cfg);
   } else {
     for (auto &up : updaters_) {
@@ -100,6 +111,46 @@ void GBTree::Configure(const Args& cfg) {
   configured_ = true;
 }
 
+bool GBTree::SetParamFloat(const std::string& key, float value) {
+  if (!configured_) {
+    return false;
+  }
+  // Only the parameters that are commonly adjusted between iterations are
+  // supported; everything else goes through the full `Configure` so that
+  // updater selection and predictor setup stay consistent.
+  if (key != "learning_rate" && key != "eta") {
+    return false;
+  }
+  std::ostringstream os;
+  os << std::setprecision(std::numeric_limits<float>::max_digits10) << value;
+  std::string const str_value = os.str();
+  // Keep the cached configuration in sync so a later full reconfiguration
+  // does not revert the parameter.
+  bool found = false;
+  for (auto& kv : cfg_) {
+    if (kv.first == key) {
+      kv.second = str_value;
+      found = true;
+    }
+  }
+  if (!found) {
+    cfg_.emplace_back(key, str_value);
+  }
+  Args const single{{key, str_value}};
+  for (auto& up : updaters_) {
+    up->Configure(single);
+  }
+  for (auto& group : group_updaters_) {
+    for (auto& up : group) {
+      up->Configure(single);
+    }
+  }
+  if (refresher_) {
+    refresher_->Configure(single);
+  }
+  return true;
+}
+
 // FIXME(trivialfis): This handles updaters.  Because the choice of updaters depends on
 // whether external memory is used and how large is dataset.  We can remove the dependency
 // on DMatrix once `hist` tree method can handle external memory so that we can make it
@@ -118,6 +169,7 @@ void GBTree::ConfigureWithKnownData(Args const& cfg, DMatrix* fmat) {
   if (updater_seq != tparam_.updater_seq) {
     LOG(DEBUG) << "Using updaters: " << tparam_.updater_seq;
     this->updaters_.clear();
+    this->group_updaters_.clear();
     this->InitUpdater(cfg);
   }
 }
@@ -192,15 +244,58 @@ void GBTree::ConfigureUpdaters() {
 void GBTree::DoBoost(DMatrix* p_fmat,
                      HostDeviceVector<GradientPair>* in_gpair,
                      PredictionCacheEntry* predt) {
-  std::vector<std::vector<std::unique_ptr<RegTree> > > new_trees;
+  std::vector<std::vector<std::shared_ptr<RegTree> > > new_trees;
   const int ngroup = model_.learner_model_param->num_output_group;
   ConfigureWithKnownData(this->cfg_, p_fmat);
   monitor_.Start("BoostNewTrees");
   CHECK_NE(ngroup, 0);
   if (ngroup == 1) {
-    std::vector<std::unique_ptr<RegTree> > ret;
+    std::vector<std::shared_ptr<RegTree> > ret;
     BoostNewTrees(in_gpair, p_fmat, 0, &ret);
     new_trees.push_back(std::move(ret));
+  } else if (tparam_.parallel_class_boosting &&
+             tparam_.process_type == TreeProcessType::kDefault &&
+             tparam_.tree_method != TreeMethod::kGPUHist &&
+             !rabit::IsDistributed()) {
+    // the updaters issue rabit collectives; concurrent group builds would
+    // interleave them in a nondeterministic order across workers, so the
+    // distributed case takes the serial loop below instead
+    CHECK_EQ(in_gpair->Size() % ngroup, 0U)
+        << "must have exactly ngroup * nrow gpairs";
+    // the per-group gradients are independent within a round, so the group
+    // updaters can run concurrently as long as each group owns its updater
+    // sequence.
+    this->InitGroupUpdaters(this->cfg_, ngroup);
+    const auto& gpair_h = in_gpair->ConstHostVector();
+    const auto nsize = static_cast<bst_omp_uint>(in_gpair->Size() / ngroup);
+    // Split the row-interleaved gradients into one class-major array per
+    // group in a single traversal, so the interleaved vector is streamed
+    // once instead of once per class.
+    std::vector<HostDeviceVector<GradientPair>> group_gpair;
+    std::vector<GradientPair*> group_ptr(ngroup);
+    for (int gid = 0; gid < ngroup; ++gid) {
+      group_gpair.emplace_back(nsize, GradientPair(), in_gpair->DeviceIdx());
+      group_ptr[gid] = group_gpair.back().HostVector().data();
+    }
+#pragma omp parallel for schedule(static)
+    for (bst_omp_uint i = 0; i < nsize; ++i) {
+      for (int gid = 0; gid < ngroup; ++gid) {
+        group_ptr[gid][i] = gpair_h[i * ngroup + gid];
+      }
+    }
+    const int nthread = omp_get_max_threads();
+    const size_t n_workers = std::min(static_cast<size_t>(ngroup),
+                                      static_cast<size_t>(std::max(nthread, 1)));
+    if (!class_pool_ || class_pool_->NumWorkers() != n_workers) {
+      class_pool_.reset(new common::WorkStealingThreadPool(n_workers));
+    }
+    new_trees.resize(ngroup);
+    class_pool_->Execute(ngroup, [&](size_t, size_t gid) {
+      // split the OpenMP budget between the concurrent group builds
+      omp_set_num_threads(std::max(nthread / static_cast<int>(n_workers), 1));
+      BoostNewTrees(&group_gpair[gid], p_fmat, static_cast<int>(gid),
+                    group_updaters_[gid], &new_trees[gid]);
+    });
   } else {
     CHECK_EQ(in_gpair->Size() % ngroup, 0U)
         << "must have exactly ngroup * nrow gpairs";
@@ -216,7 +311,7 @@ void GBTree::DoBoost(DMatrix* p_fmat,
       for (bst_omp_uint i = 0; i < nsize; ++i) {
         tmp_h[i] = gpair_h[i * ngroup + gid];
       }
-      std::vector<std::unique_ptr<RegTree> > ret;
+      std::vector<std::shared_ptr<RegTree> > ret;
       BoostNewTrees(&tmp, p_fmat, gid, &ret);
       new_trees.push_back(std::move(ret));
     }
@@ -265,17 +360,77 @@ void GBTree::InitUpdater(Args const& cfg) {
   }
 }
 
+void GBTree::InitGroupUpdaters(Args const& cfg, int ngroup) {
+  if (group_updaters_.size() == static_cast<size_t>(ngroup)) {
+    return;
+  }
+  group_updaters_.clear();
+  std::vector<std::string> ups = common::Split(tparam_.updater_seq, ',');
+  // Every class quantizes the same matrix with the same binning parameters,
+  // so the per-class builders share one quantized index instead of each
+  // materializing a private copy.  Updaters without the parameter ignore it.
+  Args group_cfg = cfg;
+  group_cfg.emplace_back("shared_quantized_index", "true");
+  for (int gid = 0; gid < ngroup; ++gid) {
+    std::vector<std::unique_ptr<TreeUpdater>> group;
+    for (const std::string& pstr : ups) {
+      std::unique_ptr<TreeUpdater> up(TreeUpdater::Create(pstr.c_str(), generic_param_));
+      up->Configure(group_cfg);
+      group.push_back(std::move(up));
+    }
+    group_updaters_.push_back(std::move(group));
+  }
+}
+
 void GBTree::BoostNewTrees(HostDeviceVector<GradientPair>* gpair,
                            DMatrix *p_fmat,
                            int bst_group,
-                           std::vector<std::unique_ptr<RegTree> >* ret) {
+                           std::vector<std::shared_ptr<RegTree> >* ret) {
+  this->BoostNewTrees(gpair, p_fmat, bst_group, updaters_, ret);
+}
+
+void GBTree::BoostNewTrees(HostDeviceVector<GradientPair>* gpair,
+                           DMatrix *p_fmat,
+                           int bst_group,
+                           std::vector<std::unique_ptr<TreeUpdater>> const& updaters,
+                           std::vector<std::shared_ptr<RegTree> >* ret) {
   std::vector<RegTree*> new_trees;
   ret->clear();
+  // an epoch of the 'refresh_epoch' process restats every pending tree of
+  // this group in a single boosting round; once the epoch is done, later
+  // rounds fall through to the default process and grow new trees on top of
+  // the refreshed model.
+  const bool refresh_epoch =
+      tparam_.process_type == TreeProcessType::kRefreshEpoch &&
+      model_.trees.size() < model_.trees_to_update.size();
+  if (refresh_epoch) {
+    const int ngroup = model_.learner_model_param->num_output_group;
+    const size_t layer_trees =
+        static_cast<size_t>(tparam_.num_parallel_tree) * ngroup;
+    for (size_t i = 0; i < model_.trees_to_update.size(); ++i) {
+      const auto gid =
+          static_cast<int>((i % layer_trees) / tparam_.num_parallel_tree);
+      if (gid != bst_group) {
+        continue;
+      }
+      auto t = std::move(model_.trees_to_update[i]);
+      new_trees.push_back(t.get());
+      ret->push_back(std::move(t));
+    }
+    CHECK_EQ(gpair->Size(), p_fmat->Info().num_row_)
+        << "Mismatching size between number of rows from input data and size "
+           "of gradient vector.";
+    // the refresher rescales the learning rate by the number of trees, so the
+    // epoch amounts to one boosting step distributed over the whole model
+    refresher_->Update(gpair, p_fmat, new_trees);
+    return;
+  }
   // create the trees
   for (int i = 0; i < tparam_.num_parallel_tree; ++i) {
-    if (tparam_.process_type == TreeProcessType::kDefault) {
-      CHECK(!updaters_.front()->CanModifyTree())
-          << "Updater: `" << updaters_.front()->Name() << "` "
+    if (tparam_.process_type == TreeProcessType::kDefault ||
+        tparam_.process_type == TreeProcessType::kRefreshEpoch) {
+      CHECK(!updaters.front()->CanModifyTree())
+          << "Updater: `" << updaters.front()->Name() << "` "
           << "can not be used to create new trees. "
           << "Set `process_type` to `update` if you want to update existing "
              "trees.";
@@ -285,7 +440,7 @@ void GBTree::BoostNewTrees(HostDeviceVector<GradientPair>* gpair,
       new_trees.push_back(ptr.get());
       ret->push_back(std::move(ptr));
     } else if (tparam_.process_type == TreeProcessType::kUpdate) {
-      for (auto const& up : updaters_) {
+      for (auto const& up : updaters) {
         CHECK(up->CanModifyTree())
           << "Updater: `" << up->Name() << "` "
           << "can not be used to modify existing trees. "
@@ -305,12 +460,12 @@ void GBTree::BoostNewTrees(HostDeviceVector<GradientPair>* gpair,
   CHECK_EQ(gpair->Size(), p_fmat->Info().num_row_)
       << "Mismatching size between number of rows from input data and size of "
          "gradient vector.";
-  for (auto& up : updaters_) {
+  for (auto& up : updaters) {
     up->Update(gpair, p_fmat, new_trees);
   }
 }
 
-void GBTree::CommitModel(std::vector<std::vector<std::unique_ptr<RegTree>>>&& new_trees,
+void GBTree::CommitModel(std::vector<std::vector<std::shared_ptr<RegTree>>>&& new_trees,
                          DMatrix* m,
                          PredictionCacheEntry* predts) {
   monitor_.Start("CommitModel");
@@ -320,13 +475,43 @@ void GBTree::CommitModel(std::vector<std::vector<std::unique_ptr<RegTree>>>&& ne
     model_.CommitModel(std::move(new_trees[gid]), gid);
   }
   auto* out = &predts->predictions;
-  if (model_.learner_model_param->num_output_group == 1 &&
+  const auto ngroup = model_.learner_model_param->num_output_group;
+  if (ngroup == 1 &&
       updaters_.size() > 0 &&
       num_new_trees == 1 &&
       out->Size() > 0 &&
       updaters_.back()->UpdatePredictionCache(m, out)) {
-    auto delta = num_new_trees / model_.learner_model_param->num_output_group;
+    auto delta = num_new_trees / ngroup;
     predts->Update(delta);
+  } else if (ngroup > 1 &&
+             group_updaters_.size() == static_cast<size_t>(ngroup) &&
+             num_new_trees == static_cast<int>(ngroup) && out->Size() > 0) {
+    // Each class's updater accumulates its new tree's leaf values into a
+    // contiguous class-major scratch buffer, then the row-major cache is
+    // merged in one sequential pass.  Writing the cache directly would
+    // stride by num_class through the whole buffer once per class, and
+    // falling through re-predicts the new trees over every row instead.
+    std::vector<HostDeviceVector<bst_float>> deltas(ngroup);
+    bool updated = true;
+    for (uint32_t gid = 0; gid < ngroup && updated; ++gid) {
+      deltas[gid].Resize(m->Info().num_row_, 0.0f);
+      updated = group_updaters_[gid].back()->UpdatePredictionCache(m, &deltas[gid]);
+    }
+    if (updated) {
+      std::vector<bst_float const*> d_ptr(ngroup);
+      for (uint32_t gid = 0; gid < ngroup; ++gid) {
+        d_ptr[gid] = deltas[gid].ConstHostVector().data();
+      }
+      auto& h_out = out->HostVector();
+      const auto nsize = static_cast<bst_omp_uint>(m->Info().num_row_);
+#pragma omp parallel for schedule(static)
+      for (bst_omp_uint i = 0; i < nsize; ++i) {
+        for (uint32_t gid = 0; gid < ngroup; ++gid) {
+          h_out[i * ngroup + gid] += d_ptr[gid][i];
+        }
+      }
+      predts->Update(1);
+    }
   }
   monitor_.Stop("CommitModel");
 }
@@ -354,6 +539,7 @@ void GBTree::LoadConfig(Json const& in) {
 
   auto const& j_updaters = get<Object const>(in["updater"]);
   updaters_.clear();
+  group_updaters_.clear();
   for (auto const& kv : j_updaters) {
     std::unique_ptr<TreeUpdater> up(TreeUpdater::Create(kv.first, generic_param_));
     up->LoadConfig(kv.second);
@@ -412,7 +598,7 @@ void GBTree::Slice(int32_t layer_begin, int32_t layer_end, int32_t step,
   CHECK_GE(layer_end, layer_begin);
   CHECK_GE(step, 1);
   int32_t n_layers = (layer_end - layer_begin) / step;
-  std::vector<std::unique_ptr<RegTree>> &out_trees = out_model.trees;
+  std::vector<std::shared_ptr<RegTree>> &out_trees = out_model.trees;
   out_trees.resize(layer_trees * n_layers);
   std::vector<int32_t> &out_trees_info = out_model.tree_info;
   out_trees_info.resize(layer_trees * n_layers);
@@ -439,6 +625,19 @@ void GBTree::PredictBatch(DMatrix* p_fmat,
       ->PredictBatch(p_fmat, out_preds, model_, 0, ntree_limit);
 }
 
+bool GBTree::PredictBatchRanged(
+    DMatrix* p_fmat, PredictionCacheEntry* out_preds,
+    std::function<void(std::size_t, std::size_t)> const& on_range) {
+  CHECK(configured_);
+  // With multiple output groups row ranges and prediction ranges no longer
+  // coincide, so keep the separate passes.
+  if (model_.learner_model_param->num_output_group != 1) {
+    return false;
+  }
+  return GetPredictor(&out_preds->predictions, p_fmat)
+      ->PredictBatchRanged(p_fmat, out_preds, model_, 0, on_range);
+}
+
 std::unique_ptr<Predictor> const &
 GBTree::GetPredictor(HostDeviceVector<float> const *out_pred,
                      DMatrix *f_dmat) const {
@@ -526,6 +725,18 @@ class Dart : public GBTree {
     dparam_.UpdateAllowUnknown(cfg);
   }
 
+  // Dart scales committed trees by its own copy of the learning rate, so a
+  // typed update must go through the full configuration.
+  bool SetParamFloat(const std::string&, float) override {
+    return false;
+  }
+
+  // Dropout makes training predictions stateful; keep the separate passes.
+  bool PredictBatchRanged(DMatrix*, PredictionCacheEntry*,
+                          std::function<void(std::size_t, std::size_t)> const&) override {
+    return false;
+  }
+
   void Slice(int32_t layer_begin, int32_t layer_end, int32_t step,
              GradientBooster *out, bool* out_of_bound) const final {
     GBTree::Slice(layer_begin, layer_end, step, out, out_of_bound);
@@ -720,7 +931,7 @@ class Dart : public GBTree {
 
   // commit new trees all at once
   void
-  CommitModel(std::vector<std::vector<std::unique_ptr<RegTree>>>&& new_trees,
+  CommitModel(std::vector<std::vector<std::shared_ptr<RegTree>>>&& new_trees,
               DMatrix*, PredictionCacheEntry*) override {
     int num_new_trees = 0;
     for (uint32_t gid = 0; gid < model_.learner_model_param->num_output_group; ++gid) {
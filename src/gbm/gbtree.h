@@ -10,6 +10,7 @@
 #include <dmlc/omp.h>
 
 #include <vector>
+#include <functional>
 #include <map>
 #include <memory>
 #include <utility>
@@ -28,6 +29,7 @@
 
 #include "gbtree_model.h"
 #include "../common/common.h"
+#include "../common/threadpool.h"
 #include "../common/timer.h"
 
 namespace xgboost {
@@ -39,7 +41,8 @@ enum class TreeMethod : int {
 // boosting process types
 enum class TreeProcessType : int {
   kDefault = 0,
-  kUpdate = 1
+  kUpdate = 1,
+  kRefreshEpoch = 2
 };
 
 enum class PredictorType : int {
@@ -68,6 +71,8 @@ struct GBTreeTrainParam : public XGBoostParameter<GBTreeTrainParam> {
   std::string updater_seq;
   /*! \brief type of boosting process to run */
   TreeProcessType process_type;
+  /*! \brief whether to build the per-class trees of a round concurrently */
+  bool parallel_class_boosting;
   // predictor type
   PredictorType predictor;
   // tree construction method
@@ -86,8 +91,16 @@ struct GBTreeTrainParam : public XGBoostParameter<GBTreeTrainParam> {
         .set_default(TreeProcessType::kDefault)
         .add_enum("default", TreeProcessType::kDefault)
         .add_enum("update", TreeProcessType::kUpdate)
+        .add_enum("refresh_epoch", TreeProcessType::kRefreshEpoch)
         .describe("Whether to run the normal boosting process that creates new trees,"\
-                  " or to update the trees in an existing model.");
+                  " to update the trees in an existing model, or to refresh the leaf"\
+                  " statistics of the whole model in the first iteration and grow new"\
+                  " trees afterwards.");
+    DMLC_DECLARE_FIELD(parallel_class_boosting)
+        .set_default(false)
+        .describe("Build the trees of different output groups concurrently within a"\
+                  " boosting round.  Only used by CPU tree methods with multi-class"\
+                  " models.");
     DMLC_DECLARE_ALIAS(updater_seq, updater);
     DMLC_DECLARE_FIELD(predictor)
         .set_default(PredictorType::kAuto)
@@ -203,6 +216,7 @@ class GBTree : public GradientBooster {
       model_(booster_config) {}
 
   void Configure(const Args& cfg) override;
+  bool SetParamFloat(const std::string& key, float value) override;
   // Revise `tree_method` and `updater` parameters after seeing the training
   // data matrix, only useful when tree_method is auto.
   void PerformTreeMethodHeuristic(DMatrix* fmat);
@@ -234,6 +248,42 @@ class GBTree : public GradientBooster {
     model_.Save(fo);
   }
 
+  void CompactForInference() override {
+    model_.CompactForInference();
+  }
+
+  std::function<void(dmlc::Stream*)> MakeSaveSnapshot() const override {
+    // Committed trees are immutable and held by shared_ptr, so copying the
+    // model only copies pointers; the writer serializes from its own copy
+    // while training keeps appending trees to the live model.
+    return [model = model_](dmlc::Stream* fo) { model.Save(fo); };
+  }
+
+  std::function<void(dmlc::Stream*)> MakeDeltaSnapshot(
+      size_t* p_trees_done, uint64_t* p_base_generation) const override {
+    // A delta is only an append to the caller's last checkpoint while the
+    // already covered trees are untouched; anything that rewrote them, e.g.
+    // process_type=update or compaction, bumps the base generation.
+    if (*p_trees_done > model_.trees.size() ||
+        (*p_trees_done != 0 && *p_base_generation != model_.BaseGeneration())) {
+      return {};
+    }
+    size_t const tree_begin = *p_trees_done;
+    *p_trees_done = model_.trees.size();
+    *p_base_generation = model_.BaseGeneration();
+    return [model = model_, tree_begin](dmlc::Stream* fo) {
+      model.SaveDelta(fo, tree_begin);
+    };
+  }
+
+  bool LoadDelta(dmlc::Stream* fi) override {
+    if (!model_.LoadDelta(fi)) {
+      return false;
+    }
+    this->cfg_.clear();
+    return true;
+  }
+
   void LoadConfig(Json const& in) override;
   void SaveConfig(Json* p_out) const override;
 
@@ -244,6 +294,9 @@ class GBTree : public GradientBooster {
     return model_.learner_model_param->num_output_group == 1;
   }
 
+  /*! \brief the tree model, used by the multi-booster scoring C API */
+  GBTreeModel const& Model() const { return model_; }
+
   // Number of trees per layer.
   auto LayerTrees() const {
     auto n_trees = model_.learner_model_param->num_output_group * tparam_.num_parallel_tree;
@@ -260,6 +313,9 @@ class GBTree : public GradientBooster {
     return model_.trees.size() / this->LayerTrees();
   }
 
+  bool PredictBatchRanged(DMatrix* p_fmat, PredictionCacheEntry* out_preds,
+                          std::function<void(std::size_t, std::size_t)> const& on_range) override;
+
   void PredictBatch(DMatrix* p_fmat,
                     PredictionCacheEntry* out_preds,
                     bool training,
@@ -290,6 +346,26 @@ class GBTree : public GradientBooster {
     this->GetPredictor()->PredictLeaf(p_fmat, out_preds, model_, ntree_limit);
   }
 
+  bool PredictLeafInt32(DMatrix* p_fmat,
+                        common::Span<bst_node_t> out_indices,
+                        unsigned ntree_limit) override {
+    return this->GetPredictor()->PredictLeafInt32(p_fmat, out_indices, model_,
+                                                  ntree_limit);
+  }
+
+  bool PredictLeafStats(DMatrix* p_fmat,
+                        std::vector<bst_float>* out_stats,
+                        unsigned ntree_limit) override {
+    return this->GetPredictor()->PredictLeafStats(p_fmat, out_stats, model_,
+                                                  ntree_limit);
+  }
+
+  bool InstallTrees(std::vector<std::shared_ptr<RegTree>>&& trees,
+                    std::vector<int>&& tree_info) override {
+    model_.InstallTrees(std::move(trees), std::move(tree_info));
+    return true;
+  }
+
   void PredictContribution(DMatrix* p_fmat,
                            HostDeviceVector<bst_float>* out_contribs,
                            unsigned ntree_limit, bool approximate,
@@ -316,18 +392,26 @@ class GBTree : public GradientBooster {
  protected:
   // initialize updater before using them
   void InitUpdater(Args const& cfg);
+  // initialize one updater sequence per output group, used by parallel class boosting
+  void InitGroupUpdaters(Args const& cfg, int ngroup);
 
   // do group specific group
   void BoostNewTrees(HostDeviceVector<GradientPair>* gpair,
                      DMatrix *p_fmat,
                      int bst_group,
-                     std::vector<std::unique_ptr<RegTree> >* ret);
+                     std::vector<std::shared_ptr<RegTree> >* ret);
+  // same as above, but runs the provided updater sequence instead of `updaters_`
+  void BoostNewTrees(HostDeviceVector<GradientPair>* gpair,
+                     DMatrix *p_fmat,
+                     int bst_group,
+                     std::vector<std::unique_ptr<TreeUpdater>> const& updaters,
+                     std::vector<std::shared_ptr<RegTree> >* ret);
 
   std::unique_ptr<Predictor> const& GetPredictor(HostDeviceVector<float> const* out_pred = nullptr,
                                                  DMatrix* f_dmat = nullptr) const;
 
   // commit new trees all at once
-  virtual void CommitModel(std::vector<std::vector<std::unique_ptr<RegTree>>>&& new_trees,
+  virtual void CommitModel(std::vector<std::vector<std::shared_ptr<RegTree>>>&& new_trees,
                            DMatrix* m,
                            PredictionCacheEntry* predts);
 
@@ -343,6 +427,13 @@ class GBTree : public GradientBooster {
   Args cfg_;
   // the updaters that can be applied to each of tree
   std::vector<std::unique_ptr<TreeUpdater>> updaters_;
+  // dedicated refresher used by the 'refresh_epoch' process_type, kept apart
+  // from the grow updaters so new trees can still be built after the epoch
+  std::unique_ptr<TreeUpdater> refresher_;
+  // per-group updater sequences used when trees of a round are built concurrently
+  std::vector<std::vector<std::unique_ptr<TreeUpdater>>> group_updaters_;
+  // thread pool driving the concurrent per-group builds
+  std::unique_ptr<common::WorkStealingThreadPool> class_pool_;
   // Predictors
   std::unique_ptr<Predictor> cpu_predictor_;
 #if defined(XGBOOST_USE_CUDA)
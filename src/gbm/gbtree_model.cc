@@ -1,18 +1,358 @@
 /*!
  * Copyright 2019-2020 by Contributors
  */
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <queue>
 #include <utility>
 
 #include "xgboost/json.h"
 #include "xgboost/logging.h"
+#include "../common/threading_utils.h"
 #include "gbtree_model.h"
 #include "gbtree.h"
 
 namespace xgboost {
 namespace gbm {
+CompactTree::CompactTree(RegTree const& tree, bool reduced_precision) {
+  auto const& nodes = tree.GetNodes();
+  const bool has_cats = tree.HasCategoricalSplit();
+  split_index_.reserve(nodes.size());
+  split_cond_.reserve(nodes.size());
+  left_child_.reserve(nodes.size());
+  std::vector<bool> default_left;
+  default_left.reserve(nodes.size());
+  if (has_cats) {
+    cat_segments_.reserve(nodes.size());
+  }
+
+  std::queue<bst_node_t> nids;
+  nids.push(RegTree::kRoot);
+  while (!nids.empty()) {
+    const bst_node_t nid = nids.front();
+    auto const& node = nodes[nid];
+    nids.pop();
+    if (node.IsLeaf()) {
+      split_index_.push_back(0);
+      split_cond_.push_back(node.LeafValue());
+      left_child_.push_back(kLeaf);
+      default_left.push_back(false);
+      if (has_cats) {
+        cat_segments_.emplace_back();
+      }
+    } else {
+      // children are appended after everything still queued, siblings adjacent
+      auto left = static_cast<bst_node_t>(left_child_.size() + 1 + nids.size());
+      split_index_.push_back(node.SplitIndex());
+      split_cond_.push_back(node.SplitCond());
+      left_child_.push_back(left);
+      default_left.push_back(node.DefaultLeft());
+      if (has_cats) {
+        // copy the bitset into the flat arena under the breadth-first id
+        CatSegment seg;
+        if (tree.NodeSplitType(nid) == FeatureType::kCategorical) {
+          auto cats = tree.NodeCats(nid);
+          seg.beg = static_cast<uint32_t>(categories_.size());
+          seg.size = static_cast<uint32_t>(cats.size());
+          categories_.insert(categories_.end(), cats.data(),
+                             cats.data() + cats.size());
+        }
+        cat_segments_.push_back(seg);
+      }
+      nids.push(node.LeftChild());
+      nids.push(node.RightChild());
+    }
+  }
+
+  default_left_.resize(CLBitField32::ComputeStorageSize(default_left.size()), 0);
+  LBitField32 bits{{default_left_.data(), default_left_.size()}};
+  for (size_t nid = 0; nid < default_left.size(); ++nid) {
+    if (default_left[nid]) {
+      bits.Set(nid);
+    }
+  }
+
+  if (reduced_precision) {
+    // Rounded thresholds may flip the direction of values falling between a
+    // threshold and its rounding, which is accepted by this mode; the leaf
+    // rounding error is tracked so the caller can report an output bound.
+    bf16_cond_.resize(split_cond_.size());
+    for (size_t nid = 0; nid < split_cond_.size(); ++nid) {
+      bf16_cond_[nid] = EncodeBF16(split_cond_[nid]);
+      if (left_child_[nid] == kLeaf) {
+        max_leaf_delta_ =
+            std::max(max_leaf_delta_,
+                     std::abs(DecodeBF16(bf16_cond_[nid]) - split_cond_[nid]));
+      }
+    }
+    std::vector<bst_float>().swap(split_cond_);
+  }
+
+  // Classify complete trees: 2^(d+1)-1 nodes with every internal child at the
+  // implicit heap position and every node past the last level a leaf.  The
+  // branchless complete-tree traversal only compares against the split
+  // condition, so trees with categorical splits stay on the generic path.
+  if (has_cats) {
+    return;
+  }
+  const size_t n_nodes = left_child_.size();
+  for (int depth = 1; depth <= kMaxCompleteDepth; ++depth) {
+    const size_t n_internal = (static_cast<size_t>(1) << depth) - 1;
+    if (n_nodes != 2 * n_internal + 1) {
+      continue;
+    }
+    bool complete = true;
+    for (size_t nid = 0; nid < n_internal && complete; ++nid) {
+      complete = left_child_[nid] == static_cast<bst_node_t>(2 * nid + 1);
+    }
+    for (size_t nid = n_internal; nid < n_nodes && complete; ++nid) {
+      complete = left_child_[nid] == kLeaf;
+    }
+    if (complete) {
+      complete_depth_ = depth;
+    }
+    break;
+  }
+}
+
+std::vector<CompactTree> const& GBTreeModel::CompactTrees() const {
+  if (compact_trees_.size() != trees.size()) {
+    // Bandwidth-bound scoring jobs can opt into bfloat16 split conditions and
+    // leaf values; each tree's rounding is validated at conversion time and
+    // the summed leaf deltas bound the prediction delta.
+    const bool bf16 = dmlc::GetEnv("XGBOOST_COMPACT_BF16", 0) != 0;
+    compact_trees_.clear();
+    compact_trees_.reserve(trees.size());
+    double output_delta = 0.0;
+    for (auto const& tree : trees) {
+      compact_trees_.emplace_back(*tree, bf16);
+      output_delta += compact_trees_.back().MaxLeafDelta();
+    }
+    if (bf16 && !trees.empty()) {
+      LOG(INFO) << "Reduced-precision inference layout: the margin of a "
+                << "prediction can shift by up to " << output_delta
+                << " from leaf rounding alone, more when a rounded threshold "
+                << "flips a split.";
+    }
+  }
+  return compact_trees_;
+}
+
+std::vector<uint32_t> const& GBTreeModel::UsedFeatures() const {
+  if (used_features_generation_ != generation_) {
+    auto const n_features = learner_model_param->num_feature;
+    used_features_.assign((n_features + 31) / 32, 0u);
+    for (auto const& tree : trees) {
+      for (auto const& node : tree->GetNodes()) {
+        if (!node.IsLeaf() && !node.IsDeleted()) {
+          auto const fid = node.SplitIndex();
+          used_features_[fid >> 5] |= 1u << (fid & 31);
+        }
+      }
+    }
+    n_used_features_ = 0;
+    for (auto word : used_features_) {
+      for (; word != 0; word &= word - 1) {
+        ++n_used_features_;
+      }
+    }
+    used_features_generation_ = generation_;
+  }
+  return used_features_;
+}
+
+namespace {
+// "XGBC", cannot collide with GBTreeModelParam::num_trees of the legacy format
+constexpr uint32_t kColumnarFormatMagic = 0x58474243;
+constexpr uint32_t kColumnarFormatVersion = 1;
+// "XGBD", delta checkpoints written by SaveDelta
+constexpr uint64_t kDeltaFormatMagic = 0x58474244;
+constexpr uint64_t kDeltaFormatVersion = 1;
+
+template <typename T>
+void WriteColumn(dmlc::Stream* fo, std::vector<T> const& column) {
+  if (column.empty()) {
+    return;
+  }
+  if (DMLC_IO_NO_ENDIAN_SWAP) {
+    fo->Write(dmlc::BeginPtr(column), sizeof(T) * column.size());
+  } else {
+    for (auto v : column) {
+      dmlc::ByteSwap(&v, sizeof(v), 1);
+      fo->Write(&v, sizeof(v));
+    }
+  }
+}
+
+template <typename T>
+void ReadColumn(dmlc::Stream* fi, std::vector<T>* p_column) {
+  auto& column = *p_column;
+  if (column.empty()) {
+    return;
+  }
+  CHECK_EQ(fi->Read(dmlc::BeginPtr(column), sizeof(T) * column.size()),
+           sizeof(T) * column.size())
+      << "GBTree: invalid columnar model file";
+  if (!DMLC_IO_NO_ENDIAN_SWAP) {
+    dmlc::ByteSwap(dmlc::BeginPtr(column), sizeof(T), column.size());
+  }
+}
+}  // anonymous namespace
+
+void GBTreeModel::SaveColumnar(dmlc::Stream* fo) const {
+  CHECK_EQ(param.num_trees, static_cast<int32_t>(trees.size()));
+  std::vector<uint32_t> header{kColumnarFormatMagic, kColumnarFormatVersion};
+  WriteColumn(fo, header);
+  if (DMLC_IO_NO_ENDIAN_SWAP) {
+    fo->Write(&param, sizeof(param));
+  } else {
+    auto x = param.ByteSwap();
+    fo->Write(&x, sizeof(x));
+  }
+
+  std::vector<uint64_t> offsets(trees.size() + 1, 0);
+  std::vector<TreeParam> tree_params(trees.size());
+  for (size_t t = 0; t < trees.size(); ++t) {
+    offsets[t + 1] = offsets[t] + trees[t]->GetNodes().size();
+    tree_params[t] = trees[t]->param;
+    if (!DMLC_IO_NO_ENDIAN_SWAP) {
+      tree_params[t] = tree_params[t].ByteSwap();
+    }
+  }
+  WriteColumn(fo, offsets);
+  if (!tree_params.empty()) {
+    fo->Write(dmlc::BeginPtr(tree_params), sizeof(TreeParam) * tree_params.size());
+  }
+
+  size_t const total_nodes = offsets.back();
+  std::vector<int32_t> parent(total_nodes);
+  std::vector<int32_t> left_child(total_nodes);
+  std::vector<int32_t> right_child(total_nodes);
+  std::vector<uint32_t> split_index(total_nodes);
+  std::vector<bst_float> split_cond(total_nodes);
+  std::vector<bst_float> loss_chg(total_nodes);
+  std::vector<bst_float> sum_hess(total_nodes);
+  std::vector<bst_float> base_weight(total_nodes);
+  std::vector<int32_t> leaf_child_cnt(total_nodes);
+
+  for (size_t t = 0; t < trees.size(); ++t) {
+    auto const& tree = *trees[t];
+    auto const& nodes = tree.GetNodes();
+    size_t const beg = offsets[t];
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      auto const& node = nodes[i];
+      parent[beg + i] = static_cast<int32_t>(
+          static_cast<uint32_t>(node.Parent()) | (node.IsLeftChild() ? 1U << 31 : 0U));
+      left_child[beg + i] = node.LeftChild();
+      right_child[beg + i] = node.RightChild();
+      split_index[beg + i] = node.SplitIndex() | (node.DefaultLeft() ? 1U << 31 : 0U);
+      split_cond[beg + i] = node.SplitCond();
+      auto const& stat = tree.Stat(i);
+      loss_chg[beg + i] = stat.loss_chg;
+      sum_hess[beg + i] = stat.sum_hess;
+      base_weight[beg + i] = stat.base_weight;
+      leaf_child_cnt[beg + i] = stat.leaf_child_cnt;
+    }
+  }
+
+  WriteColumn(fo, parent);
+  WriteColumn(fo, left_child);
+  WriteColumn(fo, right_child);
+  WriteColumn(fo, split_index);
+  WriteColumn(fo, split_cond);
+  WriteColumn(fo, loss_chg);
+  WriteColumn(fo, sum_hess);
+  WriteColumn(fo, base_weight);
+  WriteColumn(fo, leaf_child_cnt);
+  WriteColumn(fo, tree_info);
+}
+
+void GBTreeModel::LoadColumnar(dmlc::Stream* fi) {
+  std::vector<uint32_t> version(1);
+  ReadColumn(fi, &version);
+  CHECK_EQ(version[0], kColumnarFormatVersion)
+      << "GBTree: unsupported columnar model version";
+  CHECK_EQ(fi->Read(&param, sizeof(param)), sizeof(param))
+      << "GBTree: invalid columnar model file";
+  if (!DMLC_IO_NO_ENDIAN_SWAP) {
+    param = param.ByteSwap();
+  }
+
+  std::vector<uint64_t> offsets(param.num_trees + 1);
+  ReadColumn(fi, &offsets);
+  std::vector<TreeParam> tree_params(param.num_trees);
+  if (!tree_params.empty()) {
+    CHECK_EQ(fi->Read(dmlc::BeginPtr(tree_params),
+                      sizeof(TreeParam) * tree_params.size()),
+             sizeof(TreeParam) * tree_params.size())
+        << "GBTree: invalid columnar model file";
+    if (!DMLC_IO_NO_ENDIAN_SWAP) {
+      for (auto& p : tree_params) {
+        p = p.ByteSwap();
+      }
+    }
+  }
+
+  size_t const total_nodes = offsets.back();
+  std::vector<int32_t> parent(total_nodes);
+  std::vector<int32_t> left_child(total_nodes);
+  std::vector<int32_t> right_child(total_nodes);
+  std::vector<uint32_t> split_index(total_nodes);
+  std::vector<bst_float> split_cond(total_nodes);
+  std::vector<bst_float> loss_chg(total_nodes);
+  std::vector<bst_float> sum_hess(total_nodes);
+  std::vector<bst_float> base_weight(total_nodes);
+  std::vector<int32_t> leaf_child_cnt(total_nodes);
+
+  ReadColumn(fi, &parent);
+  ReadColumn(fi, &left_child);
+  ReadColumn(fi, &right_child);
+  ReadColumn(fi, &split_index);
+  ReadColumn(fi, &split_cond);
+  ReadColumn(fi, &loss_chg);
+  ReadColumn(fi, &sum_hess);
+  ReadColumn(fi, &base_weight);
+  ReadColumn(fi, &leaf_child_cnt);
+
+  trees.clear();
+  trees_to_update.clear();
+  compact_trees_.clear();
+  ++generation_;
+  base_generation_ = generation_;
+  for (int32_t t = 0; t < param.num_trees; ++t) {
+    size_t const beg = offsets[t];
+    size_t const n_nodes = offsets[t + 1] - beg;
+    std::vector<RegTree::Node> nodes(n_nodes);
+    std::vector<RTreeNodeStat> stats(n_nodes);
+    for (size_t i = 0; i < n_nodes; ++i) {
+      auto& node = nodes[i];
+      auto const p = static_cast<uint32_t>(parent[beg + i]);
+      node.SetParent(static_cast<int32_t>(p & ((1U << 31) - 1U)), (p >> 31) != 0);
+      auto const s = split_index[beg + i];
+      node.SetSplit(s & ((1U << 31) - 1U), split_cond[beg + i], (s >> 31) != 0);
+      node.SetLeftChild(left_child[beg + i]);
+      node.SetRightChild(right_child[beg + i]);
+      stats[i] = RTreeNodeStat{loss_chg[beg + i], sum_hess[beg + i], base_weight[beg + i]};
+      stats[i].leaf_child_cnt = leaf_child_cnt[beg + i];
+    }
+    std::unique_ptr<RegTree> ptr(new RegTree());
+    ptr->LoadNodes(tree_params[t], std::move(nodes), std::move(stats));
+    trees.push_back(std::move(ptr));
+  }
+
+  tree_info.resize(param.num_trees);
+  ReadColumn(fi, &tree_info);
+}
+
 void GBTreeModel::Save(dmlc::Stream* fo) const {
   CHECK_EQ(param.num_trees, static_cast<int32_t>(trees.size()));
 
+  if (dmlc::GetEnv("XGBOOST_COLUMNAR_MODEL", 0) != 0) {
+    this->SaveColumnar(fo);
+    return;
+  }
+
   if (DMLC_IO_NO_ENDIAN_SWAP) {
     fo->Write(&param, sizeof(param));
   } else {
@@ -36,13 +376,31 @@ void GBTreeModel::Save(dmlc::Stream* fo) const {
 }
 
 void GBTreeModel::Load(dmlc::Stream* fi) {
-  CHECK_EQ(fi->Read(&param, sizeof(param)), sizeof(param))
+  uint32_t first {0};
+  CHECK_EQ(fi->Read(&first, sizeof(first)), sizeof(first))
+      << "GBTree: invalid model file";
+  auto magic = kColumnarFormatMagic;
+  if (!DMLC_IO_NO_ENDIAN_SWAP) {
+    dmlc::ByteSwap(&magic, sizeof(magic), 1);
+  }
+  if (first == magic) {
+    this->LoadColumnar(fi);
+    return;
+  }
+  // legacy format, the first word read is GBTreeModelParam::num_trees
+  std::memcpy(&param, &first, sizeof(first));
+  CHECK_EQ(fi->Read(reinterpret_cast<char*>(&param) + sizeof(first),
+                    sizeof(param) - sizeof(first)),
+           sizeof(param) - sizeof(first))
       << "GBTree: invalid model file";
   if (!DMLC_IO_NO_ENDIAN_SWAP) {
     param = param.ByteSwap();
   }
   trees.clear();
   trees_to_update.clear();
+  compact_trees_.clear();
+  ++generation_;
+  base_generation_ = generation_;
   for (int32_t i = 0; i < param.num_trees; ++i) {
     std::unique_ptr<RegTree> ptr(new RegTree());
     ptr->Load(fi);
@@ -63,19 +421,122 @@ void GBTreeModel::Load(dmlc::Stream* fi) {
   }
 }
 
+void GBTreeModel::SaveDelta(dmlc::Stream* fo, size_t tree_begin) const {
+  CHECK_EQ(param.num_trees, static_cast<int32_t>(trees.size()));
+  CHECK_LE(tree_begin, trees.size());
+  std::vector<uint64_t> header{kDeltaFormatMagic, kDeltaFormatVersion,
+                               tree_begin, trees.size()};
+  WriteColumn(fo, header);
+  for (size_t t = tree_begin; t < trees.size(); ++t) {
+    trees[t]->Save(fo);
+  }
+  std::vector<int32_t> info(tree_info.begin() + tree_begin, tree_info.end());
+  WriteColumn(fo, info);
+}
+
+bool GBTreeModel::LoadDelta(dmlc::Stream* fi) {
+  std::vector<uint64_t> header(4);
+  if (fi->Read(dmlc::BeginPtr(header), sizeof(uint64_t) * header.size()) !=
+      sizeof(uint64_t) * header.size()) {
+    return false;
+  }
+  if (!DMLC_IO_NO_ENDIAN_SWAP) {
+    dmlc::ByteSwap(dmlc::BeginPtr(header), sizeof(uint64_t), header.size());
+  }
+  if (header[0] != kDeltaFormatMagic || header[1] != kDeltaFormatVersion) {
+    return false;
+  }
+  size_t const tree_begin = header[2];
+  size_t const tree_end = header[3];
+  if (tree_begin != trees.size() || tree_end < tree_begin) {
+    return false;
+  }
+  for (size_t t = tree_begin; t < tree_end; ++t) {
+    std::unique_ptr<RegTree> ptr(new RegTree());
+    ptr->Load(fi);
+    trees.push_back(std::move(ptr));
+  }
+  std::vector<int32_t> info(tree_end - tree_begin);
+  ReadColumn(fi, &info);
+  tree_info.insert(tree_info.end(), info.begin(), info.end());
+  param.num_trees = static_cast<int32_t>(trees.size());
+  compact_trees_.clear();
+  ++generation_;
+  return true;
+}
+
+void GBTreeModel::FeatureImportance(std::string const& importance_type,
+                                    std::vector<bst_float>* p_scores) const {
+  size_t const n_features = learner_model_param->num_feature;
+  bool const use_gain =
+      importance_type == "gain" || importance_type == "total_gain";
+  bool const use_cover =
+      importance_type == "cover" || importance_type == "total_cover";
+  bool const average = importance_type == "gain" || importance_type == "cover";
+  CHECK(use_gain || use_cover || importance_type == "weight")
+      << "Unknown importance type: " << importance_type;
+
+  // trees only read their own accumulators, the reduction happens once below
+  auto const nthread = static_cast<size_t>(omp_get_max_threads());
+  std::vector<std::vector<double>> sum_tloc(
+      nthread, std::vector<double>(n_features, 0.0));
+  std::vector<std::vector<double>> cnt_tloc(
+      nthread, std::vector<double>(n_features, 0.0));
+  common::ParallelFor(trees.size(), nthread, [&](size_t t) {
+    auto& sum = sum_tloc[omp_get_thread_num()];
+    auto& cnt = cnt_tloc[omp_get_thread_num()];
+    auto const& nodes = trees[t]->GetNodes();
+    auto const& stats = trees[t]->GetStats();
+    for (size_t nid = 0; nid < nodes.size(); ++nid) {
+      auto const& node = nodes[nid];
+      if (node.IsDeleted() || node.IsLeaf()) {
+        continue;
+      }
+      auto const fid = node.SplitIndex();
+      cnt[fid] += 1.0;
+      if (use_gain) {
+        sum[fid] += stats[nid].loss_chg;
+      } else if (use_cover) {
+        sum[fid] += stats[nid].sum_hess;
+      }
+    }
+  });
+
+  auto& scores = *p_scores;
+  scores.assign(n_features, 0.0f);
+  for (size_t fid = 0; fid < n_features; ++fid) {
+    double sum = 0.0;
+    double cnt = 0.0;
+    for (size_t tid = 0; tid < nthread; ++tid) {
+      sum += sum_tloc[tid][fid];
+      cnt += cnt_tloc[tid][fid];
+    }
+    if (importance_type == "weight") {
+      scores[fid] = static_cast<bst_float>(cnt);
+    } else if (average) {
+      scores[fid] = cnt > 0.0 ? static_cast<bst_float>(sum / cnt) : 0.0f;
+    } else {
+      scores[fid] = static_cast<bst_float>(sum);
+    }
+  }
+}
+
 void GBTreeModel::SaveModel(Json* p_out) const {
   auto& out = *p_out;
   CHECK_EQ(param.num_trees, static_cast<int>(trees.size()));
   out["gbtree_model_param"] = ToJson(param);
   std::vector<Json> trees_json(trees.size());
 
-  for (size_t t = 0; t < trees.size(); ++t) {
+  // Each tree serializes into its own slot of the pre-sized array; the
+  // trees are independent, so the per-tree document builds run on all
+  // cores and the result is identical to the serial construction.
+  common::ParallelFor(trees.size(), omp_get_max_threads(), [&](size_t t) {
     auto const& tree = trees[t];
     Json tree_json{Object()};
     tree->SaveModel(&tree_json);
     tree_json["id"] = Integer(static_cast<Integer::Int>(t));
     trees_json[t] = std::move(tree_json);
-  }
+  });
 
   std::vector<Json> tree_info_json(tree_info.size());
   for (size_t i = 0; i < tree_info.size(); ++i) {
@@ -91,6 +552,9 @@ void GBTreeModel::LoadModel(Json const& in) {
 
   trees.clear();
   trees_to_update.clear();
+  compact_trees_.clear();
+  ++generation_;
+  base_generation_ = generation_;
 
   auto const& trees_json = get<Array const>(in["trees"]);
   trees.resize(trees_json.size());
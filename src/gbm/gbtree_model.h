@@ -12,17 +12,135 @@
 #include <xgboost/parameter.h>
 #include <xgboost/learner.h>
 
+#include <cstring>
 #include <memory>
 #include <utility>
 #include <string>
 #include <vector>
 
+#include "../common/bitfield.h"
+#include "../common/categorical.h"
+
 namespace xgboost {
 
 class Json;
 
 namespace gbm {
 
+/*!
+ * \brief Breadth-first SoA layout of a single tree for batch inference.
+ *
+ * Nodes are renumbered level by level so that siblings occupy adjacent slots
+ * and the arrays of one level stay cache linear, instead of hopping across
+ * 20-byte `RegTree::Node` objects in creation order.  The right child always
+ * directly follows the left one, leaves reuse the split condition slot for
+ * their value, and default directions are packed into a bitfield.  The
+ * category bitsets of categorical splits are copied into one flat arena with
+ * a per-node offset and length, so deciding the direction is a single
+ * word-indexed bit test instead of recomputing a span per node visit.
+ */
+class CompactTree {
+ public:
+  static constexpr bst_node_t kLeaf = -1;
+
+  /*!
+   * \param tree source tree
+   * \param reduced_precision store split conditions and leaf values as
+   *  bfloat16, halving the memory traffic of the condition array at the cost
+   *  of rounded thresholds and leaves; see MaxLeafDelta.
+   */
+  explicit CompactTree(RegTree const& tree, bool reduced_precision = false);
+
+  /*! \brief whether the source tree could not be flattened */
+  bool Empty() const { return left_child_.empty(); }
+
+  bool IsLeaf(bst_node_t nid) const { return left_child_[nid] == kLeaf; }
+  bst_feature_t SplitIndex(bst_node_t nid) const { return split_index_[nid]; }
+  bst_float SplitCond(bst_node_t nid) const {
+    return bf16_cond_.empty() ? split_cond_[nid] : DecodeBF16(bf16_cond_[nid]);
+  }
+  bst_float LeafValue(bst_node_t nid) const { return SplitCond(nid); }
+  /*! \brief largest leaf value rounding error of the reduced-precision
+   *  layout; summed over the trees of a model it bounds the output delta */
+  bst_float MaxLeafDelta() const { return max_leaf_delta_; }
+
+  /*! \brief round to the nearest bfloat16, ties to even */
+  static uint16_t EncodeBF16(bst_float v) {
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    bits += 0x7fffu + ((bits >> 16) & 1u);
+    return static_cast<uint16_t>(bits >> 16);
+  }
+  static bst_float DecodeBF16(uint16_t v) {
+    uint32_t bits = static_cast<uint32_t>(v) << 16;
+    bst_float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+  }
+
+  static constexpr int kMaxCompleteDepth = 8;
+
+  /*!
+   * \brief Depth of a complete tree, 0 for any other shape.
+   *
+   * In the breadth-first numbering a complete tree is the implicit heap
+   * layout - the children of node i sit at 2i+1 and 2i+2 - so traversal
+   * needs neither child pointers nor leaf checks.  Only depths up to
+   * kMaxCompleteDepth are classified, deeper trees take the generic path.
+   */
+  int CompleteDepth() const { return complete_depth_; }
+
+  /*! \brief next node of the tree given current nid, see RegTree::GetNext */
+  template <bool has_missing>
+  bst_node_t Next(bst_node_t nid, bst_float fvalue, bool is_unknown) const {
+    if (has_missing && is_unknown) {
+      return left_child_[nid] + !this->DefaultLeft(nid);
+    }
+    if (!cat_segments_.empty() && cat_segments_[nid].size != 0) {
+      // set bits go right; LBitField32 numbers the bits of a word from the
+      // most significant end.  Categories past the stored bitset go left,
+      // and so do negative values through the unsigned wrap-around, matching
+      // common::Decision.
+      const auto cat = static_cast<uint32_t>(common::AsCat(fvalue));
+      const CatSegment seg = cat_segments_[nid];
+      const bool go_right =
+          (cat >> 5) < seg.size &&
+          (categories_[seg.beg + (cat >> 5)] & (1u << (31 - (cat & 31))));
+      return left_child_[nid] + static_cast<bst_node_t>(go_right);
+    }
+    return left_child_[nid] + !(fvalue < this->SplitCond(nid));
+  }
+
+ private:
+  bool DefaultLeft(bst_node_t nid) const {
+    return CLBitField32{{default_left_.data(), default_left_.size()}}.Check(
+        static_cast<uint32_t>(nid));
+  }
+
+  std::vector<bst_feature_t> split_index_;
+  /*! \brief split condition for internal nodes, leaf value for leaves;
+   *  empty when the reduced-precision array is in use */
+  std::vector<bst_float> split_cond_;
+  /*! \brief bfloat16 split conditions of the reduced-precision layout */
+  std::vector<uint16_t> bf16_cond_;
+  bst_float max_leaf_delta_ {0.0f};
+  /*! \brief left child index, kLeaf marks a leaf; right child is left + 1 */
+  std::vector<bst_node_t> left_child_;
+  /*! \brief storage for the default direction bitfield */
+  std::vector<uint32_t> default_left_;
+  /*! \brief per-node window into categories_, size 0 marks a numeric split */
+  struct CatSegment {
+    uint32_t beg{0};
+    uint32_t size{0};
+  };
+  /*! \brief empty unless the tree has at least one categorical split */
+  std::vector<CatSegment> cat_segments_;
+  /*! \brief category bitsets of all categorical splits, back to back */
+  std::vector<uint32_t> categories_;
+  /*! \brief depth when the tree is complete and shallow enough, 0 otherwise */
+  int complete_depth_ {0};
+};
+
 /*! \brief model parameters */
 struct GBTreeModelParam : public dmlc::Parameter<GBTreeModelParam> {
  public:
@@ -98,15 +216,69 @@ struct GBTreeModel : public Model {
       trees.clear();
       param.num_trees = 0;
       tree_info.clear();
+      compact_trees_.clear();
+      ++generation_;
+      base_generation_ = generation_;
     }
   }
 
   void Load(dmlc::Stream* fi);
   void Save(dmlc::Stream* fo) const;
+  /*!
+   * \brief Save the model in the binary columnar format: every node field is
+   *  stored as one contiguous array over all trees with per-tree offsets up
+   *  front, so loading is a handful of bulk reads instead of one small read
+   *  per tree.  Written by Save when XGBOOST_COLUMNAR_MODEL is set and
+   *  detected by Load through the format magic.
+   */
+  void SaveColumnar(dmlc::Stream* fo) const;
+  /*! \brief Load the columnar format, the magic has already been consumed. */
+  void LoadColumnar(dmlc::Stream* fi);
+  /*!
+   * \brief Save an incremental checkpoint holding only the trees at indices
+   *  [tree_begin, trees.size()).  Committed trees are immutable, so a model
+   *  equals the base checkpoint that covered its first trees plus the deltas
+   *  written since; the delta format is self-describing and records
+   *  tree_begin so out-of-order application can be rejected.
+   */
+  void SaveDelta(dmlc::Stream* fo, size_t tree_begin) const;
+  /*!
+   * \brief Append the trees of a delta checkpoint written by SaveDelta.
+   * \return false without touching the model when the stream is not a delta
+   *  checkpoint or its tree_begin does not match the current tree count,
+   *  e.g. a stale delta file left over from an earlier run.
+   */
+  bool LoadDelta(dmlc::Stream* fi);
+  /*!
+   * \brief Compute per-feature importance in one parallel pass over the
+   *  trees, reading the split statistics directly instead of going through
+   *  the text dump.
+   * \param importance_type one of weight, gain, cover, total_gain or
+   *  total_cover.
+   * \param p_scores output scores indexed by feature, zero for features no
+   *  tree splits on.
+   */
+  void FeatureImportance(std::string const& importance_type,
+                         std::vector<bst_float>* p_scores) const;
 
   void SaveModel(Json* p_out) const override;
   void LoadModel(Json const& p_out) override;
 
+  /*!
+   * \brief Install trees parsed by the direct JSON model reader, replacing
+   *  the empty tree list produced by LoadModel on a document with the tree
+   *  arrays spliced out.
+   */
+  void InstallTrees(std::vector<std::shared_ptr<RegTree>>&& new_trees,
+                    std::vector<int>&& new_tree_info) {
+    trees = std::move(new_trees);
+    tree_info = std::move(new_tree_info);
+    param.num_trees = static_cast<int>(trees.size());
+    compact_trees_.clear();
+    ++generation_;
+    base_generation_ = generation_;
+  }
+
   std::vector<std::string> DumpModel(const FeatureMap& fmap, bool with_stats,
                                      std::string format) const {
     std::vector<std::string> dump;
@@ -115,25 +287,95 @@ struct GBTreeModel : public Model {
     }
     return dump;
   }
-  void CommitModel(std::vector<std::unique_ptr<RegTree> >&& new_trees,
+  void CommitModel(std::vector<std::shared_ptr<RegTree> >&& new_trees,
                    int bst_group) {
     for (auto & new_tree : new_trees) {
       trees.push_back(std::move(new_tree));
       tree_info.push_back(bst_group);
     }
     param.num_trees += static_cast<int>(new_trees.size());
+    compact_trees_.clear();
+    ++generation_;
+  }
+
+  /*!
+   * \brief Compact every tree for inference, see RegTree::CompactForInference.
+   *  The trees are replaced rather than mutated, so snapshot holders keep the
+   *  uncompacted trees alive.
+   */
+  void CompactForInference() {
+    for (auto& tree : trees) {
+      auto compacted = std::make_shared<RegTree>(*tree);
+      compacted->CompactForInference();
+      tree = std::move(compacted);
+    }
+    compact_trees_.clear();
+    ++generation_;
+    base_generation_ = generation_;
+  }
+
+  /*!
+   * \brief Monotonically increasing counter bumped whenever the trees change,
+   *  letting predictors tell whether a cached device copy of the model is
+   *  stale without inspecting the trees themselves.
+   */
+  uint64_t Generation() const { return generation_; }
+
+  /*!
+   * \brief Generation of the last mutation that touched existing trees, as
+   *  opposed to CommitModel which only appends.  A cached copy taken at
+   *  generation g >= BaseGeneration() thus still holds a valid prefix of the
+   *  model and only needs the trees added since, which predictors use to
+   *  upload new trees incrementally during training.
+   */
+  uint64_t BaseGeneration() const { return base_generation_; }
+
+  /*!
+   * \brief Flattened layout of `trees` for batch inference, built lazily and
+   *        invalidated whenever the trees change.  Callers must not invoke
+   *        this concurrently with the first build.
+   */
+  std::vector<CompactTree> const& CompactTrees() const;
+
+  /*!
+   * \brief Bitmap over feature indices with a set bit for every feature some
+   *        tree splits on, letting inference skip staging features the model
+   *        never tests.  Built lazily, invalidated whenever the trees change;
+   *        same concurrency caveat as CompactTrees.
+   */
+  std::vector<uint32_t> const& UsedFeatures() const;
+  /*! \brief number of set bits in UsedFeatures, built together with it */
+  size_t NumUsedFeatures() const {
+    UsedFeatures();
+    return n_used_features_;
   }
 
   // base margin
   LearnerModelParam const* learner_model_param;
   // model parameter
   GBTreeModelParam param;
-  /*! \brief vector of trees stored in the model */
-  std::vector<std::unique_ptr<RegTree> > trees;
+  /*! \brief vector of trees stored in the model.  Shared ownership lets
+   *  checkpoint writers keep a snapshot of the trees alive while training
+   *  appends new ones; committed trees are never mutated. */
+  std::vector<std::shared_ptr<RegTree> > trees;
   /*! \brief for the update process, a place to keep the initial trees */
-  std::vector<std::unique_ptr<RegTree> > trees_to_update;
+  std::vector<std::shared_ptr<RegTree> > trees_to_update;
   /*! \brief some information indicator of the tree, reserved */
   std::vector<int> tree_info;
+
+ private:
+  /*! \brief lazily built inference layout, mutable as prediction is const */
+  mutable std::vector<CompactTree> compact_trees_;
+  /*! \brief lazily built split feature bitmap, see UsedFeatures */
+  mutable std::vector<uint32_t> used_features_;
+  /*! \brief number of set bits in used_features_ */
+  mutable size_t n_used_features_ {0};
+  /*! \brief generation used_features_ was built at, ~0 when never built */
+  mutable uint64_t used_features_generation_ {~uint64_t{0}};
+  /*! \brief bumped on every change to the trees, see Generation */
+  uint64_t generation_ { 0 };
+  /*! \brief generation of the last non-append change, see BaseGeneration */
+  uint64_t base_generation_ { 0 };
 };
 }  // namespace gbm
 }  // namespace xgboost
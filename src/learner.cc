@@ -11,12 +11,19 @@
 #include <atomic>
 #include <mutex>
 #include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
 #include <iomanip>
 #include <limits>
 #include <memory>
+#include <random>
+#include <shared_mutex>
 #include <sstream>
 #include <string>
 #include <stack>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -35,9 +42,11 @@
 #include "xgboost/metric.h"
 #include "xgboost/objective.h"
 #include "xgboost/parameter.h"
+#include "xgboost/tree_model.h"
 
 #include "common/common.h"
 #include "common/io.h"
+#include "common/memory_stats.h"
 #include "common/observer.h"
 #include "common/random.h"
 #include "common/timer.h"
@@ -171,6 +180,18 @@ struct LearnerTrainParam : public XGBoostParameter<LearnerTrainParam> {
   DataSplitMode dsplit {DataSplitMode::kAuto};
   // flag to disable default metric
   bool disable_default_eval_metric {false};
+  // whether the training metric may be taken from the fused gradient pass
+  bool fused_eval_metric {false};
+  // rounds of metric history inspected by the built-in early stopping engine
+  int early_stopping_rounds {0};
+  // relative per-round slope below which the metric counts as plateaued
+  float early_stopping_slope_tol {1e-4f};
+  // score evaluation sets on a background thread, one round behind
+  bool eval_async {false};
+  // fraction of evaluation rows scored on interim rounds
+  float eval_subsample {1.0f};
+  // every Nth round evaluates the full set when subsampling
+  int eval_full_period {10};
   // FIXME(trivialfis): The following parameters belong to model itself, but can be
   // specified by users.  Move them to model parameter once we can get rid of binary IO.
   std::string booster;
@@ -187,6 +208,41 @@ struct LearnerTrainParam : public XGBoostParameter<LearnerTrainParam> {
     DMLC_DECLARE_FIELD(disable_default_eval_metric)
         .set_default(false)
         .describe("Flag to disable default metric. Set to >0 to disable");
+    DMLC_DECLARE_FIELD(fused_eval_metric)
+        .set_default(false)
+        .describe("Accumulate the objective's default metric on the training data "
+                  "during the gradient pass and reuse it in evaluation, saving a "
+                  "full traversal of the predictions.  The reported training metric "
+                  "then reflects the model before the round's new trees.");
+    DMLC_DECLARE_FIELD(early_stopping_rounds)
+        .set_default(0)
+        .set_lower_bound(0)
+        .describe("Stop training when the slope of the last evaluation metric over "
+                  "this many rounds indicates a plateau.  0 disables the built-in "
+                  "early stopping engine.");
+    DMLC_DECLARE_FIELD(early_stopping_slope_tol)
+        .set_default(1e-4f)
+        .set_lower_bound(0.0f)
+        .describe("Relative per-round improvement below which the metric is "
+                  "considered plateaued.");
+    DMLC_DECLARE_FIELD(eval_async)
+        .set_default(false)
+        .describe("Score the evaluation sets on a background thread over a "
+                  "snapshot of the committed trees while the next round trains. "
+                  "Each call returns the previous round's result and early "
+                  "stopping consumes it one round late.  Ignored in distributed "
+                  "training; parameters should not change between rounds while "
+                  "an evaluation is in flight.");
+    DMLC_DECLARE_FIELD(eval_subsample)
+        .set_default(1.0f)
+        .set_range(0.0f, 1.0f)
+        .describe("Fraction of evaluation rows scored on interim rounds.  The "
+                  "subsample is drawn once and reused, and every eval_full_period-th "
+                  "round still evaluates the full set.");
+    DMLC_DECLARE_FIELD(eval_full_period)
+        .set_default(10)
+        .set_lower_bound(1)
+        .describe("Period of full evaluations when eval_subsample is below 1.");
     DMLC_DECLARE_FIELD(booster)
         .set_default("gbtree")
         .describe("Gradient booster used for training.");
@@ -252,6 +308,12 @@ class LearnerConfiguration : public Learner {
 
  protected:
   std::atomic<bool> need_configuration_;
+  // set by FreezeForPrediction: configuration is final and batch prediction
+  // must not touch shared state
+  bool frozen_ {false};
+  // Readers-writer lock between batch prediction and SwapModel: predictions
+  // hold it shared, a swap holds it exclusive while publishing the new model.
+  mutable std::shared_timed_mutex swap_lock_;
   std::map<std::string, std::string> cfg_;
   // Stores information like best-iteration for early stopping.
   std::map<std::string, std::string> attributes_;
@@ -260,6 +322,13 @@ class LearnerConfiguration : public Learner {
   LearnerModelParam learner_model_param_;
   LearnerTrainParam tparam_;
   std::vector<std::string> metric_names_;
+  // Hash of each configured metric name, rebuilt lazily in EvalOneIter so
+  // matching a metric against the objective default avoids string compares.
+  std::vector<size_t> metric_name_hashes_;
+  // Hash of the argument list the metrics were last configured with; when a
+  // reconfigure carries the same arguments and no new metric names, the
+  // existing instances are kept as they are.
+  size_t metric_cfg_hash_ { 0 };
 
  public:
   explicit LearnerConfiguration(std::vector<std::shared_ptr<DMatrix> > cache)
@@ -279,8 +348,11 @@ class LearnerConfiguration : public Learner {
 
   // Configuration before data is known.
   void Configure() override {
-    // Varient of double checked lock
-    if (!this->need_configuration_) { return; }
+    // Varient of double checked lock.  Once the configuration is sealed, the
+    // acquire load below is the only cost on the training and prediction hot
+    // paths; it pairs with the release store at the end of configuration, so
+    // a thread observing `false` also observes the configured state.
+    if (!this->need_configuration_.load(std::memory_order_acquire)) { return; }
     std::lock_guard<std::mutex> guard(config_lock_);
     if (!this->need_configuration_) { return; }
 
@@ -339,7 +411,7 @@ class LearnerConfiguration : public Learner {
 
     this->ConfigureMetrics(args);
 
-    this->need_configuration_ = false;
+    this->need_configuration_.store(false, std::memory_order_release);
     if (generic_parameters_.validate_parameters) {
       this->ValidateParameters();
     }
@@ -377,12 +449,25 @@ class LearnerConfiguration : public Learner {
     auto const& j_metrics = learner_parameters.at("metrics");
     auto n_metrics = get<Array const>(j_metrics).size();
     metric_names_.resize(n_metrics);
-    metrics_.resize(n_metrics);
+    std::vector<std::unique_ptr<Metric>> metrics(n_metrics);
     for (size_t i = 0; i < n_metrics; ++i) {
       metric_names_[i]= get<String>(j_metrics[i]);
-      metrics_[i] = std::unique_ptr<Metric>(
-          Metric::Create(metric_names_[i], &generic_parameters_));
+      // reuse an existing instance when the name matches, reloading a config
+      // with the same metrics should not recreate them
+      auto it = std::find_if(metrics_.begin(), metrics_.end(),
+                             [&](std::unique_ptr<Metric> const& m) {
+                               return m && m->Name() == metric_names_[i];
+                             });
+      if (it != metrics_.end()) {
+        metrics[i] = std::move(*it);
+      } else {
+        metrics[i] = std::unique_ptr<Metric>(
+            Metric::Create(metric_names_[i], &generic_parameters_));
+      }
     }
+    metrics_ = std::move(metrics);
+    metric_name_hashes_.clear();
+    metric_cfg_hash_ = 0;
 
     FromJson(learner_parameters.at("generic_param"), &generic_parameters_);
     // make sure the GPU ID is valid in new environment before start running configure.
@@ -419,16 +504,46 @@ class LearnerConfiguration : public Learner {
   }
 
   void SetParam(const std::string& key, const std::string& value) override {
-    this->need_configuration_ = true;
+    CHECK(!frozen_) << "The booster is frozen for prediction; "
+                    << "parameters can no longer be changed.";
     if (key == kEvalMetric) {
       if (std::find(metric_names_.cbegin(), metric_names_.cend(),
                     value) == metric_names_.cend()) {
         metric_names_.emplace_back(value);
+        this->need_configuration_ = true;
       }
     } else {
+      auto it = cfg_.find(key);
+      if (it != cfg_.cend() && it->second == value) {
+        // Re-setting a parameter to its current value keeps the sealed
+        // configuration valid, so callers that push the same parameters every
+        // iteration do not force a full reconfiguration.
+        return;
+      }
       cfg_[key] = value;
+      this->need_configuration_ = true;
     }
   }
+
+  bool SetParamFloat(const std::string& key, float value) override {
+    CHECK(!frozen_) << "The booster is frozen for prediction; "
+                    << "parameters can no longer be changed.";
+    // The fast path patches an already configured booster in place, so it is
+    // only valid while the configuration is sealed.
+    if (this->need_configuration_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    std::lock_guard<std::mutex> guard(config_lock_);
+    if (!gbm_ || !gbm_->SetParamFloat(key, value)) {
+      return false;
+    }
+    // Mirror the value into the string configuration so that saving the
+    // configuration or a later full reconfiguration sees it.
+    std::ostringstream os;
+    os << std::setprecision(std::numeric_limits<float>::max_digits10) << value;
+    cfg_[key] = os.str();
+    return true;
+  }
   // Short hand for setting multiple parameters
   void SetParams(std::vector<std::pair<std::string, std::string>> const& args) override {
     for (auto const& kv : args) {
@@ -611,6 +726,7 @@ class LearnerConfiguration : public Learner {
   }
 
   void ConfigureMetrics(Args const& args) {
+    bool changed = false;
     for (auto const& name : metric_names_) {
       auto DupCheck = [&name](std::unique_ptr<Metric> const& m) {
                         return m->Name() != name;
@@ -618,16 +734,362 @@ class LearnerConfiguration : public Learner {
       if (std::all_of(metrics_.begin(), metrics_.end(), DupCheck)) {
         metrics_.emplace_back(std::unique_ptr<Metric>(Metric::Create(name, &generic_parameters_)));
         mparam_.contain_eval_metrics = 1;
+        changed = true;
       }
     }
+    // Per-iteration parameter updates trigger a full reconfigure; skip the
+    // metric pass when the arguments the metrics care about did not change.
+    size_t cfg_hash = 0;
+    std::hash<std::string> hasher;
+    for (auto const& kv : args) {
+      cfg_hash ^= hasher(kv.first) + 0x9e3779b9 + (cfg_hash << 6) + (cfg_hash >> 2);
+      cfg_hash ^= hasher(kv.second) + 0x9e3779b9 + (cfg_hash << 6) + (cfg_hash >> 2);
+    }
+    if (!changed && cfg_hash == metric_cfg_hash_) {
+      return;
+    }
+    metric_name_hashes_.clear();
     for (auto& p_metric : metrics_) {
       p_metric->Configure(args);
     }
+    metric_cfg_hash_ = cfg_hash;
   }
 };
 
 std::string const LearnerConfiguration::kEvalMetric {"eval_metric"};  // NOLINT
 
+namespace {
+// Raw-text helpers for the direct JSON model reader: they scan the document
+// written by SaveModel without materializing a Json tree.
+char const* SkipJsonWs(char const* p, char const* end) {
+  while (p != end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+    ++p;
+  }
+  return p;
+}
+
+// At the opening quote; returns one past the closing quote.
+char const* SkipJsonString(char const* p, char const* end) {
+  ++p;
+  while (p < end && *p != '"') {
+    p += *p == '\\' ? 2 : 1;
+  }
+  return p < end ? p + 1 : nullptr;
+}
+
+// Advance past the value starting at `p`, bracket matched and string aware.
+char const* SkipJsonValue(char const* p, char const* end) {
+  if (p == end) {
+    return nullptr;
+  }
+  if (*p == '"') {
+    return SkipJsonString(p, end);
+  }
+  if (*p == '{' || *p == '[') {
+    int32_t depth = 0;
+    while (p != end) {
+      if (*p == '"') {
+        p = SkipJsonString(p, end);
+        if (p == nullptr) {
+          return nullptr;
+        }
+        continue;
+      }
+      if (*p == '{' || *p == '[') {
+        ++depth;
+      } else if (*p == '}' || *p == ']') {
+        if (--depth == 0) {
+          return p + 1;
+        }
+      }
+      ++p;
+    }
+    return nullptr;
+  }
+  // number, boolean or null
+  while (p != end && *p != ',' && *p != '}' && *p != ']' && *p != ' ' &&
+         *p != '\t' && *p != '\n' && *p != '\r') {
+    ++p;
+  }
+  return p;
+}
+
+// Value of `key` in the object starting at `p`; nullptr when missing.
+char const* FindJsonKey(char const* p, char const* end, char const* key) {
+  p = SkipJsonWs(p, end);
+  if (p == end || *p != '{') {
+    return nullptr;
+  }
+  p = SkipJsonWs(p + 1, end);
+  size_t const key_len = std::strlen(key);
+  while (p != end && *p != '}') {
+    if (*p != '"') {
+      return nullptr;
+    }
+    char const* kbegin = p + 1;
+    char const* kend = SkipJsonString(p, end);
+    if (kend == nullptr) {
+      return nullptr;
+    }
+    bool const match = static_cast<size_t>(kend - 1 - kbegin) == key_len &&
+                       std::equal(kbegin, kend - 1, key);
+    p = SkipJsonWs(kend, end);
+    if (p == end || *p != ':') {
+      return nullptr;
+    }
+    p = SkipJsonWs(p + 1, end);
+    if (match) {
+      return p;
+    }
+    p = SkipJsonValue(p, end);
+    if (p == nullptr) {
+      return nullptr;
+    }
+    p = SkipJsonWs(p, end);
+    if (p != end && *p == ',') {
+      p = SkipJsonWs(p + 1, end);
+    }
+  }
+  return nullptr;
+}
+
+char const* ParseF32Array(char const* p, char const* end,
+                          std::vector<float>* out) {
+  if (p == end || *p != '[') {
+    return nullptr;
+  }
+  p = SkipJsonWs(p + 1, end);
+  while (p != end && *p != ']') {
+    char* next = nullptr;
+    float const v = std::strtof(p, &next);
+    if (next == p) {
+      return nullptr;
+    }
+    out->push_back(v);
+    p = SkipJsonWs(next, end);
+    if (p != end && *p == ',') {
+      p = SkipJsonWs(p + 1, end);
+    }
+  }
+  return p != end ? p + 1 : nullptr;
+}
+
+char const* ParseI64Array(char const* p, char const* end,
+                          std::vector<int64_t>* out) {
+  if (p == end || *p != '[') {
+    return nullptr;
+  }
+  p = SkipJsonWs(p + 1, end);
+  while (p != end && *p != ']') {
+    char* next = nullptr;
+    int64_t const v = std::strtoll(p, &next, 10);
+    if (next == p) {
+      return nullptr;
+    }
+    out->push_back(v);
+    p = SkipJsonWs(next, end);
+    if (p != end && *p == ',') {
+      p = SkipJsonWs(p + 1, end);
+    }
+  }
+  return p != end ? p + 1 : nullptr;
+}
+
+char const* ParseBoolArray(char const* p, char const* end,
+                           std::vector<uint8_t>* out) {
+  if (p == end || *p != '[') {
+    return nullptr;
+  }
+  p = SkipJsonWs(p + 1, end);
+  while (p != end && *p != ']') {
+    if (end - p >= 4 && std::equal(p, p + 4, "true")) {
+      out->push_back(1);
+      p += 4;
+    } else if (end - p >= 5 && std::equal(p, p + 5, "false")) {
+      out->push_back(0);
+      p += 5;
+    } else {
+      return nullptr;
+    }
+    p = SkipJsonWs(p, end);
+    if (p != end && *p == ',') {
+      p = SkipJsonWs(p + 1, end);
+    }
+  }
+  return p != end ? p + 1 : nullptr;
+}
+
+// Parse one tree object written by RegTree::SaveModel straight into a
+// RegTree.  Returns one past the closing brace, or nullptr when the text
+// does not match the known schema, in which case the caller falls back to
+// the document reader.  Trees with categorical splits take the fallback.
+char const* ParseTreeFromText(char const* p, char const* end,
+                              std::shared_ptr<RegTree>* out_tree,
+                              int64_t* out_id) {
+  p = SkipJsonWs(p, end);
+  if (p == end || *p != '{') {
+    return nullptr;
+  }
+  p = SkipJsonWs(p + 1, end);
+  std::vector<float> loss_changes, sum_hessian, base_weights, conds;
+  std::vector<int64_t> lefts, rights, parents, indices, split_type;
+  std::vector<int64_t> cat_nodes, cat_segments, cat_sizes, cats;
+  std::vector<uint8_t> default_left;
+  Args args;
+  *out_id = -1;
+  while (p != end && *p != '}') {
+    if (*p != '"') {
+      return nullptr;
+    }
+    char const* kbegin = p + 1;
+    char const* kend = SkipJsonString(p, end);
+    if (kend == nullptr) {
+      return nullptr;
+    }
+    std::string const key{kbegin, kend - 1};
+    p = SkipJsonWs(kend, end);
+    if (p == end || *p != ':') {
+      return nullptr;
+    }
+    p = SkipJsonWs(p + 1, end);
+    if (key == "tree_param") {
+      // flat object of string parameters
+      if (p == end || *p != '{') {
+        return nullptr;
+      }
+      p = SkipJsonWs(p + 1, end);
+      while (p != end && *p != '}') {
+        if (*p != '"') {
+          return nullptr;
+        }
+        char const* nbegin = p + 1;
+        char const* nend = SkipJsonString(p, end);
+        if (nend == nullptr) {
+          return nullptr;
+        }
+        p = SkipJsonWs(nend, end);
+        if (p == end || *p != ':') {
+          return nullptr;
+        }
+        p = SkipJsonWs(p + 1, end);
+        if (p == end || *p != '"') {
+          return nullptr;
+        }
+        char const* vbegin = p + 1;
+        char const* vend = SkipJsonString(p, end);
+        if (vend == nullptr) {
+          return nullptr;
+        }
+        args.emplace_back(std::string{nbegin, nend - 1},
+                          std::string{vbegin, vend - 1});
+        p = SkipJsonWs(vend, end);
+        if (p != end && *p == ',') {
+          p = SkipJsonWs(p + 1, end);
+        }
+      }
+      if (p == end) {
+        return nullptr;
+      }
+      ++p;
+    } else if (key == "id") {
+      char* next = nullptr;
+      *out_id = std::strtoll(p, &next, 10);
+      if (next == p) {
+        return nullptr;
+      }
+      p = next;
+    } else if (key == "loss_changes") {
+      p = ParseF32Array(p, end, &loss_changes);
+    } else if (key == "sum_hessian") {
+      p = ParseF32Array(p, end, &sum_hessian);
+    } else if (key == "base_weights") {
+      p = ParseF32Array(p, end, &base_weights);
+    } else if (key == "split_conditions") {
+      p = ParseF32Array(p, end, &conds);
+    } else if (key == "left_children") {
+      p = ParseI64Array(p, end, &lefts);
+    } else if (key == "right_children") {
+      p = ParseI64Array(p, end, &rights);
+    } else if (key == "parents") {
+      p = ParseI64Array(p, end, &parents);
+    } else if (key == "split_indices") {
+      p = ParseI64Array(p, end, &indices);
+    } else if (key == "split_type") {
+      p = ParseI64Array(p, end, &split_type);
+    } else if (key == "categories_nodes") {
+      p = ParseI64Array(p, end, &cat_nodes);
+    } else if (key == "categories_segments") {
+      p = ParseI64Array(p, end, &cat_segments);
+    } else if (key == "categories_sizes") {
+      p = ParseI64Array(p, end, &cat_sizes);
+    } else if (key == "categories") {
+      p = ParseI64Array(p, end, &cats);
+    } else if (key == "default_left") {
+      p = ParseBoolArray(p, end, &default_left);
+    } else {
+      return nullptr;
+    }
+    if (p == nullptr) {
+      return nullptr;
+    }
+    p = SkipJsonWs(p, end);
+    if (p != end && *p == ',') {
+      p = SkipJsonWs(p + 1, end);
+    }
+  }
+  if (p == end) {
+    return nullptr;
+  }
+  ++p;
+  if (!cat_nodes.empty() || !cats.empty()) {
+    return nullptr;
+  }
+  for (auto t : split_type) {
+    if (t != static_cast<int64_t>(FeatureType::kNumerical)) {
+      return nullptr;
+    }
+  }
+
+  TreeParam tree_param;
+  tree_param.UpdateAllowUnknown(args);
+  auto const n_nodes = static_cast<size_t>(tree_param.num_nodes);
+  if (n_nodes == 0 || *out_id < 0 || loss_changes.size() != n_nodes ||
+      sum_hessian.size() != n_nodes || base_weights.size() != n_nodes ||
+      conds.size() != n_nodes || lefts.size() != n_nodes ||
+      rights.size() != n_nodes || parents.size() != n_nodes ||
+      indices.size() != n_nodes || default_left.size() != n_nodes) {
+    return nullptr;
+  }
+  std::vector<RegTree::Node> nodes(n_nodes);
+  std::vector<RTreeNodeStat> stats(n_nodes);
+  for (size_t i = 0; i < n_nodes; ++i) {
+    auto& s = stats[i];
+    s.loss_chg = loss_changes[i];
+    s.sum_hess = sum_hessian[i];
+    s.base_weight = base_weights[i];
+    s.leaf_child_cnt = 0;
+    nodes[i] = RegTree::Node{static_cast<bst_node_t>(lefts[i]),
+                             static_cast<bst_node_t>(rights[i]),
+                             static_cast<bst_node_t>(parents[i]),
+                             static_cast<bst_feature_t>(indices[i]),
+                             conds[i],
+                             default_left[i] != 0};
+  }
+  // the serialized parent link does not carry the left-child bit
+  for (size_t i = 1; i < n_nodes; ++i) {
+    auto const parent = nodes[i].Parent();
+    if (parent < 0 || static_cast<size_t>(parent) >= n_nodes) {
+      return nullptr;
+    }
+    nodes[i].SetParent(parent,
+                       nodes[parent].LeftChild() == static_cast<bst_node_t>(i));
+  }
+  out_tree->reset(new RegTree());
+  (*out_tree)->LoadNodes(tree_param, std::move(nodes), std::move(stats));
+  return p;
+}
+}  // anonymous namespace
+
 class LearnerIO : public LearnerConfiguration {
  private:
   std::set<std::string> saved_configs_ = {"num_round"};
@@ -635,11 +1097,25 @@ class LearnerIO : public LearnerConfiguration {
   // `enable_experimental_json_serialization' is set to false.  Will be removed once JSON
   // takes over.
   std::string const serialisation_header_ { u8"CONFIG-offset:" };
+  // in-flight background model save, at most one at a time
+  std::thread save_thread_;
+  std::string save_error_;
+  // state of the active SaveCheckpointAsync chain, see LoadCheckpoint
+  std::string checkpoint_fname_;
+  size_t checkpoint_trees_done_ {0};
+  uint64_t checkpoint_base_generation_ {0};
+  int32_t checkpoint_seq_ {0};
 
  public:
   explicit LearnerIO(std::vector<std::shared_ptr<DMatrix> > cache) :
       LearnerConfiguration{cache} {}
 
+  ~LearnerIO() override {
+    if (save_thread_.joinable()) {
+      save_thread_.join();
+    }
+  }
+
   void LoadModel(Json const& in) override {
     CHECK(IsA<Object>(in));
     Version::Load(in);
@@ -692,6 +1168,115 @@ class LearnerIO : public LearnerConfiguration {
       learner["attributes"][kv.first] = String(kv.second);
     }
   }
+  // Direct single-pass reader for the JSON model format.  The tree arrays
+  // are virtually all of the document; parse them straight into RegTree
+  // objects without materializing the intermediate Json tree, splice them
+  // out of the text and hand the small remainder to the generic reader.
+  // Returns false when the document does not match the known gbtree schema,
+  // leaving the learner untouched so the caller can take the generic path;
+  // set XGBOOST_DIRECT_JSON_READER=0 to force the generic reader.
+  bool LoadModelDirect(std::string const& buffer) {
+    if (dmlc::GetEnv("XGBOOST_DIRECT_JSON_READER", 1) == 0) {
+      return false;
+    }
+    char const* begin = buffer.c_str();
+    char const* end = begin + buffer.size();
+    char const* learner = FindJsonKey(SkipJsonWs(begin, end), end, "learner");
+    if (learner == nullptr) {
+      return false;
+    }
+    auto booster = FindJsonKey(learner, end, "gradient_booster");
+    if (booster == nullptr) {
+      return false;
+    }
+    auto model = FindJsonKey(booster, end, "model");
+    if (model == nullptr) {
+      return false;
+    }
+    auto model_param = FindJsonKey(model, end, "gbtree_model_param");
+    if (model_param == nullptr) {
+      return false;
+    }
+    auto num_trees_v = FindJsonKey(model_param, end, "num_trees");
+    auto trees_v = FindJsonKey(model, end, "trees");
+    auto tree_info_v = FindJsonKey(model, end, "tree_info");
+    if (num_trees_v == nullptr || trees_v == nullptr ||
+        tree_info_v == nullptr || *num_trees_v != '"' || *trees_v != '[' ||
+        *tree_info_v != '[') {
+      return false;
+    }
+    auto num_trees_end = SkipJsonValue(num_trees_v, end);
+    auto trees_end = SkipJsonValue(trees_v, end);
+    auto tree_info_end = SkipJsonValue(tree_info_v, end);
+    if (num_trees_end == nullptr || trees_end == nullptr ||
+        tree_info_end == nullptr) {
+      return false;
+    }
+    int64_t const n_trees = std::strtoll(num_trees_v + 1, nullptr, 10);
+    if (n_trees < 0) {
+      return false;
+    }
+
+    std::vector<std::shared_ptr<RegTree>> trees(static_cast<size_t>(n_trees));
+    char const* p = SkipJsonWs(trees_v + 1, trees_end);
+    size_t parsed = 0;
+    while (p < trees_end && *p != ']') {
+      std::shared_ptr<RegTree> tree;
+      int64_t id = -1;
+      p = ParseTreeFromText(p, trees_end, &tree, &id);
+      if (p == nullptr) {
+        return false;
+      }
+      if (id < 0 || id >= n_trees || trees[id]) {
+        return false;
+      }
+      trees[static_cast<size_t>(id)] = std::move(tree);
+      ++parsed;
+      p = SkipJsonWs(p, trees_end);
+      if (p < trees_end && *p == ',') {
+        p = SkipJsonWs(p + 1, trees_end);
+      }
+    }
+    if (parsed != static_cast<size_t>(n_trees)) {
+      return false;
+    }
+    std::vector<int64_t> info64;
+    if (ParseI64Array(tree_info_v, tree_info_end, &info64) == nullptr ||
+        info64.size() != static_cast<size_t>(n_trees)) {
+      return false;
+    }
+    std::vector<int> tree_info(info64.cbegin(), info64.cend());
+
+    // Splice the parsed sections out of the text; what remains of the
+    // document is small enough for the generic reader.
+    struct Splice {
+      char const* begin;
+      char const* end;
+      char const* text;
+    } splices[] = {{num_trees_v, num_trees_end, "\"0\""},
+                   {trees_v, trees_end, "[]"},
+                   {tree_info_v, tree_info_end, "[]"}};
+    std::sort(std::begin(splices), std::end(splices),
+              [](Splice const& a, Splice const& b) { return a.begin < b.begin; });
+    std::string reduced;
+    reduced.reserve(buffer.size() -
+                    static_cast<size_t>(trees_end - trees_v));
+    char const* cursor = begin;
+    for (auto const& s : splices) {
+      if (s.begin < cursor) {
+        return false;
+      }
+      reduced.append(cursor, s.begin);
+      reduced.append(s.text);
+      cursor = s.end;
+    }
+    reduced.append(cursor, end);
+
+    auto model_json = Json::Load({reduced.c_str(), reduced.size()});
+    this->LoadModel(model_json);
+    return gbm_->InstallTrees(std::move(trees), std::move(tree_info));
+  }
+
   // About to be deprecated by JSON format
   void LoadModel(dmlc::Stream* fi) override {
     generic_parameters_.UpdateAllowUnknown(Args{});
@@ -715,6 +1300,9 @@ class LearnerIO : public LearnerConfiguration {
       auto json_stream = common::FixedSizeStream(&fp);
       std::string buffer;
       json_stream.Take(&buffer);
+      if (this->LoadModelDirect(buffer)) {
+        return;
+      }
       auto model = Json::Load({buffer.c_str(), buffer.size()});
       this->LoadModel(model);
       return;
@@ -815,12 +1403,101 @@ class LearnerIO : public LearnerConfiguration {
     this->need_configuration_ = true;
   }
 
+  void SwapModel(dmlc::Stream* fi) override {
+    this->Configure();
+    CHECK(gbm_) << "A model must be trained or loaded before it can be swapped.";
+    common::PeekableInStream fp(fi);
+
+    std::string header;
+    header.resize(4);
+    bool is_json = false;
+    if (fp.PeekRead(&header[0], 4) == 4) {
+      CHECK_NE(header, "bs64")
+          << "Base64 format is no longer supported in brick.";
+      if (header == "binf") {
+        CHECK_EQ(fp.Read(&header[0], 4), 4U);
+      }
+      is_json = header[0] == '{';
+    }
+    if (!is_json) {
+      // The old binary format parses straight into the learner's members, so
+      // there is nothing to stage: load it under the exclusive lock.  The
+      // swap is still snapshot consistent, but predictions are drained for
+      // the duration of the parse.
+      std::unique_lock<std::shared_timed_mutex> lock(swap_lock_);
+      this->LoadModel(&fp);
+      this->Configure();
+      return;
+    }
+
+    auto json_stream = common::FixedSizeStream(&fp);
+    std::string buffer;
+    json_stream.Take(&buffer);
+    auto in = Json::Load({buffer.c_str(), buffer.size()});
+    CHECK(IsA<Object>(in));
+    Version::Load(in);
+    auto const& learner = get<Object>(in["learner"]);
+
+    // Stage the replacement off the lock, bound to this learner's parameters,
+    // so predictions keep flowing against the old trees while the new ones
+    // are built.
+    LearnerModelParamLegacy mparam;
+    mparam.FromJson(learner.at("learner_model_param"));
+
+    auto const& objective_fn = learner.at("objective");
+    std::string obj_name = get<String>(objective_fn["name"]);
+    std::unique_ptr<ObjFunction> obj{
+        ObjFunction::Create(obj_name, &generic_parameters_)};
+    obj->LoadConfig(objective_fn);
+
+    auto const& gradient_booster = learner.at("gradient_booster");
+    std::string gbm_name = get<String>(gradient_booster["name"]);
+    std::unique_ptr<GradientBooster> gbm{GradientBooster::Create(
+        gbm_name, &generic_parameters_, &learner_model_param_)};
+    gbm->LoadModel(gradient_booster);
+
+    std::map<std::string, std::string> attributes;
+    auto const& j_attributes = get<Object const>(learner.at("attributes"));
+    for (auto const& kv : j_attributes) {
+      attributes[kv.first] = get<String const>(kv.second);
+    }
+
+    {
+      // Publish: waits for in-flight predictions to drain, then swaps the
+      // model in as a whole.  Reconfiguration runs under the lock so readers
+      // never observe a half-configured learner.
+      std::unique_lock<std::shared_timed_mutex> lock(swap_lock_);
+      std::swap(mparam_, mparam);
+      tparam_.UpdateAllowUnknown(
+          Args{{"objective", obj_name}, {"booster", gbm_name}});
+      obj_.swap(obj);
+      gbm_.swap(gbm);
+      attributes_.swap(attributes);
+      // Configure skips this when base_score is unchanged, but the swapped
+      // model may differ in num_feature or num_class.
+      learner_model_param_ =
+          LearnerModelParam(mparam_, obj_->ProbToMargin(mparam_.base_score));
+      this->need_configuration_ = true;
+      this->Configure();
+    }
+    // The previous model's trees are released here, after the last reader of
+    // the old snapshot has drained, keeping peak memory bounded by the two
+    // models that briefly coexist.
+  }
+
   // Save model into binary format.  The code is about to be deprecated by more robust
   // JSON serialization format.  This function is uneffected by
   // `enable_experimental_json_serialization` as user might enable this flag for pickle
   // while still want a binary output.  As we are progressing at replacing the binary
   // format, there's no need to put too much effort on it.
-  void SaveModel(dmlc::Stream* fo) const override {
+  // Serialize everything around the booster: the bytes written before
+  // gbm_->Save go into *p_prefix and the trailing attribute block into
+  // *p_suffix.  Splitting the envelope off lets SaveModelAsync capture the
+  // learner-level state synchronously and write the booster on another
+  // thread.
+  void SaveModelEnvelope(std::string* p_prefix, std::string* p_suffix) const {
+    common::MemoryBufferStream prefix(p_prefix);
+    common::MemoryBufferStream suffix(p_suffix);
     LearnerModelParamLegacy mparam = mparam_;  // make a copy to potentially modify
     std::vector<std::pair<std::string, std::string> > extra_attr;
     mparam.contain_extra_attrs = 1;
@@ -853,26 +1530,138 @@ class LearnerIO : public LearnerConfiguration {
       extra_attr.emplace_back("metrics", os.str());
     }
     std::string header {"binf"};
-    fo->Write(header.data(), 4);
+    prefix.Write(header.data(), 4);
     if (DMLC_IO_NO_ENDIAN_SWAP) {
-      fo->Write(&mparam, sizeof(LearnerModelParamLegacy));
+      prefix.Write(&mparam, sizeof(LearnerModelParamLegacy));
     } else {
       LearnerModelParamLegacy x = mparam.ByteSwap();
-      fo->Write(&x, sizeof(LearnerModelParamLegacy));
+      prefix.Write(&x, sizeof(LearnerModelParamLegacy));
     }
-    fo->Write(tparam_.objective);
-    fo->Write(tparam_.booster);
-    gbm_->Save(fo);
+    prefix.Write(tparam_.objective);
+    prefix.Write(tparam_.booster);
     if (mparam.contain_extra_attrs != 0) {
       std::map<std::string, std::string> attr(attributes_);
       for (const auto& kv : extra_attr) {
         attr[kv.first] = kv.second;
       }
-      fo->Write(std::vector<std::pair<std::string, std::string>>(
+      suffix.Write(std::vector<std::pair<std::string, std::string>>(
           attr.begin(), attr.end()));
     }
   }
 
+  void SaveModel(dmlc::Stream* fo) const override {
+    std::string prefix, suffix;
+    this->SaveModelEnvelope(&prefix, &suffix);
+    fo->Write(prefix.data(), prefix.size());
+    gbm_->Save(fo);
+    fo->Write(suffix.data(), suffix.size());
+  }
+
+  void SaveModelAsync(std::string const& fname) override {
+    this->Configure();
+    this->WaitForModelSave();
+    std::string prefix, suffix;
+    this->SaveModelEnvelope(&prefix, &suffix);
+    // The snapshot shares the committed trees with the live model, so the
+    // serialization and the file write run off the training thread.
+    auto write_booster = gbm_->MakeSaveSnapshot();
+    save_thread_ = std::thread(
+        [this, fname, prefix = std::move(prefix), suffix = std::move(suffix),
+         write_booster = std::move(write_booster)]() {
+          try {
+            std::unique_ptr<dmlc::Stream> fo(
+                dmlc::Stream::Create(fname.c_str(), "w"));
+            fo->Write(prefix.data(), prefix.size());
+            write_booster(fo.get());
+            fo->Write(suffix.data(), suffix.size());
+          } catch (dmlc::Error const& e) {
+            save_error_ = e.what();
+          }
+        });
+  }
+
+  void WaitForModelSave() override {
+    if (save_thread_.joinable()) {
+      save_thread_.join();
+    }
+    if (!save_error_.empty()) {
+      std::string msg;
+      std::swap(msg, save_error_);
+      LOG(FATAL) << "Asynchronous model save failed: " << msg;
+    }
+  }
+
+  void SaveCheckpointAsync(std::string const& fname) override {
+    this->Configure();
+    this->WaitForModelSave();
+    if (fname == checkpoint_fname_) {
+      size_t trees_done = checkpoint_trees_done_;
+      uint64_t base_gen = checkpoint_base_generation_;
+      auto write_delta = gbm_->MakeDeltaSnapshot(&trees_done, &base_gen);
+      if (write_delta) {
+        if (trees_done == checkpoint_trees_done_) {
+          // nothing boosted since the last checkpoint
+          return;
+        }
+        std::string const delta_name =
+            fname + ".delta." + std::to_string(++checkpoint_seq_);
+        checkpoint_trees_done_ = trees_done;
+        checkpoint_base_generation_ = base_gen;
+        save_thread_ = std::thread(
+            [this, delta_name, write_delta = std::move(write_delta)]() {
+              try {
+                std::unique_ptr<dmlc::Stream> fo(
+                    dmlc::Stream::Create(delta_name.c_str(), "w"));
+                write_delta(fo.get());
+              } catch (dmlc::Error const& e) {
+                save_error_ = e.what();
+              }
+            });
+        return;
+      }
+    }
+    // Full base checkpoint starting a new chain; later deltas append where it
+    // ends.  Deltas of an older chain rooted at the same name are rejected on
+    // load through the tree count recorded in their header.
+    checkpoint_fname_ = fname;
+    checkpoint_seq_ = 0;
+    checkpoint_trees_done_ = 0;
+    checkpoint_base_generation_ = 0;
+    gbm_->MakeDeltaSnapshot(&checkpoint_trees_done_,
+                            &checkpoint_base_generation_);
+    this->SaveModelAsync(fname);
+  }
+
+  int32_t LoadCheckpoint(std::string const& fname) override {
+    this->WaitForModelSave();
+    std::unique_ptr<dmlc::Stream> fi(
+        dmlc::Stream::Create(fname.c_str(), "r", true));
+    if (!fi) {
+      return 0;
+    }
+    this->LoadModel(fi.get());
+    int32_t seq = 0;
+    for (;;) {
+      std::string const delta_name =
+          fname + ".delta." + std::to_string(seq + 1);
+      std::unique_ptr<dmlc::Stream> fd(
+          dmlc::Stream::Create(delta_name.c_str(), "r", true));
+      if (!fd || !gbm_->LoadDelta(fd.get())) {
+        break;
+      }
+      ++seq;
+    }
+    this->Configure();
+    // resume the chain, so the next save appends after the applied deltas
+    checkpoint_fname_ = fname;
+    checkpoint_seq_ = seq;
+    checkpoint_trees_done_ = 0;
+    checkpoint_base_generation_ = 0;
+    gbm_->MakeDeltaSnapshot(&checkpoint_trees_done_,
+                            &checkpoint_base_generation_);
+    return this->BoostedRounds();
+  }
+
   void Save(dmlc::Stream* fo) const override {
     Json memory_snapshot{Object()};
     memory_snapshot["Model"] = Object();
@@ -943,6 +1732,9 @@ class LearnerImpl : public LearnerIO {
   explicit LearnerImpl(std::vector<std::shared_ptr<DMatrix> > cache)
       : LearnerIO{cache} {}
   ~LearnerImpl() override {
+    if (eval_thread_.joinable()) {
+      eval_thread_.join();
+    }
     auto local_map = LearnerAPIThreadLocalStore::Get();
     if (local_map->find(this) != local_map->cend()) {
       local_map->erase(this);
@@ -987,6 +1779,7 @@ class LearnerImpl : public LearnerIO {
   }
 
   void UpdateOneIter(int iter, std::shared_ptr<DMatrix> train) override {
+    CHECK(!frozen_) << "The booster is frozen for prediction and cannot be trained.";
     monitor_.Start("UpdateOneIter");
     TrainingObserver::Instance().Update(iter);
     this->Configure();
@@ -1000,21 +1793,52 @@ class LearnerImpl : public LearnerIO {
     auto& predt = local_cache->Cache(train, generic_parameters_.gpu_id);
 
     monitor_.Start("PredictRaw");
-    this->PredictRaw(train.get(), &predt, true);
+    bool fused_gradient = false;
+    const bool want_fused_eval =
+        tparam_.fused_eval_metric && tparam_.dsplit != DataSplitMode::kRow;
+    if (!want_fused_eval &&
+        obj_->GetGradientRangeBegin(predt.predictions, train->Info(), &gpair_)) {
+      // Compute gradients block by block as the predictor finishes each row
+      // range, while the freshly updated predictions are still cache
+      // resident; this saves a separate full sweep over the predictions.
+      fused_gradient = gbm_->PredictBatchRanged(
+          train.get(), &predt, [&](std::size_t begin, std::size_t end) {
+            obj_->GetGradientRange(predt.predictions, train->Info(), iter,
+                                   begin, end, &gpair_);
+          });
+      if (fused_gradient) {
+        obj_->GetGradientRangeEnd();
+      }
+    }
+    if (!fused_gradient) {
+      this->PredictRaw(train.get(), &predt, true);
+    }
     TrainingObserver::Instance().Observe(predt.predictions, "Predictions");
     monitor_.Stop("PredictRaw");
 
     monitor_.Start("GetGradient");
-    obj_->GetGradient(predt.predictions, train->Info(), iter, &gpair_);
+    fused_eval_.valid = false;
+    if (want_fused_eval) {
+      // the fused value is only picked up by EvalOneIter when the objective
+      // managed to accumulate its metric in the same pass
+      fused_eval_.valid = obj_->GetGradientFusedEval(predt.predictions, train->Info(), iter,
+                                                     &gpair_, &fused_eval_.value);
+      fused_eval_.train = train.get();
+      fused_eval_.iter = iter;
+    } else if (!fused_gradient) {
+      obj_->GetGradient(predt.predictions, train->Info(), iter, &gpair_);
+    }
     monitor_.Stop("GetGradient");
     TrainingObserver::Instance().Observe(gpair_, "Gradients");
 
     gbm_->DoBoost(train.get(), &gpair_, &predt);
+    common::MemoryStats::Instance().Log();
     monitor_.Stop("UpdateOneIter");
   }
 
   void BoostOneIter(int iter, std::shared_ptr<DMatrix> train,
                     HostDeviceVector<GradientPair>* in_gpair) override {
+    CHECK(!frozen_) << "The booster is frozen for prediction and cannot be trained.";
     monitor_.Start("BoostOneIter");
     this->Configure();
     if (generic_parameters_.seed_per_iteration || rabit::IsDistributed()) {
@@ -1054,33 +1878,172 @@ class LearnerImpl : public LearnerIO {
       metrics_.back()->Configure({cfg_.begin(), cfg_.end()});
     }
 
+    if (tparam_.eval_async && !rabit::IsDistributed()) {
+      auto ret = this->EvalOneIterAsync(iter, data_sets, data_names);
+      monitor_.Stop("EvalOneIter");
+      return ret;
+    }
+
+    if (metric_name_hashes_.size() != metrics_.size()) {
+      metric_name_hashes_.resize(metrics_.size());
+      for (size_t j = 0; j < metrics_.size(); ++j) {
+        metric_name_hashes_[j] = std::hash<std::string>{}(metrics_[j]->Name());
+      }
+    }
+    const std::string default_metric = obj_->DefaultEvalMetric();
+    const size_t default_metric_hash = std::hash<std::string>{}(default_metric);
+    // A metric can reuse the fused training evaluation only when it is the
+    // objective's default metric; compare by hash first so the common
+    // mismatch is settled without touching the strings.
+    std::vector<bool> fused_metric(metrics_.size());
+    bool all_fused = true;
+    for (size_t j = 0; j < metrics_.size(); ++j) {
+      fused_metric[j] = metric_name_hashes_[j] == default_metric_hash &&
+                        metrics_[j]->Name() == default_metric;
+      all_fused = all_fused && fused_metric[j];
+    }
+
     auto local_cache = this->GetPredictionCache();
+    // On interim rounds a fixed random subsample of each evaluation set may be
+    // scored instead of the full set; every eval_full_period-th round stays a
+    // full evaluation so the early stopping history is anchored to exact values.
+    const bool full_eval = tparam_.eval_subsample >= 1.0f ||
+                           (iter + 1) % tparam_.eval_full_period == 0;
+    bst_float last_value = 0.0f;
     for (size_t i = 0; i < data_sets.size(); ++i) {
       std::shared_ptr<DMatrix> m = data_sets[i];
+      if (!full_eval) {
+        m = this->SubsampleForEval(m);
+      }
       auto &predt = local_cache->Cache(m, generic_parameters_.gpu_id);
       this->ValidateDMatrix(m.get(), false);
       this->PredictRaw(m.get(), &predt, false);
 
+      const bool fused_valid =
+          fused_eval_.valid && fused_eval_.train == m.get() && fused_eval_.iter == iter;
+      const bool fused_ok = fused_valid && all_fused;
       auto &out = output_predictions_.Cache(m, generic_parameters_.gpu_id).predictions;
-      out.Resize(predt.predictions.Size());
-      out.Copy(predt.predictions);
-
-      obj_->EvalTransform(&out);
-      for (auto& ev : metrics_) {
-        os << '\t' << data_names[i] << '-' << ev->Name() << ':'
-           << ev->Eval(out, m->Info(), tparam_.dsplit == DataSplitMode::kRow);
+      // External memory evaluation sets stream chunk-wise through the metrics
+      // when every metric supports it, so the transformed copy of the
+      // predictions never materializes in full.
+      bool streamed = false;
+      if (!fused_ok && !m->SingleColBlock() && !metrics_.empty()) {
+        streamed = true;
+        for (auto& ev : metrics_) {
+          streamed &= ev->EvalChunkBegin(m->Info());
+        }
+      }
+      if (streamed) {
+        auto const& h_preds = predt.predictions.ConstHostVector();
+        size_t const total = h_preds.size();
+        size_t constexpr kChunkRows = 1ul << 16;
+        HostDeviceVector<bst_float> chunk;
+        for (size_t begin = 0; begin < total; begin += kChunkRows) {
+          size_t const end = std::min(total, begin + kChunkRows);
+          chunk.Resize(end - begin);
+          auto& h_chunk = chunk.HostVector();
+          std::copy(h_preds.cbegin() + begin, h_preds.cbegin() + end,
+                    h_chunk.begin());
+          obj_->EvalTransform(&chunk);
+          for (auto& ev : metrics_) {
+            ev->EvalChunk(chunk, m->Info(), begin, end);
+          }
+        }
+      } else if (!fused_ok) {
+        out.Resize(predt.predictions.Size());
+        out.Copy(predt.predictions);
+        obj_->EvalTransform(&out);
+      }
+      for (size_t j = 0; j < metrics_.size(); ++j) {
+        auto& ev = metrics_[j];
+        bst_float value;
+        if (streamed) {
+          value = ev->EvalChunkEnd(tparam_.dsplit == DataSplitMode::kRow);
+        } else if (fused_valid && fused_metric[j]) {
+          value = fused_eval_.value;
+        } else {
+          value = ev->Eval(out, m->Info(), tparam_.dsplit == DataSplitMode::kRow);
+        }
+        os << '\t' << data_names[i] << '-' << ev->Name() << ':' << value;
+        last_value = value;
       }
     }
+    // Conventionally the last metric on the last evaluation set drives stopping.
+    if (tparam_.early_stopping_rounds > 0 && !data_sets.empty() && !metrics_.empty()) {
+      this->UpdateEarlyStop(iter, metrics_.back()->Name(), last_value);
+    }
 
     monitor_.Stop("EvalOneIter");
     return os.str();
   }
 
+  /*! \brief Kick evaluation of this round onto a background thread and return
+   *  the previous round's result.  The background task scores a private
+   *  booster materialized from a save snapshot, so it never touches the trees
+   *  the next round is appending to; the objective transform and the metrics
+   *  are stateless in their scoring paths.  The first call returns an empty
+   *  string. */
+  std::string EvalOneIterAsync(int iter,
+                               const std::vector<std::shared_ptr<DMatrix>>& data_sets,
+                               const std::vector<std::string>& data_names) {
+    // collect the previous round's outcome; the join orders the writes of the
+    // background task before the reads here
+    std::string previous;
+    if (eval_thread_.joinable()) {
+      eval_thread_.join();
+      previous = std::move(async_eval_result_);
+      if (tparam_.early_stopping_rounds > 0 && !metrics_.empty() &&
+          async_eval_iter_ >= 0) {
+        this->UpdateEarlyStop(async_eval_iter_, metrics_.back()->Name(),
+                              async_eval_last_value_);
+      }
+    }
+    for (auto const& m : data_sets) {
+      this->ValidateDMatrix(m.get(), false);
+    }
+    // the snapshot shares the committed trees with the live model; the copy is
+    // only materialized off the training thread
+    auto write_booster = gbm_->MakeSaveSnapshot();
+    eval_thread_ = std::thread(
+        [this, iter, data_sets, data_names,
+         write_booster = std::move(write_booster)]() {
+          std::string buffer;
+          common::MemoryBufferStream fs(&buffer);
+          write_booster(&fs);
+          fs.Seek(0);
+          std::unique_ptr<GradientBooster> snapshot{GradientBooster::Create(
+              tparam_.booster, &generic_parameters_, &learner_model_param_)};
+          snapshot->Load(&fs);
+
+          std::ostringstream os;
+          os << '[' << iter << ']' << std::setiosflags(std::ios::fixed);
+          bst_float last_value = 0.0f;
+          for (size_t i = 0; i < data_sets.size(); ++i) {
+            auto const& m = data_sets[i];
+            PredictionCacheEntry predt;
+            snapshot->PredictBatch(m.get(), &predt, false);
+            obj_->EvalTransform(&predt.predictions);
+            for (auto& ev : metrics_) {
+              auto value = ev->Eval(predt.predictions, m->Info(), false);
+              os << '\t' << data_names[i] << '-' << ev->Name() << ':' << value;
+              last_value = value;
+            }
+          }
+          async_eval_result_ = os.str();
+          async_eval_last_value_ = last_value;
+          async_eval_iter_ = iter;
+        });
+    return previous;
+  }
+
   void Predict(std::shared_ptr<DMatrix> data, bool output_margin,
                HostDeviceVector<bst_float>* out_preds, unsigned ntree_limit,
                bool training,
                bool pred_leaf, bool pred_contribs, bool approx_contribs,
                bool pred_interactions) override {
+    // Held shared for the whole prediction so a concurrent SwapModel cannot
+    // replace the model mid-batch: each call sees one complete snapshot.
+    std::shared_lock<std::shared_timed_mutex> swap_guard(swap_lock_);
     int multiple_predictions = static_cast<int>(pred_leaf) +
                                static_cast<int>(pred_interactions) +
                                static_cast<int>(pred_contribs);
@@ -1093,9 +2056,28 @@ class LearnerImpl : public LearnerIO {
                                             approx_contribs);
     } else if (pred_leaf) {
       gbm_->PredictLeaf(data.get(), out_preds, ntree_limit);
+    } else if (frozen_) {
+      // A frozen booster predicts into stack storage only: no entry of the
+      // shared prediction cache is created or updated, so any number of
+      // threads may run this path concurrently over one model.
+      PredictionCacheEntry prediction;
+      this->PredictRaw(data.get(), &prediction, training, ntree_limit);
+      out_preds->SetDevice(generic_parameters_.gpu_id);
+      out_preds->Resize(prediction.predictions.Size());
+      out_preds->Copy(prediction.predictions);
+      if (!output_margin) {
+        obj_->PredTransform(out_preds);
+      }
     } else {
       auto local_cache = this->GetPredictionCache();
-      auto& prediction = local_cache->Cache(data, generic_parameters_.gpu_id);
+      // A truncated prediction rolls the cache entry back to version 0 and
+      // re-predicts from the first tree; routed through the shared entry it
+      // would also force the next evaluation pass over this matrix to start
+      // from scratch.  Keep limited predictions in their own container so the
+      // entries used by UpdateOneIter/EvalOneIter stay incremental.
+      auto& prediction = ntree_limit == 0
+          ? local_cache->Cache(data, generic_parameters_.gpu_id)
+          : limited_predictions_.Cache(data, generic_parameters_.gpu_id);
       this->PredictRaw(data.get(), &prediction, training, ntree_limit);
       // Copy the prediction cache to output prediction. out_preds comes from C API
       out_preds->SetDevice(generic_parameters_.gpu_id);
@@ -1107,12 +2089,40 @@ class LearnerImpl : public LearnerIO {
     }
   }
 
+  bool PredictLeafInt32(std::shared_ptr<DMatrix> data, unsigned ntree_limit,
+                        common::Span<bst_node_t> out_indices) override {
+    std::shared_lock<std::shared_timed_mutex> swap_guard(swap_lock_);
+    this->Configure();
+    return gbm_->PredictLeafInt32(data.get(), out_indices, ntree_limit);
+  }
+
+  bool PredictLeafStats(std::shared_ptr<DMatrix> data, unsigned ntree_limit,
+                        std::vector<bst_float>* out_stats) override {
+    std::shared_lock<std::shared_timed_mutex> swap_guard(swap_lock_);
+    this->Configure();
+    return gbm_->PredictLeafStats(data.get(), out_stats, ntree_limit);
+  }
+
   int32_t BoostedRounds() const override {
     if (!this->gbm_) { return 0; }  // haven't call train or LoadModel.
     CHECK(!this->need_configuration_);
     return this->gbm_->BoostedRounds();
   }
 
+  bool ShouldStop() const override { return early_stop_; }
+
+  void FreezeForPrediction() override {
+    this->Configure();
+    CHECK(gbm_) << "A model must be trained or loaded before freezing.";
+    frozen_ = true;
+  }
+
+  void CompactForInference() override {
+    this->Configure();
+    CHECK(gbm_) << "A model must be trained or loaded before compacting.";
+    gbm_->CompactForInference();
+  }
+
   XGBAPIThreadLocalEntry& GetThreadLocal() const override {
     return (*LearnerAPIThreadLocalStore::Get())[this];
   }
@@ -1154,6 +2164,79 @@ class LearnerImpl : public LearnerIO {
     gbm_->PredictBatch(data, out_preds, training, ntree_limit);
   }
 
+  /*! \brief Fixed random row subsample of an evaluation set, drawn once and
+   *  cached so interim evaluations stay comparable across rounds. */
+  std::shared_ptr<DMatrix> SubsampleForEval(std::shared_ptr<DMatrix> m) {
+    if (!m->SingleColBlock()) {
+      // slicing is unsupported for external memory; evaluate the full set
+      return m;
+    }
+    auto it = eval_subsample_cache_.find(m.get());
+    if (it != eval_subsample_cache_.cend()) {
+      return it->second;
+    }
+    const size_t n_rows = m->Info().num_row_;
+    std::vector<int32_t> ridxs;
+    ridxs.reserve(static_cast<size_t>(n_rows * tparam_.eval_subsample) + 1);
+    std::mt19937 rng(generic_parameters_.seed);
+    std::bernoulli_distribution coin(tparam_.eval_subsample);
+    for (size_t ridx = 0; ridx < n_rows; ++ridx) {
+      if (coin(rng)) {
+        ridxs.push_back(static_cast<int32_t>(ridx));
+      }
+    }
+    if (ridxs.empty()) {
+      return m;
+    }
+    std::shared_ptr<DMatrix> sub{m->Slice(ridxs)};
+    eval_subsample_cache_.emplace(m.get(), sub);
+    return sub;
+  }
+
+  /*! \brief Record a metric value and flag a stop once the least-squares slope
+   *  over the last `early_stopping_rounds` values indicates a plateau. */
+  void UpdateEarlyStop(int iter, std::string const& name, bst_float value) {
+    // metrics where larger is better, mirroring the Python callback
+    const bool maximize = name.compare(0, 3, "auc") == 0 ||
+                          name.compare(0, 3, "map") == 0 ||
+                          name.compare(0, 4, "ndcg") == 0;
+    eval_history_.emplace_back(iter, maximize ? -static_cast<double>(value)
+                                              : static_cast<double>(value));
+    const size_t window = static_cast<size_t>(tparam_.early_stopping_rounds);
+    if (eval_history_.size() > window) {
+      eval_history_.erase(eval_history_.begin(), eval_history_.end() - window);
+    }
+    if (eval_history_.size() < window) {
+      return;
+    }
+    double mean_x = 0.0, mean_y = 0.0;
+    for (auto const& p : eval_history_) {
+      mean_x += p.first;
+      mean_y += p.second;
+    }
+    mean_x /= window;
+    mean_y /= window;
+    double cov = 0.0, var = 0.0;
+    for (auto const& p : eval_history_) {
+      cov += (p.first - mean_x) * (p.second - mean_y);
+      var += (p.first - mean_x) * (p.first - mean_x);
+    }
+    if (var == 0.0) {
+      return;
+    }
+    const double slope = cov / var;
+    const double scale = std::max(std::abs(mean_y), 1e-8);
+    // improvement drives the direction-normalized metric down; a slope this
+    // close to zero or rising is a plateau
+    if (slope > -static_cast<double>(tparam_.early_stopping_slope_tol) * scale) {
+      if (!early_stop_) {
+        LOG(INFO) << "Early stopping: " << name << " plateaued over the last "
+                  << window << " rounds.";
+      }
+      early_stop_ = true;
+    }
+  }
+
   void ValidateDMatrix(DMatrix* p_fmat, bool is_training) const {
     MetaInfo const& info = p_fmat->Info();
     info.Validate(generic_parameters_.gpu_id);
@@ -1184,9 +2267,32 @@ class LearnerImpl : public LearnerIO {
   static int32_t constexpr kRandSeedMagic = 127;
   // gradient pairs
   HostDeviceVector<GradientPair> gpair_;
+  // training metric accumulated by the fused gradient pass, consumed by
+  // EvalOneIter for the matching training matrix and iteration
+  struct FusedEvalResult {
+    DMatrix const* train { nullptr };
+    int iter { -1 };
+    bst_float value { 0.0f };
+    bool valid { false };
+  } fused_eval_;
   /*! \brief Temporary storage to prediction.  Useful for storing data transformed by
    *  objective function */
   PredictionContainer output_predictions_;
+  /*! \brief Cache for predictions with a user supplied ntree_limit, kept apart from
+   *  the incremental per-matrix entries so a limited prediction does not force the
+   *  next training or evaluation pass to re-predict from the first tree. */
+  PredictionContainer limited_predictions_;
+  // asynchronous evaluation: at most one task in flight; it fills the result
+  // fields and the join at the start of the next round orders the reads
+  std::thread eval_thread_;
+  std::string async_eval_result_;
+  bst_float async_eval_last_value_ { 0.0f };
+  int async_eval_iter_ { -1 };
+  // built-in early stopping: cached eval subsamples, direction-normalized
+  // metric history over the inspection window, and the plateau flag
+  std::map<DMatrix const*, std::shared_ptr<DMatrix>> eval_subsample_cache_;
+  std::vector<std::pair<int, double>> eval_history_;
+  bool early_stop_ { false };
 };
 
 constexpr int32_t LearnerImpl::kRandSeedMagic;
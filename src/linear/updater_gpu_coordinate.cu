@@ -3,6 +3,7 @@
  * \author Rory Mitchell
  */
 
+#include <thrust/copy.h>
 #include <thrust/execution_policy.h>
 #include <thrust/inner_product.h>
 #include <xgboost/data.h>
@@ -96,6 +97,37 @@ class GPUCoordinateUpdater : public LinearUpdater {  // NOLINT
           col.data() + seg.first,
           sizeof(Entry) * (seg.second - seg.first), cudaMemcpyHostToDevice));
     }
+
+    // Group features whose rows do not overlap.  The members of one group can
+    // be reduced in a single segmented reduction and their weight deltas
+    // applied in one launch without changing the result: simultaneous updates
+    // of row-disjoint features are exactly the sequential ones.  Grouping is
+    // greedy in feature order so cyclic selection order is preserved.
+    feature_batches_.clear();
+    std::vector<uint64_t> used((num_row_ + 63) / 64, 0);
+    std::vector<int> current;
+    for (size_t fidx = 0; fidx < batch.Size(); fidx++) {
+      auto col = batch[fidx];
+      auto seg = column_segments[fidx];
+      bool conflict = false;
+      for (auto i = seg.first; i < seg.second && !conflict; ++i) {
+        auto ridx = col.data()[i].index;
+        conflict = (used[ridx / 64] >> (ridx % 64)) & 1;
+      }
+      if (conflict) {
+        feature_batches_.push_back(std::move(current));
+        current.clear();
+        std::fill(used.begin(), used.end(), 0);
+      }
+      current.push_back(static_cast<int>(fidx));
+      for (auto i = seg.first; i < seg.second; ++i) {
+        auto ridx = col.data()[i].index;
+        used[ridx / 64] |= uint64_t{1} << (ridx % 64);
+      }
+    }
+    if (!current.empty()) {
+      feature_batches_.push_back(std::move(current));
+    }
   }
 
   void Update(HostDeviceVector<GradientPair> *in_gpair, DMatrix *p_fmat,
@@ -121,8 +153,21 @@ class GPUCoordinateUpdater : public LinearUpdater {  // NOLINT
                      tparam_.reg_alpha_denorm, tparam_.reg_lambda_denorm,
                      coord_param_.top_k);
     monitor_.Start("UpdateFeature");
+    // Cyclic selection visits the features in natural order, which is the
+    // order the conflict-free batches were formed in, so the batched rounds
+    // produce the same updates with a couple of launches per batch instead of
+    // per feature.  The other selectors pick features dynamically and keep
+    // the feature-by-feature path.
+    const bool batched = tparam_.feature_selector == kCyclic &&
+                         learner_param_->gpu_id >= 0 && !IsEmpty();
     for (auto group_idx = 0; group_idx < model->learner_model_param->num_output_group;
          ++group_idx) {
+      if (batched) {
+        for (const auto &fbatch : feature_batches_) {
+          this->UpdateFeatureBatch(fbatch, group_idx, model);
+        }
+        continue;
+      }
       for (auto i = 0U; i < model->learner_model_param->num_feature; i++) {
         auto fidx = selector_->NextFeature(
             i, *model, group_idx, in_gpair->ConstHostVector(), p_fmat,
@@ -174,6 +219,113 @@ class GPUCoordinateUpdater : public LinearUpdater {  // NOLINT
     }
   }
 
+  void UpdateFeatureBatch(const std::vector<int> &batch, int group_idx,
+                          gbm::GBLinearModel *model) {
+    const int num_group = model->learner_model_param->num_output_group;
+    auto grads = GetGradientBatch(batch, group_idx, num_group);
+    std::vector<float> dws(batch.size());
+    bool any_update = false;
+    for (size_t i = 0; i < batch.size(); ++i) {
+      bst_float &w = (*model)[batch[i]][group_idx];
+      auto dw = static_cast<float>(
+          tparam_.learning_rate *
+          CoordinateDelta(grads[i].GetGrad(), grads[i].GetHess(), w,
+                          tparam_.reg_alpha_denorm, tparam_.reg_lambda_denorm));
+      w += dw;
+      dws[i] = dw;
+      any_update |= dw != 0.0f;
+    }
+    if (any_update) {
+      UpdateResidualBatch(batch, dws, group_idx, num_group);
+    }
+  }
+
+  // This needs to be public because of the __device__ lambda.
+  std::vector<GradientPair> GetGradientBatch(const std::vector<int> &batch,
+                                             int group_idx, int num_group) {
+    dh::safe_cuda(cudaSetDevice(learner_param_->gpu_id));
+    const int n = static_cast<int>(batch.size());
+    std::vector<size_t> h_begin(n);
+    std::vector<size_t> h_end(n);
+    for (int i = 0; i < n; ++i) {
+      h_begin[i] = row_ptr_[batch[i]];
+      h_end[i] = row_ptr_[batch[i] + 1];
+    }
+    batch_begin_.resize(n);
+    batch_end_.resize(n);
+    thrust::copy(h_begin.cbegin(), h_begin.cend(), batch_begin_.begin());
+    thrust::copy(h_end.cbegin(), h_end.cend(), batch_end_.begin());
+
+    common::Span<Entry> d_data = dh::ToSpan(data_);
+    common::Span<GradientPair> d_gpair = dh::ToSpan(gpair_);
+    auto counting = thrust::make_counting_iterator(0ull);
+    auto f = [=] __device__(size_t idx) {
+      auto entry = d_data[idx];
+      auto g = d_gpair[entry.index * num_group + group_idx];
+      return GradientPair(g.GetGrad() * entry.fvalue,
+                          g.GetHess() * entry.fvalue * entry.fvalue);
+    };  // NOLINT
+    thrust::transform_iterator<decltype(f), decltype(counting), GradientPair>
+        multiply_iterator(counting, f);
+
+    dh::caching_device_vector<GradientPair> sums(n);
+    size_t tmp_bytes = 0;
+    dh::safe_cuda(cub::DeviceSegmentedReduce::Sum(
+        nullptr, tmp_bytes, multiply_iterator, sums.data().get(), n,
+        batch_begin_.data().get(), batch_end_.data().get()));
+    dh::TemporaryArray<char> tmp(tmp_bytes);
+    dh::safe_cuda(cub::DeviceSegmentedReduce::Sum(
+        tmp.data().get(), tmp_bytes, multiply_iterator, sums.data().get(), n,
+        batch_begin_.data().get(), batch_end_.data().get()));
+
+    std::vector<GradientPair> grads(n);
+    dh::safe_cuda(cudaMemcpy(grads.data(), sums.data().get(),
+                             n * sizeof(GradientPair), cudaMemcpyDeviceToHost));
+    return grads;
+  }
+
+  // This needs to be public because of the __device__ lambda.
+  void UpdateResidualBatch(const std::vector<int> &batch,
+                           const std::vector<float> &dws, int group_idx,
+                           int num_groups) {
+    const size_t n = batch.size();
+    std::vector<size_t> h_prefix(n);
+    size_t total = 0;
+    for (size_t i = 0; i < n; ++i) {
+      h_prefix[i] = total;
+      total += row_ptr_[batch[i] + 1] - row_ptr_[batch[i]];
+    }
+    if (total == 0) return;
+    batch_prefix_.resize(n);
+    batch_dw_.resize(n);
+    thrust::copy(h_prefix.cbegin(), h_prefix.cend(), batch_prefix_.begin());
+    thrust::copy(dws.cbegin(), dws.cend(), batch_dw_.begin());
+
+    common::Span<Entry> d_data = dh::ToSpan(data_);
+    common::Span<GradientPair> d_gpair = dh::ToSpan(gpair_);
+    // begin offsets uploaded by GetGradientBatch for the same batch
+    common::Span<size_t> d_begin = dh::ToSpan(batch_begin_);
+    common::Span<size_t> d_prefix = dh::ToSpan(batch_prefix_);
+    common::Span<float> d_dw = dh::ToSpan(batch_dw_);
+    // the batch members own disjoint rows, so the residual writes of one
+    // launch never collide
+    dh::LaunchN(learner_param_->gpu_id, total, [=] __device__(size_t idx) {
+      size_t lo = 0;
+      size_t hi = d_prefix.size() - 1;
+      while (lo < hi) {
+        size_t mid = lo + (hi - lo + 1) / 2;
+        if (d_prefix[mid] <= idx) {
+          lo = mid;
+        } else {
+          hi = mid - 1;
+        }
+      }
+      auto entry = d_data[d_begin[lo] + (idx - d_prefix[lo])];
+      auto &g = d_gpair[entry.index * num_groups + group_idx];
+      g += GradientPair(g.GetHess() * d_dw[lo] * entry.fvalue, 0);
+    });
+  }
+
   // This needs to be public because of the __device__ lambda.
   GradientPair GetBiasGradient(int group_idx, int num_group) {
     dh::safe_cuda(cudaSetDevice(learner_param_->gpu_id));
@@ -250,6 +402,14 @@ class GPUCoordinateUpdater : public LinearUpdater {  // NOLINT
   dh::device_vector<xgboost::Entry> data_;
   dh::caching_device_vector<GradientPair> gpair_;
   size_t num_row_;
+
+  // row-disjoint feature groups used by the batched cyclic rounds, and the
+  // per-batch device buffers of the segmented reduction and delta launch
+  std::vector<std::vector<int>> feature_batches_;
+  dh::caching_device_vector<size_t> batch_begin_;
+  dh::caching_device_vector<size_t> batch_end_;
+  dh::caching_device_vector<size_t> batch_prefix_;
+  dh::caching_device_vector<float> batch_dw_;
 };
 
 XGBOOST_REGISTER_LINEAR_UPDATER(GPUCoordinateUpdater, "gpu_coord_descent")
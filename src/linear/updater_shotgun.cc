@@ -4,6 +4,12 @@
  */
 
 #include <xgboost/linear_updater.h>
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+#include <vector>
+
 #include "coordinate_common.h"
 
 namespace xgboost {
@@ -11,11 +17,37 @@ namespace linear {
 
 DMLC_REGISTRY_FILE_TAG(updater_shotgun);
 
+struct ShotgunParam : public XGBoostParameter<ShotgunParam> {
+  int shotgun_epochs;
+  int shotgun_top_k;
+  DMLC_DECLARE_PARAMETER(ShotgunParam) {
+    DMLC_DECLARE_FIELD(shotgun_epochs)
+        .set_lower_bound(0)
+        .set_default(0)
+        .describe("Number of deterministic coordinate descent epochs per boosting "
+                  "iteration.  Weight deltas within an epoch are computed against "
+                  "the residuals frozen at the start of the epoch and merged "
+                  "afterwards, avoiding the benign races of the default sweep.  "
+                  "The value of zero uses the default sweep.");
+    DMLC_DECLARE_FIELD(shotgun_top_k)
+        .set_lower_bound(0)
+        .set_default(0)
+        .describe("Restrict each epoch after the first to the top features by "
+                  "magnitude of their most recent weight delta.  The value of "
+                  "zero means using all the features.");
+  }
+};
+
+DMLC_REGISTER_PARAMETER(ShotgunParam);
+
 class ShotgunUpdater : public LinearUpdater {
  public:
   // set training parameter
   void Configure(Args const& args) override {
-    param_.UpdateAllowUnknown(args);
+    const std::vector<std::pair<std::string, std::string> > rest {
+      param_.UpdateAllowUnknown(args)
+    };
+    sparam_.UpdateAllowUnknown(rest);
     if (param_.feature_selector != kCyclic &&
         param_.feature_selector != kShuffle) {
       LOG(FATAL) << "Unsupported feature selector for shotgun updater.\n"
@@ -26,10 +58,12 @@ class ShotgunUpdater : public LinearUpdater {
   void LoadConfig(Json const& in) override {
     auto const& config = get<Object const>(in);
     FromJson(config.at("linear_train_param"), &param_);
+    FromJson(config.at("shotgun_param"), &sparam_);
   }
   void SaveConfig(Json* p_out) const override {
     auto& out = *p_out;
     out["linear_train_param"] = ToJson(param_);
+    out["shotgun_param"] = ToJson(sparam_);
   }
 
   void Update(HostDeviceVector<GradientPair> *in_gpair, DMatrix *p_fmat,
@@ -48,6 +82,11 @@ class ShotgunUpdater : public LinearUpdater {
       UpdateBiasResidualParallel(gid, ngroup, dbias, &in_gpair->HostVector(), p_fmat);
     }
 
+    if (sparam_.shotgun_epochs > 0) {
+      this->UpdateEpochs(in_gpair, p_fmat, model);
+      return;
+    }
+
     // lock-free parallel updates of weights
     selector_->Setup(*model, in_gpair->ConstHostVector(), p_fmat,
                      param_.reg_alpha_denorm, param_.reg_lambda_denorm, 0);
@@ -88,11 +127,90 @@ class ShotgunUpdater : public LinearUpdater {
     }
   }
 
+  /**
+   * \brief Deterministic epoch mode.  An epoch computes the weight deltas of
+   *        all scheduled features against the residuals frozen at its start;
+   *        every feature is owned by a single thread, so the parallel phase
+   *        needs no synchronisation.  The deltas are then merged: applied to
+   *        the weights and replayed onto the residual vector.  Epochs after
+   *        the first revisit the features with the largest recent weight
+   *        deltas first, optionally restricted to the top-k of them.
+   */
+  void UpdateEpochs(HostDeviceVector<GradientPair> *in_gpair, DMatrix *p_fmat,
+                    gbm::GBLinearModel *model) {
+    auto &gpair = in_gpair->HostVector();
+    const int ngroup = model->learner_model_param->num_output_group;
+    const auto nfeat =
+        static_cast<bst_omp_uint>(model->learner_model_param->num_feature);
+    if (prev_dw_.size() != nfeat) {
+      prev_dw_.assign(nfeat, 0.0f);
+      have_priorities_ = false;
+    }
+    std::vector<bst_uint> order(nfeat);
+    std::iota(order.begin(), order.end(), 0);
+    for (int epoch = 0; epoch < sparam_.shotgun_epochs; ++epoch) {
+      // revisit the features with the largest recent weight deltas first
+      const bst_float *priority = prev_dw_.data();
+      std::stable_sort(order.begin(), order.end(),
+                       [priority](bst_uint a, bst_uint b) {
+                         return priority[a] > priority[b];
+                       });
+      auto n_active = nfeat;
+      if (have_priorities_ && sparam_.shotgun_top_k > 0) {
+        n_active = std::min(
+            n_active, static_cast<bst_omp_uint>(sparam_.shotgun_top_k));
+      }
+      // per-feature gradient sums against the frozen residuals
+      std::vector<std::pair<double, double>> sums(
+          n_active * ngroup, std::make_pair(0.0, 0.0));
+      for (const auto &batch : p_fmat->GetBatches<CSCPage>()) {
+#pragma omp parallel for schedule(static)
+        for (bst_omp_uint i = 0; i < n_active; ++i) {
+          auto col = batch[order[i]];
+          for (int gid = 0; gid < ngroup; ++gid) {
+            auto &s = sums[i * ngroup + gid];
+            for (auto &c : col) {
+              const GradientPair &p = gpair[c.index * ngroup + gid];
+              if (p.GetHess() < 0.0f) continue;
+              s.first += p.GetGrad() * c.fvalue;
+              s.second += p.GetHess() * c.fvalue * c.fvalue;
+            }
+          }
+        }
+      }
+      // merge the epoch: apply the weight deltas and replay them onto the
+      // residuals
+      for (bst_omp_uint i = 0; i < n_active; ++i) {
+        const bst_uint fid = order[i];
+        bst_float recent = 0.0f;
+        for (int gid = 0; gid < ngroup; ++gid) {
+          auto &s = sums[i * ngroup + gid];
+          bst_float &w = (*model)[fid][gid];
+          auto dw = static_cast<bst_float>(
+              param_.learning_rate *
+              CoordinateDelta(s.first, s.second, w, param_.reg_alpha_denorm,
+                              param_.reg_lambda_denorm));
+          recent = std::max(recent, std::abs(dw));
+          if (dw == 0.0f) continue;
+          w += dw;
+          UpdateResidualParallel(fid, gid, ngroup, dw, &gpair, p_fmat);
+        }
+        prev_dw_[fid] = recent;
+      }
+      have_priorities_ = true;
+    }
+  }
+
  protected:
   // training parameters
   LinearTrainParam param_;
+  ShotgunParam sparam_;
 
   std::unique_ptr<FeatureSelector> selector_;
+  // magnitude of the most recent weight delta per feature, drives the epoch
+  // scheduling
+  std::vector<bst_float> prev_dw_;
+  bool have_priorities_ { false };
 };
 
 XGBOOST_REGISTER_LINEAR_UPDATER(ShotgunUpdater, "shotgun")
@@ -42,6 +42,9 @@ TrackerLogger::~TrackerLogger() {
 namespace xgboost {
 
 bool ConsoleLogger::ShouldLog(LogVerbosity verbosity) {
+  if (!DebugCompiledIn() && verbosity == LV::kDebug) {
+    return false;
+  }
   return static_cast<int>(verbosity) <=
              (GlobalConfigThreadLocalStore::Get()->verbosity) ||
          verbosity == LV::kIgnore;
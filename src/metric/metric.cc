@@ -7,9 +7,34 @@
 #include <xgboost/metric.h>
 #include <xgboost/generic_parameters.h>
 
+#include <string>
+#include <unordered_map>
+
 #include "metric_common.h"
 
 namespace xgboost {
+namespace {
+// The dmlc registry keeps its entries in an ordered map; metric lookups run
+// on every learner reconfigure, so front it with a hash table built once
+// from the registered entries.  Entries registered after the first lookup
+// (e.g. by a late loaded plugin) fall through to the registry itself.
+template <typename MetricRegistry>
+MetricRegistry const* FindMetricEntry(const std::string& prefix) {
+  static const std::unordered_map<std::string, MetricRegistry const*> kEntries = [] {
+    std::unordered_map<std::string, MetricRegistry const*> entries;
+    for (auto const* e : ::dmlc::Registry<MetricRegistry>::Get()->List()) {
+      entries.emplace(e->name, e);
+    }
+    return entries;
+  }();
+  auto it = kEntries.find(prefix);
+  if (it != kEntries.cend()) {
+    return it->second;
+  }
+  return ::dmlc::Registry<MetricRegistry>::Get()->Find(prefix);
+}
+}  // anonymous namespace
+
 template <typename MetricRegistry>
 Metric* CreateMetricImpl(const std::string& name) {
   std::string buf = name;
@@ -25,7 +50,7 @@ Metric* CreateMetricImpl(const std::string& name) {
       prefix = buf;
       param = nullptr;
     }
-    auto *e = ::dmlc::Registry<MetricRegistry>::Get()->Find(prefix.c_str());
+    auto *e = FindMetricEntry<MetricRegistry>(prefix);
     if (e == nullptr) {
       return nullptr;
     }
@@ -33,7 +58,7 @@ Metric* CreateMetricImpl(const std::string& name) {
     return p_metric;
   } else {
     std::string prefix = buf.substr(0, pos);
-    auto *e = ::dmlc::Registry<MetricRegistry>::Get()->Find(prefix.c_str());
+    auto *e = FindMetricEntry<MetricRegistry>(prefix);
     if (e == nullptr) {
       return nullptr;
     }
@@ -25,6 +25,7 @@
 #include <dmlc/registry.h>
 #include <cmath>
 
+#include <algorithm>
 #include <vector>
 
 #include "xgboost/host_device_vector.h"
@@ -163,6 +164,104 @@ struct EvalAuc : public Metric {
   // for training jobs that run on the GPU.
   std::unique_ptr<xgboost::Metric> auc_gpu_;
 
+  /*
+   * Parallel AUC for a single group.  The grouped path below parallelizes
+   * across query groups, which leaves binary classification - one group
+   * spanning the whole eval set - with a sequential scan after the sort.
+   * Here the scan is replaced by blocked prefix sums of the positive and
+   * negative weights over the sorted records, after which every bucket of
+   * tied predictions can be evaluated independently: its rank statistics are
+   * differences of the prefix sums at the bucket boundaries.  Produces the
+   * same bucketed statistics as the sequential scan.
+   *
+   * Returns false when the group contains only positive or only negative
+   * samples and the AUC is undefined.
+   */
+  template <typename WeightPolicy>
+  static bool SingleGroupAuc(const std::vector<bst_float> &h_preds,
+                             const std::vector<bst_float> &labels,
+                             const MetaInfo &info, double *sum_auc) {
+    const auto n = static_cast<bst_omp_uint>(h_preds.size());
+    PredIndPairContainer rec(n);
+    #pragma omp parallel for schedule(static)
+    for (bst_omp_uint j = 0; j < n; ++j) {
+      rec[j] = {h_preds[j], j};
+    }
+    XGBOOST_PARALLEL_SORT(rec.begin(), rec.end(), common::CmpFirst);
+
+    // per-record positive/negative weights in sorted order, turned into
+    // inclusive prefix sums below
+    std::vector<double> pos(n), neg(n);
+    #pragma omp parallel for schedule(static)
+    for (bst_omp_uint j = 0; j < n; ++j) {
+      const bst_float wt = WeightPolicy::GetWeightOfSortedRecord(info, rec, j, 0);
+      const bst_float ctr = labels[rec[j].second];
+      pos[j] = ctr * wt;
+      neg[j] = (1.0f - ctr) * wt;
+    }
+
+    // blocked two-pass prefix sums: per-block totals, serial scan over the
+    // block totals, then in-place running sums seeded with the block base
+    const auto nblocks = std::max(static_cast<bst_omp_uint>(1),
+        std::min(static_cast<bst_omp_uint>(omp_get_max_threads()), n));
+    const bst_omp_uint block_size = (n + nblocks - 1) / nblocks;
+    std::vector<double> pos_base(nblocks + 1, 0.0), neg_base(nblocks + 1, 0.0);
+    #pragma omp parallel for schedule(static)
+    for (bst_omp_uint b = 0; b < nblocks; ++b) {
+      const bst_omp_uint end = std::min(n, (b + 1) * block_size);
+      double sum_pos = 0.0, sum_neg = 0.0;
+      for (bst_omp_uint j = b * block_size; j < end; ++j) {
+        sum_pos += pos[j];
+        sum_neg += neg[j];
+      }
+      pos_base[b + 1] = sum_pos;
+      neg_base[b + 1] = sum_neg;
+    }
+    for (bst_omp_uint b = 1; b <= nblocks; ++b) {
+      pos_base[b] += pos_base[b - 1];
+      neg_base[b] += neg_base[b - 1];
+    }
+    #pragma omp parallel for schedule(static)
+    for (bst_omp_uint b = 0; b < nblocks; ++b) {
+      const bst_omp_uint end = std::min(n, (b + 1) * block_size);
+      double sum_pos = pos_base[b], sum_neg = neg_base[b];
+      for (bst_omp_uint j = b * block_size; j < end; ++j) {
+        sum_pos += pos[j];
+        pos[j] = sum_pos;
+        sum_neg += neg[j];
+        neg[j] = sum_neg;
+      }
+    }
+
+    // every thread handles the buckets that start in its range; a bucket is a
+    // run of tied predictions and contributes its negative weight times the
+    // positive weight ranked ahead of it (ties count half)
+    double sum_pospair = 0.0;
+    #pragma omp parallel for schedule(static) reduction(+:sum_pospair)
+    for (bst_omp_uint j = 0; j < n; ++j) {
+      if (j != 0 && rec[j].first == rec[j - 1].first) {
+        continue;  // not the head of a bucket
+      }
+      bst_omp_uint bucket_end = j + 1;
+      while (bucket_end < n && rec[bucket_end].first == rec[j].first) {
+        ++bucket_end;
+      }
+      const double pos_before = j == 0 ? 0.0 : pos[j - 1];
+      const double neg_before = j == 0 ? 0.0 : neg[j - 1];
+      const double buf_pos = pos[bucket_end - 1] - pos_before;
+      const double buf_neg = neg[bucket_end - 1] - neg_before;
+      sum_pospair += buf_neg * (pos_before + buf_pos * 0.5);
+    }
+
+    const double sum_npos = pos[n - 1];
+    const double sum_nneg = neg[n - 1];
+    if (sum_npos <= 0.0 || sum_nneg <= 0.0) {
+      return false;
+    }
+    *sum_auc = sum_pospair / (sum_npos * sum_nneg);
+    return true;
+  }
+
   template <typename WeightPolicy>
   bst_float Eval(const HostDeviceVector<bst_float> &preds,
                  const MetaInfo &info,
@@ -175,46 +274,54 @@ struct EvalAuc : public Metric {
     const auto& labels = info.labels_.ConstHostVector();
     const auto &h_preds = preds.ConstHostVector();
 
-    #pragma omp parallel reduction(+:sum_auc, auc_error) if (ngroups > 1)
-    {
-      // Each thread works on a distinct group and sorts the predictions in that group
-      PredIndPairContainer rec;
-      #pragma omp for schedule(static)
-      for (bst_omp_uint group_id = 0; group_id < ngroups; ++group_id) {
-        // Same thread can work on multiple groups one after another; hence, resize
-        // the predictions array based on the current group
-        rec.resize(gptr[group_id + 1] - gptr[group_id]);
-        #pragma omp parallel for schedule(static) if (!omp_in_parallel())
-        for (bst_omp_uint j = gptr[group_id]; j < gptr[group_id + 1]; ++j) {
-          rec[j - gptr[group_id]] = {h_preds[j], j};
-        }
+    if (ngroups == 1) {
+      // single group: scale with cores through the parallel scan engine
+      // instead of the per-group loop below
+      if (!SingleGroupAuc<WeightPolicy>(h_preds, labels, info, &sum_auc)) {
+        auc_error = 1;
+      }
+    } else {
+      #pragma omp parallel reduction(+:sum_auc, auc_error) if (ngroups > 1)
+      {
+        // Each thread works on a distinct group and sorts the predictions in that group
+        PredIndPairContainer rec;
+        #pragma omp for schedule(static)
+        for (bst_omp_uint group_id = 0; group_id < ngroups; ++group_id) {
+          // Same thread can work on multiple groups one after another; hence, resize
+          // the predictions array based on the current group
+          rec.resize(gptr[group_id + 1] - gptr[group_id]);
+          #pragma omp parallel for schedule(static) if (!omp_in_parallel())
+          for (bst_omp_uint j = gptr[group_id]; j < gptr[group_id + 1]; ++j) {
+            rec[j - gptr[group_id]] = {h_preds[j], j};
+          }
 
-        XGBOOST_PARALLEL_SORT(rec.begin(), rec.end(), common::CmpFirst);
-        // calculate AUC
-        double sum_pospair = 0.0;
-        double sum_npos = 0.0, sum_nneg = 0.0, buf_pos = 0.0, buf_neg = 0.0;
-        for (size_t j = 0; j < rec.size(); ++j) {
-          const bst_float wt = WeightPolicy::GetWeightOfSortedRecord(info, rec, j, group_id);
-          const bst_float ctr = labels[rec[j].second];
-          // keep bucketing predictions in same bucket
-          if (j != 0 && rec[j].first != rec[j - 1].first) {
-            sum_pospair += buf_neg * (sum_npos + buf_pos * 0.5);
-            sum_npos += buf_pos;
-            sum_nneg += buf_neg;
-            buf_neg = buf_pos = 0.0f;
+          XGBOOST_PARALLEL_SORT(rec.begin(), rec.end(), common::CmpFirst);
+          // calculate AUC
+          double sum_pospair = 0.0;
+          double sum_npos = 0.0, sum_nneg = 0.0, buf_pos = 0.0, buf_neg = 0.0;
+          for (size_t j = 0; j < rec.size(); ++j) {
+            const bst_float wt = WeightPolicy::GetWeightOfSortedRecord(info, rec, j, group_id);
+            const bst_float ctr = labels[rec[j].second];
+            // keep bucketing predictions in same bucket
+            if (j != 0 && rec[j].first != rec[j - 1].first) {
+              sum_pospair += buf_neg * (sum_npos + buf_pos * 0.5);
+              sum_npos += buf_pos;
+              sum_nneg += buf_neg;
+              buf_neg = buf_pos = 0.0f;
+            }
+            buf_pos += ctr * wt;
+            buf_neg += (1.0f - ctr) * wt;
+          }
+          sum_pospair += buf_neg * (sum_npos + buf_pos * 0.5);
+          sum_npos += buf_pos;
+          sum_nneg += buf_neg;
+          // check weird conditions
+          if (sum_npos <= 0.0 || sum_nneg <= 0.0) {
+            auc_error += 1;
+          } else {
+            // this is the AUC
+            sum_auc += sum_pospair / (sum_npos * sum_nneg);
           }
-          buf_pos += ctr * wt;
-          buf_neg += (1.0f - ctr) * wt;
-        }
-        sum_pospair += buf_neg * (sum_npos + buf_pos * 0.5);
-        sum_npos += buf_pos;
-        sum_nneg += buf_neg;
-        // check weird conditions
-        if (sum_npos <= 0.0 || sum_nneg <= 0.0) {
-          auc_error += 1;
-        } else {
-          // this is the AUC
-          sum_auc += sum_pospair / (sum_npos * sum_nneg);
         }
       }
     }
@@ -623,8 +730,11 @@ struct EvalAucPR : public Metric {
     const bool is_ranking_task =
       !info.group_ptr_.empty() && info.weights_.Size() != info.num_row_;
 
-    // Check if we have a GPU assignment; else, revert back to CPU
-    if (tparam_->gpu_id >= 0 && is_ranking_task) {
+    // Check if we have a GPU assignment; else, revert back to CPU.  The GPU
+    // metric handles per-group weights and the single-group classification
+    // case with per-instance weights; grouped data with per-instance weights
+    // stays on the CPU.
+    if (tparam_->gpu_id >= 0 && (is_ranking_task || info.group_ptr_.empty())) {
       if (!aucpr_gpu_) {
         // Check and see if we have the GPU metric registered in the internal registry
         aucpr_gpu_.reset(GPUMetric::CreateGPUMetric(this->Name(), tparam_));
@@ -7,6 +7,7 @@
 #include <xgboost/objective.h>
 #include <vector>
 #include <algorithm>
+#include <memory>
 #include <utility>
 
 #include "xgboost/json.h"
@@ -37,6 +38,7 @@ DMLC_REGISTRY_FILE_TAG(rank_obj_gpu);
 struct LambdaRankParam : public XGBoostParameter<LambdaRankParam> {
   size_t num_pairsample;
   float fix_list_weight;
+  size_t max_pairs_per_group;
   // declare parameters
   DMLC_DECLARE_PARAMETER(LambdaRankParam) {
     DMLC_DECLARE_FIELD(num_pairsample).set_lower_bound(1).set_default(1)
@@ -44,6 +46,10 @@ struct LambdaRankParam : public XGBoostParameter<LambdaRankParam> {
     DMLC_DECLARE_FIELD(fix_list_weight).set_lower_bound(0.0f).set_default(0.0f)
         .describe("Normalize the weight of each list by this value,"
                   " if equals 0, no effect will happen");
+    DMLC_DECLARE_FIELD(max_pairs_per_group).set_lower_bound(0).set_default(0)
+        .describe("Budget on the number of sampled pairs per group; when the expected"
+                  " number of pairs exceeds it, instances are thinned randomly and the"
+                  " pair weights rescaled to stay unbiased.  0 means no budget.");
   }
 };
 
@@ -823,6 +829,17 @@ class LambdaRankObj : public ObjFunction {
     const auto ngroup = static_cast<bst_omp_uint>(gptr.size() - 1);
     out_gpair->Resize(preds.Size());
 
+    // Groups at least this large are handled after the per-group loop, one at
+    // a time with intra-group parallelism, so a few giant groups do not
+    // serialize the gradient pass on single threads.
+    constexpr unsigned kParallelGroupSize = 8192;
+    std::vector<bst_omp_uint> large_groups;
+    for (bst_omp_uint k = 0; k < ngroup; ++k) {
+      if (gptr[k + 1] - gptr[k] >= kParallelGroupSize) {
+        large_groups.push_back(k);
+      }
+    }
+
     #pragma omp parallel
     {
       // parallel construct, declare random number generator here, so that each
@@ -834,6 +851,7 @@ class LambdaRankObj : public ObjFunction {
 
       #pragma omp for schedule(static)
       for (bst_omp_uint k = 0; k < ngroup; ++k) {
+        if (gptr[k + 1] - gptr[k] >= kParallelGroupSize) { continue; }
         lst.clear(); pairs.clear();
         for (unsigned j = gptr[k]; j < gptr[k+1]; ++j) {
           lst.emplace_back(preds_h[j], labels[j], j);
@@ -845,6 +863,18 @@ class LambdaRankObj : public ObjFunction {
           rec[i] = std::make_pair(lst[i].label, i);
         }
         std::stable_sort(rec.begin(), rec.end(), common::CmpFirst);
+        // pair budget: thin the sampled pairs when the group would exceed it,
+        // rescaling the kept weights so the gradients stay unbiased
+        double keep_prob = 1.0;
+        if (param_.max_pairs_per_group > 0) {
+          const double expected =
+              static_cast<double>(lst.size()) * param_.num_pairsample;
+          if (expected > param_.max_pairs_per_group) {
+            keep_prob = param_.max_pairs_per_group / expected;
+          }
+        }
+        const bst_float pair_weight =
+            info.GetWeight(k) * weight_normalization_factor / keep_prob;
         // enumerate buckets with same label, for each item in the lst, grab another sample randomly
         for (unsigned i = 0; i < rec.size(); ) {
           unsigned j = i + 1;
@@ -855,13 +885,15 @@ class LambdaRankObj : public ObjFunction {
             int nsample = param_.num_pairsample;
             while (nsample --) {
               for (unsigned pid = i; pid < j; ++pid) {
+                if (keep_prob < 1.0 &&
+                    std::uniform_real_distribution<float>(0.0f, 1.0f)(rnd) >= keep_prob) {
+                  continue;
+                }
                 unsigned ridx = std::uniform_int_distribution<unsigned>(0, nleft + nright - 1)(rnd);
                 if (ridx < nleft) {
-                  pairs.emplace_back(rec[ridx].second, rec[pid].second,
-                      info.GetWeight(k) * weight_normalization_factor);
+                  pairs.emplace_back(rec[ridx].second, rec[pid].second, pair_weight);
                 } else {
-                  pairs.emplace_back(rec[pid].second, rec[ridx+j-i].second,
-                      info.GetWeight(k) * weight_normalization_factor);
+                  pairs.emplace_back(rec[pid].second, rec[ridx+j-i].second, pair_weight);
                 }
               }
             }
@@ -889,6 +921,122 @@ class LambdaRankObj : public ObjFunction {
         }
       }
     }
+
+    for (auto k : large_groups) {
+      this->ComputeGradientsLargeGroup(k, iter, preds_h, labels, info,
+                                       weight_normalization_factor, gptr, &gpair);
+    }
+  }
+
+  /*
+   * Gradients for one group too large for the one-group-per-thread loop.  The
+   * sampled partner of every instance is drawn from an instance-seeded random
+   * stream, so the per-instance pair counts are known independently and the
+   * pairs can be generated in parallel at precomputed offsets; the result
+   * does not depend on the number of threads.  The accumulation stays
+   * sequential and is bounded by the pair budget rather than the group size.
+   */
+  void ComputeGradientsLargeGroup(bst_omp_uint k, int iter,
+                                  const std::vector<bst_float>& preds_h,
+                                  const std::vector<bst_float>& labels,
+                                  const MetaInfo& info,
+                                  bst_float weight_normalization_factor,
+                                  const std::vector<unsigned>& gptr,
+                                  std::vector<GradientPair>* p_gpair) {
+    std::vector<GradientPair>& gpair = *p_gpair;
+    const unsigned group_begin = gptr[k];
+    const auto n = static_cast<omp_ulong>(gptr[k + 1] - group_begin);
+
+    std::vector<ListEntry> lst(n, ListEntry(0.0f, 0.0f, 0));
+    #pragma omp parallel for schedule(static)
+    for (omp_ulong i = 0; i < n; ++i) {
+      lst[i] = ListEntry(preds_h[group_begin + i], labels[group_begin + i], group_begin + i);
+      gpair[group_begin + i] = GradientPair(0.0f, 0.0f);
+    }
+    std::stable_sort(lst.begin(), lst.end(), ListEntry::CmpPred);
+    std::vector<std::pair<bst_float, unsigned>> rec(n);
+    for (omp_ulong i = 0; i < n; ++i) {
+      rec[i] = std::make_pair(lst[i].label, static_cast<unsigned>(i));
+    }
+    std::stable_sort(rec.begin(), rec.end(), common::CmpFirst);
+
+    // bucket boundaries of tied labels, per position
+    std::vector<unsigned> bucket_begin(n), bucket_end(n);
+    for (omp_ulong i = 0; i < n;) {
+      omp_ulong j = i + 1;
+      while (j < n && rec[j].first == rec[i].first) ++j;
+      for (omp_ulong pid = i; pid < j; ++pid) {
+        bucket_begin[pid] = static_cast<unsigned>(i);
+        bucket_end[pid] = static_cast<unsigned>(j);
+      }
+      i = j;
+    }
+
+    double keep_prob = 1.0;
+    if (param_.max_pairs_per_group > 0) {
+      const double expected = static_cast<double>(n) * param_.num_pairsample;
+      if (expected > param_.max_pairs_per_group) {
+        keep_prob = param_.max_pairs_per_group / expected;
+      }
+    }
+    const bst_float pair_weight =
+        info.GetWeight(k) * weight_normalization_factor / keep_prob;
+
+    // generate the pairs of every instance into its own slot of a padded
+    // array, then compact; no thread ever writes another instance's slot
+    const auto ns = static_cast<unsigned>(param_.num_pairsample);
+    std::vector<LambdaPair> padded(static_cast<size_t>(n) * ns, LambdaPair(0, 0, 0.0f));
+    std::vector<unsigned> counts(n, 0);
+    #pragma omp parallel for schedule(static)
+    for (omp_ulong pid = 0; pid < n; ++pid) {
+      const unsigned nleft = bucket_begin[pid];
+      const unsigned nright = static_cast<unsigned>(n) - bucket_end[pid];
+      if (nleft + nright == 0) { continue; }
+      std::minstd_rand rnd((iter + 1) * 1111 + group_begin + pid);
+      unsigned cnt = 0;
+      for (unsigned s = 0; s < ns; ++s) {
+        if (keep_prob < 1.0 &&
+            std::uniform_real_distribution<float>(0.0f, 1.0f)(rnd) >= keep_prob) {
+          continue;
+        }
+        unsigned ridx = std::uniform_int_distribution<unsigned>(0, nleft + nright - 1)(rnd);
+        if (ridx < nleft) {
+          padded[pid * ns + cnt] = LambdaPair(rec[ridx].second, rec[pid].second, pair_weight);
+        } else {
+          padded[pid * ns + cnt] =
+              LambdaPair(rec[pid].second, rec[ridx - nleft + bucket_end[pid]].second, pair_weight);
+        }
+        ++cnt;
+      }
+      counts[pid] = cnt;
+    }
+    std::vector<size_t> offsets(n + 1, 0);
+    for (omp_ulong pid = 0; pid < n; ++pid) {
+      offsets[pid + 1] = offsets[pid] + counts[pid];
+    }
+    std::vector<LambdaPair> pairs(offsets[n], LambdaPair(0, 0, 0.0f));
+    #pragma omp parallel for schedule(static)
+    for (omp_ulong pid = 0; pid < n; ++pid) {
+      std::copy_n(padded.begin() + pid * ns, counts[pid], pairs.begin() + offsets[pid]);
+    }
+
+    LambdaWeightComputerT::GetLambdaWeight(lst, &pairs);
+    float scale = 1.0f / param_.num_pairsample;
+    if (param_.fix_list_weight != 0.0f) {
+      scale *= param_.fix_list_weight / (gptr[k + 1] - gptr[k]);
+    }
+    for (auto & pair : pairs) {
+      const ListEntry &pos = lst[pair.pos_index];
+      const ListEntry &neg = lst[pair.neg_index];
+      const bst_float w = pair.weight * scale;
+      const float eps = 1e-16f;
+      bst_float p = common::Sigmoid(pos.pred - neg.pred);
+      bst_float g = p - 1.0f;
+      bst_float h = std::max(p * (1.0f - p), eps);
+      // accumulate gradient and hessian in both pid, and nid
+      gpair[pos.rindex] += GradientPair(g * w, 2.0f*w*h);
+      gpair[neg.rindex] += GradientPair(-g * w, 2.0f*w*h);
+    }
   }
 
 #if defined(__CUDACC__)
@@ -916,18 +1064,35 @@ class LambdaRankObj : public ObjFunction {
     auto d_gpair = out_gpair->DevicePointer();
     auto d_labels = info.labels_.ConstDevicePointer();
 
-    SortedLabelList slist(param_);
-
-    // Sort the labels within the groups on the device
-    slist.Sort(info.labels_, gptr);
+    // The sorted label list depends only on the labels and the group
+    // structure, both fixed for the training matrix across boosting
+    // iterations; keep it on the objective instead of re-uploading the group
+    // offsets and re-sorting the labels every round.
+    if (slist_ == nullptr || slist_info_ != &info ||
+        slist_num_rows_ != info.labels_.Size() ||
+        slist_num_groups_ != gptr.size()) {
+      slist_.reset(new SortedLabelList(param_));
+      // Sort the labels within the groups on the device
+      slist_->Sort(info.labels_, gptr);
+      slist_info_ = &info;
+      slist_num_rows_ = info.labels_.Size();
+      slist_num_groups_ = gptr.size();
+    }
 
     // Initialize the gradients next
     out_gpair->Fill(GradientPair(0.0f, 0.0f));
 
     // Finally, compute the gradients
-    slist.ComputeGradients<LambdaWeightComputerT>
+    slist_->ComputeGradients<LambdaWeightComputerT>
       (d_preds, d_labels, info.weights_, iter, d_gpair, weight_normalization_factor);
   }
+
+  // Cached device-side ranking context, see ComputeGradientsOnGPU.  The key
+  // members record the identity of the data the sorter was built from.
+  std::unique_ptr<SortedLabelList> slist_;
+  const MetaInfo* slist_info_ {nullptr};
+  size_t slist_num_rows_ {0};
+  size_t slist_num_groups_ {0};
 #endif
 
   LambdaRankParam param_;
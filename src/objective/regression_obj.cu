@@ -8,6 +8,7 @@
 #include <dmlc/omp.h>
 #include <xgboost/logging.h>
 #include <xgboost/objective.h>
+#include <atomic>
 #include <cmath>
 #include <memory>
 #include <vector>
@@ -38,10 +39,69 @@ struct RegLossParam : public XGBoostParameter<RegLossParam> {
   }
 };
 
+/*
+ * Elementwise residue of a loss' default evaluation metric, used by the fused
+ * gradient + metric pass.  The formulas mirror the corresponding EvalRow
+ * policies in src/metric/elementwise_metric.cu and take the transformed
+ * prediction, which the gradient loop computes anyway.  Losses whose default
+ * metric is not elementwise (e.g. AUC) do not specialize and keep the
+ * separate metric pass.
+ */
+template <typename Loss>
+struct FusedEvalTraits {
+  static bool constexpr kHasFusedMetric = false;
+  static bst_float Residue(bst_float, bst_float) { return 0.0f; }
+  static bst_float GetFinal(double, double) { return 0.0f; }
+};
+
+template <>
+struct FusedEvalTraits<LinearSquareLoss> {  // rmse
+  static bool constexpr kHasFusedMetric = true;
+  static bst_float Residue(bst_float label, bst_float pred) {
+    bst_float diff = label - pred;
+    return diff * diff;
+  }
+  static bst_float GetFinal(double esum, double wsum) {
+    return wsum == 0 ? std::sqrt(esum) : std::sqrt(esum / wsum);
+  }
+};
+
+template <>
+struct FusedEvalTraits<LogisticRegression> {  // rmse on the probability
+  static bool constexpr kHasFusedMetric = true;
+  static bst_float Residue(bst_float label, bst_float pred) {
+    return FusedEvalTraits<LinearSquareLoss>::Residue(label, pred);
+  }
+  static bst_float GetFinal(double esum, double wsum) {
+    return FusedEvalTraits<LinearSquareLoss>::GetFinal(esum, wsum);
+  }
+};
+
+template <>
+struct FusedEvalTraits<LogisticClassification> {  // logloss
+  static bool constexpr kHasFusedMetric = true;
+  static bst_float Residue(bst_float y, bst_float py) {
+    const bst_float eps = 1e-16f;
+    const bst_float pneg = 1.0f - py;
+    if (py < eps) {
+      return -y * std::log(eps) - (1.0f - y) * std::log(1.0f - eps);
+    } else if (pneg < eps) {
+      return -y * std::log(1.0f - eps) - (1.0f - y) * std::log(eps);
+    } else {
+      return -y * std::log(py) - (1.0f - y) * std::log(pneg);
+    }
+  }
+  static bst_float GetFinal(double esum, double wsum) {
+    return wsum == 0 ? esum : esum / wsum;
+  }
+};
+
 template<typename Loss>
 class RegLossObj : public ObjFunction {
  protected:
   HostDeviceVector<float> additional_input_;
+  // label flag shared by the thread-safe range gradient calls
+  std::atomic<int> range_label_correct_{1};
 
  public:
   // 0 - label_correct flag, 1 - scale_pos_weight, 2 - is_null_weight
@@ -61,13 +121,17 @@ class RegLossObj : public ObjFunction {
     size_t const ndata = preds.Size();
     out_gpair->Resize(ndata);
     auto device = tparam_->gpu_id;
-    additional_input_.HostVector().begin()[0] = 1;  // Fill the label_correct flag
 
     bool is_null_weight = info.weights_.Size() == 0;
     if (!is_null_weight) {
       CHECK_EQ(info.weights_.Size(), ndata)
           << "Number of weights should be equal to number of data points.";
     }
+    if (device < 0) {
+      this->GetGradientHost(preds, info, out_gpair);
+      return;
+    }
+    additional_input_.HostVector().begin()[0] = 1;  // Fill the label_correct flag
     auto scale_pos_weight = param_.scale_pos_weight;
     additional_input_.HostVector().begin()[1] = scale_pos_weight;
     additional_input_.HostVector().begin()[2] = is_null_weight;
@@ -103,6 +167,176 @@ class RegLossObj : public ObjFunction {
     }
   }
 
+  // Host gradients skip the Transform launch entirely: the loss functions
+  // inline into a plain loop the compiler can vectorize, and binary labels
+  // stream from the bit-packed cache like the fused and ranged variants.
+  void GetGradientHost(const HostDeviceVector<bst_float>& preds,
+                       const MetaInfo& info,
+                       HostDeviceVector<GradientPair>* out_gpair) {
+    const auto& h_preds = preds.ConstHostVector();
+    const auto& h_labels = info.labels_.ConstHostVector();
+    const auto& h_weights = info.weights_.ConstHostVector();
+    auto& h_gpair = out_gpair->HostVector();
+    const bool is_null_weight = h_weights.empty();
+    const float scale_pos_weight = param_.scale_pos_weight;
+    // packed labels are 0/1 by construction so the validity check can be
+    // skipped as well
+    auto const& packed = info.TryPackedLabels();
+    const bool use_packed = !packed.empty();
+    const uint32_t* p_packed = packed.data();
+
+    int label_correct = 1;
+    const auto n = static_cast<omp_ulong>(preds.Size());
+    #pragma omp parallel for schedule(static) reduction(&&:label_correct)
+    for (omp_ulong i = 0; i < n; ++i) {
+      const bst_float p = Loss::PredTransform(h_preds[i]);
+      const bst_float label =
+          use_packed ? static_cast<bst_float>((p_packed[i / 32] >> (i % 32)) & 1u)
+                     : h_labels[i];
+      bst_float w = is_null_weight ? 1.0f : h_weights[i];
+      if (label == 1.0f) {
+        w *= scale_pos_weight;
+      }
+      if (!use_packed && !Loss::CheckLabel(label)) {
+        label_correct = 0;
+      }
+      h_gpair[i] = GradientPair(Loss::FirstOrderGradient(p, label) * w,
+                                Loss::SecondOrderGradient(p, label) * w);
+    }
+    if (!label_correct) {
+      LOG(FATAL) << Loss::LabelErrorMsg();
+    }
+  }
+
+  bool GetGradientFusedEval(const HostDeviceVector<bst_float>& preds,
+                            const MetaInfo& info, int iteration,
+                            HostDeviceVector<GradientPair>* out_gpair,
+                            bst_float* out_metric) override {
+    // The fused pass is a CPU loop; on the GPU, or for losses without an
+    // elementwise default metric, keep the separate passes.
+    if (!FusedEvalTraits<Loss>::kHasFusedMetric || tparam_->gpu_id >= 0) {
+      this->GetGradient(preds, info, iteration, out_gpair);
+      return false;
+    }
+    CHECK_EQ(preds.Size(), info.labels_.Size())
+        << " " << "labels are not correctly provided"
+        << "preds.size=" << preds.Size() << ", label.size=" << info.labels_.Size() << ", "
+        << "Loss: " << Loss::Name();
+    size_t const ndata = preds.Size();
+    out_gpair->Resize(ndata);
+
+    bool is_null_weight = info.weights_.Size() == 0;
+    if (!is_null_weight) {
+      CHECK_EQ(info.weights_.Size(), ndata)
+          << "Number of weights should be equal to number of data points.";
+    }
+    const auto& h_preds = preds.ConstHostVector();
+    const auto& h_labels = info.labels_.ConstHostVector();
+    const auto& h_weights = info.weights_.ConstHostVector();
+    auto& h_gpair = out_gpair->HostVector();
+    const float scale_pos_weight = param_.scale_pos_weight;
+    // binary labels stream from the bit-packed cache, cutting label traffic
+    // 32-fold; packed labels are 0/1 by construction so the validity check
+    // can be skipped as well
+    auto const& packed = info.TryPackedLabels();
+    const bool use_packed = !packed.empty();
+    const uint32_t* p_packed = packed.data();
+
+    double residue = 0.0;
+    double weights_sum = 0.0;
+    int label_correct = 1;
+    const auto n = static_cast<omp_ulong>(ndata);
+    #pragma omp parallel for schedule(static) \
+        reduction(+:residue, weights_sum) reduction(&&:label_correct)
+    for (omp_ulong i = 0; i < n; ++i) {
+      const bst_float p = Loss::PredTransform(h_preds[i]);
+      const bst_float label =
+          use_packed ? static_cast<bst_float>((p_packed[i / 32] >> (i % 32)) & 1u)
+                     : h_labels[i];
+      bst_float w = is_null_weight ? 1.0f : h_weights[i];
+      // the metric weight does not include scale_pos_weight
+      residue += static_cast<double>(FusedEvalTraits<Loss>::Residue(label, p) * w);
+      weights_sum += w;
+      if (label == 1.0f) {
+        w *= scale_pos_weight;
+      }
+      if (!use_packed && !Loss::CheckLabel(label)) {
+        label_correct = 0;
+      }
+      h_gpair[i] = GradientPair(Loss::FirstOrderGradient(p, label) * w,
+                                Loss::SecondOrderGradient(p, label) * w);
+    }
+    if (!label_correct) {
+      LOG(FATAL) << Loss::LabelErrorMsg();
+    }
+    *out_metric = FusedEvalTraits<Loss>::GetFinal(residue, weights_sum);
+    return true;
+  }
+
+  bool GetGradientRangeBegin(const HostDeviceVector<bst_float>&,
+                             const MetaInfo& info,
+                             HostDeviceVector<GradientPair>* out_gpair) override {
+    // The range calls arrive from predictor worker threads, which only makes
+    // sense for host resident data.
+    if (tparam_->gpu_id >= 0) {
+      return false;
+    }
+    size_t const ndata = info.labels_.Size();
+    out_gpair->Resize(ndata);
+    bool is_null_weight = info.weights_.Size() == 0;
+    if (!is_null_weight) {
+      CHECK_EQ(info.weights_.Size(), ndata)
+          << "Number of weights should be equal to number of data points.";
+    }
+    // Touch the host buffers up front so concurrent range calls never
+    // trigger a lazy synchronisation; the same goes for the packed label
+    // cache, which is not thread-safe to build.
+    info.labels_.ConstHostVector();
+    info.weights_.ConstHostVector();
+    info.TryPackedLabels();
+    out_gpair->HostVector();
+    range_label_correct_.store(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  void GetGradientRange(const HostDeviceVector<bst_float>& preds,
+                        const MetaInfo& info, int, std::size_t begin,
+                        std::size_t end,
+                        HostDeviceVector<GradientPair>* out_gpair) override {
+    const auto& h_preds = preds.ConstHostVector();
+    const auto& h_labels = info.labels_.ConstHostVector();
+    const auto& h_weights = info.weights_.ConstHostVector();
+    auto& h_gpair = out_gpair->HostVector();
+    const bool is_null_weight = h_weights.empty();
+    const float scale_pos_weight = param_.scale_pos_weight;
+    // populated in GetGradientRangeBegin; packed labels are 0/1 by
+    // construction so the validity check can be skipped
+    auto const& packed = info.TryPackedLabels();
+    const bool use_packed = !packed.empty();
+    const uint32_t* p_packed = packed.data();
+    for (std::size_t i = begin; i < end; ++i) {
+      const bst_float p = Loss::PredTransform(h_preds[i]);
+      const bst_float label =
+          use_packed ? static_cast<bst_float>((p_packed[i / 32] >> (i % 32)) & 1u)
+                     : h_labels[i];
+      bst_float w = is_null_weight ? 1.0f : h_weights[i];
+      if (label == 1.0f) {
+        w *= scale_pos_weight;
+      }
+      if (!use_packed && !Loss::CheckLabel(label)) {
+        range_label_correct_.store(0, std::memory_order_relaxed);
+      }
+      h_gpair[i] = GradientPair(Loss::FirstOrderGradient(p, label) * w,
+                                Loss::SecondOrderGradient(p, label) * w);
+    }
+  }
+
+  void GetGradientRangeEnd() override {
+    if (!range_label_correct_.load(std::memory_order_relaxed)) {
+      LOG(FATAL) << Loss::LabelErrorMsg();
+    }
+  }
+
  public:
   const char* DefaultEvalMetric() const override {
     return Loss::DefaultEvalMetric();
@@ -4,8 +4,11 @@
 #include <dmlc/omp.h>
 #include <dmlc/any.h>
 
+#include <algorithm>
 #include <cstddef>
+#include <functional>
 #include <limits>
+#include <memory>
 #include <mutex>
 
 #include "xgboost/base.h"
@@ -17,7 +20,9 @@
 #include "xgboost/host_device_vector.h"
 
 #include "../data/adapter.h"
+#include "../common/common.h"
 #include "../common/math.h"
+#include "../common/threadpool.h"
 #include "../gbm/gbtree_model.h"
 
 namespace xgboost {
@@ -25,60 +30,273 @@ namespace predictor {
 
 DMLC_REGISTRY_FILE_TAG(cpu_predictor);
 
-bst_float PredValue(const SparsePage::Inst &inst,
-                    const std::vector<std::unique_ptr<RegTree>> &trees,
-                    const std::vector<int> &tree_info, int bst_group,
-                    RegTree::FVec *p_feats, unsigned tree_begin,
-                    unsigned tree_end) {
-  bst_float psum = 0.0f;
-  p_feats->Fill(inst);
-  for (size_t i = tree_begin; i < tree_end; ++i) {
-    if (tree_info[i] == bst_group) {
-      int tid = trees[i]->GetLeafIndex(*p_feats);
-      psum += (*trees[i])[tid].LeafValue();
-    }
-  }
-  p_feats->Drop(inst);
-  return psum;
+// number of rows traversed through a tree in lockstep
+size_t constexpr kPredictLanes = 16;
+// Rows with at most this many entries skip the FVec fill/drop cycle and walk
+// the trees through a binary search over the row's sorted entries instead;
+// see PredictBatchByBlockOfRowsKernel.  Worthwhile only when the feature
+// space is large enough that the dense staging array falls out of cache.
+size_t SparsePredictMaxNnz() {
+  static size_t const kMaxNnz = static_cast<size_t>(
+      dmlc::GetEnv("XGBOOST_SPARSE_PREDICT_NNZ", 32));
+  return kMaxNnz;
 }
+// number of trees per tile of the (rows x trees) blocking; sized so a tile's
+// nodes stay cached while every lane tile of a row block walks through it
+size_t constexpr kPredictTreeBlock = 32;
 
-inline bst_float PredValueByOneTree(const RegTree::FVec& p_feats,
-                                    const std::unique_ptr<RegTree>& tree) {
-  const int lid = p_feats.HasMissing() ? tree->GetLeafIndex<true>(p_feats) :
-                                         tree->GetLeafIndex<false>(p_feats);  // 35% speed up
-  return (*tree)[lid].LeafValue();
+// traversal interface over RegTree for trees the flattened layout cannot
+// represent, matching the methods of gbm::CompactTree
+struct RegTreeView {
+  RegTree const &tree;
+
+  bool IsLeaf(bst_node_t nid) const { return tree[nid].IsLeaf(); }
+  bst_feature_t SplitIndex(bst_node_t nid) const { return tree[nid].SplitIndex(); }
+  bst_float LeafValue(bst_node_t nid) const { return tree[nid].LeafValue(); }
+  template <bool has_missing>
+  bst_node_t Next(bst_node_t nid, bst_float fvalue, bool is_unknown) const {
+    return tree.GetNext<has_missing>(nid, fvalue, is_unknown);
+  }
+};
+
+/*!
+ * \brief Walk a group of rows through one tree level by level.
+ *
+ * Each iteration advances every unfinished row by a single split, so up to
+ * kPredictLanes node fetches are in flight at once instead of the serial
+ * pointer chase of GetLeafIndex.  With dense feature vectors the split
+ * comparisons within a level are branch free and vectorize.
+ */
+template <bool has_missing, typename TreeView>
+inline void PredLeafValuesLockstep(TreeView const &tree,
+                                   const std::vector<RegTree::FVec> &thread_temp,
+                                   const size_t offset, const size_t n_rows,
+                                   bst_float *out_leaf_values) {
+  bst_node_t nidx[kPredictLanes];
+  for (size_t i = 0; i < n_rows; ++i) {
+    nidx[i] = 0;
+  }
+  bool any_active = true;
+  while (any_active) {
+    any_active = false;
+    for (size_t i = 0; i < n_rows; ++i) {
+      const bst_node_t nid = nidx[i];
+      if (!tree.IsLeaf(nid)) {
+        const RegTree::FVec &feats = thread_temp[offset + i];
+        const bst_feature_t split_index = tree.SplitIndex(nid);
+        nidx[i] = tree.template Next<has_missing>(
+            nid, feats.GetFvalue(split_index),
+            has_missing && feats.IsMissing(split_index));
+        any_active = true;
+      }
+    }
+  }
+  for (size_t i = 0; i < n_rows; ++i) {
+    out_leaf_values[i] = tree.LeafValue(nidx[i]);
+  }
+}
+
+/*!
+ * \brief Branchless traversal of a complete tree in the implicit heap layout.
+ *
+ * The depth is a compile-time constant, so the level loop fully unrolls, every
+ * row performs exactly kDepth node visits without leaf checks, and the child
+ * selection compiles to a conditional move.  Requires dense feature vectors;
+ * a missing value would need the default direction and with it a branch.
+ */
+template <int kDepth>
+inline void PredLeafValuesComplete(gbm::CompactTree const &tree,
+                                   const std::vector<RegTree::FVec> &thread_temp,
+                                   const size_t offset, const size_t n_rows,
+                                   bst_float *out_leaf_values) {
+  bst_node_t nidx[kPredictLanes];
+  for (size_t i = 0; i < n_rows; ++i) {
+    nidx[i] = 0;
+  }
+  for (int level = 0; level < kDepth; ++level) {
+    for (size_t i = 0; i < n_rows; ++i) {
+      const bst_node_t nid = nidx[i];
+      const RegTree::FVec &feats = thread_temp[offset + i];
+      nidx[i] = 2 * nid + 1 +
+                !(feats.GetFvalue(tree.SplitIndex(nid)) < tree.SplitCond(nid));
+    }
+  }
+  for (size_t i = 0; i < n_rows; ++i) {
+    out_leaf_values[i] = tree.LeafValue(nidx[i]);
+  }
 }
 
-inline void PredictByAllTrees(gbm::GBTreeModel const &model, const size_t tree_begin,
-                              const size_t tree_end, std::vector<bst_float>* out_preds,
+inline void PredLeafValuesCompleteDispatch(
+    gbm::CompactTree const &tree, const std::vector<RegTree::FVec> &thread_temp,
+    const size_t offset, const size_t n_rows, bst_float *out_leaf_values) {
+  switch (tree.CompleteDepth()) {
+    case 1: PredLeafValuesComplete<1>(tree, thread_temp, offset, n_rows, out_leaf_values); break;
+    case 2: PredLeafValuesComplete<2>(tree, thread_temp, offset, n_rows, out_leaf_values); break;
+    case 3: PredLeafValuesComplete<3>(tree, thread_temp, offset, n_rows, out_leaf_values); break;
+    case 4: PredLeafValuesComplete<4>(tree, thread_temp, offset, n_rows, out_leaf_values); break;
+    case 5: PredLeafValuesComplete<5>(tree, thread_temp, offset, n_rows, out_leaf_values); break;
+    case 6: PredLeafValuesComplete<6>(tree, thread_temp, offset, n_rows, out_leaf_values); break;
+    case 7: PredLeafValuesComplete<7>(tree, thread_temp, offset, n_rows, out_leaf_values); break;
+    case 8: PredLeafValuesComplete<8>(tree, thread_temp, offset, n_rows, out_leaf_values); break;
+    default: LOG(FATAL) << "Unexpected complete tree depth: " << tree.CompleteDepth();
+  }
+}
+
+inline void PredictLanesByOneTree(gbm::GBTreeModel const &model,
+                                  std::vector<gbm::CompactTree> const &compact_trees,
+                                  const size_t tree_id, const bool any_missing,
+                                  const std::vector<RegTree::FVec> &thread_temp,
+                                  const size_t offset, const size_t n_lanes,
+                                  bst_float *leaf_values) {
+  if (!compact_trees[tree_id].Empty()) {
+    auto const &tree = compact_trees[tree_id];
+    if (!any_missing && tree.CompleteDepth() > 0) {
+      PredLeafValuesCompleteDispatch(tree, thread_temp, offset, n_lanes, leaf_values);
+    } else if (any_missing) {
+      PredLeafValuesLockstep<true>(tree, thread_temp, offset, n_lanes, leaf_values);
+    } else {
+      PredLeafValuesLockstep<false>(tree, thread_temp, offset, n_lanes, leaf_values);
+    }
+  } else {
+    RegTreeView tree{*model.trees[tree_id]};
+    if (any_missing) {
+      PredLeafValuesLockstep<true>(tree, thread_temp, offset, n_lanes, leaf_values);
+    } else {
+      PredLeafValuesLockstep<false>(tree, thread_temp, offset, n_lanes, leaf_values);
+    }
+  }
+}
+
+inline void PredictByAllTrees(gbm::GBTreeModel const &model,
+                              std::vector<gbm::CompactTree> const &compact_trees,
+                              const size_t tree_begin, const size_t tree_end,
+                              std::vector<bst_float>* out_preds,
                               const size_t predict_offset, const size_t num_group,
                               const std::vector<RegTree::FVec> &thread_temp,
                               const size_t offset, const size_t block_size) {
+  bool any_missing = false;
+  for (size_t i = 0; i < block_size; ++i) {
+    any_missing |= thread_temp[offset + i].HasMissing();
+  }
   std::vector<bst_float> &preds = *out_preds;
-  for (size_t tree_id = tree_begin; tree_id < tree_end; ++tree_id) {
-    const size_t gid = model.tree_info[tree_id];
-    for (size_t i = 0; i < block_size; ++i) {
-      preds[(predict_offset + i) * num_group + gid] += PredValueByOneTree(thread_temp[offset + i],
-                                                                      model.trees[tree_id]);
+  bst_float leaf_values[kPredictLanes];
+  // (rows x trees) tiling: every lane tile of the row block walks one block
+  // of trees before the next block of trees is touched, so the tree nodes
+  // stay cached across lane tiles and the lane tile's feature vectors stay
+  // hot across the tree block.
+  for (size_t tree_blk = tree_begin; tree_blk < tree_end; tree_blk += kPredictTreeBlock) {
+    const size_t tree_blk_end = std::min(tree_end, tree_blk + kPredictTreeBlock);
+    for (size_t i = 0; i < block_size; i += kPredictLanes) {
+      const size_t n_lanes = std::min(kPredictLanes, block_size - i);
+      for (size_t tree_id = tree_blk; tree_id < tree_blk_end; ++tree_id) {
+        PredictLanesByOneTree(model, compact_trees, tree_id, any_missing,
+                              thread_temp, offset + i, n_lanes, leaf_values);
+        const size_t gid = model.tree_info[tree_id];
+        for (size_t j = 0; j < n_lanes; ++j) {
+          preds[(predict_offset + i + j) * num_group + gid] += leaf_values[j];
+        }
+      }
+    }
+  }
+}
+
+// Feature lookup over a row's entries, kept sorted by feature index.  For a
+// row of a handful of entries the whole search stays within one or two cache
+// lines, where the dense FVec array scatters across a line per entry.
+inline bst_float SparseRowFvalue(SparsePage::Inst const &row, bst_feature_t fid,
+                                 bool *is_missing) {
+  auto const *end = row.data() + row.size();
+  auto const *it = std::lower_bound(
+      row.data(), end, fid,
+      [](Entry const &e, bst_feature_t f) { return e.index < f; });
+  if (it != end && it->index == fid) {
+    *is_missing = false;
+    return it->fvalue;
+  }
+  *is_missing = true;
+  return std::numeric_limits<bst_float>::quiet_NaN();
+}
+
+// Sparse counterpart of PredLeafValuesLockstep reading the rows directly;
+// absent features are always possible, so the traversal is the has_missing
+// variant by construction.
+template <typename TreeView>
+inline void PredLeafValuesLockstepSparse(TreeView const &tree,
+                                         SparsePage::Inst const *rows,
+                                         const size_t n_rows,
+                                         bst_float *out_leaf_values) {
+  bst_node_t nidx[kPredictLanes];
+  for (size_t i = 0; i < n_rows; ++i) {
+    nidx[i] = 0;
+  }
+  bool any_active = true;
+  while (any_active) {
+    any_active = false;
+    for (size_t i = 0; i < n_rows; ++i) {
+      const bst_node_t nid = nidx[i];
+      if (!tree.IsLeaf(nid)) {
+        bool is_missing = false;
+        const bst_float fvalue =
+            SparseRowFvalue(rows[i], tree.SplitIndex(nid), &is_missing);
+        nidx[i] = tree.template Next<true>(nid, fvalue, is_missing);
+        any_active = true;
+      }
+    }
+  }
+  for (size_t i = 0; i < n_rows; ++i) {
+    out_leaf_values[i] = tree.LeafValue(nidx[i]);
+  }
+}
+
+inline void PredictSparseByAllTrees(gbm::GBTreeModel const &model,
+                                    std::vector<gbm::CompactTree> const &compact_trees,
+                                    const size_t tree_begin, const size_t tree_end,
+                                    std::vector<bst_float> *out_preds,
+                                    const size_t predict_offset,
+                                    const size_t num_group,
+                                    SparsePage::Inst const *rows,
+                                    const size_t block_size) {
+  std::vector<bst_float> &preds = *out_preds;
+  bst_float leaf_values[kPredictLanes];
+  // same (rows x trees) tiling as PredictByAllTrees
+  for (size_t tree_blk = tree_begin; tree_blk < tree_end; tree_blk += kPredictTreeBlock) {
+    const size_t tree_blk_end = std::min(tree_end, tree_blk + kPredictTreeBlock);
+    for (size_t i = 0; i < block_size; i += kPredictLanes) {
+      const size_t n_lanes = std::min(kPredictLanes, block_size - i);
+      for (size_t tree_id = tree_blk; tree_id < tree_blk_end; ++tree_id) {
+        if (!compact_trees[tree_id].Empty()) {
+          PredLeafValuesLockstepSparse(compact_trees[tree_id], rows + i,
+                                       n_lanes, leaf_values);
+        } else {
+          RegTreeView tree{*model.trees[tree_id]};
+          PredLeafValuesLockstepSparse(tree, rows + i, n_lanes, leaf_values);
+        }
+        const size_t gid = model.tree_info[tree_id];
+        for (size_t j = 0; j < n_lanes; ++j) {
+          preds[(predict_offset + i + j) * num_group + gid] += leaf_values[j];
+        }
+      }
     }
   }
 }
 
 template <typename DataView>
 void FVecFill(const size_t block_size, const size_t batch_offset, DataView* batch,
-              const size_t fvec_offset, std::vector<RegTree::FVec>* p_feats) {
+              const size_t fvec_offset, const size_t tid,
+              std::vector<RegTree::FVec>* p_feats) {
   for (size_t i = 0; i < block_size; ++i) {
     RegTree::FVec &feats = (*p_feats)[fvec_offset + i];
-    const SparsePage::Inst inst = (*batch)[batch_offset + i];
+    const SparsePage::Inst inst = batch->GetRow(batch_offset + i, tid);
     feats.Fill(inst);
   }
 }
 template <typename DataView>
 void FVecDrop(const size_t block_size, const size_t batch_offset, DataView* batch,
-              const size_t fvec_offset, std::vector<RegTree::FVec>* p_feats) {
+              const size_t fvec_offset, const size_t tid,
+              std::vector<RegTree::FVec>* p_feats) {
   for (size_t i = 0; i < block_size; ++i) {
     RegTree::FVec &feats = (*p_feats)[fvec_offset + i];
-    const SparsePage::Inst inst = (*batch)[batch_offset + i];
+    const SparsePage::Inst inst = batch->GetRow(batch_offset + i, tid);
     feats.Drop(inst);
   }
 }
@@ -88,12 +306,14 @@ struct SparsePageView {
   bst_row_t base_rowid;
   HostSparsePageView view;
   static size_t constexpr kUnroll = kUnrollLen;
+  // rows point into the page, so a block of them can be held at once
+  static bool constexpr kStableRows = true;
 
   explicit SparsePageView(SparsePage const *p)
       : base_rowid{p->base_rowid} {
     view = p->GetView();
   }
-  SparsePage::Inst operator[](size_t i) { return view[i]; }
+  SparsePage::Inst GetRow(size_t i, size_t) { return view[i]; }
   size_t Size() const { return view.Size(); }
 };
 
@@ -106,17 +326,19 @@ class AdapterView {
 
  public:
   static size_t constexpr kUnroll = kUnrollLen;
+  // GetRow recycles the workspace every kUnroll rows, rows cannot be held
+  static bool constexpr kStableRows = false;
 
  public:
   explicit AdapterView(Adapter *adapter, float missing,
                        common::Span<Entry> workplace)
       : adapter_{adapter}, missing_{missing}, workspace_{workplace},
         current_unroll_(omp_get_max_threads() > 0 ? omp_get_max_threads() : 1, 0) {}
-  SparsePage::Inst operator[](size_t i) {
+  // `t` is the executing worker id; pool workers have no OpenMP thread id.
+  SparsePage::Inst GetRow(size_t i, size_t t) {
     bst_feature_t columns = adapter_->NumColumns();
     auto const &batch = adapter_->Value();
     auto row = batch.GetLine(i);
-    auto t = omp_get_thread_num();
     auto const beg = (columns * kUnroll * t) + (current_unroll_[t] * columns);
     size_t non_missing {beg};
     for (size_t c = 0; c < row.Size(); ++c) {
@@ -144,27 +366,72 @@ template <typename DataView, size_t block_of_rows_size>
 void PredictBatchByBlockOfRowsKernel(DataView batch, std::vector<bst_float> *out_preds,
                                      gbm::GBTreeModel const &model, int32_t tree_begin,
                                      int32_t tree_end,
-                                     std::vector<RegTree::FVec> *p_thread_temp) {
+                                     std::vector<RegTree::FVec> *p_thread_temp,
+                                     common::WorkStealingThreadPool *pool,
+                                     std::function<void(size_t, size_t)> const *on_range =
+                                         nullptr) {
   auto& thread_temp = *p_thread_temp;
   int32_t const num_group = model.learner_model_param->num_output_group;
 
   CHECK_EQ(model.param.size_leaf_vector, 0)
       << "size_leaf_vector is enforced to 0 so far";
-  // parallel over local batch
-  const auto nsize = static_cast<bst_omp_uint>(batch.Size());
+  // flattened layout is built once, before the parallel region
+  auto const &compact_trees = model.CompactTrees();
+  const auto nsize = static_cast<size_t>(batch.Size());
+  const size_t n_row_blocks = nsize / block_of_rows_size + !!(nsize % block_of_rows_size);
 
-  const bst_omp_uint n_row_blocks = (nsize) / block_of_rows_size + !!((nsize) % block_of_rows_size);
-#pragma omp parallel for schedule(static)
-  for (bst_omp_uint block_id = 0; block_id < n_row_blocks; ++block_id) {
+  // A block qualifies for the sparse-native path when every one of its rows
+  // is small and sorted by feature index; one oversized or unsorted row sends
+  // the whole block through the dense staging so the lockstep lanes stay
+  // uniform.  Small feature spaces keep the dense path, their staging array
+  // is cache resident anyway.
+  size_t const sparse_max_nnz =
+      DataView::kStableRows &&
+              model.learner_model_param->num_feature > 4 * SparsePredictMaxNnz()
+          ? SparsePredictMaxNnz()
+          : 0;
+
+  auto predict_block = [&](size_t worker_id, size_t block_id) {
     const size_t batch_offset = block_id * block_of_rows_size;
     const size_t block_size = std::min(nsize - batch_offset, block_of_rows_size);
-    const size_t fvec_offset = omp_get_thread_num() * block_of_rows_size;
+    const size_t fvec_offset = worker_id * block_of_rows_size;
 
-    FVecFill(block_size, batch_offset, &batch, fvec_offset, p_thread_temp);
-    // process block of rows through all trees to keep cache locality
-    PredictByAllTrees(model, tree_begin, tree_end, out_preds, batch_offset + batch.base_rowid,
-                      num_group, thread_temp, fvec_offset, block_size);
-    FVecDrop(block_size, batch_offset, &batch, fvec_offset, p_thread_temp);
+    SparsePage::Inst rows[block_of_rows_size];
+    bool sparse = sparse_max_nnz != 0;
+    for (size_t i = 0; i < block_size && sparse; ++i) {
+      rows[i] = batch.GetRow(batch_offset + i, worker_id);
+      sparse = rows[i].size() <= sparse_max_nnz &&
+               std::is_sorted(rows[i].data(), rows[i].data() + rows[i].size(),
+                              [](Entry const &a, Entry const &b) {
+                                return a.index < b.index;
+                              });
+    }
+    if (sparse) {
+      // rows stay in their compact form, no fill/drop cycle
+      PredictSparseByAllTrees(model, compact_trees, tree_begin, tree_end,
+                              out_preds, batch_offset + batch.base_rowid,
+                              num_group, rows, block_size);
+    } else {
+      FVecFill(block_size, batch_offset, &batch, fvec_offset, worker_id, p_thread_temp);
+      // process block of rows through all trees to keep cache locality
+      PredictByAllTrees(model, compact_trees, tree_begin, tree_end, out_preds,
+                        batch_offset + batch.base_rowid, num_group, thread_temp, fvec_offset,
+                        block_size);
+      FVecDrop(block_size, batch_offset, &batch, fvec_offset, worker_id, p_thread_temp);
+    }
+    if (on_range) {
+      // predictions for this block are final; hand them over while hot
+      (*on_range)(batch_offset + batch.base_rowid,
+                  batch_offset + batch.base_rowid + block_size);
+    }
+  };
+  if (n_row_blocks <= 1) {
+    // tiny batch: waking the pool costs more than the traversal itself
+    for (size_t block_id = 0; block_id < n_row_blocks; ++block_id) {
+      predict_block(0, block_id);
+    }
+  } else {
+    pool->Execute(n_row_blocks, predict_block);
   }
 }
 
@@ -181,13 +448,43 @@ class CPUPredictor : public Predictor {
     }
   }
 
+  // Restrict row staging to the features the model actually splits on; wide
+  // deployments often test only a small fraction of their columns.  Must be
+  // refreshed on every entry as the bitmap storage moves when the model
+  // gains trees.
+  static void SetUsedFeatures(gbm::GBTreeModel const &model,
+                              std::vector<RegTree::FVec> *out) {
+    auto const &used = model.UsedFeatures();
+    size_t const n_used = model.NumUsedFeatures();
+    common::Span<uint32_t const> filter{used};
+    if (n_used == model.learner_model_param->num_feature) {
+      // every feature is tested, skip the per-entry bitmap checks
+      filter = {};
+    }
+    for (auto &feats : *out) {
+      feats.SetFilter(filter, n_used);
+    }
+  }
+
+  // Lazily sized executor for batch inference.  Workers persist between
+  // calls, so repeated small predictions skip the OpenMP region startup that
+  // otherwise dominates their latency.  Must be called with lock_ held.
+  common::WorkStealingThreadPool *Executor(int threads) const {
+    if (!pool_ || pool_->NumWorkers() != static_cast<size_t>(threads)) {
+      pool_.reset(new common::WorkStealingThreadPool(threads));
+    }
+    return pool_.get();
+  }
+
   void PredictDMatrix(DMatrix *p_fmat, std::vector<bst_float> *out_preds,
                       gbm::GBTreeModel const &model, int32_t tree_begin,
-                      int32_t tree_end) {
+                      int32_t tree_end,
+                      std::function<void(size_t, size_t)> const *on_range = nullptr) {
     std::lock_guard<std::mutex> guard(lock_);
     const int threads = omp_get_max_threads();
     InitThreadTemp(threads*kBlockOfRowsSize, model.learner_model_param->num_feature,
                    &this->thread_temp_);
+    SetUsedFeatures(model, &this->thread_temp_);
     for (auto const& batch : p_fmat->GetBatches<SparsePage>()) {
       CHECK_EQ(out_preds->size(),
                p_fmat->Info().num_row_ * model.learner_model_param->num_output_group);
@@ -195,7 +492,8 @@ class CPUPredictor : public Predictor {
       PredictBatchByBlockOfRowsKernel<SparsePageView<kUnroll>,
                           kBlockOfRowsSize>(SparsePageView<kUnroll>{&batch},
                                               out_preds, model, tree_begin,
-                                              tree_end, &thread_temp_);
+                                              tree_end, &thread_temp_,
+                                              this->Executor(threads), on_range);
     }
   }
 
@@ -239,6 +537,22 @@ class CPUPredictor : public Predictor {
   void PredictBatch(DMatrix* dmat, PredictionCacheEntry* predts,
                     const gbm::GBTreeModel& model, int tree_begin,
                     uint32_t const ntree_limit = 0) override {
+    this->PredictBatchImpl(dmat, predts, model, tree_begin, ntree_limit, nullptr);
+  }
+
+  bool PredictBatchRanged(
+      DMatrix* dmat, PredictionCacheEntry* predts, const gbm::GBTreeModel& model,
+      int tree_begin,
+      std::function<void(std::size_t, std::size_t)> const& on_range) override {
+    this->PredictBatchImpl(dmat, predts, model, tree_begin, 0, &on_range);
+    return true;
+  }
+
+ private:
+  void PredictBatchImpl(DMatrix* dmat, PredictionCacheEntry* predts,
+                        const gbm::GBTreeModel& model, int tree_begin,
+                        uint32_t const ntree_limit,
+                        std::function<void(size_t, size_t)> const* on_range) {
     // tree_begin is not used, right now we just enforce it to be 0.
     CHECK_EQ(tree_begin, 0);
     auto* out_preds = &predts->predictions;
@@ -274,7 +588,11 @@ class CPUPredictor : public Predictor {
     if (beg_version < end_version) {
       this->PredictDMatrix(dmat, &out_preds->HostVector(), model,
                            beg_version * output_groups,
-                           end_version * output_groups);
+                           end_version * output_groups, on_range);
+    } else if (on_range) {
+      // nothing to traverse (e.g. no trees built yet); the cached predictions
+      // are already final, report them as a single range
+      (*on_range)(0, dmat->Info().num_row_);
     }
 
     // delta means {size of forest} * {number of newly accumulated layers}
@@ -286,6 +604,8 @@ class CPUPredictor : public Predictor {
           out_preds->Size() == dmat->Info().num_row_);
   }
 
+ public:
+
   template <typename Adapter>
   void DispatchedInplacePredict(dmlc::any const &x,
                                 const gbm::GBTreeModel &model, float missing,
@@ -299,15 +619,24 @@ class CPUPredictor : public Predictor {
     info.num_col_ = m->NumColumns();
     info.num_row_ = m->NumRows();
     this->InitOutPredictions(info, &(out_preds->predictions), model);
-    std::vector<Entry> workspace(info.num_col_ * 8 * threads);
+    // Reuse the predictor owned staging buffers between calls: online scorers
+    // issue many small predictions and reallocating the workspace and the
+    // thread local feature vectors dominated their latency.
+    std::lock_guard<std::mutex> guard(lock_);
+    const size_t workspace_size = info.num_col_ * 8 * threads;
+    if (inplace_workspace_.size() < workspace_size) {
+      inplace_workspace_.resize(workspace_size);
+    }
     auto &predictions = out_preds->predictions.HostVector();
-    std::vector<RegTree::FVec> thread_temp;
     InitThreadTemp(threads*kBlockOfRowsSize, model.learner_model_param->num_feature,
-                   &thread_temp);
+                   &this->thread_temp_);
+    SetUsedFeatures(model, &this->thread_temp_);
     PredictBatchByBlockOfRowsKernel<AdapterView<Adapter>,
                        kBlockOfRowsSize>(AdapterView<Adapter>(
-                                          m.get(), missing, common::Span<Entry>{workspace}),
-                                          &predictions, model, tree_begin, tree_end, &thread_temp);
+                                          m.get(), missing, common::Span<Entry>{inplace_workspace_}),
+                                          &predictions, model, tree_begin, tree_end,
+                                          &this->thread_temp_,
+                                          this->Executor(threads));
   }
 
   void InplacePredict(dmlc::any const &x, const gbm::GBTreeModel &model,
@@ -326,29 +655,43 @@ class CPUPredictor : public Predictor {
 
   void PredictInstance(const SparsePage::Inst& inst,
                        std::vector<bst_float>* out_preds,
-                       const gbm::GBTreeModel& model, unsigned ntree_limit) override {
-    if (thread_temp_.size() == 0) {
-      thread_temp_.resize(1, RegTree::FVec());
-      thread_temp_[0].Init(model.learner_model_param->num_feature);
+                       const gbm::GBTreeModel& model, unsigned ntree_limit,
+                       bst_float decision_threshold) override {
+    // persistent staging slot for the single row, one per calling thread
+    thread_local RegTree::FVec feats;
+    if (feats.Size() < model.learner_model_param->num_feature) {
+      feats.Init(model.learner_model_param->num_feature);
     }
-    ntree_limit *= model.learner_model_param->num_output_group;
+    feats.SetFilter(common::Span<uint32_t const>{model.UsedFeatures()},
+                    model.NumUsedFeatures());
+    const uint32_t num_group = model.learner_model_param->num_output_group;
+    ntree_limit *= num_group;
     if (ntree_limit == 0 || ntree_limit > model.trees.size()) {
       ntree_limit = static_cast<unsigned>(model.trees.size());
     }
-    out_preds->resize(model.learner_model_param->num_output_group *
-                      (model.param.size_leaf_vector + 1));
-    // loop over output groups
-    for (uint32_t gid = 0; gid < model.learner_model_param->num_output_group; ++gid) {
-      (*out_preds)[gid] = PredValue(inst, model.trees, model.tree_info, gid,
-                                    &thread_temp_[0], 0, ntree_limit) +
-                          model.learner_model_param->base_score;
+    std::vector<bst_float>& preds = *out_preds;
+    preds.resize(num_group * (model.param.size_leaf_vector + 1));
+    std::fill_n(preds.begin(), num_group, model.learner_model_param->base_score);
+    // the early exit is only meaningful for a single accumulated margin
+    const bool check_threshold = !common::CheckNAN(decision_threshold) && num_group == 1;
+    // stage the row once and walk every tree, instead of refilling per group
+    feats.Fill(inst);
+    for (unsigned i = 0; i < ntree_limit; ++i) {
+      const int gid = model.tree_info[i];
+      const int lid = model.trees[i]->GetLeafIndex(feats);
+      preds[gid] += (*model.trees[i])[lid].LeafValue();
+      if (check_threshold && preds[0] > decision_threshold) {
+        break;
+      }
     }
+    feats.Drop(inst);
   }
 
   void PredictLeaf(DMatrix* p_fmat, HostDeviceVector<bst_float>* out_preds,
                    const gbm::GBTreeModel& model, unsigned ntree_limit) override {
     const int nthread = omp_get_max_threads();
     InitThreadTemp(nthread, model.learner_model_param->num_feature, &this->thread_temp_);
+    SetUsedFeatures(model, &this->thread_temp_);
     const MetaInfo& info = p_fmat->Info();
     // number of valid trees
     ntree_limit *= model.learner_model_param->num_output_group;
@@ -376,13 +719,134 @@ class CPUPredictor : public Predictor {
     }
   }
 
+  bool PredictLeafInt32(DMatrix* p_fmat, common::Span<bst_node_t> out_indices,
+                        const gbm::GBTreeModel& model, unsigned ntree_limit) override {
+    const int nthread = omp_get_max_threads();
+    InitThreadTemp(nthread * kBlockOfRowsSize, model.learner_model_param->num_feature,
+                   &this->thread_temp_);
+    SetUsedFeatures(model, &this->thread_temp_);
+    const MetaInfo& info = p_fmat->Info();
+    // number of valid trees
+    ntree_limit *= model.learner_model_param->num_output_group;
+    if (ntree_limit == 0 || ntree_limit > model.trees.size()) {
+      ntree_limit = static_cast<unsigned>(model.trees.size());
+    }
+    CHECK_EQ(out_indices.size(), info.num_row_ * ntree_limit)
+        << "Leaf index buffer must hold num_row * number of used trees entries.";
+    bst_node_t* out = out_indices.data();
+    // Stage a block of rows once, then walk the trees in blocks over the
+    // staged rows: with thousands of trees the nodes of one tree block stay
+    // cached across the whole row block, while every row still owns one
+    // contiguous int32 segment of the output.
+    size_t constexpr kBlockOfTreesSize = 256;
+    for (const auto &batch : p_fmat->GetBatches<SparsePage>()) {
+      const auto nsize = static_cast<size_t>(batch.Size());
+      const auto nblock = static_cast<bst_omp_uint>(
+          nsize / kBlockOfRowsSize + !!(nsize % kBlockOfRowsSize));
+#pragma omp parallel for schedule(static)
+      for (bst_omp_uint block = 0; block < nblock; ++block) {
+        const size_t row_begin = block * kBlockOfRowsSize;
+        const size_t row_end = std::min(row_begin + kBlockOfRowsSize, nsize);
+        RegTree::FVec* feats =
+            &thread_temp_[omp_get_thread_num() * kBlockOfRowsSize];
+        for (size_t i = row_begin; i < row_end; ++i) {
+          feats[i - row_begin].Fill(batch[i]);
+        }
+        for (size_t tree_begin = 0; tree_begin < ntree_limit;
+             tree_begin += kBlockOfTreesSize) {
+          const size_t tree_end = std::min(tree_begin + kBlockOfTreesSize,
+                                           static_cast<size_t>(ntree_limit));
+          for (size_t i = row_begin; i < row_end; ++i) {
+            const size_t ridx = batch.base_rowid + i;
+            bst_node_t* row_out = out + ridx * ntree_limit;
+            RegTree::FVec& f = feats[i - row_begin];
+            for (size_t j = tree_begin; j < tree_end; ++j) {
+              row_out[j] = model.trees[j]->GetLeafIndex(f);
+            }
+          }
+        }
+        for (size_t i = row_begin; i < row_end; ++i) {
+          feats[i - row_begin].Drop(batch[i]);
+        }
+      }
+    }
+    return true;
+  }
+
+  bool PredictLeafStats(DMatrix* p_fmat, std::vector<bst_float>* out_stats,
+                        const gbm::GBTreeModel& model,
+                        unsigned ntree_limit) override {
+    const int nthread = omp_get_max_threads();
+    InitThreadTemp(nthread, model.learner_model_param->num_feature, &this->thread_temp_);
+    SetUsedFeatures(model, &this->thread_temp_);
+    const MetaInfo& info = p_fmat->Info();
+    // number of valid trees
+    ntree_limit *= model.learner_model_param->num_output_group;
+    if (ntree_limit == 0 || ntree_limit > model.trees.size()) {
+      ntree_limit = static_cast<unsigned>(model.trees.size());
+    }
+    // every tree gets a segment sized by the largest tree, so a slot is
+    // addressed without per-tree offset lookups in the inner loop
+    size_t stride = 0;
+    for (unsigned j = 0; j < ntree_limit; ++j) {
+      stride = std::max(stride, static_cast<size_t>(model.trees[j]->param.num_nodes));
+    }
+    size_t constexpr kStatsPerNode = 3;  // row count, label sum, weight sum
+    const size_t total = ntree_limit * stride * kStatsPerNode;
+    const auto& labels = info.labels_.HostVector();
+    const auto& weights = info.weights_.HostVector();
+    // per-thread double accumulators, reduced once at the end; leaf sums over
+    // millions of rows overflow float precision long before they fill memory
+    std::vector<std::vector<double>> thread_stats(nthread);
+    for (const auto& batch : p_fmat->GetBatches<SparsePage>()) {
+      const auto nsize = static_cast<bst_omp_uint>(batch.Size());
+#pragma omp parallel for schedule(static)
+      for (bst_omp_uint i = 0; i < nsize; ++i) {
+        const int tid = omp_get_thread_num();
+        auto& acc = thread_stats[tid];
+        if (acc.empty()) {
+          acc.resize(total, 0.0);
+        }
+        const auto ridx = static_cast<size_t>(batch.base_rowid + i);
+        const double label = ridx < labels.size() ? labels[ridx] : 0.0;
+        const double weight = weights.empty() ? 1.0 : weights[ridx];
+        RegTree::FVec& feats = thread_temp_[tid];
+        feats.Fill(batch[i]);
+        for (unsigned j = 0; j < ntree_limit; ++j) {
+          const int nid = model.trees[j]->GetLeafIndex(feats);
+          double* slot = &acc[(j * stride + nid) * kStatsPerNode];
+          slot[0] += 1.0;
+          slot[1] += label;
+          slot[2] += weight;
+        }
+        feats.Drop(batch[i]);
+      }
+    }
+    out_stats->clear();
+    out_stats->resize(total, 0.0f);
+    auto& out = *out_stats;
+#pragma omp parallel for schedule(static)
+    for (bst_omp_uint k = 0; k < static_cast<bst_omp_uint>(total); ++k) {
+      double sum = 0.0;
+      for (const auto& acc : thread_stats) {
+        if (!acc.empty()) {
+          sum += acc[k];
+        }
+      }
+      out[k] = static_cast<bst_float>(sum);
+    }
+    return true;
+  }
+
   void PredictContribution(DMatrix* p_fmat, HostDeviceVector<float>* out_contribs,
                            const gbm::GBTreeModel& model, uint32_t ntree_limit,
                            std::vector<bst_float>* tree_weights,
                            bool approximate, int condition,
                            unsigned condition_feature) override {
     const int nthread = omp_get_max_threads();
-    InitThreadTemp(nthread,  model.learner_model_param->num_feature, &this->thread_temp_);
+    InitThreadTemp(nthread * kBlockOfRowsSize, model.learner_model_param->num_feature,
+                   &this->thread_temp_);
+    SetUsedFeatures(model, &this->thread_temp_);
     const MetaInfo& info = p_fmat->Info();
     // number of valid trees
     ntree_limit *= model.learner_model_param->num_output_group;
@@ -405,44 +869,87 @@ class CPUPredictor : public Predictor {
       model.trees[i]->FillNodeMeanValues();
     }
     const std::vector<bst_float>& base_margin = info.base_margin_.HostVector();
+    if (approximate && condition == 0) {
+      // conservative estimate of how far the mean-value deltas can deviate
+      // from exact TreeSHAP: one split's attribution is off by at most the
+      // gap between its sibling subtree means
+      double bound = 0;
+      for (unsigned j = 0; j < ntree_limit; ++j) {
+        bound += model.trees[j]->MaxSiblingMeanDelta() *
+                 (tree_weights == nullptr ? 1 : (*tree_weights)[j]);
+      }
+      LOG(INFO) << "Approximate contributions: per-feature deviation from "
+                << "exact SHAP is bounded by roughly " << bound
+                << " in the worst case.";
+    }
+    // Per-thread scratch sized once: a path stack big enough for the deepest
+    // tree and a staging buffer for one tree's contributions.  The per-row
+    // allocations and per-call tree depth walks of the naive loop dominate
+    // batch SHAP otherwise.
+    size_t max_path_size = 0;
+    for (unsigned j = 0; j < ntree_limit; ++j) {
+      max_path_size = std::max(max_path_size, model.trees[j]->PathScratchSize());
+    }
+    std::vector<std::vector<PathElement>> path_scratch(
+        nthread, std::vector<PathElement>(max_path_size));
+    std::vector<std::vector<bst_float>> contrib_scratch(
+        nthread, std::vector<bst_float>(ncolumns));
     // start collecting the contributions
     for (const auto &batch : p_fmat->GetBatches<SparsePage>()) {
-      // parallel over local batch
-      const auto nsize = static_cast<bst_omp_uint>(batch.Size());
+      const auto nsize = batch.Size();
+      const auto n_blocks = static_cast<bst_omp_uint>(
+          nsize / kBlockOfRowsSize + !!(nsize % kBlockOfRowsSize));
+      // parallel over (row block) tiles of the local batch
 #pragma omp parallel for schedule(static)
-      for (bst_omp_uint i = 0; i < nsize; ++i) {
-        auto row_idx = static_cast<size_t>(batch.base_rowid + i);
-        RegTree::FVec &feats = thread_temp_[omp_get_thread_num()];
-        std::vector<bst_float> this_tree_contribs(ncolumns);
-        // loop over all classes
-        for (int gid = 0; gid < ngroup; ++gid) {
-          bst_float* p_contribs = &contribs[(row_idx * ngroup + gid) * ncolumns];
-          feats.Fill(batch[i]);
-          // calculate contributions
-          for (unsigned j = 0; j < ntree_limit; ++j) {
-            std::fill(this_tree_contribs.begin(), this_tree_contribs.end(), 0);
-            if (model.tree_info[j] != gid) {
-              continue;
-            }
+      for (bst_omp_uint block = 0; block < n_blocks; ++block) {
+        const int tid = omp_get_thread_num();
+        const size_t batch_offset = block * kBlockOfRowsSize;
+        const size_t block_size = std::min(kBlockOfRowsSize, nsize - batch_offset);
+        const size_t fvec_offset = static_cast<size_t>(tid) * kBlockOfRowsSize;
+        for (size_t i = 0; i < block_size; ++i) {
+          thread_temp_[fvec_offset + i].Fill(batch[batch_offset + i]);
+        }
+        std::vector<bst_float>& this_tree_contribs = contrib_scratch[tid];
+        // tree-major over the row tile keeps one tree's nodes, mean values and
+        // path stack hot while it serves every row of the tile
+        for (unsigned j = 0; j < ntree_limit; ++j) {
+          const int gid = model.tree_info[j];
+          const bst_float w = tree_weights == nullptr ? 1 : (*tree_weights)[j];
+          for (size_t i = 0; i < block_size; ++i) {
+            const size_t row_idx = batch.base_rowid + batch_offset + i;
+            bst_float* p_contribs = &contribs[(row_idx * ngroup + gid) * ncolumns];
             if (!approximate) {
-              model.trees[j]->CalculateContributions(feats, &this_tree_contribs[0],
-                                                     condition, condition_feature);
+              std::fill(this_tree_contribs.begin(), this_tree_contribs.end(), 0);
+              model.trees[j]->CalculateContributions(
+                  thread_temp_[fvec_offset + i], &this_tree_contribs[0],
+                  condition, condition_feature, path_scratch[tid].data());
+              for (size_t ci = 0 ; ci < ncolumns ; ++ci) {
+                p_contribs[ci] += this_tree_contribs[ci] * w;
+              }
             } else {
-              model.trees[j]->CalculateContributionsApprox(feats, &this_tree_contribs[0]);
-            }
-            for (size_t ci = 0 ; ci < ncolumns ; ++ci) {
-                p_contribs[ci] += this_tree_contribs[ci] *
-                    (tree_weights == nullptr ? 1 : (*tree_weights)[j]);
+              // the approximate method only touches the decision path, so it
+              // accumulates scaled deltas directly instead of staging a
+              // feature-wide buffer per tree
+              model.trees[j]->CalculateContributionsApprox(
+                  thread_temp_[fvec_offset + i], p_contribs, w);
             }
           }
-          feats.Drop(batch[i]);
-          // add base margin to BIAS
-          if (base_margin.size() != 0) {
-            p_contribs[ncolumns - 1] += base_margin[row_idx * ngroup + gid];
-          } else {
-            p_contribs[ncolumns - 1] += model.learner_model_param->base_score;
+        }
+        // add base margin to BIAS
+        for (size_t i = 0; i < block_size; ++i) {
+          const size_t row_idx = batch.base_rowid + batch_offset + i;
+          for (int gid = 0; gid < ngroup; ++gid) {
+            bst_float* p_contribs = &contribs[(row_idx * ngroup + gid) * ncolumns];
+            if (base_margin.size() != 0) {
+              p_contribs[ncolumns - 1] += base_margin[row_idx * ngroup + gid];
+            } else {
+              p_contribs[ncolumns - 1] += model.learner_model_param->base_score;
+            }
           }
         }
+        for (size_t i = 0; i < block_size; ++i) {
+          thread_temp_[fvec_offset + i].Drop(batch[batch_offset + i]);
+        }
       }
     }
   }
@@ -458,52 +965,273 @@ class CPUPredictor : public Predictor {
     const unsigned mrow_chunk = (ncolumns + 1) * (ncolumns + 1);
     const unsigned crow_chunk = ngroup * (ncolumns + 1);
 
-    // allocate space for (number of features^2) times the number of rows and tmp off/on contribs
     std::vector<bst_float>& contribs = out_contribs->HostVector();
-    contribs.resize(info.num_row_ * ngroup * (ncolumns + 1) * (ncolumns + 1));
-    HostDeviceVector<bst_float> contribs_off_hdv(info.num_row_ * ngroup * (ncolumns + 1));
-    auto &contribs_off = contribs_off_hdv.HostVector();
-    HostDeviceVector<bst_float> contribs_on_hdv(info.num_row_ * ngroup * (ncolumns + 1));
-    auto &contribs_on = contribs_on_hdv.HostVector();
-    HostDeviceVector<bst_float> contribs_diag_hdv(info.num_row_ * ngroup * (ncolumns + 1));
-    auto &contribs_diag = contribs_diag_hdv.HostVector();
+    contribs.resize(info.num_row_ * row_chunk);
+    std::fill(contribs.begin(), contribs.end(), 0);
 
-    // Compute the difference in effects when conditioning on each of the features on and off
-    // see: Axiomatic characterizations of probabilistic and
-    //      cardinal-probabilistic interaction indices
+    // additive effects fill the diagonal
+    HostDeviceVector<bst_float> contribs_diag_hdv(info.num_row_ * crow_chunk);
+    auto &contribs_diag = contribs_diag_hdv.HostVector();
     PredictContribution(p_fmat, &contribs_diag_hdv, model, ntree_limit,
                         tree_weights, approximate, 0, 0);
-    for (size_t i = 0; i < ncolumns + 1; ++i) {
-      PredictContribution(p_fmat, &contribs_off_hdv, model, ntree_limit,
-                          tree_weights, approximate, -1, i);
-      PredictContribution(p_fmat, &contribs_on_hdv, model, ntree_limit,
-                          tree_weights, approximate, 1, i);
-
-      for (size_t j = 0; j < info.num_row_; ++j) {
-        for (int l = 0; l < ngroup; ++l) {
-          const unsigned o_offset = j * row_chunk + l * mrow_chunk + i * (ncolumns + 1);
-          const unsigned c_offset = j * crow_chunk + l * (ncolumns + 1);
-          contribs[o_offset + i] = 0;
+
+    unsigned real_ntree = ntree_limit * ngroup;
+    if (real_ntree == 0 || real_ntree > model.trees.size()) {
+      real_ntree = static_cast<unsigned>(model.trees.size());
+    }
+
+    // The interaction of feature pair (i, k) is the difference between the
+    // contributions of k conditioned on i being on and off, see: Axiomatic
+    // characterizations of probabilistic and cardinal-probabilistic
+    // interaction indices.  Trees that never split on i contribute equally to
+    // both conditioned passes, so only the trees that use i are walked; the
+    // conditioning loop can further be restricted to a comma-separated
+    // feature list in XGBOOST_SHAP_INTERACTION_FEATURES, leaving the rows of
+    // all other features zero off the diagonal.  The approximate method
+    // ignores the condition entirely and reports only the diagonal.
+    std::vector<char> include(ncolumns, 1);
+    auto const subset = dmlc::GetEnv("XGBOOST_SHAP_INTERACTION_FEATURES",
+                                     std::string{});
+    if (!subset.empty()) {
+      std::fill(include.begin(), include.end(), 0);
+      for (auto const& tok : common::Split(subset, ',')) {
+        auto const fidx = std::stoul(tok);
+        CHECK_LT(fidx, ncolumns) << "Invalid feature index in "
+                                 << "XGBOOST_SHAP_INTERACTION_FEATURES";
+        include[fidx] = 1;
+      }
+    }
+    std::vector<std::vector<bst_feature_t>> tree_features(real_ntree);
+    if (!approximate) {
+      std::vector<char> seen(ncolumns);
+      for (unsigned j = 0; j < real_ntree; ++j) {
+        std::fill(seen.begin(), seen.end(), 0);
+        for (auto const& node : model.trees[j]->GetNodes()) {
+          if (node.IsDeleted() || node.IsLeaf()) {
+            continue;
+          }
+          auto const fidx = node.SplitIndex();
+          if (include[fidx] && !seen[fidx]) {
+            seen[fidx] = 1;
+            tree_features[j].push_back(fidx);
+          }
+        }
+      }
+    }
+
+    const int nthread = omp_get_max_threads();
+    InitThreadTemp(nthread * kBlockOfRowsSize, model.learner_model_param->num_feature,
+                   &this->thread_temp_);
+    SetUsedFeatures(model, &this->thread_temp_);
+    size_t max_path_size = 0;
+    for (unsigned j = 0; j < real_ntree; ++j) {
+      max_path_size = std::max(max_path_size, model.trees[j]->PathScratchSize());
+    }
+    std::vector<std::vector<PathElement>> path_scratch(
+        nthread, std::vector<PathElement>(max_path_size));
+    std::vector<std::vector<bst_float>> on_scratch(
+        nthread, std::vector<bst_float>(ncolumns + 1));
+    std::vector<std::vector<bst_float>> off_scratch(
+        nthread, std::vector<bst_float>(ncolumns + 1));
+
+    for (const auto &batch : p_fmat->GetBatches<SparsePage>()) {
+      const auto nsize = batch.Size();
+      const auto n_blocks = static_cast<bst_omp_uint>(
+          nsize / kBlockOfRowsSize + !!(nsize % kBlockOfRowsSize));
+#pragma omp parallel for schedule(static)
+      for (bst_omp_uint block = 0; block < n_blocks; ++block) {
+        const int tid = omp_get_thread_num();
+        const size_t batch_offset = block * kBlockOfRowsSize;
+        const size_t block_size = std::min(kBlockOfRowsSize, nsize - batch_offset);
+        const size_t fvec_offset = static_cast<size_t>(tid) * kBlockOfRowsSize;
+        for (size_t i = 0; i < block_size; ++i) {
+          thread_temp_[fvec_offset + i].Fill(batch[batch_offset + i]);
+        }
+        std::vector<bst_float>& on = on_scratch[tid];
+        std::vector<bst_float>& off = off_scratch[tid];
+        // tree-major over the row tile like PredictContribution, with the
+        // conditioning loop restricted to the features each tree splits on
+        for (unsigned j = 0; j < real_ntree; ++j) {
+          const int gid = model.tree_info[j];
+          const bst_float w = tree_weights == nullptr ? 1 : (*tree_weights)[j];
+          for (auto const fidx : tree_features[j]) {
+            for (size_t i = 0; i < block_size; ++i) {
+              const size_t row_idx = batch.base_rowid + batch_offset + i;
+              std::fill(off.begin(), off.end(), 0);
+              std::fill(on.begin(), on.end(), 0);
+              model.trees[j]->CalculateContributions(
+                  thread_temp_[fvec_offset + i], &off[0], -1, fidx,
+                  path_scratch[tid].data());
+              model.trees[j]->CalculateContributions(
+                  thread_temp_[fvec_offset + i], &on[0], 1, fidx,
+                  path_scratch[tid].data());
+              bst_float* p_int = &contribs[row_idx * row_chunk +
+                                           gid * mrow_chunk +
+                                           fidx * (ncolumns + 1)];
+              for (size_t k = 0; k < ncolumns + 1; ++k) {
+                if (k != fidx) {
+                  p_int[k] += (on[k] - off[k]) * 0.5f * w;
+                }
+              }
+            }
+          }
+        }
+        for (size_t i = 0; i < block_size; ++i) {
+          thread_temp_[fvec_offset + i].Drop(batch[batch_offset + i]);
+        }
+      }
+    }
+
+    // the diagonal holds the additive effect minus the row's interactions,
+    // so every row of the matrix sums to the feature's contribution
+    const auto nrows = static_cast<bst_omp_uint>(info.num_row_);
+#pragma omp parallel for schedule(static)
+    for (bst_omp_uint r = 0; r < nrows; ++r) {
+      for (int l = 0; l < ngroup; ++l) {
+        const unsigned c_offset = r * crow_chunk + l * (ncolumns + 1);
+        for (size_t i = 0; i < ncolumns + 1; ++i) {
+          bst_float* p_int = &contribs[r * row_chunk + l * mrow_chunk +
+                                       i * (ncolumns + 1)];
+          bst_float value = contribs_diag[c_offset + i];
           for (size_t k = 0; k < ncolumns + 1; ++k) {
-            // fill in the diagonal with additive effects, and off-diagonal with the interactions
-            if (k == i) {
-              contribs[o_offset + i] += contribs_diag[c_offset + k];
-            } else {
-              contribs[o_offset + k] = (contribs_on[c_offset + k] - contribs_off[c_offset + k])/2.0;
-              contribs[o_offset + i] -= contribs[o_offset + k];
+            if (k != i) {
+              value -= p_int[k];
             }
           }
+          p_int[i] = value;
         }
       }
     }
   }
 
  private:
-  std::mutex lock_;
-  std::vector<RegTree::FVec> thread_temp_;
+  // mutable so the const inplace prediction path can reuse the staging
+  // buffers; access is serialized with lock_
+  mutable std::mutex lock_;
+  mutable std::vector<RegTree::FVec> thread_temp_;
+  mutable std::vector<Entry> inplace_workspace_;
+  mutable std::unique_ptr<common::WorkStealingThreadPool> pool_;
   static size_t constexpr kBlockOfRowsSize = 64;
 };
 
+void PredictDenseMulti(std::vector<gbm::GBTreeModel const *> const &models,
+                       float const *values, size_t n_rows, size_t n_cols,
+                       float missing, float *out_margins) {
+  CHECK(!models.empty());
+  size_t const n_models = models.size();
+  size_t constexpr kRowBlock = 64;
+
+  // flattened layouts are built before the parallel region
+  std::vector<std::vector<gbm::CompactTree> const *> compact_trees(n_models);
+  size_t max_trees = 0;
+  for (size_t m = 0; m < n_models; ++m) {
+    CHECK_EQ(models[m]->learner_model_param->num_feature, n_cols)
+        << "Number of columns in data must equal to trained model.";
+    CHECK_EQ(models[m]->learner_model_param->num_output_group, 1)
+        << "Multi-class models are not supported by multi-model scoring.";
+    compact_trees[m] = &models[m]->CompactTrees();
+    max_trees = std::max(max_trees, models[m]->trees.size());
+  }
+
+  // union of the features any model tests: a single staging serves them all
+  std::vector<uint32_t> used((n_cols + 31) / 32, 0u);
+  for (auto const *model : models) {
+    auto const &model_used = model->UsedFeatures();
+    for (size_t i = 0; i < used.size(); ++i) {
+      used[i] |= model_used[i];
+    }
+  }
+  size_t n_used = 0;
+  for (auto word : used) {
+    for (; word != 0; word &= word - 1) {
+      ++n_used;
+    }
+  }
+  bool const filtered = n_used != n_cols;
+
+  for (size_t m = 0; m < n_models; ++m) {
+    std::fill_n(out_margins + m * n_rows, n_rows,
+                models[m]->learner_model_param->base_score);
+  }
+
+  const int nthread = omp_get_max_threads();
+  std::vector<RegTree::FVec> thread_temp(nthread * kRowBlock);
+  for (auto &feats : thread_temp) {
+    feats.Init(n_cols);
+    if (filtered) {
+      feats.SetFilter(common::Span<uint32_t const>{used}, n_used);
+    }
+  }
+  // per-thread staging of one row block's non-missing entries
+  std::vector<std::vector<Entry>> block_entries(nthread);
+  std::vector<std::vector<size_t>> block_row_ptr(
+      nthread, std::vector<size_t>(kRowBlock + 1));
+
+  const auto n_blocks =
+      static_cast<bst_omp_uint>(n_rows / kRowBlock + !!(n_rows % kRowBlock));
+  dmlc::OMPException exc;
+#pragma omp parallel for schedule(static)
+  for (bst_omp_uint block_id = 0; block_id < n_blocks; ++block_id) {
+    exc.Run([&, block_id]() {
+      const int tid = omp_get_thread_num();
+      const size_t row_begin = static_cast<size_t>(block_id) * kRowBlock;
+      const size_t block_size = std::min(kRowBlock, n_rows - row_begin);
+      const size_t fvec_offset = static_cast<size_t>(tid) * kRowBlock;
+
+      // stage the block once; every model's trees read the same vectors
+      auto &entries = block_entries[tid];
+      auto &row_ptr = block_row_ptr[tid];
+      entries.clear();
+      row_ptr[0] = 0;
+      for (size_t i = 0; i < block_size; ++i) {
+        float const *row = values + (row_begin + i) * n_cols;
+        for (size_t c = 0; c < n_cols; ++c) {
+          if (row[c] == missing || common::CheckNAN(row[c]) ||
+              (filtered && !((used[c >> 5] >> (c & 31)) & 1u))) {
+            continue;
+          }
+          entries.emplace_back(static_cast<bst_feature_t>(c), row[c]);
+        }
+        row_ptr[i + 1] = entries.size();
+      }
+      auto inst = common::Span<Entry const>{entries};
+      bool any_missing = false;
+      for (size_t i = 0; i < block_size; ++i) {
+        thread_temp[fvec_offset + i].Fill(
+            inst.subspan(row_ptr[i], row_ptr[i + 1] - row_ptr[i]));
+        any_missing |= thread_temp[fvec_offset + i].HasMissing();
+      }
+
+      // tree blocks are scheduled round robin across the models so all of
+      // them progress through the shared row block while it is cached
+      bst_float leaf_values[kPredictLanes];
+      for (size_t tree_blk = 0; tree_blk < max_trees; tree_blk += kPredictTreeBlock) {
+        for (size_t m = 0; m < n_models; ++m) {
+          const size_t tree_blk_end =
+              std::min(models[m]->trees.size(), tree_blk + kPredictTreeBlock);
+          for (size_t i = 0; i < block_size; i += kPredictLanes) {
+            const size_t n_lanes = std::min(kPredictLanes, block_size - i);
+            for (size_t tree_id = tree_blk; tree_id < tree_blk_end; ++tree_id) {
+              PredictLanesByOneTree(*models[m], *compact_trees[m], tree_id,
+                                    any_missing, thread_temp, fvec_offset + i,
+                                    n_lanes, leaf_values);
+              for (size_t j = 0; j < n_lanes; ++j) {
+                out_margins[m * n_rows + row_begin + i + j] += leaf_values[j];
+              }
+            }
+          }
+        }
+      }
+
+      for (size_t i = 0; i < block_size; ++i) {
+        thread_temp[fvec_offset + i].Drop(
+            inst.subspan(row_ptr[i], row_ptr[i + 1] - row_ptr[i]));
+      }
+    });
+  }
+  exc.Rethrow();
+}
+
 XGBOOST_REGISTER_PREDICTOR(CPUPredictor, "cpu_predictor")
 .describe("Make predictions using CPU.")
 .set_body([](GenericParameter const* generic_param) {
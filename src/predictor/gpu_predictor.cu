@@ -6,6 +6,11 @@
 #include <thrust/device_vector.h>
 #include <thrust/fill.h>
 #include <GPUTreeShap/gpu_treeshap.h>
+#include <dmlc/parameter.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <memory>
 
 #include "xgboost/data.h"
@@ -398,6 +403,91 @@ class DeviceModel {
     this->tree_beg_ = tree_begin;
     this->tree_end_ = tree_end;
     this->num_group = model.learner_model_param->num_output_group;
+
+    // Leave the host-staged arrays resident on the device so that Extend can
+    // append behind them instead of re-uploading the whole model.
+    split_types.DevicePointer();
+    categories.DevicePointer();
+    categories_node_segments.DevicePointer();
+  }
+
+  /*!
+   * \brief Append the trees [tree_end_, tree_end) to an already initialized
+   *  device copy.  The caller guarantees that the trees below tree_end_ have
+   *  not changed since Init/Extend last ran (see GBTreeModel::BaseGeneration),
+   *  so during training with evaluation only the round's new trees cross the
+   *  PCIe bus instead of the full model.
+   */
+  void Extend(const gbm::GBTreeModel& model, size_t tree_end, int32_t gpu_id) {
+    dh::safe_cuda(cudaSetDevice(gpu_id));
+    CHECK_EQ(model.param.size_leaf_vector, 0);
+    const size_t tree_begin = tree_beg_;
+    const size_t old_end = tree_end_;
+    CHECK_LE(old_end, tree_end);
+
+    auto& h_tree_segments = tree_segments.HostVector();
+    for (auto tree_idx = old_end; tree_idx < tree_end; tree_idx++) {
+      h_tree_segments.push_back(h_tree_segments.back() +
+                                model.trees.at(tree_idx)->GetNodes().size());
+    }
+    const size_t old_nodes = h_tree_segments[old_end - tree_begin];
+
+    nodes.Resize(h_tree_segments.back());
+    stats.Resize(h_tree_segments.back());
+    auto d_nodes = nodes.DevicePointer();
+    auto d_stats = stats.DevicePointer();
+    for (auto tree_idx = old_end; tree_idx < tree_end; tree_idx++) {
+      auto& src_nodes = model.trees.at(tree_idx)->GetNodes();
+      auto& src_stats = model.trees.at(tree_idx)->GetStats();
+      dh::safe_cuda(cudaMemcpyAsync(
+          d_nodes + h_tree_segments[tree_idx - tree_begin], src_nodes.data(),
+          sizeof(RegTree::Node) * src_nodes.size(), cudaMemcpyDefault));
+      dh::safe_cuda(cudaMemcpyAsync(
+          d_stats + h_tree_segments[tree_idx - tree_begin], src_stats.data(),
+          sizeof(RTreeNodeStat) * src_stats.size(), cudaMemcpyDefault));
+    }
+
+    // per-tree group info is small; rebuild it like Init does
+    tree_group = std::move(HostDeviceVector<int>(model.tree_info.size(), 0, gpu_id));
+    auto& h_tree_group = tree_group.HostVector();
+    std::memcpy(h_tree_group.data(), model.tree_info.data(), sizeof(int) * model.tree_info.size());
+
+    // stage the per-node tails of the appended trees on the host and copy
+    // them behind the existing device entries
+    std::vector<FeatureType> h_split_types_tail;
+    std::vector<RegTree::Segment> h_cat_node_segments_tail;
+    std::vector<uint32_t> h_categories_tail;
+    auto& h_split_cat_segments = categories_tree_segments.HostVector();
+    const size_t old_categories = categories.Size();
+    for (auto tree_idx = old_end; tree_idx < tree_end; ++tree_idx) {
+      auto const& src_st = model.trees.at(tree_idx)->GetSplitTypes();
+      h_split_types_tail.insert(h_split_types_tail.end(), src_st.cbegin(), src_st.cend());
+      auto const& src_cats = model.trees.at(tree_idx)->GetSplitCategories();
+      h_categories_tail.insert(h_categories_tail.end(), src_cats.cbegin(), src_cats.cend());
+      h_split_cat_segments.push_back(old_categories + h_categories_tail.size());
+      auto const& src_cats_ptr = model.trees.at(tree_idx)->GetSplitCategoriesPtr();
+      h_cat_node_segments_tail.insert(h_cat_node_segments_tail.end(),
+                                      src_cats_ptr.cbegin(), src_cats_ptr.cend());
+    }
+
+    split_types.Resize(h_tree_segments.back());
+    dh::safe_cuda(cudaMemcpyAsync(
+        split_types.DevicePointer() + old_nodes, h_split_types_tail.data(),
+        sizeof(FeatureType) * h_split_types_tail.size(), cudaMemcpyDefault));
+    categories_node_segments.Resize(h_tree_segments.back());
+    dh::safe_cuda(cudaMemcpyAsync(
+        categories_node_segments.DevicePointer() + old_nodes, h_cat_node_segments_tail.data(),
+        sizeof(RegTree::Segment) * h_cat_node_segments_tail.size(), cudaMemcpyDefault));
+    if (!h_categories_tail.empty()) {
+      categories.Resize(old_categories + h_categories_tail.size());
+      dh::safe_cuda(cudaMemcpyAsync(
+          categories.DevicePointer() + old_categories, h_categories_tail.data(),
+          sizeof(uint32_t) * h_categories_tail.size(), cudaMemcpyDefault));
+    }
+    // the staged tails are freed on return; make sure the copies landed
+    dh::safe_cuda(cudaStreamSynchronize(nullptr));
+
+    this->tree_end_ = tree_end;
   }
 };
 
@@ -549,6 +639,149 @@ class GPUPredictor : public xgboost::Predictor {
         model_.num_group);
   }
 
+#if CUDART_VERSION >= 10010
+  /*!
+   * \brief Score a fixed-shape batch by replaying a captured CUDA graph.
+   *
+   * Streaming scorers feed identically shaped batches through PredictBatch
+   * every few milliseconds, where the launch setup is a large share of the
+   * small-batch latency.  With XGBOOST_GPU_GRAPH_PREDICT=1 the predict
+   * launch is captured once into a CUDA graph reading persistent device
+   * buffers; later batches only copy their rows into those buffers and
+   * replay the graph.  Any change of batch shape, tree range or model
+   * triggers a recapture.
+   *
+   * \return true when the batch was scored through the graph.
+   */
+  bool TryGraphPredict(const SparsePage& batch, size_t num_features,
+                       HostDeviceVector<bst_float>* predictions) {
+    if (dmlc::GetEnv("XGBOOST_GPU_GRAPH_PREDICT", 0) == 0) {
+      return false;
+    }
+    size_t const num_rows = batch.Size();
+    if (num_rows == 0) {
+      return false;
+    }
+    int const device = generic_param_->gpu_id;
+    batch.offset.SetDevice(device);
+    batch.data.SetDevice(device);
+    size_t const n_entries = batch.data.Size();
+
+    if (graph_exec_ == nullptr || graph_device_ != device ||
+        graph_rows_ != num_rows || graph_entries_ != n_entries ||
+        graph_features_ != num_features || graph_model_ != cached_model_ ||
+        graph_generation_ != cached_generation_ ||
+        graph_tree_end_ != model_.tree_end_) {
+      this->CaptureGraph(num_rows, n_entries, num_features);
+      graph_device_ = device;
+      graph_rows_ = num_rows;
+      graph_entries_ = n_entries;
+      graph_features_ = num_features;
+      graph_model_ = cached_model_;
+      graph_generation_ = cached_generation_;
+      graph_tree_end_ = model_.tree_end_;
+    }
+
+    // rebind the input: only the rows move, the captured launch keeps
+    // reading the persistent buffers
+    dh::safe_cuda(cudaMemcpyAsync(
+        graph_data_.data().get(), batch.data.ConstDevicePointer(),
+        n_entries * sizeof(Entry), cudaMemcpyDeviceToDevice, graph_stream_));
+    dh::safe_cuda(cudaMemcpyAsync(
+        graph_offset_.data().get(), batch.offset.ConstDevicePointer(),
+        batch.offset.Size() * sizeof(bst_row_t), cudaMemcpyDeviceToDevice,
+        graph_stream_));
+    // seed the output buffer from the caller's predictions: the captured
+    // kernel accumulates into it, so each replay has to start from the base
+    // score plus any earlier trees' contributions instead of whatever the
+    // previous replay left behind
+    dh::safe_cuda(cudaMemcpyAsync(
+        graph_preds_.data().get(), predictions->ConstDevicePointer(),
+        graph_preds_.size() * sizeof(bst_float), cudaMemcpyDeviceToDevice,
+        graph_stream_));
+    dh::safe_cuda(cudaGraphLaunch(graph_exec_, graph_stream_));
+    dh::safe_cuda(cudaMemcpyAsync(
+        predictions->DevicePointer(), graph_preds_.data().get(),
+        graph_preds_.size() * sizeof(bst_float), cudaMemcpyDeviceToDevice,
+        graph_stream_));
+    dh::safe_cuda(cudaStreamSynchronize(graph_stream_));
+    return true;
+  }
+
+  void CaptureGraph(size_t num_rows, size_t n_entries, size_t num_features) {
+    if (graph_stream_ == nullptr) {
+      dh::safe_cuda(
+          cudaStreamCreateWithFlags(&graph_stream_, cudaStreamNonBlocking));
+    }
+    if (graph_exec_ != nullptr) {
+      dh::safe_cuda(cudaGraphExecDestroy(graph_exec_));
+      graph_exec_ = nullptr;
+    }
+    // sized before capture; the captured launch bakes these addresses in
+    graph_data_.resize(n_entries);
+    graph_offset_.resize(num_rows + 1);
+    graph_preds_.resize(num_rows * model_.num_group);
+
+    const uint32_t BLOCK_THREADS = 128;
+    auto GRID_SIZE =
+        static_cast<uint32_t>(common::DivRoundUp(num_rows, BLOCK_THREADS));
+    size_t shared_memory_bytes =
+        SharedMemoryBytes<BLOCK_THREADS>(num_features, max_shared_memory_bytes_);
+    bool use_shared = shared_memory_bytes != 0;
+    size_t entry_start = 0;
+    SparsePageView data(dh::ToSpan(graph_data_), dh::ToSpan(graph_offset_),
+                        num_features);
+
+    cudaGraph_t graph;
+    dh::safe_cuda(
+        cudaStreamBeginCapture(graph_stream_, cudaStreamCaptureModeThreadLocal));
+    dh::LaunchKernel {GRID_SIZE, BLOCK_THREADS, shared_memory_bytes, graph_stream_} (
+        PredictKernel<SparsePageLoader, SparsePageView>, data,
+        model_.nodes.ConstDeviceSpan(), dh::ToSpan(graph_preds_),
+        model_.tree_segments.ConstDeviceSpan(), model_.tree_group.ConstDeviceSpan(),
+        model_.split_types.ConstDeviceSpan(),
+        model_.categories_tree_segments.ConstDeviceSpan(),
+        model_.categories_node_segments.ConstDeviceSpan(),
+        model_.categories.ConstDeviceSpan(), model_.tree_beg_, model_.tree_end_,
+        num_features, num_rows, entry_start, use_shared, model_.num_group);
+    dh::safe_cuda(cudaStreamEndCapture(graph_stream_, &graph));
+    dh::safe_cuda(cudaGraphInstantiate(&graph_exec_, graph, nullptr, nullptr, 0));
+    dh::safe_cuda(cudaGraphDestroy(graph));
+  }
+#else   // CUDART_VERSION >= 10010
+  bool TryGraphPredict(const SparsePage&, size_t,
+                       HostDeviceVector<bst_float>*) {
+    return false;
+  }
+#endif  // CUDART_VERSION >= 10010
+
+  /*!
+   * \brief Copy the model to the device only when it changed since the last
+   *  copy, so repeated scoring with an unchanged booster skips the host to
+   *  device transfer of the trees.
+   */
+  void InitModel(const gbm::GBTreeModel& model, size_t tree_begin,
+                 size_t tree_end, int32_t device) {
+    // The cached copy still holds a valid prefix of the model as long as no
+    // mutation other than appending trees happened since it was taken.
+    const bool prefix_valid = cached_model_ == &model && cached_device_ == device &&
+                              model_.tree_beg_ == tree_begin &&
+                              cached_generation_ >= model.BaseGeneration();
+    if (prefix_valid && model_.tree_end_ == tree_end) {
+      return;
+    }
+    if (prefix_valid && model_.tree_end_ < tree_end) {
+      // training with evaluation grows the model a few trees per iteration;
+      // upload only those instead of the whole model
+      model_.Extend(model, tree_end, device);
+    } else {
+      model_.Init(model, tree_begin, tree_end, device);
+    }
+    cached_model_ = &model;
+    cached_generation_ = model.Generation();
+    cached_device_ = device;
+  }
+
   void DevicePredictInternal(DMatrix* dmat, HostDeviceVector<float>* out_preds,
                              const gbm::GBTreeModel& model, size_t tree_begin,
                              size_t tree_end) {
@@ -556,18 +789,14 @@ class GPUPredictor : public xgboost::Predictor {
     if (tree_end - tree_begin == 0) {
       return;
     }
-    model_.Init(model, tree_begin, tree_end, generic_param_->gpu_id);
+    this->InitModel(model, tree_begin, tree_end, generic_param_->gpu_id);
     out_preds->SetDevice(generic_param_->gpu_id);
     auto const& info = dmat->Info();
 
-    if (dmat->PageExists<SparsePage>()) {
-      size_t batch_offset = 0;
-      for (auto &batch : dmat->GetBatches<SparsePage>()) {
-        this->PredictInternal(batch, model.learner_model_param->num_feature,
-                              out_preds, batch_offset);
-        batch_offset += batch.Size() * model.learner_model_param->num_output_group;
-      }
-    } else {
+    // Prefer the page already resident on the device: the EllpackPage built
+    // for gpu_hist training is cached by the DMatrix, using it saves a full
+    // host to device round trip of the rows when scoring in place.
+    if (dmat->PageExists<EllpackPage>()) {
       size_t batch_offset = 0;
       for (auto const& page : dmat->GetBatches<EllpackPage>()) {
         this->PredictInternal(
@@ -576,6 +805,19 @@ class GPUPredictor : public xgboost::Predictor {
             batch_offset);
         batch_offset += page.Impl()->n_rows;
       }
+    } else {
+      size_t batch_offset = 0;
+      for (auto &batch : dmat->GetBatches<SparsePage>()) {
+        if (batch_offset == 0 && dmat->SingleColBlock() &&
+            this->TryGraphPredict(batch, model.learner_model_param->num_feature,
+                                  out_preds)) {
+          batch_offset += batch.Size() * model.learner_model_param->num_output_group;
+          continue;
+        }
+        this->PredictInternal(batch, model.learner_model_param->num_feature,
+                              out_preds, batch_offset);
+        batch_offset += batch.Size() * model.learner_model_param->num_output_group;
+      }
     }
   }
 
@@ -587,11 +829,22 @@ class GPUPredictor : public xgboost::Predictor {
     if (generic_param_->gpu_id >= 0 && generic_param_->gpu_id < common::AllVisibleGPUs()) {
       dh::safe_cuda(cudaSetDevice(generic_param_->gpu_id));
     }
+#if CUDART_VERSION >= 10010
+    if (graph_exec_ != nullptr) {
+      dh::safe_cuda(cudaGraphExecDestroy(graph_exec_));
+    }
+    if (graph_stream_ != nullptr) {
+      dh::safe_cuda(cudaStreamDestroy(graph_stream_));
+    }
+#endif  // CUDART_VERSION >= 10010
   }
 
   void PredictBatch(DMatrix* dmat, PredictionCacheEntry* predts,
                     const gbm::GBTreeModel& model, int tree_begin,
                     unsigned ntree_limit = 0) override {
+    if (this->TryMicroBatchPredict(dmat, predts, model, tree_begin, ntree_limit)) {
+      return;
+    }
     // This function is duplicated with CPU predictor PredictBatch, see comments in there.
     // FIXME(trivialfis): Remove the duplication.
     std::lock_guard<std::mutex> const guard(lock_);
@@ -828,7 +1081,7 @@ class GPUPredictor : public xgboost::Predictor {
 
   void PredictInstance(const SparsePage::Inst&,
                        std::vector<bst_float>*,
-                       const gbm::GBTreeModel&, unsigned) override {
+                       const gbm::GBTreeModel&, unsigned, bst_float) override {
     LOG(FATAL) << "[Internal error]: " << __func__
                << " is not implemented in GPU Predictor.";
   }
@@ -854,20 +1107,19 @@ class GPUPredictor : public xgboost::Predictor {
     }
     predictions->SetDevice(generic_param_->gpu_id);
     predictions->Resize(num_rows * real_ntree_limit);
-    model_.Init(model, 0, real_ntree_limit, generic_param_->gpu_id);
+    this->InitModel(model, 0, real_ntree_limit, generic_param_->gpu_id);
 
-    if (p_fmat->PageExists<SparsePage>()) {
-      for (auto const& batch : p_fmat->GetBatches<SparsePage>()) {
-        batch.data.SetDevice(generic_param_->gpu_id);
-        batch.offset.SetDevice(generic_param_->gpu_id);
+    // Same page preference as DevicePredictInternal: reuse the device
+    // resident EllpackPage when the DMatrix has one cached from training.
+    if (p_fmat->PageExists<EllpackPage>()) {
+      for (auto const& batch : p_fmat->GetBatches<EllpackPage>()) {
         bst_row_t batch_offset = 0;
-        SparsePageView data{batch.data.DeviceSpan(), batch.offset.DeviceSpan(),
-                            model.learner_model_param->num_feature};
+        EllpackDeviceAccessor data{batch.Impl()->GetDeviceAccessor(generic_param_->gpu_id)};
         size_t num_rows = batch.Size();
         auto grid =
             static_cast<uint32_t>(common::DivRoundUp(num_rows, kBlockThreads));
         dh::LaunchKernel {grid, kBlockThreads, shared_memory_bytes} (
-            PredictLeafKernel<SparsePageLoader, SparsePageView>, data,
+            PredictLeafKernel<EllpackLoader, EllpackDeviceAccessor>, data,
             model_.nodes.ConstDeviceSpan(),
             predictions->DeviceSpan().subspan(batch_offset),
             model_.tree_segments.ConstDeviceSpan(),
@@ -876,14 +1128,17 @@ class GPUPredictor : public xgboost::Predictor {
         batch_offset += batch.Size();
       }
     } else {
-      for (auto const& batch : p_fmat->GetBatches<EllpackPage>()) {
+      for (auto const& batch : p_fmat->GetBatches<SparsePage>()) {
+        batch.data.SetDevice(generic_param_->gpu_id);
+        batch.offset.SetDevice(generic_param_->gpu_id);
         bst_row_t batch_offset = 0;
-        EllpackDeviceAccessor data{batch.Impl()->GetDeviceAccessor(generic_param_->gpu_id)};
+        SparsePageView data{batch.data.DeviceSpan(), batch.offset.DeviceSpan(),
+                            model.learner_model_param->num_feature};
         size_t num_rows = batch.Size();
         auto grid =
             static_cast<uint32_t>(common::DivRoundUp(num_rows, kBlockThreads));
         dh::LaunchKernel {grid, kBlockThreads, shared_memory_bytes} (
-            PredictLeafKernel<EllpackLoader, EllpackDeviceAccessor>, data,
+            PredictLeafKernel<SparsePageLoader, SparsePageView>, data,
             model_.nodes.ConstDeviceSpan(),
             predictions->DeviceSpan().subspan(batch_offset),
             model_.tree_segments.ConstDeviceSpan(),
@@ -906,9 +1161,168 @@ class GPUPredictor : public xgboost::Predictor {
     }
   }
 
+  /*! \brief A request waiting to be flushed as part of a micro batch. */
+  struct MicroRequest {
+    SparsePage const* page;
+    HostDeviceVector<bst_float>* out_preds;
+    bool done { false };
+  };
+
+  /*! \brief Row budget of one micro batch, 0 disables the queue. */
+  static size_t MaxMicroBatchRows() {
+    static size_t max_rows = dmlc::GetEnv("XGBOOST_GPU_MICRO_BATCH_ROWS", 0);
+    return max_rows;
+  }
+  /*! \brief How long the leader waits for more requests before flushing. */
+  static int MicroBatchWaitUs() {
+    static int wait_us = std::max(dmlc::GetEnv("XGBOOST_GPU_MICRO_BATCH_WAIT_US", 50), 0);
+    return wait_us;
+  }
+
+  /*!
+   * \brief Coalesce small concurrent prediction requests into one fused
+   *        kernel launch.
+   *
+   * Feeding many small requests through PredictBatch pays one underfilled
+   * kernel and a full device model upload per call.  When the queue is
+   * enabled the first caller becomes the leader: it waits for up to
+   * MicroBatchWaitUs() for followers, stages all rows into one contiguous
+   * buffer and scores them with a single launch, then scatters each
+   * request's slice back.  Only fresh single-page in-memory requests
+   * against the same model can be fused; everything else falls through to
+   * the regular path.
+   *
+   * \return true when the request was served through the fused path.
+   */
+  bool TryMicroBatchPredict(DMatrix* dmat, PredictionCacheEntry* predts,
+                            const gbm::GBTreeModel& model, int tree_begin,
+                            unsigned ntree_limit) {
+    size_t const max_rows = MaxMicroBatchRows();
+    if (max_rows == 0) {
+      return false;
+    }
+    auto const& info = dmat->Info();
+    if (tree_begin != 0 || predts->version != 0 || info.num_row_ == 0 ||
+        info.num_row_ > max_rows || !dmat->SingleColBlock() ||
+        !dmat->PageExists<SparsePage>() || info.base_margin_.Size() != 0) {
+      return false;
+    }
+    uint32_t const output_groups = model.learner_model_param->num_output_group;
+    uint32_t real_ntree_limit = ntree_limit * output_groups;
+    if (real_ntree_limit == 0 || real_ntree_limit > model.trees.size()) {
+      real_ntree_limit = static_cast<uint32_t>(model.trees.size());
+    }
+
+    this->InitOutPredictions(info, &predts->predictions, model);
+    auto batches = dmat->GetBatches<SparsePage>();
+    MicroRequest req{&(*batches.begin()), &predts->predictions};
+
+    std::unique_lock<std::mutex> lk(micro_mu_);
+    if (!micro_pending_.empty() &&
+        (micro_model_ != &model || micro_tree_end_ != real_ntree_limit)) {
+      // a different model is queued, the requests cannot be fused
+      return false;
+    }
+    bool const leader = micro_pending_.empty();
+    micro_model_ = &model;
+    micro_tree_end_ = real_ntree_limit;
+    micro_pending_.push_back(&req);
+    micro_rows_ += info.num_row_;
+    if (leader) {
+      micro_cv_.wait_for(lk, std::chrono::microseconds(MicroBatchWaitUs()),
+                         [&] { return micro_rows_ >= max_rows; });
+      auto requests = std::move(micro_pending_);
+      micro_pending_.clear();
+      micro_rows_ = 0;
+      micro_model_ = nullptr;
+      lk.unlock();
+
+      this->FlushMicroBatch(requests, model, real_ntree_limit);
+
+      lk.lock();
+      for (auto* r : requests) {
+        r->done = true;
+      }
+      micro_cv_.notify_all();
+    } else {
+      // wake the leader in case this request filled the row budget
+      micro_cv_.notify_all();
+      micro_cv_.wait(lk, [&] { return req.done; });
+    }
+    predts->Update(real_ntree_limit / output_groups);
+    return true;
+  }
+
+  void FlushMicroBatch(std::vector<MicroRequest*> const& requests,
+                       const gbm::GBTreeModel& model, uint32_t tree_end) {
+    std::lock_guard<std::mutex> const guard(lock_);
+    int device = generic_param_->gpu_id;
+    CHECK_GE(device, 0) << "Set `gpu_id' to positive value for processing GPU data.";
+    ConfigureDevice(device);
+    dh::safe_cuda(cudaSetDevice(device));
+
+    // stage all rows contiguously so one launch covers the whole batch
+    SparsePage staging;
+    size_t total_rows = 0;
+    for (auto const* r : requests) {
+      staging.Push(*r->page);
+      total_rows += r->page->Size();
+    }
+
+    uint32_t const output_groups = model.learner_model_param->num_output_group;
+    fused_preds_.SetDevice(device);
+    fused_preds_.Resize(total_rows * output_groups);
+    fused_preds_.Fill(model.learner_model_param->base_score);
+
+    this->InitModel(model, 0, tree_end, device);
+    this->PredictInternal(staging, model.learner_model_param->num_feature,
+                          &fused_preds_, 0);
+
+    // scatter each request's slice back
+    auto const& h_fused = fused_preds_.ConstHostVector();
+    size_t offset = 0;
+    for (auto* r : requests) {
+      auto& h_out = r->out_preds->HostVector();
+      size_t const n = r->page->Size() * output_groups;
+      std::copy_n(h_fused.cbegin() + offset, n, h_out.begin());
+      offset += n;
+    }
+  }
+
   std::mutex lock_;
   DeviceModel model_;
+  // identity of the model currently resident in model_, see InitModel
+  const gbm::GBTreeModel* cached_model_ { nullptr };
+  uint64_t cached_generation_ { 0 };
+  int32_t cached_device_ { -1 };
   size_t max_shared_memory_bytes_ { 0 };
+
+#if CUDART_VERSION >= 10010
+  // CUDA graph replay of the predict launch and the fixed-shape state it was
+  // captured against, see TryGraphPredict
+  cudaGraphExec_t graph_exec_ { nullptr };
+  cudaStream_t graph_stream_ { nullptr };
+  dh::device_vector<Entry> graph_data_;
+  dh::device_vector<bst_row_t> graph_offset_;
+  dh::device_vector<bst_float> graph_preds_;
+  const gbm::GBTreeModel* graph_model_ { nullptr };
+  uint64_t graph_generation_ { 0 };
+  int graph_device_ { -1 };
+  size_t graph_rows_ { 0 };
+  size_t graph_entries_ { 0 };
+  size_t graph_features_ { 0 };
+  size_t graph_tree_end_ { 0 };
+#endif  // CUDART_VERSION >= 10010
+
+  // state of the micro batching queue, guarded by micro_mu_
+  std::mutex micro_mu_;
+  std::condition_variable micro_cv_;
+  std::vector<MicroRequest*> micro_pending_;
+  size_t micro_rows_ { 0 };
+  const gbm::GBTreeModel* micro_model_ { nullptr };
+  uint32_t micro_tree_end_ { 0 };
+  // staging output of a fused launch, reused across flushes
+  HostDeviceVector<bst_float> fused_preds_;
 };
 
 XGBOOST_REGISTER_PREDICTOR(GPUPredictor, "gpu_predictor")
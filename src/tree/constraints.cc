@@ -2,7 +2,6 @@
  * Copyright 2018-2019 by Contributors
  */
 #include <algorithm>
-#include <unordered_set>
 #include <vector>
 
 #include "xgboost/span.h"
@@ -29,7 +28,7 @@ void FeatureInteractionConstraintHost::Reset() {
     return;
   }
   // Read std::vector<std::vector<bst_feature_t>> first and then
-  //   convert to std::vector<std::unordered_set<bst_feature_t>>
+  //   convert to one bitset per constraint group
   std::vector<std::vector<bst_feature_t>> tmp;
   try {
     ParseInteractionConstraint(this->interaction_constraint_str_, &tmp);
@@ -38,65 +37,71 @@ void FeatureInteractionConstraintHost::Reset() {
                << this->interaction_constraint_str_ << "\n"
                << "With error:\n" << e.what();
   }
+  size_t const n_words = LBitField64::ComputeStorageSize(n_features_);
+  interaction_constraints_.clear();
   for (const auto& e : tmp) {
-    interaction_constraints_.emplace_back(e.begin(), e.end());
+    interaction_constraints_.emplace_back(n_words, 0);
+    LBitField64 bits{{interaction_constraints_.back().data(), n_words}};
+    for (bst_feature_t fid : e) {
+      CHECK_LT(fid, n_features_)
+          << "Feature index in interaction constraint is out of range.";
+      bits.Set(fid);
+    }
   }
 
   // Initialise interaction constraints record with all variables permitted for the first node
   node_constraints_.clear();
-  node_constraints_.resize(1, std::unordered_set<bst_feature_t>());
-  node_constraints_[0].reserve(n_features_);
+  node_constraints_.emplace_back(n_words, 0);
+  LBitField64 root{{node_constraints_[0].data(), n_words}};
   for (bst_feature_t i = 0; i < n_features_; ++i) {
-    node_constraints_[0].insert(i);
+    root.Set(i);
   }
 
   // Initialise splits record
   splits_.clear();
-  splits_.resize(1, std::unordered_set<bst_feature_t>());
+  splits_.emplace_back(n_words, 0);
 }
 
 void FeatureInteractionConstraintHost::SplitImpl(
     bst_node_t node_id, bst_feature_t feature_id, bst_node_t left_id, bst_node_t right_id) {
   bst_node_t newsize = std::max(left_id, right_id) + 1;
+  CHECK_NE(newsize, 0);
+  size_t const n_words = LBitField64::ComputeStorageSize(n_features_);
 
-  // Record previous splits for child nodes
-  auto feature_splits = splits_[node_id];  // fid history of current node
-  feature_splits.insert(feature_id);  // add feature of current node
-  splits_.resize(newsize);
-  splits_[left_id] = feature_splits;
-  splits_[right_id] = feature_splits;
+  // Record previous splits for child nodes: the fid history of the current
+  // node, plus the feature just used.
+  splits_.resize(newsize, BitSetStorage(n_words, 0));
+  splits_[left_id] = splits_[node_id];
+  LBitField64 feature_splits{{splits_[left_id].data(), n_words}};
+  feature_splits.Set(feature_id);
+  splits_[right_id] = splits_[left_id];
 
-  // Resize constraints record, initialise all features to be not permitted for new nodes
-  CHECK_NE(newsize, 0);
-  node_constraints_.resize(newsize, std::unordered_set<bst_feature_t>());
+  // Resize constraints record, initialise all features to be not permitted
+  // for new nodes
+  node_constraints_.resize(newsize, BitSetStorage(n_words, 0));
+  LBitField64 left_constraints{{node_constraints_[left_id].data(), n_words}};
+  LBitField64 right_constraints{{node_constraints_[right_id].data(), n_words}};
 
   // Permit features used in previous splits
-  for (bst_feature_t fid : feature_splits) {
-    node_constraints_[left_id].insert(fid);
-    node_constraints_[right_id].insert(fid);
-  }
+  left_constraints |= feature_splits;
+  right_constraints |= feature_splits;
 
-  // Loop across specified interactions in constraints
-  for (const auto &constraint : interaction_constraints_) {
-    // flags whether the specified interaction is still relevant
-    bst_uint flag = 1;
-
-    // Test relevance of specified interaction by checking all previous
-    // features are included
-    for (bst_uint checkvar : feature_splits) {
-      if (constraint.count(checkvar) == 0) {
-        flag = 0;
-        break;   // interaction is not relevant due to unmet constraint
+  // Loop across specified interactions in constraints.  An interaction is
+  // still relevant iff it contains every feature split so far on the path,
+  // i.e. the split history is a subset of the constraint set; in that case
+  // all other features in the interaction stay permitted.
+  for (auto& constraint : interaction_constraints_) {
+    bool relevant = true;
+    for (size_t i = 0; i < n_words; ++i) {
+      if ((splits_[left_id][i] & ~constraint[i]) != 0) {
+        relevant = false;
+        break;  // interaction is not relevant due to unmet constraint
       }
     }
-
-    // If interaction is still relevant, permit all other features in the
-    // interaction
-    if (flag == 1) {
-      for (bst_uint k : constraint) {
-        node_constraints_[left_id].insert(k);
-        node_constraints_[right_id].insert(k);
-      }
+    if (relevant) {
+      LBitField64 constraint_bits{{constraint.data(), n_words}};
+      left_constraints |= constraint_bits;
+      right_constraints |= constraint_bits;
     }
   }
 }
@@ -5,32 +5,37 @@
 #define XGBOOST_TREE_CONSTRAINTS_H_
 
 #include <string>
-#include <unordered_set>
 #include <vector>
 
 #include "xgboost/span.h"
 #include "xgboost/base.h"
 
+#include "../common/bitfield.h"
 #include "param.h"
 
 namespace xgboost {
 /*!
  * \brief Feature interaction constraint implementation for CPU tree updaters.
  *
- * The interface is similiar to the one for GPU Hist.
+ * The interface is similiar to the one for GPU Hist.  Constraint state is
+ * kept in fixed-width bitsets of n_features_ bits, stored as raw words and
+ * viewed through LBitField64, so membership tests are single word probes and
+ * set merges are word-wise OR.
  */
 class FeatureInteractionConstraintHost {
  protected:
+  using BitSetStorage = std::vector<LBitField64::value_type>;
+
   // interaction_constraints_[constraint_id] contains a single interaction
   //   constraint, which specifies a group of feature IDs that can interact
   //   with each other
-  std::vector< std::unordered_set<bst_feature_t> > interaction_constraints_;
-  // int_cont_[nid] contains the set of all feature IDs that are allowed to
-  //   be used for a split at node nid
-  std::vector< std::unordered_set<bst_feature_t> > node_constraints_;
+  std::vector<BitSetStorage> interaction_constraints_;
+  // node_constraints_[nid] contains the set of all feature IDs that are
+  //   allowed to be used for a split at node nid
+  std::vector<BitSetStorage> node_constraints_;
   // splits_[nid] contains the set of all feature IDs that have been used for
   //   splits in node nid and its parents
-  std::vector< std::unordered_set<bst_feature_t> > splits_;
+  std::vector<BitSetStorage> splits_;
   // string passed by user.
   std::string interaction_constraint_str_;
   // number of features in DMatrix/Booster
@@ -53,7 +58,19 @@ class FeatureInteractionConstraintHost {
 
   bool Query(bst_node_t nid, bst_feature_t fid) const {
     if (!enabled_) { return true; }
-    return node_constraints_.at(nid).find(fid) != node_constraints_.at(nid).cend();
+    auto const& bits = node_constraints_.at(nid);
+    return CLBitField64{{bits.data(), bits.size()}}.Check(fid);
+  }
+
+  /*!
+   * \brief View of the features permitted at node nid, or an empty view when
+   *   constraints are disabled.  Callers evaluating many features for one
+   *   node should obtain the view once instead of calling Query per feature.
+   */
+  CLBitField64 NodeConstraints(bst_node_t nid) const {
+    if (!enabled_) { return {}; }
+    auto const& bits = node_constraints_.at(nid);
+    return CLBitField64{{bits.data(), bits.size()}};
   }
 
   void Reset();
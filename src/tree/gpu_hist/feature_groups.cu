@@ -48,6 +48,67 @@ FeatureGroups::FeatureGroups(const common::HistogramCuts& cuts, bool is_dense,
                             bin_segments_h[bin_segments_h.size() - 2]);
 }
 
+std::mutex FeatureGroupsTuner::cache_mutex_;
+std::map<FeatureGroupsTuner::CacheKey, size_t> FeatureGroupsTuner::cache_;
+
+FeatureGroupsTuner::FeatureGroupsTuner(const common::HistogramCuts& cuts,
+                                       bool is_dense, int device,
+                                       size_t shm_size, size_t bin_size) {
+  cudaDeviceProp prop;
+  dh::safe_cuda(cudaGetDeviceProperties(&prop, device));
+  key_ = std::make_pair(std::string{prop.name},
+                        static_cast<int>(cuts.TotalBins()));
+
+  if (!is_dense) {
+    // Sparse matrices use a single feature group; nothing to tune.
+    candidates_.emplace_back(
+        new FeatureGroups(cuts, is_dense, shm_size, bin_size));
+    done_ = true;
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(cache_mutex_);
+    auto it = cache_.find(key_);
+    if (it != cache_.end()) {
+      candidates_.emplace_back(
+          new FeatureGroups(cuts, is_dense, it->second, bin_size));
+      done_ = true;
+      return;
+    }
+  }
+
+  budgets_ = {shm_size, shm_size / 2, shm_size / 4};
+  for (size_t budget : budgets_) {
+    candidates_.emplace_back(
+        new FeatureGroups(cuts, is_dense, budget, bin_size));
+  }
+  timings_.resize(candidates_.size(), 0.0f);
+}
+
+void FeatureGroupsTuner::Report(float per_row_ms) {
+  if (done_) {
+    return;
+  }
+  timings_[current_] = per_row_ms;
+  ++current_;
+  if (current_ < candidates_.size()) {
+    return;
+  }
+  best_ = std::min_element(timings_.begin(), timings_.end()) -
+          timings_.begin();
+  {
+    std::lock_guard<std::mutex> guard(cache_mutex_);
+    cache_[key_] = budgets_[best_];
+  }
+  // Drop the losing candidates.
+  auto winner = std::move(candidates_[best_]);
+  candidates_.clear();
+  candidates_.push_back(std::move(winner));
+  best_ = 0;
+  done_ = true;
+}
+
 void FeatureGroups::InitSingle(const common::HistogramCuts& cuts) {
   std::vector<int>& feature_segments_h = feature_segments.HostVector();
   feature_segments_h.push_back(0);
@@ -7,6 +7,13 @@
 #include <xgboost/host_device_vector.h>
 #include <xgboost/span.h>
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
 namespace xgboost {
 
 // Forward declarations.
@@ -111,7 +118,54 @@ struct FeatureGroups {
 
 private:
   void InitSingle(const common::HistogramCuts& cuts);
-}; 
+};
+
+/** \brief FeatureGroupsTuner picks the fastest of a few candidate feature
+    groupings by timing the histogram kernel on real builds during the first
+    iteration.
+
+    Candidate groupings are generated from decreasing shared memory budgets:
+    the full budget gives the fewest, largest groups, while smaller budgets
+    trade shared memory per block for more feature groups and hence more
+    thread blocks in flight.  Since one block row is launched per group, the
+    grouping also drives the kernel launch shape.  The measured winner is
+    cached per (GPU model, number of bins) for the lifetime of the process,
+    so later boosters and other devices of the same model skip the timing
+    runs.  Sparse matrices use a single feature group and are not tuned. */
+class FeatureGroupsTuner {
+ public:
+  /** \param device GPU ID the histograms are built on.
+      Remaining parameters match the FeatureGroups constructor. */
+  FeatureGroupsTuner(const common::HistogramCuts& cuts, bool is_dense,
+                     int device, size_t shm_size, size_t bin_size);
+
+  /** \brief The grouping to use for the next histogram build. */
+  FeatureGroups* Current() {
+    return done_ ? candidates_[best_].get() : candidates_[current_].get();
+  }
+
+  /** \brief Whether the next histogram build should be timed. */
+  bool NeedsTiming() const { return !done_; }
+
+  /** \brief Records the measured time of the current candidate, normalized by
+      the caller to a per-row cost, and advances to the next one.  After the
+      last candidate the winner is selected and cached. */
+  void Report(float per_row_ms);
+
+ private:
+  using CacheKey = std::pair<std::string, int>;
+
+  std::vector<std::unique_ptr<FeatureGroups>> candidates_;
+  std::vector<size_t> budgets_;
+  std::vector<float> timings_;
+  size_t current_{0};
+  size_t best_{0};
+  bool done_{false};
+  CacheKey key_;
+
+  static std::mutex cache_mutex_;
+  static std::map<CacheKey, size_t> cache_;
+};
 
 }  // namespace tree
 }  // namespace xgboost
@@ -54,17 +54,6 @@ struct IsNonZero : public thrust::unary_function<GradientPair, bool> {
   }
 };
 
-/*! \brief A functor that clears the row indexes with empty gradient. */
-struct ClearEmptyRows : public thrust::binary_function<GradientPair, size_t, size_t> {
-  XGBOOST_DEVICE size_t operator()(const GradientPair& gpair, size_t row_index) const {
-    if (gpair.GetGrad() != 0 || gpair.GetHess() != 0) {
-      return row_index;
-    } else {
-      return std::numeric_limits<std::size_t>::max();
-    }
-  }
-};
-
 /*! \brief A functor that combines the gradient pair into a single float.
  *
  * The approach here is based on Minimal Variance Sampling (MVS), with lambda set to 0.1.
@@ -143,6 +132,64 @@ class PoissonSampling : public thrust::binary_function<GradientPair, size_t, Gra
   CombineGradientPair combine_;
 };
 
+/*! \brief Given 0/1 selection flags in sample_row_index, compact the selected
+ * gradient pairs into out_gpair and replace each flag with the index of the
+ * sampled row (or max for discarded rows).
+ *
+ * The scan provides the destination indexes and the total, so the separate
+ * count_if/copy_if/clear passes collapse into one kernel.  Shrinking
+ * out_gpair keeps its device allocation, so its capacity settles at the
+ * high-water-mark instead of being reallocated each iteration.
+ *
+ * \return The number of sampled rows.
+ */
+size_t CompactSelectedRows(int device, common::Span<GradientPair> gpair,
+                           dh::device_vector<GradientPair>* out_gpair,
+                           dh::caching_device_vector<size_t>* sample_row_index) {
+  thrust::inclusive_scan(sample_row_index->begin(), sample_row_index->end(),
+                         sample_row_index->begin());
+  size_t sample_rows =
+      sample_row_index->empty() ? 0 : sample_row_index->back();
+  out_gpair->resize(sample_rows);
+  auto d_out_gpair = dh::ToSpan(*out_gpair);
+  auto d_row_index = dh::ToSpan(*sample_row_index);
+  dh::LaunchN(device, gpair.size(), [=] __device__(size_t i) mutable {
+    if (IsNonZero()(gpair[i])) {
+      size_t idx = d_row_index[i] - 1;
+      d_out_gpair[idx] = gpair[i];
+      d_row_index[i] = idx;
+    } else {
+      d_row_index[i] = std::numeric_limits<std::size_t>::max();
+    }
+  });
+  return sample_rows;
+}
+
+/*! \brief Size the pooled sample page for this iteration's row count.
+ *
+ * The first call (and any growth beyond the high-water-mark) allocates;
+ * afterwards the existing compressed buffer is reused, as shrinking a
+ * HostDeviceVector keeps the device allocation.  Avoiding the per-iteration
+ * cudaFree/cudaMalloc of a multi-gigabyte page also avoids the allocator
+ * synchronization it implies.
+ */
+void ResizeSamplePage(std::unique_ptr<EllpackPageImpl>* page,
+                      EllpackPageImpl const* original, int device,
+                      size_t sample_rows) {
+  if (!*page) {
+    page->reset(new EllpackPageImpl(device, original->Cuts(),
+                                    original->is_dense, original->row_stride,
+                                    sample_rows));
+  } else {
+    auto* impl = page->get();
+    impl->n_rows = sample_rows;
+    impl->gidx_buffer.Resize(common::CompressedBufferWriter::CalculateBufferSize(
+        impl->row_stride * sample_rows, impl->NumSymbols()));
+  }
+  thrust::fill(dh::tbegin((*page)->gidx_buffer), dh::tend((*page)->gidx_buffer),
+               0);
+}
+
 NoSampling::NoSampling(EllpackPageImpl* page) : page_(page) {}
 
 GradientBasedSample NoSampling::Sample(common::Span<GradientPair> gpair, DMatrix* dmat) {
@@ -200,30 +247,15 @@ GradientBasedSample ExternalMemoryUniformSampling::Sample(common::Span<GradientP
                      BernoulliTrial(common::GlobalRandom()(), subsample_),
                      GradientPair());
 
-  // Count the sampled rows.
-  size_t sample_rows = thrust::count_if(dh::tbegin(gpair), dh::tend(gpair), IsNonZero());
-
-  // Compact gradient pairs.
-  gpair_.resize(sample_rows);
-  thrust::copy_if(dh::tbegin(gpair), dh::tend(gpair), gpair_.begin(), IsNonZero());
-
-  // Index the sample rows.
-  thrust::transform(dh::tbegin(gpair), dh::tend(gpair), sample_row_index_.begin(), IsNonZero());
-  thrust::exclusive_scan(sample_row_index_.begin(), sample_row_index_.end(),
-                         sample_row_index_.begin());
+  // Flag the sampled rows, then compact the gradient pairs and build the
+  // sample row indexes in a single pass.
   thrust::transform(dh::tbegin(gpair), dh::tend(gpair),
-                    sample_row_index_.begin(),
-                    sample_row_index_.begin(),
-                    ClearEmptyRows());
-
-  // Create a new ELLPACK page with empty rows.
-  page_.reset();  // Release the device memory first before reallocating
-  page_.reset(new EllpackPageImpl(
-      batch_param_.gpu_id, original_page_->Cuts(), original_page_->is_dense,
-                                  original_page_->row_stride, sample_rows));
-
-  // Compact the ELLPACK pages into the single sample page.
-  thrust::fill(dh::tbegin(page_->gidx_buffer), dh::tend(page_->gidx_buffer), 0);
+                    sample_row_index_.begin(), IsNonZero());
+  size_t sample_rows = CompactSelectedRows(batch_param_.gpu_id, gpair, &gpair_,
+                                           &sample_row_index_);
+
+  // Size the pooled sample page and compact the ELLPACK pages into it.
+  ResizeSamplePage(&page_, original_page_, batch_param_.gpu_id, sample_rows);
   for (auto& batch : dmat->GetBatches<EllpackPage>(batch_param_)) {
     page_->Compact(batch_param_.gpu_id, batch.Impl(), dh::ToSpan(sample_row_index_));
   }
@@ -274,38 +306,23 @@ GradientBasedSample ExternalMemoryGradientBasedSampling::Sample(common::Span<Gra
   size_t threshold_index = GradientBasedSampler::CalculateThresholdIndex(
       gpair, dh::ToSpan(threshold_), dh::ToSpan(grad_sum_), n_rows * subsample_);
 
-  // Perform Poisson sampling in place.
-  thrust::transform(dh::tbegin(gpair), dh::tend(gpair),
-                    thrust::counting_iterator<size_t>(0),
-                    dh::tbegin(gpair),
-                    PoissonSampling(dh::ToSpan(threshold_),
-                                    threshold_index,
-                                    RandomWeight(common::GlobalRandom()())));
-
-  // Count the sampled rows.
-  size_t sample_rows = thrust::count_if(dh::tbegin(gpair), dh::tend(gpair), IsNonZero());
-
-  // Compact gradient pairs.
-  gpair_.resize(sample_rows);
-  thrust::copy_if(dh::tbegin(gpair), dh::tend(gpair), gpair_.begin(), IsNonZero());
-
-  // Index the sample rows.
-  thrust::transform(dh::tbegin(gpair), dh::tend(gpair), sample_row_index_.begin(), IsNonZero());
-  thrust::exclusive_scan(sample_row_index_.begin(), sample_row_index_.end(),
-    sample_row_index_.begin());
-  thrust::transform(dh::tbegin(gpair), dh::tend(gpair),
-                    sample_row_index_.begin(),
-                    sample_row_index_.begin(),
-                    ClearEmptyRows());
-
-  // Create a new ELLPACK page with empty rows.
-  page_.reset();  // Release the device memory first before reallocating
-  page_.reset(new EllpackPageImpl(batch_param_.gpu_id, original_page_->Cuts(),
-                                  original_page_->is_dense,
-                                  original_page_->row_stride, sample_rows));
-
-  // Compact the ELLPACK pages into the single sample page.
-  thrust::fill(dh::tbegin(page_->gidx_buffer), dh::tend(page_->gidx_buffer), 0);
+  // Poisson-sample and scale the gradients in place, recording each row's
+  // selection flag for the compaction scan in the same pass.
+  PoissonSampling poisson(dh::ToSpan(threshold_), threshold_index,
+                          RandomWeight(common::GlobalRandom()()));
+  auto d_flags = dh::ToSpan(sample_row_index_);
+  dh::LaunchN(batch_param_.gpu_id, n_rows, [=] __device__(size_t i) mutable {
+    GradientPair sampled = poisson(gpair[i], i);
+    gpair[i] = sampled;
+    d_flags[i] = IsNonZero()(sampled);
+  });
+
+  // Compact the gradient pairs and build the sample row indexes.
+  size_t sample_rows = CompactSelectedRows(batch_param_.gpu_id, gpair, &gpair_,
+                                           &sample_row_index_);
+
+  // Size the pooled sample page and compact the ELLPACK pages into it.
+  ResizeSamplePage(&page_, original_page_, batch_param_.gpu_id, sample_rows);
   for (auto& batch : dmat->GetBatches<EllpackPage>(batch_param_)) {
     page_->Compact(batch_param_.gpu_id, batch.Impl(), dh::ToSpan(sample_row_index_));
   }
@@ -354,6 +371,7 @@ GradientBasedSampler::GradientBasedSampler(EllpackPageImpl* page,
 // Sample a DMatrix based on the given gradient pairs.
 GradientBasedSample GradientBasedSampler::Sample(common::Span<GradientPair> gpair,
                                                  DMatrix* dmat) {
+  dh::MemoryScope mem_scope("gradient_based_sampler");
   monitor_.Start("Sample");
   GradientBasedSample sample = strategy_->Sample(gpair, dmat);
   monitor_.Stop("Sample");
@@ -49,6 +49,16 @@ XGBOOST_DEV_INLINE __host__ T CreateRoundingFactor(T max_abs, int n) {
 }
 
 namespace {
+/* Fixed-point parameters of the shared-memory accumulator.  Elements are
+   quantized to kFixedPointBits fractional bits relative to a power-of-two
+   bound on the largest absolute element, so each quantized value fits in
+   (kFixedPointBits + 1) bits.  With at most 1024 threads per block and a
+   spill every kItersPerSpill block-wide iterations, a single bin accumulates
+   at most 1024 * kItersPerSpill * 2^kFixedPointBits = 2^30 between spills,
+   which cannot overflow a 32-bit counter. */
+constexpr int kFixedPointBits = 15;
+constexpr size_t kItersPerSpill = 32;
+
 struct Pair {
   GradientPair first;
   GradientPair second;
@@ -56,6 +66,21 @@ struct Pair {
 __host__ XGBOOST_DEV_INLINE Pair operator+(Pair const& lhs, Pair const& rhs) {
   return {lhs.first + rhs.first, lhs.second + rhs.second};
 }
+
+struct MaxAbs : public thrust::unary_function<GradientPair, GradientPair> {
+  XGBOOST_DEV_INLINE GradientPair operator()(GradientPair x) const {
+    return {std::abs(x.GetGrad()), std::abs(x.GetHess())};
+  }
+};
+
+struct PairwiseMax : public thrust::binary_function<GradientPair, GradientPair,
+                                                    GradientPair> {
+  XGBOOST_DEV_INLINE GradientPair operator()(GradientPair const& lhs,
+                                             GradientPair const& rhs) const {
+    return {std::max(lhs.GetGrad(), rhs.GetGrad()),
+            std::max(lhs.GetHess(), rhs.GetHess())};
+  }
+};
 }  // anonymous namespace
 
 struct Clip : public thrust::unary_function<GradientPair, Pair> {
@@ -78,7 +103,7 @@ struct Clip : public thrust::unary_function<GradientPair, Pair> {
 };
 
 template <typename GradientSumT>
-GradientSumT CreateRoundingFactor(common::Span<GradientPair const> gpair) {
+HistRounding<GradientSumT> CreateRoundingFactor(common::Span<GradientPair const> gpair) {
   using T = typename GradientSumT::ValueT;
   dh::XGBCachingDeviceAllocator<char> alloc;
 
@@ -94,59 +119,211 @@ GradientSumT CreateRoundingFactor(common::Span<GradientPair const> gpair) {
                             gpair.size()),
     CreateRoundingFactor<T>(std::max(positive_sum.GetHess(), negative_sum.GetHess()),
                             gpair.size()) };
-  return histogram_rounding;
+
+  // The fixed-point scale of the shared-memory accumulator is bounded by the
+  // largest absolute element, so each quantized gradient keeps
+  // kFixedPointBits bits of precision relative to its own magnitude.
+  auto abs_beg = thrust::make_transform_iterator(gpair_beg, MaxAbs());
+  auto abs_end = thrust::make_transform_iterator(gpair_end, MaxAbs());
+  GradientPair max_el = dh::Reduce(thrust::cuda::par(alloc), abs_beg, abs_end,
+                                   GradientPair{}, PairwiseMax{});
+  GradientSumT to_fixed_point {
+    static_cast<T>(1 << kFixedPointBits) /
+        CreateRoundingFactor<T>(max_el.GetGrad(), 1),
+    static_cast<T>(1 << kFixedPointBits) /
+        CreateRoundingFactor<T>(max_el.GetHess(), 1)};
+
+  return {histogram_rounding, to_fixed_point};
 }
 
-template GradientPairPrecise CreateRoundingFactor(common::Span<GradientPair const> gpair);
-template GradientPair CreateRoundingFactor(common::Span<GradientPair const> gpair);
+template HistRounding<GradientPairPrecise>
+CreateRoundingFactor<GradientPairPrecise>(common::Span<GradientPair const> gpair);
+template HistRounding<GradientPair>
+CreateRoundingFactor<GradientPair>(common::Span<GradientPair const> gpair);
 
-template <typename GradientSumT>
+XGBOOST_DEV_INLINE int QuantizeToFixedPoint(float v) {
+  return __float2int_rn(v);
+}
+XGBOOST_DEV_INLINE int QuantizeToFixedPoint(double v) {
+  return __double2int_rn(v);
+}
+
+/* Aggregate the quantized gradients of all lanes in the warp that hit the
+   same bin and issue one shared-memory atomic per distinct bin.  On skewed
+   (e.g. categorical) features most lanes of a warp collide on a handful of
+   bins, and the pre-reduction removes the serialization those colliding
+   atomics would cause. */
+XGBOOST_DEV_INLINE void AggregatedAtomicAdd(int* smem_arr, int bin, int qg,
+                                            int qh) {
+#if __CUDA_ARCH__ >= 700
+  int lane = threadIdx.x % 32;
+  unsigned peers = __match_any_sync(__activemask(), bin);
+  int leader = __ffs(peers) - 1;
+  int sum_g = qg;
+  int sum_h = qh;
+  // Fold every other peer's value onto the leader.  Peer groups for distinct
+  // bins have disjoint masks and iterate independently.
+  for (unsigned remaining = peers & ~(1u << leader); remaining != 0;
+       remaining &= remaining - 1) {
+    int src = __ffs(remaining) - 1;
+    int g = __shfl_sync(peers, qg, src);
+    int h = __shfl_sync(peers, qh, src);
+    if (lane == leader) {
+      sum_g += g;
+      sum_h += h;
+    }
+  }
+  if (lane == leader) {
+    atomicAdd(&smem_arr[bin * 2], sum_g);
+    atomicAdd(&smem_arr[bin * 2 + 1], sum_h);
+  }
+#else
+  atomicAdd(&smem_arr[bin * 2], qg);
+  atomicAdd(&smem_arr[bin * 2 + 1], qh);
+#endif
+}
+
+/* Prepare a gradient pair for accumulation.  The deterministic path truncates
+   it so the subsequent floating point additions commute; the fast path adds
+   the raw value. */
+template <bool kDeterministic, typename GradientSumT>
+XGBOOST_DEV_INLINE GradientSumT
+AdjustForAccumulation(HistRounding<GradientSumT> const& roundings,
+                      GradientPair const& gpair) {
+  using T = typename GradientSumT::ValueT;
+  if (kDeterministic) {
+    return {TruncateWithRoundingFactor<T>(roundings.rounding.GetGrad(),
+                                          gpair.GetGrad()),
+            TruncateWithRoundingFactor<T>(roundings.rounding.GetHess(),
+                                          gpair.GetHess())};
+  }
+  return {static_cast<T>(gpair.GetGrad()), static_cast<T>(gpair.GetHess())};
+}
+
+template <typename GradientSumT, bool kDeterministic>
 __global__ void SharedMemHistKernel(EllpackDeviceAccessor matrix,
                                     FeatureGroupsAccessor feature_groups,
                                     common::Span<const RowPartitioner::RowIndexT> d_ridx,
                                     GradientSumT* __restrict__ d_node_hist,
                                     const GradientPair* __restrict__ d_gpair,
-                                    GradientSumT const rounding,
+                                    HistRounding<GradientSumT> const roundings,
                                     bool use_shared_memory_histograms) {
   using T = typename GradientSumT::ValueT;
   extern __shared__ char smem[];
   FeatureGroup group = feature_groups[blockIdx.y];
-  GradientSumT* smem_arr = reinterpret_cast<GradientSumT*>(smem);  // NOLINT
-  if (use_shared_memory_histograms) {
-    dh::BlockFill(smem_arr, group.num_bins, GradientSumT());
-    __syncthreads();
-  }
   int feature_stride = matrix.is_dense ? group.num_features : matrix.row_stride;
   size_t n_elements = feature_stride * d_ridx.size();
-  for (auto idx : dh::GridStrideRange(static_cast<size_t>(0), n_elements)) {
-    int ridx = d_ridx[idx / feature_stride];
-    int gidx = matrix.gidx_iter[ridx * matrix.row_stride + group.start_feature +
-                                idx % feature_stride];
-    if (gidx != matrix.NumBins()) {
-      GradientSumT truncated {
-        TruncateWithRoundingFactor<T>(rounding.GetGrad(), d_gpair[ridx].GetGrad()),
-        TruncateWithRoundingFactor<T>(rounding.GetHess(), d_gpair[ridx].GetHess()),
-      };
-      // If we are not using shared memory, accumulate the values directly into
-      // global memory
-      GradientSumT* atomic_add_ptr =
-        use_shared_memory_histograms ? smem_arr : d_node_hist;
-      gidx = use_shared_memory_histograms ? gidx - group.start_bin : gidx;
-      dh::AtomicAddGpair(atomic_add_ptr + gidx, truncated);
-    }
-  }
 
-  if (use_shared_memory_histograms) {
-    // Write shared memory back to global memory
+  if (!use_shared_memory_histograms) {
+    for (auto idx : dh::GridStrideRange(static_cast<size_t>(0), n_elements)) {
+      int ridx = d_ridx[idx / feature_stride];
+      int gidx = matrix.gidx_iter[ridx * matrix.row_stride + group.start_feature +
+                                  idx % feature_stride];
+      if (gidx != matrix.NumBins()) {
+        dh::AtomicAddGpair(d_node_hist + gidx,
+                           AdjustForAccumulation<kDeterministic>(
+                               roundings, d_gpair[ridx]));
+      }
+    }
+  } else if (!kDeterministic) {
+    /* Fast mode: the shared histogram holds GradientSumT bins accumulated
+       with plain atomics and flushed to global memory once at the end.  The
+       additions race, so the result varies from run to run, but neither
+       truncation nor fixed-point quantization is applied. */
+    GradientSumT* smem_hist = reinterpret_cast<GradientSumT*>(smem);  // NOLINT
+    for (auto i : dh::BlockStrideRange(0, group.num_bins)) {
+      smem_hist[i] = GradientSumT{};
+    }
+    __syncthreads();
+    for (auto idx : dh::GridStrideRange(static_cast<size_t>(0), n_elements)) {
+      int ridx = d_ridx[idx / feature_stride];
+      int gidx = matrix.gidx_iter[ridx * matrix.row_stride +
+                                  group.start_feature + idx % feature_stride];
+      if (gidx != matrix.NumBins()) {
+        dh::AtomicAddGpair(smem_hist + gidx - group.start_bin,
+                           GradientSumT{static_cast<T>(d_gpair[ridx].GetGrad()),
+                                        static_cast<T>(d_gpair[ridx].GetHess())});
+      }
+    }
     __syncthreads();
     for (auto i : dh::BlockStrideRange(0, group.num_bins)) {
-      GradientSumT truncated{
-          TruncateWithRoundingFactor<T>(rounding.GetGrad(),
-                                        smem_arr[i].GetGrad()),
-          TruncateWithRoundingFactor<T>(rounding.GetHess(),
-                                        smem_arr[i].GetHess()),
-      };
-      dh::AtomicAddGpair(d_node_hist + group.start_bin + i, truncated);
+      GradientSumT const sum = smem_hist[i];
+      if (sum.GetGrad() != 0 || sum.GetHess() != 0) {
+        dh::AtomicAddGpair(d_node_hist + group.start_bin + i, sum);
+      }
+    }
+  } else {
+    /* The deterministic shared histogram accumulates in 32-bit fixed point:
+       integer additions are exactly associative, a bin takes half (float
+       pairs) to a quarter (double pairs) of the memory of a GradientSumT bin,
+       and warp-aggregated integer atomics replace the contended 64-bit
+       ones. */
+    int* smem_arr = reinterpret_cast<int*>(smem);  // NOLINT
+    for (auto i : dh::BlockStrideRange(0, group.num_bins * 2)) {
+      smem_arr[i] = 0;
+    }
+    __syncthreads();
+    // The quantization scale is an exact power of two, so its reciprocal is
+    // the exact dequantization step.
+    T const grad_step = T(1) / roundings.to_fixed_point.GetGrad();
+    T const hess_step = T(1) / roundings.to_fixed_point.GetHess();
+    size_t const stride = static_cast<size_t>(blockDim.x) * gridDim.x;
+    size_t const base = blockIdx.x * blockDim.x + threadIdx.x;
+    size_t const n_iters = common::DivRoundUp(n_elements, stride);
+    for (size_t it = 0; it < n_iters; ++it) {
+      size_t idx = base + it * stride;
+      if (idx < n_elements) {
+        int ridx = d_ridx[idx / feature_stride];
+        int gidx = matrix.gidx_iter[ridx * matrix.row_stride +
+                                    group.start_feature + idx % feature_stride];
+        if (gidx != matrix.NumBins()) {
+          int bin = gidx - group.start_bin;
+          int qg = QuantizeToFixedPoint(d_gpair[ridx].GetGrad() *
+                                        roundings.to_fixed_point.GetGrad());
+          int qh = QuantizeToFixedPoint(d_gpair[ridx].GetHess() *
+                                        roundings.to_fixed_point.GetHess());
+          AggregatedAtomicAdd(smem_arr, bin, qg, qh);
+        }
+      }
+      // Spill periodically so a heavily hit bin cannot overflow its 32-bit
+      // counter, then on the last iteration to flush the remainder.
+      if ((it + 1) % kItersPerSpill == 0 || it + 1 == n_iters) {
+        __syncthreads();
+        for (auto i : dh::BlockStrideRange(0, group.num_bins)) {
+          int qg = smem_arr[i * 2];
+          int qh = smem_arr[i * 2 + 1];
+          if (qg != 0 || qh != 0) {
+            GradientSumT truncated {
+              TruncateWithRoundingFactor<T>(roundings.rounding.GetGrad(),
+                                            qg * grad_step),
+              TruncateWithRoundingFactor<T>(roundings.rounding.GetHess(),
+                                            qh * hess_step),
+            };
+            dh::AtomicAddGpair(d_node_hist + group.start_bin + i, truncated);
+            smem_arr[i * 2] = 0;
+            smem_arr[i * 2 + 1] = 0;
+          }
+        }
+        __syncthreads();
+      }
+    }
+  }
+
+  // Tails of rows longer than the dense stride live in the overflow CSR
+  // section.  Overflow rows are rare outliers and their segment lengths are
+  // unbounded, so their gradients go straight to global memory instead of the
+  // spill-managed shared accumulator.
+  if (!matrix.overflow_row_ptr.empty()) {
+    size_t overflow_base = matrix.n_rows * matrix.row_stride;
+    for (auto i : dh::GridStrideRange(static_cast<size_t>(0), d_ridx.size())) {
+      int ridx = d_ridx[i];
+      for (size_t j = matrix.overflow_row_ptr[ridx];
+           j < matrix.overflow_row_ptr[ridx + 1]; ++j) {
+        int gidx = matrix.gidx_iter[overflow_base + j];
+        dh::AtomicAddGpair(d_node_hist + gidx,
+                           AdjustForAccumulation<kDeterministic>(
+                               roundings, d_gpair[ridx]));
+      }
     }
   }
 }
@@ -157,17 +334,26 @@ void BuildGradientHistogram(EllpackDeviceAccessor const& matrix,
                             common::Span<GradientPair const> gpair,
                             common::Span<const uint32_t> d_ridx,
                             common::Span<GradientSumT> histogram,
-                            GradientSumT rounding) {
-  // decide whether to use shared memory
+                            HistRounding<GradientSumT> rounding,
+                            cudaStream_t stream) {
+  // A zeroed rounding factor requests the fast non-deterministic mode;
+  // CreateRoundingFactor never produces one itself.
+  bool deterministic = rounding.IsDeterministic();
+
+  // decide whether to use shared memory; the deterministic accumulator holds
+  // two 32-bit fixed-point counters per bin regardless of GradientSumT, the
+  // fast one a GradientSumT per bin
   int device = 0;
   dh::safe_cuda(cudaGetDevice(&device));
   int max_shared_memory = dh::MaxSharedMemoryOptin(device);
-  size_t smem_size = sizeof(GradientSumT) * feature_groups.max_group_bins;
+  size_t bin_size = deterministic ? 2 * sizeof(int) : sizeof(GradientSumT);
+  size_t smem_size = bin_size * feature_groups.max_group_bins;
   bool shared = smem_size <= max_shared_memory;
   smem_size = shared ? smem_size : 0;
 
   // opt into maximum shared memory for the kernel if necessary
-  auto kernel = SharedMemHistKernel<GradientSumT>;
+  auto kernel = deterministic ? SharedMemHistKernel<GradientSumT, true>
+                              : SharedMemHistKernel<GradientSumT, false>;
   if (shared) {
     dh::safe_cuda(cudaFuncSetAttribute
                   (kernel, cudaFuncAttributeMaxDynamicSharedMemorySize,
@@ -204,7 +390,8 @@ void BuildGradientHistogram(EllpackDeviceAccessor const& matrix,
       common::DivRoundUp(num_groups, num_groups_threshold));
 
   dh::LaunchKernel {
-    dim3(grid_size, num_groups), static_cast<uint32_t>(block_threads), smem_size} (
+    dim3(grid_size, num_groups), static_cast<uint32_t>(block_threads), smem_size,
+    stream} (
       kernel,
       matrix, feature_groups, d_ridx, histogram.data(), gpair.data(), rounding,
       shared);
@@ -217,7 +404,8 @@ template void BuildGradientHistogram<GradientPair>(
     common::Span<GradientPair const> gpair,
     common::Span<const uint32_t> ridx,
     common::Span<GradientPair> histogram,
-    GradientPair rounding);
+    HistRounding<GradientPair> rounding,
+    cudaStream_t stream);
 
 template void BuildGradientHistogram<GradientPairPrecise>(
     EllpackDeviceAccessor const& matrix,
@@ -225,7 +413,8 @@ template void BuildGradientHistogram<GradientPairPrecise>(
     common::Span<GradientPair const> gpair,
     common::Span<const uint32_t> ridx,
     common::Span<GradientPairPrecise> histogram,
-    GradientPairPrecise rounding);
+    HistRounding<GradientPairPrecise> rounding,
+    cudaStream_t stream);
 
 }  // namespace tree
 }  // namespace xgboost
@@ -12,8 +12,30 @@
 namespace xgboost {
 namespace tree {
 
+/* \brief Rounding factors for reproducible histogram accumulation.
+ *
+ * `rounding` truncates values before global-memory accumulation so the
+ * floating point additions become associative; `to_fixed_point` scales
+ * gradients into the 32-bit fixed-point shared-memory accumulator and is
+ * derived from the largest absolute element, so each quantized value keeps
+ * the full fixed-point precision.
+ *
+ * A zero `rounding` selects the fast non-deterministic mode instead:
+ * gradients are accumulated as-is with plain atomics, skipping both the
+ * truncation and the fixed-point quantization, at the cost of run-to-run
+ * jitter from the racing additions. */
 template <typename GradientSumT>
-GradientSumT CreateRoundingFactor(common::Span<GradientPair const> gpair);
+struct HistRounding {
+  GradientSumT rounding;
+  GradientSumT to_fixed_point;
+
+  bool IsDeterministic() const {
+    return rounding.GetGrad() != 0 || rounding.GetHess() != 0;
+  }
+};
+
+template <typename GradientSumT>
+HistRounding<GradientSumT> CreateRoundingFactor(common::Span<GradientPair const> gpair);
 
 template <typename T>
 XGBOOST_DEV_INLINE T TruncateWithRoundingFactor(T const rounding_factor, float const x) {
@@ -26,7 +48,8 @@ void BuildGradientHistogram(EllpackDeviceAccessor const& matrix,
                             common::Span<GradientPair const> gpair,
                             common::Span<const uint32_t> ridx,
                             common::Span<GradientSumT> histogram,
-                            GradientSumT rounding);
+                            HistRounding<GradientSumT> rounding,
+                            cudaStream_t stream = nullptr);
 }  // namespace tree
 }  // namespace xgboost
 
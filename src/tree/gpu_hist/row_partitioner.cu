@@ -87,32 +87,46 @@ void RowPartitioner::SortPosition(common::Span<bst_node_t> position,
   cub::DeviceScan::InclusiveScan(nullptr, temp_bytes, input_iterator,
                                  discard_write_iterator, IndexFlagOp(),
                                  position.size(), stream);
-  dh::TemporaryArray<int8_t> temp(temp_bytes);
-  cub::DeviceScan::InclusiveScan(temp.data().get(), temp_bytes, input_iterator,
-                                 discard_write_iterator, IndexFlagOp(),
-                                 position.size(), stream);
-}
-
-void Reset(int device_idx, common::Span<RowPartitioner::RowIndexT> ridx,
-           common::Span<bst_node_t> position) {
-  CHECK_EQ(ridx.size(), position.size());
-  dh::LaunchN(device_idx, ridx.size(), [=] __device__(size_t idx) {
-    ridx[idx] = idx;
-    position[idx] = 0;
-  });
+  if (scan_temp_.size() < temp_bytes) {
+    // Synchronise before growing: earlier scans queued in the stream may
+    // still be using the old allocation.
+    dh::safe_cuda(cudaStreamSynchronize(stream));
+    scan_temp_.resize(temp_bytes);
+  }
+  cub::DeviceScan::InclusiveScan(scan_temp_.data().get(), temp_bytes,
+                                 input_iterator, discard_write_iterator,
+                                 IndexFlagOp(), position.size(), stream);
 }
 
 RowPartitioner::RowPartitioner(int device_idx, size_t num_rows)
-    : device_idx_(device_idx), ridx_a_(num_rows), position_a_(num_rows) {
+    : device_idx_(device_idx) {
   dh::safe_cuda(cudaSetDevice(device_idx_));
-  Reset(device_idx, dh::ToSpan(ridx_a_), dh::ToSpan(position_a_));
   left_counts_.resize(256);
-  thrust::fill(left_counts_.begin(), left_counts_.end(), 0);
   streams_.resize(2);
-  ridx_segments_.emplace_back(Segment(0, num_rows));
   for (auto& stream : streams_) {
     dh::safe_cuda(cudaStreamCreate(&stream));
   }
+  this->Reset(num_rows);
+}
+
+void RowPartitioner::Reset(size_t num_rows) {
+  dh::safe_cuda(cudaSetDevice(device_idx_));
+  // Grown monotonically: the vectors keep their capacity when a later tree
+  // trains on fewer rows.
+  ridx_a_.resize(num_rows);
+  position_a_.resize(num_rows);
+  ridx_b_.resize(num_rows);
+  position_b_.resize(num_rows);
+  thrust::fill(left_counts_.begin(), left_counts_.end(), 0);
+  ridx_segments_.clear();
+  ridx_segments_.emplace_back(Segment(0, num_rows));
+
+  auto d_ridx = dh::ToSpan(ridx_a_);
+  auto d_position = dh::ToSpan(position_a_);
+  dh::LaunchN(device_idx_, num_rows, [=] __device__(size_t idx) {
+    d_ridx[idx] = idx;
+    d_position[idx] = 0;
+  });
 }
 RowPartitioner::~RowPartitioner() {
   dh::safe_cuda(cudaSetDevice(device_idx_));
@@ -159,25 +173,23 @@ void RowPartitioner::SortPositionAndCopy(const Segment& segment,
                                          bst_node_t right_nidx,
                                          int64_t* d_left_count,
                                          cudaStream_t stream) {
-  dh::TemporaryArray<bst_node_t> position_temp(position_a_.size());
-  dh::TemporaryArray<RowIndexT> ridx_temp(ridx_a_.size());
   SortPosition(
       // position_in
       common::Span<bst_node_t>(position_a_.data().get() + segment.begin,
                                segment.Size()),
       // position_out
-      common::Span<bst_node_t>(position_temp.data().get() + segment.begin,
+      common::Span<bst_node_t>(position_b_.data().get() + segment.begin,
                                segment.Size()),
       // row index in
       common::Span<RowIndexT>(ridx_a_.data().get() + segment.begin, segment.Size()),
       // row index out
-      common::Span<RowIndexT>(ridx_temp.data().get() + segment.begin, segment.Size()),
+      common::Span<RowIndexT>(ridx_b_.data().get() + segment.begin, segment.Size()),
       left_nidx, right_nidx, d_left_count, stream);
   // Copy back key/value
   const auto d_position_current = position_a_.data().get() + segment.begin;
-  const auto d_position_other = position_temp.data().get() + segment.begin;
+  const auto d_position_other = position_b_.data().get() + segment.begin;
   const auto d_ridx_current = ridx_a_.data().get() + segment.begin;
-  const auto d_ridx_other = ridx_temp.data().get() + segment.begin;
+  const auto d_ridx_other = ridx_b_.data().get() + segment.begin;
   dh::LaunchN(device_idx_, segment.Size(), stream, [=] __device__(size_t idx) {
     d_position_current[idx] = d_position_other[idx];
     d_ridx_current[idx] = d_ridx_other[idx];
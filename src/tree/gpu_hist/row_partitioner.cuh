@@ -2,6 +2,9 @@
  * Copyright 2017-2019 XGBoost contributors
  */
 #pragma once
+#include <thrust/binary_search.h>
+#include <thrust/execution_policy.h>
+#include <vector>
 #include "xgboost/base.h"
 #include "../../common/device_helpers.cuh"
 
@@ -27,14 +30,57 @@ __forceinline__ __device__ void AtomicIncrement(int64_t* d_count, bool increment
 #endif
 }
 
+/*! \brief Count how many rows are assigned to left node.  Unlike
+ * `AtomicIncrement`, lanes of a warp may target different counters, as happens
+ * on segment boundaries of a batched position update. */
+__forceinline__ __device__ void AtomicIncrementMulti(int64_t* d_count,
+                                                     bool increment) {
+#if __CUDA_ARCH__ >= 700
+  unsigned peers = __match_any_sync(
+      __activemask(), reinterpret_cast<unsigned long long>(d_count));
+  unsigned ballot = __ballot_sync(peers, increment);
+  int leader = __ffs(peers) - 1;
+  if (threadIdx.x % 32 == leader) {
+    atomicAdd(reinterpret_cast<unsigned long long*>(d_count),    // NOLINT
+              static_cast<unsigned long long>(__popc(ballot)));  // NOLINT
+  }
+#else
+  if (increment) {
+    atomicAdd(reinterpret_cast<unsigned long long*>(d_count), 1ull);  // NOLINT
+  }
+#endif
+}
+
 /** \brief Class responsible for tracking subsets of rows as we add splits and
  * partition training rows into different leaf nodes. */
 class RowPartitioner {
  public:
   using RowIndexT = bst_uint;
-  struct Segment;
   static constexpr bst_node_t kIgnoredTreePosition = -1;
 
+  /** \brief Used to demarcate a contiguous set of row indices associated with
+   * some tree node. */
+  struct Segment {
+    size_t begin { 0 };
+    size_t end { 0 };
+
+    Segment() = default;
+
+    Segment(size_t begin, size_t end) : begin(begin), end(end) {
+      CHECK_GE(end, begin);
+    }
+    size_t Size() const { return end - begin; }
+  };
+
+  /** \brief Per-node data of a batched position update, see
+   * `UpdatePositionBatch`. */
+  struct NodeBatchEntry {
+    Segment segment;
+    bst_node_t nidx;
+    bst_node_t left_nidx;
+    bst_node_t right_nidx;
+  };
+
  private:
   int device_idx_;
   /*! \brief In here if you want to find the rows belong to a node nid, first you need to
@@ -46,8 +92,18 @@ class RowPartitioner {
    */
   /*! \brief Range of row index for each node, pointers into ridx below. */
   std::vector<Segment> ridx_segments_;
-  dh::TemporaryArray<RowIndexT> ridx_a_;
-  dh::TemporaryArray<bst_node_t> position_a_;
+  /*! \brief Row index and position buffers together with the double buffers
+   * used for sorting.  Sized by `Reset` and only ever grown, so a partitioner
+   * can be reused across trees without per-tree allocations. */
+  dh::caching_device_vector<RowIndexT> ridx_a_;
+  dh::caching_device_vector<bst_node_t> position_a_;
+  dh::caching_device_vector<RowIndexT> ridx_b_;
+  dh::caching_device_vector<bst_node_t> position_b_;
+  /*! \brief Scratch memory of the partitioning scan, grown monotonically. */
+  dh::caching_device_vector<int8_t> scan_temp_;
+  /*! \brief Staging buffers of batched position updates. */
+  dh::caching_device_vector<NodeBatchEntry> batch_entries_;
+  dh::caching_device_vector<size_t> batch_offsets_;
   dh::caching_device_vector<int64_t>
       left_counts_;  // Useful to keep a bunch of zeroed memory for sort position
   std::vector<cudaStream_t> streams_;
@@ -59,6 +115,13 @@ class RowPartitioner {
   RowPartitioner(const RowPartitioner&) = delete;
   RowPartitioner& operator=(const RowPartitioner&) = delete;
 
+  /**
+   * \brief Reinitialises the partitioner for a new tree, assigning all rows to
+   * the root node.  Device buffers are reused and grown as needed, so
+   * resetting is much cheaper than constructing a new partitioner.
+   */
+  void Reset(size_t num_rows);
+
   /**
    * \brief Gets the row indices of training instances in a given node.
    */
@@ -137,6 +200,94 @@ class RowPartitioner {
         Segment(segment.begin + left_count, segment.end);
   }
 
+  /**
+   * \brief Updates the tree position of every node in the current frontier
+   * with a single segmented pass over the concatenated row segments.  The
+   * per-node launch and host synchronisation of `UpdatePosition` add up on
+   * wide frontiers; the batched form pays them once per tree level instead.
+   *
+   * \param nidx        Indices of the nodes being split.
+   * \param left_nidx   Left child index of each node.
+   * \param right_nidx  Right child index of each node.
+   * \param op          Device lambda. Should provide the row index and the
+   * index of the node being split as arguments and return the new position for
+   * this training instance.
+   */
+  template <typename UpdatePositionOpT>
+  void UpdatePositionBatch(const std::vector<bst_node_t>& nidx,
+                           const std::vector<bst_node_t>& left_nidx,
+                           const std::vector<bst_node_t>& right_nidx,
+                           UpdatePositionOpT op) {
+    if (nidx.empty()) {
+      return;
+    }
+    CHECK_EQ(nidx.size(), left_nidx.size());
+    CHECK_EQ(nidx.size(), right_nidx.size());
+    // Stage the node segments together with the exclusive scan of their sizes,
+    // which maps a thread of the concatenated launch back to its node.
+    std::vector<NodeBatchEntry> entries(nidx.size());
+    std::vector<size_t> offsets(nidx.size() + 1, 0);
+    bst_node_t max_nidx = 0;
+    for (size_t i = 0; i < nidx.size(); ++i) {
+      entries[i] = NodeBatchEntry{ridx_segments_.at(nidx[i]), nidx[i],
+                                  left_nidx[i], right_nidx[i]};
+      offsets[i + 1] = offsets[i] + entries[i].segment.Size();
+      max_nidx = std::max(max_nidx, std::max(left_nidx[i], right_nidx[i]));
+    }
+    dh::CopyToD(entries, &batch_entries_);
+    dh::CopyToD(offsets, &batch_offsets_);
+    if (left_counts_.size() <= static_cast<size_t>(max_nidx)) {
+      left_counts_.resize(max_nidx * 2 + 1);
+      thrust::fill(left_counts_.begin(), left_counts_.end(), 0);
+    }
+
+    auto d_ridx = dh::ToSpan(ridx_a_);
+    auto d_position = dh::ToSpan(position_a_);
+    auto d_entries = dh::ToSpan(batch_entries_);
+    auto d_offsets = dh::ToSpan(batch_offsets_);
+    int64_t* d_left_counts = left_counts_.data().get();
+    // Launch 1 thread for each row of the concatenated segments
+    dh::LaunchN<1, 128>(
+        device_idx_, offsets.back(), [=] __device__(size_t idx) {
+          size_t batch_idx = thrust::upper_bound(thrust::seq,
+                                                 d_offsets.begin() + 1,
+                                                 d_offsets.end(), idx) -
+                             (d_offsets.begin() + 1);
+          NodeBatchEntry entry = d_entries[batch_idx];
+          size_t seg_idx = entry.segment.begin + (idx - d_offsets[batch_idx]);
+          RowIndexT ridx = d_ridx[seg_idx];
+          bst_node_t new_position = op(ridx, entry.nidx);
+          KERNEL_CHECK(new_position == entry.left_nidx ||
+                       new_position == entry.right_nidx);
+          AtomicIncrementMulti(d_left_counts + entry.nidx,
+                               new_position == entry.left_nidx);
+          d_position[seg_idx] = new_position;
+        });
+    // Overlap the device to host copy of the counts with the sorts, which
+    // touch disjoint segments and need no synchronisation in between.
+    auto left_counts = pinned_.GetSpan<int64_t>(nidx.size());
+    for (size_t i = 0; i < nidx.size(); ++i) {
+      dh::safe_cuda(cudaMemcpyAsync(&left_counts[i], d_left_counts + nidx[i],
+                                    sizeof(int64_t), cudaMemcpyDeviceToHost,
+                                    streams_[0]));
+      SortPositionAndCopy(entries[i].segment, left_nidx[i], right_nidx[i],
+                          d_left_counts + nidx[i], streams_[1]);
+    }
+    dh::safe_cuda(cudaStreamSynchronize(streams_[0]));
+
+    ridx_segments_.resize(std::max(static_cast<bst_node_t>(ridx_segments_.size()),
+                                   max_nidx + 1));
+    for (size_t i = 0; i < nidx.size(); ++i) {
+      auto segment = entries[i].segment;
+      CHECK_LE(left_counts[i], segment.Size());
+      CHECK_GE(left_counts[i], 0);
+      ridx_segments_[left_nidx[i]] =
+          Segment(segment.begin, segment.begin + left_counts[i]);
+      ridx_segments_[right_nidx[i]] =
+          Segment(segment.begin + left_counts[i], segment.end);
+    }
+  }
+
   /**
    * \brief Finalise the position of all training instances after tree
    * construction is complete. Does not update any other meta information in
@@ -175,19 +326,6 @@ class RowPartitioner {
   void SortPositionAndCopy(const Segment& segment, bst_node_t left_nidx,
                            bst_node_t right_nidx, int64_t* d_left_count,
                            cudaStream_t stream);
-  /** \brief Used to demarcate a contiguous set of row indices associated with
-   * some tree node. */
-  struct Segment {
-    size_t begin { 0 };
-    size_t end { 0 };
-
-    Segment() = default;
-
-    Segment(size_t begin, size_t end) : begin(begin), end(end) {
-      CHECK_GE(end, begin);
-    }
-    size_t Size() const { return end - begin; }
-  };
 };
 };  // namespace tree
 };  // namespace xgboost
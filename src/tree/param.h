@@ -51,7 +51,7 @@ struct TrainParam : public XGBoostParameter<TrainParam> {
   // whether we want to do subsample
   float subsample;
   // sampling method
-  enum SamplingMethod { kUniform = 0, kGradientBased = 1 };
+  enum SamplingMethod { kUniform = 0, kGradientBased = 1, kStratified = 2 };
   int sampling_method;
   // whether to subsample columns in each split (node)
   float colsample_bynode;
@@ -151,10 +151,13 @@ struct TrainParam : public XGBoostParameter<TrainParam> {
         .set_default(kUniform)
         .add_enum("uniform", kUniform)
         .add_enum("gradient_based", kGradientBased)
+        .add_enum("stratified", kStratified)
         .describe(
             "Sampling method. 0: select random training instances uniformly. "
             "1: select random training instances with higher probability when the "
-            "gradient and hessian are larger. (cf. CatBoost)");
+            "gradient and hessian are larger. (cf. CatBoost) "
+            "2: select the subsample fraction of every label class exactly, "
+            "keeping the class balance of the sample.");
     DMLC_DECLARE_FIELD(colsample_bynode)
         .set_range(0.0f, 1.0f)
         .set_default(1.0f)
@@ -391,6 +394,11 @@ struct SplitEntryContainer {
   /*! \brief split index */
   bst_feature_t sindex{0};
   bst_float split_value{0.0f};
+  /*! \brief whether this is a categorical (many-vs-many) split */
+  bool is_cat{false};
+  /*! \brief bitset over category values whose rows go to the right branch,
+   *         layout matches \ref common::CatBitField */
+  std::vector<uint32_t> cat_bits;
 
   GradientT left_sum;
   GradientT right_sum;
@@ -440,6 +448,8 @@ struct SplitEntryContainer {
       this->loss_chg = e.loss_chg;
       this->sindex = e.sindex;
       this->split_value = e.split_value;
+      this->is_cat = e.is_cat;
+      this->cat_bits = e.cat_bits;
       this->left_sum = e.left_sum;
       this->right_sum = e.right_sum;
       return true;
@@ -466,6 +476,10 @@ struct SplitEntryContainer {
       }
       this->sindex = split_index;
       this->split_value = new_split_value;
+      // the categorical enumerator attaches the bitset after a successful
+      // update; a numeric update invalidates any previous one
+      this->is_cat = false;
+      this->cat_bits.clear();
       this->left_sum = left_sum;
       this->right_sum = right_sum;
       return true;
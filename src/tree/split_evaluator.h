@@ -90,6 +90,38 @@ class TreeEvaluator {
       }
     }
 
+    /*!
+     * \brief Split gain with the loop-invariant constraint state hoisted out
+     *  by the caller.
+     *
+     *  The hist updater loads the feature's monotone direction and the node's
+     *  weight bounds once per (node, feature) pair and passes them in here.
+     *  When \p has_constraint_t is false the instantiation reduces to the
+     *  plain gain formula, so no constraint loads or branches remain in the
+     *  per-bin split loop.
+     */
+    template <bool has_constraint_t>
+    XGBOOST_DEVICE double CalcSplitGainGivenBounds(
+        const ParamT &param, int constraint, float lower_bound,
+        float upper_bound, tree::GradStats const &left,
+        tree::GradStats const &right) const {
+      if (!has_constraint_t) {
+        return UnconstrainedGain(param, left) + UnconstrainedGain(param, right);
+      }
+      const double negative_infinity = -std::numeric_limits<double>::infinity();
+      double wleft = BoundedWeight(param, left, lower_bound, upper_bound);
+      double wright = BoundedWeight(param, right, lower_bound, upper_bound);
+      double gain = this->CalcGainGivenWeight(param, left, wleft) +
+                    this->CalcGainGivenWeight(param, right, wright);
+      if (constraint == 0) {
+        return gain;
+      } else if (constraint > 0) {
+        return wleft <= wright ? gain : negative_infinity;
+      } else {
+        return wleft >= wright ? gain : negative_infinity;
+      }
+    }
+
     XGBOOST_DEVICE float CalcWeight(bst_node_t nodeid, const ParamT &param,
                                     tree::GradStats const& stats) const {
       float w = xgboost::tree::CalcWeight(param, stats);
@@ -124,6 +156,32 @@ class TreeEvaluator {
                                   tree::GradStats const& stats) const {
       return this->CalcGainGivenWeight(p, stats, this->CalcWeight(nid, p, stats));
     }
+
+    XGBOOST_DEVICE static float UnconstrainedGain(ParamT const &p,
+                                                  tree::GradStats const &stats) {
+      if (stats.GetHess() <= 0) {
+        return .0f;
+      }
+      if (p.max_delta_step == 0.0f) {
+        return Sqr(ThresholdL1(stats.sum_grad, p.reg_alpha)) /
+               (stats.sum_hess + p.reg_lambda);
+      }
+      return tree::CalcGainGivenWeight<ParamT, float>(
+          p, stats.sum_grad, stats.sum_hess, xgboost::tree::CalcWeight(p, stats));
+    }
+
+    XGBOOST_DEVICE static float BoundedWeight(ParamT const &p,
+                                              tree::GradStats const &stats,
+                                              float lower_bound,
+                                              float upper_bound) {
+      float w = xgboost::tree::CalcWeight(p, stats);
+      if (w < lower_bound) {
+        return lower_bound;
+      } else if (w > upper_bound) {
+        return upper_bound;
+      }
+      return w;
+    }
   };
 
  public:
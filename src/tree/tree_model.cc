@@ -10,6 +10,7 @@
 #include <xgboost/logging.h>
 #include <xgboost/json.h>
 
+#include <algorithm>
 #include <sstream>
 #include <limits>
 #include <cmath>
@@ -717,6 +718,10 @@ void RegTree::ExpandCategorical(bst_node_t nid, unsigned split_index,
   this->split_categories_segments_.at(nid).size = split_cat.size();
 }
 
+bool RegTree::CategoricalDecision(bst_node_t nidx, bst_float fvalue) const {
+  return common::Decision(this->NodeCats(nidx), common::AsCat(fvalue));
+}
+
 void RegTree::Load(dmlc::Stream* fi) {
   CHECK_EQ(fi->Read(&param, sizeof(TreeParam)), sizeof(TreeParam));
   if (!DMLC_IO_NO_ENDIAN_SWAP) {
@@ -752,11 +757,34 @@ void RegTree::Load(dmlc::Stream* fi) {
   split_categories_segments_.resize(param.num_nodes);
 }
 
+void RegTree::LoadNodes(TreeParam const& p, std::vector<Node>&& nodes,
+                        std::vector<RTreeNodeStat>&& stats) {
+  param = p;
+  nodes_ = std::move(nodes);
+  stats_ = std::move(stats);
+  CHECK_NE(param.num_nodes, 0);
+  CHECK_EQ(param.num_nodes, static_cast<int>(nodes_.size()));
+  CHECK_EQ(nodes_.size(), stats_.size());
+  // chg deleted nodes
+  deleted_nodes_.resize(0);
+  for (int i = 1; i < param.num_nodes; ++i) {
+    if (nodes_[i].IsDeleted()) {
+      deleted_nodes_.push_back(i);
+    }
+  }
+  CHECK_EQ(static_cast<int>(deleted_nodes_.size()), param.num_deleted);
+
+  split_types_.resize(param.num_nodes, FeatureType::kNumerical);
+  split_categories_segments_.resize(param.num_nodes);
+}
+
 void RegTree::Save(dmlc::Stream* fo) const {
   CHECK_EQ(param.num_nodes, static_cast<int>(nodes_.size()));
   CHECK_EQ(param.num_nodes, static_cast<int>(stats_.size()));
   CHECK_EQ(param.deprecated_num_roots, 1);
   CHECK_NE(param.num_nodes, 0);
+  CHECK(!HasCategoricalSplit())
+      << "Please use JSON serialization for models with categorical splits.";
 
   if (DMLC_IO_NO_ENDIAN_SWAP) {
     fo->Write(&param, sizeof(TreeParam));
@@ -1041,13 +1069,14 @@ bst_float RegTree::FillNodeMeanValue(int nid) {
 }
 
 void RegTree::CalculateContributionsApprox(const RegTree::FVec &feat,
-                                           bst_float *out_contribs) const {
+                                           bst_float *out_contribs,
+                                           bst_float scale) const {
   CHECK_GT(this->node_mean_values_.size(), 0U);
   // this follows the idea of http://blog.datadive.net/interpreting-random-forests/
   unsigned split_index = 0;
   // update bias value
   bst_float node_value = this->node_mean_values_[0];
-  out_contribs[feat.Size()] += node_value;
+  out_contribs[feat.Size()] += node_value * scale;
   if ((*this)[0].IsLeaf()) {
     // nothing to do anymore
     return;
@@ -1058,27 +1087,96 @@ void RegTree::CalculateContributionsApprox(const RegTree::FVec &feat,
     nid = this->GetNext(nid, feat.GetFvalue(split_index), feat.IsMissing(split_index));
     bst_float new_value = this->node_mean_values_[nid];
     // update feature weight
-    out_contribs[split_index] += new_value - node_value;
+    out_contribs[split_index] += (new_value - node_value) * scale;
     node_value = new_value;
   }
   bst_float leaf_value = (*this)[nid].LeafValue();
   // update leaf feature weight
-  out_contribs[split_index] += leaf_value - node_value;
+  out_contribs[split_index] += (leaf_value - node_value) * scale;
 }
 
-// Used by TreeShap
-// data we keep about our decision path
-// note that pweight is included for convenience and is not tied with the other attributes
-// the pweight of the i'th path element is the permuation weight of paths with i-1 ones in them
-struct PathElement {
-  int feature_index;
-  bst_float zero_fraction;
-  bst_float one_fraction;
-  bst_float pweight;
-  PathElement() = default;
-  PathElement(int i, bst_float z, bst_float o, bst_float w) :
-    feature_index(i), zero_fraction(z), one_fraction(o), pweight(w) {}
-};
+void RegTree::CalculateContributionsApprox(const RegTree::FVec &feat,
+                                           bst_float *out_contribs) const {
+  this->CalculateContributionsApprox(feat, out_contribs, 1.0f);
+}
+
+bst_float RegTree::MaxSiblingMeanDelta() const {
+  CHECK_GT(this->node_mean_values_.size(), 0U);
+  bst_float delta = 0.0f;
+  for (bst_node_t nid = 0; nid < param.num_nodes; ++nid) {
+    auto const& node = (*this)[nid];
+    if (node.IsDeleted() || node.IsLeaf()) {
+      continue;
+    }
+    delta = std::max(delta, std::abs(this->node_mean_values_[node.LeftChild()] -
+                                     this->node_mean_values_[node.RightChild()]));
+  }
+  return delta;
+}
+
+void RegTree::CompactForInference() {
+  // Breadth-first order over the reachable nodes; deleted nodes are simply
+  // never visited.  With this numbering siblings are adjacent and a level
+  // occupies one contiguous range, so prediction walks forward through
+  // memory.
+  std::vector<bst_node_t> order;
+  order.reserve(param.num_nodes);
+  std::vector<bst_node_t> remap(nodes_.size(), kInvalidNodeId);
+  order.push_back(0);
+  remap[0] = 0;
+  for (size_t i = 0; i < order.size(); ++i) {
+    auto const& node = nodes_[order[i]];
+    if (!node.IsLeaf()) {
+      remap[node.LeftChild()] = static_cast<bst_node_t>(order.size());
+      order.push_back(node.LeftChild());
+      remap[node.RightChild()] = static_cast<bst_node_t>(order.size());
+      order.push_back(node.RightChild());
+    }
+  }
+
+  auto const n_nodes = static_cast<bst_node_t>(order.size());
+  std::vector<Node> nodes(n_nodes);
+  // Inference never reads the training statistics, reset them.
+  std::vector<RTreeNodeStat> stats(n_nodes, RTreeNodeStat{});
+  std::vector<FeatureType> split_types(n_nodes, FeatureType::kNumerical);
+  std::vector<Segment> split_segments(n_nodes);
+  std::vector<uint32_t> split_categories;
+  for (bst_node_t nid = 0; nid < n_nodes; ++nid) {
+    auto const old_nid = order[nid];
+    Node node = nodes_[old_nid];
+    if (!node.IsLeaf()) {
+      node.SetLeftChild(remap[node.LeftChild()]);
+      node.SetRightChild(remap[node.RightChild()]);
+    }
+    nodes[nid] = node;
+    split_types[nid] = split_types_[old_nid];
+    if (split_types_[old_nid] == FeatureType::kCategorical) {
+      auto const& seg = split_categories_segments_[old_nid];
+      split_segments[nid].beg = split_categories.size();
+      split_segments[nid].size = seg.size;
+      split_categories.insert(
+          split_categories.end(), split_categories_.cbegin() + seg.beg,
+          split_categories_.cbegin() + seg.beg + seg.size);
+    }
+  }
+  // Parent links; the root keeps the invalid parent copied from the old root.
+  for (bst_node_t nid = 0; nid < n_nodes; ++nid) {
+    if (!nodes[nid].IsLeaf()) {
+      nodes[nodes[nid].LeftChild()].SetParent(nid, true);
+      nodes[nodes[nid].RightChild()].SetParent(nid, false);
+    }
+  }
+
+  nodes_ = std::move(nodes);
+  stats_ = std::move(stats);
+  split_types_ = std::move(split_types);
+  split_categories_segments_ = std::move(split_segments);
+  split_categories_ = std::move(split_categories);
+  deleted_nodes_.clear();
+  node_mean_values_.clear();
+  param.num_nodes = n_nodes;
+  param.num_deleted = 0;
+}
 
 // extend our decision path with a fraction of one and zero extensions
 void ExtendPath(PathElement *unique_path, unsigned unique_depth,
@@ -1246,10 +1344,24 @@ void RegTree::CalculateContributions(const RegTree::FVec &feat,
   }
 
   // Preallocate space for the unique path data
-  const int maxd = this->MaxDepth(0) + 2;
-  std::vector<PathElement> unique_path_data((maxd * (maxd + 1)) / 2);
+  std::vector<PathElement> unique_path_data(this->PathScratchSize());
 
   TreeShap(feat, out_contribs, 0, 0, unique_path_data.data(),
            1, 1, -1, condition, condition_feature, 1);
 }
+
+void RegTree::CalculateContributions(const RegTree::FVec &feat,
+                                     bst_float *out_contribs,
+                                     int condition,
+                                     unsigned condition_feature,
+                                     PathElement *path_scratch) const {
+  // find the expected value of the tree's predictions
+  if (condition == 0) {
+    bst_float node_value = this->node_mean_values_[0];
+    out_contribs[feat.Size()] += node_value;
+  }
+
+  TreeShap(feat, out_contribs, 0, 0, path_scratch,
+           1, 1, -1, condition, condition_feature, 1);
+}
 }  // namespace xgboost
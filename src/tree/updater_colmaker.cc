@@ -19,6 +19,15 @@
 #include "../common/random.h"
 #include "split_evaluator.h"
 
+#if defined(XGBOOST_MM_PREFETCH_PRESENT)
+  #include <xmmintrin.h>
+  #define PREFETCH_READ_T0(addr) _mm_prefetch(reinterpret_cast<const char*>(addr), _MM_HINT_T0)
+#elif defined(XGBOOST_BUILTIN_PREFETCH_PRESENT)
+  #define PREFETCH_READ_T0(addr) __builtin_prefetch(reinterpret_cast<const char*>(addr), 0, 3)
+#else  // no SW pre-fetching available; PREFETCH_READ_T0 is no-op
+  #define PREFETCH_READ_T0(addr) do {} while (0)
+#endif  // defined(XGBOOST_MM_PREFETCH_PRESENT)
+
 namespace xgboost {
 namespace tree {
 
@@ -165,6 +174,11 @@ class ColMaker: public TreeUpdater {
       std::vector<int> newnodes;
       this->InitData(gpair, *p_fmat);
       this->InitNewNode(qexpand_, gpair, *p_fmat, *p_tree);
+      // reserve the node storage up front so splits do not reallocate the
+      // node arrays
+      if (param_.max_depth > 0 && param_.max_depth <= 16) {
+        p_tree->Reserve(param_.MaxNodes());
+      }
       for (int depth = 0; depth < param_.max_depth; ++depth) {
         this->FindSplit(depth, qexpand_, gpair, p_fmat, p_tree);
         this->ResetPosition(qexpand_, p_fmat, *p_tree);
@@ -212,14 +226,52 @@ class ColMaker: public TreeUpdater {
         }
         // mark subsample
         if (param_.subsample < 1.0f) {
-          CHECK_EQ(param_.sampling_method, TrainParam::kUniform)
-            << "Only uniform sampling is supported, "
-            << "gradient-based sampling is only support by GPU Hist.";
-          std::bernoulli_distribution coin_flip(param_.subsample);
-          auto& rnd = common::GlobalRandom();
-          for (size_t ridx = 0; ridx < position_.size(); ++ridx) {
-            if (gpair[ridx].GetHess() < 0.0f) continue;
-            if (!coin_flip(rnd)) position_[ridx] = ~position_[ridx];
+          CHECK_NE(param_.sampling_method, TrainParam::kGradientBased)
+            << "Gradient-based sampling is only supported by the hist tree methods.";
+          if (param_.sampling_method == TrainParam::kStratified) {
+            const std::vector<uint8_t> mask = common::StratifiedSampleRows(
+                gpair, fmat.Info().labels_.ConstHostVector(), param_.subsample,
+                this->nthread_);
+            for (size_t ridx = 0; ridx < position_.size(); ++ridx) {
+              if (gpair[ridx].GetHess() >= 0.0f && !mask[ridx]) {
+                position_[ridx] = ~position_[ridx];
+              }
+            }
+          } else {
+            auto& rnd = common::GlobalRandom();
+#if XGBOOST_CUSTOMIZE_GLOBAL_PRNG
+            std::bernoulli_distribution coin_flip(param_.subsample);
+            for (size_t ridx = 0; ridx < position_.size(); ++ridx) {
+              if (gpair[ridx].GetHess() < 0.0f) continue;
+              if (!coin_flip(rnd)) position_[ridx] = ~position_[ridx];
+            }
+#else
+            // one stream per thread instead of funnelling every row through
+            // the global engine
+            const size_t nthread = this->nthread_;
+            std::vector<common::RandomEngine> rnds(nthread);
+            for (common::RandomEngine& r : rnds) {
+              r = rnd;
+            }
+            const size_t discard_size = position_.size() / nthread;
+            auto upper_border = static_cast<float>(std::numeric_limits<uint32_t>::max());
+            uint32_t coin_flip_border = static_cast<uint32_t>(upper_border * param_.subsample);
+            #pragma omp parallel num_threads(nthread)
+            {
+              const size_t tid = omp_get_thread_num();
+              const size_t ibegin = tid * discard_size;
+              const size_t iend = (tid == (nthread - 1)) ?
+                                  position_.size() : ibegin + discard_size;
+              rnds[tid].discard(discard_size * tid);
+              for (size_t ridx = ibegin; ridx < iend; ++ridx) {
+                if (gpair[ridx].GetHess() >= 0.0f && rnds[tid]() >= coin_flip_border) {
+                  position_[ridx] = ~position_[ridx];
+                }
+              }
+            }
+            // discard the draws of this pass from the global engine
+            rnd = rnds[nthread - 1];
+#endif  // XGBOOST_CUSTOMIZE_GLOBAL_PRNG
           }
         }
       }
@@ -383,6 +435,15 @@ class ColMaker: public TreeUpdater {
       // internal cached loop
       for (it = begin; it != align_end; it += align_step) {
         const Entry *p;
+        // issue prefetches for the scattered position/gradient lookups of the
+        // next block while the current one is gathered; entries themselves are
+        // read sequentially and covered by the hardware prefetcher
+        if (it + align_step != align_end) {
+          for (i = 0, p = it + align_step; i < kBuffer; ++i, p += d_step) {
+            PREFETCH_READ_T0(position_.data() + p->index);
+            PREFETCH_READ_T0(gpair.data() + p->index);
+          }
+        }
         for (i = 0, p = it; i < kBuffer; ++i, p += d_step) {
           buf_position[i] = position_[p->index];
           buf_gpair[i] = gpair[p->index];
@@ -179,11 +179,13 @@ struct GPUHistMakerDevice {
   TrainParam param;
   bool deterministic_histogram;
 
-  GradientSumT histogram_rounding;
+  HistRounding<GradientSumT> histogram_rounding;
 
   dh::PinnedMemory pinned;
 
   std::vector<cudaStream_t> streams{};
+  /*! \brief event used to order the default stream after side streams */
+  cudaEvent_t join_event_;
 
   common::Monitor monitor;
   TreeEvaluator tree_evaluator;
@@ -192,7 +194,7 @@ struct GPUHistMakerDevice {
 
   std::unique_ptr<GradientBasedSampler> sampler;
 
-  std::unique_ptr<FeatureGroups> feature_groups;
+  std::unique_ptr<FeatureGroupsTuner> feature_groups;
   // Storing split categories for last node.
   dh::caching_device_vector<uint32_t> node_categories;
 
@@ -225,9 +227,10 @@ struct GPUHistMakerDevice {
     // Init histogram
     hist.Init(device_id, page->Cuts().TotalBins());
     monitor.Init(std::string("GPUHistMakerDevice") + std::to_string(device_id));
-    feature_groups.reset(new FeatureGroups(
-        page->Cuts(), page->is_dense, dh::MaxSharedMemoryOptin(device_id),
-        sizeof(GradientSumT)));
+    feature_groups.reset(new FeatureGroupsTuner(
+        page->Cuts(), page->is_dense, device_id,
+        dh::MaxSharedMemoryOptin(device_id), sizeof(GradientSumT)));
+    dh::safe_cuda(cudaEventCreateWithFlags(&join_event_, cudaEventDisableTiming));
   }
 
   ~GPUHistMakerDevice() {  // NOLINT
@@ -235,6 +238,7 @@ struct GPUHistMakerDevice {
     for (auto& stream : streams) {
       dh::safe_cuda(cudaStreamDestroy(stream));
     }
+    dh::safe_cuda(cudaEventDestroy(join_event_));
   }
 
   // Get vector of at least n initialised streams
@@ -259,6 +263,7 @@ struct GPUHistMakerDevice {
   // Note that the column sampler must be passed by value because it is not
   // thread safe
   void Reset(HostDeviceVector<GradientPair>* dh_gpair, DMatrix* dmat, int64_t num_columns) {
+    dh::MemoryScope mem_scope("updater_gpu_hist");
     auto const& info = dmat->Info();
     this->column_sampler.Init(num_columns, info.feature_weigths.HostVector(),
                               param.colsample_bynode, param.colsample_bylevel,
@@ -276,11 +281,19 @@ struct GPUHistMakerDevice {
     if (deterministic_histogram) {
       histogram_rounding = CreateRoundingFactor<GradientSumT>(this->gpair);
     } else {
-      histogram_rounding = GradientSumT{0.0, 0.0};
+      // The zeroed rounding selects the fast accumulation mode, which needs
+      // neither the truncation factor nor the fixed-point scale, so the
+      // device reductions of CreateRoundingFactor are skipped altogether.
+      histogram_rounding = HistRounding<GradientSumT>{};
     }
 
-    row_partitioner.reset();  // Release the device memory first before reallocating
-    row_partitioner.reset(new RowPartitioner(device_id,  sample.sample_rows));
+    // Reuse the partition buffers of the previous tree instead of
+    // reallocating them
+    if (row_partitioner) {
+      row_partitioner->Reset(sample.sample_rows);
+    } else {
+      row_partitioner.reset(new RowPartitioner(device_id, sample.sample_rows));
+    }
     hist.Reset();
   }
 
@@ -379,13 +392,47 @@ struct GPUHistMakerDevice {
         sizeof(ExpandEntry) * entries.size(), cudaMemcpyDeviceToHost));
   }
 
-  void BuildHist(int nidx) {
+  void BuildHist(int nidx, cudaStream_t stream = nullptr) {
     hist.AllocateHistogram(nidx);
     auto d_node_hist = hist.GetNodeHistogram(nidx);
     auto d_ridx = row_partitioner->GetRows(nidx);
-    BuildGradientHistogram(page->GetDeviceAccessor(device_id),
-                           feature_groups->DeviceAccessor(device_id), gpair,
-                           d_ridx, d_node_hist, histogram_rounding);
+    if (feature_groups->NeedsTiming()) {
+      // Benchmark the candidate grouping on a real histogram build; the tuner
+      // keeps the fastest configuration once every candidate has been timed.
+      cudaEvent_t start, stop;
+      dh::safe_cuda(cudaEventCreate(&start));
+      dh::safe_cuda(cudaEventCreate(&stop));
+      dh::safe_cuda(cudaEventRecord(start, stream));
+      BuildGradientHistogram(
+          page->GetDeviceAccessor(device_id),
+          feature_groups->Current()->DeviceAccessor(device_id), gpair, d_ridx,
+          d_node_hist, histogram_rounding, stream);
+      dh::safe_cuda(cudaEventRecord(stop, stream));
+      dh::safe_cuda(cudaEventSynchronize(stop));
+      float ms = 0;
+      dh::safe_cuda(cudaEventElapsedTime(&ms, start, stop));
+      dh::safe_cuda(cudaEventDestroy(start));
+      dh::safe_cuda(cudaEventDestroy(stop));
+      // Normalize by the node size so candidates timed on different nodes of
+      // the frontier stay comparable.
+      feature_groups->Report(ms / std::max(d_ridx.size(), size_t{1}));
+    } else {
+      BuildGradientHistogram(
+          page->GetDeviceAccessor(device_id),
+          feature_groups->Current()->DeviceAccessor(device_id), gpair, d_ridx,
+          d_node_hist, histogram_rounding, stream);
+    }
+  }
+
+  /*!
+   * \brief Make subsequent work on the default stream wait for everything
+   *  queued in the given streams, without blocking the host.
+   */
+  void JoinStreams(std::vector<cudaStream_t> const& join) {
+    for (auto const& stream : join) {
+      dh::safe_cuda(cudaEventRecord(join_event_, stream));
+      dh::safe_cuda(cudaStreamWaitEvent(nullptr, join_event_, 0));
+    }
   }
 
   void SubtractionTrick(int nidx_parent, int nidx_histogram,
@@ -408,16 +455,51 @@ struct GPUHistMakerDevice {
            hist.HistogramExists(nidx_parent);
   }
 
-  void UpdatePosition(int nidx, RegTree* p_tree) {
-    RegTree::Node split_node = (*p_tree)[nidx];
-    auto split_type = p_tree->NodeSplitType(nidx);
-    auto d_matrix = page->GetDeviceAccessor(device_id);
-    auto node_cats = dh::ToSpan(node_categories);
+  void UpdatePositionBatch(std::vector<bst_node_t> const& split_nidx,
+                           RegTree const* p_tree) {
+    if (split_nidx.empty()) {
+      return;
+    }
+    RegTree const& tree = *p_tree;
+    // The batched device op looks split data up by node id, so the split
+    // nodes and their category bitfields are staged from the tree instead of
+    // the single scratch buffer ApplySplit fills.
+    dh::TemporaryArray<RegTree::Node> d_nodes(tree.GetNodes().size());
+    dh::safe_cuda(cudaMemcpyAsync(d_nodes.data().get(), tree.GetNodes().data(),
+                                  d_nodes.size() * sizeof(RegTree::Node),
+                                  cudaMemcpyHostToDevice));
+    auto const& h_split_types = tree.GetSplitTypes();
+    auto const& categories = tree.GetSplitCategories();
+    auto const& categories_segments = tree.GetSplitCategoriesPtr();
 
-    row_partitioner->UpdatePosition(
-        nidx, split_node.LeftChild(), split_node.RightChild(),
-        [=] __device__(bst_uint ridx) {
-          // given a row index, returns the node id it belongs to
+    dh::caching_device_vector<FeatureType> d_split_types;
+    dh::caching_device_vector<uint32_t> d_categories;
+    dh::caching_device_vector<RegTree::Segment> d_categories_segments;
+    if (!categories.empty()) {
+      dh::CopyToD(h_split_types, &d_split_types);
+      dh::CopyToD(categories, &d_categories);
+      dh::CopyToD(categories_segments, &d_categories_segments);
+    }
+
+    std::vector<bst_node_t> left_nidx(split_nidx.size());
+    std::vector<bst_node_t> right_nidx(split_nidx.size());
+    for (size_t i = 0; i < split_nidx.size(); ++i) {
+      left_nidx[i] = tree[split_nidx[i]].LeftChild();
+      right_nidx[i] = tree[split_nidx[i]].RightChild();
+    }
+
+    auto d_matrix = page->GetDeviceAccessor(device_id);
+    auto nodes = dh::ToSpan(d_nodes);
+    auto split_types = dh::ToSpan(d_split_types);
+    auto tree_categories = dh::ToSpan(d_categories);
+    auto categories_ptr = dh::ToSpan(d_categories_segments);
+
+    row_partitioner->UpdatePositionBatch(
+        split_nidx, left_nidx, right_nidx,
+        [=] __device__(bst_uint ridx, bst_node_t nidx) {
+          // given a row index and the node it sits in, returns the node id it
+          // belongs to after the split
+          RegTree::Node split_node = nodes[nidx];
           bst_float cut_value =
               d_matrix.GetFvalue(ridx, split_node.SplitIndex());
           // Missing value
@@ -426,7 +508,10 @@ struct GPUHistMakerDevice {
             new_position = split_node.DefaultChild();
           } else {
             bool go_left = true;
-            if (split_type == FeatureType::kCategorical) {
+            if (common::IsCat(split_types, nidx)) {
+              auto node_cats =
+                  tree_categories.subspan(categories_ptr[nidx].beg,
+                                          categories_ptr[nidx].size);
               go_left = common::Decision(node_cats, common::AsCat(cut_value));
             } else {
               go_left = cut_value <= split_node.SplitCond();
@@ -464,8 +549,7 @@ struct GPUHistMakerDevice {
     }
 
     if (row_partitioner->GetRows().size() != p_fmat->Info().num_row_) {
-      row_partitioner.reset();  // Release the device memory first before reallocating
-      row_partitioner.reset(new RowPartitioner(device_id, p_fmat->Info().num_row_));
+      row_partitioner->Reset(p_fmat->Info().num_row_);
     }
     if (page->n_rows == p_fmat->Info().num_row_) {
       FinalisePositionInPage(page, dh::ToSpan(d_nodes),
@@ -544,7 +628,6 @@ struct GPUHistMakerDevice {
           out_preds_d[d_ridx[local_idx]] +=
               weight * param_d.learning_rate;
         });
-    row_partitioner.reset();
   }
 
   void AllReduceHist(int nidx, dh::AllReducer* reducer) {
@@ -558,6 +641,29 @@ struct GPUHistMakerDevice {
     monitor.Stop("AllReduce");
   }
 
+  /**
+   * \brief Reduce the histograms of two sibling nodes, fused into a single
+   * communication call when they are adjacent in the histogram pool.  Every
+   * reduce call carries a fixed latency cost, so halving the number of calls
+   * matters for deep trees where the payload per node is small.
+   */
+  void AllReduceHist(int nidx_a, int nidx_b, dh::AllReducer* reducer) {
+    auto hist_a = hist.GetNodeHistogram(nidx_a);
+    auto hist_b = hist.GetNodeHistogram(nidx_b);
+    if (hist_a.data() + hist_a.size() != hist_b.data()) {
+      this->AllReduceHist(nidx_a, reducer);
+      this->AllReduceHist(nidx_b, reducer);
+      return;
+    }
+    monitor.Start("AllReduce");
+    auto d_node_hist = reinterpret_cast<typename GradientSumT::ValueT*>(hist_a.data());
+    reducer->AllReduceSum(
+        d_node_hist, d_node_hist,
+        2 * page->Cuts().TotalBins() *
+            (sizeof(GradientSumT) / sizeof(typename GradientSumT::ValueT)));
+    monitor.Stop("AllReduce");
+  }
+
   /**
    * \brief Build GPU local histograms for the left and right child of some parent node
    */
@@ -573,24 +679,43 @@ struct GPUHistMakerDevice {
       std::swap(build_hist_nidx, subtraction_trick_nidx);
     }
 
-    this->BuildHist(build_hist_nidx);
-    this->AllReduceHist(build_hist_nidx, reducer);
+    hist.AllocateHistogram(build_hist_nidx);
 
     // Check whether we can use the subtraction trick to calculate the other
     bool do_subtraction_trick = this->CanDoSubtractionTrick(
         candidate.nid, build_hist_nidx, subtraction_trick_nidx);
 
     if (do_subtraction_trick) {
+      this->BuildHist(build_hist_nidx);
+      this->AllReduceHist(build_hist_nidx, reducer);
       // Calculate other histogram using subtraction trick
       this->SubtractionTrick(candidate.nid, build_hist_nidx,
                              subtraction_trick_nidx);
     } else {
-      // Calculate other histogram manually
-      this->BuildHist(subtraction_trick_nidx);
-      this->AllReduceHist(subtraction_trick_nidx, reducer);
+      // Calculate both histograms manually, overlapped on side streams, and
+      // reduce both siblings with a single call
+      this->BuildHistBoth(build_hist_nidx, subtraction_trick_nidx);
+      this->AllReduceHist(build_hist_nidx, subtraction_trick_nidx, reducer);
     }
   }
 
+  /**
+   * \brief Build the histograms of both children concurrently on separate
+   * streams.  The two kernels touch disjoint row sets and histogram ranges,
+   * so overlapping them fills the device when either child alone does not.
+   * Used when the subtraction trick is not applicable.
+   */
+  void BuildHistBoth(int nidx_a, int nidx_b) {
+    auto& build_streams = this->GetStreams(2);
+    // allocate first: allocation zeroes memory on the default stream, which
+    // the build kernels in the side streams implicitly wait on
+    hist.AllocateHistogram(nidx_a);
+    hist.AllocateHistogram(nidx_b);
+    this->BuildHist(nidx_a, build_streams[0]);
+    this->BuildHist(nidx_b, build_streams[1]);
+    this->JoinStreams(build_streams);
+  }
+
   void ApplySplit(const ExpandEntry& candidate, RegTree* p_tree) {
     RegTree& tree = *p_tree;
     auto evaluator = tree_evaluator.GetEvaluator();
@@ -704,6 +829,9 @@ struct GPUHistMakerDevice {
       auto new_candidates =
           pinned.GetSpan<ExpandEntry>(expand_set.size() * 2, ExpandEntry());
 
+      // Apply all splits of the frontier to the tree first so the position
+      // update below can be batched into a single segmented pass.
+      std::vector<bst_node_t> split_nidx;
       for (auto i = 0ull; i < expand_set.size(); i++) {
         auto candidate = expand_set.at(i);
         if (!candidate.IsValid(param, num_leaves)) {
@@ -714,29 +842,40 @@ struct GPUHistMakerDevice {
         num_leaves++;
 
         int left_child_nidx = tree[candidate.nid].LeftChild();
-        int right_child_nidx = tree[candidate.nid].RightChild();
         // Only create child entries if needed
         if (ExpandEntry::ChildIsValid(param, tree.GetDepth(left_child_nidx),
                                       num_leaves)) {
-          monitor.Start("UpdatePosition");
-          this->UpdatePosition(candidate.nid, p_tree);
-          monitor.Stop("UpdatePosition");
-
-          monitor.Start("BuildHist");
-          this->BuildHistLeftRight(candidate, left_child_nidx, right_child_nidx, reducer);
-          monitor.Stop("BuildHist");
-
-          monitor.Start("EvaluateSplits");
-          this->EvaluateLeftRightSplits(candidate, left_child_nidx,
-                                        right_child_nidx, *p_tree,
-                                        new_candidates.subspan(i * 2, 2));
-          monitor.Stop("EvaluateSplits");
+          split_nidx.push_back(candidate.nid);
         } else {
           // Set default
           new_candidates[i * 2] = ExpandEntry();
           new_candidates[i * 2 + 1] = ExpandEntry();
         }
       }
+
+      monitor.Start("UpdatePosition");
+      this->UpdatePositionBatch(split_nidx, p_tree);
+      monitor.Stop("UpdatePosition");
+
+      for (auto i = 0ull; i < expand_set.size(); i++) {
+        auto candidate = expand_set.at(i);
+        if (std::find(split_nidx.cbegin(), split_nidx.cend(), candidate.nid) ==
+            split_nidx.cend()) {
+          continue;
+        }
+        int left_child_nidx = tree[candidate.nid].LeftChild();
+        int right_child_nidx = tree[candidate.nid].RightChild();
+
+        monitor.Start("BuildHist");
+        this->BuildHistLeftRight(candidate, left_child_nidx, right_child_nidx, reducer);
+        monitor.Stop("BuildHist");
+
+        monitor.Start("EvaluateSplits");
+        this->EvaluateLeftRightSplits(candidate, left_child_nidx,
+                                      right_child_nidx, *p_tree,
+                                      new_candidates.subspan(i * 2, 2));
+        monitor.Stop("EvaluateSplits");
+      }
       dh::safe_cuda(cudaDeviceSynchronize());
       driver.Push(new_candidates.begin(), new_candidates.end());
       expand_set = driver.Pop();
@@ -8,13 +8,18 @@
 #include <rabit/rabit.h>
 
 #include <cmath>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <algorithm>
+#include <limits>
 #include <queue>
 #include <iomanip>
 #include <numeric>
 #include <string>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 
 #include "xgboost/logging.h"
@@ -25,10 +30,20 @@
 #include "./updater_quantile_hist.h"
 #include "./split_evaluator.h"
 #include "../common/random.h"
+#include "../common/categorical.h"
 #include "../common/hist_util.h"
 #include "../common/row_set.h"
 #include "../common/column_matrix.h"
 #include "../common/threading_utils.h"
+#include "../common/kernel_calibration.h"
+#include "../common/numa_utils.h"
+#include "../common/profile.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && \
+    !defined(__CUDACC__) && !defined(__APPLE__)
+  #define XGBOOST_PARTITION_VEC_KERNEL_PRESENT 1
+  #include <immintrin.h>
+#endif  // defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
 
 namespace xgboost {
 namespace tree {
@@ -47,6 +62,44 @@ void QuantileHistMaker::Configure(const Args& args) {
   hist_maker_param_.UpdateAllowUnknown(args);
 }
 
+namespace {
+/*!
+ * \brief Process-wide registry of shared quantized indices, keyed by the data
+ *  and the parameters that shape the quantization.  Entries are weak: the
+ *  index lives exactly as long as some updater still holds it.
+ */
+class QuantizedIndexCache {
+ public:
+  static QuantizedIndexCache& Instance() {
+    static QuantizedIndexCache cache;
+    return cache;
+  }
+
+  std::shared_ptr<QuantizedIndex> GetOrCreate(DMatrix* dmat, int32_t max_bin,
+                                              float sparse_threshold) {
+    std::lock_guard<std::mutex> guard(mu_);
+    Key key{dmat, dmat->Info().num_row_, max_bin, sparse_threshold};
+    auto it = cache_.find(key);
+    if (it != cache_.cend()) {
+      if (auto shared = it->second.lock()) {
+        return shared;
+      }
+    }
+    auto built = std::make_shared<QuantizedIndex>();
+    built->gmat.Init(dmat, static_cast<uint32_t>(max_bin));
+    built->columns.Init(built->gmat, sparse_threshold);
+    cache_[key] = built;
+    return built;
+  }
+
+ private:
+  // the row count guards against an unrelated DMatrix reusing a freed address
+  using Key = std::tuple<DMatrix const*, bst_row_t, int32_t, float>;
+  std::map<Key, std::weak_ptr<QuantizedIndex>> cache_;
+  std::mutex mu_;
+};
+}  // anonymous namespace
+
 template<typename GradientSumT>
 void QuantileHistMaker::SetBuilder(std::unique_ptr<Builder<GradientSumT>>* builder,
                                    DMatrix *dmat) {
@@ -54,6 +107,13 @@ void QuantileHistMaker::SetBuilder(std::unique_ptr<Builder<GradientSumT>>* build
                 param_,
                 std::move(pruner_),
                 int_constraint_, dmat));
+  (*builder)->SetUseQuantizedGradients(hist_maker_param_.quantized_gradients);
+  (*builder)->SetCompressedHistSync(hist_maker_param_.compressed_histogram_sync);
+  (*builder)->SetQuantizedHistSync(hist_maker_param_.quantized_histogram_sync);
+  (*builder)->SetSampledHistSync(hist_maker_param_.sampled_histogram_sync);
+  (*builder)->SetTreeReduceHist(hist_maker_param_.tree_reduce_histogram);
+  (*builder)->SetHistBufferBudget(hist_maker_param_.max_histogram_buffer_mb << 20);
+  (*builder)->SetLossGuideExpandBatch(hist_maker_param_.lossguide_expand_batch);
   if (rabit::IsDistributed()) {
     (*builder)->SetHistSynchronizer(new DistributedHistSynchronizer<GradientSumT>());
     (*builder)->SetHistRowsAdder(new DistributedHistRowsAdder<GradientSumT>());
@@ -68,24 +128,81 @@ void QuantileHistMaker::CallBuilderUpdate(const std::unique_ptr<Builder<Gradient
                                           HostDeviceVector<GradientPair> *gpair,
                                           DMatrix *dmat,
                                           const std::vector<RegTree *> &trees) {
+  // the trees of one boosting round see the same gradients, so without row
+  // or column sampling their partitions are identical and the histograms of
+  // the first tree can be served from the cache for the rest
+  const bool static_partitions =
+      param_.subsample >= 1.0f && param_.colsample_bytree >= 1.0f &&
+      param_.colsample_bylevel >= 1.0f && param_.colsample_bynode >= 1.0f;
+  bool reuse = false;
+  // the same identity extends to split evaluation: the first tree fills the
+  // per-(node, feature) cache, the rest look their splits up.  Loss-guided
+  // growth is excluded because rolling speculative losers back recycles node
+  // ids mid-tree, which would alias the cache slots.
+  const bool cache_splits = static_partitions && trees.size() > 1 &&
+                            param_.grow_policy == TrainParam::kDepthWise;
+  builder->SetCacheSplitResults(cache_splits);
   for (auto tree : trees) {
-    builder->Update(gmat_, gmatb_, column_matrix_, gpair, dmat, tree);
+    builder->SetReuseHistograms(reuse);
+    builder->Update(qindex_->gmat, gmatb_, qindex_->columns, gpair, dmat, tree);
+    reuse = static_partitions;
   }
+  builder->SetReuseHistograms(false);
+  builder->SetCacheSplitResults(false);
 }
 void QuantileHistMaker::Update(HostDeviceVector<GradientPair> *gpair,
                                DMatrix *dmat,
                                const std::vector<RegTree *> &trees) {
-  if (dmat != p_last_dmat_ || is_gmat_initialized_ == false) {
+  if (dmat != p_last_dmat_ || !qindex_) {
     updater_monitor_.Start("GmatInitialization");
-    gmat_.Init(dmat, static_cast<uint32_t>(param_.max_bin));
-    column_matrix_.Init(gmat_, param_.sparse_threshold);
-    if (param_.enable_feature_grouping > 0) {
-      gmatb_.Init(gmat_, column_matrix_, param_);
+    n_updates_ = 0;
+    // Feature grouping layers a per-parameter block matrix on top of the
+    // index, so only the plain layout is shareable.
+    if (hist_maker_param_.shared_quantized_index &&
+        param_.enable_feature_grouping <= 0) {
+      qindex_ = QuantizedIndexCache::Instance().GetOrCreate(
+          dmat, param_.max_bin, param_.sparse_threshold);
+    } else {
+      qindex_ = std::make_shared<QuantizedIndex>();
+      qindex_->gmat.Init(dmat, static_cast<uint32_t>(param_.max_bin));
+      qindex_->columns.Init(qindex_->gmat, param_.sparse_threshold);
+      if (param_.enable_feature_grouping > 0) {
+        gmatb_.Init(qindex_->gmat, qindex_->columns, param_);
+      }
     }
     updater_monitor_.Stop("GmatInitialization");
     // A proper solution is puting cut matrix in DMatrix, see:
     // https://github.com/dmlc/xgboost/issues/5143
-    is_gmat_initialized_ = true;
+  } else if (hist_maker_param_.cut_refresh_period > 0 &&
+             n_updates_ % hist_maker_param_.cut_refresh_period == 0) {
+    updater_monitor_.Start("GmatRefresh");
+    // Re-sketch with the current hessian as weight, so bin boundaries track
+    // where the remaining loss mass sits, like the per-iteration weighted
+    // proposals of the approx updater.  Refreshed cuts depend on this
+    // booster's gradients, so the rebuilt index is always private even when
+    // shared_quantized_index is enabled.
+    auto const& h_gpair = gpair->ConstHostVector();
+    std::vector<float> hess(h_gpair.size());
+    common::ParallelFor(h_gpair.size(), omp_get_max_threads(), [&](size_t i) {
+      hess[i] = h_gpair[i].GetHess();
+    });
+    qindex_ = std::make_shared<QuantizedIndex>();
+    qindex_->gmat.Init(dmat, static_cast<uint32_t>(param_.max_bin),
+                       {hess.data(), hess.size()});
+    qindex_->columns.Init(qindex_->gmat, param_.sparse_threshold);
+    if (param_.enable_feature_grouping > 0) {
+      gmatb_.Init(qindex_->gmat, qindex_->columns, param_);
+    }
+    updater_monitor_.Stop("GmatRefresh");
+  }
+  ++n_updates_;
+  if (hist_maker_param_.numa_aware && !omp_threads_bound_) {
+    // Block-distribute OpenMP workers across sockets once per training
+    // session: ParallelFor2d hands out blocks in the same order, so each
+    // thread first-touches its histogram buffers and row partitions on the
+    // node it is pinned to.
+    common::numa::BindOmpThreadsToNodes(omp_get_max_threads());
+    omp_threads_bound_ = true;
   }
   // rescale learning rate according to size of trees
   float lr = param_.learning_rate;
@@ -136,11 +253,21 @@ void BatchHistSynchronizer<GradientSumT>::SyncHistograms(BuilderT *builder,
     return nbins;
   }, 1024);
 
+  // nothing to reduce when the frontier was built column-parallel directly
+  // into the output histograms
+  const bool reduce = !builder->hist_built_directly_;
+  const bool tree_reduce = reduce && builder->tree_reduce_hist_;
+  if (tree_reduce) {
+    builder->hist_buffer_.ReduceHistTree(builder->nthread_);
+  }
+
   common::ParallelFor2d(space, builder->nthread_, [&](size_t node, common::Range1d r) {
     const auto& entry = builder->nodes_for_explicit_hist_build_[node];
     auto this_hist = builder->hist_[entry.nid];
     // Merging histograms from each thread into once
-    builder->hist_buffer_.ReduceHist(node, r.begin(), r.end());
+    if (reduce && !tree_reduce) {
+      builder->hist_buffer_.ReduceHist(node, r.begin(), r.end());
+    }
 
     if (!(*p_tree)[entry.nid].IsRoot() && entry.sibling_nid > -1) {
       const size_t parent_id = (*p_tree)[entry.nid].Parent();
@@ -162,11 +289,21 @@ void DistributedHistSynchronizer<GradientSumT>::SyncHistograms(BuilderT* builder
   common::BlockedSpace2d space(builder->nodes_for_explicit_hist_build_.size(), [&](size_t) {
     return nbins;
   }, 1024);
+  // nothing to reduce when the frontier was built column-parallel directly
+  // into the output histograms
+  const bool reduce = !builder->hist_built_directly_;
+  const bool tree_reduce = reduce && builder->tree_reduce_hist_;
+  if (tree_reduce) {
+    builder->hist_buffer_.ReduceHistTree(builder->nthread_);
+  }
+
   common::ParallelFor2d(space, builder->nthread_, [&](size_t node, common::Range1d r) {
     const auto& entry = builder->nodes_for_explicit_hist_build_[node];
     auto this_hist = builder->hist_[entry.nid];
     // Merging histograms from each thread into once
-    builder->hist_buffer_.ReduceHist(node, r.begin(), r.end());
+    if (reduce && !tree_reduce) {
+      builder->hist_buffer_.ReduceHist(node, r.begin(), r.end());
+    }
     // Store posible parent node
     auto this_local = builder->hist_local_worker_[entry.nid];
     CopyHist(this_local, this_hist, r.begin(), r.end());
@@ -183,17 +320,76 @@ void DistributedHistSynchronizer<GradientSumT>::SyncHistograms(BuilderT* builder
   });
   builder->builder_monitor_.Start("SyncHistogramsAllreduce");
 
-  builder->histred_.Allreduce(builder->hist_[starting_index].data(),
-                                    builder->hist_builder_.GetNumBins() * sync_count);
-
-  builder->builder_monitor_.Stop("SyncHistogramsAllreduce");
-
-  ParallelSubtractionHist(builder, space, builder->nodes_for_explicit_hist_build_, p_tree);
+  static const size_t kAllreduceBytesSlot =
+      common::ProfileRegistry::Instance().Register("allreduce_hist_bytes");
+  static const size_t kAllreduceTicksSlot =
+      common::ProfileRegistry::Instance().Register("allreduce_hist_ticks");
+  common::ProfileRegistry::Instance().Add(
+      kAllreduceBytesSlot,
+      nbins * sync_count * sizeof(xgboost::detail::GradientPairInternal<GradientSumT>));
+  common::ProfileTimer allreduce_timer{kAllreduceTicksSlot};
 
   common::BlockedSpace2d space2(builder->nodes_for_subtraction_trick_.size(), [&](size_t) {
     return nbins;
   }, 1024);
-  ParallelSubtractionHist(builder, space2, builder->nodes_for_subtraction_trick_, p_tree);
+  const int kNidEnd = std::numeric_limits<int>::max();
+
+  if (!builder->compressed_hist_sync_ && !builder->quantized_hist_sync_ &&
+      !builder->sampled_hist_sync_ && sync_count > 1) {
+    // The synced rows are the sorted left children, laid out contiguously from
+    // starting_index by DistributedHistRowsAdder.  Reduce the frontier in two
+    // halves so the reduction of the second half overlaps with the subtraction
+    // trick for siblings of the first, hiding part of the network latency.
+    std::vector<int> synced_nids;
+    for (auto const& entry : builder->nodes_for_explicit_hist_build_) {
+      if ((*p_tree)[entry.nid].IsLeftChild()) {
+        synced_nids.push_back(entry.nid);
+      }
+    }
+    for (auto const& entry : builder->nodes_for_subtraction_trick_) {
+      if ((*p_tree)[entry.nid].IsLeftChild()) {
+        synced_nids.push_back(entry.nid);
+      }
+    }
+    std::sort(synced_nids.begin(), synced_nids.end());
+    CHECK_EQ(static_cast<int>(synced_nids.size()), sync_count);
+
+    const int half = sync_count / 2;
+    const int boundary_nid = synced_nids[half];
+    builder->histred_.Allreduce(builder->hist_[starting_index].data(), nbins * half);
+    auto handle = builder->histred_.AllreduceStart(builder->hist_[boundary_nid].data(),
+                                                   nbins * (sync_count - half));
+    ParallelSubtractionHist(builder, space, builder->nodes_for_explicit_hist_build_,
+                            0, boundary_nid, p_tree);
+    ParallelSubtractionHist(builder, space2, builder->nodes_for_subtraction_trick_,
+                            0, boundary_nid, p_tree);
+    handle.Wait();
+    ParallelSubtractionHist(builder, space, builder->nodes_for_explicit_hist_build_,
+                            boundary_nid, kNidEnd, p_tree);
+    ParallelSubtractionHist(builder, space2, builder->nodes_for_subtraction_trick_,
+                            boundary_nid, kNidEnd, p_tree);
+  } else {
+    const size_t n_features = builder->cut_ptrs_->size() - 1;
+    if (builder->sampled_hist_sync_ && !builder->reuse_histograms_ &&
+        builder->column_sampler_.HasFixedTreeSet() &&
+        builder->column_sampler_.TreeFeatureSet().size() < n_features) {
+      builder->SampledAllreduceHist(starting_index, sync_count,
+                                    builder->column_sampler_.TreeFeatureSet());
+    } else if (builder->quantized_hist_sync_) {
+      builder->QuantizedAllreduceHist(starting_index, sync_count);
+    } else if (builder->compressed_hist_sync_) {
+      builder->CompressedAllreduceHist(starting_index, sync_count);
+    } else {
+      builder->histred_.Allreduce(builder->hist_[starting_index].data(),
+                                  nbins * sync_count);
+    }
+    ParallelSubtractionHist(builder, space, builder->nodes_for_explicit_hist_build_,
+                            0, kNidEnd, p_tree);
+    ParallelSubtractionHist(builder, space2, builder->nodes_for_subtraction_trick_,
+                            0, kNidEnd, p_tree);
+  }
+
+  builder->builder_monitor_.Stop("SyncHistogramsAllreduce");
   builder->builder_monitor_.Stop("SyncHistograms");
 }
 
@@ -202,13 +398,16 @@ void DistributedHistSynchronizer<GradientSumT>::ParallelSubtractionHist(
                                   BuilderT* builder,
                                   const common::BlockedSpace2d& space,
                                   const std::vector<ExpandEntryT>& nodes,
+                                  int sibling_nid_begin,
+                                  int sibling_nid_end,
                                   const RegTree * p_tree) {
   common::ParallelFor2d(space, builder->nthread_, [&](size_t node, common::Range1d r) {
     const auto& entry = nodes[node];
     if (!((*p_tree)[entry.nid].IsLeftChild())) {
       auto this_hist = builder->hist_[entry.nid];
 
-      if (!(*p_tree)[entry.nid].IsRoot() && entry.sibling_nid > -1) {
+      if (!(*p_tree)[entry.nid].IsRoot() && entry.sibling_nid >= sibling_nid_begin &&
+          entry.sibling_nid < sibling_nid_end) {
         auto parent_hist = builder->hist_[(*p_tree)[entry.nid].Parent()];
         auto sibling_hist = builder->hist_[entry.sibling_nid];
         SubtractionHist(this_hist, parent_hist, sibling_hist, r.begin(), r.end());
@@ -276,6 +475,137 @@ void DistributedHistRowsAdder<GradientSumT>::AddHistRows(BuilderT *builder,
   builder->builder_monitor_.Stop("AddHistRows");
 }
 
+template <typename GradientSumT>
+void QuantileHistMaker::Builder<GradientSumT>::CompressedAllreduceHist(
+    int starting_index, int sync_count) {
+  const size_t nelems = hist_builder_.GetNumBins() * sync_count;
+  GradientPairT* hist_data = hist_[starting_index].data();
+  if (std::is_same<GradientSumT, float>::value) {
+    // the histograms are single precision already, nothing to compress
+    histred_.Allreduce(hist_data, nelems);
+    return;
+  }
+  compressed_hist_buffer_.resize(nelems);
+  GradientPairF* compressed = compressed_hist_buffer_.data();
+  const auto n = static_cast<bst_omp_uint>(nelems);
+#pragma omp parallel for schedule(static)
+  for (bst_omp_uint i = 0; i < n; ++i) {
+    compressed[i] = GradientPairF(static_cast<float>(hist_data[i].GetGrad()),
+                                  static_cast<float>(hist_data[i].GetHess()));
+  }
+  histred_fp32_.Allreduce(compressed, nelems);
+#pragma omp parallel for schedule(static)
+  for (bst_omp_uint i = 0; i < n; ++i) {
+    hist_data[i] = GradientPairT(compressed[i].GetGrad(), compressed[i].GetHess());
+  }
+}
+
+template <typename GradientSumT>
+void QuantileHistMaker::Builder<GradientSumT>::QuantizedAllreduceHist(
+    int starting_index, int sync_count) {
+  const size_t nelems = hist_builder_.GetNumBins() * sync_count;
+  GradientPairT* hist_data = hist_[starting_index].data();
+  const auto n = static_cast<bst_omp_uint>(nelems);
+
+  const int32_t nthread = omp_get_max_threads();
+  MemStackAllocator<float, 128> partial_max(nthread);
+  float* p_max = partial_max.Get();
+  std::fill(p_max, p_max + nthread, 0.0f);
+#pragma omp parallel for num_threads(nthread) schedule(static)
+  for (bst_omp_uint i = 0; i < n; ++i) {
+    const int tid = omp_get_thread_num();
+    p_max[tid] = std::max(p_max[tid],
+                          std::abs(static_cast<float>(hist_data[i].GetGrad())));
+    p_max[tid] = std::max(p_max[tid],
+                          std::abs(static_cast<float>(hist_data[i].GetHess())));
+  }
+  float global_max = 0.0f;
+  for (int32_t tid = 0; tid < nthread; ++tid) {
+    global_max = std::max(global_max, p_max[tid]);
+  }
+  // every worker must quantize with one scale, otherwise the integer sums
+  // are meaningless; agree on the largest magnitude any worker holds
+  rabit::Allreduce<rabit::op::Max>(&global_max, 1);
+  if (global_max == 0.0f) {
+    // every worker holds empty histograms, the sum is already known
+    return;
+  }
+  // leave headroom for world_size summands: each quantized value is bounded
+  // by 32767 / world_size (truncation toward zero, never rounding up), so
+  // the reduced int16 cannot overflow
+  const int world_size = rabit::GetWorldSize();
+  const float scale = 32767.0f / (global_max * static_cast<float>(world_size));
+  const float inv_scale = 1.0f / scale;
+
+  quantized_hist_buffer_.resize(nelems);
+  QuantizedHistEntry* quantized = quantized_hist_buffer_.data();
+#pragma omp parallel for num_threads(nthread) schedule(static)
+  for (bst_omp_uint i = 0; i < n; ++i) {
+    quantized[i].grad =
+        static_cast<int16_t>(static_cast<float>(hist_data[i].GetGrad()) * scale);
+    quantized[i].hess =
+        static_cast<int16_t>(static_cast<float>(hist_data[i].GetHess()) * scale);
+  }
+  histred_q16_.Allreduce(quantized, nelems);
+#pragma omp parallel for num_threads(nthread) schedule(static)
+  for (bst_omp_uint i = 0; i < n; ++i) {
+    hist_data[i] = GradientPairT(quantized[i].grad * inv_scale,
+                                 quantized[i].hess * inv_scale);
+  }
+}
+
+template <typename GradientSumT>
+void QuantileHistMaker::Builder<GradientSumT>::SampledAllreduceHist(
+    int starting_index, int sync_count,
+    const std::vector<bst_feature_t>& features) {
+  CHECK(cut_ptrs_ != nullptr);
+  const std::vector<uint32_t>& cut_ptrs = *cut_ptrs_;
+  const size_t nbins = hist_builder_.GetNumBins();
+
+  // bins to reduce: the per-tree sample, plus the least-binned feature whose
+  // bins the dense root statistics are summed from. The latter is carried
+  // regardless of the layout so that the buffer reduced below has the same
+  // size on every worker.
+  std::vector<bst_feature_t> fids(features);
+  if (std::find(fids.begin(), fids.end(),
+                static_cast<bst_feature_t>(fid_least_bins_)) == fids.end()) {
+    fids.push_back(static_cast<bst_feature_t>(fid_least_bins_));
+  }
+  // prefix offsets of each feature's bin run inside the compact buffer
+  std::vector<size_t> offsets(fids.size() + 1, 0);
+  for (size_t i = 0; i < fids.size(); ++i) {
+    offsets[i + 1] = offsets[i] + (cut_ptrs[fids[i] + 1] - cut_ptrs[fids[i]]);
+  }
+  const size_t n_sampled_bins = offsets.back();
+
+  sampled_hist_buffer_.resize(n_sampled_bins * sync_count);
+  GradientPairT* hist_data = hist_[starting_index].data();
+  GradientPairT* compact = sampled_hist_buffer_.data();
+
+  const auto n_blocks =
+      static_cast<bst_omp_uint>(sync_count * fids.size());
+#pragma omp parallel for schedule(static)
+  for (bst_omp_uint block = 0; block < n_blocks; ++block) {
+    const size_t row = block / fids.size();
+    const size_t f = block % fids.size();
+    const uint32_t ibegin = cut_ptrs[fids[f]];
+    const uint32_t iend = cut_ptrs[fids[f] + 1];
+    std::copy(hist_data + row * nbins + ibegin, hist_data + row * nbins + iend,
+              compact + row * n_sampled_bins + offsets[f]);
+  }
+  histred_.Allreduce(compact, n_sampled_bins * sync_count);
+#pragma omp parallel for schedule(static)
+  for (bst_omp_uint block = 0; block < n_blocks; ++block) {
+    const size_t row = block / fids.size();
+    const size_t f = block % fids.size();
+    const uint32_t ibegin = cut_ptrs[fids[f]];
+    const uint32_t iend = cut_ptrs[fids[f] + 1];
+    std::copy(compact + row * n_sampled_bins + offsets[f],
+              compact + row * n_sampled_bins + offsets[f] + (iend - ibegin),
+              hist_data + row * nbins + ibegin);
+  }
+}
+
 template <typename GradientSumT>
 void QuantileHistMaker::Builder<GradientSumT>::SetHistSynchronizer(
     HistSynchronizer<GradientSumT> *sync) {
@@ -302,6 +632,10 @@ void QuantileHistMaker::Builder<GradientSumT>::BuildHistogramsLossGuide(
         p_tree->GetDepth(entry.sibling_nid), 0.0f, 0);
   }
 
+  if (ReusableHistograms()) {
+    return;
+  }
+
   int starting_index = std::numeric_limits<int>::max();
   int sync_count = 0;
 
@@ -310,6 +644,18 @@ void QuantileHistMaker::Builder<GradientSumT>::BuildHistogramsLossGuide(
   hist_synchronizer_->SyncHistograms(this, starting_index, sync_count, p_tree);
 }
 
+template <typename GradientSumT>
+bool QuantileHistMaker::Builder<GradientSumT>::ReusableHistograms() const {
+  if (!reuse_histograms_) {
+    return false;
+  }
+  auto cached = [this](const ExpandEntry& e) { return hist_.RowExists(e.nid); };
+  return std::all_of(nodes_for_explicit_hist_build_.begin(),
+                     nodes_for_explicit_hist_build_.end(), cached) &&
+         std::all_of(nodes_for_subtraction_trick_.begin(),
+                     nodes_for_subtraction_trick_.end(), cached);
+}
+
 template<typename GradientSumT>
 void QuantileHistMaker::Builder<GradientSumT>::BuildLocalHistograms(
     const GHistIndexMatrix &gmat,
@@ -320,11 +666,75 @@ void QuantileHistMaker::Builder<GradientSumT>::BuildLocalHistograms(
 
   const size_t n_nodes = nodes_for_explicit_hist_build_.size();
 
-  // create space of size (# rows in each node)
-  common::BlockedSpace2d space(n_nodes, [&](size_t node) {
+  // rows per block, calibrated once per machine when XGBOOST_CALIBRATE is set
+  const size_t kRowGrain = common::KernelCalibration::Params().hist_row_grain;
+  auto node_size = [&](size_t node) {
     const int32_t nid = nodes_for_explicit_hist_build_[node].nid;
     return row_set_collection_[nid].Size();
-  }, 256);
+  };
+  // Create space of size (# rows in each node).  Sparse rows vary wildly in
+  // length, so blocks of a fixed row count can differ by orders of magnitude
+  // in the entries they stream and the heaviest block straggles the whole
+  // frontier; cut the blocks by accumulated entry count there instead,
+  // targeting the average entries a dense block of kRowGrain rows carries.
+  auto make_space = [&]() {
+    if (data_layout_ == DataLayout::kSparseData && gmat.Size() != 0) {
+      const size_t* row_ptr = gmat.row_ptr.data();
+      const size_t grain =
+          kRowGrain * std::max<size_t>(1, row_ptr[gmat.Size()] / gmat.Size());
+      return common::BlockedSpace2d(
+          n_nodes, node_size,
+          [&](size_t node, size_t j) {
+            const int32_t nid = nodes_for_explicit_hist_build_[node].nid;
+            const size_t rid = row_set_collection_[nid].begin[j];
+            return row_ptr[rid + 1] - row_ptr[rid];
+          },
+          grain);
+    }
+    return common::BlockedSpace2d(n_nodes, node_size, kRowGrain);
+  };
+  common::BlockedSpace2d space = make_space();
+
+  size_t total_rows = 0;
+  for (size_t i = 0; i < n_nodes; ++i) {
+    total_rows += row_set_collection_[nodes_for_explicit_hist_build_[i].nid].Size();
+  }
+  static const size_t kRowsSlot =
+      common::ProfileRegistry::Instance().Register("build_hist_rows");
+  static const size_t kBytesSlot =
+      common::ProfileRegistry::Instance().Register("build_hist_index_bytes");
+  static const size_t kTicksSlot =
+      common::ProfileRegistry::Instance().Register("build_hist_ticks");
+  common::ProfileRegistry::Instance().Add(kRowsSlot, total_rows);
+  const size_t n_rows_in_matrix = gmat.Size();
+  if (n_rows_in_matrix != 0) {
+    // index bytes streamed through the kernels, averaged over the matrix
+    common::ProfileRegistry::Instance().Add(
+        kBytesSlot, total_rows * (gmat.index.Size() / n_rows_in_matrix) *
+                        gmat.index.GetBinTypeSize());
+  }
+  common::ProfileTimer build_timer{kTicksSlot};
+
+  // Dense tall-thin frontiers build faster column-parallel: each thread owns
+  // a contiguous slice of the features and writes only that slice's bin range
+  // of the output histograms, so write traffic is partitioned by construction
+  // and there are no per-thread copies and no merge phase.  Row-parallel
+  // stays ahead when rows are scarce relative to the pool - slices bound the
+  // parallelism by the feature count - or when the matrix is sparse.
+  hist_built_directly_ = false;
+  if (data_layout_ != DataLayout::kSparseData &&
+      param_.enable_feature_grouping <= 0 && !use_quantized_gradients_) {
+    constexpr size_t kColumnParallelRowsPerThread = 1 << 18;
+    constexpr size_t kColumnParallelMaxFeatures = 256;
+    const size_t n_features = gmat.cut.Ptrs().size() - 1;
+    if (n_features <= kColumnParallelMaxFeatures &&
+        total_rows >= kColumnParallelRowsPerThread * this->nthread_) {
+      BuildHistogramsByColumns(gmat, gpair_h, n_nodes);
+      hist_built_directly_ = true;
+      builder_monitor_.Stop("BuildLocalHistograms");
+      return;
+    }
+  }
 
   std::vector<GHistRowT> target_hists(n_nodes);
   for (size_t i = 0; i < n_nodes; ++i) {
@@ -332,11 +742,29 @@ void QuantileHistMaker::Builder<GradientSumT>::BuildLocalHistograms(
     target_hists[i] = hist_[nid];
   }
 
-  hist_buffer_.Reset(this->nthread_, n_nodes, space, target_hists);
+  // the row-parallel build runs at its calibrated budget rather than the
+  // full pool; the scratch buffers and reduction only see the threads that
+  // actually build
+  hist_build_budget_.SetMaxThreads(this->nthread_);
+  const int32_t n_build_threads = hist_build_budget_.Threads(total_rows);
+  common::Timer budget_timer;
+
+  // Blocks may be stolen across workers, so any thread can touch any node,
+  // which in the worst case costs one histogram copy per (thread, node) pair.
+  // When that exceeds the scratch budget, fall back to the static block
+  // assignment: a node that fits inside one thread's chunk is then built by
+  // that thread directly into its output histogram without any copy, and the
+  // scratch stays bounded by roughly one copy per thread.
+  bool any_thread_any_node = true;
+  if (max_hist_buffer_bytes_ > 0) {
+    const size_t worst_case_bytes = n_build_threads * n_nodes *
+        hist_builder_.GetNumBins() * sizeof(GradientPairT);
+    any_thread_any_node = worst_case_bytes <= max_hist_buffer_bytes_;
+  }
+  hist_buffer_.Reset(n_build_threads, n_nodes, space, target_hists,
+                     any_thread_any_node);
 
-  // Parallel processing by nodes and data in each node
-  common::ParallelFor2d(space, this->nthread_, [&](size_t nid_in_set, common::Range1d r) {
-    const auto tid = static_cast<unsigned>(omp_get_thread_num());
+  auto build_block = [&](size_t tid, size_t nid_in_set, common::Range1d r) {
     const int32_t nid = nodes_for_explicit_hist_build_[nid_in_set].nid;
 
     auto start_of_row_set = row_set_collection_[nid].begin;
@@ -344,11 +772,49 @@ void QuantileHistMaker::Builder<GradientSumT>::BuildLocalHistograms(
                                       start_of_row_set + r.end(),
                                       nid);
     BuildHist(gpair_h, rid_set, gmat, gmatb, hist_buffer_.GetInitializedHist(tid, nid_in_set));
-  });
+  };
+
+  // Parallel processing by nodes and data in each node
+  if (any_thread_any_node) {
+    WorkPool().ParallelFor2d(space, build_block, n_build_threads);
+  } else {
+    common::ParallelFor2d(space, n_build_threads, [&](size_t nid_in_set, common::Range1d r) {
+      build_block(omp_get_thread_num(), nid_in_set, r);
+    });
+  }
+  budget_timer.Stop();
+  hist_build_budget_.Observe(total_rows, budget_timer.ElapsedSeconds());
 
   builder_monitor_.Stop("BuildLocalHistograms");
 }
 
+template<typename GradientSumT>
+void QuantileHistMaker::Builder<GradientSumT>::BuildHistogramsByColumns(
+    const GHistIndexMatrix &gmat,
+    const std::vector<GradientPair> &gpair_h,
+    size_t n_nodes) {
+  const std::vector<uint32_t>& cut_ptrs = gmat.cut.Ptrs();
+  const size_t n_features = cut_ptrs.size() - 1;
+  const size_t n_slices = std::min<size_t>(this->nthread_, n_features);
+
+  // one block per (node, feature slice); slice s covers the features in
+  // [s * n_features / n_slices, (s + 1) * n_features / n_slices)
+  common::BlockedSpace2d space(n_nodes, [&](size_t) { return n_slices; }, 1);
+
+  WorkPool().ParallelFor2d(space, [&](size_t, size_t nid_in_set, common::Range1d r) {
+    const int32_t nid = nodes_for_explicit_hist_build_[nid_in_set].nid;
+    GHistRowT hist = hist_[nid];
+    for (size_t s = r.begin(); s < r.end(); ++s) {
+      const size_t f_begin = s * n_features / n_slices;
+      const size_t f_end = (s + 1) * n_features / n_slices;
+      // the slice owns its bin range exclusively: zero it, then accumulate
+      common::InitilizeHistByZeroes(hist, cut_ptrs[f_begin], cut_ptrs[f_end]);
+      hist_builder_.BuildHistColumns(gpair_h, row_set_collection_[nid],
+                                     gmat, f_begin, f_end, hist);
+    }
+  });
+}
+
 template<typename GradientSumT>
 void QuantileHistMaker::Builder<GradientSumT>::BuildNodeStats(
     const GHistIndexMatrix &gmat,
@@ -375,6 +841,30 @@ void QuantileHistMaker::Builder<GradientSumT>::BuildNodeStats(
   builder_monitor_.Stop("BuildNodeStats");
 }
 
+template<typename GradientSumT>
+void QuantileHistMaker::Builder<GradientSumT>::ApplyTreeSplit(
+    int nid, RegTree* p_tree,
+    TreeEvaluator::SplitEvaluator<TrainParam> const& evaluator) {
+  NodeEntry& e = snode_[nid];
+  bst_float left_leaf_weight =
+      evaluator.CalcWeight(nid, param_, GradStats{e.best.left_sum}) * param_.learning_rate;
+  bst_float right_leaf_weight =
+      evaluator.CalcWeight(nid, param_, GradStats{e.best.right_sum}) * param_.learning_rate;
+  if (e.best.is_cat) {
+    p_tree->ExpandCategorical(
+        nid, e.best.SplitIndex(),
+        {e.best.cat_bits.data(), e.best.cat_bits.size()}, e.best.DefaultLeft(),
+        e.weight, left_leaf_weight, right_leaf_weight, e.best.loss_chg,
+        e.stats.GetHess(), e.best.left_sum.GetHess(),
+        e.best.right_sum.GetHess());
+  } else {
+    p_tree->ExpandNode(nid, e.best.SplitIndex(), e.best.split_value,
+                       e.best.DefaultLeft(), e.weight, left_leaf_weight,
+                       right_leaf_weight, e.best.loss_chg, e.stats.GetHess(),
+                       e.best.left_sum.GetHess(), e.best.right_sum.GetHess());
+  }
+}
+
 template<typename GradientSumT>
 void QuantileHistMaker::Builder<GradientSumT>::AddSplitsToTree(
           const GHistIndexMatrix &gmat,
@@ -395,15 +885,7 @@ void QuantileHistMaker::Builder<GradientSumT>::AddSplitsToTree(
     } else {
       nodes_for_apply_split->push_back(entry);
 
-      NodeEntry& e = snode_[nid];
-      bst_float left_leaf_weight =
-          evaluator.CalcWeight(nid, param_, GradStats{e.best.left_sum}) * param_.learning_rate;
-      bst_float right_leaf_weight =
-          evaluator.CalcWeight(nid, param_, GradStats{e.best.right_sum}) * param_.learning_rate;
-      p_tree->ExpandNode(nid, e.best.SplitIndex(), e.best.split_value,
-                         e.best.DefaultLeft(), e.weight, left_leaf_weight,
-                         right_leaf_weight, e.best.loss_chg, e.stats.GetHess(),
-                         e.best.left_sum.GetHess(), e.best.right_sum.GetHess());
+      this->ApplyTreeSplit(nid, p_tree, evaluator);
 
       int left_id = (*p_tree)[nid].LeftChild();
       int right_id = (*p_tree)[nid].RightChild();
@@ -466,6 +948,14 @@ void QuantileHistMaker::Builder<GradientSumT>::SplitSiblings(
       }
     }
   }
+  // Frontier-level schedule for the single batched build pass: largest nodes
+  // first, so their blocks are handed out before the tail of small nodes and
+  // threads drain the frontier without waiting on one big node at the end.
+  std::stable_sort(small_siblings->begin(), small_siblings->end(),
+                   [this](ExpandEntry const& lhs, ExpandEntry const& rhs) {
+                     return row_set_collection_[lhs.nid].Size() >
+                            row_set_collection_[rhs.nid].Size();
+                   });
   builder_monitor_.Stop("SplitSiblings");
 }
 template<typename GradientSumT>
@@ -489,9 +979,11 @@ void QuantileHistMaker::Builder<GradientSumT>::ExpandWithDepthWise(
     std::vector<ExpandEntry> temp_qexpand_depth;
     SplitSiblings(qexpand_depth_wise_, &nodes_for_explicit_hist_build_,
                   &nodes_for_subtraction_trick_, p_tree);
-    hist_rows_adder_->AddHistRows(this, &starting_index, &sync_count, p_tree);
-    BuildLocalHistograms(gmat, gmatb, p_tree, gpair_h);
-    hist_synchronizer_->SyncHistograms(this, starting_index, sync_count, p_tree);
+    if (!ReusableHistograms()) {
+      hist_rows_adder_->AddHistRows(this, &starting_index, &sync_count, p_tree);
+      BuildLocalHistograms(gmat, gmatb, p_tree, gpair_h);
+      hist_synchronizer_->SyncHistograms(this, starting_index, sync_count, p_tree);
+    }
     BuildNodeStats(gmat, p_fmat, p_tree, gpair_h);
 
     EvaluateAndApplySplits(gmat, column_matrix, p_tree, &num_leaves, depth, &timestamp,
@@ -534,57 +1026,196 @@ void QuantileHistMaker::Builder<GradientSumT>::ExpandWithLossGuide(
   ++num_leaves;
 
   while (!qexpand_loss_guided_->empty()) {
-    const ExpandEntry candidate = qexpand_loss_guided_->top();
-    const int nid = candidate.nid;
-    qexpand_loss_guided_->pop();
-    if (candidate.IsValid(param_, num_leaves)) {
-      (*p_tree)[nid].SetLeaf(snode_[nid].weight * param_.learning_rate);
-    } else {
-      auto evaluator = tree_evaluator_.GetEvaluator();
-      NodeEntry& e = snode_[nid];
-      bst_float left_leaf_weight =
-          evaluator.CalcWeight(nid, param_, GradStats{e.best.left_sum}) * param_.learning_rate;
-      bst_float right_leaf_weight =
-          evaluator.CalcWeight(nid, param_, GradStats{e.best.right_sum}) * param_.learning_rate;
-      p_tree->ExpandNode(nid, e.best.SplitIndex(), e.best.split_value,
-                         e.best.DefaultLeft(), e.weight, left_leaf_weight,
-                         right_leaf_weight, e.best.loss_chg, e.stats.GetHess(),
-                         e.best.left_sum.GetHess(), e.best.right_sum.GetHess());
-
-      this->ApplySplit({candidate}, gmat, column_matrix, hist_, p_tree);
+    // drain the top of the queue; entries that cannot improve or that the
+    // leaf budget no longer covers become leaves, as in the serial loop
+    std::vector<ExpandEntry> batch;
+    while (!qexpand_loss_guided_->empty() &&
+           batch.size() < lossguide_expand_batch_) {
+      const ExpandEntry candidate = qexpand_loss_guided_->top();
+      const int nid = candidate.nid;
+      qexpand_loss_guided_->pop();
+      if ((*p_tree)[nid].IsDeleted() || !(*p_tree)[nid].IsLeaf()) {
+        // stale entry: the node was rolled back or already expanded during a
+        // speculative fix-up
+        continue;
+      }
+      if (candidate.IsValid(param_,
+                            num_leaves + static_cast<int>(batch.size()))) {
+        (*p_tree)[nid].SetLeaf(snode_[nid].weight * param_.learning_rate);
+      } else {
+        batch.push_back(candidate);
+      }
+    }
+    if (batch.empty()) {
+      continue;
+    }
 
+    // commit all drained splits to the tree, in gain order, and partition
+    // their rows in one batched pass
+    auto evaluator = tree_evaluator_.GetEvaluator();
+    for (const ExpandEntry& candidate : batch) {
+      this->ApplyTreeSplit(candidate.nid, p_tree, evaluator);
+      ++num_leaves;  // give two and take one, as parent is no longer a leaf
+    }
+    this->ApplySplit(batch, gmat, column_matrix, hist_, p_tree);
+
+    // one histogram frontier for all the new children: the smaller sibling
+    // is built explicitly, the larger one by the subtraction trick
+    nodes_for_explicit_hist_build_.clear();
+    nodes_for_subtraction_trick_.clear();
+    std::vector<ExpandEntry> child_nodes;
+    for (const ExpandEntry& candidate : batch) {
+      const int nid = candidate.nid;
       const int cleft = (*p_tree)[nid].LeftChild();
       const int cright = (*p_tree)[nid].RightChild();
-
       ExpandEntry left_node(cleft, cright, p_tree->GetDepth(cleft),
                             0.0f, timestamp++);
       ExpandEntry right_node(cright, cleft, p_tree->GetDepth(cright),
                             0.0f, timestamp++);
-
       if (row_set_collection_[cleft].Size() < row_set_collection_[cright].Size()) {
-        BuildHistogramsLossGuide(left_node, gmat, gmatb, p_tree, gpair_h);
+        nodes_for_explicit_hist_build_.push_back(left_node);
+        nodes_for_subtraction_trick_.push_back(right_node);
       } else {
-        BuildHistogramsLossGuide(right_node, gmat, gmatb, p_tree, gpair_h);
+        nodes_for_explicit_hist_build_.push_back(right_node);
+        nodes_for_subtraction_trick_.push_back(left_node);
       }
+      child_nodes.push_back(left_node);
+      child_nodes.push_back(right_node);
+    }
+    if (!ReusableHistograms()) {
+      int starting_index = std::numeric_limits<int>::max();
+      int sync_count = 0;
+      hist_rows_adder_->AddHistRows(this, &starting_index, &sync_count, p_tree);
+      BuildLocalHistograms(gmat, gmatb, p_tree, gpair_h);
+      hist_synchronizer_->SyncHistograms(this, starting_index, sync_count, p_tree);
+    }
 
+    for (const ExpandEntry& candidate : batch) {
+      const int nid = candidate.nid;
+      const int cleft = (*p_tree)[nid].LeftChild();
+      const int cright = (*p_tree)[nid].RightChild();
       this->InitNewNode(cleft, gmat, gpair_h, *p_fmat, *p_tree);
       this->InitNewNode(cright, gmat, gpair_h, *p_fmat, *p_tree);
       bst_uint featureid = snode_[nid].best.SplitIndex();
       tree_evaluator_.AddSplit(nid, cleft, cright, featureid,
                                snode_[cleft].weight, snode_[cright].weight);
       interaction_constraints_.Split(nid, featureid, cleft, cright);
+    }
+    this->EvaluateSplits(child_nodes, gmat, hist_, *p_tree);
+    for (ExpandEntry& child : child_nodes) {
+      child.loss_chg = snode_[child.nid].best.loss_chg;
+      qexpand_loss_guided_->push(child);
+    }
 
-      this->EvaluateSplits({left_node, right_node}, gmat, hist_, *p_tree);
-      left_node.loss_chg = snode_[cleft].best.loss_chg;
-      right_node.loss_chg = snode_[cright].best.loss_chg;
+    if (param_.max_leaves > 0 && num_leaves == param_.max_leaves) {
+      RollBackSpeculativeLosers(&batch, child_nodes, gmat, gmatb,
+                                column_matrix, p_fmat, p_tree, &num_leaves,
+                                &timestamp, gpair_h);
+    }
+  }
+  builder_monitor_.Stop("ExpandWithLossGuide");
+}
 
-      qexpand_loss_guided_->push(left_node);
-      qexpand_loss_guided_->push(right_node);
+template<typename GradientSumT>
+void QuantileHistMaker::Builder<GradientSumT>::RollBackSpeculativeLosers(
+    std::vector<ExpandEntry>* p_batch,
+    const std::vector<ExpandEntry>& child_nodes,
+    const GHistIndexMatrix& gmat,
+    const GHistIndexBlockMatrix& gmatb,
+    const ColumnMatrix& column_matrix,
+    DMatrix* p_fmat,
+    RegTree* p_tree,
+    int* num_leaves,
+    unsigned* timestamp,
+    const std::vector<GradientPair>& gpair_h) {
+  std::vector<ExpandEntry>& batch = *p_batch;
+  // work on a copy of the frontier: rolled-back children must be dropped
+  // from it before their node ids are recycled below
+  std::vector<ExpandEntry> frontier(child_nodes);
+  // the batch was drained from the priority queue, so the weakest member is
+  // at the back
+  while (batch.size() > 1) {
+    const ExpandEntry weakest = batch.back();
+    // the best child of an earlier member; children of the weakest member
+    // itself did not exist when the serial loop chose it, and children
+    // expanded by an earlier fix-up round are no longer leaves
+    const ExpandEntry* best_child = nullptr;
+    for (const ExpandEntry& child : frontier) {
+      if (!(*p_tree)[child.nid].IsLeaf() ||
+          (*p_tree)[child.nid].Parent() == weakest.nid) {
+        continue;
+      }
+      if (best_child == nullptr || child.loss_chg > best_child->loss_chg) {
+        best_child = &child;
+      }
+    }
+    if (best_child == nullptr || !(best_child->loss_chg > weakest.loss_chg)) {
+      break;
+    }
+    const ExpandEntry fixup = *best_child;
+    frontier.erase(std::remove_if(frontier.begin(), frontier.end(),
+                                  [&](const ExpandEntry& e) {
+                                    return (*p_tree)[e.nid].Parent() == weakest.nid;
+                                  }),
+                   frontier.end());
+
+    // roll the weakest split back; its rows are handed back to the parent
+    // so the freed child slots can be recycled by the expansion below, and
+    // the stale child histograms are dropped so the recycled node ids get
+    // freshly built ones
+    const int wleft = (*p_tree)[weakest.nid].LeftChild();
+    const int wright = (*p_tree)[weakest.nid].RightChild();
+    row_set_collection_.UniteSplit(weakest.nid, wleft, wright);
+    for (const int wnid : {wleft, wright}) {
+      if (hist_.RowExists(wnid)) {
+        hist_.RemoveHistRow(wnid);
+      }
+      if (hist_local_worker_.RowExists(wnid)) {
+        hist_local_worker_.RemoveHistRow(wnid);
+      }
+    }
+    p_tree->ChangeToLeaf(weakest.nid,
+                         snode_[weakest.nid].weight * param_.learning_rate);
+    batch.pop_back();
+    --(*num_leaves);
 
-      ++num_leaves;  // give two and take one, as parent is no longer a leaf
+    // hand the freed leaf budget to the child, replaying the serial
+    // expansion; its stale queue entry is skipped by the drain loop
+    const int nid = fixup.nid;
+    this->ApplyTreeSplit(nid, p_tree, tree_evaluator_.GetEvaluator());
+
+    this->ApplySplit({fixup}, gmat, column_matrix, hist_, p_tree);
+
+    const int cleft = (*p_tree)[nid].LeftChild();
+    const int cright = (*p_tree)[nid].RightChild();
+
+    ExpandEntry left_node(cleft, cright, p_tree->GetDepth(cleft),
+                          0.0f, (*timestamp)++);
+    ExpandEntry right_node(cright, cleft, p_tree->GetDepth(cright),
+                          0.0f, (*timestamp)++);
+
+    if (row_set_collection_[cleft].Size() < row_set_collection_[cright].Size()) {
+      BuildHistogramsLossGuide(left_node, gmat, gmatb, p_tree, gpair_h);
+    } else {
+      BuildHistogramsLossGuide(right_node, gmat, gmatb, p_tree, gpair_h);
     }
+
+    this->InitNewNode(cleft, gmat, gpair_h, *p_fmat, *p_tree);
+    this->InitNewNode(cright, gmat, gpair_h, *p_fmat, *p_tree);
+    bst_uint featureid = snode_[nid].best.SplitIndex();
+    tree_evaluator_.AddSplit(nid, cleft, cright, featureid,
+                             snode_[cleft].weight, snode_[cright].weight);
+    interaction_constraints_.Split(nid, featureid, cleft, cright);
+
+    this->EvaluateSplits({left_node, right_node}, gmat, hist_, *p_tree);
+    left_node.loss_chg = snode_[cleft].best.loss_chg;
+    right_node.loss_chg = snode_[cright].best.loss_chg;
+
+    qexpand_loss_guided_->push(left_node);
+    qexpand_loss_guided_->push(right_node);
+
+    ++(*num_leaves);
   }
-  builder_monitor_.Stop("ExpandWithLossGuide");
 }
 
 template <typename GradientSumT>
@@ -594,13 +1225,27 @@ void QuantileHistMaker::Builder<GradientSumT>::Update(
     DMatrix *p_fmat, RegTree *p_tree) {
   builder_monitor_.Start("Update");
 
-  const std::vector<GradientPair>& gpair_h = gpair->ConstHostVector();
+  const bool gradient_based_sampling =
+      param_.subsample < 1.0f &&
+      param_.sampling_method == TrainParam::kGradientBased;
+  if (gradient_based_sampling) {
+    // the sampling rescales the pairs of the sampled rows, keep the caller's
+    // gradients intact by working on a copy
+    gpair_local_ = gpair->ConstHostVector();
+  }
+  const std::vector<GradientPair>& gpair_h =
+      gradient_based_sampling ? gpair_local_ : gpair->ConstHostVector();
 
   tree_evaluator_ =
       TreeEvaluator(param_, p_fmat->Info().num_col_, GenericParameter::kCpuId);
   interaction_constraints_.Reset();
 
   this->InitData(gmat, gpair_h, *p_fmat, *p_tree);
+  // reserve the node storage up front so ExpandNode does not reallocate the
+  // node arrays split by split
+  if (param_.max_leaves > 0 || (param_.max_depth > 0 && param_.max_depth <= 16)) {
+    p_tree->Reserve(param_.MaxNodes());
+  }
   if (param_.grow_policy == TrainParam::kLossGuide) {
     ExpandWithLossGuide(gmat, gmatb, column_matrix, p_fmat, p_tree, gpair_h);
   } else {
@@ -675,25 +1320,13 @@ void QuantileHistMaker::Builder<GradientSumT>::InitSampling(const std::vector<Gr
   auto& rnd = common::GlobalRandom();
   std::vector<size_t>& row_indices_local = *row_indices;
   size_t* p_row_indices = row_indices_local.data();
-#if XGBOOST_CUSTOMIZE_GLOBAL_PRNG
-  std::bernoulli_distribution coin_flip(param_.subsample);
-  size_t j = 0;
-  for (size_t i = 0; i < info.num_row_; ++i) {
-    if (gpair[i].GetHess() >= 0.0f && coin_flip(rnd)) {
-      p_row_indices[j++] = i;
-    }
-  }
-  /* resize row_indices to reduce memory */
-  row_indices_local.resize(j);
-#else
   const size_t nthread = this->nthread_;
   std::vector<size_t> row_offsets(nthread, 0);
-  /* usage of mt19937_64 give 2x speed up for subsampling */
-  std::vector<std::mt19937> rnds(nthread);
-  /* create engine for each thread */
-  for (std::mt19937& r : rnds) {
-    r = rnd;
-  }
+  /* every row flips its coin from a counter-based stream indexed by the row
+   * number, so the sample is identical for every thread count; the global
+   * engine only seeds the pass */
+  uint64_t pass_seed = rnd();
+  pass_seed = (pass_seed << 32) | rnd();
   const size_t discard_size = info.num_row_ / nthread;
   auto upper_border = static_cast<float>(std::numeric_limits<uint32_t>::max());
   uint32_t coin_flip_border = static_cast<uint32_t>(upper_border * param_.subsample);
@@ -704,15 +1337,56 @@ void QuantileHistMaker::Builder<GradientSumT>::InitSampling(const std::vector<Gr
     const size_t iend = (tid == (nthread - 1)) ?
                         info.num_row_ : ibegin + discard_size;
 
-    rnds[tid].discard(discard_size * tid);
+    common::PhiloxEngine eng{pass_seed};
+    eng.discard(ibegin);
+    for (size_t i = ibegin; i < iend; ++i) {
+      const uint32_t coin = eng();
+      if (gpair[i].GetHess() >= 0.0f && coin < coin_flip_border) {
+        p_row_indices[ibegin + row_offsets[tid]++] = i;
+      }
+    }
+  }
+  size_t prefix_sum = row_offsets[0];
+  for (size_t i = 1; i < nthread; ++i) {
+    const size_t ibegin = i * discard_size;
+
+    for (size_t k = 0; k < row_offsets[i]; ++k) {
+      row_indices_local[prefix_sum + k] = row_indices_local[ibegin + k];
+    }
+    prefix_sum += row_offsets[i];
+  }
+  /* resize row_indices to reduce memory */
+  row_indices_local.resize(prefix_sum);
+}
+
+template<typename GradientSumT>
+void QuantileHistMaker::Builder<GradientSumT>::InitSamplingStratified(
+    const std::vector<GradientPair>& gpair, const DMatrix& fmat,
+    std::vector<size_t>* row_indices) {
+  const auto& info = fmat.Info();
+  const std::vector<uint8_t> mask = common::StratifiedSampleRows(
+      gpair, info.labels_.ConstHostVector(), param_.subsample, this->nthread_);
+
+  // compact the mask into the row list with the same blocked scheme as
+  // InitSampling: each thread fills the head of its own block, then the
+  // blocks are concatenated
+  std::vector<size_t>& row_indices_local = *row_indices;
+  size_t* p_row_indices = row_indices_local.data();
+  const size_t nthread = this->nthread_;
+  std::vector<size_t> row_offsets(nthread, 0);
+  const size_t discard_size = info.num_row_ / nthread;
+  #pragma omp parallel num_threads(nthread)
+  {
+    const size_t tid = omp_get_thread_num();
+    const size_t ibegin = tid * discard_size;
+    const size_t iend = (tid == (nthread - 1)) ?
+                        info.num_row_ : ibegin + discard_size;
     for (size_t i = ibegin; i < iend; ++i) {
-      if (gpair[i].GetHess() >= 0.0f && rnds[tid]() < coin_flip_border) {
+      if (mask[i]) {
         p_row_indices[ibegin + row_offsets[tid]++] = i;
       }
     }
   }
-  /* discard global engine */
-  rnd = rnds[nthread - 1];
   size_t prefix_sum = row_offsets[0];
   for (size_t i = 1; i < nthread; ++i) {
     const size_t ibegin = i * discard_size;
@@ -724,7 +1398,71 @@ void QuantileHistMaker::Builder<GradientSumT>::InitSampling(const std::vector<Gr
   }
   /* resize row_indices to reduce memory */
   row_indices_local.resize(prefix_sum);
-#endif  // XGBOOST_CUSTOMIZE_GLOBAL_PRNG
+}
+
+template<typename GradientSumT>
+void QuantileHistMaker::Builder<GradientSumT>::InitSamplingGradientBased(
+    std::vector<GradientPair>* p_gpair, const DMatrix& fmat,
+    std::vector<size_t>* row_indices) {
+  const auto& info = fmat.Info();
+  std::vector<GradientPair>& gpair = *p_gpair;
+  const size_t n_rows = info.num_row_;
+  const auto sample_rows = static_cast<size_t>(n_rows * param_.subsample);
+
+  /* combine the pair into a single weight following Minimal Variance Sampling
+   * with lambda = 0.1, the same scheme the GPU GradientBasedSampler uses */
+  constexpr float kLambda = 0.1f;
+  auto combine = [](GradientPair const& g) {
+    return std::sqrt(g.GetGrad() * g.GetGrad() +
+                     kLambda * g.GetHess() * g.GetHess());
+  };
+  std::vector<float> threshold(n_rows + 1);
+  common::ParallelFor(n_rows, this->nthread_, [&](size_t i) {
+    threshold[i] = combine(gpair[i]);
+  });
+  threshold[n_rows] = std::numeric_limits<float>::max();
+  std::sort(threshold.begin(), threshold.end() - 1);
+
+  /* search for the sampling threshold u: rows whose combined weight exceeds u
+   * are always kept, the rest are kept with probability weight / u, so that
+   * the expected number of sampled rows matches sample_rows */
+  size_t threshold_index = 1;
+  double running_sum = 0.0;
+  for (size_t i = 0; i < n_rows; ++i) {
+    running_sum += threshold[i];
+    float u = static_cast<float>(running_sum) /
+              static_cast<float>(sample_rows - n_rows + i + 1);
+    if (u > threshold[i] && u <= threshold[i + 1]) {
+      threshold[i + 1] = u;
+      threshold_index = i + 1;
+      break;
+    }
+  }
+  const float u = threshold[threshold_index];
+
+  auto& rnd = common::GlobalRandom();
+  std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+  std::vector<size_t>& row_indices_local = *row_indices;
+  size_t* p_row_indices = row_indices_local.data();
+  size_t j = 0;
+  for (size_t i = 0; i < n_rows; ++i) {
+    if (gpair[i].GetGrad() == 0.0f && gpair[i].GetHess() == 0.0f) {
+      continue;
+    }
+    const float p = combine(gpair[i]) / u;
+    if (p >= 1.0f) {
+      p_row_indices[j++] = i;
+    } else if (dist(rnd) <= p) {
+      /* scale the pair by the inverse probability to keep the histogram sums
+       * unbiased */
+      gpair[i] /= p;
+      p_row_indices[j++] = i;
+    } else {
+      gpair[i] = GradientPair();
+    }
+  }
+  /* resize row_indices to reduce memory */
+  row_indices_local.resize(j);
 }
 template<typename GradientSumT>
 void QuantileHistMaker::Builder<GradientSumT>::InitData(const GHistIndexMatrix& gmat,
@@ -746,10 +1484,11 @@ void QuantileHistMaker::Builder<GradientSumT>::InitData(const GHistIndexMatrix&
     row_set_collection_.Clear();
     // clear local prediction cache
     leaf_value_cache_.clear();
-    // initialize histogram collection
+    // initialize histogram collection; keep the rows of the previous tree
+    // when they are going to be reused
     uint32_t nbins = gmat.cut.Ptrs().back();
-    hist_.Init(nbins);
-    hist_local_worker_.Init(nbins);
+    hist_.Init(nbins, reuse_histograms_);
+    hist_local_worker_.Init(nbins, reuse_histograms_);
     hist_buffer_.Init(nbins);
 
     // initialize histogram builder
@@ -765,10 +1504,16 @@ void QuantileHistMaker::Builder<GradientSumT>::InitData(const GHistIndexMatrix&
     // mark subsample and build list of member rows
 
     if (param_.subsample < 1.0f) {
-      CHECK_EQ(param_.sampling_method, TrainParam::kUniform)
-        << "Only uniform sampling is supported, "
-        << "gradient-based sampling is only support by GPU Hist.";
-      InitSampling(gpair, fmat, &row_indices);
+      if (param_.sampling_method == TrainParam::kGradientBased) {
+        // Update() redirected gpair to the builder-local copy, which the
+        // sampling rescales in place
+        CHECK_EQ(gpair.data(), gpair_local_.data());
+        InitSamplingGradientBased(&gpair_local_, fmat, &row_indices);
+      } else if (param_.sampling_method == TrainParam::kStratified) {
+        InitSamplingStratified(gpair, fmat, &row_indices);
+      } else {
+        InitSampling(gpair, fmat, &row_indices);
+      }
     } else {
       MemStackAllocator<bool, 128> buff(this->nthread_);
       bool* p_buff = buff.Get();
@@ -823,6 +1568,14 @@ void QuantileHistMaker::Builder<GradientSumT>::InitData(const GHistIndexMatrix&
 
   row_set_collection_.Init();
 
+  // quantize after sampling: gradient-based sampling rescales the pairs of
+  // the sampled rows
+  if (use_quantized_gradients_) {
+    builder_monitor_.Start("QuantizeGradients");
+    qgrads_.Init(gpair);
+    builder_monitor_.Stop("QuantizeGradients");
+  }
+
   {
     /* determine layout of data */
     const size_t nrow = info.num_row_;
@@ -841,8 +1594,24 @@ void QuantileHistMaker::Builder<GradientSumT>::InitData(const GHistIndexMatrix&
       data_layout_ = DataLayout::kSparseData;
     }
   }
+  if (rabit::IsDistributed()) {
+    // The layout above is derived from the local shard, but collectives key
+    // on it downstream: the dense path skips the root-stat reduction in
+    // InitNewNode and folds fid_least_bins_ into the sampled sync. Workers
+    // with different shards can disagree, so take the dense shortcuts only
+    // when every worker picked the same layout; otherwise demote all of them
+    // to the sparse path, which is valid for any shard.
+    uint32_t min_layout = static_cast<uint32_t>(data_layout_);
+    uint32_t max_layout = min_layout;
+    rabit::Allreduce<rabit::op::Min>(&min_layout, 1);
+    rabit::Allreduce<rabit::op::Max>(&max_layout, 1);
+    if (min_layout != max_layout) {
+      data_layout_ = DataLayout::kSparseData;
+    }
+  }
   // store a pointer to the tree
   p_last_tree_ = &tree;
+  feature_types_ = info.feature_types.ConstHostVector();
   if (data_layout_ == DataLayout::kDenseDataOneBased) {
     column_sampler_.Init(info.num_col_, info.feature_weigths.ConstHostVector(),
                          param_.colsample_bynode, param_.colsample_bylevel,
@@ -852,12 +1621,15 @@ void QuantileHistMaker::Builder<GradientSumT>::InitData(const GHistIndexMatrix&
                          param_.colsample_bynode, param_.colsample_bylevel,
                          param_.colsample_bytree, false);
   }
-  if (data_layout_ == DataLayout::kDenseDataZeroBased
-      || data_layout_ == DataLayout::kDenseDataOneBased) {
-    /* specialized code for dense data:
-       choose the column that has a least positive number of discrete bins.
+  cut_ptrs_ = &gmat.cut.Ptrs();
+  {
+    /* choose the column that has a least positive number of discrete bins.
        For dense data (with no missing value),
-       the sum of gradient histogram is equal to snode[nid] */
+       the sum of gradient histogram is equal to snode[nid].
+       The choice depends only on the quantile cuts, which are synchronized
+       across workers, so every worker picks the same column; the sampled
+       histogram sync relies on this to keep its reduce buffer identical
+       everywhere. */
     const std::vector<uint32_t>& row_ptr = gmat.cut.Ptrs();
     const auto nfeature = static_cast<bst_uint>(row_ptr.size() - 1);
     uint32_t min_nbins_per_feature = 0;
@@ -912,45 +1684,143 @@ void QuantileHistMaker::Builder<GradientSumT>::EvaluateSplits(
   const size_t n_nodes_in_set = nodes_set.size();
   const size_t nthread = std::max(1, this->nthread_);
 
-  using FeatureSetType = std::shared_ptr<HostDeviceVector<bst_feature_t>>;
-  std::vector<FeatureSetType> features_sets(n_nodes_in_set);
+  std::vector<int> depths(n_nodes_in_set);
   best_split_tloc_.resize(nthread * n_nodes_in_set);
 
-  // Generate feature set for each tree node
   for (size_t nid_in_set = 0; nid_in_set < n_nodes_in_set; ++nid_in_set) {
     const int32_t nid = nodes_set[nid_in_set].nid;
-    features_sets[nid_in_set] = column_sampler_.GetFeatureSet(tree.GetDepth(nid));
+    depths[nid_in_set] = tree.GetDepth(nid);
 
     for (unsigned tid = 0; tid < nthread; ++tid) {
       best_split_tloc_[nthread*nid_in_set + tid] = snode_[nid].best;
     }
   }
-
-  // Create 2D space (# of nodes to process x # of features to process)
+  // Generate the feature sets of the whole frontier in one pass; the spans
+  // point into the sampler's arena and are read lock-free below
+  std::vector<common::Span<bst_feature_t const>> features_sets;
+  column_sampler_.SampleFeatureSets(depths, &features_sets);
+
+  // The cost of enumerating a feature is proportional to its bin count, so
+  // the second dimension of the parallel space is blocked over bins instead
+  // of feature counts: prefix sums locate each feature's first bin, and a
+  // feature is evaluated by the block holding that bin.  Several blocks per
+  // thread leave slack for the pool's work stealing when bin counts are
+  // skewed.
+  std::vector<std::vector<size_t>> bin_ptrs(n_nodes_in_set);
+  const auto& cut_ptrs = gmat.cut.Ptrs();
+  for (size_t nid_in_set = 0; nid_in_set < n_nodes_in_set; ++nid_in_set) {
+    const auto& fset = features_sets[nid_in_set];
+    auto& bin_ptr = bin_ptrs[nid_in_set];
+    bin_ptr.resize(fset.size() + 1);
+    bin_ptr[0] = 0;
+    for (size_t i = 0; i < fset.size(); ++i) {
+      bin_ptr[i + 1] = bin_ptr[i] + (cut_ptrs[fset[i] + 1] - cut_ptrs[fset[i]]);
+    }
+  }
+  // Create 2D space (# of nodes to process x # of bins to process)
   // to process them in parallel
-  const size_t grain_size = std::max<size_t>(1, features_sets[0]->Size() / nthread);
+  const size_t grain_size = std::max<size_t>(1, bin_ptrs[0].back() / (nthread * 4));
   common::BlockedSpace2d space(n_nodes_in_set, [&](size_t nid_in_set) {
-      return features_sets[nid_in_set]->Size();
+      return bin_ptrs[nid_in_set].back();
   }, grain_size);
 
+  // With histogram reuse the later trees of a boosting round re-scan bins
+  // that cannot have changed: gradients, partitions and histograms are all
+  // identical across the round's trees.  Memoize each (node, feature) result
+  // so those repeats become lookups.  Bounded so one node's slot stays small
+  // even on wide matrices.
+  constexpr size_t kMaxSplitCacheBytesPerNode = 1u << 20;
+  const size_t n_features_total = cut_ptrs.size() - 1;
+  const bool use_split_cache =
+      cache_split_results_ &&
+      n_features_total * sizeof(SplitEntry) <= kMaxSplitCacheBytesPerNode;
+  if (use_split_cache) {
+    size_t max_nid = 0;
+    for (const ExpandEntry& e : nodes_set) {
+      max_nid = std::max(max_nid, static_cast<size_t>(e.nid));
+    }
+    if (split_result_cache_.size() <= max_nid) {
+      split_result_cache_.resize(max_nid + 1);
+      split_result_valid_.resize(max_nid + 1);
+    }
+    for (const ExpandEntry& e : nodes_set) {
+      if (split_result_cache_[e.nid].size() != n_features_total) {
+        split_result_cache_[e.nid].assign(n_features_total, SplitEntry());
+        split_result_valid_[e.nid].assign(n_features_total, 0);
+      }
+    }
+  }
+
   auto evaluator = tree_evaluator_.GetEvaluator();
+  const common::Span<FeatureType const> feature_types{feature_types_.data(),
+                                                      feature_types_.size()};
   // Start parallel enumeration for all tree nodes in the set and all features
-  common::ParallelFor2d(space, this->nthread_, [&](size_t nid_in_set, common::Range1d r) {
+  WorkPool().ParallelFor2d(space, [&](size_t tid, size_t nid_in_set, common::Range1d r) {
     const int32_t nid = nodes_set[nid_in_set].nid;
-    const auto tid = static_cast<unsigned>(omp_get_thread_num());
     GHistRowT node_hist = hist[nid];
-
-    for (auto idx_in_feature_set = r.begin(); idx_in_feature_set < r.end(); ++idx_in_feature_set) {
-      const auto fid = features_sets[nid_in_set]->ConstHostVector()[idx_in_feature_set];
-      if (interaction_constraints_.Query(nid, fid)) {
-        auto grad_stats = this->EnumerateSplit<+1>(
-            gmat, node_hist, snode_[nid],
-            &best_split_tloc_[nthread * nid_in_set + tid], fid, nid, evaluator);
-        if (SplitContainsMissingValues(grad_stats, snode_[nid])) {
-          this->EnumerateSplit<-1>(
-              gmat, node_hist, snode_[nid],
-              &best_split_tloc_[nthread * nid_in_set + tid], fid, nid,
-              evaluator);
+    // Bitset of features permitted at this node; empty when interaction
+    // constraints are disabled.  One word probe per candidate feature
+    // replaces a per-feature set lookup.
+    auto const allowed_features = interaction_constraints_.NodeConstraints(nid);
+
+    const std::vector<size_t>& bin_ptr = bin_ptrs[nid_in_set];
+    const size_t n_feats = features_sets[nid_in_set].size();
+    // first feature whose leading bin falls inside this block
+    size_t idx_in_feature_set =
+        std::lower_bound(bin_ptr.begin(), bin_ptr.begin() + n_feats, r.begin()) -
+        bin_ptr.begin();
+    for (; idx_in_feature_set < n_feats && bin_ptr[idx_in_feature_set] < r.end();
+         ++idx_in_feature_set) {
+      const auto fid = features_sets[nid_in_set][idx_in_feature_set];
+      if (allowed_features.Bits().empty() || allowed_features.Check(fid)) {
+        SplitEntry* p_best = &best_split_tloc_[nthread * nid_in_set + tid];
+        // a repeat evaluation of an unchanged histogram is a lookup
+        if (use_split_cache && split_result_valid_[nid][fid]) {
+          p_best->Update(split_result_cache_[nid][fid]);
+          continue;
+        }
+        // a feature whose gain cap cannot beat the running best is skipped
+        // before the per-bin enumeration
+        if (!FeatureCanImproveSplit(node_hist, snode_[nid], fid, gmat,
+                                    p_best->loss_chg)) {
+          continue;
+        }
+        // when memoizing, enumerate into a feature-local entry so the cached
+        // result is independent of the running best it raced against
+        SplitEntry feature_best;
+        if (use_split_cache) {
+          p_best = &feature_best;
+        }
+        if (common::IsCat(feature_types, fid)) {
+          if (evaluator.has_constraint) {
+            this->EnumerateCategoricalSplit<true>(
+                gmat, node_hist, snode_[nid], p_best, fid, nid, evaluator);
+          } else {
+            this->EnumerateCategoricalSplit<false>(
+                gmat, node_hist, snode_[nid], p_best, fid, nid, evaluator);
+          }
+        } else if (evaluator.has_constraint) {
+          // Dispatch to the EnumerateSplit instantiation matching the
+          // configuration: without monotone constraints the hot loop carries
+          // no constraint overhead at all.
+          auto grad_stats = this->EnumerateSplit<+1, true>(
+              gmat, node_hist, snode_[nid], p_best, fid, nid, evaluator);
+          if (SplitContainsMissingValues(grad_stats, snode_[nid])) {
+            this->EnumerateSplit<-1, true>(
+                gmat, node_hist, snode_[nid], p_best, fid, nid, evaluator);
+          }
+        } else {
+          auto grad_stats = this->EnumerateSplit<+1, false>(
+              gmat, node_hist, snode_[nid], p_best, fid, nid, evaluator);
+          if (SplitContainsMissingValues(grad_stats, snode_[nid])) {
+            this->EnumerateSplit<-1, false>(
+                gmat, node_hist, snode_[nid], p_best, fid, nid, evaluator);
+          }
+        }
+        if (use_split_cache) {
+          split_result_cache_[nid][fid] = feature_best;
+          split_result_valid_[nid][fid] = 1;
+          best_split_tloc_[nthread * nid_in_set + tid].Update(feature_best);
         }
       }
     }
@@ -964,9 +1834,167 @@ void QuantileHistMaker::Builder<GradientSumT>::EvaluateSplits(
     }
   }
 
+  this->SyncBestSplits(nodes_set);
+
   builder_monitor_.Stop("EvaluateSplits");
 }
 
+template <typename GradientSumT>
+void QuantileHistMaker::Builder<GradientSumT>::SyncBestSplits(
+    const std::vector<ExpandEntry>& nodes_set) {
+  if (!rabit::IsDistributed() || nodes_set.empty()) {
+    return;
+  }
+  builder_monitor_.Start("SyncBestSplits");
+  packed_split_buffer_.resize(nodes_set.size());
+  for (size_t i = 0; i < nodes_set.size(); ++i) {
+    const SplitEntry& best = snode_[nodes_set[i].nid].best;
+    PackedSplitEntry& packed = packed_split_buffer_[i];
+    packed.loss_chg = best.loss_chg;
+    packed.sindex = best.sindex;
+    packed.split_value = best.split_value;
+    packed.is_cat = best.is_cat ? 1 : 0;
+    packed.left_sum_grad = best.left_sum.GetGrad();
+    packed.left_sum_hess = best.left_sum.GetHess();
+    packed.right_sum_grad = best.right_sum.GetGrad();
+    packed.right_sum_hess = best.right_sum.GetHess();
+  }
+  // one typed collective for the whole frontier instead of a collective per
+  // node; the reduction functor keeps the better entry per slot
+  splitred_.Allreduce(packed_split_buffer_.data(), packed_split_buffer_.size());
+  for (size_t i = 0; i < nodes_set.size(); ++i) {
+    const PackedSplitEntry& packed = packed_split_buffer_[i];
+    SplitEntry& best = snode_[nodes_set[i].nid].best;
+    if (packed.sindex == best.sindex && packed.loss_chg == best.loss_chg &&
+        packed.split_value == best.split_value) {
+      // the local candidate won; keep it, including any categorical bitset
+      continue;
+    }
+    if (packed.is_cat != 0) {
+      // a categorical winner carries a variable-length bitset the fixed-size
+      // exchange cannot transport; the reduced histograms are identical on
+      // every worker so each one enumerates the same bits locally, making
+      // this branch unreachable in practice - keep the local candidate
+      continue;
+    }
+    best.loss_chg = packed.loss_chg;
+    best.sindex = packed.sindex;
+    best.split_value = packed.split_value;
+    best.is_cat = false;
+    best.cat_bits.clear();
+    best.left_sum = GradStats(packed.left_sum_grad, packed.left_sum_hess);
+    best.right_sum = GradStats(packed.right_sum_grad, packed.right_sum_hess);
+  }
+  builder_monitor_.Stop("SyncBestSplits");
+}
+
+#if defined(XGBOOST_PARTITION_VEC_KERNEL_PRESENT)
+/* Lane permutations for branch-free compaction of four 64-bit row ids.  Entry
+   m lists the 32-bit lane pairs of the elements whose bit is set in m, in
+   ascending order, so a single permutevar8x32 moves the selected row ids to
+   the front of the vector while preserving their relative order. */
+alignas(32) static const int32_t kCompressPermLut[16][8] = {
+  {0, 0, 0, 0, 0, 0, 0, 0},  // 0000
+  {0, 1, 0, 0, 0, 0, 0, 0},  // 0001
+  {2, 3, 0, 0, 0, 0, 0, 0},  // 0010
+  {0, 1, 2, 3, 0, 0, 0, 0},  // 0011
+  {4, 5, 0, 0, 0, 0, 0, 0},  // 0100
+  {0, 1, 4, 5, 0, 0, 0, 0},  // 0101
+  {2, 3, 4, 5, 0, 0, 0, 0},  // 0110
+  {0, 1, 2, 3, 4, 5, 0, 0},  // 0111
+  {6, 7, 0, 0, 0, 0, 0, 0},  // 1000
+  {0, 1, 6, 7, 0, 0, 0, 0},  // 1001
+  {2, 3, 6, 7, 0, 0, 0, 0},  // 1010
+  {0, 1, 2, 3, 6, 7, 0, 0},  // 1011
+  {4, 5, 6, 7, 0, 0, 0, 0},  // 1100
+  {0, 1, 4, 5, 6, 7, 0, 0},  // 1101
+  {2, 3, 4, 5, 6, 7, 0, 0},  // 1110
+  {0, 1, 2, 3, 4, 5, 6, 7},  // 1111
+};
+
+/* On the dense no-missing path left/right membership is a pure comparison of
+   the row's bin against the split bin, so four rows can be partitioned at a
+   time without branches: compare, turn the result into a 4-bit mask, permute
+   the matching row ids to the front of the vector and issue one unaligned
+   store into each partition buffer, advancing the counts by popcount.  The
+   stores may write up to three elements of garbage past the current count;
+   they stay inside the buffers (every row of the range ends up in one of the
+   two partitions) and are overwritten by later stores or never read.
+   n must be a multiple of four. */
+__attribute__((target("avx2")))
+static std::pair<size_t, size_t> PartitionDenseCompressAvx2(
+    const size_t* rids, const int32_t* bins, const size_t n, const int32_t split_cond,
+    size_t* p_left_part, size_t* p_right_part, size_t nleft_elems, size_t nright_elems) {
+  const __m128i v_split = _mm_set1_epi32(split_cond);
+  for (size_t i = 0; i < n; i += 4) {
+    const __m256i v_rid = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rids + i));
+    const __m128i v_bin = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bins + i));
+    const int right_mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(v_bin, v_split)));
+    const int left_mask = (~right_mask) & 0xF;
+    const __m256i v_left = _mm256_permutevar8x32_epi32(
+        v_rid, _mm256_load_si256(reinterpret_cast<const __m256i*>(kCompressPermLut[left_mask])));
+    const __m256i v_right = _mm256_permutevar8x32_epi32(
+        v_rid, _mm256_load_si256(reinterpret_cast<const __m256i*>(kCompressPermLut[right_mask])));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p_left_part + nleft_elems), v_left);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p_right_part + nright_elems), v_right);
+    nleft_elems += __builtin_popcount(left_mask);
+    nright_elems += __builtin_popcount(right_mask);
+  }
+  return {nleft_elems, nright_elems};
+}
+
+/* Vectorized variant of the dense no-missing branch of PartitionDenseKernel.
+   The bin gather stays scalar (the row ids of a node are not contiguous) and
+   is blocked so the gathered bins are still in cache when the compaction
+   kernel consumes them.  Returns false when the running CPU lacks AVX2 or the
+   range is too short to bother, so that the caller falls back to the scalar
+   loop.  Produces exactly the same partitions in the same order. */
+template <typename BinIdxType>
+inline bool TryPartitionDenseVecKernel(const BinIdxType* idx, const int32_t offset,
+                                       common::Span<const size_t> rid_span,
+                                       const int32_t split_cond,
+                                       common::Span<size_t> left_part,
+                                       common::Span<size_t> right_part,
+                                       std::pair<size_t, size_t>* p_counts) {
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  constexpr size_t kVecWidth = 4;
+  if (!has_avx2 || rid_span.size() < 2 * kVecWidth) {
+    return false;
+  }
+  const size_t* rids = rid_span.data();
+  const size_t size = rid_span.size();
+  const size_t n_vec = size - size % kVecWidth;
+  size_t* p_left_part = left_part.data();
+  size_t* p_right_part = right_part.data();
+  size_t nleft_elems = 0;
+  size_t nright_elems = 0;
+
+  constexpr size_t kGatherBlock = 256;
+  alignas(32) int32_t bins[kGatherBlock];
+  for (size_t i = 0; i < n_vec; i += kGatherBlock) {
+    const size_t len = std::min(kGatherBlock, n_vec - i);
+    for (size_t j = 0; j < len; ++j) {
+      bins[j] = static_cast<int32_t>(idx[rids[i + j]]) + offset;
+    }
+    const auto counts = PartitionDenseCompressAvx2(rids + i, bins, len, split_cond,
+                                                   p_left_part, p_right_part,
+                                                   nleft_elems, nright_elems);
+    nleft_elems = counts.first;
+    nright_elems = counts.second;
+  }
+  for (size_t i = n_vec; i < size; ++i) {
+    const size_t rid = rids[i];
+    if ((static_cast<int32_t>(idx[rid]) + offset) <= split_cond) {
+      p_left_part[nleft_elems++] = rid;
+    } else {
+      p_right_part[nright_elems++] = rid;
+    }
+  }
+  *p_counts = {nleft_elems, nright_elems};
+  return true;
+}
+#endif  // defined(XGBOOST_PARTITION_VEC_KERNEL_PRESENT)
+
 // split row indexes (rid_span) to 2 parts (left_part, right_part) depending
 // on comparison of indexes values (idx_span) and split point (split_cond)
 // Handle dense columns
@@ -999,6 +2027,15 @@ inline std::pair<size_t, size_t> PartitionDenseKernel(const common::DenseColumn<
       }
     }
   } else {
+    // without missing values default_left is irrelevant and the split is a
+    // pure bin comparison, which admits branch-free SIMD compaction
+#if defined(XGBOOST_PARTITION_VEC_KERNEL_PRESENT)
+    std::pair<size_t, size_t> counts;
+    if (TryPartitionDenseVecKernel(idx, offset, rid_span, split_cond,
+                                   left_part, right_part, &counts)) {
+      return counts;
+    }
+#endif  // defined(XGBOOST_PARTITION_VEC_KERNEL_PRESENT)
     for (auto rid : rid_span)  {
       if ((static_cast<int32_t>(idx[rid]) + offset) <= split_cond) {
         p_left_part[nleft_elems++] = rid;
@@ -1069,11 +2106,101 @@ inline std::pair<size_t, size_t> PartitionSparseKernel(
   return {nleft_elems, nright_elems};
 }
 
+// Partition rows of a categorical many-vs-many split: the direction is a per
+// bin lookup into go_left instead of a comparison against a split point.
+// Handle dense columns.
+template <bool default_left, bool any_missing, typename BinIdxType>
+inline std::pair<size_t, size_t> PartitionDenseCatKernel(
+      const common::DenseColumn<BinIdxType>& column,
+      common::Span<const size_t> rid_span, common::Span<const uint8_t> go_left,
+      common::Span<size_t> left_part, common::Span<size_t> right_part) {
+  const BinIdxType* idx = column.GetFeatureBinIdxPtr().data();
+  size_t* p_left_part = left_part.data();
+  size_t* p_right_part = right_part.data();
+  size_t nleft_elems = 0;
+  size_t nright_elems = 0;
+
+  for (auto rid : rid_span) {
+    if (any_missing && column.IsMissing(rid)) {
+      if (default_left) {
+        p_left_part[nleft_elems++] = rid;
+      } else {
+        p_right_part[nright_elems++] = rid;
+      }
+    } else if (go_left[idx[rid]]) {
+      p_left_part[nleft_elems++] = rid;
+    } else {
+      p_right_part[nright_elems++] = rid;
+    }
+  }
+  return {nleft_elems, nright_elems};
+}
+
+// As above for sparse columns; follows the cursor walk of
+// PartitionSparseKernel.
+template <bool default_left, typename BinIdxType>
+inline std::pair<size_t, size_t> PartitionSparseCatKernel(
+  common::Span<const size_t> rid_span, common::Span<const uint8_t> go_left,
+  const common::SparseColumn<BinIdxType>& column, common::Span<size_t> left_part,
+  common::Span<size_t> right_part) {
+  size_t* p_left_part  = left_part.data();
+  size_t* p_right_part = right_part.data();
+
+  size_t nleft_elems = 0;
+  size_t nright_elems = 0;
+  const size_t* row_data = column.GetRowData();
+  const size_t column_size = column.Size();
+  const uint32_t base_idx = column.GetBaseIdx();
+  if (rid_span.size()) {  // ensure that rid_span is nonempty range
+    // search first nonzero row with index >= rid_span.front()
+    const size_t* p = std::lower_bound(row_data, row_data + column_size,
+                                       rid_span.front());
+
+    if (p != row_data + column_size && *p <= rid_span.back()) {
+      size_t cursor = p - row_data;
+
+      for (auto rid : rid_span) {
+        while (cursor < column_size
+               && column.GetRowIdx(cursor) < rid
+               && column.GetRowIdx(cursor) <= rid_span.back()) {
+          ++cursor;
+        }
+        if (cursor < column_size && column.GetRowIdx(cursor) == rid) {
+          if (go_left[column.GetGlobalBinIdx(cursor) - base_idx]) {
+            p_left_part[nleft_elems++] = rid;
+          } else {
+            p_right_part[nright_elems++] = rid;
+          }
+          ++cursor;
+        } else {
+          // missing value
+          if (default_left) {
+            p_left_part[nleft_elems++] = rid;
+          } else {
+            p_right_part[nright_elems++] = rid;
+          }
+        }
+      }
+    } else {  // all rows in rid_span have missing values
+      if (default_left) {
+        std::copy(rid_span.begin(), rid_span.end(), p_left_part);
+        nleft_elems = rid_span.size();
+      } else {
+        std::copy(rid_span.begin(), rid_span.end(), p_right_part);
+        nright_elems = rid_span.size();
+      }
+    }
+  }
+
+  return {nleft_elems, nright_elems};
+}
+
 template <typename GradientSumT>
 template <typename BinIdxType>
 void QuantileHistMaker::Builder<GradientSumT>::PartitionKernel(
     const size_t node_in_set, const size_t nid, common::Range1d range,
-    const int32_t split_cond, const ColumnMatrix& column_matrix, const RegTree& tree) {
+    const int32_t split_cond, common::Span<const uint8_t> cat_go_left,
+    const ColumnMatrix& column_matrix, const RegTree& tree) {
   const size_t* rid = row_set_collection_[nid].begin;
 
   common::Span<const size_t> rid_span(rid + range.begin(), rid + range.end());
@@ -1090,7 +2217,25 @@ void QuantileHistMaker::Builder<GradientSumT>::PartitionKernel(
   if (column_ptr->GetType() == xgboost::common::kDenseColumn) {
     const common::DenseColumn<BinIdxType>& column =
           static_cast<const common::DenseColumn<BinIdxType>& >(*(column_ptr.get()));
-    if (default_left) {
+    if (!cat_go_left.empty()) {
+      if (default_left) {
+        if (column_matrix.AnyMissing()) {
+          child_nodes_sizes = PartitionDenseCatKernel<true, true>(column, rid_span, cat_go_left,
+                                                                  left, right);
+        } else {
+          child_nodes_sizes = PartitionDenseCatKernel<true, false>(column, rid_span, cat_go_left,
+                                                                   left, right);
+        }
+      } else {
+        if (column_matrix.AnyMissing()) {
+          child_nodes_sizes = PartitionDenseCatKernel<false, true>(column, rid_span, cat_go_left,
+                                                                   left, right);
+        } else {
+          child_nodes_sizes = PartitionDenseCatKernel<false, false>(column, rid_span, cat_go_left,
+                                                                    left, right);
+        }
+      }
+    } else if (default_left) {
       if (column_matrix.AnyMissing()) {
         child_nodes_sizes = PartitionDenseKernel<true, true>(column, rid_span, split_cond,
                                                              left, right);
@@ -1110,7 +2255,15 @@ void QuantileHistMaker::Builder<GradientSumT>::PartitionKernel(
   } else {
     const common::SparseColumn<BinIdxType>& column
       = static_cast<const common::SparseColumn<BinIdxType>& >(*(column_ptr.get()));
-    if (default_left) {
+    if (!cat_go_left.empty()) {
+      if (default_left) {
+        child_nodes_sizes = PartitionSparseCatKernel<true>(rid_span, cat_go_left, column,
+                                                           left, right);
+      } else {
+        child_nodes_sizes = PartitionSparseCatKernel<false>(rid_span, cat_go_left, column,
+                                                            left, right);
+      }
+    } else if (default_left) {
       child_nodes_sizes = PartitionSparseKernel<true>(rid_span, split_cond, column, left, right);
     } else {
       child_nodes_sizes = PartitionSparseKernel<false>(rid_span, split_cond, column, left, right);
@@ -1135,6 +2288,11 @@ void QuantileHistMaker::Builder<GradientSumT>::FindSplitConditions(
 
   for (size_t i = 0; i < nodes.size(); ++i) {
     const int32_t nid = nodes[i].nid;
+    if (tree.NodeSplitType(nid) == FeatureType::kCategorical) {
+      // categorical splits are partitioned by the bitset, not a bin condition
+      (*split_conditions)[i] = -1;
+      continue;
+    }
     const bst_uint fid = tree[nid].SplitIndex();
     const bst_float split_pt = tree[nid].SplitCond();
     const uint32_t lower_bound = gmat.cut.Ptrs()[fid];
@@ -1178,11 +2336,44 @@ void QuantileHistMaker::Builder<GradientSumT>::ApplySplit(const std::vector<Expa
   const size_t n_nodes = nodes.size();
   std::vector<int32_t> split_conditions;
   FindSplitConditions(nodes, *p_tree, gmat, &split_conditions);
+  // for categorical splits, map every bin of the split feature to its
+  // direction once, so the partition kernels do a plain table lookup per row
+  std::vector<std::vector<uint8_t>> cat_go_left(n_nodes);
+  for (size_t i = 0; i < n_nodes; ++i) {
+    const int32_t nid = nodes[i].nid;
+    if (p_tree->NodeSplitType(nid) != FeatureType::kCategorical) {
+      continue;
+    }
+    const bst_uint fid = (*p_tree)[nid].SplitIndex();
+    const auto cats = p_tree->NodeCats(nid);
+    const uint32_t ibegin = gmat.cut.Ptrs()[fid];
+    const uint32_t iend = gmat.cut.Ptrs()[fid + 1];
+    cat_go_left[i].resize(iend - ibegin);
+    for (uint32_t j = ibegin; j < iend; ++j) {
+      cat_go_left[i][j - ibegin] =
+          common::Decision(cats, common::AsCat(gmat.cut.Values()[j]));
+    }
+  }
   // 2.1 Create a blocked space of size SUM(samples in each node)
   common::BlockedSpace2d space(n_nodes, [&](size_t node_in_set) {
     int32_t nid = nodes[node_in_set].nid;
     return row_set_collection_[nid].Size();
   }, kPartitionBlockSize);
+  static const size_t kPartitionRowsSlot =
+      common::ProfileRegistry::Instance().Register("partition_rows");
+  static const size_t kPartitionTicksSlot =
+      common::ProfileRegistry::Instance().Register("partition_ticks");
+  size_t partitioned_rows = 0;
+  for (size_t node_in_set = 0; node_in_set < n_nodes; ++node_in_set) {
+    partitioned_rows += row_set_collection_[nodes[node_in_set].nid].Size();
+  }
+  common::ProfileRegistry::Instance().Add(kPartitionRowsSlot, partitioned_rows);
+  common::ProfileTimer partition_timer{kPartitionTicksSlot};
+  // partitioning runs at its own calibrated thread budget; tasks are indexed
+  // by block, not by thread, so the count only affects scheduling
+  partition_budget_.SetMaxThreads(this->nthread_);
+  const int32_t n_partition_threads = partition_budget_.Threads(partitioned_rows);
+  common::Timer budget_timer;
   // 2.2 Initialize the partition builder
   // allocate buffers for storage intermediate results by each thread
   partition_builder_.Init(space.Size(), n_nodes, [&](size_t node_in_set) {
@@ -1193,23 +2384,25 @@ void QuantileHistMaker::Builder<GradientSumT>::ApplySplit(const std::vector<Expa
   });
   // 2.3 Split elements of row_set_collection_ to left and right child-nodes for each node
   // Store results in intermediate buffers from partition_builder_
-  common::ParallelFor2d(space, this->nthread_, [&](size_t node_in_set, common::Range1d r) {
+  common::ParallelFor2d(space, n_partition_threads, [&](size_t node_in_set, common::Range1d r) {
     size_t begin = r.begin();
     const int32_t nid = nodes[node_in_set].nid;
     const size_t task_id = partition_builder_.GetTaskIdx(node_in_set, begin);
     partition_builder_.AllocateForTask(task_id);
+      const common::Span<const uint8_t> node_cat_go_left{
+          cat_go_left[node_in_set].data(), cat_go_left[node_in_set].size()};
       switch (column_matrix.GetTypeSize()) {
       case common::kUint8BinsTypeSize:
         PartitionKernel<uint8_t>(node_in_set, nid, r,
-                  split_conditions[node_in_set], column_matrix, *p_tree);
+                  split_conditions[node_in_set], node_cat_go_left, column_matrix, *p_tree);
         break;
       case common::kUint16BinsTypeSize:
         PartitionKernel<uint16_t>(node_in_set, nid, r,
-                  split_conditions[node_in_set], column_matrix, *p_tree);
+                  split_conditions[node_in_set], node_cat_go_left, column_matrix, *p_tree);
         break;
       case common::kUint32BinsTypeSize:
         PartitionKernel<uint32_t>(node_in_set, nid, r,
-                  split_conditions[node_in_set], column_matrix, *p_tree);
+                  split_conditions[node_in_set], node_cat_go_left, column_matrix, *p_tree);
         break;
       default:
         CHECK(false);  // no default behavior
@@ -1221,11 +2414,13 @@ void QuantileHistMaker::Builder<GradientSumT>::ApplySplit(const std::vector<Expa
 
   // 4. Copy elements from partition_builder_ to row_set_collection_ back
   // with updated row-indexes for each tree-node
-  common::ParallelFor2d(space, this->nthread_, [&](size_t node_in_set, common::Range1d r) {
+  common::ParallelFor2d(space, n_partition_threads, [&](size_t node_in_set, common::Range1d r) {
     const int32_t nid = nodes[node_in_set].nid;
     partition_builder_.MergeToArray(node_in_set, r.begin(),
         const_cast<size_t*>(row_set_collection_[nid].begin));
   });
+  budget_timer.Stop();
+  partition_budget_.Observe(partitioned_rows, budget_timer.ElapsedSeconds());
   // 5. Add info about splits into row_set_collection_
   AddSplitsToRowSet(nodes, p_tree);
   builder_monitor_.Stop("ApplySplit");
@@ -1255,13 +2450,17 @@ void QuantileHistMaker::Builder<GradientSumT>::InitNewNode(int nid,
           const GradientPairT et = begin[i];
           grad_stat.Add(et.GetGrad(), et.GetHess());
         }
+        // the root histogram was already reduced across workers together with
+        // the rest of the frontier in SyncHistograms, so the sums above are
+        // global totals and no extra collective is needed. InitData agreed
+        // the layout across workers, so everyone takes the same branch here.
       } else {
         const RowSetCollection::Elem e = row_set_collection_[nid];
         for (const size_t* it = e.begin; it < e.end; ++it) {
           grad_stat.Add(gpair[*it].GetGrad(), gpair[*it].GetHess());
         }
+        histred_.Allreduce(&grad_stat, 1);
       }
-      histred_.Allreduce(&grad_stat, 1);
       snode_[nid].stats = tree::GradStats(grad_stat.GetGrad(), grad_stat.GetHess());
     } else {
       int parent_id = tree[nid].Parent();
@@ -1285,17 +2484,68 @@ void QuantileHistMaker::Builder<GradientSumT>::InitNewNode(int nid,
   builder_monitor_.Stop("InitNewNode");
 }
 
+// Upper-bound the gain any split of feature fid can reach.  One enumerated
+// side accumulates a subset of the feature's bins, so its gradient sum lies
+// between the summed negative and the summed positive gradients of those
+// bins; the other side is the parent minus that subset.  A valid side also
+// carries at least min_child_weight hessian, so each side's term
+// G^2 / (H + lambda) is capped by its largest reachable |G| squared over
+// (min_child_weight + lambda).  L1 shrinkage, max_delta_step clipping and
+// monotone bounds only lower the realized gain further, which keeps the cap
+// sound for both the numeric and the categorical enumeration.
+template <typename GradientSumT>
+bool QuantileHistMaker::Builder<GradientSumT>::FeatureCanImproveSplit(
+    const GHistRowT &hist, const NodeEntry &snode, bst_uint fid,
+    const GHistIndexMatrix &gmat, bst_float best_loss_chg) const {
+  const double denominator = static_cast<double>(param_.reg_lambda) +
+                             static_cast<double>(param_.min_child_weight);
+  if (denominator <= 0.0) {
+    return true;  // no floor on the hessian side, the cap is unbounded
+  }
+  const std::vector<uint32_t>& cut_ptr = gmat.cut.Ptrs();
+  double grad_pos = 0.0;
+  double grad_neg = 0.0;
+  for (uint32_t i = cut_ptr[fid]; i < cut_ptr[fid + 1]; ++i) {
+    const double grad = hist[i].GetGrad();
+    if (grad > 0.0) {
+      grad_pos += grad;
+    } else {
+      grad_neg += grad;
+    }
+  }
+  const double parent_grad = snode.stats.GetGrad();
+  const double bin_side = std::max(grad_pos, -grad_neg);
+  const double rest_side = std::max(std::abs(parent_grad - grad_pos),
+                                    std::abs(parent_grad - grad_neg));
+  const double gain_cap =
+      (bin_side * bin_side + rest_side * rest_side) / denominator;
+  return gain_cap - snode.root_gain > best_loss_chg;
+}
+
 // Enumerate the split values of specific feature.
 // Returns the sum of gradients corresponding to the data points that contains a non-missing value
 // for the particular feature fid.
 template <typename GradientSumT>
-template <int d_step>
+template <int d_step, bool any_constraint>
 GradStats QuantileHistMaker::Builder<GradientSumT>::EnumerateSplit(
     const GHistIndexMatrix &gmat, const GHistRowT &hist, const NodeEntry &snode,
     SplitEntry *p_best, bst_uint fid, bst_uint nodeID,
     TreeEvaluator::SplitEvaluator<TrainParam> const &evaluator) const {
   CHECK(d_step == +1 || d_step == -1);
 
+  // The monotone direction of the feature and the weight bounds of the node
+  // are invariant over the bins enumerated below; load them once here.  The
+  // unconstrained instantiation skips the loads and propagates the constants
+  // into the gain computation, so it carries no constraint code in the loop.
+  int constraint = 0;
+  float lower_bound = -std::numeric_limits<float>::max();
+  float upper_bound = std::numeric_limits<float>::max();
+  if (any_constraint) {
+    constraint = evaluator.constraints[fid];
+    lower_bound = evaluator.lower[nodeID];
+    upper_bound = evaluator.upper[nodeID];
+  }
+
   // aliases
   const std::vector<uint32_t>& cut_ptr = gmat.cut.Ptrs();
   const std::vector<bst_float>& cut_val = gmat.cut.Values();
@@ -1337,16 +2587,18 @@ GradStats QuantileHistMaker::Builder<GradientSumT>::EnumerateSplit(
         if (d_step > 0) {
           // forward enumeration: split at right bound of each bin
           loss_chg = static_cast<bst_float>(
-              evaluator.CalcSplitGain(param_, nodeID, fid, GradStats{e},
-                                      GradStats{c}) -
+              evaluator.CalcSplitGainGivenBounds<any_constraint>(
+                  param_, constraint, lower_bound, upper_bound, GradStats{e},
+                  GradStats{c}) -
               snode.root_gain);
           split_pt = cut_val[i];
           best.Update(loss_chg, fid, split_pt, d_step == -1, e, c);
         } else {
           // backward enumeration: split at left bound of each bin
           loss_chg = static_cast<bst_float>(
-              evaluator.CalcSplitGain(param_, nodeID, fid, GradStats{c},
-                                      GradStats{e}) -
+              evaluator.CalcSplitGainGivenBounds<any_constraint>(
+                  param_, constraint, lower_bound, upper_bound, GradStats{c},
+                  GradStats{e}) -
               snode.root_gain);
           if (i == imin) {
             // for leftmost bin, left bound is the smallest feature value
@@ -1364,26 +2616,139 @@ GradStats QuantileHistMaker::Builder<GradientSumT>::EnumerateSplit(
   return e;
 }
 
+// Enumerate many-vs-many splits of a categorical feature.  Each bin of the
+// feature holds one category; ordering the bins by their gradient ratio and
+// scanning that order like a numeric feature finds the optimal partition of
+// the categories for the squared-error objective, the same argument LightGBM
+// uses.  The scan runs twice so missing values can land on either side, and
+// the winning partition is attached to the split entry as a bitset over
+// category values.
+template <typename GradientSumT>
+template <bool any_constraint>
+void QuantileHistMaker::Builder<GradientSumT>::EnumerateCategoricalSplit(
+    const GHistIndexMatrix &gmat, const GHistRowT &hist, const NodeEntry &snode,
+    SplitEntry *p_best, bst_uint fid, bst_uint nodeID,
+    TreeEvaluator::SplitEvaluator<TrainParam> const &evaluator) const {
+  int constraint = 0;
+  float lower_bound = -std::numeric_limits<float>::max();
+  float upper_bound = std::numeric_limits<float>::max();
+  if (any_constraint) {
+    constraint = evaluator.constraints[fid];
+    lower_bound = evaluator.lower[nodeID];
+    upper_bound = evaluator.upper[nodeID];
+  }
+
+  const std::vector<uint32_t>& cut_ptr = gmat.cut.Ptrs();
+  const std::vector<bst_float>& cut_val = gmat.cut.Values();
+  const uint32_t ibegin = cut_ptr[fid];
+  const uint32_t iend = cut_ptr[fid + 1];
+  const uint32_t n_bins = iend - ibegin;
+  if (n_bins < 2) {
+    return;
+  }
+
+  // scan order: category bins sorted by their gradient ratio
+  std::vector<uint32_t> order(n_bins);
+  std::iota(order.begin(), order.end(), ibegin);
+  std::sort(order.begin(), order.end(), [&hist](uint32_t l, uint32_t r) {
+    return hist[l].GetGrad() / (hist[l].GetHess() + kRtEps) <
+           hist[r].GetGrad() / (hist[r].GetHess() + kRtEps);
+  });
+
+  bst_cat_t max_cat = 0;
+  for (uint32_t i = ibegin; i < iend; ++i) {
+    const bst_cat_t cat = common::AsCat(cut_val[i]);
+    CHECK_GE(cat, 0) << "Invalid category value for feature " << fid;
+    max_cat = std::max(max_cat, cat);
+  }
+  const size_t n_words =
+      common::CatBitField::ComputeStorageSize(static_cast<size_t>(max_cat) + 1);
+  std::vector<uint32_t> bits_storage(n_words, 0);
+  common::CatBitField bits({bits_storage.data(), bits_storage.size()});
+  const bst_float nan_value = std::numeric_limits<bst_float>::quiet_NaN();
+  SplitEntry best;
+
+  // first pass: the scanned prefix goes left and missing values right.  The
+  // bitset starts with every observed category on the right; a category
+  // moves left when the scan adds its bin to the prefix.
+  for (uint32_t i = ibegin; i < iend; ++i) {
+    bits.Set(common::AsCat(cut_val[i]));
+  }
+  GradStats e;
+  GradStats c;
+  for (uint32_t k = 0; k < n_bins; ++k) {
+    const uint32_t i = order[k];
+    bits.Clear(common::AsCat(cut_val[i]));
+    e.Add(hist[i].GetGrad(), hist[i].GetHess());
+    if (e.GetHess() >= param_.min_child_weight) {
+      c.SetSubstract(snode.stats, e);
+      if (c.GetHess() >= param_.min_child_weight) {
+        const auto loss_chg = static_cast<bst_float>(
+            evaluator.CalcSplitGainGivenBounds<any_constraint>(
+                param_, constraint, lower_bound, upper_bound, GradStats{e},
+                GradStats{c}) -
+            snode.root_gain);
+        if (best.Update(loss_chg, fid, nan_value, false, e, c)) {
+          best.is_cat = true;
+          best.cat_bits = bits_storage;
+        }
+      }
+    }
+  }
+
+  // second pass: the scanned prefix goes right, taking the bitset with it,
+  // and missing values left
+  std::fill(bits_storage.begin(), bits_storage.end(), 0);
+  e = GradStats();
+  for (uint32_t k = 0; k < n_bins; ++k) {
+    const uint32_t i = order[k];
+    bits.Set(common::AsCat(cut_val[i]));
+    e.Add(hist[i].GetGrad(), hist[i].GetHess());
+    if (e.GetHess() >= param_.min_child_weight) {
+      c.SetSubstract(snode.stats, e);
+      if (c.GetHess() >= param_.min_child_weight) {
+        const auto loss_chg = static_cast<bst_float>(
+            evaluator.CalcSplitGainGivenBounds<any_constraint>(
+                param_, constraint, lower_bound, upper_bound, GradStats{c},
+                GradStats{e}) -
+            snode.root_gain);
+        if (best.Update(loss_chg, fid, nan_value, true, c, e)) {
+          best.is_cat = true;
+          best.cat_bits = bits_storage;
+        }
+      }
+    }
+  }
+
+  p_best->Update(best);
+}
+
 template struct QuantileHistMaker::Builder<float>;
 template struct QuantileHistMaker::Builder<double>;
 template void QuantileHistMaker::Builder<float>::PartitionKernel<uint8_t>(
     const size_t node_in_set, const size_t nid, common::Range1d range,
-    const int32_t split_cond, const ColumnMatrix& column_matrix, const RegTree& tree);
+    const int32_t split_cond, common::Span<const uint8_t> cat_go_left,
+    const ColumnMatrix& column_matrix, const RegTree& tree);
 template void QuantileHistMaker::Builder<float>::PartitionKernel<uint16_t>(
     const size_t node_in_set, const size_t nid, common::Range1d range,
-    const int32_t split_cond, const ColumnMatrix& column_matrix, const RegTree& tree);
+    const int32_t split_cond, common::Span<const uint8_t> cat_go_left,
+    const ColumnMatrix& column_matrix, const RegTree& tree);
 template void QuantileHistMaker::Builder<float>::PartitionKernel<uint32_t>(
     const size_t node_in_set, const size_t nid, common::Range1d range,
-    const int32_t split_cond, const ColumnMatrix& column_matrix, const RegTree& tree);
+    const int32_t split_cond, common::Span<const uint8_t> cat_go_left,
+    const ColumnMatrix& column_matrix, const RegTree& tree);
 template void QuantileHistMaker::Builder<double>::PartitionKernel<uint8_t>(
     const size_t node_in_set, const size_t nid, common::Range1d range,
-    const int32_t split_cond, const ColumnMatrix& column_matrix, const RegTree& tree);
+    const int32_t split_cond, common::Span<const uint8_t> cat_go_left,
+    const ColumnMatrix& column_matrix, const RegTree& tree);
 template void QuantileHistMaker::Builder<double>::PartitionKernel<uint16_t>(
     const size_t node_in_set, const size_t nid, common::Range1d range,
-    const int32_t split_cond, const ColumnMatrix& column_matrix, const RegTree& tree);
+    const int32_t split_cond, common::Span<const uint8_t> cat_go_left,
+    const ColumnMatrix& column_matrix, const RegTree& tree);
 template void QuantileHistMaker::Builder<double>::PartitionKernel<uint32_t>(
     const size_t node_in_set, const size_t nid, common::Range1d range,
-    const int32_t split_cond, const ColumnMatrix& column_matrix, const RegTree& tree);
+    const int32_t split_cond, common::Span<const uint8_t> cat_go_left,
+    const ColumnMatrix& column_matrix, const RegTree& tree);
 
 XGBOOST_REGISTER_TREE_UPDATER(FastHistMaker, "grow_fast_histmaker")
 .describe("(Deprecated, use grow_quantile_histmaker instead.)"
@@ -11,6 +11,7 @@
 #include <rabit/rabit.h>
 #include <xgboost/tree_updater.h>
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <string>
@@ -29,6 +30,7 @@
 #include "../common/hist_util.h"
 #include "../common/row_set.h"
 #include "../common/column_matrix.h"
+#include "../common/threadpool.h"
 
 namespace xgboost {
 
@@ -96,14 +98,87 @@ class BatchHistRowsAdder;
 template <typename GradientSumT>
 class DistributedHistRowsAdder;
 
+/*!
+ * \brief Quantized index and column layout built from one DMatrix.
+ *
+ * Once built the pair is only ever read, so updater instances with identical
+ * quantization parameters - across booster instances of a sweep over the same
+ * data - can hold one copy through a shared pointer instead of re-quantizing.
+ */
+struct QuantizedIndex {
+  GHistIndexMatrix gmat;
+  ColumnMatrix columns;
+};
+
 // training parameters specific to this algorithm
 struct CPUHistMakerTrainParam
     : public XGBoostParameter<CPUHistMakerTrainParam> {
   bool single_precision_histogram = false;
+  bool numa_aware = false;
+  bool quantized_gradients = false;
+  bool compressed_histogram_sync = false;
+  bool quantized_histogram_sync = false;
+  bool sampled_histogram_sync = false;
+  bool tree_reduce_histogram = false;
+  size_t max_histogram_buffer_mb = 0;
+  size_t lossguide_expand_batch = 1;
+  bool shared_quantized_index = false;
+  size_t cut_refresh_period = 0;
   // declare parameters
   DMLC_DECLARE_PARAMETER(CPUHistMakerTrainParam) {
     DMLC_DECLARE_FIELD(single_precision_histogram).set_default(false).describe(
         "Use single precision to build histograms.");
+    DMLC_DECLARE_FIELD(compressed_histogram_sync).set_default(false).describe(
+        "Reduce histograms across workers in single precision, halving the "
+        "bytes on the wire; local histograms keep full precision.");
+    DMLC_DECLARE_FIELD(quantized_histogram_sync).set_default(false).describe(
+        "Reduce histograms across workers as int16 pairs under one globally "
+        "agreed scale, quartering the bytes on the wire at the cost of a "
+        "bounded quantization error.  Meant for deployments where the "
+        "slowest link, not accuracy, limits scaling; takes precedence over "
+        "compressed_histogram_sync.");
+    DMLC_DECLARE_FIELD(sampled_histogram_sync).set_default(false).describe(
+        "Reduce only the histogram bins of the features sampled for the "
+        "current tree across workers, so with colsample_bytree the sync "
+        "payload scales with the sample instead of the full feature count. "
+        "Requires colsample_bylevel and colsample_bynode at 1 and no "
+        "histogram reuse; otherwise the full reduction is kept.");
+    DMLC_DECLARE_FIELD(quantized_gradients).set_default(false).describe(
+        "Rescale per-iteration gradients to int16 pairs with a shared "
+        "exponent, halving gradient memory traffic when building histograms.");
+    DMLC_DECLARE_FIELD(tree_reduce_histogram).set_default(false).describe(
+        "Merge per-thread histogram copies with a pairwise tree reduction "
+        "instead of a sequential fold, improving reduction scaling at high "
+        "thread counts while staying deterministic.");
+    DMLC_DECLARE_FIELD(lossguide_expand_batch).set_lower_bound(1).set_default(1).describe(
+        "Number of frontier leaves grow_policy=lossguide expands per step. "
+        "The top entries of the priority queue are split together, so their "
+        "row partitions, child histograms and split evaluations run as one "
+        "parallel batch instead of one node at a time.  When max_leaves is "
+        "exhausted inside a batch, the weakest speculative splits are rolled "
+        "back in favour of higher-gain children, keeping the chosen leaves "
+        "close to the serial order.  1 reproduces the serial expansion "
+        "exactly.");
+    DMLC_DECLARE_FIELD(max_histogram_buffer_mb).set_lower_bound(0).set_default(0).describe(
+        "Budget in megabytes for per-thread histogram scratch.  When the "
+        "work-stealing layout (one copy per thread and node) would exceed it, "
+        "histograms are built with the static thread-to-node assignment, "
+        "where small nodes are built by a single thread directly into the "
+        "output histogram.  0 means no budget.");
+    DMLC_DECLARE_FIELD(shared_quantized_index).set_default(false).describe(
+        "Share the quantized index of a DMatrix across booster instances with "
+        "identical max_bin and sparse_threshold, so sweeps over the same data "
+        "quantize it once instead of once per booster.  The shared index is "
+        "read-only and freed once the last user releases it.");
+    DMLC_DECLARE_FIELD(cut_refresh_period).set_lower_bound(0).set_default(0).describe(
+        "Rebuild the quantile cuts every this many boosting iterations using "
+        "hessian-weighted sketches, recovering the weighted per-iteration "
+        "proposals of the approx updater inside the hist framework.  0 keeps "
+        "the cuts fixed for the whole training session.");
+    DMLC_DECLARE_FIELD(numa_aware).set_default(false).describe(
+        "Pin worker threads to NUMA nodes so that per-thread histogram "
+        "buffers and row partitions stay on local memory; histograms are "
+        "merged across sockets only at reduction time.");
   }
 };
 
@@ -171,14 +246,17 @@ class QuantileHistMaker: public TreeUpdater {
   CPUHistMakerTrainParam hist_maker_param_;
   // training parameter
   TrainParam param_;
-  // quantized data matrix
-  GHistIndexMatrix gmat_;
+  // quantized data matrix and column accessor, possibly shared across
+  // updater instances (see shared_quantized_index)
+  std::shared_ptr<QuantizedIndex> qindex_;
   // (optional) data matrix with feature grouping
   GHistIndexBlockMatrix gmatb_;
-  // column accessor
-  ColumnMatrix column_matrix_;
   DMatrix const* p_last_dmat_ {nullptr};
-  bool is_gmat_initialized_ {false};
+  // number of Update calls served from the current quantized index, used to
+  // schedule hessian-weighted cut refreshes (see cut_refresh_period)
+  size_t n_updates_ {0};
+  // whether worker threads were already pinned to NUMA nodes (numa_aware mode)
+  bool omp_threads_bound_ {false};
 
   // data structure
   struct NodeEntry {
@@ -228,12 +306,68 @@ class QuantileHistMaker: public TreeUpdater {
                           GHistRowT hist) {
       if (param_.enable_feature_grouping > 0) {
         hist_builder_.BuildBlockHist(gpair, row_indices, gmatb, hist);
+      } else if (use_quantized_gradients_) {
+        hist_builder_.BuildHistQuantized(qgrads_, row_indices, gmat, hist,
+                                         data_layout_ != DataLayout::kSparseData);
       } else {
         hist_builder_.BuildHist(gpair, row_indices, gmat, hist,
                                 data_layout_ != DataLayout::kSparseData);
       }
     }
 
+    void SetUseQuantizedGradients(bool use) {
+      use_quantized_gradients_ = use;
+    }
+
+    void SetCompressedHistSync(bool use) {
+      compressed_hist_sync_ = use;
+    }
+
+    void SetQuantizedHistSync(bool use) {
+      quantized_hist_sync_ = use;
+    }
+
+    void SetSampledHistSync(bool use) {
+      sampled_hist_sync_ = use;
+    }
+
+    void SetTreeReduceHist(bool use) {
+      tree_reduce_hist_ = use;
+    }
+
+    void SetHistBufferBudget(size_t bytes) {
+      max_hist_buffer_bytes_ = bytes;
+    }
+
+    void SetLossGuideExpandBatch(size_t n) {
+      lossguide_expand_batch_ = n == 0 ? 1 : n;
+    }
+
+    /*!
+     * \brief Reduce the frontier's histograms across workers in single
+     *        precision, halving the sync payload.  Local histograms keep
+     *        full precision; only the wire representation is compressed.
+     */
+    void CompressedAllreduceHist(int starting_index, int sync_count);
+
+    /*!
+     * \brief Reduce the frontier's histograms across workers as int16 pairs
+     *        under one globally agreed scale.  A max-allreduce fixes the
+     *        scale with enough headroom that the integer sums cannot
+     *        overflow, so the only loss is the quantization itself.
+     */
+    void QuantizedAllreduceHist(int starting_index, int sync_count);
+
+    /*!
+     * \brief Reduce only the bins of the given features across workers.
+     *        Features outside the per-tree sample are never evaluated, so
+     *        their bins can stay worker-local and the payload scales with
+     *        the sample.  The bins of fid_least_bins_ are always included
+     *        because the root node sums them for its gradient statistics.
+     */
+    void SampledAllreduceHist(int starting_index, int sync_count,
+                              const std::vector<bst_feature_t>& features);
+
     inline void SubtractionTrick(GHistRowT self,
                                  GHistRowT sibling,
                                  GHistRowT parent) {
@@ -246,6 +380,23 @@ class QuantileHistMaker: public TreeUpdater {
                                HostDeviceVector<bst_float>* p_out_preds);
     void SetHistSynchronizer(HistSynchronizer<GradientSumT>* sync);
     void SetHistRowsAdder(HistRowsAdder<GradientSumT>* adder);
+    /*!
+     * \brief Let the next Update() serve the node histograms of the previous
+     *  tree from the cache instead of rebuilding them.  Only valid when the
+     *  partitions are identical, i.e. the trees of one boosting round are
+     *  built without row or column sampling.
+     */
+    void SetReuseHistograms(bool reuse) { reuse_histograms_ = reuse; }
+    /*!
+     * \brief Memoize per-(node, feature) split results so the repeated
+     *  evaluations of reused histograms become lookups.  Storage is dropped
+     *  on every toggle so entries never outlive the round's gradients.
+     */
+    void SetCacheSplitResults(bool cache) {
+      cache_split_results_ = cache;
+      split_result_cache_.clear();
+      split_result_valid_.clear();
+    }
 
    protected:
     friend class HistSynchronizer<GradientSumT>;
@@ -286,20 +437,51 @@ class QuantileHistMaker: public TreeUpdater {
     void InitSampling(const std::vector<GradientPair>& gpair,
                       const DMatrix& fmat, std::vector<size_t>* row_indices);
 
+    /*!
+     * \brief Gradient-based sampling: rows are kept with probability
+     *  proportional to their combined gradient and the pairs of the sampled
+     *  rows are rescaled by the inverse probability, mirroring the GPU
+     *  GradientBasedSampler.  Mutates the gradient pairs, so the builder
+     *  works on its own copy when this path is taken.
+     */
+    void InitSamplingGradientBased(std::vector<GradientPair>* p_gpair,
+                                   const DMatrix& fmat,
+                                   std::vector<size_t>* row_indices);
+
+    /*!
+     * \brief Label-stratified sampling: the subsample fraction of every
+     *  label class is kept exactly, so the class balance of the sample
+     *  matches the training data instead of only in expectation.
+     */
+    void InitSamplingStratified(const std::vector<GradientPair>& gpair,
+                                const DMatrix& fmat,
+                                std::vector<size_t>* row_indices);
+
+    // whether the histograms of all nodes scheduled for the current build
+    // step are already cached from the previous identical tree
+    bool ReusableHistograms() const;
+
     void EvaluateSplits(const std::vector<ExpandEntry>& nodes_set,
                         const GHistIndexMatrix& gmat,
                         const HistCollection<GradientSumT>& hist,
                         const RegTree& tree);
 
+    // Agree on the winning split of every node of the frontier across
+    // workers in one batched typed collective; a no-op under a single worker.
+    void SyncBestSplits(const std::vector<ExpandEntry>& nodes_set);
+
     void ApplySplit(std::vector<ExpandEntry> nodes,
                         const GHistIndexMatrix& gmat,
                         const ColumnMatrix& column_matrix,
                         const HistCollection<GradientSumT>& hist,
                         RegTree* p_tree);
 
+    // cat_go_left is empty for numeric splits; for a categorical split it
+    // maps every bin of the split feature to its direction
     template <typename BinIdxType>
     void PartitionKernel(const size_t node_in_set, const size_t nid, common::Range1d range,
                          const int32_t split_cond,
+                         common::Span<const uint8_t> cat_go_left,
                          const ColumnMatrix& column_matrix, const RegTree& tree);
 
     void AddSplitsToRowSet(const std::vector<ExpandEntry>& nodes, RegTree* p_tree);
@@ -314,16 +496,43 @@ class QuantileHistMaker: public TreeUpdater {
                      const DMatrix& fmat,
                      const RegTree& tree);
 
+    // Cheap per-feature precheck run before the per-bin enumeration: caps
+    // the gain any split of the feature can reach from its histogram
+    // gradient sums and the parent statistics, so hopeless features are
+    // skipped without scanning their bins against the evaluator.
+    bool FeatureCanImproveSplit(const GHistRowT &hist, const NodeEntry &snode,
+                                bst_uint fid, const GHistIndexMatrix &gmat,
+                                bst_float best_loss_chg) const;
+
     // Enumerate the split values of specific feature
     // Returns the sum of gradients corresponding to the data points that contains a non-missing
     // value for the particular feature fid.
-    template <int d_step>
+    // `any_constraint` selects the instantiation with monotone-constraint
+    // handling; the false instantiation keeps the per-bin loop free of any
+    // constraint loads or branches.
+    template <int d_step, bool any_constraint>
     GradStats EnumerateSplit(
         const GHistIndexMatrix &gmat, const GHistRowT &hist,
         const NodeEntry &snode, SplitEntry *p_best, bst_uint fid,
         bst_uint nodeID,
         TreeEvaluator::SplitEvaluator<TrainParam> const &evaluator) const;
 
+    // Enumerate many-vs-many splits of a categorical feature: the category
+    // bins are ordered by their gradient ratio and the order is scanned like
+    // a numeric feature, once with missing values on either side.  The
+    // chosen set is stored with the split as a bitset over category values.
+    template <bool any_constraint>
+    void EnumerateCategoricalSplit(
+        const GHistIndexMatrix &gmat, const GHistRowT &hist,
+        const NodeEntry &snode, SplitEntry *p_best, bst_uint fid,
+        bst_uint nodeID,
+        TreeEvaluator::SplitEvaluator<TrainParam> const &evaluator) const;
+
+    // commit the best split of nid to the tree, routing to ExpandNode or
+    // ExpandCategorical depending on the split type
+    void ApplyTreeSplit(int nid, RegTree* p_tree,
+                        TreeEvaluator::SplitEvaluator<TrainParam> const& evaluator);
+
     // if sum of statistics for non-missing values in the node
     // is equal to sum of statistics for all values:
     // then - there are no missing values
@@ -342,6 +551,12 @@ class QuantileHistMaker: public TreeUpdater {
                               RegTree *p_tree,
                               const std::vector<GradientPair> &gpair_h);
 
+    // column-parallel build for dense tall-thin frontiers, see
+    // BuildLocalHistograms; writes directly into hist_ with no merge phase
+    void BuildHistogramsByColumns(const GHistIndexMatrix &gmat,
+                                  const std::vector<GradientPair> &gpair_h,
+                                  size_t n_nodes);
+
     void BuildHistogramsLossGuide(
                         ExpandEntry entry,
                         const GHistIndexMatrix &gmat,
@@ -390,6 +605,24 @@ class QuantileHistMaker: public TreeUpdater {
                              RegTree* p_tree,
                              const std::vector<GradientPair>& gpair_h);
 
+    /*!
+     * \brief When a speculative batch exhausts max_leaves, a child evaluated
+     *  in the batch may out-gain a weaker member that was expanded before
+     *  the child existed; the serial loop would have expanded the child
+     *  instead.  Roll such members back to leaves and hand their leaf budget
+     *  to the children, weakest member first.
+     */
+    void RollBackSpeculativeLosers(std::vector<ExpandEntry>* p_batch,
+                                   const std::vector<ExpandEntry>& child_nodes,
+                                   const GHistIndexMatrix& gmat,
+                                   const GHistIndexBlockMatrix& gmatb,
+                                   const ColumnMatrix& column_matrix,
+                                   DMatrix* p_fmat,
+                                   RegTree* p_tree,
+                                   int* num_leaves,
+                                   unsigned* timestamp,
+                                   const std::vector<GradientPair>& gpair_h);
+
     inline static bool LossGuide(ExpandEntry lhs, ExpandEntry rhs) {
       if (lhs.loss_chg == rhs.loss_chg) {
         return lhs.timestamp > rhs.timestamp;  // favor small timestamp
@@ -397,11 +630,31 @@ class QuantileHistMaker: public TreeUpdater {
         return lhs.loss_chg < rhs.loss_chg;  // favor large loss_chg
       }
     }
+    // persistent work-stealing pool shared by histogram building and split
+    // evaluation; kept alive across Update() calls to avoid the fork/join
+    // cost of opening an OpenMP region per processed node
+    common::WorkStealingThreadPool& WorkPool() {
+      if (!work_pool_ || work_pool_->NumWorkers() != static_cast<size_t>(nthread_)) {
+        work_pool_.reset(new common::WorkStealingThreadPool(nthread_));
+      }
+      return *work_pool_;
+    }
+
     //  --data fields--
     const TrainParam& param_;
     // number of omp thread used during training
     int nthread_;
+    std::unique_ptr<common::WorkStealingThreadPool> work_pool_;
+    // per-phase thread budgets, calibrated on the first frontiers; histogram
+    // building saturates memory bandwidth before the pool is exhausted while
+    // partitioning usually wants every thread, so each phase settles on its
+    // own count
+    common::PhaseThreadBudget hist_build_budget_ {2048};
+    common::PhaseThreadBudget partition_budget_ {2048};
     common::ColumnSampler column_sampler_;
+    /*! \brief feature types of the training matrix; empty when no feature is
+               marked categorical */
+    std::vector<FeatureType> feature_types_;
     // the internal row sets
     RowSetCollection row_set_collection_;
     // the temp space for split
@@ -421,6 +674,22 @@ class QuantileHistMaker: public TreeUpdater {
     std::vector<float> leaf_value_cache_;
 
     GHistBuilder<GradientSumT> hist_builder_;
+    // local copy of the gradient pairs, used when gradient-based sampling
+    // rescales the pairs of the sampled rows
+    std::vector<GradientPair> gpair_local_;
+    // serve the node histograms of the previous identical tree from the
+    // cache, see SetReuseHistograms()
+    bool reuse_histograms_ {false};
+    // memoize split results across the identical trees of one round, see
+    // SetCacheSplitResults(); indexed [nid][fid], a valid byte marks entries
+    // backed by an unchanged histogram
+    bool cache_split_results_ {false};
+    std::vector<std::vector<SplitEntry>> split_result_cache_;
+    std::vector<std::vector<uint8_t>> split_result_valid_;
+    // int16 gradient pairs, recomputed per iteration when
+    // quantized_gradients mode is enabled
+    bool use_quantized_gradients_ {false};
+    common::QuantizedGradients qgrads_;
     std::unique_ptr<TreeUpdater> pruner_;
     FeatureInteractionConstraintHost interaction_constraints_;
 
@@ -449,6 +718,67 @@ class QuantileHistMaker: public TreeUpdater {
     common::Monitor builder_monitor_;
     common::ParallelGHistBuilder<GradientSumT> hist_buffer_;
     rabit::Reducer<GradientPairT, GradientPairT::Reduce> histred_;
+    // single precision reduction path, see CompressedAllreduceHist
+    bool compressed_hist_sync_ {false};
+    // pairwise tree merge of per-thread histogram copies, see
+    // ParallelGHistBuilder::ReduceHistTree
+    bool tree_reduce_hist_ {false};
+    // cap on histogram scratch memory, see BuildLocalHistograms; 0 = no cap
+    size_t max_hist_buffer_bytes_ {0};
+    // number of frontier leaves ExpandWithLossGuide splits per step
+    size_t lossguide_expand_batch_ {1};
+    // set when the last frontier was built column-parallel straight into
+    // hist_, so the synchronizers must not reduce the (unused) buffer
+    bool hist_built_directly_ {false};
+    using GradientPairF = xgboost::detail::GradientPairInternal<float>;
+    rabit::Reducer<GradientPairF, GradientPairF::Reduce> histred_fp32_;
+    std::vector<GradientPairF> compressed_hist_buffer_;
+    // int16 wire representation, see QuantizedAllreduceHist
+    struct QuantizedHistEntry {
+      int16_t grad;
+      int16_t hess;
+      static void Reduce(QuantizedHistEntry& dst, const QuantizedHistEntry& src) {  // NOLINT
+        dst.grad = static_cast<int16_t>(dst.grad + src.grad);
+        dst.hess = static_cast<int16_t>(dst.hess + src.hess);
+      }
+    };
+    bool quantized_hist_sync_ {false};
+    rabit::Reducer<QuantizedHistEntry, QuantizedHistEntry::Reduce> histred_q16_;
+    std::vector<QuantizedHistEntry> quantized_hist_buffer_;
+    // Fixed-size wire representation of a node's best split, exchanged for a
+    // whole frontier in one collective; see SyncBestSplits.  The comparison
+    // runs inside the reduction functor, mirroring SplitEntry::NeedReplace,
+    // so the collective itself selects the winner.
+    struct PackedSplitEntry {
+      bst_float loss_chg;
+      unsigned sindex;
+      bst_float split_value;
+      uint32_t is_cat;
+      double left_sum_grad;
+      double left_sum_hess;
+      double right_sum_grad;
+      double right_sum_hess;
+      static void Reduce(PackedSplitEntry& dst, const PackedSplitEntry& src) {  // NOLINT
+        if (std::isinf(src.loss_chg)) {
+          return;
+        }
+        const unsigned dst_index = dst.sindex & ((1U << 31) - 1U);
+        const unsigned src_index = src.sindex & ((1U << 31) - 1U);
+        const bool replace = dst_index <= src_index
+                                 ? src.loss_chg > dst.loss_chg
+                                 : !(dst.loss_chg > src.loss_chg);
+        if (replace) {
+          dst = src;
+        }
+      }
+    };
+    rabit::Reducer<PackedSplitEntry, PackedSplitEntry::Reduce> splitred_;
+    std::vector<PackedSplitEntry> packed_split_buffer_;
+    // per-tree-sample reduction path, see SampledAllreduceHist
+    bool sampled_hist_sync_ {false};
+    std::vector<GradientPairT> sampled_hist_buffer_;
+    // bin boundaries of the current quantized index, set by InitData
+    const std::vector<uint32_t>* cut_ptrs_ {nullptr};
     std::unique_ptr<HistSynchronizer<GradientSumT>> hist_synchronizer_;
     std::unique_ptr<HistRowsAdder<GradientSumT>> hist_rows_adder_;
   };
@@ -502,9 +832,16 @@ class DistributedHistSynchronizer: public HistSynchronizer<GradientSumT> {
   void SyncHistograms(BuilderT* builder, int starting_index,
                       int sync_count, RegTree *p_tree) override;
 
+  /*!
+   * \brief Performs the subtraction trick for the entries whose reduced
+   *  sibling histogram lies in [sibling_nid_begin, sibling_nid_end), so
+   *  subtraction can start before the whole frontier has been reduced.
+   */
   void ParallelSubtractionHist(BuilderT* builder,
                                const common::BlockedSpace2d& space,
                                const std::vector<ExpandEntryT>& nodes,
+                               int sibling_nid_begin,
+                               int sibling_nid_end,
                                const RegTree * p_tree);
 };
 
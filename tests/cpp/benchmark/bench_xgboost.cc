@@ -0,0 +1,259 @@
+/*!
+ * Copyright 2021 XGBoost contributors
+ * \file bench_xgboost.cc
+ * \brief Microbenchmarks for the training and inference hot paths.
+ *
+ * Built as the optional `xgboost_bench` target (cmake -DGOOGLE_BENCHMARK=ON)
+ * so regressions in the core kernels can be quantified between releases
+ * without training end to end.  Each benchmark is parameterized over the
+ * shapes that drive its cost (rows, features, bins, sparsity, tree count);
+ * run a subset with --benchmark_filter=<name>.
+ */
+#include <benchmark/benchmark.h>
+
+#include <xgboost/data.h>
+#include <xgboost/generic_parameters.h>
+#include <xgboost/json.h>
+#include <xgboost/learner.h>
+#include <xgboost/predictor.h>
+#include <xgboost/tree_model.h>
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../../../src/common/hist_util.h"
+#include "../../../src/common/quantile.h"
+#include "../../../src/common/row_set.h"
+#include "../../../src/data/adapter.h"
+#include "../../../src/gbm/gbtree_model.h"
+
+namespace xgboost {
+namespace {
+
+// Dense row-major data with the requested fraction of missing entries.
+std::vector<float> GenerateData(size_t rows, size_t cols, float sparsity,
+                                uint32_t seed = 27) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> value(0.0f, 1.0f);
+  std::vector<float> data(rows * cols);
+  for (auto& v : data) {
+    v = value(rng) < sparsity ? std::numeric_limits<float>::quiet_NaN()
+                              : value(rng);
+  }
+  return data;
+}
+
+std::shared_ptr<DMatrix> MakeDMatrix(size_t rows, size_t cols, float sparsity) {
+  auto data = GenerateData(rows, cols, sparsity);
+  data::DenseAdapter adapter(data.data(), rows, cols);
+  return std::shared_ptr<DMatrix>(DMatrix::Create(
+      &adapter, std::numeric_limits<float>::quiet_NaN(), 1));
+}
+
+std::vector<GradientPair> GenerateGradients(size_t rows) {
+  std::vector<GradientPair> gpair(rows);
+  for (size_t i = 0; i < rows; ++i) {
+    gpair[i] = GradientPair(-1.0f + 2.0f * (i % 97) / 96.0f,
+                            0.1f + (i % 13) / 13.0f);
+  }
+  return gpair;
+}
+
+// Complete binary trees of the given depth splitting on rotating features.
+gbm::GBTreeModel MakeModel(LearnerModelParam const* param, size_t n_trees,
+                           size_t depth, size_t cols) {
+  gbm::GBTreeModel model(param);
+  std::vector<std::shared_ptr<RegTree>> trees;
+  for (size_t t = 0; t < n_trees; ++t) {
+    trees.emplace_back(new RegTree);
+    auto& tree = *trees.back();
+    const bst_node_t n_internal = (1 << depth) - 1;
+    for (bst_node_t nid = 0; nid < n_internal; ++nid) {
+      tree.ExpandNode(nid, (nid + t) % cols, 0.5f, true, 0.0f, -0.1f, 0.1f,
+                      0.0f, 1.0f, 0.5f, 0.5f);
+    }
+  }
+  model.CommitModel(std::move(trees), 0);
+  return model;
+}
+
+// GHistBuilder::BuildHist - one full pass over the rows of a node.
+// Args: rows, features, max bins, sparsity (percent).
+void BM_BuildHist(benchmark::State& state) {  // NOLINT
+  const size_t rows = state.range(0);
+  const size_t cols = state.range(1);
+  const int bins = static_cast<int>(state.range(2));
+  const float sparsity = state.range(3) / 100.0f;
+
+  auto dmat = MakeDMatrix(rows, cols, sparsity);
+  common::GHistIndexMatrix gmat;
+  gmat.Init(dmat.get(), bins);
+  const uint32_t nbins = gmat.cut.Ptrs().back();
+
+  auto gpair = GenerateGradients(rows);
+  std::vector<size_t> rids(rows);
+  std::iota(rids.begin(), rids.end(), 0);
+  common::RowSetCollection::Elem row_set(rids.data(), rids.data() + rows, 0);
+
+  common::HistCollection<double> collection;
+  collection.Init(nbins);
+  collection.AddHistRow(0);
+  collection.AllocateAllData();
+  auto hist = collection[0];
+
+  common::GHistBuilder<double> builder(1, nbins);
+  for (auto _ : state) {
+    common::InitilizeHistByZeroes(hist, 0, nbins);
+    builder.BuildHist(gpair, row_set, gmat, hist, gmat.IsDense());
+  }
+  state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_BuildHist)
+    ->Args({1 << 16, 50, 256, 0})
+    ->Args({1 << 20, 50, 256, 0})
+    ->Args({1 << 16, 500, 256, 0})
+    ->Args({1 << 16, 50, 256, 50})
+    ->Args({1 << 16, 50, 32, 0});
+
+// CPU batch prediction through the public Predictor interface.
+// Args: rows, features, trees, tree depth.
+void BM_PredictBatch(benchmark::State& state) {  // NOLINT
+  const size_t rows = state.range(0);
+  const size_t cols = state.range(1);
+  const size_t n_trees = state.range(2);
+  const size_t depth = state.range(3);
+
+  LearnerModelParam param;
+  param.num_feature = cols;
+  param.base_score = 0.5f;
+  param.num_output_group = 1;
+  auto model = MakeModel(&param, n_trees, depth, cols);
+
+  GenericParameter lparam;
+  lparam.UpdateAllowUnknown(Args{{"gpu_id", "-1"}});
+  std::unique_ptr<Predictor> predictor(
+      Predictor::Create("cpu_predictor", &lparam));
+  predictor->Configure({});
+
+  auto dmat = MakeDMatrix(rows, cols, 0.0f);
+  PredictionCacheEntry out_predictions;
+  for (auto _ : state) {
+    out_predictions.version = 0;
+    predictor->PredictBatch(dmat.get(), &out_predictions, model, 0);
+  }
+  state.SetItemsProcessed(state.iterations() * rows * n_trees);
+}
+BENCHMARK(BM_PredictBatch)
+    ->Args({1 << 14, 50, 100, 6})
+    ->Args({1 << 14, 50, 1000, 6})
+    ->Args({1 << 14, 500, 100, 6})
+    ->Args({1 << 18, 50, 100, 6});
+
+// WQuantileSketch::Push - streaming quantile summary maintenance.
+// Args: values, max bins.
+void BM_QuantileSketchPush(benchmark::State& state) {  // NOLINT
+  const size_t n = state.range(0);
+  const int bins = static_cast<int>(state.range(1));
+
+  auto data = GenerateData(n, 1, 0.0f);
+  common::WQuantileSketch<float, float> sketch;
+  for (auto _ : state) {
+    sketch.Init(n, 1.0 / (std::max(bins, 2) *
+                          common::WQuantileSketch<float, float>::kFactor));
+    for (size_t i = 0; i < n; ++i) {
+      sketch.Push(data[i], 1.0f);
+    }
+    benchmark::DoNotOptimize(sketch);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_QuantileSketchPush)
+    ->Args({1 << 16, 256})
+    ->Args({1 << 20, 256})
+    ->Args({1 << 20, 32});
+
+// PartitionBuilder - block bookkeeping and merge of a frontier partition.
+// Args: rows.
+void BM_PartitionBuilder(benchmark::State& state) {  // NOLINT
+  const size_t rows = state.range(0);
+  constexpr size_t kBlockSize = 2048;
+  const size_t n_tasks = rows / kBlockSize + !!(rows % kBlockSize);
+
+  std::vector<size_t> rids(rows);
+  std::iota(rids.begin(), rids.end(), 0);
+  std::vector<size_t> out(rows);
+
+  common::PartitionBuilder<kBlockSize> partition_builder;
+  for (auto _ : state) {
+    partition_builder.Init(n_tasks, 1, [&](size_t) { return n_tasks; });
+    for (size_t task = 0; task < n_tasks; ++task) {
+      const size_t begin = task * kBlockSize;
+      const size_t end = std::min(rows, begin + kBlockSize);
+      partition_builder.AllocateForTask(task);
+      auto left = partition_builder.GetLeftBuffer(0, begin, end);
+      auto right = partition_builder.GetRightBuffer(0, begin, end);
+      size_t n_left = 0, n_right = 0;
+      for (size_t i = begin; i < end; ++i) {
+        if (rids[i] % 3 == 0) {
+          left[n_left++] = rids[i];
+        } else {
+          right[n_right++] = rids[i];
+        }
+      }
+      partition_builder.SetNLeftElems(0, begin, end, n_left);
+      partition_builder.SetNRightElems(0, begin, end, n_right);
+    }
+    partition_builder.CalculateRowOffsets();
+    for (size_t task = 0; task < n_tasks; ++task) {
+      partition_builder.MergeToArray(0, task * kBlockSize, out.data());
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_PartitionBuilder)
+    ->Arg(1 << 16)
+    ->Arg(1 << 20)
+    ->Arg(1 << 22);
+
+// JSON model round trip - parse plus GBTreeModel::LoadModel.
+// Args: trees, tree depth.
+void BM_JsonModelLoad(benchmark::State& state) {  // NOLINT
+  const size_t n_trees = state.range(0);
+  const size_t depth = state.range(1);
+  constexpr size_t kCols = 50;
+
+  LearnerModelParam param;
+  param.num_feature = kCols;
+  param.base_score = 0.5f;
+  param.num_output_group = 1;
+  auto model = MakeModel(&param, n_trees, depth, kCols);
+
+  Json j_model{Object()};
+  model.SaveModel(&j_model);
+  std::string buffer;
+  Json::Dump(j_model, &buffer);
+
+  for (auto _ : state) {
+    Json loaded = Json::Load(StringView{buffer.c_str(), buffer.size()});
+    gbm::GBTreeModel round_trip(&param);
+    round_trip.LoadModel(loaded);
+    benchmark::DoNotOptimize(round_trip);
+  }
+  state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+BENCHMARK(BM_JsonModelLoad)
+    ->Args({100, 6})
+    ->Args({1000, 6})
+    ->Args({100, 10});
+
+}  // namespace
+}  // namespace xgboost
+
+BENCHMARK_MAIN();
@@ -21,8 +21,10 @@
  * KIND, either express or implied.
  */
 #include <cstddef>
+#include <cstdlib>
 #include <gtest/gtest.h>
 #include <limits>
+#include <string>
 #include "../../../src/common/charconv.h"
 
 namespace xgboost {
@@ -147,6 +149,18 @@ TEST(Ryu, RoundTrip) {
   ASSERT_EQ(f, back);
 }
 
+TEST(Ryu, EightDigitBatch) {
+  // Mantissas long enough to take the batched 8-digit parsing path.
+  float f;
+  for (auto in : {"12345678", "1.2345678", "12345678.0", "0.00000000123456",
+                  "-9.8765432E-12", "87654321E3"}) {
+    std::string str{in};
+    auto ret = from_chars(str.c_str(), str.c_str() + str.size(), f);
+    ASSERT_EQ(ret.ec, std::errc());
+    ASSERT_EQ(f, std::strtof(str.c_str(), nullptr)) << str;
+  }
+}
+
 TEST(Ryu, LooksLikePow5) {
   // These numbers have a mantissa that is the largest power of 5 that fits,
   // and an exponent that causes the computation for q to result in 10, which is a corner
@@ -171,5 +171,23 @@ TEST(Allocator, OOM) {
   // Clear last error so we don't fail subsequent tests
   cudaGetLastError();
 }
+
+TEST(Allocator, MemoryScope) {
+  size_t constexpr kElems = 1024;
+  dh::GlobalMemoryLogger().Clear();
+  ConsoleLogger::Configure({{"verbosity", "3"}});
+  {
+    dh::MemoryScope scope("memory_scope_test");
+    dh::device_vector<float> data(kElems);
+    EXPECT_EQ(
+        dh::GlobalMemoryLogger().CurrentlyAllocatedBytes("memory_scope_test"),
+        kElems * sizeof(float));
+  }
+  ConsoleLogger::Configure({{"verbosity", "0"}});
+  EXPECT_EQ(
+      dh::GlobalMemoryLogger().CurrentlyAllocatedBytes("memory_scope_test"), 0);
+  EXPECT_EQ(dh::GlobalMemoryLogger().PeakMemory("memory_scope_test"),
+            kElems * sizeof(float));
+}
 }  // namespace common
 }  // namespace xgboost
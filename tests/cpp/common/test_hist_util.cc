@@ -1,9 +1,11 @@
 #include <gtest/gtest.h>
+#include <numeric>
 #include <vector>
 #include <string>
 #include <utility>
 
 #include "../../../src/common/hist_util.h"
+#include "../../../src/data/adapter.h"
 #include "../helpers.h"
 #include "test_hist_util.h"
 
@@ -132,6 +134,51 @@ TEST(ParallelGHistBuilder, ResetFloat) {
   ParallelGHistBuilderReset<float>();
 }
 
+template <typename GradientSumT>
+void ParallelGHistBuilderReduceHistTree(){
+  constexpr size_t kBins = 10;
+  constexpr size_t kNodes = 5;
+  constexpr size_t kTasksPerNode = 10;
+  constexpr double kValue = 1.0;
+  const size_t nthreads = GetNThreads();
+
+  HistCollection<GradientSumT> collection;
+  collection.Init(kBins);
+
+  for(size_t inode = 0; inode < kNodes; inode++) {
+    collection.AddHistRow(inode);
+  }
+  collection.AllocateAllData();
+  ParallelGHistBuilder<GradientSumT> hist_builder;
+  hist_builder.Init(kBins);
+  std::vector<GHistRow<GradientSumT>> target_hist(kNodes);
+  for(size_t i = 0; i < target_hist.size(); ++i) {
+    target_hist[i] = collection[i];
+  }
+
+  common::BlockedSpace2d space(kNodes, [&](size_t node) { return kTasksPerNode; }, 1);
+  hist_builder.Reset(nthreads, kNodes, space, target_hist);
+
+  common::ParallelFor2d(space, nthreads, [&](size_t inode, common::Range1d r) {
+    const size_t tid = omp_get_thread_num();
+
+    GHistRow<GradientSumT> hist = hist_builder.GetInitializedHist(tid, inode);
+    for(size_t i = 0; i < kBins; ++i) {
+      hist[i].Add(kValue, kValue);
+    }
+  });
+
+  // The tree-structured merge must produce the same totals as ReduceHist
+  hist_builder.ReduceHistTree(nthreads);
+
+  for(size_t inode = 0; inode < kNodes; inode++) {
+    for(size_t i = 0; i < kBins; ++i) {
+      ASSERT_EQ(kValue * kTasksPerNode, collection[inode][i].GetGrad());
+      ASSERT_EQ(kValue * kTasksPerNode, collection[inode][i].GetHess());
+    }
+  }
+}
+
 TEST(ParallelGHistBuilder, ReduceHistDouble) {
   ParallelGHistBuilderReduceHist<double>();
 }
@@ -140,6 +187,34 @@ TEST(ParallelGHistBuilder, ReduceHistFloat) {
   ParallelGHistBuilderReduceHist<float>();
 }
 
+TEST(ParallelGHistBuilder, ReduceHistTreeDouble) {
+  ParallelGHistBuilderReduceHistTree<double>();
+}
+
+TEST(ParallelGHistBuilder, ReduceHistTreeFloat) {
+  ParallelGHistBuilderReduceHistTree<float>();
+}
+
+TEST(QuantizedGradients, RoundTrip) {
+  std::vector<GradientPair> gpair = {
+      {0.5f, 1.0f}, {-2.25f, 0.75f}, {1024.0f, 3.5f}, {-0.125f, 2.0f}};
+  QuantizedGradients quantized;
+  quantized.Init(gpair);
+
+  ASSERT_FALSE(quantized.Empty());
+  const int16_t* data = quantized.Data();
+  const float scale = quantized.Scale();
+  // shared scale must cover the largest absolute value without overflow
+  ASSERT_GE(scale * 32767.0f, 1024.0f);
+  for (size_t i = 0; i < gpair.size(); ++i) {
+    const float grad = scale * data[2 * i];
+    const float hess = scale * data[2 * i + 1];
+    // error per value is bounded by half a quantization step
+    ASSERT_NEAR(gpair[i].GetGrad(), grad, 0.5f * scale);
+    ASSERT_NEAR(gpair[i].GetHess(), hess, 0.5f * scale);
+  }
+}
+
 TEST(CutsBuilder, SearchGroupInd) {
   size_t constexpr kNumGroups = 4;
   size_t constexpr kRows = 17;
@@ -209,6 +284,26 @@ TEST(HistUtil, DenseCutsAccuracyTest) {
   }
 }
 
+TEST(HistUtil, SearchBinBlock) {
+  // The block search must agree with the per-element SearchBin on every
+  // entry, including the scalar tail of a block and out-of-range values.
+  int num_rows = 1000;
+  int num_columns = 7;
+  auto x = GenerateRandom(num_rows, num_columns);
+  auto dmat = GetDMatrixFromData(x, num_rows, num_columns);
+  for (auto num_bins : {2, 16, 256}) {
+    HistogramCuts cuts = SketchOnDMatrix(dmat.get(), num_bins);
+    for (auto const& page : dmat->GetBatches<SparsePage>()) {
+      auto const& entries = page.data.HostVector();
+      std::vector<uint32_t> bins(entries.size());
+      cuts.SearchBinBlock(entries.data(), entries.size(), bins.data());
+      for (size_t i = 0; i < entries.size(); ++i) {
+        ASSERT_EQ(bins[i], cuts.SearchBin(entries[i]));
+      }
+    }
+  }
+}
+
 TEST(HistUtil, DenseCutsAccuracyTestWeights) {
   int bin_sizes[] = {2, 16, 256, 512};
   int sizes[] = {100, 1000, 1500};
@@ -241,27 +336,88 @@ TEST(HistUtil, DenseCutsExternalMemory) {
   }
 }
 
+TEST(HistUtil, StreamingIndexFromParser) {
+  dmlc::TemporaryDirectory tmpdir;
+  const std::string filename = tmpdir.path + "/test.libsvm";
+  CreateBigTestData(filename, 60);
+
+  std::unique_ptr<DMatrix> dmat{DMatrix::Load(filename, true, false)};
+  GHistIndexMatrix expected;
+  expected.Init(dmat.get(), 16);
+
+  std::unique_ptr<dmlc::Parser<uint32_t>> parser(
+      dmlc::Parser<uint32_t>::Create(filename.c_str(), 0, 1, "libsvm"));
+  MetaInfo info;
+  GHistIndexMatrix gmat;
+  gmat.Init(parser.get(), &info, 16);
+
+  ASSERT_EQ(info.num_row_, dmat->Info().num_row_);
+  ASSERT_EQ(info.num_col_, dmat->Info().num_col_);
+  ASSERT_EQ(info.num_nonzero_, dmat->Info().num_nonzero_);
+  ASSERT_EQ(info.labels_.HostVector(), dmat->Info().labels_.HostVector());
+
+  ASSERT_EQ(gmat.cut.Ptrs(), expected.cut.Ptrs());
+  ASSERT_EQ(gmat.cut.Values(), expected.cut.Values());
+  ASSERT_EQ(gmat.cut.MinValues(), expected.cut.MinValues());
+  ASSERT_EQ(gmat.row_ptr, expected.row_ptr);
+  ASSERT_EQ(gmat.hit_count, expected.hit_count);
+  ASSERT_EQ(gmat.index.Size(), expected.index.Size());
+  for (size_t i = 0; i < expected.index.Size(); ++i) {
+    ASSERT_EQ(gmat.index[i], expected.index[i]);
+  }
+}
+
 TEST(HistUtil, IndexBinBound) {
   uint64_t bin_sizes[] = { static_cast<uint64_t>(std::numeric_limits<uint8_t>::max()) + 1,
                            static_cast<uint64_t>(std::numeric_limits<uint16_t>::max()) + 1,
                            static_cast<uint64_t>(std::numeric_limits<uint16_t>::max()) + 2 };
-  BinTypeSize expected_bin_type_sizes[] = {kUint8BinsTypeSize,
-                                           kUint16BinsTypeSize,
-                                           kUint32BinsTypeSize};
   size_t constexpr kRows = 100;
   size_t constexpr kCols = 10;
 
-  size_t bin_id = 0;
   for (auto max_bin : bin_sizes) {
     auto p_fmat = RandomDataGenerator(kRows, kCols, 0).GenerateDMatrix();
 
     common::GHistIndexMatrix hmat;
     hmat.Init(p_fmat.get(), max_bin);
     EXPECT_EQ(hmat.index.Size(), kRows*kCols);
-    EXPECT_EQ(expected_bin_type_sizes[bin_id++], hmat.index.GetBinTypeSize());
+    // the index width is chosen from the realized cut count, not from the
+    // configured maximum; 100 distinct values per feature fit into uint8
+    // regardless of how many bins were requested
+    EXPECT_LE(hmat.max_num_bins - 1,
+              static_cast<size_t>(std::numeric_limits<uint8_t>::max()));
+    EXPECT_EQ(kUint8BinsTypeSize, hmat.index.GetBinTypeSize());
   }
 }
 
+TEST(HistUtil, DenseImplicitStride) {
+  size_t constexpr kRows = 100;
+  size_t constexpr kCols = 10;
+
+  // a dense matrix addresses rows by the implicit stride and never
+  // materializes the row offset array
+  auto dense = RandomDataGenerator(kRows, kCols, 0).GenerateDMatrix();
+  common::GHistIndexMatrix dense_hmat;
+  dense_hmat.Init(dense.get(), 16);
+  ASSERT_TRUE(dense_hmat.IsDense());
+  EXPECT_TRUE(dense_hmat.row_ptr.empty());
+  EXPECT_EQ(dense_hmat.Size(), kRows);
+  EXPECT_EQ(dense_hmat.RowStride(), kCols);
+  EXPECT_EQ(dense_hmat.RowBegin(3), 3 * kCols);
+  EXPECT_EQ(dense_hmat.RowEnd(3), 4 * kCols);
+  EXPECT_EQ(dense_hmat.RowBegin(kRows), dense_hmat.index.Size());
+
+  // sparse data keeps the CSR offsets, exposed through the same accessors
+  auto sparse = RandomDataGenerator(kRows, kCols, 0.5).GenerateDMatrix();
+  common::GHistIndexMatrix sparse_hmat;
+  sparse_hmat.Init(sparse.get(), 16);
+  ASSERT_FALSE(sparse_hmat.IsDense());
+  EXPECT_EQ(sparse_hmat.row_ptr.size(), kRows + 1);
+  EXPECT_EQ(sparse_hmat.Size(), kRows);
+  EXPECT_EQ(sparse_hmat.RowStride(), 0);
+  EXPECT_EQ(sparse_hmat.RowBegin(3), sparse_hmat.row_ptr[3]);
+  EXPECT_EQ(sparse_hmat.RowEnd(3), sparse_hmat.row_ptr[4]);
+}
+
 template <typename T>
 void CheckIndexData(T* data_ptr, uint32_t* offsets,
                     const common::GHistIndexMatrix& hmat, size_t n_cols) {
@@ -283,16 +439,16 @@ TEST(HistUtil, IndexBinData) {
     hmat.Init(p_fmat.get(), max_bin);
     uint32_t* offsets = hmat.index.Offset();
     EXPECT_EQ(hmat.index.Size(), kRows*kCols);
-    switch (max_bin) {
-      case kBinSizes[0]:
+    switch (hmat.index.GetBinTypeSize()) {
+      case kUint8BinsTypeSize:
         CheckIndexData(hmat.index.data<uint8_t>(),
                        offsets, hmat, kCols);
         break;
-      case kBinSizes[1]:
+      case kUint16BinsTypeSize:
         CheckIndexData(hmat.index.data<uint16_t>(),
                        offsets, hmat, kCols);
         break;
-      case kBinSizes[2]:
+      case kUint32BinsTypeSize:
         CheckIndexData(hmat.index.data<uint32_t>(),
                        offsets, hmat, kCols);
         break;
@@ -300,6 +456,53 @@ TEST(HistUtil, IndexBinData) {
   }
 }
 
+TEST(HistUtil, BuildHistColumns) {
+  size_t constexpr kRows = 100;
+  size_t constexpr kCols = 10;
+  size_t constexpr kBins = 16;
+
+  auto p_fmat = RandomDataGenerator(kRows, kCols, 0).GenerateDMatrix();
+  common::GHistIndexMatrix gmat;
+  gmat.Init(p_fmat.get(), kBins);
+  const size_t nbins = gmat.cut.Ptrs().back();
+
+  std::vector<GradientPair> gpair(kRows);
+  for (size_t i = 0; i < kRows; ++i) {
+    gpair[i] = GradientPair(0.1f + 0.01f * i, 0.2f + 0.01f * i);
+  }
+  std::vector<size_t> rids(kRows);
+  std::iota(rids.begin(), rids.end(), 0);
+  RowSetCollection::Elem rows(rids.data(), rids.data() + kRows, 0);
+
+  HistCollection<double> collection;
+  collection.Init(nbins);
+  collection.AddHistRow(0);
+  collection.AddHistRow(1);
+  collection.AllocateAllData();
+  auto row_hist = collection[0];
+  auto col_hist = collection[1];
+  InitilizeHistByZeroes(row_hist, 0, nbins);
+
+  GHistBuilder<double> builder(1, nbins);
+  builder.BuildHist(gpair, rows, gmat, row_hist, /*isDense=*/true);
+
+  // slices must cover their own bin ranges and nothing else, so their union
+  // reproduces the row-parallel result exactly
+  const std::vector<uint32_t>& cut_ptrs = gmat.cut.Ptrs();
+  const size_t n_slices = 3;
+  for (size_t s = 0; s < n_slices; ++s) {
+    const size_t f_begin = s * kCols / n_slices;
+    const size_t f_end = (s + 1) * kCols / n_slices;
+    InitilizeHistByZeroes(col_hist, cut_ptrs[f_begin], cut_ptrs[f_end]);
+    builder.BuildHistColumns(gpair, rows, gmat, f_begin, f_end, col_hist);
+  }
+
+  for (size_t i = 0; i < nbins; ++i) {
+    ASSERT_EQ(row_hist[i].GetGrad(), col_hist[i].GetGrad());
+    ASSERT_EQ(row_hist[i].GetHess(), col_hist[i].GetHess());
+  }
+}
+
 void TestSketchFromWeights(bool with_group) {
   size_t constexpr kRows = 300, kCols = 20, kBins = 256;
   size_t constexpr kGroups = 10;
@@ -356,5 +559,101 @@ TEST(HistUtil, SketchFromWeights) {
   TestSketchFromWeights(true);
   TestSketchFromWeights(false);
 }
+
+TEST(HistUtil, SketchWithHessian) {
+  size_t constexpr kRows = 300, kCols = 20, kBins = 64;
+  auto m = RandomDataGenerator{kRows, kCols, 0}.GenerateDMatrix();
+  HistogramCuts unweighted = SketchOnDMatrix(m.get(), kBins);
+
+  // a uniform hessian reproduces the unweighted proposal
+  std::vector<float> hess(kRows, 1.0f);
+  HistogramCuts uniform =
+      SketchOnDMatrix(m.get(), kBins, {hess.data(), hess.size()});
+  ASSERT_EQ(uniform.Values(), unweighted.Values());
+  ASSERT_EQ(uniform.Ptrs(), unweighted.Ptrs());
+
+  // a non-uniform hessian acts exactly like per-row sample weights
+  for (size_t i = 0; i < kRows; ++i) {
+    hess[i] = 1.0f + static_cast<float>(i % 10);
+  }
+  m->Info().weights_.HostVector().assign(hess.begin(), hess.end());
+  HistogramCuts weighted = SketchOnDMatrix(m.get(), kBins);
+  m->Info().weights_.HostVector().clear();
+  HistogramCuts hessian_cuts =
+      SketchOnDMatrix(m.get(), kBins, {hess.data(), hess.size()});
+  ASSERT_EQ(hessian_cuts.Values(), weighted.Values());
+  ASSERT_EQ(hessian_cuts.Ptrs(), weighted.Ptrs());
+}
+
+TEST(HistCollection, KeepRows) {
+  HistCollection<double> hist;
+  hist.Init(8);
+  hist.AddHistRow(0);
+  hist.AllocateData(0);
+  hist[0][3] = xgboost::detail::GradientPairInternal<double>{1.0, 2.0};
+
+  // keeping the rows retains both the mapping and the contents
+  hist.Init(8, true);
+  ASSERT_TRUE(hist.RowExists(0));
+  ASSERT_EQ(hist[0][3].GetGrad(), 1.0);
+  ASSERT_EQ(hist[0][3].GetHess(), 2.0);
+
+  // a plain Init drops them
+  hist.Init(8);
+  ASSERT_FALSE(hist.RowExists(0));
+}
+
+TEST(HistCollection, RemoveHistRow) {
+  HistCollection<double> hist;
+  hist.Init(8);
+  hist.AddHistRow(0);
+  hist.AddHistRow(1);
+  hist.AllocateAllData();
+  // a removed row disappears and its slot is recycled for the next node,
+  // as when a speculative lossguide split is rolled back
+  hist.RemoveHistRow(1);
+  ASSERT_FALSE(hist.RowExists(1));
+  hist.AddHistRow(2);
+  hist.AllocateAllData();
+  ASSERT_TRUE(hist.RowExists(2));
+  ASSERT_EQ(hist[2].data(), hist[0].data() + 8);
+}
+
+TEST(HistUtil, ExclusiveFeatureBundles) {
+  // f0..f2 are mutually exclusive one-hot columns, f3 is dense
+  std::vector<size_t> row_ptr{0, 2, 4, 6, 7, 9, 11, 12, 13};
+  std::vector<unsigned> findex{0, 3, 1, 3, 2, 3, 0, 1, 3, 2, 3, 0, 1};
+  std::vector<float> fvalues{1, 5, 1, 6, 1, 9, 1, 1, 7, 1, 8, 1, 1};
+  data::CSRAdapter adapter(row_ptr.data(), findex.data(), fvalues.data(), 8,
+                           13, 4);
+  std::shared_ptr<DMatrix> dmat{
+      DMatrix::Create(&adapter, std::numeric_limits<float>::quiet_NaN(), 1)};
+
+  auto efb = MakeExclusiveFeatureBundles(dmat.get(), 0.0);
+  ASSERT_EQ(efb.NumBundles(), 2ul);
+  ASSERT_EQ(efb.bundles[0], std::vector<bst_feature_t>({3}));
+  ASSERT_EQ(efb.bundles[1], std::vector<bst_feature_t>({0, 1, 2}));
+
+  // splits on bundled columns map back to the original features
+  bst_float value { 0 };
+  ASSERT_EQ(efb.OriginalSplit(0, 5.5f, &value), 3u);
+  ASSERT_EQ(value, 5.5f);
+  ASSERT_EQ(efb.OriginalSplit(1, 1.5f, &value), 1u);
+  ASSERT_NEAR(value, 0.5f, kRtEps);
+
+  auto bundled = ApplyExclusiveFeatureBundles(dmat.get(), efb);
+  ASSERT_EQ(bundled->Info().num_col_, 2ul);
+  ASSERT_EQ(bundled->Info().num_row_, 8ul);
+  ASSERT_EQ(bundled->Info().num_nonzero_, 13ul);
+  for (auto const& batch : bundled->GetBatches<SparsePage>()) {
+    // first row: the dense column followed by the one-hot bundle
+    auto inst = batch[0];
+    ASSERT_EQ(inst.size(), 2ul);
+    ASSERT_EQ(inst[0].index, 0u);
+    ASSERT_EQ(inst[0].fvalue, 5.0f);
+    ASSERT_EQ(inst[1].index, 1u);
+    ASSERT_EQ(inst[1].fvalue, 1.0f);
+  }
+}
 }  // namespace common
 }  // namespace xgboost
@@ -240,6 +240,20 @@ TEST(HistUtil, DeviceSketchBatches) {
   }
 }
 
+TEST(HistUtil, DeviceSketchMemoryBudget) {
+  int num_bins = 256;
+  int num_rows = 5000;
+  int num_columns = 5;
+  auto x = GenerateRandom(num_rows, num_columns);
+  auto dmat = GetDMatrixFromData(x, num_rows, num_columns);
+  // A tight ceiling forces several windows whose summaries are spilled to
+  // pinned host memory and merged back.
+  size_t budget =
+      detail::BytesPerElement(false) * num_rows * num_columns / 8;
+  auto cuts = DeviceSketch(0, dmat.get(), num_bins, 0, budget);
+  ValidateCuts(cuts, dmat.get(), num_bins);
+}
+
 TEST(HistUtil, DeviceSketchMultipleColumnsExternal) {
   int bin_sizes[] = {2, 16, 256, 512};
   int sizes[] = {100, 1000, 1500};
@@ -0,0 +1,36 @@
+/*!
+ * Copyright 2021 XGBoost contributors
+ */
+#include <gtest/gtest.h>
+#include <xgboost/host_device_vector.h>
+
+namespace xgboost {
+namespace common {
+
+TEST(HostDeviceVector, Reserve) {
+  HostDeviceVector<float> vec;
+  vec.Reserve(100);
+  ASSERT_EQ(vec.Size(), 0);
+  ASSERT_GE(vec.Capacity(), 100);
+
+  // resizing within the reservation does not reallocate
+  auto const* ptr = vec.ConstHostPointer();
+  vec.Resize(100, 1.0f);
+  ASSERT_EQ(vec.ConstHostPointer(), ptr);
+  for (auto v : vec.ConstHostVector()) {
+    ASSERT_EQ(v, 1.0f);
+  }
+
+  // growth past the capacity is amortized
+  auto const capacity = vec.Capacity();
+  vec.Resize(capacity + 1);
+  ASSERT_GE(vec.Capacity(), 2 * capacity);
+  ASSERT_EQ(vec.Size(), capacity + 1);
+
+  // reserving less than the capacity is a no-op
+  vec.Reserve(1);
+  ASSERT_GE(vec.Capacity(), capacity + 1);
+}
+
+}  // namespace common
+}  // namespace xgboost
@@ -6,7 +6,10 @@
 #include <thrust/equal.h>
 #include <thrust/iterator/counting_iterator.h>
 
+#include <numeric>
+
 #include "../../../src/common/device_helpers.cuh"
+#include <xgboost/global_config.h>
 #include <xgboost/host_device_vector.h>
 
 namespace xgboost {
@@ -183,6 +186,32 @@ TEST(HostDeviceVector, Empty) {
   ASSERT_TRUE(vec.Empty());
 }
 
+TEST(HostDeviceVector, PinnedStaging) {
+  auto* config = GlobalConfigThreadLocalStore::Get();
+  auto saved = config->pinned_staging_bytes;
+  // small pool so that the copy takes several chunks
+  config->pinned_staging_bytes = 1 << 10;
+
+  size_t n = 1001;
+  HostDeviceVector<int> vec;
+  auto& h_vec = vec.HostVector();
+  h_vec.resize(n);
+  std::iota(h_vec.begin(), h_vec.end(), 0);
+
+  vec.SetDevice(0);
+  ASSERT_TRUE(thrust::equal(dh::tcbegin(vec.ConstDeviceSpan()),
+                            dh::tcend(vec.ConstDeviceSpan()),
+                            thrust::make_counting_iterator(0)));
+  // force the round trip back to the host
+  vec.DeviceSpan();
+  auto const& h_result = vec.ConstHostVector();
+  for (size_t i = 0; i < n; ++i) {
+    ASSERT_EQ(h_result[i], static_cast<int>(i));
+  }
+
+  config->pinned_staging_bytes = saved;
+}
+
 TEST(HostDeviceVector, MGPU_Basic) {  // NOLINT
   if (AllVisibleGPUs() < 2) {
     LOG(WARNING) << "Not testing in multi-gpu environment.";
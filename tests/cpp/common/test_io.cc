@@ -45,6 +45,29 @@ TEST(IO, FixedSizeStream) {
   }
 }
 
+#if defined(__unix__)
+TEST(IO, MemoryMappedStream) {
+  dmlc::TemporaryDirectory tempdir;
+  std::string path = tempdir.path + "/mapped.bin";
+  std::string content {"This is the content of stream"};
+  {
+    std::unique_ptr<dmlc::Stream> fo(dmlc::Stream::Create(path.c_str(), "w"));
+    fo->Write(content.c_str(), content.size());
+  }
+
+  MemoryMappedStream fi(path);
+  std::string read(content.size(), '\0');
+  ASSERT_EQ(fi.Read(&read[0], read.size()), read.size());
+  ASSERT_EQ(read, content);
+  ASSERT_EQ(fi.Read(&read[0], read.size()), 0);
+
+  fi.Seek(8);
+  ASSERT_EQ(fi.Tell(), 8);
+  ASSERT_EQ(fi.Read(&read[0], 3), 3);
+  ASSERT_EQ(read.substr(0, 3), content.substr(8, 3));
+}
+#endif  // defined(__unix__)
+
 TEST(IO, LoadSequentialFile) {
   EXPECT_THROW(LoadSequentialFile("non-exist"), dmlc::Error);
 
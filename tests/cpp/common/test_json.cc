@@ -245,6 +245,29 @@ TEST(Json, ParseArray) {
   }
 }
 
+TEST(Json, ParseArrayParallel) {
+  // build an array large enough to trigger the parallel element parser
+  std::string str = "[";
+  size_t constexpr kElems = 512;
+  for (size_t i = 0; i < kElems; ++i) {
+    str += R"json({"nodeid": )json" + std::to_string(i) +
+           R"json(, "leaf": 0.25, "pad": ")json" + std::string(4096, 'x') + "\"}";
+    if (i != kElems - 1) {
+      str += ",";
+    }
+  }
+  str += "]";
+  ASSERT_GT(str.size(), 1ul << 20);
+
+  auto json = Json::Load(StringView{str.c_str(), str.size()});
+  auto const& arr = get<Array const>(json);
+  ASSERT_EQ(arr.size(), kElems);
+  for (size_t i = 0; i < kElems; ++i) {
+    ASSERT_EQ(get<Integer const>(arr[i]["nodeid"]), static_cast<int64_t>(i));
+    ASSERT_EQ(get<Number const>(arr[i]["leaf"]), 0.25f);
+  }
+}
+
 TEST(Json, Null) {
   Json json {JsonNull()};
   std::string ss;
@@ -553,6 +576,32 @@ TEST(Json, RoundTrip) {
   }
 }
 
+TEST(Json, ArenaScope) {
+  Json escaped;
+  {
+    JsonArenaScope scope;
+    Json obj { Object() };
+    std::vector<Json> values;
+    for (size_t i = 0; i < 1024; ++i) {
+      values.emplace_back(Number(static_cast<float>(i)));
+    }
+    obj["list"] = Array(std::move(values));
+    obj["str"] = String("hello");
+
+    std::string str;
+    Json::Dump(obj, &str);
+    auto loaded = Json::Load({str.c_str(), str.size()});
+    ASSERT_EQ(loaded, obj);
+
+    // values may outlive the scope, the arena blocks are kept alive by the
+    // last value referencing them.
+    escaped = obj["list"];
+  }
+  auto const& arr = get<Array const>(escaped);
+  ASSERT_EQ(arr.size(), 1024ul);
+  ASSERT_EQ(get<Number const>(arr[512]), 512.0f);
+}
+
 TEST(Json, DISABLED_RoundTripExhaustive) {
   auto test = [](uint32_t i) {
     float f;
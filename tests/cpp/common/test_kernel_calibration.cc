@@ -0,0 +1,65 @@
+/*!
+ * Copyright 2021 by Contributors
+ */
+#include <gtest/gtest.h>
+#include <dmlc/filesystem.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+
+#include "../../../src/common/kernel_calibration.h"
+
+namespace xgboost {
+namespace common {
+
+TEST(KernelCalibration, CacheFileRoundTrip) {
+  dmlc::TemporaryDirectory tempdir;
+  const std::string path = tempdir.path + "/tuning";
+
+  KernelParams out;
+  ASSERT_FALSE(KernelCalibration::LoadCacheFile(path, "cpu-a", &out));
+
+  KernelParams params;
+  params.hist_prefetch_distance = 13;
+  params.hist_row_grain = 512;
+  KernelCalibration::AppendCacheFile(path, "cpu-a", params);
+  KernelParams other;
+  other.hist_prefetch_distance = 8;
+  other.hist_row_grain = 128;
+  KernelCalibration::AppendCacheFile(path, "Some CPU (R) Model @ 3.40GHz", other);
+
+  ASSERT_TRUE(KernelCalibration::LoadCacheFile(path, "cpu-a", &out));
+  ASSERT_EQ(out.hist_prefetch_distance, 13ul);
+  ASSERT_EQ(out.hist_row_grain, 512ul);
+  ASSERT_TRUE(KernelCalibration::LoadCacheFile(
+      path, "Some CPU (R) Model @ 3.40GHz", &out));
+  ASSERT_EQ(out.hist_prefetch_distance, 8ul);
+  ASSERT_EQ(out.hist_row_grain, 128ul);
+  ASSERT_FALSE(KernelCalibration::LoadCacheFile(path, "cpu-b", &out));
+
+  // corrupt lines are skipped without disturbing the valid entries
+  {
+    std::ofstream fo(path.c_str(), std::ios::app);
+    fo << "garbage line\n0\tx\ty\tcpu-b\n";
+  }
+  ASSERT_FALSE(KernelCalibration::LoadCacheFile(path, "cpu-b", &out));
+  ASSERT_TRUE(KernelCalibration::LoadCacheFile(path, "cpu-a", &out));
+  ASSERT_EQ(out.hist_prefetch_distance, 13ul);
+}
+
+TEST(KernelCalibration, Benchmark) {
+  const KernelParams params = KernelCalibration::Benchmark();
+  const size_t distances[] = {4, 6, 8, 10, 13, 16, 24, 32};
+  ASSERT_NE(std::find(std::begin(distances), std::end(distances),
+                      params.hist_prefetch_distance),
+            std::end(distances));
+  const size_t grains[] = {64, 128, 256, 512, 1024};
+  ASSERT_NE(std::find(std::begin(grains), std::end(grains),
+                      params.hist_row_grain),
+            std::end(grains));
+  ASSERT_FALSE(KernelCalibration::CpuModel().empty());
+}
+
+}  // namespace common
+}  // namespace xgboost
@@ -0,0 +1,30 @@
+/*!
+ * Copyright 2021 by XGBoost Contributors
+ */
+#include <gtest/gtest.h>
+#include <cmath>
+#include "../../../src/common/math.h"
+
+namespace xgboost {
+namespace common {
+
+TEST(Math, ApproxExp) {
+  for (float x = -80.0f; x <= 80.0f; x += 0.0625f) {
+    float const expected = std::exp(x);
+    float const approx = ApproxExp(x);
+    ASSERT_NEAR(approx, expected, std::abs(expected) * 4e-7f) << "x = " << x;
+  }
+  // out of range inputs saturate instead of producing inf / 0
+  ASSERT_GT(ApproxExp(-1000.0f), 0.0f);
+  ASSERT_TRUE(std::isfinite(ApproxExp(1000.0f)));
+}
+
+TEST(Math, Sigmoid) {
+  ASSERT_FLOAT_EQ(Sigmoid(0.0f), 0.5f);
+  for (float x = -30.0f; x <= 30.0f; x += 0.25f) {
+    float const expected = 1.0f / (1.0f + std::exp(-x));
+    ASSERT_NEAR(Sigmoid(x), expected, 1e-6f) << "x = " << x;
+  }
+}
+}  // namespace common
+}  // namespace xgboost
@@ -0,0 +1,42 @@
+/*!
+ * Copyright 2021 by Contributors
+ */
+#include <gtest/gtest.h>
+#include <xgboost/json.h>
+
+#include "../../../src/common/memory_stats.h"
+
+namespace xgboost {
+namespace common {
+
+TEST(MemoryStats, LiveAndPeak) {
+  auto& stats = MemoryStats::Instance();
+  size_t const live = stats.LiveBytes(MemoryStats::kGroupBuilder);
+  size_t const peak = stats.PeakBytes(MemoryStats::kGroupBuilder);
+
+  stats.Allocate(MemoryStats::kGroupBuilder, 256);
+  ASSERT_EQ(stats.LiveBytes(MemoryStats::kGroupBuilder), live + 256);
+  ASSERT_GE(stats.PeakBytes(MemoryStats::kGroupBuilder), live + 256);
+
+  stats.Free(MemoryStats::kGroupBuilder, 256);
+  ASSERT_EQ(stats.LiveBytes(MemoryStats::kGroupBuilder), live);
+  // the high-water mark must not move backwards
+  ASSERT_GE(stats.PeakBytes(MemoryStats::kGroupBuilder), peak);
+}
+
+TEST(MemoryStats, CollectJson) {
+  auto& stats = MemoryStats::Instance();
+  std::string const str = stats.CollectJson();
+  auto collected = Json::Load(StringView{str.c_str(), str.size()});
+  for (int i = 0; i < MemoryStats::kNumSubsystems; ++i) {
+    auto const sub = static_cast<MemoryStats::Subsystem>(i);
+    auto const& entry = collected[MemoryStats::Name(sub)];
+    ASSERT_EQ(get<Integer const>(entry["live_bytes"]),
+              static_cast<Integer::Int>(stats.LiveBytes(sub)));
+    ASSERT_GE(get<Integer const>(entry["peak_bytes"]),
+              get<Integer const>(entry["live_bytes"]));
+  }
+}
+
+}  // namespace common
+}  // namespace xgboost
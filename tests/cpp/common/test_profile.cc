@@ -0,0 +1,51 @@
+/*!
+ * Copyright 2021 by Contributors
+ */
+#include <gtest/gtest.h>
+#include <xgboost/json.h>
+
+#include "../../../src/common/profile.h"
+
+namespace xgboost {
+namespace common {
+
+TEST(ProfileRegistry, RegisterIsIdempotent) {
+  auto& registry = ProfileRegistry::Instance();
+  size_t const slot = registry.Register("test_profile_idempotent");
+  ASSERT_EQ(slot, registry.Register("test_profile_idempotent"));
+}
+
+TEST(ProfileRegistry, CollectResetsCounters) {
+  auto& registry = ProfileRegistry::Instance();
+  size_t const slot = registry.Register("test_profile_counter");
+  registry.CollectJson();  // discard whatever earlier tests accumulated
+
+  registry.Add(slot, 3);
+  registry.Add(slot, 4);
+  std::string str = registry.CollectJson();
+  auto collected = Json::Load(StringView{str.c_str(), str.size()});
+  ASSERT_EQ(get<Integer const>(collected["test_profile_counter"]), 7);
+
+  // collecting must have reset the slot
+  str = registry.CollectJson();
+  collected = Json::Load(StringView{str.c_str(), str.size()});
+  ASSERT_EQ(get<Integer const>(collected["test_profile_counter"]), 0);
+
+  std::string const unit = get<String const>(collected["timer_unit"]);
+  ASSERT_TRUE(unit == "tsc" || unit == "ns");
+}
+
+TEST(ProfileRegistry, TimerCharges) {
+  auto& registry = ProfileRegistry::Instance();
+  size_t const slot = registry.Register("test_profile_timer");
+  registry.CollectJson();
+  {
+    ProfileTimer timer{slot};
+  }
+  std::string const str = registry.CollectJson();
+  auto collected = Json::Load(StringView{str.c_str(), str.size()});
+  ASSERT_GE(get<Integer const>(collected["test_profile_timer"]), 0);
+}
+
+}  // namespace common
+}  // namespace xgboost
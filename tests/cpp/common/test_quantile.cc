@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <dmlc/memory_io.h>
 #include "test_quantile.h"
 #include "../../../src/common/quantile.h"
 #include "../../../src/common/hist_util.h"
@@ -6,6 +7,135 @@
 namespace xgboost {
 namespace common {
 
+TEST(Quantile, SaveLoadState) {
+  size_t constexpr kRows = 1000, kCols = 10;
+  size_t constexpr kBins = 64;
+  auto m = RandomDataGenerator{kRows, kCols, 0}.GenerateDMatrix();
+  std::vector<bst_row_t> column_size(kCols, kRows);
+
+  HostSketchContainer original(column_size, kBins, false);
+  for (auto const& page : m->GetBatches<SparsePage>()) {
+    original.PushRowPage(page, m->Info());
+  }
+
+  std::string buffer;
+  dmlc::MemoryStringStream fo(&buffer);
+  original.SaveState(&fo);
+
+  // restoring the state without pushing new rows must reproduce the cuts
+  HostSketchContainer restored(column_size, kBins, false);
+  dmlc::MemoryStringStream fi(&buffer);
+  restored.LoadAndMergeState(&fi);
+
+  HistogramCuts original_cuts;
+  original.MakeCuts(&original_cuts);
+  HistogramCuts restored_cuts;
+  restored.MakeCuts(&restored_cuts);
+
+  ASSERT_EQ(original_cuts.Ptrs(), restored_cuts.Ptrs());
+  ASSERT_EQ(original_cuts.Values(), restored_cuts.Values());
+  ASSERT_EQ(original_cuts.MinValues(), restored_cuts.MinValues());
+}
+
+TEST(Quantile, SetCombine) {
+  using Summary = WQSummary<float, float>;
+  using Entry = Summary::Entry;
+  // unit weight entries with values {1, 3, 5} and {2, 3}
+  std::vector<Entry> a_data{{0, 1, 1, 1}, {1, 2, 1, 3}, {2, 3, 1, 5}};
+  std::vector<Entry> b_data{{0, 1, 1, 2}, {1, 2, 1, 3}};
+  Summary sa(a_data.data(), a_data.size());
+  Summary sb(b_data.data(), b_data.size());
+
+  std::vector<Entry> out_data(a_data.size() + b_data.size());
+  Summary out(out_data.data(), 0);
+  out.SetCombine(sa, sb);
+
+  // duplicated value 3 collapses into one entry, ranks accumulate
+  ASSERT_EQ(out.size, 4);
+  const std::vector<Entry> expected{
+      {0, 1, 1, 1}, {1, 2, 1, 2}, {2, 4, 2, 3}, {4, 5, 1, 5}};
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_EQ(out.data[i].rmin, expected[i].rmin);
+    ASSERT_EQ(out.data[i].rmax, expected[i].rmax);
+    ASSERT_EQ(out.data[i].wmin, expected[i].wmin);
+    ASSERT_EQ(out.data[i].value, expected[i].value);
+  }
+  out.CheckValid(1e-6f);
+
+  // one input exhausted first, remainder handled by the tail loop
+  std::vector<Entry> c_data{{0, 1, 1, 0}};
+  Summary sc(c_data.data(), c_data.size());
+  Summary tail(out_data.data(), 0);
+  tail.SetCombine(sc, sa);
+  ASSERT_EQ(tail.size, 4);
+  ASSERT_EQ(tail.data[0].value, 0);
+  ASSERT_EQ(tail.data[3].rmax, 4);
+  tail.CheckValid(1e-6f);
+}
+
+TEST(Quantile, PushBatch) {
+  using Sketch = WQuantileSketch<float, float>;
+  Sketch sketch;
+  sketch.Init(16, 1e-2);
+
+  // duplicates fold together, zero weight entries are dropped
+  std::vector<Sketch::Summary::Queue::QEntry> batch{
+      {3.0f, 1.0f}, {2.0f, 1.0f}, {2.0f, 1.0f}, {1.0f, 1.0f}, {5.0f, 0.0f}};
+  sketch.PushBatch({batch.data(), batch.size()});
+
+  Sketch::SummaryContainer out;
+  sketch.GetSummary(&out);
+  ASSERT_EQ(out.size, 3);
+  const std::vector<Sketch::Entry> expected{
+      {0, 1, 1, 1}, {1, 3, 2, 2}, {3, 4, 1, 3}};
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_EQ(out.data[i].rmin, expected[i].rmin);
+    ASSERT_EQ(out.data[i].rmax, expected[i].rmax);
+    ASSERT_EQ(out.data[i].wmin, expected[i].wmin);
+    ASSERT_EQ(out.data[i].value, expected[i].value);
+  }
+  out.CheckValid(1e-6f);
+}
+
+TEST(Quantile, TwoPhaseReduce) {
+  size_t constexpr kRows = 1000, kCols = 10;
+  size_t constexpr kBins = 16;
+  auto m = RandomDataGenerator{kRows, kCols, 0}.GenerateDMatrix();
+  std::vector<bst_row_t> column_size(kCols, kRows);
+
+  HostSketchContainer sketch(column_size, kBins, false);
+  for (auto const& page : m->GetBatches<SparsePage>()) {
+    sketch.PushRowPage(page, m->Info());
+  }
+  using WQSketch = HostSketchContainer::WQSketch;
+  std::vector<WQSketch::SummaryContainer> reduced;
+  std::vector<int32_t> num_cuts;
+  sketch.AllReduce(&reduced, &num_cuts);
+
+  std::vector<WQSketch::SummaryContainer> baseline(reduced.size());
+  for (size_t i = 0; i < reduced.size(); ++i) {
+    baseline[i].Reserve(reduced[i].size);
+    baseline[i].CopyFrom(reduced[i]);
+  }
+  sketch.TwoPhaseReduce(&reduced, num_cuts);
+
+  // With a single worker the candidate values come out of the worker's own
+  // summary and the rank statistics match it exactly, so the two-phase
+  // result must reproduce the coarse pruning of the baseline.
+  for (size_t i = 0; i < reduced.size(); ++i) {
+    WQSketch::SummaryContainer expected;
+    expected.Reserve(kBins + 1);
+    expected.SetPrune(baseline[i], kBins + 1);
+    ASSERT_EQ(reduced[i].size, expected.size);
+    for (size_t j = 0; j < expected.size; ++j) {
+      ASSERT_EQ(reduced[i].data[j].value, expected.data[j].value);
+      ASSERT_EQ(reduced[i].data[j].rmin, expected.data[j].rmin);
+      ASSERT_EQ(reduced[i].data[j].rmax, expected.data[j].rmax);
+      ASSERT_EQ(reduced[i].data[j].wmin, expected.data[j].wmin);
+    }
+  }
+}
+
 TEST(Quantile, LoadBalance) {
   size_t constexpr kRows = 1000, kCols = 100;
   auto m = RandomDataGenerator{kRows, kCols, 0}.GenerateDMatrix();
@@ -50,6 +50,37 @@ TEST(ColumnSampler, Test) {
   ASSERT_EQ(cs.GetFeatureSet(0)->Size(), 1);
 }
 
+TEST(ColumnSampler, SampleFrontier) {
+  int n = 128;
+  ColumnSampler cs;
+  std::vector<float> feature_weights;
+  std::vector<Span<bst_feature_t const>> sets;
+
+  // No level or node sampling, all nodes alias the tree set
+  cs.Init(n, feature_weights, 1.0f, 1.0f, 0.5f);
+  cs.SampleFeatureSets({0, 0, 1}, &sets);
+  ASSERT_EQ(sets.size(), 3);
+  for (auto const& set : sets) {
+    ASSERT_EQ(set.size(), 64);
+    ASSERT_EQ(set.data(), sets[0].data());
+  }
+
+  // Level sampling, nodes of the same depth share a set
+  cs.Init(n, feature_weights, 1.0f, 0.5f, 1.0f);
+  cs.SampleFeatureSets({0, 0, 1}, &sets);
+  ASSERT_EQ(sets[0].data(), sets[1].data());
+  ASSERT_NE(sets[0].data(), sets[2].data());
+  ASSERT_EQ(sets[0].size(), 64);
+
+  // Node sampling, each node gets its own slice of the arena
+  cs.Init(n, feature_weights, 0.5f, 1.0f, 1.0f);
+  cs.SampleFeatureSets({0, 0}, &sets);
+  ASSERT_EQ(sets[0].size(), 64);
+  ASSERT_EQ(sets[1].size(), 64);
+  ASSERT_NE(std::vector<bst_feature_t>(sets[0].begin(), sets[0].end()),
+            std::vector<bst_feature_t>(sets[1].begin(), sets[1].end()));
+}
+
 // Test if different threads using the same seed produce the same result
 TEST(ColumnSampler, ThreadSynchronisation) {
   const int64_t num_threads = 100;
@@ -126,5 +157,71 @@ TEST(ColumnSampler, WeightedSampling) {
     EXPECT_NEAR(freq[i], feature_weights[i], 1e-2);
   }
 }
+
+TEST(PhiloxEngine, Determinism) {
+  PhiloxEngine a{42, 0};
+  PhiloxEngine b{42, 0};
+  for (size_t i = 0; i < 16; ++i) {
+    ASSERT_EQ(a(), b());
+  }
+  // discard is a constant-time jump to the same point of the sequence
+  PhiloxEngine c{42, 0};
+  c.discard(16);
+  ASSERT_EQ(a(), c());
+
+  // different streams and seeds yield different sequences
+  PhiloxEngine base{42, 0};
+  PhiloxEngine stream1{42, 1};
+  PhiloxEngine seed43{43, 0};
+  auto v = base();
+  ASSERT_NE(v, stream1());
+  ASSERT_NE(v, seed43());
+}
+
+TEST(StratifiedSampleRows, ThreadInvariant) {
+  size_t constexpr kRows = 1024;
+  std::vector<GradientPair> gpair(kRows, GradientPair{1.0f, 1.0f});
+  std::vector<bst_float> labels(kRows);
+  for (size_t i = 0; i < kRows; ++i) {
+    labels[i] = static_cast<bst_float>(i % 2);
+  }
+  // the per-row keys are counter based, so the selection must not depend on
+  // how many threads partition the pass
+  GlobalRandom().seed(7);
+  auto mask_serial = StratifiedSampleRows(gpair, labels, 0.5f, 1);
+  GlobalRandom().seed(7);
+  auto mask_parallel = StratifiedSampleRows(gpair, labels, 0.5f, 4);
+  ASSERT_EQ(mask_serial, mask_parallel);
+}
+
+TEST(StratifiedSampleRows, ExactClassFractions) {
+  size_t constexpr kRows = 4096;
+  float constexpr kSubsample = 0.25f;
+  std::vector<GradientPair> gpair(kRows, GradientPair{1.0f, 1.0f});
+  std::vector<bst_float> labels(kRows);
+  // a skewed three class problem
+  for (size_t i = 0; i < kRows; ++i) {
+    labels[i] = i % 8 == 0 ? 2.0f : (i % 2 == 0 ? 1.0f : 0.0f);
+  }
+  // rows with negative hessian must never be selected
+  gpair[3] = GradientPair{0.0f, -1.0f};
+
+  auto mask = StratifiedSampleRows(gpair, labels, kSubsample, 4);
+  ASSERT_EQ(mask.size(), kRows);
+  ASSERT_EQ(mask[3], 0);
+
+  std::vector<size_t> total(3, 0), sampled(3, 0);
+  for (size_t i = 0; i < kRows; ++i) {
+    if (gpair[i].GetHess() < 0.0f) {
+      continue;
+    }
+    auto c = static_cast<size_t>(labels[i]);
+    ++total[c];
+    sampled[c] += mask[i];
+  }
+  for (size_t c = 0; c < 3; ++c) {
+    ASSERT_EQ(sampled[c], static_cast<size_t>(total[c] * kSubsample));
+  }
+}
 }  // namespace common
 }  // namespace xgboost
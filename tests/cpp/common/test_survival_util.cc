@@ -32,6 +32,37 @@ inline static void RobustTestSuite(double y_lower, double y_upper, double sigma)
   }
 }
 
+template <typename Distribution>
+inline static void FusedTestSuite(double y_lower, double y_upper, double sigma) {
+  for (int i = 20; i >= -20; --i) {
+    const double y_pred = std::log(std::pow(10.0, static_cast<double>(i)));
+    double gradient, hessian;
+    AFTLoss<Distribution>::GradientAndHessian(y_lower, y_upper, y_pred, sigma,
+                                              &gradient, &hessian);
+    ASSERT_EQ(gradient, AFTLoss<Distribution>::Gradient(y_lower, y_upper, y_pred, sigma));
+    ASSERT_EQ(hessian, AFTLoss<Distribution>::Hessian(y_lower, y_upper, y_pred, sigma));
+  }
+}
+
+TEST(AFTLoss, FusedGradientHessian) {  // Single pass evaluation matches the separate ones
+  const double inf = std::numeric_limits<double>::infinity();
+  for (double sigma : {0.5, 2.0}) {
+    // uncensored, interval-, right- and left-censored rows
+    FusedTestSuite<NormalDistribution>(100.0, 100.0, sigma);
+    FusedTestSuite<NormalDistribution>(16.0, 200.0, sigma);
+    FusedTestSuite<NormalDistribution>(16.0, inf, sigma);
+    FusedTestSuite<NormalDistribution>(0.0, 200.0, sigma);
+    FusedTestSuite<LogisticDistribution>(100.0, 100.0, sigma);
+    FusedTestSuite<LogisticDistribution>(16.0, 200.0, sigma);
+    FusedTestSuite<LogisticDistribution>(16.0, inf, sigma);
+    FusedTestSuite<LogisticDistribution>(0.0, 200.0, sigma);
+    FusedTestSuite<ExtremeDistribution>(100.0, 100.0, sigma);
+    FusedTestSuite<ExtremeDistribution>(16.0, 200.0, sigma);
+    FusedTestSuite<ExtremeDistribution>(16.0, inf, sigma);
+    FusedTestSuite<ExtremeDistribution>(0.0, 200.0, sigma);
+  }
+}
+
 TEST(AFTLoss, RobustGradientPair) {  // Ensure that INF and NAN don't show up in gradient pair
   RobustTestSuite<NormalDistribution>(16.0, 200.0, 2.0);
   RobustTestSuite<LogisticDistribution>(16.0, 200.0, 2.0);
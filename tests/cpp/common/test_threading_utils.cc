@@ -27,6 +27,41 @@ TEST(CreateBlockedSpace2d, Test) {
   }
 }
 
+TEST(CreateBlockedSpace2dWeighted, Test) {
+  // two 'rows': one long-tailed, one uniform
+  std::vector<std::vector<size_t>> weights {
+      {1, 1, 1, 1, 100, 1, 1}, {2, 2, 2, 2}};
+  constexpr size_t kGrain = 4;
+
+  BlockedSpace2d space(weights.size(),
+                       [&](size_t i) { return weights[i].size(); },
+                       [&](size_t i, size_t j) { return weights[i][j]; },
+                       kGrain);
+
+  // blocks cover each row in order without gaps, and each block is either
+  // a single heavy element or carries at least kGrain of weight unless it
+  // is the tail of its row
+  std::vector<size_t> covered(weights.size(), 0);
+  for (size_t block = 0; block < space.Size(); ++block) {
+    const size_t i = space.GetFirstDimension(block);
+    const auto range = space.GetRange(block);
+    ASSERT_EQ(range.begin(), covered[i]);
+    covered[i] = range.end();
+
+    size_t weight = 0;
+    for (size_t j = range.begin(); j < range.end(); ++j) {
+      weight += weights[i][j];
+    }
+    if (range.end() != weights[i].size()) {
+      ASSERT_GE(weight, kGrain);
+    }
+    ASSERT_LT(weight - weights[i][range.end() - 1], kGrain);
+  }
+  for (size_t i = 0; i < weights.size(); ++i) {
+    ASSERT_EQ(covered[i], weights[i].size());
+  }
+}
+
 TEST(ParallelFor2d, Test) {
   constexpr size_t kDim1 = 100;
   constexpr size_t kDim2 = 15;
@@ -105,5 +140,32 @@ TEST(OmpSetNumThreads, Basic) {
   omp_set_num_threads(orgi);
 }
 #endif  // defined(_OPENMP)
+
+TEST(PhaseThreadBudget, SettlesOnBestCandidate) {
+  PhaseThreadBudget budget;
+  budget.SetMaxThreads(8);  // candidates: 8, 6, 4, 2
+  // feed identical work with the 4-thread candidate fastest; three trials
+  // per candidate
+  for (int trial = 0; trial < 12; ++trial) {
+    const int32_t threads = budget.Threads(1000);
+    budget.Observe(1000, threads == 4 ? 0.5 : 1.0);
+  }
+  ASSERT_EQ(budget.Threads(1000), 4);
+  // further observations must not unsettle the choice
+  budget.Observe(1000, 10.0);
+  ASSERT_EQ(budget.Threads(1000), 4);
+}
+
+TEST(PhaseThreadBudget, ClampsSmallWork) {
+  PhaseThreadBudget budget{100};
+  budget.SetMaxThreads(1);  // single candidate settles immediately
+  ASSERT_EQ(budget.Threads(1000), 1);
+
+  PhaseThreadBudget wide{100};
+  wide.SetMaxThreads(16);
+  ASSERT_EQ(wide.Threads(350), 3);
+  ASSERT_EQ(wide.Threads(0), 1);
+}
+
 }  // namespace common
 }  // namespace xgboost
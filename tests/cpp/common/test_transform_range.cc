@@ -50,6 +50,26 @@ TEST(Transform, DeclareUnifiedTest(Basic)) {
   ASSERT_TRUE(std::equal(h_sol.begin(), h_sol.end(), res.begin()));
 }
 
+// a size that is neither a multiple of the unroll factor nor of the thread
+// count, exercising the remainder of the blocked CPU loop
+TEST(Transform, DeclareUnifiedTest(OddSize)) {
+  const size_t size {77};
+  std::vector<bst_float> h_in(size);
+  std::iota(h_in.begin(), h_in.end(), 0);
+
+  const HostDeviceVector<bst_float> in_vec{h_in, TRANSFORM_GPU};
+  HostDeviceVector<bst_float> out_vec{std::vector<bst_float>(size), TRANSFORM_GPU};
+  out_vec.Fill(0);
+
+  Transform<>::Init(TestTransformRange<bst_float>{},
+                    Range{0, static_cast<Range::DifferenceType>(size)},
+                    TRANSFORM_GPU)
+      .Eval(&out_vec, &in_vec);
+
+  ASSERT_TRUE(std::equal(h_in.begin(), h_in.end(),
+                         out_vec.HostVector().begin()));
+}
+
 #if !defined(__CUDACC__)
 TEST(TransformDeathTest, Exception) {
   size_t const kSize {16};
@@ -68,6 +68,43 @@ TEST(Adapter, CSCAdapterColsMoreThanRows) {
   EXPECT_EQ(inst[3].index, 3);
 }
 
+TEST(Adapter, ColumnarAdapter) {
+  std::vector<float> col0 = {1, 2, 3, 4};
+  std::vector<double> col1 = {5, 6, 7, 8};
+  std::vector<void const*> columns = {col0.data(), col1.data()};
+  std::vector<const char*> types = {"float32", "float64"};
+  // Rows 1 and 3 of the second column are masked out.
+  std::vector<uint8_t> col1_validity = {0b00000101};
+  std::vector<uint8_t const*> validity = {nullptr, col1_validity.data()};
+  data::ColumnarAdapter adapter(columns.data(), types.data(), validity.data(),
+                                col0.size(), columns.size());
+  data::SimpleDMatrix dmat(&adapter, std::numeric_limits<float>::quiet_NaN(),
+                           -1);
+  EXPECT_EQ(dmat.Info().num_row_, 4);
+  EXPECT_EQ(dmat.Info().num_col_, 2);
+  EXPECT_EQ(dmat.Info().num_nonzero_, 6);
+
+  auto& batch = *dmat.GetBatches<SparsePage>().begin();
+  auto inst = batch[0];
+  EXPECT_EQ(inst.size(), 2);
+  EXPECT_EQ(inst[0].fvalue, 1);
+  EXPECT_EQ(inst[1].fvalue, 5);
+  EXPECT_EQ(inst[1].index, 1);
+
+  inst = batch[1];
+  EXPECT_EQ(inst.size(), 1);
+  EXPECT_EQ(inst[0].fvalue, 2);
+  EXPECT_EQ(inst[0].index, 0);
+
+  inst = batch[2];
+  EXPECT_EQ(inst.size(), 2);
+  EXPECT_EQ(inst[1].fvalue, 7);
+
+  inst = batch[3];
+  EXPECT_EQ(inst.size(), 1);
+  EXPECT_EQ(inst[0].fvalue, 4);
+}
+
 // A mock for JVM data iterator.
 class CSRIterForTest {
   std::vector<float> data_ {1, 2, 3, 4, 5};
@@ -85,6 +85,40 @@ TEST(SparsePage, PushCSCAfterTranspose) {
   }
 }
 
+TEST(SparsePage, BuildFeatureIndex) {
+  // two rows over four features: row 0 = {0, 2}, row 1 = {0, 1, 3}
+  SparsePage page;
+  page.offset.HostVector() = {0, 2, 5};
+  page.data.HostVector() = {Entry(0, 1.0f), Entry(2, 2.0f), Entry(0, 3.0f),
+                            Entry(1, 4.0f), Entry(3, 5.0f)};
+  const int kCols = 4;
+
+  page.BuildFeatureIndex(kCols);
+  const std::vector<size_t> expected {2, 1, 1, 1};
+  ASSERT_EQ(page.feature_counts, expected);
+
+  // the transpose takes its column offsets from the index
+  SparsePage transpose = page.GetTranspose(kCols);
+  const auto& rptr = transpose.offset.HostVector();
+  ASSERT_EQ(rptr.size(), 5ul);
+  for (int j = 0; j < kCols; ++j) {
+    ASSERT_EQ(rptr[j + 1] - rptr[j], expected[j]);
+  }
+  ASSERT_EQ(transpose[0].size(), 2ul);
+  ASSERT_EQ(transpose[0][0].index, 0u);  // row ids, sorted
+  ASSERT_EQ(transpose[0][1].index, 1u);
+  ASSERT_EQ(transpose[3][0].fvalue, 5.0f);
+
+  // pushing more rows invalidates the index
+  SparsePage other;
+  other.offset.HostVector() = {0, 1};
+  other.data.HostVector() = {Entry(1, 6.0f)};
+  page.Push(other);
+  ASSERT_TRUE(page.feature_counts.empty());
+  page.BuildFeatureIndex(kCols);
+  ASSERT_EQ(page.feature_counts[1], 2ul);
+}
+
 TEST(DMatrix, Uri) {
   size_t constexpr kRows {16};
   size_t constexpr kCols {8};
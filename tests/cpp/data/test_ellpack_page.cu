@@ -3,6 +3,7 @@
  */
 #include <xgboost/base.h>
 
+#include <limits>
 #include <utility>
 
 #include "../helpers.h"
@@ -11,6 +12,7 @@
 
 #include "../../../src/common/categorical.h"
 #include "../../../src/common/hist_util.h"
+#include "../../../src/data/adapter.h"
 #include "../../../src/data/ellpack_page.cuh"
 
 namespace xgboost {
@@ -133,6 +135,51 @@ struct ReadRowFunction {
   }
 };
 
+TEST(EllpackPage, OverflowSection) {
+  constexpr size_t kRows = 1000, kCols = 32;
+  constexpr int kMaxBin = 16;
+  // Every row carries two features, except one outlier row with all of them,
+  // which would otherwise inflate the stride of the whole page.
+  std::vector<float> x(kRows * kCols, std::numeric_limits<float>::quiet_NaN());
+  for (size_t i = 0; i < kRows; ++i) {
+    x[i * kCols] = static_cast<float>(i % 16);
+    x[i * kCols + 1] = static_cast<float>((i * 7) % 16);
+  }
+  for (size_t j = 0; j < kCols; ++j) {
+    x[j] = static_cast<float>(j % 16);
+  }
+  data::DenseAdapter adapter(x.data(), kRows, kCols);
+  std::shared_ptr<DMatrix> dmat(DMatrix::Create(
+      &adapter, std::numeric_limits<float>::quiet_NaN(), 1));
+
+  auto& page = *dmat->GetBatches<EllpackPage>({0, kMaxBin}).begin();
+  auto impl = page.Impl();
+  ASSERT_EQ(impl->row_stride, 2);
+  ASSERT_EQ(impl->OverflowSize(), kCols - 2);
+  auto const& overflow_ptr = impl->overflow_row_ptr.ConstHostVector();
+  ASSERT_EQ(overflow_ptr.size(), kRows + 1);
+  ASSERT_EQ(overflow_ptr[1], kCols - 2);  // only the first row overflows
+  ASSERT_EQ(overflow_ptr.back(), kCols - 2);
+
+  // All elements, including the overflow tail, must be readable through the
+  // device accessor.
+  thrust::device_vector<bst_float> row_d(kCols);
+  std::vector<bst_float> row(kCols);
+  for (auto ridx : {size_t(0), kRows / 2}) {
+    dh::LaunchN(0, kCols,
+                ReadRowFunction(impl->GetDeviceAccessor(0), ridx,
+                                row_d.data().get()));
+    thrust::copy(row_d.begin(), row_d.end(), row.begin());
+    for (size_t j = 0; j < kCols; ++j) {
+      if (std::isnan(x[ridx * kCols + j])) {
+        ASSERT_EQ(row[j], -1) << "ridx: " << ridx << " j: " << j;
+      } else {
+        ASSERT_NE(row[j], -1) << "ridx: " << ridx << " j: " << j;
+      }
+    }
+  }
+}
+
 TEST(EllpackPage, Copy) {
   constexpr size_t kRows = 1024;
   constexpr size_t kCols = 16;
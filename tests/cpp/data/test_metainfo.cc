@@ -39,6 +39,26 @@ TEST(MetaInfo, GetSet) {
   ASSERT_EQ(info.group_ptr_.size(), 0);
 }
 
+TEST(MetaInfo, PackedLabels) {
+  xgboost::MetaInfo info;
+  float binary[37];
+  for (size_t i = 0; i < 37; ++i) {
+    binary[i] = i % 3 == 0 ? 1.0f : 0.0f;
+  }
+  info.SetInfo("label", binary, xgboost::DataType::kFloat32, 37);
+
+  auto const& packed = info.TryPackedLabels();
+  ASSERT_EQ(packed.size(), 2ul);
+  for (size_t i = 0; i < 37; ++i) {
+    EXPECT_EQ((packed[i / 32] >> (i % 32)) & 1u, i % 3 == 0 ? 1u : 0u);
+  }
+
+  // replacing the labels invalidates the cache
+  float continuous[2] = {0.5f, 1.5f};
+  info.SetInfo("label", continuous, xgboost::DataType::kFloat32, 2);
+  ASSERT_TRUE(info.TryPackedLabels().empty());
+}
+
 TEST(MetaInfo, GetSetFeature) {
   xgboost::MetaInfo info;
   EXPECT_THROW(info.SetFeatureInfo("", nullptr, 0), dmlc::Error);
@@ -202,6 +222,29 @@ TEST(MetaInfo, LoadQid) {
   }
 }
 
+TEST(MetaInfo, SetGroupPtrFromQids) {
+  xgboost::MetaInfo info;
+  const std::vector<uint64_t> qids{1, 1, 2, 2, 2, 3};
+  info.SetGroupPtrFromQids(qids, 1);
+  const std::vector<xgboost::bst_group_t> expected{0, 2, 5, 6};
+  ASSERT_EQ(info.group_ptr_, expected);
+
+  // boundary detection is chunked, the result must not depend on the
+  // number of threads
+  xgboost::MetaInfo parallel;
+  parallel.SetGroupPtrFromQids(qids, 4);
+  ASSERT_EQ(parallel.group_ptr_, expected);
+
+  // a single query forms a single group
+  xgboost::MetaInfo single;
+  single.SetGroupPtrFromQids({7, 7, 7}, 2);
+  ASSERT_EQ(single.group_ptr_, (std::vector<xgboost::bst_group_t>{0, 3}));
+
+  xgboost::MetaInfo empty;
+  empty.SetGroupPtrFromQids({}, 2);
+  ASSERT_TRUE(empty.group_ptr_.empty());
+}
+
 TEST(MetaInfo, Validate) {
   xgboost::MetaInfo info;
   info.num_row_ = 10;
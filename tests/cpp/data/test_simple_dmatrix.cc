@@ -3,6 +3,7 @@
 #include <xgboost/data.h>
 
 #include <array>
+#include <fstream>
 #include "xgboost/base.h"
 #include "../../../src/data/simple_dmatrix.h"
 #include "../../../src/data/adapter.h"
@@ -284,6 +285,30 @@ TEST(SimpleDMatrix, Slice) {
   ASSERT_EQ(out->Info().num_nonzero_, ridxs.size() * kCols);  // dense
 }
 
+TEST(SimpleDMatrix, SliceContiguous) {
+  // contiguous ascending ranges take the bulk-copy fast path
+  size_t constexpr kRows{16};
+  size_t constexpr kCols{8};
+  auto p_m = RandomDataGenerator{kRows, kCols, 0}.GenerateDMatrix(true);
+  std::array<int32_t, 4> ridxs{4, 5, 6, 7};
+  std::unique_ptr<DMatrix> out{p_m->Slice(ridxs)};
+  ASSERT_EQ(out->Info().num_row_, ridxs.size());
+  for (auto const& in_page : p_m->GetBatches<SparsePage>()) {
+    for (auto const& out_page : out->GetBatches<SparsePage>()) {
+      for (size_t i = 0; i < ridxs.size(); ++i) {
+        auto out_inst = out_page[i];
+        auto in_inst = in_page[ridxs[i]];
+        ASSERT_EQ(out_inst.size(), in_inst.size()) << i;
+        for (size_t j = 0; j < in_inst.size(); ++j) {
+          ASSERT_EQ(in_inst[j].fvalue, out_inst[j].fvalue);
+          ASSERT_EQ(in_inst[j].index, out_inst[j].index);
+        }
+      }
+    }
+  }
+  ASSERT_EQ(out->Info().num_nonzero_, ridxs.size() * kCols);  // dense
+}
+
 TEST(SimpleDMatrix, SaveLoadBinary) {
   dmlc::TemporaryDirectory tempdir;
   const std::string tmp_file = tempdir.path + "/simple.libsvm";
@@ -313,3 +338,76 @@ TEST(SimpleDMatrix, SaveLoadBinary) {
   delete dmat;
   delete dmat_read;
 }
+
+TEST(SimpleDMatrix, SaveLoadCompactBinary) {
+  dmlc::TemporaryDirectory tempdir;
+  const std::string tmp_file = tempdir.path + "/simple.libsvm";
+  CreateSimpleTestData(tmp_file);
+  xgboost::DMatrix* dmat = xgboost::DMatrix::Load(tmp_file, true, false);
+  data::SimpleDMatrix* simple_dmat = dynamic_cast<data::SimpleDMatrix*>(dmat);
+
+  const std::string raw_binfile = tempdir.path + "/raw.binary";
+  simple_dmat->SaveToLocalFile(raw_binfile);
+
+  const std::string compact_binfile = tempdir.path + "/compact.binary";
+  setenv("XGBOOST_COMPACT_BINARY", "1", 1);
+  simple_dmat->SaveToLocalFile(compact_binfile);
+  unsetenv("XGBOOST_COMPACT_BINARY");
+
+  auto file_size = [](const std::string& path) {
+    std::ifstream fin(path, std::ios::binary | std::ios::ate);
+    return static_cast<size_t>(fin.tellg());
+  };
+  ASSERT_LT(file_size(compact_binfile), file_size(raw_binfile));
+
+  // loading dispatches on the magic without the environment variable set
+  xgboost::DMatrix* dmat_read = xgboost::DMatrix::Load(compact_binfile, true, false);
+  ASSERT_EQ(dmat->Info().num_col_, dmat_read->Info().num_col_);
+  ASSERT_EQ(dmat->Info().num_row_, dmat_read->Info().num_row_);
+  ASSERT_EQ(dmat->Info().num_nonzero_, dmat_read->Info().num_nonzero_);
+
+  auto row_iter = dmat->GetBatches<xgboost::SparsePage>().begin();
+  auto row_iter_read = dmat_read->GetBatches<xgboost::SparsePage>().begin();
+  auto batch = (*row_iter).GetView();
+  auto batch_read = (*row_iter_read).GetView();
+  for (size_t i = 0; i < dmat->Info().num_row_; ++i) {
+    auto row = batch[i];
+    auto row_read = batch_read[i];
+    ASSERT_EQ(row.size(), row_read.size());
+    for (size_t j = 0; j < row.size(); ++j) {
+      ASSERT_EQ(row[j].index, row_read[j].index);
+      ASSERT_EQ(row[j].fvalue, row_read[j].fvalue);
+    }
+  }
+  delete dmat;
+  delete dmat_read;
+}
+
+TEST(SimpleDMatrix, SortedPageCache) {
+  dmlc::TemporaryDirectory tempdir;
+  const std::string tmp_file = tempdir.path + "/simple.libsvm";
+  CreateSimpleTestData(tmp_file);
+  xgboost::DMatrix* dmat = xgboost::DMatrix::Load(tmp_file, true, false);
+  data::SimpleDMatrix* simple_dmat = dynamic_cast<data::SimpleDMatrix*>(dmat);
+
+  const std::string tmp_binfile = tempdir.path + "/csr_source.binary";
+  simple_dmat->SaveToLocalFile(tmp_binfile);
+  // first access builds the page and writes it next to the binary matrix
+  const auto& built = *dmat->GetBatches<xgboost::SortedCSCPage>().begin();
+  const auto built_offset = built.offset.HostVector();
+  const auto built_data = built.data.HostVector();
+
+  ASSERT_TRUE(FileExists(tmp_binfile + ".sorted.col.page"));
+
+  // a matrix loaded from the binary file reads the sorted page back in
+  xgboost::DMatrix* dmat_read = xgboost::DMatrix::Load(tmp_binfile, true, false);
+  const auto& loaded = *dmat_read->GetBatches<xgboost::SortedCSCPage>().begin();
+  ASSERT_EQ(loaded.offset.HostVector(), built_offset);
+  ASSERT_EQ(loaded.data.HostVector().size(), built_data.size());
+  for (size_t i = 0; i < built_data.size(); ++i) {
+    ASSERT_EQ(loaded.data.HostVector()[i].index, built_data[i].index);
+    ASSERT_EQ(loaded.data.HostVector()[i].fvalue, built_data[i].fvalue);
+  }
+  delete dmat;
+  delete dmat_read;
+}
@@ -1,5 +1,6 @@
 // Copyright by Contributors
 #include <dmlc/filesystem.h>
+#include <dmlc/memory_io.h>
 #include <gtest/gtest.h>
 #include <xgboost/data.h>
 #include <thread>
@@ -7,6 +8,7 @@
 #include "../../../src/common/io.h"
 #include "../../../src/data/adapter.h"
 #include "../../../src/data/sparse_page_dmatrix.h"
+#include "../../../src/data/sparse_page_writer.h"
 #include "../helpers.h"
 
 using namespace xgboost;  // NOLINT
@@ -45,6 +47,59 @@ TEST(SparsePageDMatrix, RowAccess) {
   EXPECT_EQ(first_row[2].fvalue, 20);
 }
 
+TEST(SparsePageDMatrix, FilteredRowBatches) {
+  dmlc::TemporaryDirectory tmpdir;
+  std::string filename = tmpdir.path + "/big.libsvm";
+  std::unique_ptr<xgboost::DMatrix> dmat =
+      xgboost::CreateSparsePageDMatrix(96, 8, filename);
+
+  // record the row range and offsets of every page from a full scan
+  std::vector<std::pair<size_t, size_t>> ranges;
+  std::vector<std::vector<xgboost::bst_row_t>> offsets;
+  for (auto const& batch : dmat->GetBatches<xgboost::SparsePage>()) {
+    ranges.emplace_back(batch.base_rowid, batch.base_rowid + batch.Size());
+    offsets.push_back(batch.offset.ConstHostVector());
+  }
+  ASSERT_GE(ranges.size(), 3ul);
+
+  // select the rows of a middle page only; the pages on both sides must be
+  // skipped while the returned page keeps its unfiltered base row id
+  size_t const target = ranges.size() / 2;
+  auto const want = ranges[target];
+  size_t n_batches = 0;
+  for (auto const& batch : dmat->GetRowBatches(
+           [&want](size_t begin, size_t end) {
+             return begin < want.second && want.first < end;
+           })) {
+    EXPECT_EQ(batch.base_rowid, want.first);
+    EXPECT_EQ(batch.Size(), want.second - want.first);
+    EXPECT_EQ(batch.offset.ConstHostVector(), offsets[target]);
+    ++n_batches;
+  }
+  ASSERT_EQ(n_batches, 1ul);
+
+  // a predicate accepting every range returns the full scan
+  n_batches = 0;
+  size_t n_rows = 0;
+  for (auto const& batch :
+       dmat->GetRowBatches([](size_t, size_t) { return true; })) {
+    EXPECT_EQ(batch.base_rowid, ranges[n_batches].first);
+    n_rows += batch.Size();
+    ++n_batches;
+  }
+  ASSERT_EQ(n_batches, ranges.size());
+  ASSERT_EQ(n_rows, dmat->Info().num_row_);
+
+  // rejecting every range yields an empty batch set
+  n_batches = 0;
+  for (auto const& batch :
+       dmat->GetRowBatches([](size_t, size_t) { return false; })) {
+    (void)batch;
+    ++n_batches;
+  }
+  ASSERT_EQ(n_batches, 0ul);
+}
+
 TEST(SparsePageDMatrix, ColAccess) {
   dmlc::TemporaryDirectory tempdir;
   const std::string tmp_file = tempdir.path + "/simple.libsvm";
@@ -377,3 +432,37 @@ TEST(SparsePageDMatrix, Determinism) {
     ASSERT_EQ(caches[i], caches.front());
   }
 }
+
+TEST(SparsePageDMatrix, CompressedPageFormat) {
+  auto p_m = RandomDataGenerator{256, 32, 0.6}.GenerateDMatrix();
+  for (auto const& page : p_m->GetBatches<SparsePage>()) {
+    std::string raw_buffer;
+    {
+      std::unique_ptr<data::SparsePageFormat<SparsePage>> raw{
+          data::CreatePageFormat<SparsePage>("raw")};
+      dmlc::MemoryStringStream fo(&raw_buffer);
+      raw->Write(page, &fo);
+    }
+    std::unique_ptr<data::SparsePageFormat<SparsePage>> fmt{
+        data::CreatePageFormat<SparsePage>("compress")};
+    std::string compressed_buffer;
+    {
+      dmlc::MemoryStringStream fo(&compressed_buffer);
+      fmt->Write(page, &fo);
+    }
+    // the index stream shrinks to varints, everything else stays exact
+    ASSERT_LT(compressed_buffer.size(), raw_buffer.size());
+
+    SparsePage read_page;
+    dmlc::MemoryStringStream fi(&compressed_buffer);
+    ASSERT_TRUE(fmt->Read(&read_page, &fi));
+    ASSERT_EQ(read_page.offset.HostVector(), page.offset.HostVector());
+    auto const& in_data = page.data.HostVector();
+    auto const& out_data = read_page.data.HostVector();
+    ASSERT_EQ(in_data.size(), out_data.size());
+    for (size_t i = 0; i < in_data.size(); ++i) {
+      ASSERT_EQ(in_data[i].index, out_data[i].index);
+      ASSERT_EQ(in_data[i].fvalue, out_data[i].fvalue);
+    }
+  }
+}
@@ -3,12 +3,14 @@
  */
 #include <gtest/gtest.h>
 #include <dmlc/filesystem.h>
+#include <dmlc/memory_io.h>
 #include <xgboost/generic_parameters.h>
 
 #include "xgboost/base.h"
 #include "xgboost/host_device_vector.h"
 #include "xgboost/learner.h"
 #include "../helpers.h"
+#include "../../../src/common/bitfield.h"
 #include "../../../src/gbm/gbtree.h"
 #include "xgboost/predictor.h"
 
@@ -69,6 +71,225 @@ TEST(GBTree, WrongUpdater) {
   ASSERT_THROW(learner->UpdateOneIter(0, p_dmat), dmlc::Error);
 }
 
+TEST(GBTree, RefreshEpoch) {
+  size_t constexpr kRows = 64;
+  size_t constexpr kCols = 8;
+  int32_t constexpr kIters = 4;
+
+  auto p_dmat = RandomDataGenerator(kRows, kCols, 0).GenerateDMatrix(true);
+  auto learner = std::unique_ptr<Learner>(Learner::Create({p_dmat}));
+  learner->SetParams(Args{{"tree_method", "hist"}});
+  for (int32_t i = 0; i < kIters; ++i) {
+    learner->UpdateOneIter(i, p_dmat);
+  }
+  Json model {Object()};
+  learner->SaveModel(&model);
+
+  auto get_num_trees = [](Json const& m) {
+    auto const& shape =
+        get<Object const>(m["learner"]["gradient_booster"]["model"]["gbtree_model_param"]);
+    return get<String const>(shape.at("num_trees"));
+  };
+
+  auto refreshed = std::unique_ptr<Learner>(Learner::Create({p_dmat}));
+  refreshed->LoadModel(model);
+  refreshed->SetParams(
+      Args{{"tree_method", "hist"}, {"process_type", "refresh_epoch"}});
+  // the first iteration refreshes all existing trees in a single pass
+  refreshed->UpdateOneIter(0, p_dmat);
+  Json out {Object()};
+  refreshed->SaveModel(&out);
+  ASSERT_EQ(get_num_trees(out), std::to_string(kIters));
+  // later iterations grow new trees on top of the refreshed model
+  refreshed->UpdateOneIter(1, p_dmat);
+  out = Json{Object()};
+  refreshed->SaveModel(&out);
+  ASSERT_EQ(get_num_trees(out), std::to_string(kIters + 1));
+}
+
+TEST(GBTree, ColumnarModelIO) {
+  LearnerModelParam mparam;
+  mparam.base_score = 0.5;
+  mparam.num_feature = 2;
+  mparam.num_output_group = 1;
+
+  gbm::GBTreeModel model(&mparam);
+  {
+    std::vector<std::shared_ptr<RegTree>> trees;
+    trees.push_back(std::make_shared<RegTree>());
+    trees.back()->ExpandNode(0, 0, 0.5f, true, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f,
+                             0.0f, 0.0f);
+    model.CommitModel(std::move(trees), 0);
+  }
+  {
+    std::vector<std::shared_ptr<RegTree>> trees;
+    trees.push_back(std::make_shared<RegTree>());
+    (*trees.back())[0].SetLeaf(1.5f);
+    model.CommitModel(std::move(trees), 0);
+  }
+
+  std::string buffer;
+  dmlc::MemoryStringStream fo(&buffer);
+  model.SaveColumnar(&fo);
+
+  gbm::GBTreeModel loaded(&mparam);
+  dmlc::MemoryStringStream fi(&buffer);
+  loaded.Load(&fi);  // detected through the columnar magic
+
+  ASSERT_EQ(loaded.param.num_trees, 2);
+  ASSERT_EQ(loaded.tree_info, model.tree_info);
+  for (int32_t i = 0; i < loaded.param.num_trees; ++i) {
+    ASSERT_TRUE(*loaded.trees[i] == *model.trees[i]);
+  }
+}
+
+TEST(GBTree, FeatureImportance) {
+  LearnerModelParam mparam;
+  mparam.base_score = 0.5;
+  mparam.num_feature = 3;
+  mparam.num_output_group = 1;
+
+  gbm::GBTreeModel model(&mparam);
+  {
+    std::vector<std::shared_ptr<RegTree>> trees;
+    trees.push_back(std::make_shared<RegTree>());
+    auto& tree = *trees.back();
+    // root splits on f0 with gain 4 and cover 10, its left child on f2
+    tree.ExpandNode(0, 0, 0.5f, true, 0.0f, -1.0f, 1.0f, 4.0f, 10.0f, 6.0f,
+                    4.0f);
+    tree.ExpandNode(tree[0].LeftChild(), 2, 0.5f, true, 0.0f, -1.0f, 1.0f,
+                    1.0f, 6.0f, 3.0f, 3.0f);
+    model.CommitModel(std::move(trees), 0);
+  }
+  {
+    std::vector<std::shared_ptr<RegTree>> trees;
+    trees.push_back(std::make_shared<RegTree>());
+    trees.back()->ExpandNode(0, 0, 0.5f, true, 0.0f, -1.0f, 1.0f, 2.0f, 8.0f,
+                             4.0f, 4.0f);
+    model.CommitModel(std::move(trees), 0);
+  }
+
+  std::vector<bst_float> scores;
+  model.FeatureImportance("weight", &scores);
+  ASSERT_EQ(scores, (std::vector<bst_float>{2.0f, 0.0f, 1.0f}));
+  model.FeatureImportance("total_gain", &scores);
+  ASSERT_EQ(scores, (std::vector<bst_float>{6.0f, 0.0f, 1.0f}));
+  model.FeatureImportance("gain", &scores);
+  ASSERT_EQ(scores, (std::vector<bst_float>{3.0f, 0.0f, 1.0f}));
+  model.FeatureImportance("total_cover", &scores);
+  ASSERT_EQ(scores, (std::vector<bst_float>{18.0f, 0.0f, 6.0f}));
+  model.FeatureImportance("cover", &scores);
+  ASSERT_EQ(scores, (std::vector<bst_float>{9.0f, 0.0f, 6.0f}));
+  ASSERT_THROW(model.FeatureImportance("leaf", &scores), dmlc::Error);
+}
+
+TEST(GBTree, CompactTreeLayout) {
+  RegTree tree;
+  // f0 < 0.5, default left; left child splits again on f1 < 0.5
+  tree.ExpandNode(0, 0, 0.5f, true, 0.0f, 0.0f, 3.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+  tree.ExpandNode(tree[0].LeftChild(), 1, 0.5f, false, 0.0f, -1.0f, 1.0f, 0.0f,
+                  0.0f, 0.0f, 0.0f);
+  gbm::CompactTree flat{tree};
+  ASSERT_FALSE(flat.Empty());
+
+  auto predict = [](gbm::CompactTree const& flat, RegTree::FVec const& feat) {
+    bst_node_t nid = 0;
+    while (!flat.IsLeaf(nid)) {
+      auto split = flat.SplitIndex(nid);
+      nid = flat.Next<true>(nid, feat.GetFvalue(split), feat.IsMissing(split));
+    }
+    return flat.LeafValue(nid);
+  };
+
+  RegTree::FVec feat;
+  feat.Init(2);
+  for (auto const& row : std::vector<std::vector<Entry>>{
+           {{0, 0.0f}, {1, 0.0f}},
+           {{0, 0.0f}, {1, 1.0f}},
+           {{0, 1.0f}, {1, 0.0f}},
+           {{1, 0.0f}}}) {  // f0 missing, takes the default direction
+    feat.Fill({row.data(), row.size()});
+    bst_float expected = tree[tree.GetLeafIndex(feat)].LeafValue();
+    ASSERT_EQ(predict(flat, feat), expected);
+    feat.Drop({row.data(), row.size()});
+  }
+}
+
+TEST(GBTree, CompactTreeReducedPrecision) {
+  RegTree tree;
+  // leaf values and the threshold carry more mantissa bits than bfloat16 keeps
+  tree.ExpandNode(0, 0, 0.123456f, true, 0.0f, 1.234567f, -7.654321f, 0.0f,
+                  0.0f, 0.0f, 0.0f);
+  gbm::CompactTree exact{tree};
+  gbm::CompactTree rounded{tree, /*reduced_precision=*/true};
+  ASSERT_FALSE(rounded.Empty());
+
+  // leaves round to the nearest bfloat16 and the delta is tracked
+  bst_float max_delta = 0.0f;
+  for (bst_node_t nid : {1, 2}) {
+    bst_float const v = rounded.LeafValue(nid);
+    ASSERT_EQ(v, gbm::CompactTree::DecodeBF16(
+                     gbm::CompactTree::EncodeBF16(exact.LeafValue(nid))));
+    ASSERT_NEAR(v, exact.LeafValue(nid), std::abs(exact.LeafValue(nid)) / 128);
+    max_delta = std::max(max_delta, std::abs(v - exact.LeafValue(nid)));
+  }
+  ASSERT_EQ(rounded.MaxLeafDelta(), max_delta);
+
+  // values away from the rounded threshold keep their direction
+  ASSERT_EQ(rounded.Next<false>(0, 0.0f, false), exact.Next<false>(0, 0.0f, false));
+  ASSERT_EQ(rounded.Next<false>(0, 1.0f, false), exact.Next<false>(0, 1.0f, false));
+}
+
+TEST(GBTree, CompactTreeCategorical) {
+  RegTree tree;
+  bst_cat_t cat = 42;
+  std::vector<uint32_t> split_cats(LBitField32::ComputeStorageSize(cat + 1));
+  LBitField32 bits{split_cats};
+  bits.Set(cat);
+  tree.ExpandCategorical(0, 0, split_cats, /*default_left=*/true, 0.0f, -1.0f,
+                         1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+  gbm::CompactTree flat{tree};
+  ASSERT_FALSE(flat.Empty());
+  // the branchless complete-tree path is numeric only
+  ASSERT_EQ(flat.CompleteDepth(), 0);
+
+  // the matching category goes right, any other left, even past the bitset;
+  // missing values take the default direction
+  ASSERT_EQ(flat.LeafValue(flat.Next<true>(0, 42.0f, false)), 1.0f);
+  ASSERT_EQ(flat.LeafValue(flat.Next<true>(0, 7.0f, false)), -1.0f);
+  ASSERT_EQ(flat.LeafValue(flat.Next<true>(0, 1024.0f, false)), -1.0f);
+  ASSERT_EQ(flat.LeafValue(flat.Next<true>(0, 0.0f, true)), -1.0f);
+}
+
+TEST(GBTree, CompactTreeCompleteDepth) {
+  {
+    // perfect depth-2 tree: heap layout, children of node i at 2i+1 / 2i+2
+    RegTree tree;
+    tree.ExpandNode(0, 0, 0.5f, true, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+    tree.ExpandNode(tree[0].LeftChild(), 1, 0.5f, true, 0.0f, -1.0f, 1.0f, 0.0f,
+                    0.0f, 0.0f, 0.0f);
+    tree.ExpandNode(tree[0].RightChild(), 1, 0.5f, true, 0.0f, -2.0f, 2.0f, 0.0f,
+                    0.0f, 0.0f, 0.0f);
+    gbm::CompactTree flat{tree};
+    ASSERT_EQ(flat.CompleteDepth(), 2);
+    for (bst_node_t nid = 0; nid < 3; ++nid) {
+      ASSERT_FALSE(flat.IsLeaf(nid));
+    }
+    for (bst_node_t nid = 3; nid < 7; ++nid) {
+      ASSERT_TRUE(flat.IsLeaf(nid));
+    }
+  }
+  {
+    // unbalanced tree: not classified as complete
+    RegTree tree;
+    tree.ExpandNode(0, 0, 0.5f, true, 0.0f, 0.0f, 3.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+    tree.ExpandNode(tree[0].LeftChild(), 1, 0.5f, false, 0.0f, -1.0f, 1.0f, 0.0f,
+                    0.0f, 0.0f, 0.0f);
+    gbm::CompactTree flat{tree};
+    ASSERT_EQ(flat.CompleteDepth(), 0);
+  }
+}
+
 #ifdef XGBOOST_USE_CUDA
 TEST(GBTree, ChoosePredictor) {
   // The test ensures data don't get pulled into device.
@@ -348,4 +569,49 @@ TEST(Dart, Slice) {
   auto const& trees = get<Array const>(model["learner"]["gradient_booster"]["gbtree"]["model"]["trees"]);
   ASSERT_EQ(weights.size(), trees.size());
 }
+
+TEST(GBTreeModel, BaseGeneration) {
+  LearnerModelParam mparam;
+  mparam.num_feature = 1;
+  mparam.num_output_group = 1;
+  mparam.base_score = 0.5;
+  gbm::GBTreeModel model = CreateTestModel(&mparam);
+
+  // appending trees bumps the generation but keeps the base generation, so a
+  // device copy of the existing trees stays valid
+  auto const generation = model.Generation();
+  auto const base = model.BaseGeneration();
+  ASSERT_LE(base, generation);
+  std::vector<std::shared_ptr<RegTree>> trees;
+  trees.push_back(std::make_shared<RegTree>());
+  model.CommitModel(std::move(trees), 0);
+  ASSERT_GT(model.Generation(), generation);
+  ASSERT_EQ(model.BaseGeneration(), base);
+
+  // moving the trees out for the update process invalidates any prefix
+  model.InitTreesToUpdate();
+  ASSERT_EQ(model.BaseGeneration(), model.Generation());
+  ASSERT_GT(model.BaseGeneration(), base);
+}
+
+TEST(GBTreeModel, UsedFeatures) {
+  LearnerModelParam mparam;
+  mparam.num_feature = 64;
+  mparam.num_output_group = 1;
+  mparam.base_score = 0.5;
+  gbm::GBTreeModel model = CreateTestModel(&mparam);
+  // the initial tree is a single leaf, no feature is tested
+  ASSERT_EQ(model.NumUsedFeatures(), 0);
+
+  std::vector<std::shared_ptr<RegTree>> trees;
+  trees.push_back(std::make_shared<RegTree>());
+  trees.back()->ExpandNode(0, /*split_index=*/3, 0.5f, true, 0.0f, 0.0f, 0.0f,
+                           0.0f, 0.0f, 0.0f, 0.0f);
+  model.CommitModel(std::move(trees), 0);
+  auto const& bits = model.UsedFeatures();
+  ASSERT_EQ(bits.size(), 2);
+  ASSERT_TRUE(bits[0] & (1u << 3));
+  ASSERT_EQ(bits[1], 0);
+  ASSERT_EQ(model.NumUsedFeatures(), 1);
+}
 }  // namespace xgboost
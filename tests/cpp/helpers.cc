@@ -457,8 +457,8 @@ gbm::GBTreeModel CreateTestModel(LearnerModelParam const* param, size_t n_classe
   gbm::GBTreeModel model(param);
 
   for (size_t i = 0; i < n_classes; ++i) {
-    std::vector<std::unique_ptr<RegTree>> trees;
-    trees.push_back(std::unique_ptr<RegTree>(new RegTree));
+    std::vector<std::shared_ptr<RegTree>> trees;
+    trees.push_back(std::make_shared<RegTree>());
     if (i == 0) {
       (*trees.back())[0].SetLeaf(1.5f);
       (*trees.back()).Stat(0).sum_hess = 1.0f;
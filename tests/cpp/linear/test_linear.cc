@@ -43,6 +43,44 @@ TEST(Linear, Shotgun) {
   }
 }
 
+TEST(Linear, ShotgunEpochs) {
+  size_t constexpr kRows = 10;
+  size_t constexpr kCols = 10;
+
+  auto p_fmat = xgboost::RandomDataGenerator(kRows, kCols, 0).GenerateDMatrix();
+
+  auto lparam = xgboost::CreateEmptyGenericParam(GPUIDX);
+  LearnerModelParam mparam;
+  mparam.num_feature = kCols;
+  mparam.num_output_group = 1;
+  mparam.base_score = 0.5;
+
+  auto run = [&]() {
+    auto updater = std::unique_ptr<xgboost::LinearUpdater>(
+        xgboost::LinearUpdater::Create("shotgun", &lparam));
+    updater->Configure({{"eta", "1."},
+                        {"shotgun_epochs", "2"},
+                        {"shotgun_top_k", "4"}});
+    xgboost::HostDeviceVector<xgboost::GradientPair> gpair(
+        p_fmat->Info().num_row_, xgboost::GradientPair(-5, 1.0));
+    xgboost::gbm::GBLinearModel model{&mparam};
+    model.LazyInitModel();
+    updater->Update(&gpair, p_fmat.get(), &model, gpair.Size());
+
+    EXPECT_EQ(model.Bias()[0], 5.0f);
+    std::vector<float> weights(kCols);
+    for (size_t i = 0; i < kCols; ++i) {
+      weights[i] = model[i][0];
+    }
+    return weights;
+  };
+
+  // the epochs work against frozen residuals, so the result is deterministic
+  // regardless of the number of threads
+  auto weights = run();
+  ASSERT_EQ(weights, run());
+}
+
 TEST(Shotgun, JsonIO) {
   TestUpdaterJsonIO("shotgun");
 }
@@ -19,6 +19,40 @@ TEST(Metric, DeclareUnifiedTest(RMSE)) {
   delete metric;
 }
 
+TEST(Metric, DeclareUnifiedTest(ChunkedReduction)) {
+  auto lparam = xgboost::CreateEmptyGenericParam(GPUIDX);
+  std::unique_ptr<xgboost::Metric> metric{xgboost::Metric::Create("rmse", &lparam)};
+  metric->Configure({});
+
+  size_t constexpr kRows = 1000;
+  xgboost::HostDeviceVector<xgboost::bst_float> preds;
+  xgboost::MetaInfo info;
+  info.num_row_ = kRows;
+  auto& h_preds = preds.HostVector();
+  auto& h_labels = info.labels_.HostVector();
+  auto& h_weights = info.weights_.HostVector();
+  for (size_t i = 0; i < kRows; ++i) {
+    h_preds.push_back(static_cast<float>(i % 17) / 16.0f);
+    h_labels.push_back(static_cast<float>(i % 5) / 4.0f);
+    h_weights.push_back(static_cast<float>(i % 3) + 0.5f);
+  }
+  auto const full = metric->Eval(preds, info, false);
+
+  if (!metric->EvalChunkBegin(info)) {
+    // the chunked path is host only
+    ASSERT_GE(GPUIDX, 0);
+    return;
+  }
+  size_t constexpr kChunkRows = 128;
+  for (size_t begin = 0; begin < kRows; begin += kChunkRows) {
+    size_t const end = std::min(kRows, begin + kChunkRows);
+    xgboost::HostDeviceVector<xgboost::bst_float> chunk;
+    chunk.HostVector().assign(h_preds.cbegin() + begin, h_preds.cbegin() + end);
+    metric->EvalChunk(chunk, info, begin, end);
+  }
+  EXPECT_NEAR(metric->EvalChunkEnd(false), full, 1e-6);
+}
+
 TEST(Metric, DeclareUnifiedTest(RMSLE)) {
   auto lparam = xgboost::CreateEmptyGenericParam(GPUIDX);
   xgboost::Metric * metric = xgboost::Metric::Create("rmsle", &lparam);
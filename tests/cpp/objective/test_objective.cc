@@ -1,5 +1,6 @@
 // Copyright by Contributors
 #include <gtest/gtest.h>
+#include <xgboost/metric.h>
 #include <xgboost/objective.h>
 #include <xgboost/generic_parameters.h>
 
@@ -17,3 +18,48 @@ TEST(Objective, UnknownFunction) {
     delete obj;
   }
 }
+
+TEST(Objective, FusedEvalMetric) {
+  xgboost::GenericParameter tparam = xgboost::CreateEmptyGenericParam(-1);
+  std::vector<std::pair<std::string, std::string>> args;
+
+  for (auto name : {"reg:squarederror", "binary:logistic"}) {
+    std::unique_ptr<xgboost::ObjFunction> obj {
+      xgboost::ObjFunction::Create(name, &tparam)
+    };
+    obj->Configure(args);
+
+    xgboost::HostDeviceVector<xgboost::bst_float> preds {
+      {0.1f, -0.3f, 0.7f, 1.2f, -0.5f, 0.0f, 0.9f, -1.1f}};
+    xgboost::MetaInfo info;
+    info.num_row_ = preds.Size();
+    info.labels_.HostVector() = {0.0f, 1.0f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f};
+    info.weights_.HostVector() = {1.0f, 2.0f, 1.0f, 0.5f, 1.0f, 1.0f, 3.0f, 1.0f};
+
+    xgboost::HostDeviceVector<xgboost::GradientPair> gpair;
+    xgboost::bst_float fused_metric = 0.0f;
+    ASSERT_TRUE(obj->GetGradientFusedEval(preds, info, 0, &gpair, &fused_metric));
+
+    // gradients must match the plain pass
+    xgboost::HostDeviceVector<xgboost::GradientPair> expected_gpair;
+    obj->GetGradient(preds, info, 0, &expected_gpair);
+    ASSERT_EQ(gpair.Size(), expected_gpair.Size());
+    for (size_t i = 0; i < gpair.Size(); ++i) {
+      EXPECT_NEAR(gpair.HostVector()[i].GetGrad(),
+                  expected_gpair.HostVector()[i].GetGrad(), 1e-6f);
+      EXPECT_NEAR(gpair.HostVector()[i].GetHess(),
+                  expected_gpair.HostVector()[i].GetHess(), 1e-6f);
+    }
+
+    // the fused metric must match the registered default metric on the
+    // transformed predictions
+    std::unique_ptr<xgboost::Metric> metric {
+      xgboost::Metric::Create(obj->DefaultEvalMetric(), &tparam)
+    };
+    metric->Configure(args);
+    xgboost::HostDeviceVector<xgboost::bst_float> transformed;
+    transformed.HostVector() = preds.HostVector();
+    obj->EvalTransform(&transformed);
+    EXPECT_NEAR(fused_metric, metric->Eval(transformed, info, false), 1e-6f);
+  }
+}
@@ -32,6 +32,38 @@ TEST(Objective, DeclareUnifiedTest(LinearRegressionGPair)) {
   ASSERT_NO_THROW(obj->DefaultEvalMetric());
 }
 
+TEST(Objective, DeclareUnifiedTest(GradientRange)) {
+  GenericParameter tparam = CreateEmptyGenericParam(GPUIDX);
+  std::unique_ptr<ObjFunction> obj{ObjFunction::Create("binary:logistic", &tparam)};
+  obj->Configure({});
+
+  HostDeviceVector<bst_float> preds{{0.1f, 0.9f, -0.3f, 0.4f, 2.0f}};
+  MetaInfo info;
+  info.num_row_ = 5;
+  info.labels_.HostVector() = {0.0f, 1.0f, 1.0f, 0.0f, 1.0f};
+
+  HostDeviceVector<GradientPair> expected;
+  obj->GetGradient(preds, info, 0, &expected);
+
+  HostDeviceVector<GradientPair> ranged;
+  if (!obj->GetGradientRangeBegin(preds, info, &ranged)) {
+    // the range path is host only
+    ASSERT_GE(tparam.gpu_id, 0);
+    return;
+  }
+  ASSERT_EQ(ranged.Size(), preds.Size());
+  obj->GetGradientRange(preds, info, 0, 0, 2, &ranged);
+  obj->GetGradientRange(preds, info, 0, 2, 5, &ranged);
+  obj->GetGradientRangeEnd();
+
+  auto const& h_expected = expected.ConstHostVector();
+  auto const& h_ranged = ranged.ConstHostVector();
+  for (size_t i = 0; i < h_expected.size(); ++i) {
+    EXPECT_FLOAT_EQ(h_expected[i].GetGrad(), h_ranged[i].GetGrad());
+    EXPECT_FLOAT_EQ(h_expected[i].GetHess(), h_ranged[i].GetHess());
+  }
+}
+
 TEST(Objective, DeclareUnifiedTest(SquaredLog)) {
   GenericParameter tparam = CreateEmptyGenericParam(GPUIDX);
   std::vector<std::pair<std::string, std::string>> args;
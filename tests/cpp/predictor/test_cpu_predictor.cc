@@ -5,6 +5,8 @@
 #include <gtest/gtest.h>
 #include <xgboost/predictor.h>
 
+#include <limits>
+
 #include "../helpers.h"
 #include "test_predictor.h"
 #include "../../../src/gbm/gbtree_model.h"
@@ -83,6 +85,317 @@ TEST(CpuPredictor, Basic) {
   }
 }
 
+TEST(CpuPredictor, SparseTraversal) {
+  auto lparam = CreateEmptyGenericParam(GPUIDX);
+  std::unique_ptr<Predictor> cpu_predictor =
+      std::unique_ptr<Predictor>(Predictor::Create("cpu_predictor", &lparam));
+
+  // wide feature space with a handful of entries per row, the profile the
+  // sparse-native traversal targets
+  size_t constexpr kRows = 200;
+  size_t constexpr kCols = 256;
+
+  LearnerModelParam param;
+  param.num_feature = kCols;
+  param.base_score = 0.0;
+  param.num_output_group = 1;
+
+  gbm::GBTreeModel model{&param};
+  {
+    std::vector<std::shared_ptr<RegTree>> trees;
+    trees.push_back(std::make_shared<RegTree>());
+    auto& tree0 = *trees.back();
+    tree0.ExpandNode(0, 3, 0.5f, true, 0.0f, -1.0f, 1.0f, 0.0f, 1.0f, 1.0f,
+                     1.0f);
+    trees.push_back(std::make_shared<RegTree>());
+    auto& tree1 = *trees.back();
+    tree1.ExpandNode(0, 10, 0.5f, false, 0.0f, 0.0f, 2.0f, 0.0f, 1.0f, 1.0f,
+                     1.0f);
+    tree1.ExpandNode(tree1[0].LeftChild(), 200, 0.25f, true, 0.0f, -3.0f, 3.0f,
+                     0.0f, 1.0f, 1.0f, 1.0f);
+    trees.push_back(std::make_shared<RegTree>());
+    auto& tree2 = *trees.back();
+    tree2.ExpandNode(0, 77, 0.25f, true, 0.0f, -5.0f, 5.0f, 0.0f, 1.0f, 1.0f,
+                     1.0f);
+    model.CommitModel(std::move(trees), 0);
+  }
+
+  for (float sparsity : {0.98f, 0.0f}) {
+    // the dense matrix exceeds the per-row entry threshold, so it exercises
+    // the fall back to the staged path
+    auto dmat = RandomDataGenerator(kRows, kCols, sparsity).GenerateDMatrix();
+    PredictionCacheEntry out_predictions;
+    cpu_predictor->PredictBatch(dmat.get(), &out_predictions, model, 0);
+    auto const& batch_preds = out_predictions.predictions.ConstHostVector();
+    ASSERT_EQ(batch_preds.size(), kRows);
+
+    // the instance path stages each row densely, both must agree exactly
+    auto const& page = *dmat->GetBatches<SparsePage>().begin();
+    for (size_t i = 0; i < page.Size(); ++i) {
+      std::vector<float> instance_out;
+      cpu_predictor->PredictInstance(page[i], &instance_out, model);
+      ASSERT_EQ(batch_preds[i], instance_out[0]) << " row " << i;
+    }
+  }
+}
+
+TEST(CpuPredictor, InteractionContributions) {
+  auto lparam = CreateEmptyGenericParam(GPUIDX);
+  std::unique_ptr<Predictor> cpu_predictor =
+      std::unique_ptr<Predictor>(Predictor::Create("cpu_predictor", &lparam));
+
+  size_t constexpr kRows = 64;
+  size_t constexpr kCols = 3;
+
+  LearnerModelParam param;
+  param.num_feature = kCols;
+  param.base_score = 0.0;
+  param.num_output_group = 1;
+
+  // two trees with real splits so features actually interact
+  gbm::GBTreeModel model(&param);
+  std::vector<std::shared_ptr<RegTree>> trees;
+  trees.push_back(std::make_shared<RegTree>());
+  trees.back()->ExpandNode(0, 0, 0.5f, true, 0.0f, -0.5f, 3.0f, 0.0f, 4.0f,
+                           2.0f, 2.0f);
+  trees.back()->ExpandNode(1, 1, 0.5f, true, 0.0f, 1.0f, 2.0f, 0.0f, 2.0f,
+                           1.0f, 1.0f);
+  trees.push_back(std::make_shared<RegTree>());
+  trees.back()->ExpandNode(0, 2, 0.5f, true, 0.0f, -1.0f, 1.0f, 0.0f, 4.0f,
+                           2.0f, 2.0f);
+  model.CommitModel(std::move(trees), 0);
+
+  auto dmat = RandomDataGenerator(kRows, kCols, 0).GenerateDMatrix();
+
+  HostDeviceVector<float> interactions_hdv;
+  cpu_predictor->PredictInteractionContributions(dmat.get(), &interactions_hdv,
+                                                 model);
+  auto const& interactions = interactions_hdv.HostVector();
+  size_t constexpr kMatrix = (kCols + 1) * (kCols + 1);
+  ASSERT_EQ(interactions.size(), kRows * kMatrix);
+
+  // reference from explicit conditioned contribution passes
+  HostDeviceVector<float> contribs_hdv;
+  cpu_predictor->PredictContribution(dmat.get(), &contribs_hdv, model);
+  auto const& contribs = contribs_hdv.HostVector();
+  HostDeviceVector<float> on_hdv;
+  HostDeviceVector<float> off_hdv;
+  for (size_t i = 0; i < kCols + 1; ++i) {
+    cpu_predictor->PredictContribution(dmat.get(), &off_hdv, model, 0, nullptr,
+                                       false, -1, i);
+    cpu_predictor->PredictContribution(dmat.get(), &on_hdv, model, 0, nullptr,
+                                       false, 1, i);
+    auto const& on = on_hdv.HostVector();
+    auto const& off = off_hdv.HostVector();
+    for (size_t r = 0; r < kRows; ++r) {
+      float diag = contribs[r * (kCols + 1) + i];
+      for (size_t k = 0; k < kCols + 1; ++k) {
+        if (k == i) {
+          continue;
+        }
+        float expected =
+            (on[r * (kCols + 1) + k] - off[r * (kCols + 1) + k]) / 2.0f;
+        ASSERT_NEAR(interactions[r * kMatrix + i * (kCols + 1) + k], expected,
+                    1e-5f);
+        diag -= expected;
+      }
+      // the diagonal makes each row sum to the feature's contribution
+      ASSERT_NEAR(interactions[r * kMatrix + i * (kCols + 1) + i], diag, 1e-5f);
+    }
+  }
+
+  // restricting the conditioning loop to a feature subset leaves the other
+  // rows with only their additive effect
+  setenv("XGBOOST_SHAP_INTERACTION_FEATURES", "1", 1);
+  HostDeviceVector<float> subset_hdv;
+  cpu_predictor->PredictInteractionContributions(dmat.get(), &subset_hdv,
+                                                 model);
+  unsetenv("XGBOOST_SHAP_INTERACTION_FEATURES");
+  auto const& restricted = subset_hdv.HostVector();
+  for (size_t r = 0; r < kRows; ++r) {
+    for (size_t i = 0; i < kCols + 1; ++i) {
+      for (size_t k = 0; k < kCols + 1; ++k) {
+        float const value = restricted[r * kMatrix + i * (kCols + 1) + k];
+        if (i == 1) {
+          ASSERT_EQ(value, interactions[r * kMatrix + i * (kCols + 1) + k]);
+        } else if (i == k) {
+          ASSERT_NEAR(value, contribs[r * (kCols + 1) + i], 1e-5f);
+        } else {
+          ASSERT_EQ(value, 0.0f);
+        }
+      }
+    }
+  }
+}
+
+TEST(CpuPredictor, DenseMulti) {
+  size_t constexpr kRows = 100;
+  size_t constexpr kCols = 5;
+
+  LearnerModelParam param;
+  param.num_feature = kCols;
+  param.base_score = 0.0;
+  param.num_output_group = 1;
+  gbm::GBTreeModel first = CreateTestModel(&param);
+
+  LearnerModelParam second_param;
+  second_param.num_feature = kCols;
+  second_param.base_score = 0.5;
+  second_param.num_output_group = 1;
+  gbm::GBTreeModel second = CreateTestModel(&second_param);
+  {
+    // a real split so the second model exercises traversal
+    std::vector<std::shared_ptr<RegTree>> trees;
+    trees.push_back(std::make_shared<RegTree>());
+    trees.back()->ExpandNode(0, /*split_index=*/1, 0.5f, true, 0.0f, -1.0f,
+                             2.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+    second.CommitModel(std::move(trees), 0);
+  }
+
+  std::vector<float> data(kRows * kCols);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<float>(i % 3) / 3.0f;
+  }
+
+  std::vector<float> margins(2 * kRows);
+  predictor::PredictDenseMulti({&first, &second}, data.data(), kRows, kCols,
+                               std::numeric_limits<float>::quiet_NaN(),
+                               margins.data());
+  for (size_t i = 0; i < kRows; ++i) {
+    // the test model is a single 1.5 leaf
+    ASSERT_EQ(margins[i], 1.5f);
+    float const split_value = data[i * kCols + 1];
+    float const expected = 0.5f + 1.5f + (split_value < 0.5f ? -1.0f : 2.0f);
+    ASSERT_EQ(margins[kRows + i], expected);
+  }
+}
+
+TEST(CpuPredictor, PredictLeafInt32) {
+  auto lparam = CreateEmptyGenericParam(GPUIDX);
+  std::unique_ptr<Predictor> cpu_predictor =
+      std::unique_ptr<Predictor>(Predictor::Create("cpu_predictor", &lparam));
+
+  size_t constexpr kRows = 100;
+  size_t constexpr kCols = 5;
+
+  LearnerModelParam param;
+  param.num_feature = kCols;
+  param.base_score = 0.0;
+  param.num_output_group = 1;
+  gbm::GBTreeModel model = CreateTestModel(&param);
+  {
+    // a real split so the rows land in different leaves
+    std::vector<std::shared_ptr<RegTree>> trees;
+    trees.push_back(std::make_shared<RegTree>());
+    trees.back()->ExpandNode(0, /*split_index=*/1, 0.5f, true, 0.0f, -1.0f,
+                             2.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+    model.CommitModel(std::move(trees), 0);
+  }
+
+  auto dmat = RandomDataGenerator(kRows, kCols, 0).GenerateDMatrix();
+
+  HostDeviceVector<float> float_leaves;
+  cpu_predictor->PredictLeaf(dmat.get(), &float_leaves, model);
+  auto const& h_float_leaves = float_leaves.ConstHostVector();
+  ASSERT_EQ(h_float_leaves.size(), kRows * model.trees.size());
+
+  std::vector<bst_node_t> int_leaves(h_float_leaves.size(), -1);
+  ASSERT_TRUE(cpu_predictor->PredictLeafInt32(
+      dmat.get(), common::Span<bst_node_t>{int_leaves}, model));
+  for (size_t i = 0; i < int_leaves.size(); ++i) {
+    ASSERT_EQ(static_cast<float>(int_leaves[i]), h_float_leaves[i]);
+  }
+}
+
+TEST(CpuPredictor, PredictLeafStats) {
+  auto lparam = CreateEmptyGenericParam(GPUIDX);
+  std::unique_ptr<Predictor> cpu_predictor =
+      std::unique_ptr<Predictor>(Predictor::Create("cpu_predictor", &lparam));
+
+  size_t constexpr kRows = 100;
+  size_t constexpr kCols = 5;
+
+  LearnerModelParam param;
+  param.num_feature = kCols;
+  param.base_score = 0.0;
+  param.num_output_group = 1;
+  gbm::GBTreeModel model = CreateTestModel(&param);
+  {
+    // a real split so the rows land in different leaves
+    std::vector<std::shared_ptr<RegTree>> trees;
+    trees.push_back(std::make_shared<RegTree>());
+    trees.back()->ExpandNode(0, /*split_index=*/1, 0.5f, true, 0.0f, -1.0f,
+                             2.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+    model.CommitModel(std::move(trees), 0);
+  }
+
+  auto dmat = RandomDataGenerator(kRows, kCols, 0).GenerateDMatrix();
+  auto& labels = dmat->Info().labels_.HostVector();
+  labels.resize(kRows);
+  for (size_t i = 0; i < kRows; ++i) {
+    labels[i] = static_cast<float>(i % 2);
+  }
+
+  HostDeviceVector<float> leaves;
+  cpu_predictor->PredictLeaf(dmat.get(), &leaves, model);
+  auto const& h_leaves = leaves.ConstHostVector();
+
+  std::vector<bst_float> stats;
+  ASSERT_TRUE(cpu_predictor->PredictLeafStats(dmat.get(), &stats, model));
+  size_t const ntree = model.trees.size();
+  size_t stride = 0;
+  for (auto const& tree : model.trees) {
+    stride = std::max(stride, static_cast<size_t>(tree->param.num_nodes));
+  }
+  ASSERT_EQ(stats.size(), ntree * stride * 3);
+
+  // rebuild the expected aggregation from the per-row leaf indices
+  std::vector<float> expected(stats.size(), 0.0f);
+  for (size_t i = 0; i < kRows; ++i) {
+    for (size_t j = 0; j < ntree; ++j) {
+      auto const nid = static_cast<size_t>(h_leaves[i * ntree + j]);
+      float* slot = &expected[(j * stride + nid) * 3];
+      slot[0] += 1.0f;
+      slot[1] += labels[i];
+      slot[2] += 1.0f;  // unweighted rows count with weight one
+    }
+  }
+  for (size_t k = 0; k < stats.size(); ++k) {
+    ASSERT_EQ(stats[k], expected[k]);
+  }
+}
+
+TEST(CpuPredictor, InstanceEarlyExit) {
+  auto lparam = CreateEmptyGenericParam(GPUIDX);
+  std::unique_ptr<Predictor> cpu_predictor =
+      std::unique_ptr<Predictor>(Predictor::Create("cpu_predictor", &lparam));
+
+  size_t constexpr kCols = 5;
+
+  LearnerModelParam param;
+  param.num_feature = kCols;
+  param.base_score = 0.0;
+  param.num_output_group = 1;
+
+  gbm::GBTreeModel model(&param);
+  for (size_t i = 0; i < 3; ++i) {
+    std::vector<std::shared_ptr<RegTree>> trees;
+    trees.push_back(std::make_shared<RegTree>());
+    (*trees.back())[0].SetLeaf(1.0f);
+    model.CommitModel(std::move(trees), 0);
+  }
+
+  auto dmat = RandomDataGenerator(1, kCols, 0).GenerateDMatrix();
+  auto const& batch = *dmat->GetBatches<SparsePage>().begin();
+
+  std::vector<float> preds;
+  cpu_predictor->PredictInstance(batch[0], &preds, model);
+  ASSERT_EQ(preds[0], 3.0f);
+  // the partial sum exceeds the threshold after the second tree
+  cpu_predictor->PredictInstance(batch[0], &preds, model, 0, 1.5f);
+  ASSERT_EQ(preds[0], 2.0f);
+}
+
 TEST(CpuPredictor, ExternalMemory) {
   dmlc::TemporaryDirectory tmpdir;
   std::string filename = tmpdir.path + "/big.libsvm";
@@ -57,6 +57,46 @@ TEST(GPUPredictor, Basic) {
   }
 }
 
+TEST(GPUPredictor, GraphPredict) {
+  auto lparam = CreateEmptyGenericParam(0);
+  std::unique_ptr<Predictor> gpu_predictor =
+      std::unique_ptr<Predictor>(Predictor::Create("gpu_predictor", &lparam));
+  gpu_predictor->Configure({});
+
+  const int n_row = 16, n_col = 8;
+  LearnerModelParam param;
+  param.num_feature = n_col;
+  param.num_output_group = 1;
+  param.base_score = 0.5;
+  gbm::GBTreeModel model = CreateTestModel(&param);
+
+  // reference predictions through the regular launch path
+  auto dmat = RandomDataGenerator(n_row, n_col, 0).Seed(3).GenerateDMatrix();
+  PredictionCacheEntry reference;
+  gpu_predictor->PredictBatch(dmat.get(), &reference, model, 0);
+
+  setenv("XGBOOST_GPU_GRAPH_PREDICT", "1", 1);
+  // first call captures, the later identically shaped calls replay the graph
+  for (int it = 0; it < 3; ++it) {
+    PredictionCacheEntry out;
+    gpu_predictor->PredictBatch(dmat.get(), &out, model, 0);
+    auto const& h_out = out.predictions.ConstHostVector();
+    auto const& h_ref = reference.predictions.ConstHostVector();
+    ASSERT_EQ(h_out.size(), h_ref.size());
+    for (size_t i = 0; i < h_ref.size(); ++i) {
+      ASSERT_EQ(h_out[i], h_ref[i]);
+    }
+  }
+  // a different shape forces a recapture
+  auto small = RandomDataGenerator(n_row / 2, n_col, 0).Seed(4).GenerateDMatrix();
+  PredictionCacheEntry graph_small, plain_small;
+  gpu_predictor->PredictBatch(small.get(), &graph_small, model, 0);
+  unsetenv("XGBOOST_GPU_GRAPH_PREDICT");
+  gpu_predictor->PredictBatch(small.get(), &plain_small, model, 0);
+  ASSERT_EQ(graph_small.predictions.ConstHostVector(),
+            plain_small.predictions.ConstHostVector());
+}
+
 TEST(GPUPredictor, EllpackBasic) {
   size_t constexpr kCols {8};
   for (size_t bins = 2; bins < 258; bins += 16) {
@@ -171,8 +211,8 @@ TEST(GPUPredictor, ShapStump) {
   param.num_output_group = 1;
   param.base_score = 0.5;
   gbm::GBTreeModel model(&param);
-  std::vector<std::unique_ptr<RegTree>> trees;
-  trees.push_back(std::unique_ptr<RegTree>(new RegTree));
+  std::vector<std::shared_ptr<RegTree>> trees;
+  trees.push_back(std::make_shared<RegTree>());
   model.CommitModel(std::move(trees), 0);
 
   auto gpu_lparam = CreateEmptyGenericParam(0);
@@ -197,8 +237,8 @@ TEST(GPUPredictor, Shap) {
   param.num_output_group = 1;
   param.base_score = 0.5;
   gbm::GBTreeModel model(&param);
-  std::vector<std::unique_ptr<RegTree>> trees;
-  trees.push_back(std::unique_ptr<RegTree>(new RegTree));
+  std::vector<std::shared_ptr<RegTree>> trees;
+  trees.push_back(std::make_shared<RegTree>());
   trees[0]->ExpandNode(0, 0, 0.5, true, 1.0, -1.0, 1.0, 0.0, 5.0, 2.0, 3.0);
   model.CommitModel(std::move(trees), 0);
 
@@ -188,8 +188,8 @@ void TestCategoricalPrediction(std::string name) {
 
   gbm::GBTreeModel model(&param);
 
-  std::vector<std::unique_ptr<RegTree>> trees;
-  trees.push_back(std::unique_ptr<RegTree>(new RegTree));
+  std::vector<std::shared_ptr<RegTree>> trees;
+  trees.push_back(std::make_shared<RegTree>());
   auto& p_tree = trees.front();
 
   uint32_t split_ind = 3;
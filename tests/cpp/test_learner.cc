@@ -133,6 +133,22 @@ TEST(Learner, Configuration) {
   }
 }
 
+TEST(Learner, SetParamFloat) {
+  auto p_mat = RandomDataGenerator{10, 10, 0}.GenerateDMatrix();
+  std::unique_ptr<Learner> learner{Learner::Create({p_mat})};
+
+  // The typed fast path only applies to a configured booster.
+  ASSERT_FALSE(learner->SetParamFloat("learning_rate", 0.3f));
+
+  learner->Configure();
+  ASSERT_TRUE(learner->SetParamFloat("learning_rate", 0.3f));
+  auto args = learner->GetConfigurationArguments();
+  ASSERT_FLOAT_EQ(std::stof(args.at("learning_rate")), 0.3f);
+
+  // Unsupported keys fall back to the string path.
+  ASSERT_FALSE(learner->SetParamFloat("max_depth", 4.0f));
+}
+
 TEST(Learner, JsonModelIO) {
   // Test of comparing JSON object directly.
   size_t constexpr kRows = 8;
@@ -187,6 +203,101 @@ TEST(Learner, JsonModelIO) {
   }
 }
 
+TEST(Learner, DirectJsonModelIO) {
+  // The stream loader parses JSON models directly into trees; the result must
+  // be byte-identical to going through the generic document reader.
+  size_t constexpr kRows = 8;
+  int32_t constexpr kIters = 4;
+
+  std::shared_ptr<DMatrix> p_dmat{
+    RandomDataGenerator{kRows, 10, 0}.GenerateDMatrix()};
+  p_dmat->Info().labels_.Resize(kRows);
+
+  std::unique_ptr<Learner> learner { Learner::Create({p_dmat}) };
+  for (int32_t iter = 0; iter < kIters; ++iter) {
+    learner->UpdateOneIter(iter, p_dmat);
+  }
+
+  Json out { Object() };
+  learner->SaveModel(&out);
+  std::string dumped;
+  Json::Dump(out, &dumped);
+
+  std::unique_ptr<Learner> loaded { Learner::Create({p_dmat}) };
+  common::MemoryFixSizeBuffer fs(&dumped[0], dumped.size());
+  loaded->LoadModel(&fs);
+  loaded->Configure();
+
+  Json reloaded { Object() };
+  loaded->SaveModel(&reloaded);
+  ASSERT_EQ(reloaded, out);
+
+  HostDeviceVector<float> expected;
+  learner->Predict(p_dmat, false, &expected);
+  HostDeviceVector<float> predictions;
+  loaded->Predict(p_dmat, false, &predictions);
+  ASSERT_EQ(predictions.HostVector(), expected.HostVector());
+}
+
+TEST(Learner, MulticlassPredictionCache) {
+  // The per-class cache update in GBTree::CommitModel must leave the training
+  // prediction cache identical to a cold prediction over the same model.
+  size_t constexpr kRows = 100;
+  size_t constexpr kCols = 10;
+  auto p_dmat = RandomDataGenerator{kRows, kCols, 0}.GenerateDMatrix();
+  auto& h_labels = p_dmat->Info().labels_.HostVector();
+  h_labels.resize(kRows);
+  for (size_t i = 0; i < kRows; ++i) {
+    h_labels[i] = static_cast<bst_float>(i % 3);
+  }
+
+  std::unique_ptr<Learner> learner { Learner::Create({p_dmat}) };
+  learner->SetParam("objective", "multi:softprob");
+  learner->SetParam("num_class", "3");
+  learner->SetParam("tree_method", "hist");
+  learner->SetParam("parallel_class_boosting", "true");
+  for (int32_t iter = 0; iter < 4; ++iter) {
+    learner->UpdateOneIter(iter, p_dmat);
+  }
+
+  HostDeviceVector<float> cached;
+  learner->Predict(p_dmat, false, &cached);
+
+  auto p_fresh = RandomDataGenerator{kRows, kCols, 0}.GenerateDMatrix();
+  HostDeviceVector<float> cold;
+  learner->Predict(p_fresh, false, &cold);
+  ASSERT_EQ(cached.HostVector(), cold.HostVector());
+}
+
+TEST(Learner, AsyncEval) {
+  size_t constexpr kRows = 100;
+  int32_t constexpr kIters = 4;
+  auto p_dmat = RandomDataGenerator{kRows, 10, 0}.GenerateDMatrix(true);
+
+  // reference results from a synchronous learner trained identically
+  std::vector<std::string> expected;
+  {
+    std::unique_ptr<Learner> learner { Learner::Create({p_dmat}) };
+    for (int32_t iter = 0; iter < kIters; ++iter) {
+      learner->UpdateOneIter(iter, p_dmat);
+      expected.push_back(learner->EvalOneIter(iter, {p_dmat}, {"train"}));
+    }
+  }
+
+  // the asynchronous learner reports each round one call late
+  std::unique_ptr<Learner> learner { Learner::Create({p_dmat}) };
+  learner->SetParam("eval_async", "true");
+  std::vector<std::string> results;
+  for (int32_t iter = 0; iter < kIters; ++iter) {
+    learner->UpdateOneIter(iter, p_dmat);
+    results.push_back(learner->EvalOneIter(iter, {p_dmat}, {"train"}));
+  }
+  ASSERT_TRUE(results.front().empty());
+  for (int32_t iter = 1; iter < kIters; ++iter) {
+    ASSERT_EQ(results[iter], expected[iter - 1]);
+  }
+}
+
 // Crashes the test runner if there are race condiditions.
 //
 // Build with additional cmake flags to enable thread sanitizer
@@ -229,6 +340,92 @@ TEST(Learner, MultiThreadedPredict) {
   }
 }
 
+TEST(Learner, FrozenPredict) {
+  size_t constexpr kRows = 100;
+  size_t constexpr kCols = 10;
+  auto p_dmat = RandomDataGenerator{kRows, kCols, 0}.GenerateDMatrix(true);
+  auto p_data = RandomDataGenerator{kRows, kCols, 0}.GenerateDMatrix();
+
+  std::shared_ptr<Learner> learner{Learner::Create({p_dmat})};
+  learner->UpdateOneIter(0, p_dmat);
+  learner->FreezeForPrediction();
+
+  HostDeviceVector<float> reference;
+  learner->Predict(p_data, false, &reference);
+
+  std::vector<std::thread> threads;
+  for (uint32_t thread_id = 0;
+       thread_id < 2 * std::thread::hardware_concurrency(); ++thread_id) {
+    threads.emplace_back([learner, p_data, &reference] {
+      HostDeviceVector<float> predictions;
+      for (size_t iter = 0; iter < 10; ++iter) {
+        learner->Predict(p_data, false, &predictions);
+        ASSERT_EQ(predictions.HostVector(), reference.HostVector());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // a frozen booster accepts neither parameters nor training
+  EXPECT_THROW(learner->SetParam("learning_rate", "0.5"), dmlc::Error);
+  EXPECT_THROW(learner->UpdateOneIter(1, p_dmat), dmlc::Error);
+}
+
+TEST(Learner, SwapModel) {
+  size_t constexpr kRows = 100;
+  size_t constexpr kCols = 10;
+  auto p_dmat = RandomDataGenerator{kRows, kCols, 0}.GenerateDMatrix(true);
+  auto p_data = RandomDataGenerator{kRows, kCols, 0}.GenerateDMatrix();
+
+  // serialize a retrained replacement model
+  std::string replacement;
+  HostDeviceVector<float> expected;
+  {
+    std::unique_ptr<Learner> retrained{Learner::Create({p_dmat})};
+    for (int32_t iter = 0; iter < 4; ++iter) {
+      retrained->UpdateOneIter(iter, p_dmat);
+    }
+    Json out{Object()};
+    retrained->SaveModel(&out);
+    Json::Dump(out, &replacement);
+    retrained->Predict(p_data, false, &expected);
+  }
+
+  std::shared_ptr<Learner> learner{Learner::Create({p_dmat})};
+  learner->UpdateOneIter(0, p_dmat);
+  learner->FreezeForPrediction();
+
+  HostDeviceVector<float> reference;
+  learner->Predict(p_data, false, &reference);
+  ASSERT_NE(reference.HostVector(), expected.HostVector());
+
+  // every concurrent prediction must match either the old model or the new
+  // one; a torn swap would produce something that matches neither
+  std::vector<std::thread> threads;
+  for (uint32_t thread_id = 0;
+       thread_id < 2 * std::thread::hardware_concurrency(); ++thread_id) {
+    threads.emplace_back([learner, p_data, &reference, &expected] {
+      HostDeviceVector<float> predictions;
+      for (size_t iter = 0; iter < 10; ++iter) {
+        learner->Predict(p_data, false, &predictions);
+        ASSERT_TRUE(predictions.HostVector() == reference.HostVector() ||
+                    predictions.HostVector() == expected.HostVector());
+      }
+    });
+  }
+  common::MemoryFixSizeBuffer fs(&replacement[0], replacement.size());
+  learner->SwapModel(&fs);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  HostDeviceVector<float> swapped;
+  learner->Predict(p_data, false, &swapped);
+  ASSERT_EQ(swapped.HostVector(), expected.HostVector());
+}
+
 TEST(Learner, BinaryModelIO) {
   size_t constexpr kRows = 8;
   int32_t constexpr kIters = 4;
@@ -261,6 +458,110 @@ TEST(Learner, BinaryModelIO) {
   ASSERT_EQ(config_str.find("WARNING"), std::string::npos);
 }
 
+TEST(Learner, AsyncModelSave) {
+  size_t constexpr kRows = 8;
+  int32_t constexpr kIters = 4;
+  auto p_dmat = RandomDataGenerator{kRows, 10, 0}.GenerateDMatrix();
+  p_dmat->Info().labels_.Resize(kRows);
+
+  std::unique_ptr<Learner> learner{Learner::Create({p_dmat})};
+  learner->Configure();
+  for (int32_t iter = 0; iter < kIters; ++iter) {
+    learner->UpdateOneIter(iter, p_dmat);
+  }
+
+  dmlc::TemporaryDirectory tempdir;
+  std::string const sync_name = tempdir.path + "/model_sync.bin";
+  std::string const async_name = tempdir.path + "/model_async.bin";
+  {
+    std::unique_ptr<dmlc::Stream> fo(dmlc::Stream::Create(sync_name.c_str(), "w"));
+    learner->SaveModel(fo.get());
+  }
+  learner->SaveModelAsync(async_name);
+  // Training continues while the checkpoint is written; the snapshot must
+  // not see the extra trees.
+  for (int32_t iter = kIters; iter < 2 * kIters; ++iter) {
+    learner->UpdateOneIter(iter, p_dmat);
+  }
+  learner->WaitForModelSave();
+
+  auto read_file = [](std::string const& path) {
+    std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(path.c_str(), "r"));
+    std::string buffer;
+    char chunk[1024];
+    size_t n = 0;
+    while ((n = fi->Read(chunk, sizeof chunk)) != 0) {
+      buffer.append(chunk, n);
+    }
+    return buffer;
+  };
+  ASSERT_EQ(read_file(async_name), read_file(sync_name));
+
+  learner.reset(Learner::Create({p_dmat}));
+  std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(async_name.c_str(), "r"));
+  learner->LoadModel(fi.get());
+  learner->Configure();
+  ASSERT_EQ(learner->BoostedRounds(), kIters);
+}
+
+TEST(Learner, DeltaCheckpoint) {
+  size_t constexpr kRows = 16;
+  auto p_dmat = RandomDataGenerator{kRows, 10, 0}.GenerateDMatrix();
+  p_dmat->Info().labels_.Resize(kRows);
+
+  dmlc::TemporaryDirectory tempdir;
+  std::string const ckpt = tempdir.path + "/checkpoint.bin";
+  auto exists = [](std::string const& path) {
+    std::unique_ptr<dmlc::Stream> fi(
+        dmlc::Stream::Create(path.c_str(), "r", true));
+    return fi != nullptr;
+  };
+
+  std::unique_ptr<Learner> learner{Learner::Create({p_dmat})};
+  learner->Configure();
+  ASSERT_EQ(learner->LoadCheckpoint(ckpt), 0);  // nothing to recover yet
+
+  int32_t iter = 0;
+  for (; iter < 2; ++iter) {
+    learner->UpdateOneIter(iter, p_dmat);
+  }
+  learner->SaveCheckpointAsync(ckpt);  // full base
+  for (; iter < 4; ++iter) {
+    learner->UpdateOneIter(iter, p_dmat);
+  }
+  learner->SaveCheckpointAsync(ckpt);  // trees of rounds 2-3 only
+  for (; iter < 6; ++iter) {
+    learner->UpdateOneIter(iter, p_dmat);
+  }
+  learner->SaveCheckpointAsync(ckpt);  // trees of rounds 4-5 only
+  learner->WaitForModelSave();
+  ASSERT_TRUE(exists(ckpt));
+  ASSERT_TRUE(exists(ckpt + ".delta.1"));
+  ASSERT_TRUE(exists(ckpt + ".delta.2"));
+  ASSERT_FALSE(exists(ckpt + ".delta.3"));
+
+  // base plus deltas reassemble the model exactly
+  auto model_bytes = [](Learner* l) {
+    std::string buf;
+    common::MemoryBufferStream ms(&buf);
+    l->SaveModel(&ms);
+    return buf;
+  };
+  std::unique_ptr<Learner> recovered{Learner::Create({p_dmat})};
+  ASSERT_EQ(recovered->LoadCheckpoint(ckpt), 6);
+  ASSERT_EQ(model_bytes(recovered.get()), model_bytes(learner.get()));
+
+  // recovery resumes the chain: the next checkpoint appends a delta instead
+  // of rewriting the base
+  recovered->UpdateOneIter(iter, p_dmat);
+  recovered->SaveCheckpointAsync(ckpt);
+  recovered->WaitForModelSave();
+  ASSERT_TRUE(exists(ckpt + ".delta.3"));
+
+  std::unique_ptr<Learner> verify{Learner::Create({p_dmat})};
+  ASSERT_EQ(verify->LoadCheckpoint(ckpt), 7);
+}
+
 #if defined(XGBOOST_USE_CUDA)
 // Tests for automatic GPU configuration.
 TEST(Learner, GPUConfiguration) {
@@ -335,6 +636,22 @@ TEST(Learner, Seed) {
             get<String>(config["learner"]["generic_param"]["seed"]));
 }
 
+TEST(Learner, EarlyStopOnPlateau) {
+  auto m = RandomDataGenerator{50, 4, 0}.GenerateDMatrix(true);
+  std::unique_ptr<Learner> learner{Learner::Create({m})};
+  // a zero learning rate keeps the metric exactly flat, so the slope test
+  // must flag a plateau as soon as the window fills up
+  learner->SetParams({{"learning_rate", "0.0"}, {"early_stopping_rounds", "4"}});
+  learner->Configure();
+
+  ASSERT_FALSE(learner->ShouldStop());
+  for (int iter = 0; iter < 8; ++iter) {
+    learner->UpdateOneIter(iter, m);
+    learner->EvalOneIter(iter, {m}, {"train"});
+  }
+  ASSERT_TRUE(learner->ShouldStop());
+}
+
 TEST(Learner, ConstantSeed) {
   auto m = RandomDataGenerator{10, 10, 0}.GenerateDMatrix(true);
   std::unique_ptr<Learner> learner{Learner::Create({m})};
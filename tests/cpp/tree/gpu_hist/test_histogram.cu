@@ -99,6 +99,66 @@ TEST(Histogram, GPUDeterministic) {
   }
 }
 
+// The fast mode, selected by a zeroed rounding factor, skips truncation and
+// fixed-point quantization but must still agree with the deterministic
+// histogram up to floating point tolerance.
+template <typename Gradient>
+void TestFastHistogram(bool is_dense) {
+  size_t constexpr kBins = 256, kCols = 120, kRows = 16384;
+  float constexpr kLower = -1e-2, kUpper = 1e2;
+
+  float sparsity = is_dense ? 0.0f : 0.5f;
+  auto matrix = RandomDataGenerator(kRows, kCols, sparsity).GenerateDMatrix();
+  BatchParam batch_param{0, static_cast<int32_t>(kBins), 0};
+
+  for (auto const& batch : matrix->GetBatches<EllpackPage>(batch_param)) {
+    auto* page = batch.Impl();
+
+    tree::RowPartitioner row_partitioner(0, kRows);
+    auto ridx = row_partitioner.GetRows(0);
+
+    int num_bins = kBins * kCols;
+    auto gpair = GenerateRandomGradients(kRows, kLower, kUpper);
+    gpair.SetDevice(0);
+
+    FeatureGroups feature_groups(page->Cuts(), page->is_dense,
+                                 dh::MaxSharedMemoryOptin(0), sizeof(Gradient));
+
+    dh::device_vector<Gradient> reference(num_bins);
+    auto rounding = CreateRoundingFactor<Gradient>(gpair.DeviceSpan());
+    ASSERT_TRUE(rounding.IsDeterministic());
+    BuildGradientHistogram(page->GetDeviceAccessor(0),
+                           feature_groups.DeviceAccessor(0), gpair.DeviceSpan(),
+                           ridx, dh::ToSpan(reference), rounding);
+
+    dh::device_vector<Gradient> fast(num_bins);
+    HistRounding<Gradient> no_rounding{};
+    ASSERT_FALSE(no_rounding.IsDeterministic());
+    BuildGradientHistogram(page->GetDeviceAccessor(0),
+                           feature_groups.DeviceAccessor(0), gpair.DeviceSpan(),
+                           ridx, dh::ToSpan(fast), no_rounding);
+
+    std::vector<Gradient> reference_h(num_bins);
+    thrust::copy(reference.begin(), reference.end(), reference_h.begin());
+    std::vector<Gradient> fast_h(num_bins);
+    thrust::copy(fast.begin(), fast.end(), fast_h.begin());
+
+    for (int i = 0; i < num_bins; ++i) {
+      EXPECT_NEAR(fast_h[i].GetGrad(), reference_h[i].GetGrad(),
+                  std::abs(reference_h[i].GetGrad()) * 1e-3 + 1e-5);
+      EXPECT_NEAR(fast_h[i].GetHess(), reference_h[i].GetHess(),
+                  std::abs(reference_h[i].GetHess()) * 1e-3 + 1e-5);
+    }
+  }
+}
+
+TEST(Histogram, GPUFast) {
+  for (bool is_dense : {false, true}) {
+    TestFastHistogram<GradientPair>(is_dense);
+    TestFastHistogram<GradientPairPrecise>(is_dense);
+  }
+}
+
 std::vector<float> OneHotEncodeFeature(std::vector<float> x, size_t num_cat) {
   std::vector<float> ret(x.size() * num_cat, 0);
   size_t n_rows = x.size();
@@ -168,6 +228,36 @@ void TestGPUHistogramCategorical(size_t num_categories) {
   }
 }
 
+TEST(Histogram, FeatureGroupsTuner) {
+  size_t constexpr kBins = 24, kCols = 16, kRows = 64;
+  auto matrix = RandomDataGenerator(kRows, kCols, 0.0f).GenerateDMatrix();
+  BatchParam batch_param{0, static_cast<int32_t>(kBins), 0};
+  for (auto const& batch : matrix->GetBatches<EllpackPage>(batch_param)) {
+    auto* page = batch.Impl();
+    FeatureGroupsTuner tuner(page->Cuts(), page->is_dense, 0,
+                             dh::MaxSharedMemoryOptin(0),
+                             sizeof(GradientPairPrecise));
+    // Feed timings until every candidate has been measured; the second
+    // candidate is the artificial winner.
+    size_t n_candidates = 0;
+    float fake_timings[] = {3.0f, 1.0f, 2.0f};
+    while (tuner.NeedsTiming()) {
+      ASSERT_NE(tuner.Current(), nullptr);
+      tuner.Report(fake_timings[n_candidates % 3]);
+      ++n_candidates;
+    }
+    ASSERT_GT(n_candidates, 1);
+    ASSERT_NE(tuner.Current(), nullptr);
+
+    // A second tuner for the same (GPU model, bins) key hits the cache and
+    // needs no timing runs.
+    FeatureGroupsTuner cached(page->Cuts(), page->is_dense, 0,
+                              dh::MaxSharedMemoryOptin(0),
+                              sizeof(GradientPairPrecise));
+    ASSERT_FALSE(cached.NeedsTiming());
+  }
+}
+
 TEST(Histogram, GPUHistCategorical) {
   for (size_t num_categories = 2; num_categories < 8; ++num_categories) {
     TestGPUHistogramCategorical(num_categories);
@@ -96,6 +96,67 @@ void TestUpdatePosition() {
 
 TEST(RowPartitioner, Basic) { TestUpdatePosition(); }
 
+void TestUpdatePositionBatch() {
+  const int kNumRows = 10;
+  RowPartitioner rp(0, kNumRows);
+  // Send the first five training instances to the right node
+  // and the second 5 to the left node
+  rp.UpdatePositionBatch(
+      {0}, {1}, {2},
+      [=] __device__(RowPartitioner::RowIndexT ridx, bst_node_t nidx) {
+        return ridx > 4 ? 1 : 2;
+      });
+  EXPECT_EQ(rp.GetRows(1).size(), 5);
+  EXPECT_EQ(rp.GetRows(2).size(), 5);
+
+  // Split both leaves in a single batch
+  rp.UpdatePositionBatch(
+      {1, 2}, {3, 5}, {4, 6},
+      [=] __device__(RowPartitioner::RowIndexT ridx, bst_node_t nidx) {
+        if (nidx == 1) {
+          return ridx < 7 ? 3 : 4;
+        }
+        return ridx < 3 ? 5 : 6;
+      });
+  for (auto r : rp.GetRowsHost(3)) {
+    EXPECT_TRUE(r == 5 || r == 6);
+  }
+  for (auto r : rp.GetRowsHost(4)) {
+    EXPECT_GT(r, 6);
+  }
+  for (auto r : rp.GetRowsHost(5)) {
+    EXPECT_LT(r, 3);
+  }
+  for (auto r : rp.GetRowsHost(6)) {
+    EXPECT_TRUE(r == 3 || r == 4);
+  }
+  EXPECT_EQ(rp.GetPositionHost(),
+            std::vector<bst_node_t>({3, 3, 4, 4, 4, 5, 5, 5, 6, 6}));
+}
+
+TEST(RowPartitioner, Batch) { TestUpdatePositionBatch(); }
+
+void TestReuse() {
+  RowPartitioner rp(0, 5);
+  rp.UpdatePosition(0, 1, 2, [=] __device__(RowPartitioner::RowIndexT ridx) {
+    return ridx % 2 == 0 ? 1 : 2;
+  });
+  // Resetting for the next tree restores the root assignment, growing the
+  // buffers as needed.
+  const int kNumRows = 10;
+  rp.Reset(kNumRows);
+  auto rows = rp.GetRowsHost(0);
+  EXPECT_EQ(rows.size(), kNumRows);
+  for (auto i = 0ull; i < kNumRows; i++) {
+    EXPECT_EQ(rows[i], i);
+  }
+  for (auto p : rp.GetPositionHost()) {
+    EXPECT_EQ(p, 0);
+  }
+}
+
+TEST(RowPartitioner, Reuse) { TestReuse(); }
+
 void TestFinalise() {
   const int kNumRows = 10;
   RowPartitioner rp(0, kNumRows);
@@ -54,6 +54,12 @@ TEST(CPUFeatureInteractionConstraint, Basic) {
 
   ASSERT_FALSE(constraints.Query(1, 0));
   ASSERT_FALSE(constraints.Query(1, 5));
+
+  // Per-node bitset view used by split evaluation.
+  auto allowed = constraints.NodeConstraints(1);
+  ASSERT_FALSE(allowed.Bits().empty());
+  ASSERT_TRUE(allowed.Check(2));
+  ASSERT_FALSE(allowed.Check(5));
 }
 
 }  // namespace tree
@@ -6,10 +6,14 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
 #include <vector>
 #include <string>
 
 #include "../helpers.h"
+#include "xgboost/learner.h"
 #include "../../../src/tree/param.h"
 #include "../../../src/tree/updater_quantile_hist.h"
 #include "../../../src/tree/split_evaluator.h"
@@ -123,6 +127,32 @@ class QuantileHistMock : public QuantileHistMaker {
       omp_set_num_threads(nthreads);
     }
 
+    void TestInitDataGradientBasedSampling(const GHistIndexMatrix& gmat,
+                      const std::vector<GradientPair>& gpair,
+                      DMatrix* p_fmat,
+                      const RegTree& tree) {
+      // Update() would make this copy, InitData expects to sample from it
+      this->gpair_local_ = gpair;
+      RealImpl::InitData(gmat, this->gpair_local_, *p_fmat, tree);
+      std::vector<size_t> const& row_indices = *(this->row_set_collection_.Data());
+      ASSERT_GT(row_indices.size(), 0ul);
+      ASSERT_LE(row_indices.size(), gpair.size());
+      std::vector<bool> sampled(gpair.size(), false);
+      for (auto ridx : row_indices) {
+        sampled[ridx] = true;
+      }
+      for (size_t i = 0; i < gpair.size(); ++i) {
+        if (sampled[i]) {
+          // pairs of sampled rows are rescaled by the inverse probability
+          ASSERT_GE(this->gpair_local_[i].GetGrad(), gpair[i].GetGrad());
+          ASSERT_GE(this->gpair_local_[i].GetHess(), gpair[i].GetHess());
+        } else {
+          ASSERT_EQ(this->gpair_local_[i].GetGrad(), 0.0f);
+          ASSERT_EQ(this->gpair_local_[i].GetHess(), 0.0f);
+        }
+      }
+    }
+
     void TestAddHistRows(const GHistIndexMatrix& gmat,
                          const std::vector<GradientPair>& gpair,
                          DMatrix* p_fmat,
@@ -351,8 +381,8 @@ class QuantileHistMock : public QuantileHistMaker {
           //                      value is left/right side of the split threshold
           GradientPairPrecise left_sum, right_sum;
           for (size_t rid = 0; rid < num_row; ++rid) {
-            for (size_t offset = gmat.row_ptr[rid];
-                 offset < gmat.row_ptr[rid + 1]; ++offset) {
+            for (size_t offset = gmat.RowBegin(rid);
+                 offset < gmat.RowEnd(rid); ++offset) {
               const size_t bin_id = gmat.index[offset];
               if (bin_id >= bin_id_min && bin_id < bin_id_max) {
                 if (bin_id <= split_thresh) {
@@ -426,7 +456,7 @@ class QuantileHistMock : public QuantileHistMaker {
 
           // manually compute how many samples go left or right
           for (size_t rid = 0; rid < num_row; ++rid) {
-            for (size_t offset = gmat.row_ptr[rid]; offset < gmat.row_ptr[rid + 1]; ++offset) {
+            for (size_t offset = gmat.RowBegin(rid); offset < gmat.RowEnd(rid); ++offset) {
               const size_t bin_id = gmat.index[offset];
               if (bin_id >= bin_id_min && bin_id < bin_id_max) {
                 if (bin_id <= split) {
@@ -545,6 +575,24 @@ class QuantileHistMock : public QuantileHistMaker {
     }
   }
 
+  void TestInitDataGradientBasedSampling() {
+    size_t constexpr kMaxBins = 4;
+    common::GHistIndexMatrix gmat;
+    gmat.Init(dmat_.get(), kMaxBins);
+
+    RegTree tree = RegTree();
+    tree.param.UpdateAllowUnknown(cfg_);
+
+    std::vector<GradientPair> gpair =
+        { {0.23f, 0.24f}, {0.23f, 0.24f}, {0.23f, 0.24f}, {0.23f, 0.24f},
+          {0.27f, 0.29f}, {0.27f, 0.29f}, {0.27f, 0.29f}, {0.27f, 0.29f} };
+    if (double_builder_) {
+      double_builder_->TestInitDataGradientBasedSampling(gmat, gpair, dmat_.get(), tree);
+    } else {
+      float_builder_->TestInitDataGradientBasedSampling(gmat, gpair, dmat_.get(), tree);
+    }
+  }
+
   void TestAddHistRows() {
     size_t constexpr kMaxBins = 4;
     common::GHistIndexMatrix gmat;
@@ -637,6 +685,19 @@ TEST(QuantileHist, InitDataSampling) {
   maker_float.TestInitDataSampling();
 }
 
+TEST(QuantileHist, InitDataGradientBasedSampling) {
+  const float subsample = 0.5;
+  std::vector<std::pair<std::string, std::string>> cfg
+      {{"num_feature", std::to_string(QuantileHistMock::GetNumColumns())},
+       {"subsample", std::to_string(subsample)},
+       {"sampling_method", "gradient_based"}};
+  QuantileHistMock maker(cfg);
+  maker.TestInitDataGradientBasedSampling();
+  const bool single_precision_histogram = true;
+  QuantileHistMock maker_float(cfg, single_precision_histogram);
+  maker_float.TestInitDataGradientBasedSampling();
+}
+
 TEST(QuantileHist, AddHistRows) {
   std::vector<std::pair<std::string, std::string>> cfg
       {{"num_feature", std::to_string(QuantileHistMock::GetNumColumns())}};
@@ -702,6 +763,34 @@ TEST(QuantileHist, EvalSplits) {
   maker_float.TestEvaluateSplit();
 }
 
+TEST(QuantileHist, ParallelTreeSplitCache) {
+  // without sampling the trees of one boosting round must be identical;
+  // the split-result cache serves trees past the first from lookups and
+  // must not change that
+  size_t constexpr kRows = 512;
+  size_t constexpr kCols = 8;
+  size_t constexpr kParallelTrees = 3;
+  auto p_dmat = RandomDataGenerator(kRows, kCols, 0.2).GenerateDMatrix(true);
+
+  std::unique_ptr<Learner> learner{Learner::Create({p_dmat})};
+  learner->SetParams(Args{{"tree_method", "hist"},
+                          {"num_parallel_tree", std::to_string(kParallelTrees)},
+                          {"max_depth", "3"}});
+  learner->Configure();
+  for (int32_t iter = 0; iter < 2; ++iter) {
+    learner->UpdateOneIter(iter, p_dmat);
+  }
+
+  FeatureMap fmap;
+  auto dump = learner->DumpModel(fmap, true, "text");
+  ASSERT_EQ(dump.size(), 2 * kParallelTrees);
+  for (size_t round = 0; round < 2; ++round) {
+    for (size_t t = 1; t < kParallelTrees; ++t) {
+      ASSERT_EQ(dump[round * kParallelTrees + t], dump[round * kParallelTrees]);
+    }
+  }
+}
+
 TEST(QuantileHist, ApplySplit) {
   std::vector<std::pair<std::string, std::string>> cfg
       {{"num_feature", std::to_string(QuantileHistMock::GetNumColumns())},
@@ -715,5 +804,39 @@ TEST(QuantileHist, ApplySplit) {
   maker_float.TestApplySplit();
 }
 
+TEST(QuantileHist, PackedSplitReduce) {
+  struct Accessor : public QuantileHistMaker::Builder<float> {
+    using Packed = PackedSplitEntry;
+  };
+  using Packed = Accessor::Packed;
+  auto make = [](bst_float loss_chg, unsigned sindex) {
+    Packed e;
+    std::memset(&e, 0, sizeof(e));
+    e.loss_chg = loss_chg;
+    e.sindex = sindex;
+    return e;
+  };
+
+  // higher gain wins
+  Packed dst = make(1.0f, 3);
+  Packed::Reduce(dst, make(2.0f, 7));
+  ASSERT_EQ(dst.sindex, 7u);
+  ASSERT_FLOAT_EQ(dst.loss_chg, 2.0f);
+
+  // on equal gain the lower feature index wins, in either argument order
+  Packed::Reduce(dst, make(2.0f, 5));
+  ASSERT_EQ(dst.sindex, 5u);
+  Packed::Reduce(dst, make(2.0f, 9));
+  ASSERT_EQ(dst.sindex, 5u);
+
+  // the default-left bit is masked out of the comparison
+  Packed::Reduce(dst, make(2.0f, 4U | (1U << 31)));
+  ASSERT_EQ(dst.sindex, 4U | (1U << 31));
+
+  // invalid (infinite gain) candidates never replace
+  Packed::Reduce(dst, make(std::numeric_limits<bst_float>::infinity(), 1));
+  ASSERT_EQ(dst.sindex & ((1U << 31) - 1U), 4u);
+}
+
 }  // namespace tree
 }  // namespace xgboost
@@ -1,5 +1,6 @@
 // Copyright by Contributors
 #include <gtest/gtest.h>
+#include <limits>
 #include "../helpers.h"
 #include "dmlc/filesystem.h"
 #include "xgboost/json_io.h"
@@ -107,6 +108,50 @@ TEST(Tree, AllocateNode) {
   ASSERT_TRUE(nodes.at(2).IsLeaf());
 }
 
+TEST(Tree, CompactForInference) {
+  RegTree tree;
+  tree.ExpandNode(0, 0, 0.5f, true, 0.0f, 0.0f, 0.0f, 1.0f, 4.0f, 2.0f, 2.0f);
+  tree.ExpandNode(1, 1, 0.5f, true, 0.0f, -1.0f, -2.0f, 1.0f, 2.0f, 1.0f, 1.0f);
+  tree.ExpandNode(2, 1, 0.5f, true, 0.0f, 1.0f, 2.0f, 1.0f, 2.0f, 1.0f, 1.0f);
+  // Collapsing an internal node leaves deleted nodes behind.
+  tree.CollapseToLeaf(2, 3.0f);
+  ASSERT_EQ(tree.param.num_deleted, 2);
+
+  std::vector<float> values(2);
+  auto predict = [&](RegTree const& t, float f0, float f1) {
+    values[0] = f0;
+    values[1] = f1;
+    bst_node_t nid = 0;
+    while (!t[nid].IsLeaf()) {
+      nid = t.GetNext(nid, values[t[nid].SplitIndex()], false);
+    }
+    return t[nid].LeafValue();
+  };
+
+  std::vector<std::pair<float, float>> points{
+      {0.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}};
+  std::vector<float> before;
+  for (auto const& p : points) {
+    before.push_back(predict(tree, p.first, p.second));
+  }
+
+  tree.CompactForInference();
+  ASSERT_EQ(tree.param.num_deleted, 0);
+  ASSERT_EQ(tree.GetNodes().size(), 5);
+  // Breadth-first layout: children are adjacent and numbered past the parent.
+  for (bst_node_t nid = 0; nid < static_cast<bst_node_t>(tree.GetNodes().size()); ++nid) {
+    if (!tree[nid].IsLeaf()) {
+      ASSERT_GT(tree[nid].LeftChild(), nid);
+      ASSERT_EQ(tree[nid].RightChild(), tree[nid].LeftChild() + 1);
+    }
+  }
+  for (size_t i = 0; i < points.size(); ++i) {
+    ASSERT_EQ(predict(tree, points[i].first, points[i].second), before[i]);
+  }
+  // Training statistics are gone.
+  ASSERT_EQ(tree.Stat(0).sum_hess, 0.0f);
+}
+
 TEST(Tree, ExpandCategoricalFeature) {
   {
     RegTree tree;
@@ -151,6 +196,27 @@ TEST(Tree, ExpandCategoricalFeature) {
   }
 }
 
+TEST(Tree, CategoricalTraversal) {
+  RegTree tree;
+  bst_cat_t cat = 33;
+  std::vector<uint32_t> split_cats(LBitField32::ComputeStorageSize(cat + 1));
+  LBitField32 bitset{split_cats};
+  bitset.Set(cat);  // category 33 goes to the right branch
+  tree.ExpandCategorical(0, 0, split_cats, /*default_left=*/false, 1.0, 2.0,
+                         3.0, 11.0, 2.0, /*left_sum=*/3.0, /*right_sum=*/4.0);
+
+  // the matching category goes right, any other goes left
+  ASSERT_EQ(tree.GetNext(0, 33.0f, false), tree[0].RightChild());
+  ASSERT_EQ(tree.GetNext(0, 12.0f, false), tree[0].LeftChild());
+  // so do categories beyond the stored bitset
+  ASSERT_EQ(tree.GetNext(0, 512.0f, false), tree[0].LeftChild());
+  // missing values take the default branch
+  auto nan = std::numeric_limits<float>::quiet_NaN();
+  ASSERT_EQ(tree.GetNext(0, nan, true), tree[0].DefaultChild());
+  // the no-missing instantiation agrees
+  ASSERT_EQ(tree.GetNext<false>(0, 33.0f, false), tree[0].RightChild());
+}
+
 void GrowTree(RegTree* p_tree) {
   SimpleLCG lcg;
   size_t n_expands = 10;